@@ -0,0 +1,66 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#pragma once
+
+#include <plcore/pl.h>
+
+/**
+ * Each benchmark runs a batch of work per repetition and returns how many
+ * items it processed, so results can be reported per item as well as per run.
+ * Setup and Reset are not timed; Reset is called before every repetition.
+ * Setup is handed parm, so one set of callbacks can cover several cases, and
+ * throughput is reported too if bytesPerItem is provided.
+ */
+typedef struct Benchmark {
+	const char *name;
+	void *( *Setup )( const void *parm );
+	void ( *Reset )( void *userData );
+	uint64_t ( *Run )( void *userData );
+	void ( *Teardown )( void *userData );
+	const void *parm;
+	unsigned int bytesPerItem;
+	void ( *Annotate )( void *userData, char *note, size_t size ); /* optional, for results that aren't a time */
+} Benchmark;
+
+void RegisterBenchmark( const Benchmark *benchmark );
+
+/* stops the optimiser from throwing away results we never look at */
+extern volatile uint64_t benchSink;
+#define BenchConsume( VALUE ) ( benchSink += ( uint64_t ) ( VALUE ) )
+
+/* simple xorshift, so generated data is identical between runs */
+uint32_t BenchRandom( uint32_t *state );
+
+void RegisterVfsBenchmarks( void );
+void RegisterPackageBenchmarks( void );
+void RegisterImageBenchmarks( void );
+void RegisterMathBenchmarks( void );
+void RegisterMeshBenchmarks( void );
+void RegisterConsoleBenchmarks( void );
+void RegisterPhysicsBenchmarks( void );
+void RegisterOcclusionBenchmarks( void );
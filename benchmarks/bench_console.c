@@ -0,0 +1,143 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_console.h>
+#include <plcore/pl_parse.h>
+
+#include "bench.h"
+
+#define CONSOLE_NUM_LINES    1024
+#define CONSOLE_NUM_COMMANDS 256
+
+typedef struct ConsoleData {
+	char lines[ CONSOLE_NUM_LINES ][ 64 ];
+	char *script;
+} ConsoleData;
+
+static unsigned int numCommandCalls;
+static void BenchCommand( unsigned int argc, char **argv ) {
+	numCommandCalls += argc;
+}
+
+static void *SetupConsole( const void *parm ) {
+	static bool isRegistered = false;
+	if ( !isRegistered ) {
+		/* a few hundred entries, so lookups aren't trivially cheap */
+		static char names[ CONSOLE_NUM_COMMANDS ][ 24 ];
+		for ( unsigned int i = 0; i < CONSOLE_NUM_COMMANDS; ++i ) {
+			snprintf( names[ i ], sizeof( names[ i ] ), "bench_cmd%03u", i );
+			PlRegisterConsoleCommand( names[ i ], BenchCommand, "benchmark command" );
+		}
+		PlRegisterConsoleVariable( "bench_var", "0", pl_int_var, NULL, "benchmark variable" );
+		isRegistered = true;
+	}
+
+	ConsoleData *data = pl_malloc( sizeof( ConsoleData ) );
+	uint32_t seed = 0x5eed;
+	for ( unsigned int i = 0; i < CONSOLE_NUM_LINES; ++i ) {
+		uint32_t r = BenchRandom( &seed );
+		if ( r & 1 ) {
+			snprintf( data->lines[ i ], sizeof( data->lines[ i ] ), "bench_cmd%03u %u \"quoted arg\" %u",
+			          r % CONSOLE_NUM_COMMANDS, r >> 8, r >> 16 );
+		} else {
+			snprintf( data->lines[ i ], sizeof( data->lines[ i ] ), "bench_var %u", r >> 4 );
+		}
+	}
+
+	/* and a script-like blob for the generic parser */
+	size_t length = 0;
+	data->script = pl_malloc( CONSOLE_NUM_LINES * 64 );
+	for ( unsigned int i = 0; i < CONSOLE_NUM_LINES; ++i ) {
+		uint32_t r = BenchRandom( &seed );
+		length += snprintf( data->script + length, 64, "key%u %d %f\n", r % 100, ( int ) ( r >> 8 ), ( r % 1000 ) / 7.0f );
+	}
+
+	return data;
+}
+
+static void TeardownConsole( void *userData ) {
+	ConsoleData *data = userData;
+	pl_free( data->script );
+	pl_free( data );
+}
+
+static uint64_t RunParseConsoleString( void *userData ) {
+	ConsoleData *data = userData;
+	for ( unsigned int i = 0; i < CONSOLE_NUM_LINES; ++i ) {
+		PlParseConsoleString( data->lines[ i ] );
+	}
+	BenchConsume( numCommandCalls );
+	return CONSOLE_NUM_LINES;
+}
+
+static uint64_t RunGetConsoleCommand( void *userData ) {
+	char name[ 24 ];
+	for ( unsigned int i = 0; i < CONSOLE_NUM_COMMANDS; ++i ) {
+		snprintf( name, sizeof( name ), "bench_cmd%03u", ( i * 31 ) % CONSOLE_NUM_COMMANDS );
+		BenchConsume( PlGetConsoleCommand( name ) != NULL );
+	}
+	return CONSOLE_NUM_COMMANDS;
+}
+
+static uint64_t RunAutocompleteConsoleString( void *userData ) {
+	char prefix[ 16 ];
+	for ( unsigned int i = 0; i < 100; ++i ) {
+		snprintf( prefix, sizeof( prefix ), "bench_cmd%02u", i );
+		unsigned int numElements;
+		PlAutocompleteConsoleString( prefix, &numElements );
+		BenchConsume( numElements );
+	}
+	return 100;
+}
+
+static uint64_t RunParseTokens( void *userData ) {
+	ConsoleData *data = userData;
+	const char *p = data->script;
+	char token[ 32 ];
+	uint64_t numTokens = 0;
+	bool status;
+	while ( *p != '\0' ) {
+		PlParseToken( &p, token, sizeof( token ) );
+		BenchConsume( PlParseInteger( &p, &status ) );
+		BenchConsume( PlParseFloat( &p, &status ) );
+		PlSkipLine( &p );
+		numTokens += 3;
+	}
+	return numTokens;
+}
+
+void RegisterConsoleBenchmarks( void ) {
+	static const Benchmark list[] = {
+	        { "console/parse_string", SetupConsole, NULL, RunParseConsoleString, TeardownConsole },
+	        { "console/get_command", SetupConsole, NULL, RunGetConsoleCommand, TeardownConsole },
+	        { "console/autocomplete", SetupConsole, NULL, RunAutocompleteConsoleString, TeardownConsole },
+	        { "console/parse_tokens", SetupConsole, NULL, RunParseTokens, TeardownConsole },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
@@ -0,0 +1,472 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_image.h>
+
+#include "bench.h"
+
+#define IMAGE_WIDTH  1024
+#define IMAGE_HEIGHT 1024
+
+typedef struct ImageData {
+	uint8_t *source;
+	PLImageFormat sourceFormat;
+	PLImageFormat destinationFormat;
+	PLImageCompressionQuality quality;
+	PLImageMipmapFilter filter;
+	unsigned int mipmapFlags;
+	PLImageResizeFilter resizeFilter;
+	PLImage *image;
+} ImageData;
+
+static ImageData *CreateImageData( PLImageFormat sourceFormat, PLImageFormat destinationFormat ) {
+	ImageData *data = pl_calloc( 1, sizeof( ImageData ) );
+	data->sourceFormat = sourceFormat;
+	data->destinationFormat = destinationFormat;
+
+	unsigned int size = PlGetImageSize( sourceFormat, IMAGE_WIDTH, IMAGE_HEIGHT );
+	data->source = pl_malloc( size );
+	uint32_t seed = 0xcafe;
+	for ( unsigned int i = 0; i < size; ++i ) {
+		data->source[ i ] = ( uint8_t ) BenchRandom( &seed );
+	}
+
+	return data;
+}
+
+static void ResetImage( void *userData ) {
+	ImageData *data = userData;
+	PlDestroyImage( data->image );
+	data->image = PlCreateImage( data->source, IMAGE_WIDTH, IMAGE_HEIGHT, PL_COLOURFORMAT_RGBA, data->sourceFormat );
+}
+
+static void TeardownImage( void *userData ) {
+	ImageData *data = userData;
+	PlDestroyImage( data->image );
+	pl_free( data->source );
+	pl_free( data );
+}
+
+static uint64_t RunConvertImage( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlConvertPixelFormat( data->image, data->destinationFormat ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunCompressImage( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlCompressImage( data->image, data->destinationFormat, data->quality ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunGenerateMipmaps( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlGenerateImageMipmaps( data->image, data->filter, data->mipmapFlags ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+/* thumbnail sized, so the filters get stretched right out */
+static uint64_t RunResizeImage( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlResizeImage( data->image, IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4, data->resizeFilter ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunFlipImage( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlFlipImageVertical( data->image ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunFlipImageHorizontal( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlFlipImageHorizontal( data->image ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunRotateImage( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlRotateImage( data->image, PL_IMAGE_ROTATE_90 ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunSwizzleImage( void *userData ) {
+	static const uint8_t swizzle[ 4 ] = { 2, 1, 0, 3 };
+	ImageData *data = userData;
+	BenchConsume( PlSwizzleImageChannels( data->image, swizzle ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static uint64_t RunPremultiplyImage( void *userData ) {
+	ImageData *data = userData;
+	BenchConsume( PlPremultiplyImageAlpha( data->image ) );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static void *SetupRGB5A1toRGBA8( const void *parm ) {
+	return CreateImageData( PL_IMAGEFORMAT_RGB5A1, PL_IMAGEFORMAT_RGBA8 );
+}
+
+static void *SetupDecodeBC1( const void *parm ) {
+	return CreateImageData( PL_IMAGEFORMAT_RGBA_DXT1, PL_IMAGEFORMAT_RGBA8 );
+}
+
+static void *SetupDecodeBC3( const void *parm ) {
+	return CreateImageData( PL_IMAGEFORMAT_RGBA_DXT5, PL_IMAGEFORMAT_RGBA8 );
+}
+
+static void *SetupCompress( PLImageFormat format, PLImageCompressionQuality quality ) {
+	ImageData *data = CreateImageData( PL_IMAGEFORMAT_RGBA8, format );
+	data->quality = quality;
+	return data;
+}
+
+static void *SetupCompressBC1Fast( const void *parm ) {
+	return SetupCompress( PL_IMAGEFORMAT_RGB_DXT1, PL_IMAGE_COMPRESSION_FAST );
+}
+
+static void *SetupCompressBC1Quality( const void *parm ) {
+	return SetupCompress( PL_IMAGEFORMAT_RGB_DXT1, PL_IMAGE_COMPRESSION_QUALITY );
+}
+
+static void *SetupCompressBC3Fast( const void *parm ) {
+	return SetupCompress( PL_IMAGEFORMAT_RGBA_DXT5, PL_IMAGE_COMPRESSION_FAST );
+}
+
+static void *SetupCompressBC3Quality( const void *parm ) {
+	return SetupCompress( PL_IMAGEFORMAT_RGBA_DXT5, PL_IMAGE_COMPRESSION_QUALITY );
+}
+
+static void *SetupMipmaps( PLImageMipmapFilter filter, unsigned int flags ) {
+	ImageData *data = CreateImageData( PL_IMAGEFORMAT_RGBA8, PL_IMAGEFORMAT_RGBA8 );
+	data->filter = filter;
+	data->mipmapFlags = flags;
+	return data;
+}
+
+static void *SetupMipmapsBox( const void *parm ) {
+	return SetupMipmaps( PL_IMAGE_MIPMAP_FILTER_BOX, 0 );
+}
+
+static void *SetupMipmapsBoxSrgb( const void *parm ) {
+	return SetupMipmaps( PL_IMAGE_MIPMAP_FILTER_BOX, PL_IMAGE_MIPMAP_SRGB );
+}
+
+static void *SetupMipmapsKaiser( const void *parm ) {
+	return SetupMipmaps( PL_IMAGE_MIPMAP_FILTER_KAISER, 0 );
+}
+
+static void *SetupResize( PLImageResizeFilter filter ) {
+	ImageData *data = CreateImageData( PL_IMAGEFORMAT_RGBA8, PL_IMAGEFORMAT_RGBA8 );
+	data->resizeFilter = filter;
+	return data;
+}
+
+static void *SetupResizeBilinear( const void *parm ) {
+	return SetupResize( PL_IMAGE_RESIZE_FILTER_BILINEAR );
+}
+
+static void *SetupResizeLanczos3( const void *parm ) {
+	return SetupResize( PL_IMAGE_RESIZE_FILTER_LANCZOS3 );
+}
+
+static void *SetupFlipRGBA8( const void *parm ) {
+	ImageData *data = CreateImageData( PL_IMAGEFORMAT_RGBA8, PL_IMAGEFORMAT_RGBA8 );
+	ResetImage( data );
+	return data;
+}
+
+static void *SetupFlipRGB8( const void *parm ) {
+	ImageData *data = CreateImageData( PL_IMAGEFORMAT_RGB8, PL_IMAGEFORMAT_RGB8 );
+	ResetImage( data );
+	return data;
+}
+
+/****************************************
+ * Indexed TIM loading, from memory
+ ****************************************/
+
+typedef struct TimData {
+	uint8_t *buffer;
+	size_t size;
+} TimData;
+
+static void WriteTimInt( uint8_t **p, uint32_t value, unsigned int size ) {
+	for ( unsigned int i = 0; i < size; ++i ) {
+		*( *p )++ = ( uint8_t ) ( value >> ( i * 8 ) );
+	}
+}
+
+static void *SetupTim( unsigned int bitsPerIndex ) {
+	unsigned int numColours = 1U << bitsPerIndex;
+	size_t imageSize = IMAGE_WIDTH * IMAGE_HEIGHT * bitsPerIndex / 8;
+
+	TimData *data = pl_calloc( 1, sizeof( TimData ) );
+	data->size = 8 + 12 + numColours * 2 + 12 + imageSize;
+	data->buffer = pl_malloc( data->size );
+
+	uint32_t seed = 0xcafe;
+	uint8_t *p = data->buffer;
+	WriteTimInt( &p, 16, 4 );
+	WriteTimInt( &p, ( bitsPerIndex == 8 ? 1 : 0 ) | 8, 4 );
+	WriteTimInt( &p, 12 + numColours * 2, 4 );
+	WriteTimInt( &p, 0, 4 );
+	WriteTimInt( &p, numColours, 2 );
+	WriteTimInt( &p, 1, 2 );
+	for ( unsigned int i = 0; i < numColours; ++i ) {
+		WriteTimInt( &p, BenchRandom( &seed ), 2 );
+	}
+	WriteTimInt( &p, ( uint32_t ) ( 12 + imageSize ), 4 );
+	WriteTimInt( &p, 0, 4 );
+	WriteTimInt( &p, ( uint32_t ) ( imageSize / 2 / IMAGE_HEIGHT ), 2 );
+	WriteTimInt( &p, IMAGE_HEIGHT, 2 );
+	for ( size_t i = 0; i < imageSize; ++i ) {
+		*p++ = ( uint8_t ) BenchRandom( &seed );
+	}
+
+	PlRegisterStandardImageLoaders( PL_IMAGE_FILEFORMAT_TIM );
+
+	return data;
+}
+
+static void *SetupTim4bpp( const void *parm ) {
+	return SetupTim( 4 );
+}
+
+static void *SetupTim8bpp( const void *parm ) {
+	return SetupTim( 8 );
+}
+
+static uint64_t RunLoadTim( void *userData ) {
+	TimData *data = userData;
+	PLImage *image = PlLoadImageFromMemory( data->buffer, data->size, "tim" );
+	BenchConsume( image != NULL );
+	PlDestroyImage( image );
+	return IMAGE_WIDTH * IMAGE_HEIGHT;
+}
+
+static void TeardownTim( void *userData ) {
+	TimData *data = userData;
+	PlClearImageLoaders();
+	pl_free( data->buffer );
+	pl_free( data );
+}
+
+/****************************************
+ * Atlas packing, over randomly sized sprites
+ ****************************************/
+
+typedef struct AtlasData {
+	PLImage **images;
+	unsigned int numImages;
+	PLImageAtlasRect *rects;
+	PLImage *atlas;
+} AtlasData;
+
+static void *SetupAtlas( unsigned int numImages ) {
+	AtlasData *data = pl_calloc( 1, sizeof( AtlasData ) );
+	data->numImages = numImages;
+	data->images = pl_calloc( numImages, sizeof( PLImage * ) );
+	data->rects = pl_calloc( numImages, sizeof( PLImageAtlasRect ) );
+
+	uint32_t seed = 0xcafe;
+	for ( unsigned int i = 0; i < numImages; ++i ) {
+		unsigned int w = 8 + BenchRandom( &seed ) % 57;
+		unsigned int h = 8 + BenchRandom( &seed ) % 57;
+		data->images[ i ] = PlCreateImage( NULL, w, h, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	}
+
+	return data;
+}
+
+static void *SetupAtlas256( const void *parm ) {
+	return SetupAtlas( 256 );
+}
+
+static void *SetupAtlas2048( const void *parm ) {
+	return SetupAtlas( 2048 );
+}
+
+static void ResetAtlas( void *userData ) {
+	AtlasData *data = userData;
+	PlDestroyImage( data->atlas );
+	data->atlas = NULL;
+}
+
+/* padded and aligned for a few mip levels, as sprites would be */
+static uint64_t RunPackAtlas( void *userData ) {
+	AtlasData *data = userData;
+	data->atlas = PlCreateImageAtlas( data->images, data->numImages, 2, 4, 16384, data->rects );
+	BenchConsume( data->atlas != NULL );
+	return data->numImages;
+}
+
+/* how much of the atlas is actually covered by the sprites */
+static void AnnotateAtlas( void *userData, char *note, size_t size ) {
+	AtlasData *data = userData;
+	if ( data->atlas == NULL ) {
+		return;
+	}
+
+	uint64_t used = 0;
+	for ( unsigned int i = 0; i < data->numImages; ++i ) {
+		used += ( uint64_t ) data->rects[ i ].width * data->rects[ i ].height;
+	}
+
+	snprintf( note, size, "%ux%u, %.1f%% used", data->atlas->width, data->atlas->height,
+	          ( double ) used * 100.0 / ( ( double ) data->atlas->width * data->atlas->height ) );
+}
+
+static void TeardownAtlas( void *userData ) {
+	AtlasData *data = userData;
+	PlDestroyImage( data->atlas );
+	for ( unsigned int i = 0; i < data->numImages; ++i ) {
+		PlDestroyImage( data->images[ i ] );
+	}
+	pl_free( data->images );
+	pl_free( data->rects );
+	pl_free( data );
+}
+
+/****************************************
+ * Pixel conversion, for every pair of formats
+ ****************************************/
+
+#define PIXELS_WIDTH  512
+#define PIXELS_HEIGHT 512
+
+static const struct {
+	PLImageFormat format;
+	const char *name;
+} pixelFormats[] = {
+        { PL_IMAGEFORMAT_RGB4, "rgb4" },
+        { PL_IMAGEFORMAT_RGBA4, "rgba4" },
+        { PL_IMAGEFORMAT_RGB5, "rgb5" },
+        { PL_IMAGEFORMAT_RGB5A1, "rgb5a1" },
+        { PL_IMAGEFORMAT_RGB565, "rgb565" },
+        { PL_IMAGEFORMAT_RGB8, "rgb8" },
+        { PL_IMAGEFORMAT_RGBA8, "rgba8" },
+        { PL_IMAGEFORMAT_RGBA12, "rgba12" },
+        { PL_IMAGEFORMAT_RGBA16, "rgba16" },
+        { PL_IMAGEFORMAT_RGBA16F, "rgba16f" },
+};
+
+#define NUM_PIXEL_FORMATS plArrayElements( pixelFormats )
+
+typedef struct PixelsPair {
+	char name[ 64 ];
+	PLImageFormat sourceFormat;
+	PLImageFormat destinationFormat;
+} PixelsPair;
+
+typedef struct PixelsData {
+	const PixelsPair *pair;
+	uint8_t *source;
+	uint8_t *destination;
+} PixelsData;
+
+static void *SetupPixels( const void *parm ) {
+	PixelsData *data = pl_calloc( 1, sizeof( PixelsData ) );
+	data->pair = parm;
+
+	unsigned int size = PlGetImageSize( data->pair->sourceFormat, PIXELS_WIDTH, PIXELS_HEIGHT );
+	data->source = pl_malloc( size );
+	data->destination = pl_malloc( PlGetImageSize( data->pair->destinationFormat, PIXELS_WIDTH, PIXELS_HEIGHT ) );
+	uint32_t seed = 0xcafe;
+	for ( unsigned int i = 0; i < size; ++i ) {
+		data->source[ i ] = ( uint8_t ) BenchRandom( &seed );
+	}
+
+	return data;
+}
+
+static uint64_t RunPixels( void *userData ) {
+	PixelsData *data = userData;
+	BenchConsume( PlConvertPixels( data->source, data->pair->sourceFormat, data->destination, data->pair->destinationFormat, PIXELS_WIDTH * PIXELS_HEIGHT ) );
+	return PIXELS_WIDTH * PIXELS_HEIGHT;
+}
+
+static void TeardownPixels( void *userData ) {
+	PixelsData *data = userData;
+	pl_free( data->source );
+	pl_free( data->destination );
+	pl_free( data );
+}
+
+void RegisterImageBenchmarks( void ) {
+	static const Benchmark list[] = {
+	        { "image/convert_rgb5a1_rgba8", SetupRGB5A1toRGBA8, ResetImage, RunConvertImage, TeardownImage },
+	        { "image/flip_vertical_rgba8", SetupFlipRGBA8, NULL, RunFlipImage, TeardownImage },
+	        { "image/flip_horizontal_rgba8", SetupFlipRGBA8, NULL, RunFlipImageHorizontal, TeardownImage },
+	        { "image/flip_horizontal_rgb8", SetupFlipRGB8, NULL, RunFlipImageHorizontal, TeardownImage },
+	        { "image/rotate_90_rgba8", SetupFlipRGBA8, NULL, RunRotateImage, TeardownImage },
+	        { "image/swizzle_rgb8", SetupFlipRGB8, NULL, RunSwizzleImage, TeardownImage },
+	        { "image/premultiply_rgba8", SetupFlipRGBA8, ResetImage, RunPremultiplyImage, TeardownImage },
+	        { "image/decode_bc1_rgba8", SetupDecodeBC1, ResetImage, RunConvertImage, TeardownImage },
+	        { "image/decode_bc3_rgba8", SetupDecodeBC3, ResetImage, RunConvertImage, TeardownImage },
+	        /* throughput here is over the RGBA8 source */
+	        { "image/compress_bc1_fast", SetupCompressBC1Fast, ResetImage, RunCompressImage, TeardownImage, NULL, 4 },
+	        { "image/compress_bc1_quality", SetupCompressBC1Quality, ResetImage, RunCompressImage, TeardownImage, NULL, 4 },
+	        { "image/compress_bc3_fast", SetupCompressBC3Fast, ResetImage, RunCompressImage, TeardownImage, NULL, 4 },
+	        { "image/compress_bc3_quality", SetupCompressBC3Quality, ResetImage, RunCompressImage, TeardownImage, NULL, 4 },
+	        { "image/mipmaps_box_rgba8", SetupMipmapsBox, ResetImage, RunGenerateMipmaps, TeardownImage, NULL, 4 },
+	        { "image/mipmaps_box_srgb_rgba8", SetupMipmapsBoxSrgb, ResetImage, RunGenerateMipmaps, TeardownImage, NULL, 4 },
+	        { "image/mipmaps_kaiser_rgba8", SetupMipmapsKaiser, ResetImage, RunGenerateMipmaps, TeardownImage, NULL, 4 },
+	        { "image/resize_bilinear_rgba8", SetupResizeBilinear, ResetImage, RunResizeImage, TeardownImage, NULL, 4 },
+	        { "image/resize_lanczos3_rgba8", SetupResizeLanczos3, ResetImage, RunResizeImage, TeardownImage, NULL, 4 },
+	        { "image/load_tim_4bpp", SetupTim4bpp, NULL, RunLoadTim, TeardownTim },
+	        { "image/load_tim_8bpp", SetupTim8bpp, NULL, RunLoadTim, TeardownTim },
+	        /* per sprite */
+	        { "image/atlas_pack_256", SetupAtlas256, ResetAtlas, RunPackAtlas, TeardownAtlas, NULL, 0, AnnotateAtlas },
+	        { "image/atlas_pack_2048", SetupAtlas2048, ResetAtlas, RunPackAtlas, TeardownAtlas, NULL, 0, AnnotateAtlas },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+
+	/* registered benchmarks only keep pointers, so these need to stick around */
+	static PixelsPair pairs[ NUM_PIXEL_FORMATS * NUM_PIXEL_FORMATS ];
+	unsigned int numPairs = 0;
+	for ( unsigned int i = 0; i < NUM_PIXEL_FORMATS; ++i ) {
+		for ( unsigned int j = 0; j < NUM_PIXEL_FORMATS; ++j ) {
+			if ( i == j ) {
+				continue;
+			}
+
+			PixelsPair *pair = &pairs[ numPairs++ ];
+			snprintf( pair->name, sizeof( pair->name ), "image/pixels_%s_%s", pixelFormats[ i ].name, pixelFormats[ j ].name );
+			pair->sourceFormat = pixelFormats[ i ].format;
+			pair->destinationFormat = pixelFormats[ j ].format;
+
+			/* throughput is measured over both what's read and what's written */
+			Benchmark benchmark = {
+			        pair->name, SetupPixels, NULL, RunPixels, TeardownPixels, pair,
+			        PlImageBytesPerPixel( pair->sourceFormat ) + PlImageBytesPerPixel( pair->destinationFormat ) };
+			RegisterBenchmark( &benchmark );
+		}
+	}
+}
@@ -0,0 +1,320 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_math.h>
+
+#include "bench.h"
+
+#define MATH_NUM_MATRICES 4096
+#define MATH_NUM_VECTORS  65536
+
+typedef struct MathData {
+	PLMatrix4 matrices[ MATH_NUM_MATRICES ];
+	PLVector3 vectors[ MATH_NUM_VECTORS ];
+	PLQuaternion rotations[ MATH_NUM_MATRICES ];
+
+	/* the same again for the batches, with the per-element loops working
+	 * on the usual structures for comparison */
+	PLQuaternion from[ MATH_NUM_VECTORS ], to[ MATH_NUM_VECTORS ];
+	PLVector3 vectorsOut[ MATH_NUM_VECTORS ];
+	PLQuaternion rotationsOut[ MATH_NUM_VECTORS ];
+	float streams[ 11 ][ MATH_NUM_VECTORS ], streamsOut[ 4 ][ MATH_NUM_VECTORS ];
+
+	PLRandom rng;
+} MathData;
+
+static float RandomFloat( uint32_t *seed ) {
+	return ( ( float ) ( BenchRandom( seed ) & 0xffff ) / 32768.0f ) - 1.0f;
+}
+
+static void *SetupMath( const void *parm ) {
+	MathData *data = pl_malloc( sizeof( MathData ) );
+	uint32_t seed = 0xf00d;
+	for ( unsigned int i = 0; i < MATH_NUM_MATRICES; ++i ) {
+		PLVector3 axis = PlNormalizeVector3( PLVector3( RandomFloat( &seed ), RandomFloat( &seed ), 1.0f ) );
+		data->matrices[ i ] = PlMultiplyMatrix4( PlRotateMatrix4( RandomFloat( &seed ) * PL_PI, axis ),
+		                                         PlTranslateMatrix4( PLVector3( RandomFloat( &seed ), RandomFloat( &seed ), RandomFloat( &seed ) ) ) );
+
+		PLQuaternion q = PLQuaternion( RandomFloat( &seed ), RandomFloat( &seed ), RandomFloat( &seed ), 1.0f );
+		data->rotations[ i ] = PlNormalizeQuaternion( &q );
+	}
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->vectors[ i ] = PLVector3( RandomFloat( &seed ), RandomFloat( &seed ), RandomFloat( &seed ) );
+		data->streams[ 0 ][ i ] = data->vectors[ i ].x;
+		data->streams[ 1 ][ i ] = data->vectors[ i ].y;
+		data->streams[ 2 ][ i ] = data->vectors[ i ].z;
+
+		PLQuaternion q = PLQuaternion( RandomFloat( &seed ), RandomFloat( &seed ), RandomFloat( &seed ), 1.0f );
+		PLQuaternion q2 = PLQuaternion( RandomFloat( &seed ), RandomFloat( &seed ), RandomFloat( &seed ), 1.0f );
+		data->from[ i ] = PlNormalizeQuaternion( &q );
+		data->to[ i ] = PlNormalizeQuaternion( &q2 );
+		for ( unsigned int j = 0; j < 4; ++j ) {
+			data->streams[ 3 + j ][ i ] = ( &data->from[ i ].x )[ j ];
+			data->streams[ 7 + j ][ i ] = ( &data->to[ i ].x )[ j ];
+		}
+	}
+	PlSeedRandom( &data->rng, seed );
+	return data;
+}
+
+static void TeardownMath( void *userData ) {
+	pl_free( userData );
+}
+
+static uint64_t RunMultiplyMatrix4( void *userData ) {
+	MathData *data = userData;
+	PLMatrix4 m = PlMatrix4Identity();
+	for ( unsigned int i = 0; i < MATH_NUM_MATRICES; ++i ) {
+		m = PlMultiplyMatrix4( m, data->matrices[ i ] );
+	}
+	BenchConsume( m.m[ 0 ] );
+	return MATH_NUM_MATRICES;
+}
+
+static uint64_t RunInverseMatrix4( void *userData ) {
+	MathData *data = userData;
+	float sum = 0.0f;
+	for ( unsigned int i = 0; i < MATH_NUM_MATRICES; ++i ) {
+		PLMatrix4 m = PlInverseMatrix4( data->matrices[ i ] );
+		sum += m.m[ 0 ];
+	}
+	BenchConsume( sum );
+	return MATH_NUM_MATRICES;
+}
+
+static uint64_t RunTransformPoint3( void *userData ) {
+	MathData *data = userData;
+	float sum = 0.0f;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		PLVector3 v = PlTransformPoint3( &data->matrices[ i % MATH_NUM_MATRICES ], data->vectors[ i ] );
+		sum += v.x;
+	}
+	BenchConsume( sum );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunNormalizeVector3( void *userData ) {
+	MathData *data = userData;
+	float sum = 0.0f;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		PLVector3 v = PlNormalizeVector3( data->vectors[ i ] );
+		sum += v.x;
+	}
+	BenchConsume( sum );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunCrossProductVector3( void *userData ) {
+	MathData *data = userData;
+	PLVector3 v = data->vectors[ 0 ];
+	for ( unsigned int i = 1; i < MATH_NUM_VECTORS; ++i ) {
+		v = PlNormalizeVector3( PlVector3CrossProduct( v, data->vectors[ i ] ) );
+	}
+	BenchConsume( v.x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRotateQuaternionPoint( void *userData ) {
+	MathData *data = userData;
+	float sum = 0.0f;
+	for ( unsigned int i = 0; i < MATH_NUM_MATRICES; ++i ) {
+		PLQuaternion q = PlRotateQuaternionPoint( &data->rotations[ i ], &data->vectors[ i ] );
+		sum += q.x;
+	}
+	BenchConsume( sum );
+	return MATH_NUM_MATRICES;
+}
+
+/****************************************
+ * Batches, against per-element loops
+ ****************************************/
+
+static uint64_t RunTransformPointsLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->vectorsOut[ i ] = PlTransformPoint3( &data->matrices[ 0 ], data->vectors[ i ] );
+	}
+	BenchConsume( data->vectorsOut[ MATH_NUM_VECTORS - 1 ].x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunTransformPointsBatch( void *userData ) {
+	MathData *data = userData;
+	PLVector3SoA src = { data->streams[ 0 ], data->streams[ 1 ], data->streams[ 2 ] };
+	PLVector3SoA dst = { data->streamsOut[ 0 ], data->streamsOut[ 1 ], data->streamsOut[ 2 ] };
+	PlTransformPoints3( &data->matrices[ 0 ], &src, &dst, MATH_NUM_VECTORS );
+	BenchConsume( dst.x[ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunNormalizeLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->vectorsOut[ i ] = PlNormalizeVector3( data->vectors[ i ] );
+	}
+	BenchConsume( data->vectorsOut[ MATH_NUM_VECTORS - 1 ].x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunNormalizeBatch( void *userData ) {
+	MathData *data = userData;
+	PLVector3SoA src = { data->streams[ 0 ], data->streams[ 1 ], data->streams[ 2 ] };
+	PLVector3SoA dst = { data->streamsOut[ 0 ], data->streamsOut[ 1 ], data->streamsOut[ 2 ] };
+	PlNormalizeVectors3( &src, &dst, MATH_NUM_VECTORS );
+	BenchConsume( dst.x[ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunBoundsLoop( void *userData ) {
+	MathData *data = userData;
+	PLVector3 mins = data->vectors[ 0 ], maxs = data->vectors[ 0 ];
+	for ( unsigned int i = 1; i < MATH_NUM_VECTORS; ++i ) {
+		mins = PlVector3Min( mins, data->vectors[ i ] );
+		maxs = PlVector3Max( maxs, data->vectors[ i ] );
+	}
+	BenchConsume( mins.x + maxs.x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunBoundsBatch( void *userData ) {
+	MathData *data = userData;
+	PLVector3SoA src = { data->streams[ 0 ], data->streams[ 1 ], data->streams[ 2 ] };
+	PLVector3 mins, maxs;
+	PlGetVector3Bounds( &src, MATH_NUM_VECTORS, &mins, &maxs );
+	BenchConsume( mins.x + maxs.x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunSlerpLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->rotationsOut[ i ] = PlSlerpQuaternion( &data->from[ i ], &data->to[ i ], 0.25f );
+	}
+	BenchConsume( data->rotationsOut[ MATH_NUM_VECTORS - 1 ].x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunSlerpBatch( void *userData ) {
+	MathData *data = userData;
+	PLQuaternionSoA a = { data->streams[ 3 ], data->streams[ 4 ], data->streams[ 5 ], data->streams[ 6 ] };
+	PLQuaternionSoA b = { data->streams[ 7 ], data->streams[ 8 ], data->streams[ 9 ], data->streams[ 10 ] };
+	PLQuaternionSoA dst = { data->streamsOut[ 0 ], data->streamsOut[ 1 ], data->streamsOut[ 2 ], data->streamsOut[ 3 ] };
+	PlSlerpQuaternions( &a, &b, 0.25f, &dst, MATH_NUM_VECTORS );
+	BenchConsume( dst.x[ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+/****************************************
+ * Random numbers, against rand()
+ ****************************************/
+
+static uint64_t RunRandFloatsLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->streamsOut[ 0 ][ i ] = ( float ) rand() / ( float ) RAND_MAX;
+	}
+	BenchConsume( data->streamsOut[ 0 ][ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRandomFloatsLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->streamsOut[ 0 ][ i ] = PlRandomFloat( &data->rng );
+	}
+	BenchConsume( data->streamsOut[ 0 ][ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRandomFloatsBatch( void *userData ) {
+	MathData *data = userData;
+	PlFillRandomFloats( &data->rng, data->streamsOut[ 0 ], MATH_NUM_VECTORS, 0.0f, 1.0f );
+	BenchConsume( data->streamsOut[ 0 ][ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRandomNormalsLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->streamsOut[ 0 ][ i ] = PlRandomNormal( &data->rng, 0.0f, 1.0f );
+	}
+	BenchConsume( data->streamsOut[ 0 ][ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRandomNormalsBatch( void *userData ) {
+	MathData *data = userData;
+	PlFillRandomNormals( &data->rng, data->streamsOut[ 0 ], MATH_NUM_VECTORS, 0.0f, 1.0f );
+	BenchConsume( data->streamsOut[ 0 ][ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRandomOnSphereLoop( void *userData ) {
+	MathData *data = userData;
+	for ( unsigned int i = 0; i < MATH_NUM_VECTORS; ++i ) {
+		data->vectorsOut[ i ] = PlRandomOnSphere( &data->rng );
+	}
+	BenchConsume( data->vectorsOut[ MATH_NUM_VECTORS - 1 ].x );
+	return MATH_NUM_VECTORS;
+}
+
+static uint64_t RunRandomOnSphereBatch( void *userData ) {
+	MathData *data = userData;
+	PLVector3SoA dst = { data->streamsOut[ 0 ], data->streamsOut[ 1 ], data->streamsOut[ 2 ] };
+	PlFillRandomOnSphere( &data->rng, &dst, MATH_NUM_VECTORS );
+	BenchConsume( dst.x[ MATH_NUM_VECTORS - 1 ] );
+	return MATH_NUM_VECTORS;
+}
+
+void RegisterMathBenchmarks( void ) {
+	static const Benchmark list[] = {
+	        { "math/matrix4_multiply", SetupMath, NULL, RunMultiplyMatrix4, TeardownMath },
+	        { "math/matrix4_inverse", SetupMath, NULL, RunInverseMatrix4, TeardownMath },
+	        { "math/matrix4_transform_point", SetupMath, NULL, RunTransformPoint3, TeardownMath },
+	        { "math/vector3_normalize", SetupMath, NULL, RunNormalizeVector3, TeardownMath },
+	        { "math/vector3_cross", SetupMath, NULL, RunCrossProductVector3, TeardownMath },
+	        { "math/quaternion_rotate_point", SetupMath, NULL, RunRotateQuaternionPoint, TeardownMath },
+	        { "math/loop_transform_points", SetupMath, NULL, RunTransformPointsLoop, TeardownMath },
+	        { "math/batch_transform_points", SetupMath, NULL, RunTransformPointsBatch, TeardownMath },
+	        { "math/loop_normalize", SetupMath, NULL, RunNormalizeLoop, TeardownMath },
+	        { "math/batch_normalize", SetupMath, NULL, RunNormalizeBatch, TeardownMath },
+	        { "math/loop_bounds", SetupMath, NULL, RunBoundsLoop, TeardownMath },
+	        { "math/batch_bounds", SetupMath, NULL, RunBoundsBatch, TeardownMath },
+	        { "math/loop_slerp", SetupMath, NULL, RunSlerpLoop, TeardownMath },
+	        { "math/batch_slerp", SetupMath, NULL, RunSlerpBatch, TeardownMath },
+	        { "math/loop_rand_floats", SetupMath, NULL, RunRandFloatsLoop, TeardownMath },
+	        { "math/loop_random_floats", SetupMath, NULL, RunRandomFloatsLoop, TeardownMath },
+	        { "math/batch_random_floats", SetupMath, NULL, RunRandomFloatsBatch, TeardownMath },
+	        { "math/loop_random_normals", SetupMath, NULL, RunRandomNormalsLoop, TeardownMath },
+	        { "math/batch_random_normals", SetupMath, NULL, RunRandomNormalsBatch, TeardownMath },
+	        { "math/loop_random_on_sphere", SetupMath, NULL, RunRandomOnSphereLoop, TeardownMath },
+	        { "math/batch_random_on_sphere", SetupMath, NULL, RunRandomOnSphereBatch, TeardownMath },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
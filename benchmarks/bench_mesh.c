@@ -0,0 +1,258 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_physics.h>
+#include <plgraphics/plg_mesh.h>
+
+#include <float.h>
+
+#include "bench.h"
+
+#define MESH_GRID_SIZE     256
+#define MESH_NUM_VERTICES  ( MESH_GRID_SIZE * MESH_GRID_SIZE )
+#define MESH_NUM_TRIANGLES ( ( MESH_GRID_SIZE - 1 ) * ( MESH_GRID_SIZE - 1 ) * 2 )
+
+/**
+ * Bumpy terrain-style grid; the mesh is filled in directly rather than
+ * via PlgCreateMesh, so no graphics driver is required.
+ */
+static void *SetupMesh( const void *parm ) {
+	PLGMesh *mesh = pl_calloc( 1, sizeof( PLGMesh ) );
+	mesh->primitive = PLG_MESH_TRIANGLES;
+	mesh->num_verts = mesh->maxVertices = MESH_NUM_VERTICES;
+	mesh->vertices = pl_calloc( MESH_NUM_VERTICES, sizeof( PLGVertex ) );
+	mesh->num_triangles = MESH_NUM_TRIANGLES;
+	mesh->num_indices = mesh->maxIndices = MESH_NUM_TRIANGLES * 3;
+	mesh->indices = pl_malloc( sizeof( unsigned int ) * mesh->num_indices );
+
+	uint32_t seed = 0xabcd;
+	for ( unsigned int y = 0; y < MESH_GRID_SIZE; ++y ) {
+		for ( unsigned int x = 0; x < MESH_GRID_SIZE; ++x ) {
+			PLGVertex *vertex = &mesh->vertices[ y * MESH_GRID_SIZE + x ];
+			vertex->position = PLVector3( x * 8.0f, ( float ) ( BenchRandom( &seed ) % 64 ), y * 8.0f );
+			vertex->st[ 0 ] = PLVector2( x / ( float ) MESH_GRID_SIZE, y / ( float ) MESH_GRID_SIZE );
+		}
+	}
+
+	unsigned int *index = mesh->indices;
+	for ( unsigned int y = 0; y < MESH_GRID_SIZE - 1; ++y ) {
+		for ( unsigned int x = 0; x < MESH_GRID_SIZE - 1; ++x ) {
+			unsigned int i = y * MESH_GRID_SIZE + x;
+			*( index++ ) = i;
+			*( index++ ) = i + MESH_GRID_SIZE;
+			*( index++ ) = i + 1;
+			*( index++ ) = i + 1;
+			*( index++ ) = i + MESH_GRID_SIZE;
+			*( index++ ) = i + MESH_GRID_SIZE + 1;
+		}
+	}
+
+	return mesh;
+}
+
+static void ResetMeshNormals( void *userData ) {
+	PLGMesh *mesh = userData;
+	for ( unsigned int i = 0; i < mesh->num_verts; ++i ) {
+		mesh->vertices[ i ].normal = pl_vecOrigin3;
+	}
+}
+
+static void TeardownMesh( void *userData ) {
+	PLGMesh *mesh = userData;
+	pl_free( mesh->vertices );
+	pl_free( mesh->indices );
+	pl_free( mesh );
+}
+
+static uint64_t RunGenerateNormals( void *userData ) {
+	PLGMesh *mesh = userData;
+	PlgGenerateMeshNormals( mesh, true );
+	BenchConsume( mesh->vertices[ 0 ].normal.y );
+	return MESH_NUM_TRIANGLES;
+}
+
+static uint64_t RunGenerateTangentBasis( void *userData ) {
+	PLGMesh *mesh = userData;
+	PlgGenerateMeshTangentBasis( mesh );
+	BenchConsume( mesh->vertices[ 0 ].tangent.x );
+	return MESH_NUM_TRIANGLES;
+}
+
+static uint64_t RunGenerateTextureCoordinates( void *userData ) {
+	PLGMesh *mesh = userData;
+	PlgGenerateTextureCoordinates( mesh->vertices, mesh->num_verts, pl_vecOrigin2, PLVector2( 1.0f, 1.0f ) );
+	BenchConsume( mesh->vertices[ 1 ].st[ 0 ].x );
+	return MESH_NUM_VERTICES;
+}
+
+static uint64_t RunGenerateBounds( void *userData ) {
+	PLGMesh *mesh = userData;
+	PLCollisionAABB bounds = PlgGenerateAabbFromMesh( mesh, true );
+	BenchConsume( bounds.maxs.y );
+	return MESH_NUM_VERTICES;
+}
+
+/****************************************
+ * Raycasting
+ ****************************************/
+
+#define MESH_NUM_RAYS       ( 256 * 256 )
+#define MESH_NUM_BRUTE_RAYS 16
+
+typedef struct RaycastData {
+	PLGMesh *mesh;
+	PLCollisionMesh *collisionMesh;
+	PLCollisionRay rays[ MESH_NUM_RAYS ];
+	PLCollisionMeshHit hits[ MESH_NUM_RAYS ];
+} RaycastData;
+
+static float RandomRayFloat( uint32_t *seed, float min, float max ) {
+	return min + ( BenchRandom( seed ) / ( float ) UINT32_MAX ) * ( max - min );
+}
+
+/**
+ * Coherent rays go through each pixel of a 256x256 view looking across
+ * the terrain, as for picking or visibility; incoherent ones start
+ * anywhere above it and head anywhere below.
+ */
+static void *SetupRaycast( const void *parm ) {
+	RaycastData *data = pl_malloc( sizeof( RaycastData ) );
+	data->mesh = SetupMesh( NULL );
+	data->collisionMesh = PlCreateCollisionMesh();
+	PlgAddMeshToCollisionMesh( data->collisionMesh, data->mesh );
+	PlBuildCollisionMesh( data->collisionMesh );
+
+	bool coherent = *( const bool * ) parm;
+	uint32_t seed = 0x5eed;
+	for ( unsigned int i = 0; i < MESH_NUM_RAYS; ++i ) {
+		PLCollisionRay *ray = &data->rays[ i ];
+		if ( coherent ) {
+			float x = ( i % 256 ) / 128.0f - 1.0f, y = ( i / 256 ) / 128.0f - 1.0f;
+			ray->origin = PLVector3( 1020.0f, 200.0f, -100.0f );
+			ray->direction = PlNormalizeVector3( PLVector3( x, -0.4f + y * 0.3f, 1.0f ) );
+		} else {
+			ray->origin = PLVector3( RandomRayFloat( &seed, 0.0f, 2040.0f ), RandomRayFloat( &seed, 80.0f, 200.0f ), RandomRayFloat( &seed, 0.0f, 2040.0f ) );
+			ray->direction = PlNormalizeVector3( PLVector3( RandomRayFloat( &seed, -1.0f, 1.0f ), RandomRayFloat( &seed, -1.0f, -0.1f ), RandomRayFloat( &seed, -1.0f, 1.0f ) ) );
+		}
+	}
+
+	return data;
+}
+
+static void TeardownRaycast( void *userData ) {
+	RaycastData *data = userData;
+	PlDestroyCollisionMesh( data->collisionMesh );
+	TeardownMesh( data->mesh );
+	pl_free( data );
+}
+
+static uint64_t RunBuildCollisionMesh( void *userData ) {
+	PLGMesh *mesh = userData;
+	PLCollisionMesh *collisionMesh = PlCreateCollisionMesh();
+	PlgAddMeshToCollisionMesh( collisionMesh, mesh );
+	PlBuildCollisionMesh( collisionMesh );
+	BenchConsume( PlGetCollisionMeshNumTriangles( collisionMesh ) );
+	PlDestroyCollisionMesh( collisionMesh );
+	return MESH_NUM_TRIANGLES;
+}
+
+/* what it takes without the hierarchy, so only a handful of rays */
+static uint64_t RunRaycastBruteForce( void *userData ) {
+	RaycastData *data = userData;
+	const PLGMesh *mesh = data->mesh;
+	for ( unsigned int i = 0; i < MESH_NUM_BRUTE_RAYS; ++i ) {
+		PLCollisionMeshHit *hit = &data->hits[ i ];
+		hit->distance = FLT_MAX;
+		hit->triangle = PL_COLLISION_MESH_NO_HIT;
+		for ( unsigned int j = 0; j < mesh->num_triangles; ++j ) {
+			const unsigned int *index = &mesh->indices[ j * 3 ];
+			float t, u, v;
+			if ( PlIsRayIntersectingTriangle( &data->rays[ i ], mesh->vertices[ index[ 0 ] ].position, mesh->vertices[ index[ 1 ] ].position,
+			                                  mesh->vertices[ index[ 2 ] ].position, &t, &u, &v ) &&
+			     t < hit->distance ) {
+				*hit = ( PLCollisionMeshHit ){ t, j, u, v };
+			}
+		}
+		BenchConsume( hit->triangle );
+	}
+	return MESH_NUM_BRUTE_RAYS;
+}
+
+static uint64_t RunRaycastSingle( void *userData ) {
+	RaycastData *data = userData;
+	for ( unsigned int i = 0; i < MESH_NUM_RAYS; ++i ) {
+		PlRaycastCollisionMesh( data->collisionMesh, &data->rays[ i ], FLT_MAX, &data->hits[ i ] );
+	}
+	BenchConsume( data->hits[ MESH_NUM_RAYS / 2 ].triangle );
+	return MESH_NUM_RAYS;
+}
+
+static uint64_t RunRaycastBulk( void *userData ) {
+	RaycastData *data = userData;
+	PlRaycastCollisionMeshRays( data->collisionMesh, data->rays, MESH_NUM_RAYS, FLT_MAX, data->hits );
+	BenchConsume( data->hits[ MESH_NUM_RAYS / 2 ].triangle );
+	return MESH_NUM_RAYS;
+}
+
+static uint64_t RunRaycastBlocking( void *userData ) {
+	RaycastData *data = userData;
+	unsigned int numBlocked = 0;
+	for ( unsigned int i = 0; i < MESH_NUM_RAYS; ++i ) {
+		numBlocked += PlIsCollisionMeshBlockingRay( data->collisionMesh, &data->rays[ i ], FLT_MAX );
+	}
+	BenchConsume( numBlocked );
+	return MESH_NUM_RAYS;
+}
+
+static void AnnotateRaycast( void *userData, char *note, size_t size ) {
+	const RaycastData *data = userData;
+	unsigned int numHits = 0;
+	for ( unsigned int i = 0; i < MESH_NUM_RAYS; ++i ) {
+		numHits += ( data->hits[ i ].triangle != PL_COLLISION_MESH_NO_HIT );
+	}
+	snprintf( note, size, "%.1f%% hit", numHits * 100.0 / MESH_NUM_RAYS );
+}
+
+void RegisterMeshBenchmarks( void ) {
+	static const bool coherent = true, incoherent = false;
+	static const Benchmark list[] = {
+	        { "mesh/generate_normals", SetupMesh, ResetMeshNormals, RunGenerateNormals, TeardownMesh },
+	        { "mesh/generate_tangent_basis", SetupMesh, NULL, RunGenerateTangentBasis, TeardownMesh },
+	        { "mesh/generate_texture_coordinates", SetupMesh, NULL, RunGenerateTextureCoordinates, TeardownMesh },
+	        { "mesh/generate_aabb", SetupMesh, NULL, RunGenerateBounds, TeardownMesh },
+	        { "mesh/collision_mesh_build", SetupMesh, NULL, RunBuildCollisionMesh, TeardownMesh },
+	        { "mesh/raycast_brute_force", SetupRaycast, NULL, RunRaycastBruteForce, TeardownRaycast, &coherent },
+	        { "mesh/raycast_single_coherent", SetupRaycast, NULL, RunRaycastSingle, TeardownRaycast, &coherent, 0, AnnotateRaycast },
+	        { "mesh/raycast_bulk_coherent", SetupRaycast, NULL, RunRaycastBulk, TeardownRaycast, &coherent, 0, AnnotateRaycast },
+	        { "mesh/raycast_single_incoherent", SetupRaycast, NULL, RunRaycastSingle, TeardownRaycast, &incoherent, 0, AnnotateRaycast },
+	        { "mesh/raycast_bulk_incoherent", SetupRaycast, NULL, RunRaycastBulk, TeardownRaycast, &incoherent, 0, AnnotateRaycast },
+	        { "mesh/raycast_blocking_incoherent", SetupRaycast, NULL, RunRaycastBlocking, TeardownRaycast, &incoherent },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
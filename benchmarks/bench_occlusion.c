@@ -0,0 +1,200 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plgraphics/plg_occlusion.h>
+
+#include "bench.h"
+
+#define OCCLUSION_WIDTH       256
+#define OCCLUSION_HEIGHT      144
+#define OCCLUSION_BLOCKS_X    9
+#define OCCLUSION_BLOCKS_Z    8
+#define OCCLUSION_NUM_BLOCKS  ( OCCLUSION_BLOCKS_X * OCCLUSION_BLOCKS_Z )
+#define OCCLUSION_BLOCK_SPACE 40.0f
+#define OCCLUSION_NUM_BOXES   10000
+
+static const PLVector3 cubeVertices[ 8 ] = {
+        { -0.5f, 0.0f, -0.5f },
+        { 0.5f, 0.0f, -0.5f },
+        { 0.5f, 1.0f, -0.5f },
+        { -0.5f, 1.0f, -0.5f },
+        { -0.5f, 0.0f, 0.5f },
+        { 0.5f, 0.0f, 0.5f },
+        { 0.5f, 1.0f, 0.5f },
+        { -0.5f, 1.0f, 0.5f },
+};
+
+static const unsigned int cubeIndices[ 36 ] = {
+        0, 1, 2, 0, 2, 3, /* back */
+        5, 4, 7, 5, 7, 6, /* front */
+        4, 0, 3, 4, 3, 7, /* left */
+        1, 5, 6, 1, 6, 2, /* right */
+        3, 2, 6, 3, 6, 7, /* top */
+        4, 5, 1, 4, 1, 0, /* bottom */
+};
+
+typedef enum OcclusionMethod {
+	OCCLUSION_RASTERIZE,
+	OCCLUSION_BUILD_PYRAMID,
+	OCCLUSION_BOXES_SINGLE,
+	OCCLUSION_BOXES_BATCH,
+	OCCLUSION_BOXES_BATCH_NO_PYRAMID,
+	OCCLUSION_FRAME,
+} OcclusionMethod;
+
+/**
+ * City blocks of assorted heights, seen from street level looking down
+ * one of the streets, with small objects scattered among them; most of
+ * the view is taken up by the blocks either side, so most of the objects
+ * are hidden.
+ */
+typedef struct OcclusionData {
+	OcclusionMethod method;
+	PLGOcclusionBuffer *buffer;
+	PLMatrix4 viewProjection;
+	PLMatrix4 blocks[ OCCLUSION_NUM_BLOCKS ];
+	float centres[ 3 ][ OCCLUSION_NUM_BOXES ], extents[ 3 ][ OCCLUSION_NUM_BOXES ];
+	uint32_t visibleBits[ PL_CULL_BITSET_WORDS( OCCLUSION_NUM_BOXES ) ];
+	unsigned int numVisible;
+} OcclusionData;
+
+static void DrawOccluders( OcclusionData *data ) {
+	PlgClearOcclusionBuffer( data->buffer, &data->viewProjection );
+	for ( unsigned int i = 0; i < OCCLUSION_NUM_BLOCKS; ++i ) {
+		PlgAddOccluderTriangles( data->buffer, &data->blocks[ i ], cubeVertices, 0, cubeIndices, 12 );
+	}
+}
+
+static void *SetupOcclusion( const void *parm ) {
+	OcclusionData *data = pl_calloc( 1, sizeof( OcclusionData ) );
+	data->method = *( const OcclusionMethod * ) parm;
+	data->buffer = PlgCreateOcclusionBuffer( OCCLUSION_WIDTH, OCCLUSION_HEIGHT );
+
+	PLMatrix4 view = PlLookAt( PLVector3( OCCLUSION_BLOCK_SPACE * 0.5f, 2.0f, 0.0f ), PLVector3( OCCLUSION_BLOCK_SPACE * 0.5f, 2.0f, 100.0f ), PLVector3( 0.0f, 1.0f, 0.0f ) );
+	data->viewProjection = PlMultiplyMatrix4( PlPerspective( 75.0f, 16.0f / 9.0f, 0.1f, 1000.0f ), view );
+
+	PLRandom rng;
+	PlSeedRandom( &rng, 0x0cc1 );
+	for ( unsigned int x = 0; x < OCCLUSION_BLOCKS_X; ++x ) {
+		for ( unsigned int z = 0; z < OCCLUSION_BLOCKS_Z; ++z ) {
+			PLMatrix4 *m = &data->blocks[ x * OCCLUSION_BLOCKS_Z + z ];
+			*m = PlMatrix4Identity();
+			m->m[ 0 ] = m->m[ 10 ] = OCCLUSION_BLOCK_SPACE * 0.6f;
+			m->m[ 5 ] = PlRandomFloatRange( &rng, 10.0f, 40.0f );
+			m->m[ 12 ] = ( ( float ) x - ( OCCLUSION_BLOCKS_X / 2 ) ) * OCCLUSION_BLOCK_SPACE;
+			m->m[ 14 ] = ( ( float ) z + 1.0f ) * OCCLUSION_BLOCK_SPACE;
+		}
+	}
+
+	float halfWidth = OCCLUSION_BLOCKS_X * OCCLUSION_BLOCK_SPACE * 0.5f;
+	PlFillRandomFloats( &rng, data->centres[ 0 ], OCCLUSION_NUM_BOXES, -halfWidth, halfWidth );
+	PlFillRandomFloats( &rng, data->centres[ 1 ], OCCLUSION_NUM_BOXES, 0.0f, 6.0f );
+	PlFillRandomFloats( &rng, data->centres[ 2 ], OCCLUSION_NUM_BOXES, 5.0f, ( OCCLUSION_BLOCKS_Z + 1 ) * OCCLUSION_BLOCK_SPACE );
+	for ( unsigned int j = 0; j < 3; ++j ) {
+		PlFillRandomFloats( &rng, data->extents[ j ], OCCLUSION_NUM_BOXES, 0.5f, 2.0f );
+	}
+
+	/* ready for the tests that don't draw anything themselves */
+	DrawOccluders( data );
+	if ( data->method != OCCLUSION_BOXES_BATCH_NO_PYRAMID ) {
+		PlgBuildOcclusionPyramid( data->buffer );
+	}
+
+	return data;
+}
+
+static void TeardownOcclusion( void *userData ) {
+	OcclusionData *data = userData;
+	PlgDestroyOcclusionBuffer( data->buffer );
+	pl_free( data );
+}
+
+static unsigned int TestOcclusionBoxes( OcclusionData *data ) {
+	PLVector3SoA centres = { data->centres[ 0 ], data->centres[ 1 ], data->centres[ 2 ] };
+	PLVector3SoA extents = { data->extents[ 0 ], data->extents[ 1 ], data->extents[ 2 ] };
+	return PlgTestOcclusionBoxes( data->buffer, &centres, &extents, OCCLUSION_NUM_BOXES, data->visibleBits, NULL );
+}
+
+static uint64_t RunOcclusion( void *userData ) {
+	OcclusionData *data = userData;
+	switch ( data->method ) {
+		case OCCLUSION_RASTERIZE:
+			DrawOccluders( data );
+			BenchConsume( PlgGetOcclusionBufferDepth( data->buffer, 0, OCCLUSION_WIDTH / 2, OCCLUSION_HEIGHT / 2 ) );
+			return OCCLUSION_NUM_BLOCKS * 12;
+		case OCCLUSION_BUILD_PYRAMID:
+			PlgBuildOcclusionPyramid( data->buffer );
+			BenchConsume( PlgGetOcclusionBufferDepth( data->buffer, PlgGetOcclusionBufferLevels( data->buffer ) - 1, 0, 0 ) );
+			return OCCLUSION_WIDTH * OCCLUSION_HEIGHT;
+		case OCCLUSION_BOXES_SINGLE:
+			data->numVisible = 0;
+			for ( unsigned int i = 0; i < OCCLUSION_NUM_BOXES; ++i ) {
+				PLVector3 extents = PLVector3( data->extents[ 0 ][ i ], data->extents[ 1 ][ i ], data->extents[ 2 ][ i ] );
+				PLCollisionAABB bounds = PlSetupCollisionAABB( PLVector3( data->centres[ 0 ][ i ], data->centres[ 1 ][ i ], data->centres[ 2 ][ i ] ), PlScaleVector3F( extents, -1.0f ), extents );
+				if ( !PlgIsBoxOccluded( data->buffer, &bounds ) ) {
+					data->numVisible++;
+				}
+			}
+			break;
+		case OCCLUSION_BOXES_BATCH:
+		case OCCLUSION_BOXES_BATCH_NO_PYRAMID:
+			data->numVisible = TestOcclusionBoxes( data );
+			break;
+		case OCCLUSION_FRAME:
+			DrawOccluders( data );
+			PlgBuildOcclusionPyramid( data->buffer );
+			data->numVisible = TestOcclusionBoxes( data );
+			break;
+	}
+	BenchConsume( data->numVisible );
+	return OCCLUSION_NUM_BOXES;
+}
+
+static void AnnotateOcclusion( void *userData, char *note, size_t size ) {
+	const OcclusionData *data = userData;
+	snprintf( note, size, "%.1f%% occluded", ( OCCLUSION_NUM_BOXES - data->numVisible ) * 100.0 / OCCLUSION_NUM_BOXES );
+}
+
+void RegisterOcclusionBenchmarks( void ) {
+	static const OcclusionMethod rasterize = OCCLUSION_RASTERIZE;
+	static const OcclusionMethod buildPyramid = OCCLUSION_BUILD_PYRAMID;
+	static const OcclusionMethod boxesSingle = OCCLUSION_BOXES_SINGLE;
+	static const OcclusionMethod boxesBatch = OCCLUSION_BOXES_BATCH;
+	static const OcclusionMethod boxesBatchNoPyramid = OCCLUSION_BOXES_BATCH_NO_PYRAMID;
+	static const OcclusionMethod frame = OCCLUSION_FRAME;
+	static const Benchmark list[] = {
+	        { "occlusion/rasterize_occluders", SetupOcclusion, NULL, RunOcclusion, TeardownOcclusion, &rasterize },
+	        { "occlusion/build_pyramid", SetupOcclusion, NULL, RunOcclusion, TeardownOcclusion, &buildPyramid },
+	        { "occlusion/boxes_single", SetupOcclusion, NULL, RunOcclusion, TeardownOcclusion, &boxesSingle, 0, AnnotateOcclusion },
+	        { "occlusion/boxes_batch", SetupOcclusion, NULL, RunOcclusion, TeardownOcclusion, &boxesBatch, 0, AnnotateOcclusion },
+	        { "occlusion/boxes_batch_no_pyramid", SetupOcclusion, NULL, RunOcclusion, TeardownOcclusion, &boxesBatchNoPyramid, 0, AnnotateOcclusion },
+	        { "occlusion/frame", SetupOcclusion, NULL, RunOcclusion, TeardownOcclusion, &frame, 0, AnnotateOcclusion },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
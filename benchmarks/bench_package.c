@@ -0,0 +1,126 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_package.h>
+
+#include "bench.h"
+
+#define PACKAGE_PATH      "bench_package.wad"
+#define PACKAGE_NUM_LUMPS 512
+#define PACKAGE_LUMP_SIZE 1024
+
+/**
+ * Generates a Doom-style WAD, as it's the simplest of the formats we support.
+ */
+static bool WriteSyntheticWad( const char *path ) {
+	uint32_t tableOffset = 12 + PACKAGE_NUM_LUMPS * PACKAGE_LUMP_SIZE;
+	size_t size = tableOffset + PACKAGE_NUM_LUMPS * 16;
+	uint8_t *buf = pl_calloc( size, sizeof( uint8_t ) );
+	if ( buf == NULL ) {
+		return false;
+	}
+
+	uint32_t header[ 2 ] = { PACKAGE_NUM_LUMPS, tableOffset };
+	memcpy( buf, "IWAD", 4 );
+	memcpy( buf + 4, header, sizeof( header ) );
+
+	uint32_t seed = 0xbeef;
+	for ( unsigned int i = 0; i < PACKAGE_NUM_LUMPS; ++i ) {
+		uint32_t offset = 12 + i * PACKAGE_LUMP_SIZE;
+		for ( unsigned int j = 0; j < PACKAGE_LUMP_SIZE; ++j ) {
+			buf[ offset + j ] = ( uint8_t ) BenchRandom( &seed );
+		}
+
+		uint8_t *index = buf + tableOffset + i * 16;
+		uint32_t lump[ 2 ] = { offset, PACKAGE_LUMP_SIZE };
+		memcpy( index, lump, sizeof( lump ) );
+		char name[ 9 ];
+		snprintf( name, sizeof( name ), "LUMP%04u", i );
+		memcpy( index + 8, name, 8 );
+	}
+
+	bool status = PlWriteFile( path, buf, size );
+	pl_free( buf );
+	return status;
+}
+
+static void *SetupPackage( const void *parm ) {
+	if ( !WriteSyntheticWad( PACKAGE_PATH ) ) {
+		return NULL;
+	}
+
+	PLPackage *package = PlLoadPackage( PACKAGE_PATH );
+	if ( package == NULL ) {
+		PlDeleteFile( PACKAGE_PATH );
+	}
+	return package;
+}
+
+static void TeardownPackage( void *userData ) {
+	PlDestroyPackage( userData );
+	PlDeleteFile( PACKAGE_PATH );
+}
+
+static uint64_t RunLoadPackage( void *userData ) {
+	PLPackage *package = PlLoadPackage( PACKAGE_PATH );
+	BenchConsume( PlGetPackageTableSize( package ) );
+	PlDestroyPackage( package );
+	return PACKAGE_NUM_LUMPS;
+}
+
+static uint64_t RunLoadPackageFiles( void *userData ) {
+	PLPackage *package = userData;
+	for ( unsigned int i = 0; i < PACKAGE_NUM_LUMPS; ++i ) {
+		PLFile *file = PlLoadPackageFileByIndex( package, i );
+		if ( file != NULL ) {
+			BenchConsume( PlGetFileData( file )[ 0 ] );
+			PlCloseFile( file );
+		}
+	}
+	return PACKAGE_NUM_LUMPS;
+}
+
+static uint64_t RunFindPackageIndex( void *userData ) {
+	PLPackage *package = userData;
+	char name[ 16 ];
+	for ( unsigned int i = 0; i < PACKAGE_NUM_LUMPS; ++i ) {
+		snprintf( name, sizeof( name ), "LUMP%04u", ( i * 7 ) % PACKAGE_NUM_LUMPS );
+		BenchConsume( PlGetPackageTableIndex( package, name ) );
+	}
+	return PACKAGE_NUM_LUMPS;
+}
+
+void RegisterPackageBenchmarks( void ) {
+	static const Benchmark list[] = {
+	        { "package/load_index", SetupPackage, NULL, RunLoadPackage, TeardownPackage },
+	        { "package/load_files", SetupPackage, NULL, RunLoadPackageFiles, TeardownPackage },
+	        { "package/find_index", SetupPackage, NULL, RunFindPackageIndex, TeardownPackage },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
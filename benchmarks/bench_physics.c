@@ -0,0 +1,740 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_physics.h>
+
+#include <float.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include "bench.h"
+
+#define PHYSICS_NUM_BOXES  4096
+#define PHYSICS_NUM_RAYS   1024
+#define PHYSICS_SCENE_SIZE 128.0f
+
+/**
+ * Boxes of assorted sizes scattered through a cube, with a set of rays
+ * fired in from outside, and a view looking into one corner.
+ */
+typedef struct PhysicsData {
+	PLCollisionAABB boxes[ PHYSICS_NUM_BOXES ];
+	PLCollisionRay rays[ PHYSICS_NUM_RAYS ];
+	PLVector4 frustum[ 6 ];
+	unsigned int proxies[ PHYSICS_NUM_BOXES ];
+	PLAabbTree *tree, *sahTree, *scratch;
+	PLRandom rng;
+	float direction;
+} PhysicsData;
+
+static void SetupFrustum( PLVector4 *frustum, PLVector3 eye, PLVector3 target ) {
+	PLMatrix4 view = PlLookAt( eye, target, PLVector3( 0.0f, 1.0f, 0.0f ) );
+	PLMatrix4 m = PlMultiplyMatrix4( PlPerspective( 75.0f, 1.5f, 0.1f, PHYSICS_SCENE_SIZE * 4.0f ), view );
+	for ( unsigned int i = 0; i < 6; ++i ) {
+		/* right, left, bottom, top, far, near; as PLGCamera */
+		float sign = ( i & 1 ) ? 1.0f : -1.0f;
+		unsigned int row = i / 2;
+		frustum[ i ] = PlNormalizePlane( PLVector4( m.m[ 3 ] + sign * m.m[ row ], m.m[ 7 ] + sign * m.m[ 4 + row ],
+		                                            m.m[ 11 ] + sign * m.m[ 8 + row ], m.m[ 15 ] + sign * m.m[ 12 + row ] ) );
+	}
+}
+
+static void *SetupPhysics( const void *parm ) {
+	PhysicsData *data = pl_calloc( 1, sizeof( PhysicsData ) );
+	PlSeedRandom( &data->rng, 0xb0c5 );
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		PLVector3 origin, extents;
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			PlVector3Index( origin, j ) = PlRandomFloatRange( &data->rng, -PHYSICS_SCENE_SIZE, PHYSICS_SCENE_SIZE );
+			PlVector3Index( extents, j ) = PlRandomFloatRange( &data->rng, 0.5f, 4.0f );
+		}
+		data->boxes[ i ] = PlSetupCollisionAABB( origin, PlScaleVector3F( extents, -1.0f ), extents );
+	}
+	for ( unsigned int i = 0; i < PHYSICS_NUM_RAYS; ++i ) {
+		PLVector3 target = PlRandomOnSphere( &data->rng );
+		PLVector3 origin = PlScaleVector3F( PlRandomOnSphere( &data->rng ), PHYSICS_SCENE_SIZE * 2.0f );
+		target = PlScaleVector3F( target, PHYSICS_SCENE_SIZE * 0.5f );
+		data->rays[ i ] = PlSetupCollisionRay( origin, PlNormalizeVector3( PlSubtractVector3( target, origin ) ) );
+	}
+
+	SetupFrustum( data->frustum, PLVector3( -PHYSICS_SCENE_SIZE, 0.0f, -PHYSICS_SCENE_SIZE ), PLVector3( 0.0f, 0.0f, 0.0f ) );
+
+	data->tree = PlCreateAabbTree( 0.25f );
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		data->proxies[ i ] = PlInsertAabbTreeProxy( data->tree, &data->boxes[ i ], &data->boxes[ i ] );
+	}
+	data->sahTree = PlCreateAabbTree( 0.0f );
+	PlBuildAabbTree( data->sahTree, data->boxes, NULL, PHYSICS_NUM_BOXES );
+	data->scratch = PlCreateAabbTree( 0.25f );
+	data->direction = 1.0f;
+	return data;
+}
+
+static void TeardownPhysics( void *userData ) {
+	PhysicsData *data = userData;
+	PlDestroyAabbTree( data->tree );
+	PlDestroyAabbTree( data->sahTree );
+	PlDestroyAabbTree( data->scratch );
+	pl_free( data );
+}
+
+static void ResetScratchTree( void *userData ) {
+	PhysicsData *data = userData;
+	PlClearAabbTree( data->scratch );
+}
+
+/****************************************
+ * Building
+ ****************************************/
+
+static uint64_t RunInsertTree( void *userData ) {
+	PhysicsData *data = userData;
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		PlInsertAabbTreeProxy( data->scratch, &data->boxes[ i ], NULL );
+	}
+	BenchConsume( PlGetAabbTreeHeight( data->scratch ) );
+	return PHYSICS_NUM_BOXES;
+}
+
+static uint64_t RunBuildSahTree( void *userData ) {
+	PhysicsData *data = userData;
+	PlBuildAabbTree( data->scratch, data->boxes, NULL, PHYSICS_NUM_BOXES );
+	BenchConsume( PlGetAabbTreeHeight( data->scratch ) );
+	return PHYSICS_NUM_BOXES;
+}
+
+/* everything drifts a little, back and forth between runs */
+static uint64_t RunMoveTree( void *userData ) {
+	PhysicsData *data = userData;
+	unsigned int numMoved = 0;
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		PLVector3 displacement = PLVector3( 0.1f * data->direction, ( float ) ( i & 3 ) * 0.05f * data->direction, 0.0f );
+		data->boxes[ i ].origin = PlAddVector3( data->boxes[ i ].origin, displacement );
+		numMoved += PlMoveAabbTreeProxy( data->tree, data->proxies[ i ], &data->boxes[ i ], displacement );
+	}
+	data->direction = -data->direction;
+	BenchConsume( numMoved );
+	return PHYSICS_NUM_BOXES;
+}
+
+/****************************************
+ * Overlapping pairs
+ ****************************************/
+
+static void CountPair( unsigned int proxyA, unsigned int proxyB, void *parm ) {
+	( *( unsigned int * ) parm )++;
+}
+
+static uint64_t RunPairsBruteForce( void *userData ) {
+	PhysicsData *data = userData;
+	unsigned int numPairs = 0;
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		for ( unsigned int j = i + 1; j < PHYSICS_NUM_BOXES; ++j ) {
+			numPairs += PlIsAabbIntersecting( &data->boxes[ i ], &data->boxes[ j ] );
+		}
+	}
+	BenchConsume( numPairs );
+	return PHYSICS_NUM_BOXES;
+}
+
+static uint64_t RunPairsTree( void *userData ) {
+	PhysicsData *data = userData;
+	unsigned int numPairs = 0;
+	PlGetAabbTreeOverlapPairs( data->tree, CountPair, &numPairs );
+	BenchConsume( numPairs );
+	return PHYSICS_NUM_BOXES;
+}
+
+static uint64_t RunPairsSahTree( void *userData ) {
+	PhysicsData *data = userData;
+	unsigned int numPairs = 0;
+	PlGetAabbTreeOverlapPairs( data->sahTree, CountPair, &numPairs );
+	BenchConsume( numPairs );
+	return PHYSICS_NUM_BOXES;
+}
+
+/****************************************
+ * Rays
+ ****************************************/
+
+static float FindClosestHit( unsigned int proxy, void *userData, float distance, void *parm ) {
+	*( float * ) parm = distance;
+	return distance;
+}
+
+static uint64_t RunRaycastBruteForce( void *userData ) {
+	PhysicsData *data = userData;
+	float total = 0.0f;
+	for ( unsigned int i = 0; i < PHYSICS_NUM_RAYS; ++i ) {
+		float closest = FLT_MAX;
+		for ( unsigned int j = 0; j < PHYSICS_NUM_BOXES; ++j ) {
+			PLVector3 hit;
+			if ( PlIsRayIntersectingAabb( &data->boxes[ j ], &data->rays[ i ], &hit ) ) {
+				float distance = PlVector3Length( PlSubtractVector3( hit, data->rays[ i ].origin ) );
+				closest = ( distance < closest ) ? distance : closest;
+			}
+		}
+		total += closest;
+	}
+	BenchConsume( total );
+	return PHYSICS_NUM_RAYS;
+}
+
+static uint64_t RunRaycastTree( PLAabbTree *tree, PhysicsData *data ) {
+	float total = 0.0f;
+	for ( unsigned int i = 0; i < PHYSICS_NUM_RAYS; ++i ) {
+		float closest = FLT_MAX;
+		PlRaycastAabbTree( tree, &data->rays[ i ], FLT_MAX, FindClosestHit, &closest );
+		total += closest;
+	}
+	BenchConsume( total );
+	return PHYSICS_NUM_RAYS;
+}
+
+static uint64_t RunRaycastDynamicTree( void *userData ) {
+	PhysicsData *data = userData;
+	return RunRaycastTree( data->tree, data );
+}
+
+static uint64_t RunRaycastSahTree( void *userData ) {
+	PhysicsData *data = userData;
+	return RunRaycastTree( data->sahTree, data );
+}
+
+/****************************************
+ * Frustum
+ ****************************************/
+
+static bool CountProxy( unsigned int proxy, void *userData, void *parm ) {
+	( *( unsigned int * ) parm )++;
+	return true;
+}
+
+/* corner by corner, the way PlgIsBoxInsideView used to */
+static uint64_t RunFrustumBruteForce( void *userData ) {
+	PhysicsData *data = userData;
+	unsigned int numVisible = 0;
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		PLVector3 mins = PlAddVector3( data->boxes[ i ].mins, data->boxes[ i ].origin );
+		PLVector3 maxs = PlAddVector3( data->boxes[ i ].maxs, data->boxes[ i ].origin );
+		bool visible = true;
+		for ( unsigned int j = 0; j < 6 && visible; ++j ) {
+			visible = false;
+			for ( unsigned int c = 0; c < 8 && !visible; ++c ) {
+				PLVector3 corner = PLVector3( ( c & 1 ) ? maxs.x : mins.x, ( c & 2 ) ? maxs.y : mins.y, ( c & 4 ) ? maxs.z : mins.z );
+				visible = PlGetPlaneDotProduct( &data->frustum[ j ], &corner ) >= 0.0f;
+			}
+		}
+		numVisible += visible;
+	}
+	BenchConsume( numVisible );
+	return PHYSICS_NUM_BOXES;
+}
+
+static uint64_t RunFrustumTree( void *userData ) {
+	PhysicsData *data = userData;
+	unsigned int numVisible = 0;
+	PlQueryAabbTreeFrustum( data->sahTree, data->frustum, 6, CountProxy, &numVisible );
+	BenchConsume( numVisible );
+	return PHYSICS_NUM_BOXES;
+}
+
+typedef enum CullMethod {
+	CULL_BOXES,
+	CULL_BOXES_CACHED,
+	CULL_BOXES_INDICES,
+	CULL_SPHERES_CACHED,
+} CullMethod;
+
+typedef struct CullScene {
+	CullMethod method;
+	bool inside; /* from the middle of the scene, so most of it's culled */
+} CullScene;
+
+/* the same boxes split out by component, for culling in batches */
+typedef struct CullData {
+	PhysicsData *scene;
+	CullMethod method;
+	float centres[ 3 ][ PHYSICS_NUM_BOXES ], extents[ 3 ][ PHYSICS_NUM_BOXES ], radii[ PHYSICS_NUM_BOXES ];
+	uint8_t planeCache[ PHYSICS_NUM_BOXES ];
+	uint32_t visibleBits[ PL_CULL_BITSET_WORDS( PHYSICS_NUM_BOXES ) ];
+	unsigned int visibleIndices[ PHYSICS_NUM_BOXES ];
+	unsigned int numVisible;
+} CullData;
+
+#define CULL_CELL_SIZE 32.0f
+
+typedef struct CullOrder {
+	unsigned int cell, box;
+} CullOrder;
+
+static int CompareCullOrder( const void *a, const void *b ) {
+	const CullOrder *oa = a, *ob = b;
+	if ( oa->cell != ob->cell ) {
+		return ( oa->cell < ob->cell ) ? -1 : 1;
+	}
+	return ( oa->box < ob->box ) ? -1 : ( oa->box > ob->box );
+}
+
+static void *SetupCull( const void *parm ) {
+	const CullScene *cullScene = parm;
+	CullData *data = pl_calloc( 1, sizeof( CullData ) );
+	data->scene = SetupPhysics( NULL );
+	data->method = cullScene->method;
+	if ( cullScene->inside ) {
+		SetupFrustum( data->scene->frustum, PLVector3( 0.0f, 0.0f, 0.0f ), PLVector3( 1.0f, 0.0f, 0.0f ) );
+	}
+	/* objects are usually kept in some spatial order, so neighbours tend to be culled by the same plane */
+	static CullOrder order[ PHYSICS_NUM_BOXES ];
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		const PLVector3 *origin = &data->scene->boxes[ i ].origin;
+		unsigned int cell[ 3 ];
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			cell[ j ] = ( unsigned int ) ( ( PlVector3Index( *origin, j ) + PHYSICS_SCENE_SIZE ) / CULL_CELL_SIZE );
+		}
+		order[ i ].cell = ( cell[ 0 ] * 256 + cell[ 1 ] ) * 256 + cell[ 2 ];
+		order[ i ].box = i;
+	}
+	qsort( order, PHYSICS_NUM_BOXES, sizeof( CullOrder ), CompareCullOrder );
+	for ( unsigned int i = 0; i < PHYSICS_NUM_BOXES; ++i ) {
+		const PLCollisionAABB *box = &data->scene->boxes[ order[ i ].box ];
+		PLVector3 mins = PlAddVector3( box->mins, box->origin );
+		PLVector3 maxs = PlAddVector3( box->maxs, box->origin );
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			data->centres[ j ][ i ] = ( PlVector3Index( mins, j ) + PlVector3Index( maxs, j ) ) * 0.5f;
+			data->extents[ j ][ i ] = ( PlVector3Index( maxs, j ) - PlVector3Index( mins, j ) ) * 0.5f;
+		}
+		data->radii[ i ] = PlVector3Length( PLVector3( data->extents[ 0 ][ i ], data->extents[ 1 ][ i ], data->extents[ 2 ][ i ] ) );
+	}
+	return data;
+}
+
+static void TeardownCull( void *userData ) {
+	CullData *data = userData;
+	TeardownPhysics( data->scene );
+	pl_free( data );
+}
+
+/* the cache carries over between runs, as it would between frames */
+static uint64_t RunCull( void *userData ) {
+	CullData *data = userData;
+	PLVector3SoA centres = { data->centres[ 0 ], data->centres[ 1 ], data->centres[ 2 ] };
+	PLVector3SoA extents = { data->extents[ 0 ], data->extents[ 1 ], data->extents[ 2 ] };
+	switch ( data->method ) {
+		case CULL_BOXES:
+			data->numVisible = PlCullBoxes( data->scene->frustum, 6, &centres, &extents, PHYSICS_NUM_BOXES, NULL, data->visibleBits, NULL );
+			break;
+		case CULL_BOXES_CACHED:
+			data->numVisible = PlCullBoxes( data->scene->frustum, 6, &centres, &extents, PHYSICS_NUM_BOXES, data->planeCache, data->visibleBits, NULL );
+			break;
+		case CULL_BOXES_INDICES:
+			data->numVisible = PlCullBoxes( data->scene->frustum, 6, &centres, &extents, PHYSICS_NUM_BOXES, data->planeCache, NULL, data->visibleIndices );
+			break;
+		case CULL_SPHERES_CACHED:
+			data->numVisible = PlCullSpheres( data->scene->frustum, 6, &centres, data->radii, PHYSICS_NUM_BOXES, data->planeCache, data->visibleBits, NULL );
+			break;
+	}
+	BenchConsume( data->numVisible );
+	return PHYSICS_NUM_BOXES;
+}
+
+static void AnnotateCull( void *userData, char *note, size_t size ) {
+	const CullData *data = userData;
+	snprintf( note, size, "%.1f%% visible", data->numVisible * 100.0 / PHYSICS_NUM_BOXES );
+}
+
+/****************************************
+ * Broadphase
+ ****************************************/
+
+typedef enum BroadphaseMethod {
+	METHOD_SWEEP_AND_PRUNE,
+	METHOD_HASH_GRID,
+	METHOD_TREE,
+} BroadphaseMethod;
+
+typedef struct BroadphaseScene {
+	unsigned int numBoxes;
+	BroadphaseMethod method;
+	unsigned int moveEvery; /* 1 for everything, 10 for every tenth box, etc. */
+} BroadphaseScene;
+
+/**
+ * Boxes drifting about and bouncing off the walls, at the same density
+ * whatever the count, so there's about one overlap for each.
+ */
+typedef struct BroadphaseData {
+	BroadphaseScene scene;
+	PLCollisionAABB *boxes;
+	PLVector3 *velocities;
+	unsigned int *proxies;
+	float extent;
+	PLBroadphase *broadphase;
+	PLAabbTree *tree;
+	uint64_t numUpdates, numPairs, numChanged;
+} BroadphaseData;
+
+static PLBroadphase *CreateSceneBroadphase( BroadphaseMethod method ) {
+	return ( method == METHOD_SWEEP_AND_PRUNE ) ? PlCreateSweepAndPruneBroadphase() : PlCreateHashGridBroadphase( 4.0f );
+}
+
+static void AddSceneProxies( BroadphaseData *data ) {
+	for ( unsigned int i = 0; i < data->scene.numBoxes; ++i ) {
+		if ( data->scene.method == METHOD_TREE ) {
+			data->proxies[ i ] = PlInsertAabbTreeProxy( data->tree, &data->boxes[ i ], NULL );
+		} else {
+			data->proxies[ i ] = PlAddBroadphaseProxy( data->broadphase, &data->boxes[ i ], NULL );
+		}
+	}
+}
+
+static void *SetupBroadphase( const void *parm ) {
+	BroadphaseData *data = pl_calloc( 1, sizeof( BroadphaseData ) );
+	data->scene = *( const BroadphaseScene * ) parm;
+	data->boxes = pl_malloc( sizeof( PLCollisionAABB ) * data->scene.numBoxes );
+	data->velocities = pl_malloc( sizeof( PLVector3 ) * data->scene.numBoxes );
+	data->proxies = pl_malloc( sizeof( unsigned int ) * data->scene.numBoxes );
+	data->extent = 2.0f * cbrtf( ( float ) data->scene.numBoxes );
+
+	PLRandom rng;
+	PlSeedRandom( &rng, data->scene.numBoxes );
+	for ( unsigned int i = 0; i < data->scene.numBoxes; ++i ) {
+		PLVector3 origin, size;
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			PlVector3Index( origin, j ) = PlRandomFloatRange( &rng, -data->extent, data->extent );
+			PlVector3Index( size, j ) = PlRandomFloatRange( &rng, 0.5f, 1.5f );
+			PlVector3Index( data->velocities[ i ], j ) = PlRandomFloatRange( &rng, -0.2f, 0.2f );
+		}
+		data->boxes[ i ] = PlSetupCollisionAABB( origin, PlScaleVector3F( size, -1.0f ), size );
+	}
+
+	if ( data->scene.method == METHOD_TREE ) {
+		data->tree = PlCreateAabbTree( 0.2f );
+	} else {
+		data->broadphase = CreateSceneBroadphase( data->scene.method );
+	}
+	AddSceneProxies( data );
+	if ( data->broadphase != NULL ) {
+		PlUpdateBroadphase( data->broadphase );
+	}
+	return data;
+}
+
+static void TeardownBroadphase( void *userData ) {
+	BroadphaseData *data = userData;
+	PlDestroyBroadphase( data->broadphase );
+	PlDestroyAabbTree( data->tree );
+	pl_free( data->boxes );
+	pl_free( data->velocities );
+	pl_free( data->proxies );
+	pl_free( data );
+}
+
+static void ResetBroadphase( void *userData ) {
+	BroadphaseData *data = userData;
+	PlDestroyBroadphase( data->broadphase );
+	data->broadphase = CreateSceneBroadphase( data->scene.method );
+}
+
+static void AnnotateBroadphase( void *userData, char *note, size_t size ) {
+	BroadphaseData *data = userData;
+	if ( data->numUpdates > 0 ) {
+		snprintf( note, size, "%" PRIu64 " pairs, %" PRIu64 " changed", data->numPairs / data->numUpdates, data->numChanged / data->numUpdates );
+	}
+}
+
+static void MoveSceneBox( BroadphaseData *data, unsigned int i ) {
+	PLCollisionAABB *box = &data->boxes[ i ];
+	box->origin = PlAddVector3( box->origin, data->velocities[ i ] );
+	for ( unsigned int j = 0; j < 3; ++j ) {
+		if ( PlVector3Index( box->origin, j ) < -data->extent || PlVector3Index( box->origin, j ) > data->extent ) {
+			PlVector3Index( data->velocities[ i ], j ) = -PlVector3Index( data->velocities[ i ], j );
+		}
+	}
+}
+
+static uint64_t RunBroadphaseUpdate( void *userData ) {
+	BroadphaseData *data = userData;
+	for ( unsigned int i = 0; i < data->scene.numBoxes; i += data->scene.moveEvery ) {
+		MoveSceneBox( data, i );
+		PlSetBroadphaseProxyBounds( data->broadphase, data->proxies[ i ], &data->boxes[ i ] );
+	}
+	PlUpdateBroadphase( data->broadphase );
+
+	unsigned int numPairs, numAdded, numRemoved;
+	PlGetBroadphasePairs( data->broadphase, &numPairs );
+	PlGetBroadphaseAddedPairs( data->broadphase, &numAdded );
+	PlGetBroadphaseRemovedPairs( data->broadphase, &numRemoved );
+	data->numUpdates++;
+	data->numPairs += numPairs;
+	data->numChanged += numAdded + numRemoved;
+	BenchConsume( numPairs );
+	return data->scene.numBoxes;
+}
+
+static uint64_t RunBroadphaseTreeUpdate( void *userData ) {
+	BroadphaseData *data = userData;
+	for ( unsigned int i = 0; i < data->scene.numBoxes; i += data->scene.moveEvery ) {
+		MoveSceneBox( data, i );
+		PlMoveAabbTreeProxy( data->tree, data->proxies[ i ], &data->boxes[ i ], data->velocities[ i ] );
+	}
+
+	unsigned int numPairs = 0;
+	PlGetAabbTreeOverlapPairs( data->tree, CountPair, &numPairs );
+	data->numUpdates++;
+	data->numPairs += numPairs;
+	BenchConsume( numPairs );
+	return data->scene.numBoxes;
+}
+
+static uint64_t RunBroadphaseBuild( void *userData ) {
+	BroadphaseData *data = userData;
+	AddSceneProxies( data );
+	PlUpdateBroadphase( data->broadphase );
+
+	unsigned int numPairs;
+	PlGetBroadphasePairs( data->broadphase, &numPairs );
+	BenchConsume( numPairs );
+	return data->scene.numBoxes;
+}
+
+/****************************************
+ * Narrowphase
+ ****************************************/
+
+#define NARROWPHASE_NUM_PAIRS 4096
+#define NARROWPHASE_HULL_SIZE 16
+
+typedef struct NarrowphaseScene {
+	PLCollisionShapeType typeA, typeB;
+} NarrowphaseScene;
+
+/**
+ * Pairs of randomly sized and turned shapes, each close enough to the
+ * other that most are touching.
+ */
+typedef struct NarrowphaseData {
+	PLCollisionShape shapes[ NARROWPHASE_NUM_PAIRS * 2 ];
+	PLVector3 vertices[ NARROWPHASE_NUM_PAIRS * 2 ][ NARROWPHASE_HULL_SIZE ];
+	PLContactManifold manifolds[ NARROWPHASE_NUM_PAIRS ];
+	unsigned int numTouching;
+} NarrowphaseData;
+
+static PLVector3 GetRandomDirection( PLRandom *rng ) {
+	PLVector3 v;
+	do {
+		v = PLVector3( PlRandomFloatRange( rng, -1.0f, 1.0f ), PlRandomFloatRange( rng, -1.0f, 1.0f ), PlRandomFloatRange( rng, -1.0f, 1.0f ) );
+	} while ( PlVector3DotProduct( v, v ) < 0.01f || PlVector3DotProduct( v, v ) > 1.0f );
+	return PlNormalizeVector3( v );
+}
+
+static PLCollisionShape GetRandomShape( PLRandom *rng, PLCollisionShapeType type, PLVector3 centre, PLVector3 *vertices ) {
+	PLCollisionShape shape = { .type = type };
+	switch ( type ) {
+		case PL_COLLISION_SHAPE_SPHERE:
+			shape.sphere = PlSetupCollisionSphere( centre, PlRandomFloatRange( rng, 0.5f, 1.0f ) );
+			break;
+		case PL_COLLISION_SHAPE_AABB: {
+			PLVector3 extents = PLVector3( PlRandomFloatRange( rng, 0.5f, 1.0f ), PlRandomFloatRange( rng, 0.5f, 1.0f ), PlRandomFloatRange( rng, 0.5f, 1.0f ) );
+			shape.aabb = PlSetupCollisionAABB( centre, PlScaleVector3F( extents, -1.0f ), extents );
+			break;
+		}
+		case PL_COLLISION_SHAPE_CAPSULE: {
+			PLVector3 half = PlScaleVector3F( GetRandomDirection( rng ), PlRandomFloatRange( rng, 0.3f, 0.7f ) );
+			shape.capsule = ( PLCollisionCapsule ){ PlSubtractVector3( centre, half ), PlAddVector3( centre, half ), PlRandomFloatRange( rng, 0.3f, 0.5f ) };
+			break;
+		}
+		case PL_COLLISION_SHAPE_OBB: {
+			PLVector3 x = GetRandomDirection( rng ), y = GetRandomDirection( rng );
+			PLVector3 z = PlNormalizeVector3( PlVector3CrossProduct( x, y ) );
+			shape.obb.origin = centre;
+			shape.obb.axes[ 0 ] = x;
+			shape.obb.axes[ 1 ] = PlVector3CrossProduct( z, x );
+			shape.obb.axes[ 2 ] = z;
+			shape.obb.extents = PLVector3( PlRandomFloatRange( rng, 0.5f, 1.0f ), PlRandomFloatRange( rng, 0.5f, 1.0f ), PlRandomFloatRange( rng, 0.5f, 1.0f ) );
+			break;
+		}
+		default:
+			for ( unsigned int i = 0; i < NARROWPHASE_HULL_SIZE; ++i ) {
+				vertices[ i ] = PlScaleVector3F( GetRandomDirection( rng ), PlRandomFloatRange( rng, 0.7f, 1.0f ) );
+			}
+			shape.hull = ( PLCollisionHull ){ centre, vertices, NARROWPHASE_HULL_SIZE };
+			break;
+	}
+	return shape;
+}
+
+static void *SetupNarrowphase( const void *parm ) {
+	const NarrowphaseScene *scene = parm;
+	NarrowphaseData *data = pl_malloc( sizeof( NarrowphaseData ) );
+	PLRandom rng;
+	PlSeedRandom( &rng, scene->typeA * PL_NUM_COLLISION_SHAPES + scene->typeB );
+	for ( unsigned int i = 0; i < NARROWPHASE_NUM_PAIRS; ++i ) {
+		PLVector3 centre = PLVector3( i * 4.0f, 0.0f, 0.0f );
+		PLVector3 offset = PlScaleVector3F( GetRandomDirection( &rng ), PlRandomFloatRange( &rng, 0.5f, 2.0f ) );
+		data->shapes[ i * 2 ] = GetRandomShape( &rng, scene->typeA, centre, data->vertices[ i * 2 ] );
+		data->shapes[ i * 2 + 1 ] = GetRandomShape( &rng, scene->typeB, PlAddVector3( centre, offset ), data->vertices[ i * 2 + 1 ] );
+	}
+	return data;
+}
+
+static void TeardownNarrowphase( void *userData ) {
+	pl_free( userData );
+}
+
+static uint64_t RunNarrowphase( void *userData ) {
+	NarrowphaseData *data = userData;
+	unsigned int numTouching = 0;
+	for ( unsigned int i = 0; i < NARROWPHASE_NUM_PAIRS; ++i ) {
+		numTouching += PlCollideShapes( &data->shapes[ i * 2 ], &data->shapes[ i * 2 + 1 ], &data->manifolds[ i ] );
+	}
+	data->numTouching = numTouching;
+	BenchConsume( numTouching );
+	return NARROWPHASE_NUM_PAIRS;
+}
+
+static void AnnotateNarrowphase( void *userData, char *note, size_t size ) {
+	const NarrowphaseData *data = userData;
+	snprintf( note, size, "%.1f%% touching", data->numTouching * 100.0 / NARROWPHASE_NUM_PAIRS );
+}
+
+/* everything from the 10k broadphase scene as boxes, a frame at a time */
+typedef struct ContactsData {
+	BroadphaseData *scene;
+	PLCollisionShape *shapes;
+	PLContactManifold *manifolds;
+	uint64_t numPairs, numContacts;
+} ContactsData;
+
+static void *SetupContacts( const void *parm ) {
+	ContactsData *data = pl_calloc( 1, sizeof( ContactsData ) );
+	data->scene = SetupBroadphase( parm );
+	data->shapes = pl_calloc( data->scene->scene.numBoxes, sizeof( PLCollisionShape ) );
+	return data;
+}
+
+static void TeardownContacts( void *userData ) {
+	ContactsData *data = userData;
+	TeardownBroadphase( data->scene );
+	pl_free( data->shapes );
+	pl_free( data->manifolds );
+	pl_free( data );
+}
+
+static uint64_t RunContacts( void *userData ) {
+	ContactsData *data = userData;
+	BroadphaseData *scene = data->scene;
+	for ( unsigned int i = 0; i < scene->scene.numBoxes; ++i ) {
+		MoveSceneBox( scene, i );
+		PlSetBroadphaseProxyBounds( scene->broadphase, scene->proxies[ i ], &scene->boxes[ i ] );
+		data->shapes[ scene->proxies[ i ] ] = ( PLCollisionShape ){ .type = PL_COLLISION_SHAPE_AABB, .aabb = scene->boxes[ i ] };
+	}
+	PlUpdateBroadphase( scene->broadphase );
+
+	unsigned int numPairs;
+	const PLBroadphasePair *pairs = PlGetBroadphasePairs( scene->broadphase, &numPairs );
+	data->manifolds = pl_realloc( data->manifolds, sizeof( PLContactManifold ) * ( numPairs + 1 ) );
+	unsigned int numContacts = PlCollideShapePairs( data->shapes, pairs, numPairs, data->manifolds );
+	data->numPairs += numPairs;
+	data->numContacts += numContacts;
+	BenchConsume( numContacts );
+	return scene->scene.numBoxes;
+}
+
+static void AnnotateContacts( void *userData, char *note, size_t size ) {
+	const ContactsData *data = userData;
+	if ( data->numPairs > 0 ) {
+		snprintf( note, size, "%.1f%% of pairs touching", data->numContacts * 100.0 / data->numPairs );
+	}
+}
+
+void RegisterPhysicsBenchmarks( void ) {
+	static const CullScene cullBoxes = { CULL_BOXES, false };
+	static const CullScene cullBoxesCached = { CULL_BOXES_CACHED, false };
+	static const CullScene cullBoxesIndices = { CULL_BOXES_INDICES, false };
+	static const CullScene cullSpheresCached = { CULL_SPHERES_CACHED, false };
+	static const CullScene cullBoxesInside = { CULL_BOXES, true };
+	static const CullScene cullBoxesInsideCached = { CULL_BOXES_CACHED, true };
+	static const BroadphaseScene sap10k = { 10000, METHOD_SWEEP_AND_PRUNE, 1 };
+	static const BroadphaseScene sap100k = { 100000, METHOD_SWEEP_AND_PRUNE, 1 };
+	static const BroadphaseScene sap100kResting = { 100000, METHOD_SWEEP_AND_PRUNE, 10 };
+	static const BroadphaseScene grid10k = { 10000, METHOD_HASH_GRID, 1 };
+	static const BroadphaseScene grid100k = { 100000, METHOD_HASH_GRID, 1 };
+	static const BroadphaseScene grid100kResting = { 100000, METHOD_HASH_GRID, 10 };
+	static const BroadphaseScene tree10k = { 10000, METHOD_TREE, 1 };
+	static const BroadphaseScene tree100k = { 100000, METHOD_TREE, 1 };
+	static const NarrowphaseScene spheres = { PL_COLLISION_SHAPE_SPHERE, PL_COLLISION_SHAPE_SPHERE };
+	static const NarrowphaseScene sphereAabbs = { PL_COLLISION_SHAPE_SPHERE, PL_COLLISION_SHAPE_AABB };
+	static const NarrowphaseScene aabbs = { PL_COLLISION_SHAPE_AABB, PL_COLLISION_SHAPE_AABB };
+	static const NarrowphaseScene capsules = { PL_COLLISION_SHAPE_CAPSULE, PL_COLLISION_SHAPE_CAPSULE };
+	static const NarrowphaseScene obbs = { PL_COLLISION_SHAPE_OBB, PL_COLLISION_SHAPE_OBB };
+	static const NarrowphaseScene capsuleObbs = { PL_COLLISION_SHAPE_CAPSULE, PL_COLLISION_SHAPE_OBB };
+	static const NarrowphaseScene sphereHulls = { PL_COLLISION_SHAPE_SPHERE, PL_COLLISION_SHAPE_HULL };
+	static const NarrowphaseScene hulls = { PL_COLLISION_SHAPE_HULL, PL_COLLISION_SHAPE_HULL };
+
+	static const Benchmark list[] = {
+	        { "physics/tree_insert", SetupPhysics, ResetScratchTree, RunInsertTree, TeardownPhysics },
+	        { "physics/tree_build_sah", SetupPhysics, ResetScratchTree, RunBuildSahTree, TeardownPhysics },
+	        { "physics/tree_move", SetupPhysics, NULL, RunMoveTree, TeardownPhysics },
+	        { "physics/brute_force_pairs", SetupPhysics, NULL, RunPairsBruteForce, TeardownPhysics },
+	        { "physics/tree_pairs", SetupPhysics, NULL, RunPairsTree, TeardownPhysics },
+	        { "physics/sah_tree_pairs", SetupPhysics, NULL, RunPairsSahTree, TeardownPhysics },
+	        { "physics/brute_force_raycast", SetupPhysics, NULL, RunRaycastBruteForce, TeardownPhysics },
+	        { "physics/tree_raycast", SetupPhysics, NULL, RunRaycastDynamicTree, TeardownPhysics },
+	        { "physics/sah_tree_raycast", SetupPhysics, NULL, RunRaycastSahTree, TeardownPhysics },
+	        { "physics/brute_force_frustum", SetupPhysics, NULL, RunFrustumBruteForce, TeardownPhysics },
+	        { "physics/sah_tree_frustum", SetupPhysics, NULL, RunFrustumTree, TeardownPhysics },
+	        { "physics/batch_frustum_boxes", SetupCull, NULL, RunCull, TeardownCull, &cullBoxes, 0, AnnotateCull },
+	        { "physics/batch_frustum_boxes_cached", SetupCull, NULL, RunCull, TeardownCull, &cullBoxesCached, 0, AnnotateCull },
+	        { "physics/batch_frustum_boxes_indices", SetupCull, NULL, RunCull, TeardownCull, &cullBoxesIndices, 0, AnnotateCull },
+	        { "physics/batch_frustum_spheres_cached", SetupCull, NULL, RunCull, TeardownCull, &cullSpheresCached, 0, AnnotateCull },
+	        { "physics/batch_frustum_boxes_inside", SetupCull, NULL, RunCull, TeardownCull, &cullBoxesInside, 0, AnnotateCull },
+	        { "physics/batch_frustum_boxes_inside_cached", SetupCull, NULL, RunCull, TeardownCull, &cullBoxesInsideCached, 0, AnnotateCull },
+	        { "physics/broadphase_sap_10k", SetupBroadphase, NULL, RunBroadphaseUpdate, TeardownBroadphase, &sap10k, 0, AnnotateBroadphase },
+	        { "physics/broadphase_grid_10k", SetupBroadphase, NULL, RunBroadphaseUpdate, TeardownBroadphase, &grid10k, 0, AnnotateBroadphase },
+	        { "physics/broadphase_tree_10k", SetupBroadphase, NULL, RunBroadphaseTreeUpdate, TeardownBroadphase, &tree10k, 0, AnnotateBroadphase },
+	        { "physics/broadphase_sap_100k", SetupBroadphase, NULL, RunBroadphaseUpdate, TeardownBroadphase, &sap100k, 0, AnnotateBroadphase },
+	        { "physics/broadphase_grid_100k", SetupBroadphase, NULL, RunBroadphaseUpdate, TeardownBroadphase, &grid100k, 0, AnnotateBroadphase },
+	        { "physics/broadphase_tree_100k", SetupBroadphase, NULL, RunBroadphaseTreeUpdate, TeardownBroadphase, &tree100k, 0, AnnotateBroadphase },
+	        { "physics/broadphase_sap_100k_resting", SetupBroadphase, NULL, RunBroadphaseUpdate, TeardownBroadphase, &sap100kResting, 0, AnnotateBroadphase },
+	        { "physics/broadphase_grid_100k_resting", SetupBroadphase, NULL, RunBroadphaseUpdate, TeardownBroadphase, &grid100kResting, 0, AnnotateBroadphase },
+	        { "physics/broadphase_sap_build_100k", SetupBroadphase, ResetBroadphase, RunBroadphaseBuild, TeardownBroadphase, &sap100k },
+	        { "physics/broadphase_grid_build_100k", SetupBroadphase, ResetBroadphase, RunBroadphaseBuild, TeardownBroadphase, &grid100k },
+	        { "physics/narrowphase_sphere_sphere", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &spheres, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_sphere_aabb", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &sphereAabbs, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_aabb_aabb", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &aabbs, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_capsule_capsule", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &capsules, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_obb_obb", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &obbs, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_capsule_obb", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &capsuleObbs, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_sphere_hull", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &sphereHulls, 0, AnnotateNarrowphase },
+	        { "physics/narrowphase_hull_hull", SetupNarrowphase, NULL, RunNarrowphase, TeardownNarrowphase, &hulls, 0, AnnotateNarrowphase },
+	        { "physics/contacts_grid_10k", SetupContacts, NULL, RunContacts, TeardownContacts, &grid10k, 0, AnnotateContacts },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
@@ -0,0 +1,140 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_filesystem.h>
+
+#include "bench.h"
+
+#if defined( _WIN32 )
+#	include <direct.h>
+#	define rmdir _rmdir
+#else
+#	include <unistd.h>
+#endif
+
+#define VFS_DIRECTORY "bench_vfs"
+#define VFS_NUM_FILES 256
+#define VFS_FILE_SIZE 4096
+
+typedef struct VfsData {
+	char paths[ VFS_NUM_FILES ][ 64 ];
+} VfsData;
+
+static void *SetupVfs( const void *parm ) {
+	if ( !PlCreateDirectory( VFS_DIRECTORY ) ) {
+		return NULL;
+	}
+
+	VfsData *data = pl_malloc( sizeof( VfsData ) );
+	uint8_t *buf = pl_malloc( VFS_FILE_SIZE );
+	uint32_t seed = 0x1234;
+	for ( unsigned int i = 0; i < VFS_NUM_FILES; ++i ) {
+		for ( unsigned int j = 0; j < VFS_FILE_SIZE; ++j ) {
+			buf[ j ] = ( uint8_t ) BenchRandom( &seed );
+		}
+
+		snprintf( data->paths[ i ], sizeof( data->paths[ i ] ), VFS_DIRECTORY "/file%03u.bin", i );
+		if ( !PlWriteFile( data->paths[ i ], buf, VFS_FILE_SIZE ) ) {
+			pl_free( buf );
+			pl_free( data );
+			return NULL;
+		}
+	}
+
+	pl_free( buf );
+	return data;
+}
+
+static void TeardownVfs( void *userData ) {
+	VfsData *data = userData;
+	for ( unsigned int i = 0; i < VFS_NUM_FILES; ++i ) {
+		PlDeleteFile( data->paths[ i ] );
+	}
+	rmdir( VFS_DIRECTORY );
+	pl_free( data );
+}
+
+static uint64_t RunFileExists( void *userData ) {
+	VfsData *data = userData;
+	for ( unsigned int i = 0; i < VFS_NUM_FILES; ++i ) {
+		BenchConsume( PlFileExists( data->paths[ i ] ) );
+	}
+	return VFS_NUM_FILES;
+}
+
+static uint64_t RunOpenFile( void *userData ) {
+	VfsData *data = userData;
+	for ( unsigned int i = 0; i < VFS_NUM_FILES; ++i ) {
+		PLFile *file = PlOpenFile( data->paths[ i ], true );
+		if ( file != NULL ) {
+			BenchConsume( PlGetFileData( file )[ 0 ] );
+			PlCloseFile( file );
+		}
+	}
+	return VFS_NUM_FILES;
+}
+
+static uint64_t RunReadFile( void *userData ) {
+	VfsData *data = userData;
+	uint8_t buf[ 64 ];
+	uint64_t numReads = 0;
+	for ( unsigned int i = 0; i < VFS_NUM_FILES; ++i ) {
+		PLFile *file = PlOpenFile( data->paths[ i ], false );
+		if ( file == NULL ) {
+			continue;
+		}
+
+		while ( PlReadFile( file, buf, sizeof( buf ), 1 ) == 1 ) {
+			BenchConsume( buf[ 0 ] );
+			numReads++;
+		}
+		PlCloseFile( file );
+	}
+	return numReads;
+}
+
+static void ScanCallback( const char *path, void *userData ) {
+	( *( unsigned int * ) userData )++;
+}
+
+static uint64_t RunScanDirectory( void *userData ) {
+	unsigned int numFiles = 0;
+	PlScanDirectory( VFS_DIRECTORY, "bin", ScanCallback, false, &numFiles );
+	return numFiles;
+}
+
+void RegisterVfsBenchmarks( void ) {
+	static const Benchmark list[] = {
+	        { "vfs/file_exists", SetupVfs, NULL, RunFileExists, TeardownVfs },
+	        { "vfs/open_cached", SetupVfs, NULL, RunOpenFile, TeardownVfs },
+	        { "vfs/read_uncached_64b", SetupVfs, NULL, RunReadFile, TeardownVfs },
+	        { "vfs/scan_directory", SetupVfs, NULL, RunScanDirectory, TeardownVfs },
+	};
+	for ( unsigned int i = 0; i < plArrayElements( list ); ++i ) {
+		RegisterBenchmark( &list[ i ] );
+	}
+}
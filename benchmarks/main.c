@@ -0,0 +1,344 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org>
+*/
+
+#include <plcore/pl_console.h>
+#include <plcore/pl_package.h>
+
+#include "bench.h"
+
+/**
+ * Microbenchmark runner for the platform library.
+ *
+ * benchmarks [-filter <substring>] [-repetitions <n>] [-warmup <n>]
+ *            [-json <path>] [-baseline <path>] [-threshold <percent>] [-list] [-verbose]
+ *            [-simd <none|sse2|avx2>]
+ *
+ * Results can be written out as JSON via -json and a previous result passed
+ * back in via -baseline; any benchmark which has slowed down by more than
+ * the threshold is flagged and the runner exits with a failure.
+ **/
+
+#define MAX_BENCHMARKS 256
+
+volatile uint64_t benchSink;
+
+static Benchmark benchmarks[ MAX_BENCHMARKS ];
+static unsigned int numBenchmarks = 0;
+
+void RegisterBenchmark( const Benchmark *benchmark ) {
+	if ( numBenchmarks >= MAX_BENCHMARKS ) {
+		fprintf( stderr, "Too many benchmarks registered, ignoring %s!\n", benchmark->name );
+		return;
+	}
+
+	benchmarks[ numBenchmarks++ ] = *benchmark;
+}
+
+uint32_t BenchRandom( uint32_t *state ) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return ( *state = x );
+}
+
+typedef struct BenchResult {
+	const char *name;
+	unsigned int repetitions;
+	uint64_t items;
+	uint64_t min, median, p99;
+	double mean;
+	double nsPerItem;
+	double gbPerSecond; /* zero if the benchmark doesn't provide a size */
+	char note[ 64 ];
+} BenchResult;
+
+static int CompareSamples( const void *a, const void *b ) {
+	uint64_t x = *( const uint64_t * ) a;
+	uint64_t y = *( const uint64_t * ) b;
+	return ( x > y ) - ( x < y );
+}
+
+static bool RunBenchmark( const Benchmark *benchmark, unsigned int warmup, unsigned int repetitions, BenchResult *result ) {
+	uint64_t *samples = pl_malloc( sizeof( uint64_t ) * repetitions );
+	if ( samples == NULL ) {
+		fprintf( stderr, "Failed to allocate samples for %s!\n", benchmark->name );
+		return false;
+	}
+
+	void *userData = ( benchmark->Setup != NULL ) ? benchmark->Setup( benchmark->parm ) : NULL;
+	if ( benchmark->Setup != NULL && userData == NULL ) {
+		fprintf( stderr, "Failed to setup %s: %s\n", benchmark->name, PlGetError() );
+		pl_free( samples );
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < warmup; ++i ) {
+		if ( benchmark->Reset != NULL ) {
+			benchmark->Reset( userData );
+		}
+		benchmark->Run( userData );
+	}
+
+	uint64_t items = 0;
+	double total = 0.0;
+	for ( unsigned int i = 0; i < repetitions; ++i ) {
+		if ( benchmark->Reset != NULL ) {
+			benchmark->Reset( userData );
+		}
+
+		uint64_t start = PlGetMonotonicTime();
+		items = benchmark->Run( userData );
+		samples[ i ] = PlGetMonotonicTime() - start;
+		total += ( double ) samples[ i ];
+	}
+
+	result->note[ 0 ] = '\0';
+	if ( benchmark->Annotate != NULL ) {
+		benchmark->Annotate( userData, result->note, sizeof( result->note ) );
+	}
+
+	if ( benchmark->Teardown != NULL ) {
+		benchmark->Teardown( userData );
+	}
+
+	qsort( samples, repetitions, sizeof( uint64_t ), CompareSamples );
+
+	unsigned int p99 = ( unsigned int ) ( ( repetitions * 99 + 99 ) / 100 );
+
+	result->name = benchmark->name;
+	result->repetitions = repetitions;
+	result->items = items;
+	result->min = samples[ 0 ];
+	result->median = ( repetitions % 2 ) ? samples[ repetitions / 2 ] : ( samples[ repetitions / 2 - 1 ] + samples[ repetitions / 2 ] ) / 2;
+	result->p99 = samples[ p99 - 1 ];
+	result->mean = total / repetitions;
+	result->nsPerItem = ( items > 0 ) ? ( double ) result->median / ( double ) items : ( double ) result->median;
+	/* bytes per nanosecond is conveniently the same as gigabytes per second */
+	result->gbPerSecond = ( result->median > 0 ) ? ( double ) ( items * benchmark->bytesPerItem ) / ( double ) result->median : 0.0;
+
+	pl_free( samples );
+
+	return true;
+}
+
+/**
+ * Copies src into dst as the contents of a JSON string, escaping
+ * quotes, backslashes and control characters. Whatever doesn't fit
+ * is left off, rather than half an escape.
+ */
+static void EscapeJsonString( char *dst, size_t dstSize, const char *src ) {
+	size_t length = 0;
+	for ( ; *src != '\0'; ++src ) {
+		unsigned char c = ( unsigned char ) *src;
+		char escaped[ 8 ];
+		if ( c == '"' || c == '\\' ) {
+			snprintf( escaped, sizeof( escaped ), "\\%c", c );
+		} else if ( c < 0x20 ) {
+			snprintf( escaped, sizeof( escaped ), "\\u%04x", c );
+		} else {
+			escaped[ 0 ] = ( char ) c;
+			escaped[ 1 ] = '\0';
+		}
+
+		size_t n = strlen( escaped );
+		if ( length + n >= dstSize ) {
+			break;
+		}
+		memcpy( dst + length, escaped, n );
+		length += n;
+	}
+	dst[ length ] = '\0';
+}
+
+static bool WriteResults( const char *path, const BenchResult *results, unsigned int numResults ) {
+	FILE *file = fopen( path, "w" );
+	if ( file == NULL ) {
+		fprintf( stderr, "Failed to open %s for writing!\n", path );
+		return false;
+	}
+
+	/* one benchmark per line, which keeps reading it back in for comparison trivial */
+	fprintf( file, "{\"benchmarks\":[\n" );
+	for ( unsigned int i = 0; i < numResults; ++i ) {
+		char name[ 512 ], note[ 512 ];
+		EscapeJsonString( name, sizeof( name ), results[ i ].name );
+		EscapeJsonString( note, sizeof( note ), results[ i ].note );
+		fprintf( file, "{\"name\":\"%s\",\"repetitions\":%u,\"items\":%llu,\"min_ns\":%llu,\"median_ns\":%llu,\"p99_ns\":%llu,\"mean_ns\":%.1f,\"ns_per_item\":%.4f,\"gb_per_s\":%.4f,\"note\":\"%s\"}%s\n",
+		         name, results[ i ].repetitions, ( unsigned long long ) results[ i ].items,
+		         ( unsigned long long ) results[ i ].min, ( unsigned long long ) results[ i ].median, ( unsigned long long ) results[ i ].p99,
+		         results[ i ].mean, results[ i ].nsPerItem, results[ i ].gbPerSecond, note, ( i + 1 < numResults ) ? "," : "" );
+	}
+	fprintf( file, "]}\n" );
+
+	bool status = ( ferror( file ) == 0 );
+	fclose( file );
+	return status;
+}
+
+static bool GetBaselineResult( const char *path, const char *name, double *nsPerItem ) {
+	FILE *file = fopen( path, "r" );
+	if ( file == NULL ) {
+		return false;
+	}
+
+	/* escaped the same way as when written, see WriteResults */
+	char escapedName[ 512 ];
+	EscapeJsonString( escapedName, sizeof( escapedName ), name );
+	char key[ sizeof( escapedName ) + 16 ];
+	snprintf( key, sizeof( key ), "\"name\":\"%s\"", escapedName );
+
+	bool status = false;
+	char line[ 2048 ];
+	while ( fgets( line, sizeof( line ), file ) != NULL ) {
+		if ( strstr( line, key ) == NULL ) {
+			continue;
+		}
+
+		const char *value = strstr( line, "\"ns_per_item\":" );
+		if ( value != NULL ) {
+			*nsPerItem = strtod( value + 14, NULL );
+			status = true;
+		}
+		break;
+	}
+
+	fclose( file );
+	return status;
+}
+
+int main( int argc, char **argv ) {
+	if ( PlInitialize( argc, argv ) != PL_RESULT_SUCCESS ) {
+		fprintf( stderr, "Failed to initialize Hei: %s\n", PlGetError() );
+		return EXIT_FAILURE;
+	}
+
+	PlRegisterStandardPackageLoaders();
+
+	/* console parsing echoes every line, which would otherwise swamp the results */
+	if ( !PlHasCommandLineArgument( "-verbose" ) ) {
+		PlSetConsoleVariableByName( "log.plcore", "0" );
+	}
+
+	/* allows comparing the vectorised paths against the scalar ones */
+	const char *simd = PlGetCommandLineArgumentValue( "-simd" );
+	if ( simd != NULL ) {
+		if ( strcmp( simd, "none" ) == 0 ) {
+			PlSetSimdLevel( PL_SIMD_LEVEL_NONE );
+		} else if ( strcmp( simd, "sse2" ) == 0 ) {
+			PlSetSimdLevel( PL_SIMD_LEVEL_SSE2 );
+		} else if ( strcmp( simd, "avx2" ) == 0 ) {
+			PlSetSimdLevel( PL_SIMD_LEVEL_AVX2 );
+		} else {
+			fprintf( stderr, "Unknown SIMD level %s, expected none, sse2 or avx2!\n", simd );
+		}
+	}
+
+	RegisterVfsBenchmarks();
+	RegisterPackageBenchmarks();
+	RegisterImageBenchmarks();
+	RegisterMathBenchmarks();
+	RegisterMeshBenchmarks();
+	RegisterConsoleBenchmarks();
+	RegisterPhysicsBenchmarks();
+	RegisterOcclusionBenchmarks();
+
+	const char *filter = PlGetCommandLineArgumentValue( "-filter" );
+	const char *jsonPath = PlGetCommandLineArgumentValue( "-json" );
+	const char *baselinePath = PlGetCommandLineArgumentValue( "-baseline" );
+
+	const char *arg;
+	unsigned int repetitions = ( arg = PlGetCommandLineArgumentValue( "-repetitions" ) ) != NULL ? strtoul( arg, NULL, 10 ) : 30;
+	unsigned int warmup = ( arg = PlGetCommandLineArgumentValue( "-warmup" ) ) != NULL ? strtoul( arg, NULL, 10 ) : 3;
+	double threshold = ( arg = PlGetCommandLineArgumentValue( "-threshold" ) ) != NULL ? strtod( arg, NULL ) : 10.0;
+	if ( repetitions == 0 ) {
+		repetitions = 1;
+	}
+
+	if ( PlHasCommandLineArgument( "-list" ) ) {
+		for ( unsigned int i = 0; i < numBenchmarks; ++i ) {
+			printf( "%s\n", benchmarks[ i ].name );
+		}
+		PlShutdown();
+		return EXIT_SUCCESS;
+	}
+
+	BenchResult *results = pl_calloc( numBenchmarks, sizeof( BenchResult ) );
+	unsigned int numResults = 0;
+	unsigned int numRegressions = 0;
+
+	printf( "%-36s %12s %12s %12s %14s %10s\n", "benchmark", "min (us)", "median (us)", "p99 (us)", "ns/item", "GB/s" );
+	for ( unsigned int i = 0; i < numBenchmarks; ++i ) {
+		if ( filter != NULL && strstr( benchmarks[ i ].name, filter ) == NULL ) {
+			continue;
+		}
+
+		BenchResult *result = &results[ numResults ];
+		if ( !RunBenchmark( &benchmarks[ i ], warmup, repetitions, result ) ) {
+			continue;
+		}
+		numResults++;
+
+		printf( "%-36s %12.2f %12.2f %12.2f %14.3f", result->name,
+		        result->min / 1000.0, result->median / 1000.0, result->p99 / 1000.0, result->nsPerItem );
+		if ( result->gbPerSecond > 0.0 ) {
+			printf( " %10.2f", result->gbPerSecond );
+		} else {
+			printf( " %10s", "-" );
+		}
+
+		double baseline;
+		if ( baselinePath != NULL && GetBaselineResult( baselinePath, result->name, &baseline ) && baseline > 0.0 ) {
+			double change = ( ( result->nsPerItem - baseline ) / baseline ) * 100.0;
+			printf( " %+7.1f%%", change );
+			if ( change > threshold ) {
+				printf( " REGRESSION" );
+				numRegressions++;
+			}
+		}
+		if ( result->note[ 0 ] != '\0' ) {
+			printf( "  %s", result->note );
+		}
+		printf( "\n" );
+	}
+
+	if ( jsonPath != NULL && !WriteResults( jsonPath, results, numResults ) ) {
+		pl_free( results );
+		PlShutdown();
+		return EXIT_FAILURE;
+	}
+
+	pl_free( results );
+
+	if ( numRegressions > 0 ) {
+		printf( "%u benchmark(s) regressed by more than %.1f%%!\n", numRegressions, threshold );
+	}
+
+	PlShutdown();
+
+	return ( numRegressions > 0 ) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -28,6 +28,9 @@ For more information, please refer to <http://unlicense.org>
 #include <plcore/pl.h>
 #include <plcore/pl_console.h>
 #include <plcore/pl_image.h>
+#include <plcore/pl_thread.h>
+
+#include <inttypes.h>
 
 /**
  * Command line utility to interface with the platform lib.
@@ -54,37 +57,253 @@ static void ConvertImage( const char *path, const char *destination ) {
 	PlDestroyImage( image );
 }
 
-static void ConvertImageCallback( const char *path, void *userData ) {
-	char *outDir = ( char * ) userData;
-
-	if ( !PlCreateDirectory( outDir ) ) {
-		Error( "Error: %s\n", PlGetError() );
+static void Cmd_IMGConvert( unsigned int argc, char **argv ) {
+	if ( argc < 2 ) {
 		return;
 	}
 
+	const char *outPath = "./out.png";
+	if ( argc >= 3 ) {
+		outPath = argv[ 2 ];
+	}
+
+	ConvertImage( argv[ 1 ], outPath );
+}
+
+/****************************************
+ * Bulk conversion
+ *
+ * Scanning runs on the calling thread and feeds a reader thread, which
+ * pulls whole files into memory so that the workers never wait on I/O.
+ * The workers then decode, convert and write the images out. Both queues
+ * are bounded, and the reader holds off once the files it has in flight
+ * add up to the memory budget, so we don't run away on huge directories.
+ ****************************************/
+
+#define BULK_MAX_QUEUED_PATHS 1024
+#define BULK_DEFAULT_BUDGET   256 /* in MiB */
+
+typedef struct BulkJob {
+	char path[ PL_SYSTEM_MAX_PATH ];
+	char outPath[ PL_SYSTEM_MAX_PATH ];
+	PLFile *file;
+	size_t size;
+	struct BulkJob *next;
+} BulkJob;
+
+typedef struct BulkQueue {
+	BulkJob *head, *tail;
+	unsigned int length;
+	bool closed;
+} BulkQueue;
+
+typedef struct BulkStats {
+	volatile int64_t converted, skipped, failed;
+	volatile int64_t bytesRead, pixels;
+	volatile int64_t readTime, decodeTime, convertTime, writeTime; /* nanoseconds, summed over threads */
+} BulkStats;
+
+typedef struct BulkConverter {
+	const char *outDir;
+	bool force;
+
+	PLMutex *mutex;
+	PLCondition *condition; /* signalled whenever a queue or the budget changes */
+	BulkQueue pending, loaded;
+	size_t bytesInFlight, budget;
+
+	BulkStats stats;
+} BulkConverter;
+
+static void PushBulkJob( BulkQueue *queue, BulkJob *job ) {
+	job->next = NULL;
+	if ( queue->tail != NULL ) {
+		queue->tail->next = job;
+	} else {
+		queue->head = job;
+	}
+	queue->tail = job;
+	queue->length++;
+}
+
+static BulkJob *PopBulkJob( BulkQueue *queue ) {
+	BulkJob *job = queue->head;
+	if ( job != NULL ) {
+		queue->head = job->next;
+		if ( queue->head == NULL ) {
+			queue->tail = NULL;
+		}
+		queue->length--;
+	}
+	return job;
+}
+
+/* blocks until there's a job, or returns NULL once the queue is closed and drained */
+static BulkJob *WaitForBulkJob( BulkConverter *converter, BulkQueue *queue ) {
+	PlLockMutex( converter->mutex );
+	BulkJob *job;
+	while ( ( job = PopBulkJob( queue ) ) == NULL && !queue->closed ) {
+		PlWaitCondition( converter->condition, converter->mutex, 0 );
+	}
+	PlBroadcastCondition( converter->condition );
+	PlUnlockMutex( converter->mutex );
+	return job;
+}
+
+static void CloseBulkQueue( BulkConverter *converter, BulkQueue *queue ) {
+	PlLockMutex( converter->mutex );
+	queue->closed = true;
+	PlBroadcastCondition( converter->condition );
+	PlUnlockMutex( converter->mutex );
+}
+
+static void ScanBulkImageCallback( const char *path, void *userData ) {
+	BulkConverter *converter = userData;
+
 	const char *fileName = PlGetFileName( path );
 	if ( fileName == NULL ) {
 		Error( "Error: %s\n", PlGetError() );
 		return;
 	}
 
-	char outPath[ PL_SYSTEM_MAX_PATH ];
-	snprintf( outPath, sizeof( outPath ), "%s%s.png", outDir, fileName );
+	BulkJob *job = pl_calloc( 1, sizeof( BulkJob ) );
+	if ( job == NULL ) {
+		Error( "Failed to queue \"%s\"! (%s)\n", path, PlGetError() );
+		PlAtomicFetchAdd64( &converter->stats.failed, 1 );
+		return;
+	}
+
+	snprintf( job->path, sizeof( job->path ), "%s", path );
+	snprintf( job->outPath, sizeof( job->outPath ), "%s%s.png", converter->outDir, fileName );
+
+	/* skip anything that's already been converted since the source last changed */
+	if ( !converter->force && PlLocalFileExists( job->outPath ) ) {
+		time_t sourceTime = PlGetLocalFileTimeStamp( job->path );
+		if ( sourceTime != 0 && PlGetLocalFileTimeStamp( job->outPath ) >= sourceTime ) {
+			PlAtomicFetchAdd64( &converter->stats.skipped, 1 );
+			pl_free( job );
+			return;
+		}
+	}
 
-	ConvertImage( path, outPath );
+	PlLockMutex( converter->mutex );
+	while ( converter->pending.length >= BULK_MAX_QUEUED_PATHS ) {
+		PlWaitCondition( converter->condition, converter->mutex, 0 );
+	}
+	PushBulkJob( &converter->pending, job );
+	PlBroadcastCondition( converter->condition );
+	PlUnlockMutex( converter->mutex );
 }
 
-static void Cmd_IMGConvert( unsigned int argc, char **argv ) {
-	if ( argc < 2 ) {
-		return;
+static int BulkReaderThread( void *userData ) {
+	BulkConverter *converter = userData;
+
+	BulkJob *job;
+	while ( ( job = WaitForBulkJob( converter, &converter->pending ) ) != NULL ) {
+		/* hold off until there's room, though always allow one through so big files can't stall us */
+		size_t size = PlGetLocalFileSize( job->path );
+		PlLockMutex( converter->mutex );
+		while ( converter->bytesInFlight > 0 && converter->bytesInFlight + size > converter->budget ) {
+			PlWaitCondition( converter->condition, converter->mutex, 0 );
+		}
+		converter->bytesInFlight += size;
+		PlUnlockMutex( converter->mutex );
+
+		uint64_t start = PlGetMonotonicTime();
+		job->file = PlOpenFile( job->path, true );
+		PlAtomicFetchAdd64( &converter->stats.readTime, ( int64_t ) ( PlGetMonotonicTime() - start ) );
+
+		if ( job->file == NULL ) {
+			Error( "Failed to read \"%s\"! (%s)\n", job->path, PlGetError() );
+			PlAtomicFetchAdd64( &converter->stats.failed, 1 );
+		} else {
+			PlAtomicFetchAdd64( &converter->stats.bytesRead, ( int64_t ) PlGetFileSize( job->file ) );
+		}
+
+		PlLockMutex( converter->mutex );
+		if ( job->file == NULL ) {
+			converter->bytesInFlight -= size;
+			pl_free( job );
+		} else {
+			/* files from a package won't have had a local size to go on */
+			job->size = PlGetFileSize( job->file );
+			converter->bytesInFlight = converter->bytesInFlight - size + job->size;
+			PushBulkJob( &converter->loaded, job );
+		}
+		PlBroadcastCondition( converter->condition );
+		PlUnlockMutex( converter->mutex );
 	}
 
-	const char *outPath = "./out.png";
-	if ( argc >= 3 ) {
-		outPath = argv[ 2 ];
+	CloseBulkQueue( converter, &converter->loaded );
+	return 0;
+}
+
+static bool ProcessBulkJob( BulkConverter *converter, BulkJob *job ) {
+	uint64_t start = PlGetMonotonicTime();
+	PLImage *image = PlLoadImageFromFile( job->file, NULL );
+	uint64_t decoded = PlGetMonotonicTime();
+	PlAtomicFetchAdd64( &converter->stats.decodeTime, ( int64_t ) ( decoded - start ) );
+
+	/* done with the source, so let the reader have its budget back */
+	PlCloseFile( job->file );
+	job->file = NULL;
+	PlLockMutex( converter->mutex );
+	converter->bytesInFlight -= job->size;
+	PlBroadcastCondition( converter->condition );
+	PlUnlockMutex( converter->mutex );
+
+	if ( image == NULL ) {
+		Error( "Failed to load \"%s\"! (%s)\n", job->path, PlGetError() );
+		return false;
 	}
 
-	ConvertImage( argv[ 1 ], outPath );
+	/* ensure it's a valid format before we write it out */
+	bool status = PlConvertPixelFormat( image, PL_IMAGEFORMAT_RGBA8 );
+	uint64_t converted = PlGetMonotonicTime();
+	PlAtomicFetchAdd64( &converter->stats.convertTime, ( int64_t ) ( converted - decoded ) );
+
+	if ( status && !( status = PlWriteImage( image, job->outPath ) ) ) {
+		Error( "Failed to write \"%s\"! (%s)\n", job->outPath, PlGetError() );
+	} else if ( !status ) {
+		Error( "Failed to convert \"%s\"! (%s)\n", job->path, PlGetError() );
+	}
+	PlAtomicFetchAdd64( &converter->stats.writeTime, ( int64_t ) ( PlGetMonotonicTime() - converted ) );
+
+	if ( status ) {
+		PlAtomicFetchAdd64( &converter->stats.pixels, ( int64_t ) image->width * image->height );
+	}
+
+	PlDestroyImage( image );
+	return status;
+}
+
+static int BulkWorkerThread( void *userData ) {
+	BulkConverter *converter = userData;
+
+	BulkJob *job;
+	while ( ( job = WaitForBulkJob( converter, &converter->loaded ) ) != NULL ) {
+		PlAtomicFetchAdd64( ProcessBulkJob( converter, job ) ? &converter->stats.converted : &converter->stats.failed, 1 );
+		pl_free( job );
+	}
+
+	return 0;
+}
+
+static void PrintBulkStats( const BulkStats *stats, uint64_t elapsed ) {
+	double seconds = ( double ) elapsed / 1e9;
+	if ( seconds <= 0.0 ) {
+		seconds = 1e-9;
+	}
+
+	printf( "Converted %" PRId64 ", skipped %" PRId64 ", failed %" PRId64 " in %.2fs\n",
+	        stats->converted, stats->skipped, stats->failed, seconds );
+	printf( "  %.1f files/s, %.1f MiB/s read, %.1f MPixels/s\n",
+	        ( double ) stats->converted / seconds,
+	        PlBytesToMebibytes( stats->bytesRead ) / seconds,
+	        ( double ) stats->pixels / 1e6 / seconds );
+	printf( "  time spent (over all threads): read %.2fs, decode %.2fs, convert %.2fs, write %.2fs\n",
+	        ( double ) stats->readTime / 1e9, ( double ) stats->decodeTime / 1e9,
+	        ( double ) stats->convertTime / 1e9, ( double ) stats->writeTime / 1e9 );
 }
 
 static void Cmd_IMGBulkConvert( unsigned int argc, char **argv ) {
@@ -92,18 +311,196 @@ static void Cmd_IMGBulkConvert( unsigned int argc, char **argv ) {
 		return;
 	}
 
+	BulkConverter converter;
+	memset( &converter, 0, sizeof( converter ) );
+	converter.budget = ( size_t ) BULK_DEFAULT_BUDGET * 1024 * 1024;
+
+	unsigned int numWorkers = PlGetNumProcessors();
+
 	char outDir[ PL_SYSTEM_MAX_PATH ];
-	if ( argc >= 4 ) {
-		snprintf( outDir, sizeof( outDir ), "%s/", argv[ 3 ] );
+	snprintf( outDir, sizeof( outDir ), "out/" );
+	for ( unsigned int i = 3; i < argc; ++i ) {
+		if ( strcmp( argv[ i ], "-force" ) == 0 ) {
+			converter.force = true;
+		} else if ( strcmp( argv[ i ], "-j" ) == 0 && i + 1 < argc ) {
+			numWorkers = ( unsigned int ) strtoul( argv[ ++i ], NULL, 10 );
+		} else if ( strcmp( argv[ i ], "-mem" ) == 0 && i + 1 < argc ) {
+			converter.budget = ( size_t ) strtoul( argv[ ++i ], NULL, 10 ) * 1024 * 1024;
+		} else {
+			snprintf( outDir, sizeof( outDir ), "%s/", argv[ i ] );
+		}
+	}
+
+	if ( numWorkers == 0 ) {
+		numWorkers = 1;
+	}
+
+	if ( !PlCreateDirectory( outDir ) ) {
+		Error( "Error: %s\n", PlGetError() );
+		return;
+	}
+
+	converter.outDir = outDir;
+	converter.mutex = PlCreateMutex();
+	converter.condition = PlCreateCondition();
+
+	PLThread *reader = NULL;
+	PLThread **workers = pl_calloc( numWorkers, sizeof( PLThread * ) );
+	if ( converter.mutex == NULL || converter.condition == NULL || workers == NULL ||
+	     ( reader = PlCreateThread( BulkReaderThread, &converter ) ) == NULL ) {
+		Error( "Failed to set up bulk conversion! (%s)\n", PlGetError() );
+		pl_free( workers );
+		PlDestroyCondition( converter.condition );
+		PlDestroyMutex( converter.mutex );
+		return;
+	}
+
+	uint64_t start = PlGetMonotonicTime();
+
+	/* carry on with however many workers we managed to get */
+	unsigned int numStarted = 0;
+	for ( unsigned int i = 0; i < numWorkers; ++i ) {
+		if ( ( workers[ numStarted ] = PlCreateThread( BulkWorkerThread, &converter ) ) != NULL ) {
+			numStarted++;
+		}
+	}
+
+	/* without any workers the reader would fill its budget and never drain, so don't scan anything */
+	if ( numStarted == 0 ) {
+		Error( "Failed to start any workers! (%s)\n", PlGetError() );
 	} else {
-		snprintf( outDir, sizeof( outDir ), "out/" );
+		PlScanDirectory( argv[ 1 ], argv[ 2 ], ScanBulkImageCallback, false, &converter );
 	}
+	CloseBulkQueue( &converter, &converter.pending );
 
-	PlScanDirectory( argv[ 1 ], argv[ 2 ], ConvertImageCallback, false, outDir );
+	PlJoinThread( reader );
+	for ( unsigned int i = 0; i < numStarted; ++i ) {
+		PlJoinThread( workers[ i ] );
+	}
+	pl_free( workers );
+
+	PlDestroyCondition( converter.condition );
+	PlDestroyMutex( converter.mutex );
+
+	if ( numStarted == 0 ) {
+		return;
+	}
+
+	PrintBulkStats( &converter.stats, PlGetMonotonicTime() - start );
 
 	printf( "Done!\n" );
 }
 
+/****************************************
+ * Atlas packing
+ ****************************************/
+
+#define ATLAS_MAX_SIZE 8192
+
+typedef struct AtlasImages {
+	PLImage **images;
+	unsigned int numImages, maxImages;
+} AtlasImages;
+
+static void AddAtlasImageCallback( const char *path, void *userData ) {
+	AtlasImages *list = userData;
+
+	PLImage *image = PlLoadImage( path );
+	if ( image == NULL ) {
+		Error( "Failed to load \"%s\"! (%s)\n", path, PlGetError() );
+		return;
+	}
+
+	if ( list->numImages == list->maxImages ) {
+		list->maxImages = ( list->maxImages > 0 ) ? list->maxImages * 2 : 64;
+		list->images = pl_realloc( list->images, list->maxImages * sizeof( PLImage * ) );
+	}
+
+	list->images[ list->numImages++ ] = image;
+}
+
+static void Cmd_IMGAtlas( unsigned int argc, char **argv ) {
+	if ( argc < 4 ) {
+		return;
+	}
+
+	unsigned int padding = ( argc >= 5 ) ? ( unsigned int ) strtoul( argv[ 4 ], NULL, 10 ) : 2;
+	unsigned int alignment = ( argc >= 6 ) ? ( unsigned int ) strtoul( argv[ 5 ], NULL, 10 ) : 4;
+
+	AtlasImages list;
+	memset( &list, 0, sizeof( list ) );
+	PlScanDirectory( argv[ 1 ], argv[ 2 ], AddAtlasImageCallback, false, &list );
+	if ( list.numImages == 0 ) {
+		Error( "No images found in \"%s\"!\n", argv[ 1 ] );
+		return;
+	}
+
+	PLImageAtlasRect *rects = pl_calloc( list.numImages, sizeof( PLImageAtlasRect ) );
+
+	uint64_t start = PlGetMonotonicTime();
+	PLImage *atlas = PlCreateImageAtlas( list.images, list.numImages, padding, alignment, ATLAS_MAX_SIZE, rects );
+	double seconds = ( double ) ( PlGetMonotonicTime() - start ) / 1e9;
+
+	if ( atlas == NULL ) {
+		Error( "Failed to create atlas! (%s)\n", PlGetError() );
+	} else if ( !PlWriteImage( atlas, argv[ 3 ] ) ) {
+		Error( "Failed to write \"%s\"! (%s)\n", argv[ 3 ], PlGetError() );
+	} else {
+		/* uv table goes alongside, one image per line */
+		char tablePath[ PL_SYSTEM_MAX_PATH ];
+		snprintf( tablePath, sizeof( tablePath ), "%s.txt", argv[ 3 ] );
+		FILE *table = fopen( tablePath, "w" );
+		if ( table == NULL ) {
+			Error( "Failed to open \"%s\" for writing!\n", tablePath );
+		}
+
+		uint64_t used = 0;
+		for ( unsigned int i = 0; i < list.numImages; ++i ) {
+			const PLImageAtlasRect *rect = &rects[ i ];
+			used += ( uint64_t ) rect->width * rect->height;
+			if ( table != NULL ) {
+				fprintf( table, "%s %u %u %u %u %f %f %f %f\n", PlGetFileName( list.images[ i ]->path ),
+				         rect->x, rect->y, rect->width, rect->height, rect->s0, rect->t0, rect->s1, rect->t1 );
+			}
+		}
+
+		if ( table != NULL ) {
+			fclose( table );
+		}
+
+		printf( "Packed %u images into %ux%u (%.1f%% used) in %.2fms\n", list.numImages, atlas->width, atlas->height,
+		        ( double ) used * 100.0 / ( ( double ) atlas->width * atlas->height ), seconds * 1000.0 );
+		printf( "Wrote \"%s\" and \"%s\"\n", argv[ 3 ], tablePath );
+	}
+
+	PlDestroyImage( atlas );
+	for ( unsigned int i = 0; i < list.numImages; ++i ) {
+		PlDestroyImage( list.images[ i ] );
+	}
+	pl_free( list.images );
+	pl_free( rects );
+}
+
+static void Cmd_LogDecode( unsigned int argc, char **argv ) {
+	if ( argc < 2 ) {
+		return;
+	}
+
+	FILE *out = stdout;
+	if ( argc >= 3 && ( out = fopen( argv[ 2 ], "w" ) ) == NULL ) {
+		Error( "Failed to open \"%s\" for writing!\n", argv[ 2 ] );
+		return;
+	}
+
+	if ( !PlDecodeBinaryLog( argv[ 1 ], out ) ) {
+		Error( "Failed to decode \"%s\"! (%s)\n", argv[ 1 ], PlGetError() );
+	}
+
+	if ( out != stdout ) {
+		fclose( out );
+	}
+}
+
 static bool isRunning = true;
 
 static void Cmd_Exit( unsigned int argc, char **argv ) {
@@ -135,7 +532,14 @@ int main( int argc, char **argv ) {
 	                          "Usage: img_convert ./image.bmp [./out.png]" );
 	PlRegisterConsoleCommand( "img_bulkconvert", Cmd_IMGBulkConvert,
 	                          "Bulk convert images in the given directory.\n"
-	                          "Usage: img_bulkconvert ./path bmp [./outpath]" );
+	                          "Images that are older than an existing conversion are skipped, unless -force is given.\n"
+	                          "Usage: img_bulkconvert ./path bmp [./outpath] [-j workers] [-mem budgetMiB] [-force]" );
+	PlRegisterConsoleCommand( "img_atlas", Cmd_IMGAtlas,
+	                          "Pack the images in the given directory into a single atlas, with a uv table alongside.\n"
+	                          "Usage: img_atlas ./path png ./atlas.png [padding] [alignment]" );
+	PlRegisterConsoleCommand( "log_decode", Cmd_LogDecode,
+	                          "Decode a binary log back into text.\n"
+	                          "Usage: log_decode ./log.bin [./out.log]" );
 
 	PlInitializePlugins();
 
@@ -50,4 +50,5 @@ typedef struct PLFile {
 	size_t		size;
 	time_t		timeStamp;
 	void		*fptr;
+	bool		isUnmanaged; /* data belongs to the caller, don't free it */
 } PLFile;
@@ -137,15 +137,6 @@ static PLImage *FD3_ReadFile( PLFile *file ) {
 	return image;
 }
 
-PLImage *PlLoad3dfImage( const char *path ) {
-	PLFile *file = PlOpenFile( path, false );
-	if ( file == NULL ) {
-		return NULL;
-	}
-
-	PLImage *image = FD3_ReadFile( file );
-
-	PlCloseFile( file );
-
-	return image;
+PLImage *PlParse3dfImage( PLFile *file ) {
+	return FD3_ReadFile( file );
 }
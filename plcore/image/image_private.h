@@ -10,7 +10,26 @@
 
 #include <plcore/pl_image.h>
 
-PLImage *PlLoad3dfImage( const char *path );
-PLImage *PlLoadFtxImage( const char *path );
-PLImage *PlLoadTimImage( const char *path );
-PLImage *PlLoadSwlImage( const char *path );
+PLImage *PlParse3dfImage( PLFile *file );
+PLImage *PlParseFtxImage( PLFile *file );
+PLImage *PlParseTimImage( PLFile *file );
+PLImage *PlParseSwlImage( PLFile *file );
+
+bool _plIsPixelFormatConvertible( PLImageFormat format );
+bool _plPixelFormatHasAlpha( PLImageFormat format );
+bool _plPixelsToFloat( const uint8_t *src, PLImageFormat format, float *dst, size_t numPixels );
+bool _plFloatToPixels( const float *src, uint8_t *dst, PLImageFormat format, size_t numPixels );
+
+bool _plExpandPaletteIndices( const uint8_t *indices, unsigned int bitsPerIndex, size_t numPixels,
+                              const void *palette, unsigned int numColours, unsigned int bytesPerColour, uint8_t *dst );
+
+bool _plIsBlockCompressedFormat( PLImageFormat format );
+unsigned int _plGetBlockSize( PLImageFormat format );
+uint8_t **_plDecodeBlockCompressedLevels( const PLImage *image );
+uint8_t **_plEncodeBlockCompressedLevels( const PLImage *image, PLImageFormat format, PLImageCompressionQuality quality );
+
+uint8_t *_plGenerateMipmapChain( const PLImage *image, unsigned int numLevels, PLImageMipmapFilter filter, unsigned int flags );
+uint8_t *_plResampleImage( const PLImage *image, unsigned int width, unsigned int height, PLImageResizeFilter filter );
+
+bool _plReverseImagePixels( PLImage *image );
+uint8_t *_plRotateImageLevels( const PLImage *image, bool clockwise );
@@ -31,23 +31,33 @@ static PLImage *ReadSwlImage( PLFile *fin ) {
 	} palette[ 256 ];
 	if ( PlReadFile( fin, palette, 4, 256 ) != 256 ) {
 		PlReportBasicError( PL_RESULT_FILEREAD );
-		return false;
+		return NULL;
+	}
+
+	/* the alpha channel appears to be used more like
+	 * a flag to say "yes this texture will be transparent",
+	 * rather than actual levels of alpha for this pixel.
+	 *
+	 * because of that we'll just ignore it */
+	for ( unsigned int i = 0; i < 256; ++i ) {
+		palette[ i ].a = 255; /*(uint8_t) (255 - palette[i].a);*/
 	}
 
 	/* according to sources, this is a collection of misc data that's
    * specific to SiN itself, so we'll skip it. */
 	if ( !PlFileSeek( fin, 0x4D4, PL_SEEK_SET ) ) {
 		PlReportBasicError( PL_RESULT_FILEREAD );
-		return false;
+		return NULL;
 	}
 
-	PLImage *out = malloc( sizeof( PLImage ) );
+	PLImage *out = pl_calloc( 1, sizeof( PLImage ) );
 	out->width = header.width;
 	out->height = header.height;
 	out->levels = 4;
 	out->colour_format = PL_COLOURFORMAT_RGBA;
 	out->format = PL_IMAGEFORMAT_RGBA8;
 	out->size = PlGetImageSize( out->format, out->width, out->height );
+	out->data = pl_calloc( out->levels, sizeof( uint8_t * ) );
 
 	unsigned int mip_w = out->width;
 	unsigned int mip_h = out->height;
@@ -62,28 +72,15 @@ static PLImage *ReadSwlImage( PLFile *fin ) {
 		if ( PlReadFile( fin, buf, 1, buf_size ) != buf_size ) {
 			PlDestroyImage( out );
 			pl_free( buf );
-			return false;
+			return NULL;
 		}
 
-		out->data = pl_calloc( out->levels, sizeof( uint8_t * ) );
-
 		size_t level_size = PlGetImageSize( out->format, mip_w, mip_h );
 		out->data[ i ] = pl_calloc( level_size, sizeof( uint8_t ) );
 
 		/* now we fill in the buf we just allocated,
      * by using the palette */
-		for ( size_t j = 0, k = 0; j < buf_size; ++j, k += 4 ) {
-			out->data[ i ][ k ] = palette[ buf[ j ] ].r;
-			out->data[ i ][ k + 1 ] = palette[ buf[ j ] ].g;
-			out->data[ i ][ k + 2 ] = palette[ buf[ j ] ].b;
-
-			/* the alpha channel appears to be used more like
-       * a flag to say "yes this texture will be transparent",
-       * rather than actual levels of alpha for this pixel.
-       *
-       * because of that we'll just ignore it */
-			out->data[ i ][ k + 3 ] = 255; /*(uint8_t) (255 - palette[buf[j]].a);*/
-		}
+		_plExpandPaletteIndices( buf, 8, buf_size, palette, 256, 4, out->data[ i ] );
 
 		pl_free( buf );
 	}
@@ -91,15 +88,6 @@ static PLImage *ReadSwlImage( PLFile *fin ) {
 	return out;
 }
 
-PLImage *PlLoadSwlImage( const char *path ) {
-	PLFile *file = PlOpenFile( path, false );
-	if ( file == NULL ) {
-		return NULL;
-	}
-
-	PLImage *image = ReadSwlImage( file );
-
-	PlCloseFile( file );
-
-	return image;
+PLImage *PlParseSwlImage( PLFile *file ) {
+	return ReadSwlImage( file );
 }
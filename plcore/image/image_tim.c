@@ -182,7 +182,7 @@ static bool TIM_ReadFile( PLFile *fin, PLImage *out ) {
 		} break;
 
 		case TIM_TYPE_24BPP: {
-			out->width = image_info.width / 1.5;
+			out->width = ( unsigned int ) ( image_info.width * 2 ) / 3;
 			out->height = image_info.height;
 			out->format = PL_IMAGEFORMAT_RGB8;
 		} break;
@@ -209,64 +209,51 @@ static bool TIM_ReadFile( PLFile *fin, PLImage *out ) {
 	/* Copy the image data into the PLImage buffer. */
 
 	switch ( type ) {
-		case TIM_TYPE_4BPP: {
-			uint8_t *indata = image_data;
-			uint16_t *outdata = ( uint16_t * ) ( out->data[ 0 ] );
-
-			for ( ; indata < ( uint8_t * ) ( image_data + image_data_len ); ++indata ) {
-				uint8_t p1 = ( *indata & 0x0F );
-				uint8_t p2 = ( *indata & 0xF0 ) >> 4;
-
-				if ( p1 >= palette_size || p2 >= palette_size ) {
-					PlReportErrorF( PL_RESULT_FILETYPE, "out-of-range palette index in TIM image" );
-					goto ERR_CLEANUP;
-				}
+		case TIM_TYPE_4BPP:
+		case TIM_TYPE_8BPP: {
+			/* convert the palette once, rather than every pixel */
+			for ( uint32_t i = 0; i < palette_size; ++i ) {
+				palette[ i ] = _tim16toRGB51A( palette[ i ] );
+			}
 
-				*( outdata++ ) = _tim16toRGB51A( palette[ p1 ] );
-				*( outdata++ ) = _tim16toRGB51A( palette[ p2 ] );
+			unsigned int bitsPerIndex = ( type == TIM_TYPE_4BPP ) ? 4 : 8;
+			if ( !_plExpandPaletteIndices( image_data, bitsPerIndex, ( size_t ) out->width * out->height, palette, palette_size, sizeof( uint16_t ), out->data[ 0 ] ) ) {
+				goto ERR_CLEANUP;
 			}
 
+			out->colour_format = PL_COLOURFORMAT_ABGR;
 			break;
 		}
 
-		case TIM_TYPE_8BPP: {
-			uint8_t *indata = image_data;
+		case TIM_TYPE_16BPP: {
+			const uint8_t *indata = image_data;
 			uint16_t *outdata = ( uint16_t * ) ( out->data[ 0 ] );
 
-			for ( ; indata < ( uint8_t * ) ( image_data + image_data_len ); ++indata ) {
-				uint8_t p = *indata;
-
-				if ( p >= palette_size ) {
-					PlReportErrorF( PL_RESULT_FILETYPE, "out-of-range palette index in TIM image" );
-					goto ERR_CLEANUP;
-				}
-
-				*( outdata++ ) = _tim16toRGB51A( palette[ p ] );
+			for ( size_t i = 0; i < ( size_t ) out->width * out->height; ++i, indata += 2 ) {
+				*( outdata++ ) = _tim16toRGB51A( ( uint16_t ) ( indata[ 0 ] | ( indata[ 1 ] << 8 ) ) );
 			}
 
+			out->colour_format = PL_COLOURFORMAT_ABGR;
 			break;
 		}
 
-		case TIM_TYPE_16BPP: {
-			uint8_t *indata = image_data;
-			uint8_t *outdata = out->data[ 0 ];
-
-			for ( ; indata < ( uint8_t * ) ( image_data + image_data_len ); ++indata ) {
-				uint16_t colour = ( uint16_t ) ( ( *indata ) + ( ( *indata ) << 8 ) );
-				*( outdata++ ) = ( uint8_t ) ( colour );//(_tim16toRGB51A(colour));
+		case TIM_TYPE_24BPP: {
+			/* rows are padded out to a whole number of 16-bit words */
+			size_t srcStride = ( size_t ) image_info.width * 2;
+			size_t dstStride = ( size_t ) out->width * 3;
+			for ( unsigned int y = 0; y < out->height; ++y ) {
+				memcpy( out->data[ 0 ] + y * dstStride, image_data + y * srcStride, dstStride );
 			}
 
+			out->colour_format = PL_COLOURFORMAT_RGB;
 			break;
 		}
 
-		case TIM_TYPE_24BPP:
 		default:
 			PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported tim type (%d)", type );
 			goto ERR_CLEANUP;
 	}
 
-	out->colour_format = PL_COLOURFORMAT_ABGR;
-
 	pl_free( image_data );
 	pl_free( palette );
 
@@ -288,14 +275,8 @@ ERR_CLEANUP:
 	return false;
 }
 
-PLImage *PlLoadTimImage( const char *path ) {
-	PLFile *file = PlOpenFile( path, false );
-	if ( file == NULL ) {
-		return NULL;
-	}
-
+PLImage *PlParseTimImage( PLFile *file ) {
 	if ( !TIM_FormatCheck( file ) ) {
-		PlCloseFile( file );
 		return NULL;
 	}
 
@@ -307,7 +288,5 @@ PLImage *PlLoadTimImage( const char *path ) {
 		image = NULL;
 	}
 
-	PlCloseFile( file );
-
 	return image;
 }
@@ -21,16 +21,32 @@
 #if defined( STB_IMAGE_IMPLEMENTATION )
 #include "stb_image.h"
 
-static PLImage *LoadStbImage( const char *path ) {
-	PLFile *file = PlOpenFile( path, true );
-	if ( file == NULL ) {
-		return NULL;
-	}
+static int ReadStbCallback( void *user, char *data, int size ) {
+	return ( int ) PlReadFile( user, data, sizeof( char ), ( size_t ) size );
+}
 
-	int x, y, component;
-	unsigned char *data = stbi_load_from_memory( file->data, ( int ) file->size, &x, &y, &component, 4 );
+static void SkipStbCallback( void *user, int n ) {
+	PlFileSeek( user, n, PL_SEEK_CUR );
+}
 
-	PlCloseFile( file );
+static int EofStbCallback( void *user ) {
+	return PlIsEndOfFile( user );
+}
+
+static PLImage *LoadStbImage( PLFile *file ) {
+	int x, y, component;
+	unsigned char *data;
+	if ( file->data != NULL ) {
+		/* cached or memory backed, so decode straight from the buffer */
+		data = stbi_load_from_memory( file->data, ( int ) file->size, &x, &y, &component, 4 );
+	} else {
+		static const stbi_io_callbacks callbacks = {
+		        ReadStbCallback,
+		        SkipStbCallback,
+		        EofStbCallback,
+		};
+		data = stbi_load_from_callbacks( &callbacks, file, &x, &y, &component, 4 );
+	}
 
 	if ( data == NULL ) {
 		PlReportErrorF( PL_RESULT_FILEREAD, "failed to read in image (%s)", stbi_failure_reason() );
@@ -54,9 +70,12 @@ static PLImage *LoadStbImage( const char *path ) {
 
 #define MAX_IMAGE_LOADERS 4096
 
+/* loaders either open the path themselves (plugins), or
+ * parse a file handle that's already been opened for them */
 typedef struct PLImageLoader {
 	const char *extension;
 	PLImage *( *LoadImage )( const char *path );
+	PLImage *( *LoadImageFile )( PLFile *file );
 } PLImageLoader;
 
 static PLImageLoader imageLoaders[ MAX_IMAGE_LOADERS ];
@@ -70,6 +89,20 @@ void PlRegisterImageLoader( const char *extension, PLImage *( *LoadImage )( cons
 
 	imageLoaders[ numImageLoaders ].extension = extension;
 	imageLoaders[ numImageLoaders ].LoadImage = LoadImage;
+	imageLoaders[ numImageLoaders ].LoadImageFile = NULL;
+
+	numImageLoaders++;
+}
+
+void PlRegisterImageFileLoader( const char *extension, PLImage *( *LoadImageFile )( PLFile *file ) ) {
+	if ( numImageLoaders >= MAX_IMAGE_LOADERS ) {
+		PlReportBasicError( PL_RESULT_MEMORY_EOA );
+		return;
+	}
+
+	imageLoaders[ numImageLoaders ].extension = extension;
+	imageLoaders[ numImageLoaders ].LoadImage = NULL;
+	imageLoaders[ numImageLoaders ].LoadImageFile = LoadImageFile;
 
 	numImageLoaders++;
 }
@@ -78,7 +111,7 @@ void PlRegisterStandardImageLoaders( unsigned int flags ) {
 	typedef struct SImageLoader {
 		unsigned int flag;
 		const char *extension;
-		PLImage *( *LoadFunction )( const char *path );
+		PLImage *( *LoadFunction )( PLFile *file );
 	} SImageLoader;
 
 	static const SImageLoader loaderList[] = {
@@ -91,10 +124,10 @@ void PlRegisterStandardImageLoaders( unsigned int flags ) {
 	        { PL_IMAGE_FILEFORMAT_HDR, "hdr", LoadStbImage },
 	        { PL_IMAGE_FILEFORMAT_PIC, "pic", LoadStbImage },
 	        { PL_IMAGE_FILEFORMAT_PNM, "pnm", LoadStbImage },
-	        { PL_IMAGE_FILEFORMAT_FTX, "ftx", PlLoadFtxImage },
-	        { PL_IMAGE_FILEFORMAT_3DF, "3df", PlLoad3dfImage },
-	        { PL_IMAGE_FILEFORMAT_TIM, "tim", PlLoadTimImage },
-	        { PL_IMAGE_FILEFORMAT_SWL, "swl", PlLoadSwlImage },
+	        { PL_IMAGE_FILEFORMAT_FTX, "ftx", PlParseFtxImage },
+	        { PL_IMAGE_FILEFORMAT_3DF, "3df", PlParse3dfImage },
+	        { PL_IMAGE_FILEFORMAT_TIM, "tim", PlParseTimImage },
+	        { PL_IMAGE_FILEFORMAT_SWL, "swl", PlParseSwlImage },
 	};
 
 	for ( unsigned int i = 0; i < plArrayElements( loaderList ); ++i ) {
@@ -102,7 +135,7 @@ void PlRegisterStandardImageLoaders( unsigned int flags ) {
 			continue;
 		}
 
-		PlRegisterImageLoader( loaderList[ i ].extension, loaderList[ i ].LoadFunction );
+		PlRegisterImageFileLoader( loaderList[ i ].extension, loaderList[ i ].LoadFunction );
 	}
 }
 
@@ -111,7 +144,7 @@ void PlClearImageLoaders( void ) {
 }
 
 PLImage *PlCreateImage( uint8_t *buf, unsigned int w, unsigned int h, PLColourFormat col, PLImageFormat dat ) {
-	PLImage *image = pl_malloc( sizeof( PLImage ) );
+	PLImage *image = pl_calloc( 1, sizeof( PLImage ) );
 	if ( image == NULL ) {
 		return NULL;
 	}
@@ -151,37 +184,160 @@ void PlDestroyImage( PLImage *image ) {
 	free( image );
 }
 
-PLImage *PlLoadImage( const char *path ) {
-	if ( !PlFileExists( path ) ) {
-		PlReportBasicError( PL_RESULT_FILEPATH );
-		return NULL;
+/**
+ * Tries each of the file loaders registered for the given extension
+ * against the handle, rewinding between attempts. If extension is
+ * NULL, every file loader is tried.
+ */
+static PLImage *LoadImageFromFile( PLFile *file, const char *extension ) {
+	for ( unsigned int i = 0; i < numImageLoaders; ++i ) {
+		if ( imageLoaders[ i ].LoadImageFile == NULL ) {
+			continue;
+		}
+
+		if ( extension != NULL && pl_strcasecmp( extension, imageLoaders[ i ].extension ) != 0 ) {
+			continue;
+		}
+
+		PlRewindFile( file );
+
+		PLImage *image = imageLoaders[ i ].LoadImageFile( file );
+		if ( image != NULL ) {
+			return image;
+		}
 	}
 
+	return NULL;
+}
+
+PLImage *PlLoadImage( const char *path ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	const char *extension = PlGetFileExtension( path );
+
+	bool hasFileLoader = false, hasPathLoader = false;
 	for ( unsigned int i = 0; i < numImageLoaders; ++i ) {
-		if ( pl_strcasecmp( extension, imageLoaders[ i ].extension ) == 0 ) {
-			PLImage *image = imageLoaders[ i ].LoadImage( path );
-			if ( image != NULL ) {
-				strncpy( image->path, path, sizeof( image->path ) );
-				return image;
-			}
+		if ( pl_strcasecmp( extension, imageLoaders[ i ].extension ) != 0 ) {
+			continue;
+		}
+
+		if ( imageLoaders[ i ].LoadImageFile != NULL ) {
+			hasFileLoader = true;
+		} else {
+			hasPathLoader = true;
 		}
 	}
 
-	PlReportBasicError( PL_RESULT_UNSUPPORTED );
+	if ( !hasFileLoader && !hasPathLoader ) {
+		PlReportBasicError( PL_RESULT_UNSUPPORTED );
+		PL_PROFILE_END();
+		return NULL;
+	}
 
-	return NULL;
+	/* resolve and read the file in just the once, then let each loader parse it */
+	PLImage *image = NULL;
+	if ( hasFileLoader ) {
+		PLFile *file = PlOpenFile( path, true );
+		if ( file == NULL ) {
+			PlReportBasicError( PL_RESULT_FILEPATH );
+			PL_PROFILE_END();
+			return NULL;
+		}
+
+		image = LoadImageFromFile( file, extension );
+
+		PlCloseFile( file );
+	}
+
+	/* fall back to any loaders that want to open the path themselves */
+	for ( unsigned int i = 0; image == NULL && hasPathLoader && i < numImageLoaders; ++i ) {
+		if ( imageLoaders[ i ].LoadImage == NULL || pl_strcasecmp( extension, imageLoaders[ i ].extension ) != 0 ) {
+			continue;
+		}
+
+		image = imageLoaders[ i ].LoadImage( path );
+	}
+
+	if ( image == NULL ) {
+		PlReportBasicError( PL_RESULT_UNSUPPORTED );
+		PL_PROFILE_END();
+		return NULL;
+	}
+
+	snprintf( image->path, sizeof( image->path ), "%s", path );
+
+	PL_PROFILE_END();
+	return image;
+}
+
+/**
+ * Decodes an image from a file handle that's already open, such as
+ * one returned from a package. The handle is left open.
+ * @param file Handle to read the image from, starting at the beginning.
+ * @param extension Used to pick the loader; if NULL it's taken from the
+ * file's path and, failing that, every loader is tried.
+ * @return Returns the decoded image, or NULL on failure.
+ */
+PLImage *PlLoadImageFromFile( PLFile *file, const char *extension ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	if ( file == NULL ) {
+		PlReportBasicError( PL_RESULT_INVALID_PARM1 );
+		PL_PROFILE_END();
+		return NULL;
+	}
+
+	if ( extension == NULL ) {
+		extension = PlGetFileExtension( file->path );
+	}
+
+	if ( plIsEmptyString( extension ) ) {
+		extension = NULL;
+	}
+
+	PLImage *image = LoadImageFromFile( file, extension );
+	if ( image == NULL ) {
+		PlReportBasicError( PL_RESULT_UNSUPPORTED );
+		PL_PROFILE_END();
+		return NULL;
+	}
+
+	snprintf( image->path, sizeof( image->path ), "%s", file->path );
+
+	PL_PROFILE_END();
+	return image;
+}
+
+/**
+ * Decodes an image held in memory, e.g. one embedded in a model.
+ * The buffer isn't copied and only needs to live for the call.
+ */
+PLImage *PlLoadImageFromMemory( const void *buf, size_t bufSize, const char *extension ) {
+	PLFile *file = PlCreateFileFromMemory( NULL, ( void * ) buf, bufSize, PL_FILE_MEMORYBUFFERTYPE_UNMANAGED );
+	if ( file == NULL ) {
+		return NULL;
+	}
+
+	PLImage *image = PlLoadImageFromFile( file, extension );
+
+	PlCloseFile( file );
+
+	return image;
 }
 
 bool PlWriteImage( const PLImage *image, const char *path ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	if ( plIsEmptyString( path ) ) {
 		PlReportErrorF( PL_RESULT_FILEPATH, PlGetResultString( PL_RESULT_FILEPATH ) );
+		PL_PROFILE_END();
 		return false;
 	}
 
 	int comp = ( int ) PlGetNumberOfColourChannels( image->colour_format );
 	if ( comp == 0 ) {
 		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "invalid colour format" );
+		PL_PROFILE_END();
 		return false;
 	}
 
@@ -189,24 +345,29 @@ bool PlWriteImage( const PLImage *image, const char *path ) {
 	if ( !plIsEmptyString( extension ) ) {
 		if ( !pl_strncasecmp( extension, "bmp", 3 ) ) {
 			if ( stbi_write_bmp( path, ( int ) image->width, ( int ) image->height, comp, image->data[ 0 ] ) == 1 ) {
+				PL_PROFILE_END();
 				return true;
 			}
 		} else if ( !pl_strncasecmp( extension, "png", 3 ) ) {
 			if ( stbi_write_png( path, ( int ) image->width, ( int ) image->height, comp, image->data[ 0 ], 0 ) == 1 ) {
+				PL_PROFILE_END();
 				return true;
 			}
 		} else if ( !pl_strncasecmp( extension, "tga", 3 ) ) {
 			if ( stbi_write_tga( path, ( int ) image->width, ( int ) image->height, comp, image->data[ 0 ] ) == 1 ) {
+				PL_PROFILE_END();
 				return true;
 			}
 		} else if ( !pl_strncasecmp( extension, "jpg", 3 ) || !pl_strncasecmp( extension, "jpeg", 3 ) ) {
 			if ( stbi_write_jpg( path, ( int ) image->width, ( int ) image->height, comp, image->data[ 0 ], 90 ) == 1 ) {
+				PL_PROFILE_END();
 				return true;
 			}
 		}
 	}
 
 	PlReportErrorF( PL_RESULT_FILETYPE, PlGetResultString( PL_RESULT_FILETYPE ) );
+	PL_PROFILE_END();
 	return false;
 }
 
@@ -229,140 +390,326 @@ unsigned int PlGetNumberOfColourChannels( PLColourFormat format ) {
 	return 0;
 }
 
-static bool RGB8toRGBA8( PLImage *image ) {
-	size_t size = PlGetImageSize( PL_IMAGEFORMAT_RGBA8, image->width, image->height );
-	if ( size == 0 ) {
+static void FreeImageLevels( uint8_t **levels, unsigned int numLevels ) {
+	for ( unsigned int l = 0; l < numLevels; ++l ) {
+		pl_free( levels[ l ] );
+	}
+
+	pl_free( levels );
+}
+
+/* frees the image's current levels, minding whether they share the one allocation */
+static void FreeImageData( PLImage *image ) {
+	if ( image->flags & PL_IMAGE_FLAG_CONTIGUOUS_LEVELS ) {
+		FreeImageLevels( image->data, 1 );
+		image->flags &= ~PL_IMAGE_FLAG_CONTIGUOUS_LEVELS;
+		return;
+	}
+
+	FreeImageLevels( image->data, image->levels );
+}
+
+bool PlConvertPixelFormat( PLImage *image, PLImageFormat new_format ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	if ( image->format == new_format ) {
+		PL_PROFILE_END();
+		return true;
+	}
+
+	if ( _plIsBlockCompressedFormat( new_format ) ) {
+		bool status = PlCompressImage( image, new_format, PL_IMAGE_COMPRESSION_FAST );
+		PL_PROFILE_END();
+		return status;
+	}
+
+	bool isCompressed = _plIsBlockCompressedFormat( image->format );
+	if ( ( !isCompressed && !_plIsPixelFormatConvertible( image->format ) ) || !_plIsPixelFormatConvertible( new_format ) ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format conversion" );
+		PL_PROFILE_END();
 		return false;
 	}
 
-	typedef struct RGB8 {
-		uint8_t r, g, b;
-	} RGB8;
-	typedef struct RGBA8 {
-		uint8_t r, g, b, a;
-	} RGBA8;
-	size_t num_pixels = image->size / 3;
+	/* Compressed images are decoded first and then handled like any RGBA8 image. */
 
-	RGB8 *src = ( RGB8 * ) image->data[ 0 ];
-	RGBA8 *dst = pl_malloc( size );
-	for ( size_t i = 0; i < num_pixels; ++i ) {
-		dst->r = src->r;
-		dst->g = src->g;
-		dst->b = src->b;
-		dst->a = 255;
-		dst++;
-		src++;
+	uint8_t **source = image->data;
+	PLImageFormat sourceFormat = image->format;
+	if ( isCompressed ) {
+		if ( ( source = _plDecodeBlockCompressedLevels( image ) ) == NULL ) {
+			PL_PROFILE_END();
+			return false;
+		}
+		sourceFormat = PL_IMAGEFORMAT_RGBA8;
 	}
 
-	pl_free( image->data[ 0 ] );
+	uint8_t **levels = source;
+	if ( sourceFormat != new_format ) {
+		if ( ( levels = pl_calloc( image->levels, sizeof( uint8_t * ) ) ) == NULL ) {
+			if ( isCompressed ) {
+				FreeImageLevels( source, image->levels );
+			}
+			PL_PROFILE_END();
+			return false;
+		}
 
-	image->data[ 0 ] = ( uint8_t * ) ( &dst[ 0 ] );
-	image->size = size;
-	image->format = PL_IMAGEFORMAT_RGBA8;
-	image->colour_format = PL_COLOURFORMAT_RGBA;
+		/* Make a new copy of each detail level in the new format. */
+
+		unsigned int lw = image->width;
+		unsigned int lh = image->height;
+		for ( unsigned int l = 0; l < image->levels; ++l ) {
+			if ( ( levels[ l ] = pl_malloc( PlGetImageSize( new_format, lw, lh ) ) ) == NULL ) {
+				/* Memory allocation failed, ditch any buffers we've created so far. */
+				FreeImageLevels( levels, l );
+				if ( isCompressed ) {
+					FreeImageLevels( source, image->levels );
+				}
+				PL_PROFILE_END();
+				return false;
+			}
+
+			PlConvertPixels( source[ l ], sourceFormat, levels[ l ], new_format, ( size_t ) lw * lh );
+
+			lw = ( lw > 1 ) ? lw / 2 : 1;
+			lh = ( lh > 1 ) ? lh / 2 : 1;
+		}
 
+		if ( isCompressed ) {
+			FreeImageLevels( source, image->levels );
+		}
+	}
+
+	/* Now that all levels have been converted, free and replace the old buffers. */
+
+	FreeImageData( image );
+	image->data = levels;
+
+	image->size = PlGetImageSize( new_format, image->width, image->height );
+	image->format = new_format;
+
+	bool isBGR = ( image->colour_format == PL_COLOURFORMAT_BGR || image->colour_format == PL_COLOURFORMAT_BGRA || image->colour_format == PL_COLOURFORMAT_ABGR );
+	if ( _plPixelFormatHasAlpha( new_format ) ) {
+		image->colour_format = isBGR ? PL_COLOURFORMAT_BGRA : PL_COLOURFORMAT_RGBA;
+	} else {
+		image->colour_format = isBGR ? PL_COLOURFORMAT_BGR : PL_COLOURFORMAT_RGB;
+	}
+
+	PL_PROFILE_END();
 	return true;
 }
 
-#define scale_5to8( i ) ( ( ( ( double ) ( i ) ) / 31 ) * 255 )
+/**
+ * Compresses every level of the image into the given block compressed format.
+ * Anything that isn't already RGBA8 gets converted to it first.
+ */
+bool PlCompressImage( PLImage *image, PLImageFormat format, PLImageCompressionQuality quality ) {
+	PL_PROFILE_FUNCTION_BEGIN();
 
-static uint8_t *ImageDataRGB5A1toRGBA8( const uint8_t *src, size_t n_pixels ) {
-	uint8_t *dst = pl_malloc( n_pixels * 4 );
-	if ( dst == NULL ) {
-		return NULL;
+	if ( image->format == format ) {
+		PL_PROFILE_END();
+		return true;
 	}
 
-	uint8_t *dp = dst;
+	if ( !_plIsBlockCompressedFormat( format ) ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image compression format" );
+		PL_PROFILE_END();
+		return false;
+	}
 
-	for ( size_t i = 0; i < n_pixels; ++i ) {
-		/* Red */
-		*( dp++ ) = scale_5to8( ( src[ 0 ] & 0xF8 ) >> 3 );
+	if ( !PlConvertPixelFormat( image, PL_IMAGEFORMAT_RGBA8 ) ) {
+		PL_PROFILE_END();
+		return false;
+	}
 
-		/* Green */
-		*( dp++ ) = scale_5to8( ( ( src[ 0 ] & 0x07 ) << 2 ) | ( ( src[ 1 ] & 0xC0 ) >> 6 ) );
+	uint8_t **levels = _plEncodeBlockCompressedLevels( image, format, quality );
+	if ( levels == NULL ) {
+		PL_PROFILE_END();
+		return false;
+	}
 
-		/* Blue */
-		*( dp++ ) = scale_5to8( ( src[ 1 ] & 0x3E ) >> 1 );
+	FreeImageData( image );
+	image->data = levels;
 
-		/* Alpha */
-		*( dp++ ) = ( src[ 1 ] & 0x01 ) ? 255 : 0;
+	image->size = PlGetImageSize( format, image->width, image->height );
+	image->format = format;
 
-		src += 2;
+	if ( format == PL_IMAGEFORMAT_RGB_DXT1 || format == PL_IMAGEFORMAT_R_BC4 || format == PL_IMAGEFORMAT_RG_BC5 ) {
+		image->colour_format = ( image->colour_format == PL_COLOURFORMAT_BGRA ) ? PL_COLOURFORMAT_BGR : PL_COLOURFORMAT_RGB;
 	}
 
-	return dst;
+	PL_PROFILE_END();
+	return true;
 }
 
-bool PlConvertPixelFormat( PLImage *image, PLImageFormat new_format ) {
-	if ( image->format == new_format ) {
-		return true;
+/* points each level into the chain, which then owns them all */
+static void SetContiguousLevels( PLImage *image, uint8_t **levels, uint8_t *chain, unsigned int numLevels ) {
+	unsigned int lw = image->width;
+	unsigned int lh = image->height;
+	for ( unsigned int l = 0; l < numLevels; ++l ) {
+		levels[ l ] = chain;
+		chain += PlGetImageSize( image->format, lw, lh );
+
+		lw = ( lw > 1 ) ? lw / 2 : 1;
+		lh = ( lh > 1 ) ? lh / 2 : 1;
 	}
 
-	switch ( image->format ) {
-		case PL_IMAGEFORMAT_RGB8: {
-			if ( new_format == PL_IMAGEFORMAT_RGBA8 ) { return RGB8toRGBA8( image ); }
-		}
+	image->data = levels;
+	image->levels = numLevels;
+	image->flags |= PL_IMAGE_FLAG_CONTIGUOUS_LEVELS;
+}
+
+/**
+ * Replaces any existing levels with a full chain filtered down from the top level,
+ * all within a single allocation. Compressed images will need decoding first.
+ */
+bool PlGenerateImageMipmaps( PLImage *image, PLImageMipmapFilter filter, unsigned int flags ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	if ( !_plIsPixelFormatConvertible( image->format ) ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "cannot generate mipmaps for this format" );
+		PL_PROFILE_END();
+		return false;
+	}
 
-		case PL_IMAGEFORMAT_RGB5A1: {
-			if ( new_format == PL_IMAGEFORMAT_RGBA8 ) {
-				uint8_t **levels = pl_calloc( image->levels, sizeof( uint8_t * ) );
+	unsigned int numLevels = 1;
+	for ( unsigned int size = ( image->width > image->height ) ? image->width : image->height; size > 1; size /= 2 ) {
+		numLevels++;
+	}
 
-				/* Make a new copy of each detail level in the new format. */
+	uint8_t **levels = pl_calloc( numLevels, sizeof( uint8_t * ) );
+	if ( levels == NULL ) {
+		PL_PROFILE_END();
+		return false;
+	}
 
-				unsigned int lw = image->width;
-				unsigned int lh = image->height;
+	uint8_t *chain = _plGenerateMipmapChain( image, numLevels, filter, flags );
+	if ( chain == NULL ) {
+		pl_free( levels );
+		PL_PROFILE_END();
+		return false;
+	}
 
-				for ( unsigned int l = 0; l < image->levels; ++l ) {
-					levels[ l ] = ImageDataRGB5A1toRGBA8( image->data[ l ], lw * lh );
-					if ( levels[ l ] == NULL ) {
-						/* Memory allocation failed, ditch any buffers we've created so far. */
-						for ( unsigned int m = 0; m < l; ++m ) {
-							pl_free( levels[ m ] );
-						}
+	FreeImageData( image );
+	SetContiguousLevels( image, levels, chain, numLevels );
 
-						pl_free( levels );
+	PL_PROFILE_END();
+	return true;
+}
 
-						PlReportErrorF( PL_RESULT_MEMORY_ALLOCATION, "couldn't allocate memory for image data" );
-						return false;
-					}
+/**
+ * Resamples the image to the given size. Only the top level is kept,
+ * so any mipmaps will need generating again afterwards.
+ */
+bool PlResizeImage( PLImage *image, unsigned int width, unsigned int height, PLImageResizeFilter filter ) {
+	PL_PROFILE_FUNCTION_BEGIN();
 
-					lw /= 2;
-					lh /= 2;
-				}
+	if ( width == 0 || height == 0 ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid image size (%ux%u)", width, height );
+		PL_PROFILE_END();
+		return false;
+	}
 
-				/* Now that all levels have been converted, free and replace the old buffers. */
+	if ( !_plIsPixelFormatConvertible( image->format ) ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "cannot resize images in this format" );
+		PL_PROFILE_END();
+		return false;
+	}
 
-				for ( unsigned int l = 0; l < image->levels; ++l ) {
-					pl_free( image->data[ l ] );
-				}
+	uint8_t **levels = pl_calloc( 1, sizeof( uint8_t * ) );
+	if ( levels == NULL ) {
+		PL_PROFILE_END();
+		return false;
+	}
 
-				pl_free( image->data );
-				image->data = levels;
+	if ( ( levels[ 0 ] = _plResampleImage( image, width, height, filter ) ) == NULL ) {
+		pl_free( levels );
+		PL_PROFILE_END();
+		return false;
+	}
 
-				image->format = new_format;
-				/* TODO: Update colour_format */
+	FreeImageData( image );
+	image->data = levels;
+	image->levels = 1;
+	image->width = width;
+	image->height = height;
+	image->size = PlGetImageSize( image->format, width, height );
 
-				return true;
-			}
-		} break;
+	PL_PROFILE_END();
+	return true;
+}
 
-		default:
-			break;
+/**
+ * Rotates every level of the image, swapping its width and height for
+ * quarter turns. Those end up within a single allocation, as with mipmaps.
+ */
+bool PlRotateImage( PLImage *image, PLImageRotation rotation ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	if ( rotation == PL_IMAGE_ROTATE_180 ) {
+		bool status = _plReverseImagePixels( image );
+		PL_PROFILE_END();
+		return status;
 	}
 
-	PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format conversion" );
-	return false;
+	if ( rotation != PL_IMAGE_ROTATE_90 && rotation != PL_IMAGE_ROTATE_270 ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid rotation (%d)", rotation );
+		PL_PROFILE_END();
+		return false;
+	}
+
+	uint8_t **levels = pl_calloc( image->levels, sizeof( uint8_t * ) );
+	if ( levels == NULL ) {
+		PL_PROFILE_END();
+		return false;
+	}
+
+	uint8_t *chain = _plRotateImageLevels( image, rotation == PL_IMAGE_ROTATE_90 );
+	if ( chain == NULL ) {
+		pl_free( levels );
+		PL_PROFILE_END();
+		return false;
+	}
+
+	unsigned int width = image->width;
+	image->width = image->height;
+	image->height = width;
+
+	FreeImageData( image );
+	SetContiguousLevels( image, levels, chain, image->levels );
+
+	PL_PROFILE_END();
+	return true;
+}
+
+static unsigned int GetNextPowerOfTwo( unsigned int num ) {
+	unsigned int p = 1;
+	while ( p < num ) {
+		p <<= 1;
+	}
+
+	return p;
+}
+
+/**
+ * Enlarges the image to the nearest power of two in each dimension,
+ * for hardware (or formats) which can't handle anything else.
+ */
+bool PlResizeImageToPowerOfTwo( PLImage *image, PLImageResizeFilter filter ) {
+	if ( PlImageIsPowerOfTwo( image ) ) {
+		return true;
+	}
+
+	return PlResizeImage( image, GetNextPowerOfTwo( image->width ), GetNextPowerOfTwo( image->height ), filter );
 }
 
 unsigned int PlGetImageSize( PLImageFormat format, unsigned int width, unsigned int height ) {
-	switch ( format ) {
-		case PL_IMAGEFORMAT_RGB_DXT1:
-			return ( width * height ) >> 1;
-		default: {
-			unsigned int bytes = PlImageBytesPerPixel( format );
-			return width * height * bytes;
-		}
+	/* compressed formats are stored in 4x4 blocks, so round up to those */
+	unsigned int blockSize = _plGetBlockSize( format );
+	if ( blockSize != 0 ) {
+		return ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * blockSize;
 	}
+
+	unsigned int bytes = PlImageBytesPerPixel( format );
+	return width * height * bytes;
 }
 
 /* Returns the number of BYTES per pixel for the given PLImageFormat.
@@ -371,13 +718,14 @@ unsigned int PlGetImageSize( PLImageFormat format, unsigned int width, unsigned
  * of one byte, returns ZERO. */
 unsigned int PlImageBytesPerPixel( PLImageFormat format ) {
 	switch ( format ) {
+		case PL_IMAGEFORMAT_RGB4:
 		case PL_IMAGEFORMAT_RGBA4:
+		case PL_IMAGEFORMAT_RGB5:
 		case PL_IMAGEFORMAT_RGB5A1:
 		case PL_IMAGEFORMAT_RGB565:
 			return 2;
 		case PL_IMAGEFORMAT_RGB8:
 			return 3;
-		case PL_IMAGEFORMAT_RGBA_DXT1:
 		case PL_IMAGEFORMAT_RGBA8:
 			return 4;
 		case PL_IMAGEFORMAT_RGBA12:
@@ -390,26 +738,6 @@ unsigned int PlImageBytesPerPixel( PLImageFormat format ) {
 	}
 }
 
-void PlInvertImageColour( PLImage *image ) {
-	unsigned int num_colours = PlGetNumberOfColourChannels( image->colour_format );
-	switch ( image->format ) {
-		case PL_IMAGEFORMAT_RGB8:
-		case PL_IMAGEFORMAT_RGBA8: {
-			for ( size_t i = 0; i < image->size; i += num_colours ) {
-				uint8_t *pixel = &image->data[ 0 ][ i ];
-				pixel[ 0 ] = ~pixel[ 0 ];
-				pixel[ 1 ] = ~pixel[ 1 ];
-				pixel[ 2 ] = ~pixel[ 2 ];
-			}
-		} break;
-
-		default:
-			break;
-	}
-
-	PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format" );
-}
-
 /* utility function */
 void PlGenerateStipplePattern( PLImage *image, unsigned int depth ) {
 #if 0
@@ -435,37 +763,6 @@ void PlGenerateStipplePattern( PLImage *image, unsigned int depth ) {
 #endif
 }
 
-void PlReplaceImageColour( PLImage *image, PLColour target, PLColour dest ) {
-	unsigned int num_colours = PlGetNumberOfColourChannels( image->colour_format );
-	switch ( image->format ) {
-		case PL_IMAGEFORMAT_RGB8:
-		case PL_IMAGEFORMAT_RGBA8: {
-			for ( unsigned int i = 0; i < image->size; i += num_colours ) {
-				uint8_t *pixel = &image->data[ 0 ][ i ];
-				if ( num_colours == 4 ) {
-					if ( PlCompareColour( PLColour( pixel[ 0 ], pixel[ 1 ], pixel[ 2 ], pixel[ 3 ] ), target ) ) {
-						pixel[ 0 ] = dest.r;
-						pixel[ 1 ] = dest.g;
-						pixel[ 2 ] = dest.b;
-						pixel[ 3 ] = dest.a;
-					}
-				} else {
-					if ( PlCompareColour( PLColourRGB( pixel[ 0 ], pixel[ 1 ], pixel[ 2 ] ), target ) ) {
-						pixel[ 0 ] = dest.r;
-						pixel[ 1 ] = dest.g;
-						pixel[ 2 ] = dest.b;
-					}
-				}
-			}
-		} break;
-
-		default:
-			break;
-	}
-
-	PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format" );
-}
-
 void PlFreeImage( PLImage *image ) {
 	FunctionStart();
 
@@ -473,11 +770,7 @@ void PlFreeImage( PLImage *image ) {
 		return;
 	}
 
-	for ( unsigned int levels = 0; levels < image->levels; ++levels ) {
-		pl_free( image->data[ levels ] );
-	}
-
-	pl_free( image->data );
+	FreeImageData( image );
 }
 
 bool PlImageIsPowerOfTwo( const PLImage *image ) {
@@ -488,42 +781,6 @@ bool PlImageIsPowerOfTwo( const PLImage *image ) {
 	return true;
 }
 
-bool PlFlipImageVertical( PLImage *image ) {
-	unsigned int width = image->width;
-	unsigned int height = image->height;
-
-	unsigned int bytes_per_pixel = PlImageBytesPerPixel( image->format );
-	if ( bytes_per_pixel == 0 ) {
-		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "cannot flip images in this format" );
-		return false;
-	}
-
-	unsigned int bytes_per_row = width * bytes_per_pixel;
-
-	unsigned char *swap = pl_malloc( bytes_per_row );
-	if ( swap == NULL ) {
-		return false;
-	}
-
-	for ( unsigned int l = 0; l < image->levels; ++l ) {
-		for ( unsigned int r = 0; r < height / 2; ++r ) {
-			unsigned char *tr = image->data[ l ] + ( r * bytes_per_row );
-			unsigned char *br = image->data[ l ] + ( ( ( height - 1 ) - r ) * bytes_per_row );
-
-			memcpy( swap, tr, bytes_per_row );
-			memcpy( tr, br, bytes_per_row );
-			memcpy( br, swap, bytes_per_row );
-		}
-
-		bytes_per_row /= 2;
-		height /= 2;
-	}
-
-	pl_free( swap );
-
-	return true;
-}
-
 /**
  * Returns a list of file extensions representing all
  * the formats supported by the image loader.
@@ -0,0 +1,347 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include <limits.h>
+
+#include "image_private.h"
+
+/* Texture atlas packing, using MaxRects with the best short side fit
+ * heuristic. Images are placed largest first into the smallest power of
+ * two atlas they'll fit in, growing it until they do.
+ *
+ * Each image gets a cell which is padded out on every side, with the
+ * padding filled by extruding the image's edges so filtering doesn't pull
+ * in its neighbours. Cells are also aligned, so for n mip levels aligning
+ * to 2^n (with at least that much padding) keeps every image in its own
+ * set of texels all the way down the chain. */
+
+typedef struct AtlasRect {
+	unsigned int x, y, w, h;
+} AtlasRect;
+
+typedef struct AtlasPacker {
+	unsigned int width, height;
+	AtlasRect *freeRects;
+	unsigned int numFreeRects, maxFreeRects;
+} AtlasPacker;
+
+typedef struct AtlasCell {
+	unsigned int index;
+	unsigned int w, h;
+} AtlasCell;
+
+static unsigned int AlignUp( unsigned int value, unsigned int alignment ) {
+	return ( value + alignment - 1 ) / alignment * alignment;
+}
+
+static bool AddFreeRect( AtlasPacker *packer, unsigned int x, unsigned int y, unsigned int w, unsigned int h ) {
+	if ( packer->numFreeRects == packer->maxFreeRects ) {
+		unsigned int maxFreeRects = packer->maxFreeRects * 2;
+		AtlasRect *freeRects = pl_realloc( packer->freeRects, maxFreeRects * sizeof( AtlasRect ) );
+		if ( freeRects == NULL ) {
+			return false;
+		}
+
+		packer->freeRects = freeRects;
+		packer->maxFreeRects = maxFreeRects;
+	}
+
+	packer->freeRects[ packer->numFreeRects++ ] = ( AtlasRect ){ x, y, w, h };
+	return true;
+}
+
+static bool IsRectContained( const AtlasRect *a, const AtlasRect *b ) {
+	return a->x >= b->x && a->y >= b->y && a->x + a->w <= b->x + b->w && a->y + a->h <= b->y + b->h;
+}
+
+static bool FindPosition( const AtlasPacker *packer, unsigned int w, unsigned int h, AtlasRect *out ) {
+	unsigned int bestShortSide = UINT_MAX, bestLongSide = UINT_MAX;
+	for ( unsigned int i = 0; i < packer->numFreeRects; ++i ) {
+		const AtlasRect *rect = &packer->freeRects[ i ];
+		if ( rect->w < w || rect->h < h ) {
+			continue;
+		}
+
+		unsigned int leftoverW = rect->w - w, leftoverH = rect->h - h;
+		unsigned int shortSide = leftoverW < leftoverH ? leftoverW : leftoverH;
+		unsigned int longSide = leftoverW < leftoverH ? leftoverH : leftoverW;
+		if ( shortSide < bestShortSide || ( shortSide == bestShortSide && longSide < bestLongSide ) ) {
+			*out = ( AtlasRect ){ rect->x, rect->y, w, h };
+			bestShortSide = shortSide;
+			bestLongSide = longSide;
+		}
+	}
+
+	return ( bestShortSide != UINT_MAX );
+}
+
+/**
+ * Carves the placed rect out of every free rect it overlaps, then drops
+ * any free rects that end up inside another. Only the new rects can be
+ * redundant or make an old one redundant, so that's all we compare.
+ */
+static bool PlaceRect( AtlasPacker *packer, const AtlasRect *placed ) {
+	unsigned int numOld = packer->numFreeRects;
+	for ( unsigned int i = 0; i < numOld; ) {
+		AtlasRect rect = packer->freeRects[ i ];
+		if ( placed->x >= rect.x + rect.w || placed->x + placed->w <= rect.x ||
+		     placed->y >= rect.y + rect.h || placed->y + placed->h <= rect.y ) {
+			++i;
+			continue;
+		}
+
+		bool status = true;
+		if ( placed->x > rect.x ) {
+			status &= AddFreeRect( packer, rect.x, rect.y, placed->x - rect.x, rect.h );
+		}
+		if ( placed->x + placed->w < rect.x + rect.w ) {
+			status &= AddFreeRect( packer, placed->x + placed->w, rect.y, rect.x + rect.w - ( placed->x + placed->w ), rect.h );
+		}
+		if ( placed->y > rect.y ) {
+			status &= AddFreeRect( packer, rect.x, rect.y, rect.w, placed->y - rect.y );
+		}
+		if ( placed->y + placed->h < rect.y + rect.h ) {
+			status &= AddFreeRect( packer, rect.x, placed->y + placed->h, rect.w, rect.y + rect.h - ( placed->y + placed->h ) );
+		}
+		if ( !status ) {
+			return false;
+		}
+
+		/* swap the last old rect in, and the last new rect in behind it */
+		packer->freeRects[ i ] = packer->freeRects[ --numOld ];
+		packer->freeRects[ numOld ] = packer->freeRects[ --packer->numFreeRects ];
+	}
+
+	for ( unsigned int i = numOld; i < packer->numFreeRects; ) {
+		bool redundant = false;
+		for ( unsigned int j = 0; j < packer->numFreeRects && !redundant; ++j ) {
+			redundant = ( j != i ) && IsRectContained( &packer->freeRects[ i ], &packer->freeRects[ j ] );
+		}
+
+		if ( redundant ) {
+			packer->freeRects[ i ] = packer->freeRects[ --packer->numFreeRects ];
+		} else {
+			++i;
+		}
+	}
+
+	for ( unsigned int i = 0; i < numOld; ) {
+		bool redundant = false;
+		for ( unsigned int j = numOld; j < packer->numFreeRects && !redundant; ++j ) {
+			redundant = IsRectContained( &packer->freeRects[ i ], &packer->freeRects[ j ] );
+		}
+
+		if ( redundant ) {
+			/* keep old rects ahead of the new ones */
+			packer->freeRects[ i ] = packer->freeRects[ --numOld ];
+			packer->freeRects[ numOld ] = packer->freeRects[ --packer->numFreeRects ];
+		} else {
+			++i;
+		}
+	}
+
+	return true;
+}
+
+static int CompareAtlasCells( const void *a, const void *b ) {
+	const AtlasCell *x = a, *y = b;
+	unsigned int xMax = x->w > x->h ? x->w : x->h;
+	unsigned int yMax = y->w > y->h ? y->w : y->h;
+	if ( xMax != yMax ) {
+		return ( xMax < yMax ) - ( xMax > yMax );
+	}
+
+	unsigned int xArea = x->w * x->h, yArea = y->w * y->h;
+	if ( xArea != yArea ) {
+		return ( xArea < yArea ) - ( xArea > yArea );
+	}
+
+	/* keeps the result stable, whatever qsort does */
+	return ( x->index > y->index ) - ( x->index < y->index );
+}
+
+static bool PackCells( AtlasPacker *packer, const AtlasCell *cells, unsigned int numCells, AtlasRect *positions ) {
+	packer->numFreeRects = 0;
+	if ( !AddFreeRect( packer, 0, 0, packer->width, packer->height ) ) {
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < numCells; ++i ) {
+		AtlasRect *position = &positions[ cells[ i ].index ];
+		if ( !FindPosition( packer, cells[ i ].w, cells[ i ].h, position ) || !PlaceRect( packer, position ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static unsigned int NextPowerOfTwo( unsigned int value ) {
+	unsigned int result = 1;
+	while ( result < value ) {
+		result <<= 1;
+	}
+
+	return result;
+}
+
+/**
+ * Copies an image into its cell, extruding its edges out over the padding
+ * and anything left over from aligning the cell.
+ */
+static void BlitCell( PLImage *atlas, const AtlasRect *cell, const uint8_t *pixels, unsigned int w, unsigned int h, unsigned int padding ) {
+	for ( unsigned int y = 0; y < cell->h; ++y ) {
+		int sy = ( int ) y - ( int ) padding;
+		sy = sy < 0 ? 0 : ( sy >= ( int ) h ? ( int ) h - 1 : sy );
+
+		const uint8_t *src = pixels + ( size_t ) sy * w * 4;
+		uint8_t *dst = atlas->data[ 0 ] + ( ( size_t ) ( cell->y + y ) * atlas->width + cell->x ) * 4;
+
+		unsigned int x = 0;
+		for ( ; x < padding && x < cell->w; ++x, dst += 4 ) {
+			memcpy( dst, src, 4 );
+		}
+
+		unsigned int span = ( cell->w - x ) < w ? ( cell->w - x ) : w;
+		memcpy( dst, src, ( size_t ) span * 4 );
+		dst += ( size_t ) span * 4;
+		x += span;
+
+		for ( ; x < cell->w; ++x, dst += 4 ) {
+			memcpy( dst, src + ( size_t ) ( w - 1 ) * 4, 4 );
+		}
+	}
+}
+
+/**
+ * Packs the given images into a single RGBA8 atlas.
+ * @param images Images to pack; only the first level of each is used.
+ * @param numImages Number of images.
+ * @param padding Border around each image, filled by extruding its edges.
+ * @param alignment Every cell starts on a multiple of this; use the BC block
+ * size or 2^n for n mip levels. Zero is treated as one.
+ * @param maxSize Largest the atlas may grow to in either dimension.
+ * @param rects Receives where each image ended up, in the same order.
+ * @return Returns the atlas, or NULL if the images couldn't be packed.
+ */
+PLImage *PlCreateImageAtlas( PLImage **images, unsigned int numImages, unsigned int padding, unsigned int alignment,
+                             unsigned int maxSize, PLImageAtlasRect *rects ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	if ( images == NULL || numImages == 0 ) {
+		PlReportBasicError( PL_RESULT_INVALID_PARM1 );
+		PL_PROFILE_END();
+		return NULL;
+	}
+
+	if ( rects == NULL ) {
+		PlReportErrorF( PL_RESULT_FAIL, "no rect table provided" );
+		PL_PROFILE_END();
+		return NULL;
+	}
+
+	if ( alignment == 0 ) {
+		alignment = 1;
+	}
+
+	AtlasCell *cells = pl_calloc( numImages, sizeof( AtlasCell ) );
+	AtlasRect *positions = pl_calloc( numImages, sizeof( AtlasRect ) );
+	AtlasPacker packer = { 0, 0, pl_malloc( 64 * sizeof( AtlasRect ) ), 0, 64 };
+
+	PLImage *atlas = NULL;
+	unsigned int minWidth = 1, minHeight = 1;
+	uint64_t area = 0;
+	for ( unsigned int i = 0; i < numImages; ++i ) {
+		if ( images[ i ] == NULL || images[ i ]->width == 0 || images[ i ]->height == 0 ) {
+			PlReportErrorF( PL_RESULT_INVALID_PARM1, "invalid image at %u", i );
+			goto CLEANUP;
+		}
+
+		if ( !_plIsPixelFormatConvertible( images[ i ]->format ) ) {
+			PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported pixel format for image at %u", i );
+			goto CLEANUP;
+		}
+
+		cells[ i ].index = i;
+		cells[ i ].w = AlignUp( images[ i ]->width + padding * 2, alignment );
+		cells[ i ].h = AlignUp( images[ i ]->height + padding * 2, alignment );
+		minWidth = cells[ i ].w > minWidth ? cells[ i ].w : minWidth;
+		minHeight = cells[ i ].h > minHeight ? cells[ i ].h : minHeight;
+		area += ( uint64_t ) cells[ i ].w * cells[ i ].h;
+	}
+
+	qsort( cells, numImages, sizeof( AtlasCell ), CompareAtlasCells );
+
+	/* start from the smallest size that could possibly hold everything, and grow the shorter side until it does */
+	packer.width = NextPowerOfTwo( minWidth );
+	packer.height = NextPowerOfTwo( minHeight );
+	while ( ( uint64_t ) packer.width * packer.height < area ) {
+		if ( packer.width <= packer.height ) {
+			packer.width <<= 1;
+		} else {
+			packer.height <<= 1;
+		}
+	}
+
+	for ( ;; ) {
+		if ( packer.width > maxSize || packer.height > maxSize ) {
+			PlReportErrorF( PL_RESULT_IMAGERESOLUTION, "images don't fit within a %ux%u atlas", maxSize, maxSize );
+			goto CLEANUP;
+		}
+
+		if ( PackCells( &packer, cells, numImages, positions ) ) {
+			break;
+		}
+
+		if ( packer.width <= packer.height ) {
+			packer.width <<= 1;
+		} else {
+			packer.height <<= 1;
+		}
+	}
+
+	atlas = PlCreateImage( NULL, packer.width, packer.height, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	if ( atlas == NULL ) {
+		goto CLEANUP;
+	}
+
+	for ( unsigned int i = 0; i < numImages; ++i ) {
+		const PLImage *image = images[ i ];
+		const uint8_t *pixels = image->data[ 0 ];
+		uint8_t *converted = NULL;
+		if ( image->format != PL_IMAGEFORMAT_RGBA8 ) {
+			converted = pl_malloc( ( size_t ) image->width * image->height * 4 );
+			if ( converted == NULL || !PlConvertPixels( pixels, image->format, converted, PL_IMAGEFORMAT_RGBA8, ( size_t ) image->width * image->height ) ) {
+				pl_free( converted );
+				PlDestroyImage( atlas );
+				atlas = NULL;
+				goto CLEANUP;
+			}
+			pixels = converted;
+		}
+
+		BlitCell( atlas, &positions[ i ], pixels, image->width, image->height, padding );
+		pl_free( converted );
+
+		PLImageAtlasRect *rect = &rects[ i ];
+		rect->x = positions[ i ].x + padding;
+		rect->y = positions[ i ].y + padding;
+		rect->width = image->width;
+		rect->height = image->height;
+		rect->s0 = ( float ) rect->x / ( float ) atlas->width;
+		rect->t0 = ( float ) rect->y / ( float ) atlas->height;
+		rect->s1 = ( float ) ( rect->x + rect->width ) / ( float ) atlas->width;
+		rect->t1 = ( float ) ( rect->y + rect->height ) / ( float ) atlas->height;
+	}
+
+CLEANUP:
+	pl_free( packer.freeRects );
+	pl_free( positions );
+	pl_free( cells );
+
+	PL_PROFILE_END();
+	return atlas;
+}
@@ -0,0 +1,1096 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include <plcore/pl_thread.h>
+
+#include <float.h>
+#include <limits.h>
+
+#include "image_private.h"
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Decoding of the block compressed formats (BC1-5, aka DXT1-5 and RGTC)
+ * into RGBA8. Blocks are 4x4 pixels; the AVX2 path expands the indices of
+ * two rows at a time with a byte shuffle over the block's palette.
+ *
+ * BC4 and BC5 decode as D3D does, so the missing channels are zero
+ * and alpha is opaque.
+ *
+ * Encoding goes the other way, from RGBA8, fitting the colour endpoints
+ * along the principal axis of each block (see RangeFitColours and
+ * ClusterFitColours) and picking the indices with SSE2 where we can. */
+
+/* below this many pixels, spinning up threads costs more than it saves */
+#define BC_THREAD_MIN_PIXELS ( 256 * 256 )
+#define BC_THREAD_JOB_ROWS   16 /* rows of blocks per job */
+#define BC_MAX_THREADS       16
+
+typedef void ( *BlockDecoder )( const uint8_t *block, uint8_t *dst, size_t stride );
+
+static inline unsigned int Expand5( unsigned int v ) { return ( v << 3 ) | ( v >> 2 ); }
+static inline unsigned int Expand6( unsigned int v ) { return ( v << 2 ) | ( v >> 4 ); }
+
+static inline uint32_t ReadLittle32( const uint8_t *p ) {
+	return ( uint32_t ) p[ 0 ] | ( ( uint32_t ) p[ 1 ] << 8 ) | ( ( uint32_t ) p[ 2 ] << 16 ) | ( ( uint32_t ) p[ 3 ] << 24 );
+}
+
+static inline uint64_t ReadLittle48( const uint8_t *p ) {
+	return ( uint64_t ) ReadLittle32( p ) | ( ( uint64_t ) p[ 4 ] << 32 ) | ( ( uint64_t ) p[ 5 ] << 40 );
+}
+
+/**
+ * Fills in the four RGBA8 colours for a BC1-style colour block. Only BC1 has
+ * the three colour mode, in which case the last entry gets the given alpha.
+ */
+static void BuildColourPalette( const uint8_t *block, uint8_t palette[ 4 ][ 4 ], bool hasThreeColourMode, uint8_t blackAlpha ) {
+	unsigned int c0 = block[ 0 ] | ( block[ 1 ] << 8 );
+	unsigned int c1 = block[ 2 ] | ( block[ 3 ] << 8 );
+
+	palette[ 0 ][ 0 ] = ( uint8_t ) Expand5( c0 >> 11 );
+	palette[ 0 ][ 1 ] = ( uint8_t ) Expand6( ( c0 >> 5 ) & 63 );
+	palette[ 0 ][ 2 ] = ( uint8_t ) Expand5( c0 & 31 );
+	palette[ 0 ][ 3 ] = 255;
+	palette[ 1 ][ 0 ] = ( uint8_t ) Expand5( c1 >> 11 );
+	palette[ 1 ][ 1 ] = ( uint8_t ) Expand6( ( c1 >> 5 ) & 63 );
+	palette[ 1 ][ 2 ] = ( uint8_t ) Expand5( c1 & 31 );
+	palette[ 1 ][ 3 ] = 255;
+
+	if ( c0 > c1 || !hasThreeColourMode ) {
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			palette[ 2 ][ i ] = ( uint8_t ) ( ( 2 * palette[ 0 ][ i ] + palette[ 1 ][ i ] ) / 3 );
+			palette[ 3 ][ i ] = ( uint8_t ) ( ( palette[ 0 ][ i ] + 2 * palette[ 1 ][ i ] ) / 3 );
+		}
+		palette[ 3 ][ 3 ] = 255;
+	} else {
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			palette[ 2 ][ i ] = ( uint8_t ) ( ( palette[ 0 ][ i ] + palette[ 1 ][ i ] ) / 2 );
+			palette[ 3 ][ i ] = 0;
+		}
+		palette[ 3 ][ 3 ] = blackAlpha;
+	}
+	palette[ 2 ][ 3 ] = 255;
+}
+
+/**
+ * Fills in the eight values for a BC3 alpha or BC4 channel block.
+ */
+static void BuildChannelPalette( const uint8_t *block, uint8_t palette[ 8 ] ) {
+	unsigned int a0 = block[ 0 ];
+	unsigned int a1 = block[ 1 ];
+
+	palette[ 0 ] = ( uint8_t ) a0;
+	palette[ 1 ] = ( uint8_t ) a1;
+	if ( a0 > a1 ) {
+		for ( unsigned int i = 1; i < 7; ++i ) {
+			palette[ i + 1 ] = ( uint8_t ) ( ( ( 7 - i ) * a0 + i * a1 ) / 7 );
+		}
+	} else {
+		for ( unsigned int i = 1; i < 5; ++i ) {
+			palette[ i + 1 ] = ( uint8_t ) ( ( ( 5 - i ) * a0 + i * a1 ) / 5 );
+		}
+		palette[ 6 ] = 0;
+		palette[ 7 ] = 255;
+	}
+}
+
+/****************************************
+ * Scalar
+ ****************************************/
+
+static void DecodeColourScalar( const uint8_t *block, uint8_t *dst, size_t stride, bool hasThreeColourMode, uint8_t blackAlpha ) {
+	uint8_t palette[ 4 ][ 4 ];
+	BuildColourPalette( block, palette, hasThreeColourMode, blackAlpha );
+
+	uint32_t indices = ReadLittle32( block + 4 );
+	for ( unsigned int y = 0; y < 4; ++y, dst += stride ) {
+		for ( unsigned int x = 0; x < 4; ++x, indices >>= 2 ) {
+			memcpy( dst + x * 4, palette[ indices & 3 ], 4 );
+		}
+	}
+}
+
+/* writes the decoded channel into every fourth byte, starting from dst */
+static void DecodeChannelScalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	uint8_t palette[ 8 ];
+	BuildChannelPalette( block, palette );
+
+	uint64_t indices = ReadLittle48( block + 2 );
+	for ( unsigned int y = 0; y < 4; ++y, dst += stride ) {
+		for ( unsigned int x = 0; x < 4; ++x, indices >>= 3 ) {
+			dst[ x * 4 ] = palette[ indices & 7 ];
+		}
+	}
+}
+
+static void DecodeBC1Scalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	DecodeColourScalar( block, dst, stride, true, 0 );
+}
+
+static void DecodeBC1OpaqueScalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	DecodeColourScalar( block, dst, stride, true, 255 );
+}
+
+static void DecodeBC2Scalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	DecodeColourScalar( block + 8, dst, stride, false, 255 );
+
+	for ( unsigned int y = 0; y < 4; ++y, dst += stride ) {
+		unsigned int row = block[ y * 2 ] | ( block[ y * 2 + 1 ] << 8 );
+		for ( unsigned int x = 0; x < 4; ++x, row >>= 4 ) {
+			dst[ x * 4 + 3 ] = ( uint8_t ) ( ( row & 15 ) * 17 );
+		}
+	}
+}
+
+static void DecodeBC3Scalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	DecodeColourScalar( block + 8, dst, stride, false, 255 );
+	DecodeChannelScalar( block, dst + 3, stride );
+}
+
+static void DecodeBC4Scalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	static const uint8_t clear[ 16 ] = { 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255 };
+	for ( unsigned int y = 0; y < 4; ++y ) {
+		memcpy( dst + y * stride, clear, sizeof( clear ) );
+	}
+
+	DecodeChannelScalar( block, dst, stride );
+}
+
+static void DecodeBC5Scalar( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	DecodeBC4Scalar( block, dst, stride );
+	DecodeChannelScalar( block + 8, dst + 1, stride );
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+/****************************************
+ * AVX2
+ ****************************************/
+
+/* expands sixteen 2-bit colour indices, two rows at a time */
+PL_TARGET_ISA( "avx2" )
+static inline void Avx2ColourRows( const uint8_t *block, bool hasThreeColourMode, uint8_t blackAlpha, __m256i *rows ) {
+	uint8_t palette[ 4 ][ 4 ];
+	BuildColourPalette( block, palette, hasThreeColourMode, blackAlpha );
+	__m256i colours = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i * ) palette ) );
+
+	const __m256i shifts = _mm256_setr_epi32( 0, 2, 4, 6, 8, 10, 12, 14 );
+	uint32_t indices = ReadLittle32( block + 4 );
+	for ( unsigned int i = 0; i < 2; ++i, indices >>= 16 ) {
+		__m256i index = _mm256_and_si256( _mm256_srlv_epi32( _mm256_set1_epi32( ( int ) indices ), shifts ), _mm256_set1_epi32( 3 ) );
+		/* turn each index into the four byte offsets of its colour */
+		__m256i control = _mm256_add_epi32( _mm256_mullo_epi32( index, _mm256_set1_epi32( 0x04040404 ) ), _mm256_set1_epi32( 0x03020100 ) );
+		rows[ i ] = _mm256_shuffle_epi8( colours, control );
+	}
+}
+
+/* expands sixteen 3-bit channel indices, with the result in the low byte of each pixel */
+PL_TARGET_ISA( "avx2" )
+static inline void Avx2ChannelRows( const uint8_t *block, __m256i *rows ) {
+	uint8_t palette[ 8 ];
+	BuildChannelPalette( block, palette );
+	int64_t values;
+	memcpy( &values, palette, sizeof( values ) );
+	__m256i channel = _mm256_set1_epi64x( values );
+
+	const __m256i shifts = _mm256_setr_epi32( 0, 3, 6, 9, 12, 15, 18, 21 );
+	uint64_t indices = ReadLittle48( block + 2 );
+	for ( unsigned int i = 0; i < 2; ++i, indices >>= 24 ) {
+		__m256i index = _mm256_and_si256( _mm256_srlv_epi32( _mm256_set1_epi32( ( int ) ( indices & 0xffffff ) ), shifts ), _mm256_set1_epi32( 7 ) );
+		/* the high bit zeroes the other three bytes */
+		rows[ i ] = _mm256_shuffle_epi8( channel, _mm256_or_si256( index, _mm256_set1_epi32( ( int ) 0x80808000 ) ) );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static inline void Avx2StoreRows( uint8_t *dst, size_t stride, const __m256i *rows ) {
+	for ( unsigned int i = 0; i < 2; ++i, dst += stride * 2 ) {
+		_mm_storeu_si128( ( __m128i * ) dst, _mm256_castsi256_si128( rows[ i ] ) );
+		_mm_storeu_si128( ( __m128i * ) ( dst + stride ), _mm256_extracti128_si256( rows[ i ], 1 ) );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DecodeBC1Avx2( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	__m256i rows[ 2 ];
+	Avx2ColourRows( block, true, 0, rows );
+	Avx2StoreRows( dst, stride, rows );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DecodeBC1OpaqueAvx2( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	__m256i rows[ 2 ];
+	Avx2ColourRows( block, true, 255, rows );
+	Avx2StoreRows( dst, stride, rows );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DecodeBC2Avx2( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	__m256i rows[ 2 ];
+	Avx2ColourRows( block + 8, false, 255, rows );
+
+	const __m256i shifts = _mm256_setr_epi32( 0, 4, 8, 12, 16, 20, 24, 28 );
+	const __m256i colourMask = _mm256_set1_epi32( 0x00ffffff );
+	for ( unsigned int i = 0; i < 2; ++i ) {
+		__m256i alpha = _mm256_and_si256( _mm256_srlv_epi32( _mm256_set1_epi32( ( int ) ReadLittle32( block + i * 4 ) ), shifts ), _mm256_set1_epi32( 15 ) );
+		alpha = _mm256_slli_epi32( _mm256_mullo_epi32( alpha, _mm256_set1_epi32( 17 ) ), 24 );
+		rows[ i ] = _mm256_or_si256( _mm256_and_si256( rows[ i ], colourMask ), alpha );
+	}
+
+	Avx2StoreRows( dst, stride, rows );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DecodeBC3Avx2( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	__m256i rows[ 2 ], alpha[ 2 ];
+	Avx2ColourRows( block + 8, false, 255, rows );
+	Avx2ChannelRows( block, alpha );
+
+	const __m256i colourMask = _mm256_set1_epi32( 0x00ffffff );
+	for ( unsigned int i = 0; i < 2; ++i ) {
+		rows[ i ] = _mm256_or_si256( _mm256_and_si256( rows[ i ], colourMask ), _mm256_slli_epi32( alpha[ i ], 24 ) );
+	}
+
+	Avx2StoreRows( dst, stride, rows );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DecodeBC4Avx2( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	__m256i rows[ 2 ];
+	Avx2ChannelRows( block, rows );
+
+	const __m256i opaque = _mm256_set1_epi32( ( int ) 0xff000000 );
+	for ( unsigned int i = 0; i < 2; ++i ) {
+		rows[ i ] = _mm256_or_si256( rows[ i ], opaque );
+	}
+
+	Avx2StoreRows( dst, stride, rows );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DecodeBC5Avx2( const uint8_t *block, uint8_t *dst, size_t stride ) {
+	__m256i rows[ 2 ], green[ 2 ];
+	Avx2ChannelRows( block, rows );
+	Avx2ChannelRows( block + 8, green );
+
+	const __m256i opaque = _mm256_set1_epi32( ( int ) 0xff000000 );
+	for ( unsigned int i = 0; i < 2; ++i ) {
+		rows[ i ] = _mm256_or_si256( _mm256_or_si256( rows[ i ], _mm256_slli_epi32( green[ i ], 8 ) ), opaque );
+	}
+
+	Avx2StoreRows( dst, stride, rows );
+}
+
+#	define AVX2_DECODER( DECODER ) DECODER
+#else
+#	define AVX2_DECODER( DECODER ) NULL
+#endif
+
+/****************************************
+ * Encoding
+ ****************************************/
+
+typedef uint32_t ( *ColourIndexSelector )( const uint8_t pixels[ 16 ][ 4 ], const uint8_t palette[ 4 ][ 4 ], unsigned int numColours, uint32_t *error );
+typedef uint64_t ( *ChannelIndexSelector )( const uint8_t values[ 16 ], const uint8_t palette[ 8 ], uint32_t *error );
+
+typedef struct BlockEncodeOptions {
+	PLImageCompressionQuality quality;
+	ColourIndexSelector SelectColourIndices;
+	ChannelIndexSelector SelectChannelIndices;
+} BlockEncodeOptions;
+
+typedef void ( *BlockEncoder )( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options );
+
+/* pixels with less alpha than this are transparent in BC1 */
+#define BC1_ALPHA_THRESHOLD 128
+
+static uint32_t SelectColourIndicesScalar( const uint8_t pixels[ 16 ][ 4 ], const uint8_t palette[ 4 ][ 4 ], unsigned int numColours, uint32_t *error ) {
+	uint32_t indices = 0;
+	*error = 0;
+	for ( unsigned int i = 0; i < 16; ++i ) {
+		uint32_t best = UINT32_MAX;
+		unsigned int bestIndex = 0;
+		for ( unsigned int j = 0; j < numColours; ++j ) {
+			int dr = pixels[ i ][ 0 ] - palette[ j ][ 0 ];
+			int dg = pixels[ i ][ 1 ] - palette[ j ][ 1 ];
+			int db = pixels[ i ][ 2 ] - palette[ j ][ 2 ];
+			uint32_t distance = ( uint32_t ) ( dr * dr + dg * dg + db * db );
+			if ( distance < best ) {
+				best = distance;
+				bestIndex = j;
+			}
+		}
+
+		indices |= bestIndex << ( i * 2 );
+		*error += best;
+	}
+
+	return indices;
+}
+
+static uint64_t SelectChannelIndicesScalar( const uint8_t values[ 16 ], const uint8_t palette[ 8 ], uint32_t *error ) {
+	uint64_t indices = 0;
+	*error = 0;
+	for ( unsigned int i = 0; i < 16; ++i ) {
+		unsigned int best = UINT_MAX;
+		unsigned int bestIndex = 0;
+		for ( unsigned int j = 0; j < 8; ++j ) {
+			unsigned int distance = ( unsigned int ) abs( values[ i ] - palette[ j ] );
+			if ( distance < best ) {
+				best = distance;
+				bestIndex = j;
+			}
+		}
+
+		indices |= ( uint64_t ) bestIndex << ( i * 3 );
+		*error += best * best;
+	}
+
+	return indices;
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+/* squared distance from four pixels to a colour, ignoring alpha */
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2ColourDistance( __m128i pixels, __m128i colour ) {
+	__m128i lo = _mm_sub_epi16( _mm_unpacklo_epi8( pixels, _mm_setzero_si128() ), _mm_unpacklo_epi8( colour, _mm_setzero_si128() ) );
+	__m128i hi = _mm_sub_epi16( _mm_unpackhi_epi8( pixels, _mm_setzero_si128() ), _mm_unpackhi_epi8( colour, _mm_setzero_si128() ) );
+	lo = _mm_madd_epi16( lo, lo );
+	hi = _mm_madd_epi16( hi, hi );
+	lo = _mm_add_epi32( lo, _mm_srli_epi64( lo, 32 ) );
+	hi = _mm_add_epi32( hi, _mm_srli_epi64( hi, 32 ) );
+	return _mm_unpacklo_epi64( _mm_shuffle_epi32( lo, _MM_SHUFFLE( 3, 1, 2, 0 ) ), _mm_shuffle_epi32( hi, _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static uint32_t SelectColourIndicesSse2( const uint8_t pixels[ 16 ][ 4 ], const uint8_t palette[ 4 ][ 4 ], unsigned int numColours, uint32_t *error ) {
+	const __m128i colourMask = _mm_set1_epi32( 0x00ffffff );
+
+	__m128i colours[ 4 ];
+	for ( unsigned int j = 0; j < numColours; ++j ) {
+		uint32_t colour;
+		memcpy( &colour, palette[ j ], sizeof( colour ) );
+		colours[ j ] = _mm_and_si128( _mm_set1_epi32( ( int ) colour ), colourMask );
+	}
+
+	uint32_t indices = 0;
+	__m128i total = _mm_setzero_si128();
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		__m128i p = _mm_and_si128( _mm_loadu_si128( ( const __m128i * ) pixels[ i * 4 ] ), colourMask );
+		__m128i best = Sse2ColourDistance( p, colours[ 0 ] );
+		__m128i bestIndex = _mm_setzero_si128();
+		for ( unsigned int j = 1; j < numColours; ++j ) {
+			__m128i distance = Sse2ColourDistance( p, colours[ j ] );
+			__m128i closer = _mm_cmplt_epi32( distance, best );
+			best = _mm_or_si128( _mm_and_si128( closer, distance ), _mm_andnot_si128( closer, best ) );
+			bestIndex = _mm_or_si128( _mm_and_si128( closer, _mm_set1_epi32( ( int ) j ) ), _mm_andnot_si128( closer, bestIndex ) );
+		}
+		total = _mm_add_epi32( total, best );
+
+		/* gather the four 2-bit indices into a byte */
+		bestIndex = _mm_or_si128( bestIndex, _mm_srli_epi64( bestIndex, 30 ) );
+		uint32_t packed = ( uint32_t ) ( _mm_cvtsi128_si32( bestIndex ) & 0xf ) | ( ( uint32_t ) ( _mm_cvtsi128_si32( _mm_srli_si128( bestIndex, 8 ) ) & 0xf ) << 4 );
+		indices |= packed << ( i * 8 );
+	}
+
+	total = _mm_add_epi32( total, _mm_shuffle_epi32( total, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	total = _mm_add_epi32( total, _mm_shuffle_epi32( total, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	*error = ( uint32_t ) _mm_cvtsi128_si32( total );
+
+	return indices;
+}
+
+PL_TARGET_ISA( "sse2" )
+static uint64_t SelectChannelIndicesSse2( const uint8_t values[ 16 ], const uint8_t palette[ 8 ], uint32_t *error ) {
+	__m128i v = _mm_loadu_si128( ( const __m128i * ) values );
+	__m128i best = _mm_set1_epi8( ( char ) 255 );
+	__m128i bestIndex = _mm_setzero_si128();
+	for ( unsigned int j = 0; j < 8; ++j ) {
+		__m128i c = _mm_set1_epi8( ( char ) palette[ j ] );
+		__m128i distance = _mm_or_si128( _mm_subs_epu8( v, c ), _mm_subs_epu8( c, v ) );
+		/* strictly closer, so ties keep the lowest index like the scalar path */
+		__m128i closer = _mm_andnot_si128( _mm_cmpeq_epi8( distance, best ), _mm_cmpeq_epi8( _mm_min_epu8( distance, best ), distance ) );
+		best = _mm_min_epu8( distance, best );
+		bestIndex = _mm_or_si128( _mm_and_si128( closer, _mm_set1_epi8( ( char ) j ) ), _mm_andnot_si128( closer, bestIndex ) );
+	}
+
+	__m128i lo = _mm_unpacklo_epi8( best, _mm_setzero_si128() );
+	__m128i hi = _mm_unpackhi_epi8( best, _mm_setzero_si128() );
+	__m128i total = _mm_add_epi32( _mm_madd_epi16( lo, lo ), _mm_madd_epi16( hi, hi ) );
+	total = _mm_add_epi32( total, _mm_shuffle_epi32( total, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+	total = _mm_add_epi32( total, _mm_shuffle_epi32( total, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+	*error = ( uint32_t ) _mm_cvtsi128_si32( total );
+
+	uint8_t index[ 16 ];
+	_mm_storeu_si128( ( __m128i * ) index, bestIndex );
+	uint64_t indices = 0;
+	for ( unsigned int i = 0; i < 16; ++i ) {
+		indices |= ( uint64_t ) index[ i ] << ( i * 3 );
+	}
+
+	return indices;
+}
+
+#endif
+
+static inline void WriteLittle16( uint8_t *p, unsigned int v ) {
+	p[ 0 ] = ( uint8_t ) v;
+	p[ 1 ] = ( uint8_t ) ( v >> 8 );
+}
+
+static inline void WriteLittle32( uint8_t *p, uint32_t v ) {
+	WriteLittle16( p, v & 0xffff );
+	WriteLittle16( p + 2, v >> 16 );
+}
+
+/* snaps a channel onto the grid it will be stored in, returning the value it decodes to */
+static inline float SnapChannel( float v, unsigned int max ) {
+	unsigned int q = ( unsigned int ) ( fminf( fmaxf( v, 0.0f ), 255.0f ) * ( ( float ) max / 255.0f ) + 0.5f );
+	return ( float ) ( ( max == 31 ) ? Expand5( q ) : Expand6( q ) );
+}
+
+static unsigned int PackColour565( const float *colour ) {
+	unsigned int r = ( unsigned int ) ( PlClamp( 0.0f, colour[ 0 ], 255.0f ) * 31.0f / 255.0f + 0.5f );
+	unsigned int g = ( unsigned int ) ( PlClamp( 0.0f, colour[ 1 ], 255.0f ) * 63.0f / 255.0f + 0.5f );
+	unsigned int b = ( unsigned int ) ( PlClamp( 0.0f, colour[ 2 ], 255.0f ) * 31.0f / 255.0f + 0.5f );
+	return ( r << 11 ) | ( g << 5 ) | b;
+}
+
+/**
+ * Finds the mean and the direction of greatest variance for the given
+ * colours, the latter via a few rounds of power iteration.
+ */
+static void ComputePrincipalAxis( const float ( *points )[ 3 ], unsigned int numPoints, float *mean, float *axis ) {
+	mean[ 0 ] = mean[ 1 ] = mean[ 2 ] = 0.0f;
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		for ( unsigned int c = 0; c < 3; ++c ) {
+			mean[ c ] += points[ i ][ c ];
+		}
+	}
+	for ( unsigned int c = 0; c < 3; ++c ) {
+		mean[ c ] /= ( float ) numPoints;
+	}
+
+	float covariance[ 6 ] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; /* xx xy xz yy yz zz */
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		float x = points[ i ][ 0 ] - mean[ 0 ];
+		float y = points[ i ][ 1 ] - mean[ 1 ];
+		float z = points[ i ][ 2 ] - mean[ 2 ];
+		covariance[ 0 ] += x * x;
+		covariance[ 1 ] += x * y;
+		covariance[ 2 ] += x * z;
+		covariance[ 3 ] += y * y;
+		covariance[ 4 ] += y * z;
+		covariance[ 5 ] += z * z;
+	}
+
+	axis[ 0 ] = axis[ 1 ] = axis[ 2 ] = 1.0f;
+	for ( unsigned int i = 0; i < 8; ++i ) {
+		float x = covariance[ 0 ] * axis[ 0 ] + covariance[ 1 ] * axis[ 1 ] + covariance[ 2 ] * axis[ 2 ];
+		float y = covariance[ 1 ] * axis[ 0 ] + covariance[ 3 ] * axis[ 1 ] + covariance[ 4 ] * axis[ 2 ];
+		float z = covariance[ 2 ] * axis[ 0 ] + covariance[ 4 ] * axis[ 1 ] + covariance[ 5 ] * axis[ 2 ];
+		float length = fmaxf( fabsf( x ), fmaxf( fabsf( y ), fabsf( z ) ) );
+		if ( length < 1e-6f ) {
+			break; /* a single colour, so any axis will do */
+		}
+
+		axis[ 0 ] = x / length;
+		axis[ 1 ] = y / length;
+		axis[ 2 ] = z / length;
+	}
+}
+
+/**
+ * Range fit; spans the endpoints across the extent of the colours along
+ * their principal axis. Cheap, which makes it the one for runtime use.
+ */
+static void RangeFitColours( const float ( *points )[ 3 ], unsigned int numPoints, float *start, float *end ) {
+	float mean[ 3 ], axis[ 3 ];
+	ComputePrincipalAxis( points, numPoints, mean, axis );
+
+	float minDot = FLT_MAX, maxDot = -FLT_MAX;
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		float dot = ( points[ i ][ 0 ] - mean[ 0 ] ) * axis[ 0 ] + ( points[ i ][ 1 ] - mean[ 1 ] ) * axis[ 1 ] + ( points[ i ][ 2 ] - mean[ 2 ] ) * axis[ 2 ];
+		minDot = fminf( minDot, dot );
+		maxDot = fmaxf( maxDot, dot );
+	}
+
+	float lengthSquared = axis[ 0 ] * axis[ 0 ] + axis[ 1 ] * axis[ 1 ] + axis[ 2 ] * axis[ 2 ];
+	for ( unsigned int c = 0; c < 3; ++c ) {
+		start[ c ] = mean[ c ] + axis[ c ] * maxDot / lengthSquared;
+		end[ c ] = mean[ c ] + axis[ c ] * minDot / lengthSquared;
+	}
+}
+
+/**
+ * Cluster fit; orders the colours along their principal axis and then
+ * tries every way of splitting them into the four palette entries,
+ * solving for the endpoints which best fit each split. Slow, so it's
+ * intended for offline use.
+ */
+static void ClusterFitColours( const float ( *points )[ 3 ], unsigned int numPoints, float *start, float *end ) {
+	float mean[ 3 ], axis[ 3 ];
+	ComputePrincipalAxis( points, numPoints, mean, axis );
+
+	unsigned int order[ 16 ];
+	float dots[ 16 ];
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		float dot = points[ i ][ 0 ] * axis[ 0 ] + points[ i ][ 1 ] * axis[ 1 ] + points[ i ][ 2 ] * axis[ 2 ];
+		unsigned int j = i;
+		for ( ; j > 0 && dots[ j - 1 ] < dot; --j ) {
+			dots[ j ] = dots[ j - 1 ];
+			order[ j ] = order[ j - 1 ];
+		}
+		dots[ j ] = dot;
+		order[ j ] = i;
+	}
+
+	float sums[ 17 ][ 3 ];
+	sums[ 0 ][ 0 ] = sums[ 0 ][ 1 ] = sums[ 0 ][ 2 ] = 0.0f;
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		for ( unsigned int c = 0; c < 3; ++c ) {
+			sums[ i + 1 ][ c ] = sums[ i ][ c ] + points[ order[ i ] ][ c ];
+		}
+	}
+
+	RangeFitColours( points, numPoints, start, end );
+	float bestError = FLT_MAX;
+
+	/* clusters are weighted 1, 2/3, 1/3 and 0 towards the start */
+	for ( unsigned int c0 = 0; c0 <= numPoints; ++c0 ) {
+		for ( unsigned int c1 = c0; c1 <= numPoints; ++c1 ) {
+			for ( unsigned int c2 = c1; c2 <= numPoints; ++c2 ) {
+				float n0 = ( float ) c0, n1 = ( float ) ( c1 - c0 ), n2 = ( float ) ( c2 - c1 ), n3 = ( float ) ( numPoints - c2 );
+				float alpha2 = n0 + n1 * ( 4.0f / 9.0f ) + n2 * ( 1.0f / 9.0f );
+				float beta2 = n3 + n2 * ( 4.0f / 9.0f ) + n1 * ( 1.0f / 9.0f );
+				float alphaBeta = ( n1 + n2 ) * ( 2.0f / 9.0f );
+				float factor = alpha2 * beta2 - alphaBeta * alphaBeta;
+				if ( factor < 1e-4f ) {
+					continue;
+				}
+				factor = 1.0f / factor;
+
+				float a[ 3 ], b[ 3 ], error = 0.0f;
+				for ( unsigned int c = 0; c < 3; ++c ) {
+					float x0 = sums[ c0 ][ c ];
+					float x1 = sums[ c1 ][ c ] - sums[ c0 ][ c ];
+					float x2 = sums[ c2 ][ c ] - sums[ c1 ][ c ];
+					float x3 = sums[ numPoints ][ c ] - sums[ c2 ][ c ];
+					float alphaX = x0 + x1 * ( 2.0f / 3.0f ) + x2 * ( 1.0f / 3.0f );
+					float betaX = x1 * ( 1.0f / 3.0f ) + x2 * ( 2.0f / 3.0f ) + x3;
+
+					unsigned int max = ( c == 1 ) ? 63 : 31;
+					a[ c ] = SnapChannel( ( alphaX * beta2 - betaX * alphaBeta ) * factor, max );
+					b[ c ] = SnapChannel( ( betaX * alpha2 - alphaX * alphaBeta ) * factor, max );
+					error += a[ c ] * a[ c ] * alpha2 + b[ c ] * b[ c ] * beta2 + 2.0f * ( a[ c ] * b[ c ] * alphaBeta - a[ c ] * alphaX - b[ c ] * betaX );
+				}
+
+				if ( error < bestError ) {
+					bestError = error;
+					memcpy( start, a, sizeof( a ) );
+					memcpy( end, b, sizeof( b ) );
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Encodes a BC1-style colour block. With hasCutout, any transparent
+ * pixels force the three colour mode so they can use the transparent entry.
+ */
+static void EncodeColourBlock( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, bool isBC1, bool hasCutout, const BlockEncodeOptions *options ) {
+	float points[ 16 ][ 3 ];
+	unsigned int numPoints = 0;
+	uint32_t transparent = 0;
+	for ( unsigned int i = 0; i < 16; ++i ) {
+		if ( hasCutout && pixels[ i ][ 3 ] < BC1_ALPHA_THRESHOLD ) {
+			transparent |= 3u << ( i * 2 );
+			continue;
+		}
+
+		points[ numPoints ][ 0 ] = pixels[ i ][ 0 ];
+		points[ numPoints ][ 1 ] = pixels[ i ][ 1 ];
+		points[ numPoints ][ 2 ] = pixels[ i ][ 2 ];
+		numPoints++;
+	}
+
+	if ( numPoints == 0 ) {
+		WriteLittle16( block, 0 );
+		WriteLittle16( block + 2, 0 );
+		WriteLittle32( block + 4, UINT32_MAX );
+		return;
+	}
+
+	float start[ 3 ], end[ 3 ];
+	if ( options->quality == PL_IMAGE_COMPRESSION_QUALITY && transparent == 0 ) {
+		ClusterFitColours( points, numPoints, start, end );
+	} else {
+		RangeFitColours( points, numPoints, start, end );
+	}
+
+	unsigned int c0 = PackColour565( start );
+	unsigned int c1 = PackColour565( end );
+
+	/* BC1 picks its mode from the order of the endpoints */
+	bool threeColourMode = ( transparent != 0 );
+	if ( isBC1 && ( threeColourMode ? c0 > c1 : c0 < c1 ) ) {
+		unsigned int swap = c0;
+		c0 = c1;
+		c1 = swap;
+	}
+
+	WriteLittle16( block, c0 );
+	WriteLittle16( block + 2, c1 );
+
+	uint32_t indices = 0;
+	if ( c0 != c1 ) {
+		uint8_t palette[ 4 ][ 4 ];
+		BuildColourPalette( block, palette, isBC1, 0 );
+
+		uint32_t error;
+		indices = options->SelectColourIndices( pixels, palette, threeColourMode ? 3 : 4, &error );
+		if ( options->quality == PL_IMAGE_COMPRESSION_QUALITY && !threeColourMode ) {
+			/* cluster fit works on unrounded palette entries, so keep the range fit if that's actually better */
+			uint8_t rangeBlock[ 4 ];
+			RangeFitColours( points, numPoints, start, end );
+			unsigned int r0 = PackColour565( start ), r1 = PackColour565( end );
+			if ( isBC1 && r0 < r1 ) {
+				unsigned int swap = r0;
+				r0 = r1;
+				r1 = swap;
+			}
+			if ( r0 != r1 ) {
+				WriteLittle16( rangeBlock, r0 );
+				WriteLittle16( rangeBlock + 2, r1 );
+				BuildColourPalette( rangeBlock, palette, isBC1, 0 );
+
+				uint32_t rangeError;
+				uint32_t rangeIndices = options->SelectColourIndices( pixels, palette, 4, &rangeError );
+				if ( rangeError < error ) {
+					WriteLittle16( block, r0 );
+					WriteLittle16( block + 2, r1 );
+					indices = rangeIndices;
+				}
+			}
+		}
+	}
+
+	WriteLittle32( block + 4, ( indices & ~transparent ) | transparent );
+}
+
+static void WriteChannelBlock( uint8_t *block, unsigned int a0, unsigned int a1, uint64_t indices ) {
+	block[ 0 ] = ( uint8_t ) a0;
+	block[ 1 ] = ( uint8_t ) a1;
+	for ( unsigned int i = 0; i < 6; ++i ) {
+		block[ 2 + i ] = ( uint8_t ) ( indices >> ( i * 8 ) );
+	}
+}
+
+/**
+ * Encodes a BC3 alpha / BC4 channel block. The quality setting also tries
+ * the six value mode, which keeps exact 0 and 255 for the cost of precision.
+ */
+static void EncodeChannelBlock( const uint8_t values[ 16 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	unsigned int min = 255, max = 0;
+	unsigned int innerMin = 255, innerMax = 0;
+	for ( unsigned int i = 0; i < 16; ++i ) {
+		min = ( values[ i ] < min ) ? values[ i ] : min;
+		max = ( values[ i ] > max ) ? values[ i ] : max;
+		if ( values[ i ] != 0 && values[ i ] != 255 ) {
+			innerMin = ( values[ i ] < innerMin ) ? values[ i ] : innerMin;
+			innerMax = ( values[ i ] > innerMax ) ? values[ i ] : innerMax;
+		}
+	}
+
+	if ( min == max ) {
+		WriteChannelBlock( block, min, max, 0 );
+		return;
+	}
+
+	/* eight value mode needs a0 > a1 */
+	uint8_t palette[ 8 ];
+	WriteChannelBlock( block, max, min, 0 );
+	BuildChannelPalette( block, palette );
+
+	uint32_t error;
+	uint64_t indices = options->SelectChannelIndices( values, palette, &error );
+	WriteChannelBlock( block, max, min, indices );
+
+	if ( options->quality != PL_IMAGE_COMPRESSION_QUALITY || innerMin > innerMax ) {
+		return;
+	}
+
+	uint8_t sixBlock[ 8 ];
+	WriteChannelBlock( sixBlock, innerMin, innerMax, 0 );
+	BuildChannelPalette( sixBlock, palette );
+
+	uint32_t sixError;
+	uint64_t sixIndices = options->SelectChannelIndices( values, palette, &sixError );
+	if ( sixError < error ) {
+		WriteChannelBlock( block, innerMin, innerMax, sixIndices );
+	}
+}
+
+static void GatherChannel( const uint8_t pixels[ 16 ][ 4 ], unsigned int channel, uint8_t *values ) {
+	for ( unsigned int i = 0; i < 16; ++i ) {
+		values[ i ] = pixels[ i ][ channel ];
+	}
+}
+
+static void EncodeBC1( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	EncodeColourBlock( pixels, block, true, true, options );
+}
+
+static void EncodeBC1Opaque( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	EncodeColourBlock( pixels, block, true, false, options );
+}
+
+static void EncodeBC2( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	for ( unsigned int i = 0; i < 16; i += 2 ) {
+		unsigned int a0 = ( pixels[ i ][ 3 ] * 15 + 127 ) / 255;
+		unsigned int a1 = ( pixels[ i + 1 ][ 3 ] * 15 + 127 ) / 255;
+		block[ i / 2 ] = ( uint8_t ) ( a0 | ( a1 << 4 ) );
+	}
+
+	EncodeColourBlock( pixels, block + 8, false, false, options );
+}
+
+static void EncodeBC3( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	uint8_t values[ 16 ];
+	GatherChannel( pixels, 3, values );
+	EncodeChannelBlock( values, block, options );
+	EncodeColourBlock( pixels, block + 8, false, false, options );
+}
+
+static void EncodeBC4( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	uint8_t values[ 16 ];
+	GatherChannel( pixels, 0, values );
+	EncodeChannelBlock( values, block, options );
+}
+
+static void EncodeBC5( const uint8_t pixels[ 16 ][ 4 ], uint8_t *block, const BlockEncodeOptions *options ) {
+	uint8_t values[ 16 ];
+	GatherChannel( pixels, 0, values );
+	EncodeChannelBlock( values, block, options );
+	GatherChannel( pixels, 1, values );
+	EncodeChannelBlock( values, block + 8, options );
+}
+
+/****************************************
+ ****************************************/
+
+typedef struct BlockFormatInfo {
+	PLImageFormat format;
+	unsigned int blockSize;
+	BlockDecoder decode[ PL_SIMD_LEVEL_AVX2 + 1 ];
+	BlockEncoder encode;
+} BlockFormatInfo;
+
+static const BlockFormatInfo blockFormats[] = {
+        { PL_IMAGEFORMAT_RGBA_DXT1, 8, { DecodeBC1Scalar, NULL, AVX2_DECODER( DecodeBC1Avx2 ) }, EncodeBC1 },
+        { PL_IMAGEFORMAT_RGB_DXT1, 8, { DecodeBC1OpaqueScalar, NULL, AVX2_DECODER( DecodeBC1OpaqueAvx2 ) }, EncodeBC1Opaque },
+        { PL_IMAGEFORMAT_RGBA_DXT3, 16, { DecodeBC2Scalar, NULL, AVX2_DECODER( DecodeBC2Avx2 ) }, EncodeBC2 },
+        { PL_IMAGEFORMAT_RGBA_DXT5, 16, { DecodeBC3Scalar, NULL, AVX2_DECODER( DecodeBC3Avx2 ) }, EncodeBC3 },
+        { PL_IMAGEFORMAT_R_BC4, 8, { DecodeBC4Scalar, NULL, AVX2_DECODER( DecodeBC4Avx2 ) }, EncodeBC4 },
+        { PL_IMAGEFORMAT_RG_BC5, 16, { DecodeBC5Scalar, NULL, AVX2_DECODER( DecodeBC5Avx2 ) }, EncodeBC5 },
+};
+
+static const BlockFormatInfo *GetBlockFormatInfo( PLImageFormat format ) {
+	for ( unsigned int i = 0; i < plArrayElements( blockFormats ); ++i ) {
+		if ( blockFormats[ i ].format == format ) {
+			return &blockFormats[ i ];
+		}
+	}
+
+	return NULL;
+}
+
+static void GetBlockEncodeOptions( PLImageCompressionQuality quality, BlockEncodeOptions *options ) {
+	options->quality = quality;
+	options->SelectColourIndices = SelectColourIndicesScalar;
+	options->SelectChannelIndices = SelectChannelIndicesScalar;
+#if defined( PL_SYSTEM_CPU_X86 )
+	if ( PlGetSimdLevel() >= PL_SIMD_LEVEL_SSE2 ) {
+		options->SelectColourIndices = SelectColourIndicesSse2;
+		options->SelectChannelIndices = SelectChannelIndicesSse2;
+	}
+#endif
+}
+
+bool _plIsBlockCompressedFormat( PLImageFormat format ) {
+	return ( GetBlockFormatInfo( format ) != NULL );
+}
+
+/**
+ * Returns the size in bytes of each 4x4 block, or zero
+ * if the format isn't one we can decode.
+ */
+unsigned int _plGetBlockSize( PLImageFormat format ) {
+	const BlockFormatInfo *info = GetBlockFormatInfo( format );
+	return ( info != NULL ) ? info->blockSize : 0;
+}
+
+typedef struct BlockLevel {
+	const uint8_t *src;
+	uint8_t *dst;
+	unsigned int width, height;
+} BlockLevel;
+
+typedef struct BlockJob {
+	const BlockLevel *level;
+	unsigned int firstRow, numRows;
+} BlockJob;
+
+typedef struct BlockWork {
+	void ( *ProcessRows )( const struct BlockWork *work, const BlockJob *job );
+	BlockDecoder decode;
+	BlockEncoder encode;
+	BlockEncodeOptions encodeOptions;
+	unsigned int blockSize;
+	const BlockJob *jobs;
+	int32_t numJobs;
+	volatile int32_t nextJob;
+} BlockWork;
+
+static void DecodeBlockRows( const BlockWork *work, const BlockJob *job ) {
+	const BlockLevel *level = job->level;
+	unsigned int blocksWide = ( level->width + 3 ) / 4;
+	size_t stride = ( size_t ) level->width * 4;
+
+	const uint8_t *block = level->src + ( size_t ) job->firstRow * blocksWide * work->blockSize;
+	for ( unsigned int by = job->firstRow; by < job->firstRow + job->numRows; ++by ) {
+		unsigned int y = by * 4;
+		for ( unsigned int bx = 0; bx < blocksWide; ++bx, block += work->blockSize ) {
+			unsigned int x = bx * 4;
+			uint8_t *dst = level->dst + y * stride + x * 4;
+			if ( x + 4 <= level->width && y + 4 <= level->height ) {
+				work->decode( block, dst, stride );
+				continue;
+			}
+
+			/* partial block on the edge of the image, so only copy out what's visible */
+			uint8_t pixels[ 4 * 4 * 4 ];
+			work->decode( block, pixels, 16 );
+
+			unsigned int w = ( level->width - x < 4 ) ? level->width - x : 4;
+			unsigned int h = ( level->height - y < 4 ) ? level->height - y : 4;
+			for ( unsigned int r = 0; r < h; ++r ) {
+				memcpy( dst + r * stride, pixels + r * 16, w * 4 );
+			}
+		}
+	}
+}
+
+static void EncodeBlockRows( const BlockWork *work, const BlockJob *job ) {
+	const BlockLevel *level = job->level;
+	unsigned int blocksWide = ( level->width + 3 ) / 4;
+	size_t stride = ( size_t ) level->width * 4;
+
+	uint8_t *block = level->dst + ( size_t ) job->firstRow * blocksWide * work->blockSize;
+	for ( unsigned int by = job->firstRow; by < job->firstRow + job->numRows; ++by ) {
+		unsigned int y = by * 4;
+		for ( unsigned int bx = 0; bx < blocksWide; ++bx, block += work->blockSize ) {
+			unsigned int x = bx * 4;
+
+			/* blocks hanging off the edge repeat the last row and column */
+			uint8_t pixels[ 16 ][ 4 ];
+			for ( unsigned int r = 0; r < 4; ++r ) {
+				unsigned int sy = ( y + r < level->height ) ? y + r : level->height - 1;
+				const uint8_t *src = level->src + sy * stride;
+				if ( x + 4 <= level->width ) {
+					memcpy( pixels[ r * 4 ], src + x * 4, 16 );
+					continue;
+				}
+
+				for ( unsigned int c = 0; c < 4; ++c ) {
+					unsigned int sx = ( x + c < level->width ) ? x + c : level->width - 1;
+					memcpy( pixels[ r * 4 + c ], src + sx * 4, 4 );
+				}
+			}
+
+			work->encode( ( const uint8_t( * )[ 4 ] ) pixels, block, &work->encodeOptions );
+		}
+	}
+}
+
+static int BlockWorkThread( void *userData ) {
+	BlockWork *work = userData;
+
+	int32_t job;
+	while ( ( job = PlAtomicFetchAdd32( &work->nextJob, 1 ) ) < work->numJobs ) {
+		work->ProcessRows( work, &work->jobs[ job ] );
+	}
+
+	return 0;
+}
+
+/**
+ * Splits the given levels up by rows of blocks and hands them out to the
+ * work's ProcessRows; large chains are spread across several threads.
+ */
+static bool RunBlockWork( BlockWork *work, const BlockLevel *levels, unsigned int numLevels ) {
+	unsigned int numJobs = 0;
+	size_t numPixels = 0;
+	for ( unsigned int l = 0; l < numLevels; ++l ) {
+		numJobs += ( ( levels[ l ].height + 3 ) / 4 + BC_THREAD_JOB_ROWS - 1 ) / BC_THREAD_JOB_ROWS;
+		numPixels += ( size_t ) levels[ l ].width * levels[ l ].height;
+	}
+
+	BlockJob *jobs = pl_calloc( numJobs, sizeof( BlockJob ) );
+	if ( jobs == NULL ) {
+		return false;
+	}
+
+	unsigned int j = 0;
+	for ( unsigned int l = 0; l < numLevels; ++l ) {
+		unsigned int blocksHigh = ( levels[ l ].height + 3 ) / 4;
+		for ( unsigned int row = 0; row < blocksHigh; row += BC_THREAD_JOB_ROWS ) {
+			jobs[ j ].level = &levels[ l ];
+			jobs[ j ].firstRow = row;
+			jobs[ j ].numRows = ( blocksHigh - row < BC_THREAD_JOB_ROWS ) ? blocksHigh - row : BC_THREAD_JOB_ROWS;
+			j++;
+		}
+	}
+
+	work->jobs = jobs;
+	work->numJobs = ( int32_t ) numJobs;
+	work->nextJob = 0;
+
+	PLThread *threads[ BC_MAX_THREADS ];
+	unsigned int numThreads = 0;
+	if ( numPixels >= BC_THREAD_MIN_PIXELS ) {
+		/* the calling thread pitches in too */
+		unsigned int maxThreads = PlGetNumProcessors();
+		if ( maxThreads > numJobs ) {
+			maxThreads = numJobs;
+		}
+		if ( maxThreads > BC_MAX_THREADS ) {
+			maxThreads = BC_MAX_THREADS;
+		}
+		for ( ; numThreads + 1 < maxThreads; ++numThreads ) {
+			if ( ( threads[ numThreads ] = PlCreateThread( BlockWorkThread, work ) ) == NULL ) {
+				break;
+			}
+		}
+	}
+
+	BlockWorkThread( work );
+
+	for ( unsigned int i = 0; i < numThreads; ++i ) {
+		PlJoinThread( threads[ i ] );
+	}
+
+	pl_free( jobs );
+
+	return true;
+}
+
+/**
+ * Allocates a buffer for each level of the chain, sized for the given
+ * format, and fills in the level descriptions used by the jobs.
+ */
+static uint8_t **AllocateBlockLevels( const PLImage *image, PLImageFormat format, BlockLevel *blockLevels ) {
+	uint8_t **levels = pl_calloc( image->levels, sizeof( uint8_t * ) );
+	if ( levels == NULL ) {
+		return NULL;
+	}
+
+	unsigned int lw = image->width;
+	unsigned int lh = image->height;
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		if ( ( levels[ l ] = pl_malloc( PlGetImageSize( format, lw, lh ) ) ) == NULL ) {
+			for ( unsigned int m = 0; m < l; ++m ) {
+				pl_free( levels[ m ] );
+			}
+			pl_free( levels );
+			return NULL;
+		}
+
+		blockLevels[ l ].width = lw;
+		blockLevels[ l ].height = lh;
+
+		lw = ( lw > 1 ) ? lw / 2 : 1;
+		lh = ( lh > 1 ) ? lh / 2 : 1;
+	}
+
+	return levels;
+}
+
+static uint8_t **ProcessBlockLevels( const PLImage *image, PLImageFormat dstFormat, BlockWork *work ) {
+	BlockLevel *blockLevels = pl_calloc( image->levels, sizeof( BlockLevel ) );
+	if ( blockLevels == NULL ) {
+		return NULL;
+	}
+
+	uint8_t **levels = AllocateBlockLevels( image, dstFormat, blockLevels );
+	if ( levels == NULL ) {
+		pl_free( blockLevels );
+		return NULL;
+	}
+
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		blockLevels[ l ].src = image->data[ l ];
+		blockLevels[ l ].dst = levels[ l ];
+	}
+
+	if ( !RunBlockWork( work, blockLevels, image->levels ) ) {
+		for ( unsigned int l = 0; l < image->levels; ++l ) {
+			pl_free( levels[ l ] );
+		}
+		pl_free( levels );
+		levels = NULL;
+	}
+
+	pl_free( blockLevels );
+
+	return levels;
+}
+
+/**
+ * Decodes every level of a block compressed image into newly allocated
+ * RGBA8 buffers. Large images are split up by rows of blocks and the
+ * whole chain is decoded across several threads.
+ */
+uint8_t **_plDecodeBlockCompressedLevels( const PLImage *image ) {
+	const BlockFormatInfo *info = GetBlockFormatInfo( image->format );
+	if ( info == NULL ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported compressed image format" );
+		return NULL;
+	}
+
+	BlockWork work = {
+	        .ProcessRows = DecodeBlockRows,
+	        .decode = PL_SELECT_SIMD_KERNEL( info->decode, PlGetSimdLevel() ),
+	        .blockSize = info->blockSize,
+	};
+
+	return ProcessBlockLevels( image, PL_IMAGEFORMAT_RGBA8, &work );
+}
+
+/**
+ * Encodes every level of an RGBA8 image into newly allocated buffers
+ * of the given block compressed format, in the same way as above.
+ */
+uint8_t **_plEncodeBlockCompressedLevels( const PLImage *image, PLImageFormat format, PLImageCompressionQuality quality ) {
+	const BlockFormatInfo *info = GetBlockFormatInfo( format );
+	if ( info == NULL || image->format != PL_IMAGEFORMAT_RGBA8 ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported compressed image format" );
+		return NULL;
+	}
+
+	BlockWork work = {
+	        .ProcessRows = EncodeBlockRows,
+	        .encode = info->encode,
+	        .blockSize = info->blockSize,
+	};
+	GetBlockEncodeOptions( quality, &work.encodeOptions );
+
+	return ProcessBlockLevels( image, format, &work );
+}
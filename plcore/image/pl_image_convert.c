@@ -0,0 +1,834 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "image_private.h"
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <emmintrin.h>
+#	include <immintrin.h>
+#endif
+
+/* Conversion between the uncompressed pixel formats.
+ *
+ * Everything goes via RGBA8, unless the destination holds more than
+ * eight bits per channel in which case it goes via floating point instead.
+ * The conversions to and from RGBA8 are the hot paths, so those are
+ * where the SSE2/AVX2 kernels live.
+ *
+ * The 16-bit packed formats are stored big-endian with red in the
+ * highest bits (i.e. RGB5A1 is RRRRRGGG GGBBBBBA), RGBA12 is a big-endian
+ * 48-bit word and RGBA16/RGBA16F are four native 16-bit values. */
+
+#define CONVERT_BLOCK_PIXELS 512
+
+typedef struct PixelFormatInfo PixelFormatInfo;
+
+typedef void ( *PixelKernel )( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels );
+typedef void ( *FloatKernel )( const uint8_t *src, float *dst, size_t numPixels );
+typedef void ( *FloatPackKernel )( const float *src, uint8_t *dst, size_t numPixels );
+
+struct PixelFormatInfo {
+	unsigned int bytesPerPixel;
+	bool hasAlpha;
+	/* packed 16-bit formats only, zero bits means the channel isn't stored */
+	uint8_t shift[ 4 ];
+	uint8_t bits[ 4 ];
+	/* indexed by PLSimdLevel, falling back to the level below if NULL */
+	PixelKernel toRGBA8[ PL_SIMD_LEVEL_AVX2 + 1 ];
+	PixelKernel fromRGBA8[ PL_SIMD_LEVEL_AVX2 + 1 ];
+	/* only provided for formats with more than eight bits per channel */
+	FloatKernel toFloat[ PL_SIMD_LEVEL_AVX2 + 1 ];
+	FloatPackKernel fromFloat[ PL_SIMD_LEVEL_AVX2 + 1 ];
+};
+
+/* exact floor( t / 255 ) for t < 65535 */
+#define DIV255( T ) ( ( ( T ) + 1 + ( ( T ) >> 8 ) ) >> 8 )
+
+/* rounds an 8-bit channel down to a channel with the given maximum */
+static inline unsigned int Reduce8( unsigned int v, unsigned int max ) {
+	unsigned int t = v * max + 127;
+	return DIV255( t );
+}
+
+static inline unsigned int Expand8( unsigned int v, unsigned int bits ) {
+	if ( bits == 1 ) {
+		return v * 255;
+	}
+
+	return ( v << ( 8 - bits ) ) | ( v >> ( 2 * bits - 8 ) );
+}
+
+static inline float ClampUnit( float f ) {
+	if ( !( f > 0.0f ) ) {
+		return 0.0f; /* also catches NaN */
+	} else if ( f > 1.0f ) {
+		return 1.0f;
+	}
+
+	return f;
+}
+
+/* half conversions after Fabian Giesen's, which keep the branches to a minimum */
+
+static float HalfToFloat( uint16_t h ) {
+	static const uint32_t shiftedExponent = 0x7c00 << 13;
+	union {
+		uint32_t u;
+		float f;
+	} o, magic = { 113 << 23 };
+
+	o.u = ( uint32_t ) ( h & 0x7fff ) << 13;
+	uint32_t exponent = o.u & shiftedExponent;
+	o.u += ( 127 - 15 ) << 23;
+	if ( exponent == shiftedExponent ) {
+		o.u += ( 128 - 16 ) << 23; /* inf or NaN */
+	} else if ( exponent == 0 ) {
+		o.u += 1 << 23; /* subnormal, let the FPU renormalise it */
+		o.f -= magic.f;
+	}
+
+	o.u |= ( uint32_t ) ( h & 0x8000 ) << 16;
+	return o.f;
+}
+
+/* rounds to nearest even */
+static uint16_t FloatToHalf( float f ) {
+	union {
+		uint32_t u;
+		float f;
+	} v = { .f = f }, denormMagic = { ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23 };
+
+	uint32_t sign = v.u & 0x80000000;
+	v.u ^= sign;
+
+	uint16_t o;
+	if ( v.u >= ( 127 + 16 ) << 23 ) {
+		o = ( v.u > 0x7f800000 ) ? 0x7e00 : 0x7c00;
+	} else if ( v.u < ( 113 << 23 ) ) {
+		v.f += denormMagic.f;
+		o = ( uint16_t ) ( v.u - denormMagic.u );
+	} else {
+		uint32_t mantissaOdd = ( v.u >> 13 ) & 1;
+		v.u += ( ( uint32_t ) ( 15 - 127 ) << 23 ) + 0xfff + mantissaOdd;
+		o = ( uint16_t ) ( v.u >> 13 );
+	}
+
+	return ( uint16_t ) ( o | ( sign >> 16 ) );
+}
+
+/****************************************
+ * Scalar
+ ****************************************/
+
+static void CopyRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	memcpy( dst, src, numPixels * 4 );
+}
+
+static void RGB8toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 3, dst += 4 ) {
+		dst[ 0 ] = src[ 0 ];
+		dst[ 1 ] = src[ 1 ];
+		dst[ 2 ] = src[ 2 ];
+		dst[ 3 ] = 255;
+	}
+}
+
+static void RGBA8toRGB8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 4, dst += 3 ) {
+		dst[ 0 ] = src[ 0 ];
+		dst[ 1 ] = src[ 1 ];
+		dst[ 2 ] = src[ 2 ];
+	}
+}
+
+static void Packed16toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 2, dst += 4 ) {
+		unsigned int p = ( src[ 0 ] << 8 ) | src[ 1 ];
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			if ( format->bits[ c ] == 0 ) {
+				dst[ c ] = 255;
+				continue;
+			}
+
+			unsigned int v = ( p >> format->shift[ c ] ) & ( ( 1u << format->bits[ c ] ) - 1 );
+			dst[ c ] = ( uint8_t ) Expand8( v, format->bits[ c ] );
+		}
+	}
+}
+
+static void RGBA8toPacked16( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 4, dst += 2 ) {
+		unsigned int p = 0;
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			if ( format->bits[ c ] != 0 ) {
+				p |= Reduce8( src[ c ], ( 1u << format->bits[ c ] ) - 1 ) << format->shift[ c ];
+			}
+		}
+
+		dst[ 0 ] = ( uint8_t ) ( p >> 8 );
+		dst[ 1 ] = ( uint8_t ) p;
+	}
+}
+
+static inline void UnpackRGBA12( const uint8_t *src, unsigned int *v ) {
+	v[ 0 ] = ( src[ 0 ] << 4 ) | ( src[ 1 ] >> 4 );
+	v[ 1 ] = ( ( src[ 1 ] & 15 ) << 8 ) | src[ 2 ];
+	v[ 2 ] = ( src[ 3 ] << 4 ) | ( src[ 4 ] >> 4 );
+	v[ 3 ] = ( ( src[ 4 ] & 15 ) << 8 ) | src[ 5 ];
+}
+
+static inline void PackRGBA12( const unsigned int *v, uint8_t *dst ) {
+	dst[ 0 ] = ( uint8_t ) ( v[ 0 ] >> 4 );
+	dst[ 1 ] = ( uint8_t ) ( ( ( v[ 0 ] & 15 ) << 4 ) | ( v[ 1 ] >> 8 ) );
+	dst[ 2 ] = ( uint8_t ) v[ 1 ];
+	dst[ 3 ] = ( uint8_t ) ( v[ 2 ] >> 4 );
+	dst[ 4 ] = ( uint8_t ) ( ( ( v[ 2 ] & 15 ) << 4 ) | ( v[ 3 ] >> 8 ) );
+	dst[ 5 ] = ( uint8_t ) v[ 3 ];
+}
+
+static void RGBA12toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 6, dst += 4 ) {
+		unsigned int v[ 4 ];
+		UnpackRGBA12( src, v );
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			/* exact ( t / 4095 ), as is the reverse below */
+			unsigned int t = v[ c ] * 255 + 2047;
+			dst[ c ] = ( uint8_t ) ( ( t + ( t >> 12 ) + 1 ) >> 12 );
+		}
+	}
+}
+
+static void RGBA8toRGBA12( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 4, dst += 6 ) {
+		unsigned int v[ 4 ];
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			v[ c ] = ( src[ c ] * 4111 + 135 ) >> 8;
+		}
+		PackRGBA12( v, dst );
+	}
+}
+
+static void RGBA12toFloat( const uint8_t *src, float *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 6, dst += 4 ) {
+		unsigned int v[ 4 ];
+		UnpackRGBA12( src, v );
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			dst[ c ] = ( float ) v[ c ] / 4095.0f;
+		}
+	}
+}
+
+static void FloatToRGBA12( const float *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, src += 4, dst += 6 ) {
+		unsigned int v[ 4 ];
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			v[ c ] = ( unsigned int ) ( ClampUnit( src[ c ] ) * 4095.0f + 0.5f );
+		}
+		PackRGBA12( v, dst );
+	}
+}
+
+static void RGBA16toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const uint16_t *s = ( const uint16_t * ) src;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		dst[ i ] = ( uint8_t ) ( ( s[ i ] * 255u + 32895u ) >> 16 );
+	}
+}
+
+static void RGBA8toRGBA16( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	uint16_t *d = ( uint16_t * ) dst;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		d[ i ] = ( uint16_t ) ( src[ i ] * 257 );
+	}
+}
+
+static void RGBA16toFloat( const uint8_t *src, float *dst, size_t numPixels ) {
+	const uint16_t *s = ( const uint16_t * ) src;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		dst[ i ] = ( float ) s[ i ] / 65535.0f;
+	}
+}
+
+static void FloatToRGBA16( const float *src, uint8_t *dst, size_t numPixels ) {
+	uint16_t *d = ( uint16_t * ) dst;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		d[ i ] = ( uint16_t ) ( ClampUnit( src[ i ] ) * 65535.0f + 0.5f );
+	}
+}
+
+static void RGBA16FtoRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const uint16_t *s = ( const uint16_t * ) src;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		dst[ i ] = ( uint8_t ) ( ClampUnit( HalfToFloat( s[ i ] ) ) * 255.0f + 0.5f );
+	}
+}
+
+static void RGBA8toRGBA16F( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	uint16_t *d = ( uint16_t * ) dst;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		d[ i ] = FloatToHalf( ( float ) src[ i ] / 255.0f );
+	}
+}
+
+static void RGBA16FtoFloat( const uint8_t *src, float *dst, size_t numPixels ) {
+	const uint16_t *s = ( const uint16_t * ) src;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		dst[ i ] = HalfToFloat( s[ i ] );
+	}
+}
+
+static void FloatToRGBA16F( const float *src, uint8_t *dst, size_t numPixels ) {
+	uint16_t *d = ( uint16_t * ) dst;
+	for ( size_t i = 0; i < numPixels * 4; ++i ) {
+		d[ i ] = FloatToHalf( src[ i ] );
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+/****************************************
+ * SSE2
+ ****************************************/
+
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2SwapBytes16( __m128i v ) {
+	return _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+}
+
+/* channel value 0-255 from 16-bit packed, ready for Sse2StoreRGBA8 */
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2UnpackChannel( __m128i p, unsigned int shift, unsigned int bits ) {
+	if ( bits == 0 ) {
+		return _mm_set1_epi16( 255 );
+	}
+
+	__m128i v = _mm_and_si128( _mm_srl_epi16( p, _mm_cvtsi32_si128( ( int ) shift ) ), _mm_set1_epi16( ( short ) ( ( 1 << bits ) - 1 ) ) );
+	if ( bits == 1 ) {
+		return _mm_srli_epi16( _mm_sub_epi16( _mm_setzero_si128(), v ), 8 );
+	}
+
+	return _mm_or_si128( _mm_sll_epi16( v, _mm_cvtsi32_si128( ( int ) ( 8 - bits ) ) ),
+	                     _mm_srl_epi16( v, _mm_cvtsi32_si128( ( int ) ( 2 * bits - 8 ) ) ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2PackChannel( __m128i v, unsigned int shift, unsigned int bits ) {
+	if ( bits == 0 ) {
+		return _mm_setzero_si128();
+	}
+
+	__m128i t = _mm_add_epi16( _mm_mullo_epi16( v, _mm_set1_epi16( ( short ) ( ( 1 << bits ) - 1 ) ) ), _mm_set1_epi16( 127 ) );
+	t = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( t, _mm_set1_epi16( 1 ) ), _mm_srli_epi16( t, 8 ) ), 8 );
+	return _mm_sll_epi16( t, _mm_cvtsi32_si128( ( int ) shift ) );
+}
+
+/* interleaves 16-bit channel values into eight RGBA8 pixels */
+PL_TARGET_ISA( "sse2" )
+static inline void Sse2StoreRGBA8( uint8_t *dst, __m128i r, __m128i g, __m128i b, __m128i a ) {
+	__m128i rg = _mm_or_si128( r, _mm_slli_epi16( g, 8 ) );
+	__m128i ba = _mm_or_si128( b, _mm_slli_epi16( a, 8 ) );
+	_mm_storeu_si128( ( __m128i * ) dst, _mm_unpacklo_epi16( rg, ba ) );
+	_mm_storeu_si128( ( __m128i * ) ( dst + 16 ), _mm_unpackhi_epi16( rg, ba ) );
+}
+
+/* splits eight RGBA8 pixels into 16-bit channel values */
+PL_TARGET_ISA( "sse2" )
+static inline void Sse2LoadRGBA8( const uint8_t *src, __m128i *channels ) {
+	__m128i lo = _mm_loadu_si128( ( const __m128i * ) src );
+	__m128i hi = _mm_loadu_si128( ( const __m128i * ) ( src + 16 ) );
+	__m128i mask = _mm_set1_epi32( 0xff );
+	channels[ 0 ] = _mm_packs_epi32( _mm_and_si128( lo, mask ), _mm_and_si128( hi, mask ) );
+	channels[ 1 ] = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( lo, 8 ), mask ), _mm_and_si128( _mm_srli_epi32( hi, 8 ), mask ) );
+	channels[ 2 ] = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( lo, 16 ), mask ), _mm_and_si128( _mm_srli_epi32( hi, 16 ), mask ) );
+	channels[ 3 ] = _mm_packs_epi32( _mm_srli_epi32( lo, 24 ), _mm_srli_epi32( hi, 24 ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2Packed16toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 8 <= numPixels; i += 8, src += 16, dst += 32 ) {
+		__m128i p = Sse2SwapBytes16( _mm_loadu_si128( ( const __m128i * ) src ) );
+		Sse2StoreRGBA8( dst,
+		                Sse2UnpackChannel( p, format->shift[ 0 ], format->bits[ 0 ] ),
+		                Sse2UnpackChannel( p, format->shift[ 1 ], format->bits[ 1 ] ),
+		                Sse2UnpackChannel( p, format->shift[ 2 ], format->bits[ 2 ] ),
+		                Sse2UnpackChannel( p, format->shift[ 3 ], format->bits[ 3 ] ) );
+	}
+
+	Packed16toRGBA8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2RGBA8toPacked16( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 8 <= numPixels; i += 8, src += 32, dst += 16 ) {
+		__m128i c[ 4 ];
+		Sse2LoadRGBA8( src, c );
+		__m128i p = _mm_or_si128( _mm_or_si128( Sse2PackChannel( c[ 0 ], format->shift[ 0 ], format->bits[ 0 ] ),
+		                                        Sse2PackChannel( c[ 1 ], format->shift[ 1 ], format->bits[ 1 ] ) ),
+		                          _mm_or_si128( Sse2PackChannel( c[ 2 ], format->shift[ 2 ], format->bits[ 2 ] ),
+		                                        Sse2PackChannel( c[ 3 ], format->shift[ 3 ], format->bits[ 3 ] ) ) );
+		_mm_storeu_si128( ( __m128i * ) dst, Sse2SwapBytes16( p ) );
+	}
+
+	RGBA8toPacked16( format, src, dst, numPixels - i );
+}
+
+/* exact ( v * 255 + 32895 ) >> 16, the add saturating is intended */
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2Reduce16( __m128i v ) {
+	__m128i t = _mm_adds_epu16( v, _mm_set1_epi16( 128 ) );
+	return _mm_srli_epi16( _mm_sub_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2RGBA16toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 4 <= numPixels; i += 4, src += 32, dst += 16 ) {
+		__m128i lo = Sse2Reduce16( _mm_loadu_si128( ( const __m128i * ) src ) );
+		__m128i hi = Sse2Reduce16( _mm_loadu_si128( ( const __m128i * ) ( src + 16 ) ) );
+		_mm_storeu_si128( ( __m128i * ) dst, _mm_packus_epi16( lo, hi ) );
+	}
+
+	RGBA16toRGBA8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2RGBA8toRGBA16( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 4 <= numPixels; i += 4, src += 16, dst += 32 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) src );
+		_mm_storeu_si128( ( __m128i * ) dst, _mm_unpacklo_epi8( v, v ) );
+		_mm_storeu_si128( ( __m128i * ) ( dst + 16 ), _mm_unpackhi_epi8( v, v ) );
+	}
+
+	RGBA8toRGBA16( format, src, dst, numPixels - i );
+}
+
+/* vector forms of HalfToFloat/FloatToHalf, on halves held in 32-bit lanes */
+
+PL_TARGET_ISA( "sse2" )
+static inline __m128 Sse2HalfToFloat( __m128i h ) {
+	__m128i expmant = _mm_and_si128( h, _mm_set1_epi32( 0x7fff ) );
+	__m128i sign = _mm_slli_epi32( _mm_xor_si128( h, expmant ), 16 );
+
+	__m128i o = _mm_add_epi32( _mm_slli_epi32( expmant, 13 ), _mm_set1_epi32( ( 127 - 15 ) << 23 ) );
+	__m128i isInfNan = _mm_cmpgt_epi32( expmant, _mm_set1_epi32( 0x7bff ) );
+	o = _mm_add_epi32( o, _mm_and_si128( isInfNan, _mm_set1_epi32( ( 128 - 16 ) << 23 ) ) );
+
+	/* renormalise subnormals without ever handing the FPU a denormal */
+	__m128i isSubnormal = _mm_cmpgt_epi32( _mm_set1_epi32( 0x400 ), expmant );
+	__m128 subnormal = _mm_sub_ps( _mm_castsi128_ps( _mm_add_epi32( o, _mm_set1_epi32( 1 << 23 ) ) ), _mm_castsi128_ps( _mm_set1_epi32( 113 << 23 ) ) );
+	o = _mm_or_si128( _mm_and_si128( isSubnormal, _mm_castps_si128( subnormal ) ), _mm_andnot_si128( isSubnormal, o ) );
+
+	return _mm_castsi128_ps( _mm_or_si128( o, sign ) );
+}
+
+/* the result is sign extended, so _mm_packs_epi32 gives the right 16 bits */
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2FloatToHalf( __m128 f ) {
+	const __m128i subnormalMagic = _mm_set1_epi32( ( ( 127 - 15 ) + ( 23 - 10 ) + 1 ) << 23 );
+
+	__m128i justSign = _mm_and_si128( _mm_castps_si128( f ), _mm_set1_epi32( ( int ) 0x80000000 ) );
+	__m128 absf = _mm_castsi128_ps( _mm_xor_si128( _mm_castps_si128( f ), justSign ) );
+	__m128i absi = _mm_castps_si128( absf );
+
+	__m128i isNan = _mm_castps_si128( _mm_cmpunord_ps( absf, absf ) );
+	__m128i isRegular = _mm_cmpgt_epi32( _mm_set1_epi32( ( 127 + 16 ) << 23 ), absi );
+	__m128i infOrNan = _mm_or_si128( _mm_and_si128( isNan, _mm_set1_epi32( 0x200 ) ), _mm_set1_epi32( 0x7c00 ) );
+	__m128i isSubnormal = _mm_cmpgt_epi32( _mm_set1_epi32( 113 << 23 ), absi );
+
+	__m128i subnormal = _mm_sub_epi32( _mm_castps_si128( _mm_add_ps( absf, _mm_castsi128_ps( subnormalMagic ) ) ), subnormalMagic );
+
+	/* round to nearest even */
+	__m128i mantissaOdd = _mm_srai_epi32( _mm_slli_epi32( absi, 31 - 13 ), 31 );
+	__m128i normal = _mm_add_epi32( absi, _mm_set1_epi32( 0xfff - ( ( 127 - 15 ) << 23 ) ) );
+	normal = _mm_srli_epi32( _mm_sub_epi32( normal, mantissaOdd ), 13 );
+
+	__m128i result = _mm_or_si128( _mm_and_si128( isSubnormal, subnormal ), _mm_andnot_si128( isSubnormal, normal ) );
+	result = _mm_or_si128( _mm_and_si128( isRegular, result ), _mm_andnot_si128( isRegular, infOrNan ) );
+	return _mm_or_si128( result, _mm_srai_epi32( justSign, 16 ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2HalfUnitToByte( __m128i h ) {
+	/* max returns the second operand for NaN, matching ClampUnit */
+	__m128 f = _mm_min_ps( _mm_max_ps( Sse2HalfToFloat( h ), _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+	return _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( f, _mm_set1_ps( 255.0f ) ), _mm_set1_ps( 0.5f ) ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2RGBA16FtoRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 4 <= numPixels; i += 4, src += 32, dst += 16 ) {
+		__m128i lo = _mm_loadu_si128( ( const __m128i * ) src );
+		__m128i hi = _mm_loadu_si128( ( const __m128i * ) ( src + 16 ) );
+		__m128i a = _mm_packs_epi32( Sse2HalfUnitToByte( _mm_unpacklo_epi16( lo, _mm_setzero_si128() ) ),
+		                             Sse2HalfUnitToByte( _mm_unpackhi_epi16( lo, _mm_setzero_si128() ) ) );
+		__m128i b = _mm_packs_epi32( Sse2HalfUnitToByte( _mm_unpacklo_epi16( hi, _mm_setzero_si128() ) ),
+		                             Sse2HalfUnitToByte( _mm_unpackhi_epi16( hi, _mm_setzero_si128() ) ) );
+		_mm_storeu_si128( ( __m128i * ) dst, _mm_packus_epi16( a, b ) );
+	}
+
+	RGBA16FtoRGBA8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2RGBA8toRGBA16F( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const __m128 scale = _mm_set1_ps( 255.0f );
+	size_t i = 0;
+	for ( ; i + 4 <= numPixels; i += 4, src += 16, dst += 32 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) src );
+		__m128i lo = _mm_unpacklo_epi8( v, _mm_setzero_si128() );
+		__m128i hi = _mm_unpackhi_epi8( v, _mm_setzero_si128() );
+		__m128i h[ 4 ];
+		h[ 0 ] = Sse2FloatToHalf( _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, _mm_setzero_si128() ) ), scale ) );
+		h[ 1 ] = Sse2FloatToHalf( _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, _mm_setzero_si128() ) ), scale ) );
+		h[ 2 ] = Sse2FloatToHalf( _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, _mm_setzero_si128() ) ), scale ) );
+		h[ 3 ] = Sse2FloatToHalf( _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, _mm_setzero_si128() ) ), scale ) );
+		_mm_storeu_si128( ( __m128i * ) dst, _mm_packs_epi32( h[ 0 ], h[ 1 ] ) );
+		_mm_storeu_si128( ( __m128i * ) ( dst + 16 ), _mm_packs_epi32( h[ 2 ], h[ 3 ] ) );
+	}
+
+	RGBA8toRGBA16F( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2RGBA16FtoFloat( const uint8_t *src, float *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 2 <= numPixels; i += 2, src += 16, dst += 8 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) src );
+		_mm_storeu_ps( dst, Sse2HalfToFloat( _mm_unpacklo_epi16( v, _mm_setzero_si128() ) ) );
+		_mm_storeu_ps( dst + 4, Sse2HalfToFloat( _mm_unpackhi_epi16( v, _mm_setzero_si128() ) ) );
+	}
+
+	RGBA16FtoFloat( src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void Sse2FloatToRGBA16F( const float *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 2 <= numPixels; i += 2, src += 8, dst += 16 ) {
+		__m128i lo = Sse2FloatToHalf( _mm_loadu_ps( src ) );
+		__m128i hi = Sse2FloatToHalf( _mm_loadu_ps( src + 4 ) );
+		_mm_storeu_si128( ( __m128i * ) dst, _mm_packs_epi32( lo, hi ) );
+	}
+
+	FloatToRGBA16F( src, dst, numPixels - i );
+}
+
+/****************************************
+ * AVX2
+ ****************************************/
+
+PL_TARGET_ISA( "avx2" )
+static inline __m256i Avx2UnpackChannel( __m256i p, unsigned int shift, unsigned int bits ) {
+	if ( bits == 0 ) {
+		return _mm256_set1_epi16( 255 );
+	}
+
+	__m256i v = _mm256_and_si256( _mm256_srl_epi16( p, _mm_cvtsi32_si128( ( int ) shift ) ), _mm256_set1_epi16( ( short ) ( ( 1 << bits ) - 1 ) ) );
+	if ( bits == 1 ) {
+		return _mm256_srli_epi16( _mm256_sub_epi16( _mm256_setzero_si256(), v ), 8 );
+	}
+
+	return _mm256_or_si256( _mm256_sll_epi16( v, _mm_cvtsi32_si128( ( int ) ( 8 - bits ) ) ),
+	                        _mm256_srl_epi16( v, _mm_cvtsi32_si128( ( int ) ( 2 * bits - 8 ) ) ) );
+}
+
+PL_TARGET_ISA( "avx2" )
+static inline __m256i Avx2PackChannel( __m256i v, unsigned int shift, unsigned int bits ) {
+	if ( bits == 0 ) {
+		return _mm256_setzero_si256();
+	}
+
+	__m256i t = _mm256_add_epi16( _mm256_mullo_epi16( v, _mm256_set1_epi16( ( short ) ( ( 1 << bits ) - 1 ) ) ), _mm256_set1_epi16( 127 ) );
+	t = _mm256_srli_epi16( _mm256_add_epi16( _mm256_add_epi16( t, _mm256_set1_epi16( 1 ) ), _mm256_srli_epi16( t, 8 ) ), 8 );
+	return _mm256_sll_epi16( t, _mm_cvtsi32_si128( ( int ) shift ) );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Avx2Packed16toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const __m256i swap = _mm256_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+	                                       1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+	size_t i = 0;
+	for ( ; i + 16 <= numPixels; i += 16, src += 32, dst += 64 ) {
+		__m256i p = _mm256_shuffle_epi8( _mm256_loadu_si256( ( const __m256i * ) src ), swap );
+		__m256i rg = _mm256_or_si256( Avx2UnpackChannel( p, format->shift[ 0 ], format->bits[ 0 ] ),
+		                              _mm256_slli_epi16( Avx2UnpackChannel( p, format->shift[ 1 ], format->bits[ 1 ] ), 8 ) );
+		__m256i ba = _mm256_or_si256( Avx2UnpackChannel( p, format->shift[ 2 ], format->bits[ 2 ] ),
+		                              _mm256_slli_epi16( Avx2UnpackChannel( p, format->shift[ 3 ], format->bits[ 3 ] ), 8 ) );
+		/* unpacking works per 128-bit lane, so put the halves back in order */
+		__m256i lo = _mm256_unpacklo_epi16( rg, ba );
+		__m256i hi = _mm256_unpackhi_epi16( rg, ba );
+		_mm256_storeu_si256( ( __m256i * ) dst, _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + 32 ), _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+	}
+
+	Packed16toRGBA8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Avx2RGBA8toPacked16( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const __m256i swap = _mm256_setr_epi8( 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+	                                       1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+	const __m256i mask = _mm256_set1_epi32( 0xff );
+	size_t i = 0;
+	for ( ; i + 16 <= numPixels; i += 16, src += 64, dst += 32 ) {
+		__m256i lo = _mm256_loadu_si256( ( const __m256i * ) src );
+		__m256i hi = _mm256_loadu_si256( ( const __m256i * ) ( src + 32 ) );
+		__m256i p = _mm256_setzero_si256();
+		for ( unsigned int c = 0; c < 4; ++c ) {
+			__m256i v = _mm256_packs_epi32( _mm256_and_si256( _mm256_srli_epi32( lo, ( int ) ( c * 8 ) ), mask ),
+			                                _mm256_and_si256( _mm256_srli_epi32( hi, ( int ) ( c * 8 ) ), mask ) );
+			p = _mm256_or_si256( p, Avx2PackChannel( v, format->shift[ c ], format->bits[ c ] ) );
+		}
+		/* packing interleaved the lanes, so restore the pixel order */
+		p = _mm256_permute4x64_epi64( p, 0xd8 );
+		_mm256_storeu_si256( ( __m256i * ) dst, _mm256_shuffle_epi8( p, swap ) );
+	}
+
+	RGBA8toPacked16( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Avx2RGB8toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const __m256i shuffle = _mm256_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+	                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+	const __m256i alpha = _mm256_set1_epi32( ( int ) 0xff000000 );
+	size_t i = 0;
+	/* the second load reads four bytes beyond the eight pixels, hence the margin */
+	for ( ; i + 10 <= numPixels; i += 8, src += 24, dst += 32 ) {
+		__m256i v = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( ( const __m128i * ) src ) ),
+		                                     _mm_loadu_si128( ( const __m128i * ) ( src + 12 ) ), 1 );
+		_mm256_storeu_si256( ( __m256i * ) dst, _mm256_or_si256( _mm256_shuffle_epi8( v, shuffle ), alpha ) );
+	}
+
+	RGB8toRGBA8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Avx2RGBA8toRGB8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const __m256i shuffle = _mm256_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+	                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+	size_t i = 0;
+	/* each store writes four bytes of padding beyond its twelve, the next store covers them */
+	for ( ; i + 10 <= numPixels; i += 8, src += 32, dst += 24 ) {
+		__m256i v = _mm256_shuffle_epi8( _mm256_loadu_si256( ( const __m256i * ) src ), shuffle );
+		_mm_storeu_si128( ( __m128i * ) dst, _mm256_castsi256_si128( v ) );
+		_mm_storeu_si128( ( __m128i * ) ( dst + 12 ), _mm256_extracti128_si256( v, 1 ) );
+	}
+
+	RGBA8toRGB8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Avx2RGBA16toRGBA8( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 8 <= numPixels; i += 8, src += 64, dst += 32 ) {
+		__m256i lo = _mm256_loadu_si256( ( const __m256i * ) src );
+		__m256i hi = _mm256_loadu_si256( ( const __m256i * ) ( src + 32 ) );
+		lo = _mm256_adds_epu16( lo, _mm256_set1_epi16( 128 ) );
+		hi = _mm256_adds_epu16( hi, _mm256_set1_epi16( 128 ) );
+		lo = _mm256_srli_epi16( _mm256_sub_epi16( lo, _mm256_srli_epi16( lo, 8 ) ), 8 );
+		hi = _mm256_srli_epi16( _mm256_sub_epi16( hi, _mm256_srli_epi16( hi, 8 ) ), 8 );
+		_mm256_storeu_si256( ( __m256i * ) dst, _mm256_permute4x64_epi64( _mm256_packus_epi16( lo, hi ), 0xd8 ) );
+	}
+
+	RGBA16toRGBA8( format, src, dst, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Avx2RGBA8toRGBA16( const PixelFormatInfo *format, const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 4 <= numPixels; i += 4, src += 16, dst += 32 ) {
+		__m256i v = _mm256_cvtepu8_epi16( _mm_loadu_si128( ( const __m128i * ) src ) );
+		_mm256_storeu_si256( ( __m256i * ) dst, _mm256_or_si256( v, _mm256_slli_epi16( v, 8 ) ) );
+	}
+
+	RGBA8toRGBA16( format, src, dst, numPixels - i );
+}
+
+#	define SIMD_KERNELS( SSE2, AVX2 ) SSE2, AVX2
+#else
+#	define SIMD_KERNELS( SSE2, AVX2 ) NULL, NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+#define PACKED16_KERNELS \
+	.toRGBA8 = { Packed16toRGBA8, SIMD_KERNELS( Sse2Packed16toRGBA8, Avx2Packed16toRGBA8 ) }, \
+	.fromRGBA8 = { RGBA8toPacked16, SIMD_KERNELS( Sse2RGBA8toPacked16, Avx2RGBA8toPacked16 ) }
+
+static const PixelFormatInfo pixelFormats[] = {
+	[PL_IMAGEFORMAT_RGB4] = {
+		2, false, { 12, 8, 4, 0 }, { 4, 4, 4, 0 }, PACKED16_KERNELS },
+	[PL_IMAGEFORMAT_RGBA4] = {
+		2, true, { 12, 8, 4, 0 }, { 4, 4, 4, 4 }, PACKED16_KERNELS },
+	[PL_IMAGEFORMAT_RGB5] = {
+		2, false, { 11, 6, 1, 0 }, { 5, 5, 5, 0 }, PACKED16_KERNELS },
+	[PL_IMAGEFORMAT_RGB5A1] = {
+		2, true, { 11, 6, 1, 0 }, { 5, 5, 5, 1 }, PACKED16_KERNELS },
+	[PL_IMAGEFORMAT_RGB565] = {
+		2, false, { 11, 5, 0, 0 }, { 5, 6, 5, 0 }, PACKED16_KERNELS },
+	[PL_IMAGEFORMAT_RGB8] = {
+		3, false,
+		.toRGBA8 = { RGB8toRGBA8, SIMD_KERNELS( NULL, Avx2RGB8toRGBA8 ) },
+		.fromRGBA8 = { RGBA8toRGB8, SIMD_KERNELS( NULL, Avx2RGBA8toRGB8 ) } },
+	[PL_IMAGEFORMAT_RGBA8] = {
+		4, true,
+		.toRGBA8 = { CopyRGBA8 },
+		.fromRGBA8 = { CopyRGBA8 } },
+	[PL_IMAGEFORMAT_RGBA12] = {
+		6, true,
+		.toRGBA8 = { RGBA12toRGBA8 },
+		.fromRGBA8 = { RGBA8toRGBA12 },
+		.toFloat = { RGBA12toFloat },
+		.fromFloat = { FloatToRGBA12 } },
+	[PL_IMAGEFORMAT_RGBA16] = {
+		8, true,
+		.toRGBA8 = { RGBA16toRGBA8, SIMD_KERNELS( Sse2RGBA16toRGBA8, Avx2RGBA16toRGBA8 ) },
+		.fromRGBA8 = { RGBA8toRGBA16, SIMD_KERNELS( Sse2RGBA8toRGBA16, Avx2RGBA8toRGBA16 ) },
+		.toFloat = { RGBA16toFloat },
+		.fromFloat = { FloatToRGBA16 } },
+	[PL_IMAGEFORMAT_RGBA16F] = {
+		8, true,
+		.toRGBA8 = { RGBA16FtoRGBA8, SIMD_KERNELS( Sse2RGBA16FtoRGBA8, NULL ) },
+		.fromRGBA8 = { RGBA8toRGBA16F, SIMD_KERNELS( Sse2RGBA8toRGBA16F, NULL ) },
+		.toFloat = { RGBA16FtoFloat, SIMD_KERNELS( Sse2RGBA16FtoFloat, NULL ) },
+		.fromFloat = { FloatToRGBA16F, SIMD_KERNELS( Sse2FloatToRGBA16F, NULL ) } },
+};
+
+static const PixelFormatInfo *GetPixelFormatInfo( PLImageFormat format ) {
+	if ( format < 0 || format >= plArrayElements( pixelFormats ) || pixelFormats[ format ].bytesPerPixel == 0 ) {
+		return NULL;
+	}
+
+	return &pixelFormats[ format ];
+}
+
+bool _plIsPixelFormatConvertible( PLImageFormat format ) {
+	return ( GetPixelFormatInfo( format ) != NULL );
+}
+
+bool _plPixelFormatHasAlpha( PLImageFormat format ) {
+	const PixelFormatInfo *info = GetPixelFormatInfo( format );
+	return ( info != NULL && info->hasAlpha );
+}
+
+/**
+ * Converts a run of pixels between any two of the uncompressed formats.
+ * The source and destination must not overlap.
+ */
+bool PlConvertPixels( const uint8_t *src, PLImageFormat srcFormat, uint8_t *dst, PLImageFormat dstFormat, size_t numPixels ) {
+	const PixelFormatInfo *in = GetPixelFormatInfo( srcFormat );
+	const PixelFormatInfo *out = GetPixelFormatInfo( dstFormat );
+	if ( in == NULL || out == NULL ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format conversion" );
+		return false;
+	}
+
+	if ( srcFormat == dstFormat ) {
+		memcpy( dst, src, numPixels * in->bytesPerPixel );
+		return true;
+	}
+
+	PLSimdLevel level = PlGetSimdLevel();
+	PixelKernel unpack = PL_SELECT_SIMD_KERNEL( in->toRGBA8, level );
+	PixelKernel pack = PL_SELECT_SIMD_KERNEL( out->fromRGBA8, level );
+	if ( srcFormat == PL_IMAGEFORMAT_RGBA8 ) {
+		pack( out, src, dst, numPixels );
+		return true;
+	} else if ( dstFormat == PL_IMAGEFORMAT_RGBA8 ) {
+		unpack( in, src, dst, numPixels );
+		return true;
+	}
+
+	/* nothing beyond eight bits per channel to keep, so RGBA8 will do */
+	if ( in->toFloat[ 0 ] == NULL || out->fromFloat[ 0 ] == NULL ) {
+		uint8_t block[ CONVERT_BLOCK_PIXELS * 4 ];
+		for ( size_t i = 0; i < numPixels; i += CONVERT_BLOCK_PIXELS ) {
+			size_t n = ( numPixels - i < CONVERT_BLOCK_PIXELS ) ? numPixels - i : CONVERT_BLOCK_PIXELS;
+			unpack( in, src + i * in->bytesPerPixel, block, n );
+			pack( out, block, dst + i * out->bytesPerPixel, n );
+		}
+
+		return true;
+	}
+
+	/* otherwise go via floating point, so nothing is lost on the way */
+	FloatKernel toFloat = PL_SELECT_SIMD_KERNEL( in->toFloat, level );
+	FloatPackKernel fromFloat = PL_SELECT_SIMD_KERNEL( out->fromFloat, level );
+	float block[ CONVERT_BLOCK_PIXELS * 4 ];
+	for ( size_t i = 0; i < numPixels; i += CONVERT_BLOCK_PIXELS ) {
+		size_t n = ( numPixels - i < CONVERT_BLOCK_PIXELS ) ? numPixels - i : CONVERT_BLOCK_PIXELS;
+		toFloat( src + i * in->bytesPerPixel, block, n );
+		fromFloat( block, dst + i * out->bytesPerPixel, n );
+	}
+
+	return true;
+}
+
+/**
+ * Unpacks a run of pixels into normalised RGBA floats, for the filters
+ * which work in floating point regardless of the format.
+ */
+bool _plPixelsToFloat( const uint8_t *src, PLImageFormat format, float *dst, size_t numPixels ) {
+	const PixelFormatInfo *info = GetPixelFormatInfo( format );
+	if ( info == NULL ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format conversion" );
+		return false;
+	}
+
+	PLSimdLevel level = PlGetSimdLevel();
+	if ( info->toFloat[ 0 ] != NULL ) {
+		PL_SELECT_SIMD_KERNEL( info->toFloat, level )( src, dst, numPixels );
+		return true;
+	}
+
+	PixelKernel unpack = PL_SELECT_SIMD_KERNEL( info->toRGBA8, level );
+	uint8_t block[ CONVERT_BLOCK_PIXELS * 4 ];
+	for ( size_t i = 0; i < numPixels; i += CONVERT_BLOCK_PIXELS ) {
+		size_t n = ( numPixels - i < CONVERT_BLOCK_PIXELS ) ? numPixels - i : CONVERT_BLOCK_PIXELS;
+		unpack( info, src + i * info->bytesPerPixel, block, n );
+		for ( size_t j = 0; j < n * 4; ++j ) {
+			dst[ i * 4 + j ] = block[ j ] * ( 1.0f / 255.0f );
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Packs normalised RGBA floats back into the given format, clamping
+ * anything which has strayed outside of zero to one.
+ */
+bool _plFloatToPixels( const float *src, uint8_t *dst, PLImageFormat format, size_t numPixels ) {
+	const PixelFormatInfo *info = GetPixelFormatInfo( format );
+	if ( info == NULL ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported image format conversion" );
+		return false;
+	}
+
+	PLSimdLevel level = PlGetSimdLevel();
+	if ( info->fromFloat[ 0 ] != NULL ) {
+		PL_SELECT_SIMD_KERNEL( info->fromFloat, level )( src, dst, numPixels );
+		return true;
+	}
+
+	PixelKernel pack = PL_SELECT_SIMD_KERNEL( info->fromRGBA8, level );
+	uint8_t block[ CONVERT_BLOCK_PIXELS * 4 ];
+	for ( size_t i = 0; i < numPixels; i += CONVERT_BLOCK_PIXELS ) {
+		size_t n = ( numPixels - i < CONVERT_BLOCK_PIXELS ) ? numPixels - i : CONVERT_BLOCK_PIXELS;
+		for ( size_t j = 0; j < n * 4; ++j ) {
+			block[ j ] = ( uint8_t ) ( ClampUnit( src[ i * 4 + j ] ) * 255.0f + 0.5f );
+		}
+		pack( info, block, dst + i * info->bytesPerPixel, n );
+	}
+
+	return true;
+}
@@ -0,0 +1,436 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "image_private.h"
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Mipmap generation. Every level is filtered down from the one above it,
+ * either with a 2x2 box or a separable Kaiser windowed sinc, which keeps
+ * more of the detail at the cost of a little ringing. Filtering is done on
+ * float RGBA, other than plain box filtered RGBA8 which has an integer path.
+ *
+ * Pixels are addressed with clamped coordinates throughout, so odd sizes
+ * and levels which are only one pixel wide or high need no special casing. */
+
+#define MIPMAP_BLOCK_PIXELS     512
+#define MIPMAP_SRGB_TABLE_SIZE  8192
+
+#define MIPMAP_ALPHA_REFERENCE 0.5f /* what an alpha test is assumed to compare against */
+#define MIPMAP_COVERAGE_STEPS  12
+
+#define MIPMAP_KAISER_TAPS   6
+#define MIPMAP_KAISER_ALPHA  4.0
+#define MIPMAP_KAISER_RADIUS 1.5 /* in destination pixels */
+
+typedef void ( *BoxRowKernel )( const float *row0, const float *row1, float *dst, unsigned int srcWidth, unsigned int dstWidth );
+typedef void ( *BoxRowRGBA8Kernel )( const uint8_t *row0, const uint8_t *row1, uint8_t *dst, unsigned int srcWidth, unsigned int dstWidth );
+typedef void ( *KaiserRowKernel )( const float *src, float *dst, unsigned int srcWidth, unsigned int dstWidth, const float *weights );
+typedef void ( *KaiserColumnKernel )( const float *const *rows, float *dst, unsigned int width, const float *weights );
+
+static inline unsigned int ClampIndex( int i, unsigned int size ) {
+	return ( i < 0 ) ? 0 : ( ( ( unsigned int ) i >= size ) ? size - 1 : ( unsigned int ) i );
+}
+
+/* powf is far too slow to call per channel, so the transfer functions are
+ * looked up instead; interpolated, these stay well within 16-bit precision */
+typedef struct SrgbTables {
+	float toLinear[ MIPMAP_SRGB_TABLE_SIZE + 1 ];
+	float toSrgb[ MIPMAP_SRGB_TABLE_SIZE + 1 ];
+} SrgbTables;
+
+static void BuildSrgbTables( SrgbTables *tables ) {
+	for ( unsigned int i = 0; i <= MIPMAP_SRGB_TABLE_SIZE; ++i ) {
+		float c = ( float ) i / MIPMAP_SRGB_TABLE_SIZE;
+		tables->toLinear[ i ] = ( c <= 0.04045f ) ? c / 12.92f : powf( ( c + 0.055f ) / 1.055f, 2.4f );
+		tables->toSrgb[ i ] = ( c <= 0.0031308f ) ? c * 12.92f : 1.055f * powf( c, 1.0f / 2.4f ) - 0.055f;
+	}
+}
+
+static inline float LookupSrgbTable( const float *table, float c ) {
+	c = PlClamp( 0.0f, c, 1.0f ) * MIPMAP_SRGB_TABLE_SIZE;
+	unsigned int i = ( unsigned int ) c;
+	if ( i >= MIPMAP_SRGB_TABLE_SIZE ) {
+		i = MIPMAP_SRGB_TABLE_SIZE - 1;
+	}
+
+	return table[ i ] + ( table[ i + 1 ] - table[ i ] ) * ( c - ( float ) i );
+}
+
+static double BesselI0( double x ) {
+	double sum = 1.0, term = 1.0;
+	for ( unsigned int k = 1; term > sum * 1e-12; ++k ) {
+		double t = x / ( 2.0 * k );
+		term *= t * t;
+		sum += term;
+	}
+
+	return sum;
+}
+
+/**
+ * Halving is the only thing the filter does, so the taps fall at the same
+ * offsets for every pixel and the weights only need working out once.
+ */
+static void GetKaiserWeights( float *weights ) {
+	double w[ MIPMAP_KAISER_TAPS ], total = 0.0;
+	for ( unsigned int i = 0; i < MIPMAP_KAISER_TAPS; ++i ) {
+		/* distance from the centre of the destination pixel, in destination pixels */
+		double t = ( ( double ) i - ( MIPMAP_KAISER_TAPS - 1 ) / 2.0 ) / 2.0;
+		double sinc = ( t == 0.0 ) ? 1.0 : sin( PL_PI * t ) / ( PL_PI * t );
+		double x = t / MIPMAP_KAISER_RADIUS;
+		double window = BesselI0( MIPMAP_KAISER_ALPHA * sqrt( 1.0 - x * x ) ) / BesselI0( MIPMAP_KAISER_ALPHA );
+		w[ i ] = sinc * window;
+		total += w[ i ];
+	}
+
+	for ( unsigned int i = 0; i < MIPMAP_KAISER_TAPS; ++i ) {
+		weights[ i ] = ( float ) ( w[ i ] / total );
+	}
+}
+
+/****************************************
+ * Scalar
+ ****************************************/
+
+static void BoxRowScalar( const float *row0, const float *row1, float *dst, unsigned int srcWidth, unsigned int dstWidth ) {
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		const float *a = row0 + ( 2 * x ) * 4;
+		const float *b = row0 + ClampIndex( 2 * x + 1, srcWidth ) * 4;
+		const float *c = row1 + ( 2 * x ) * 4;
+		const float *d = row1 + ClampIndex( 2 * x + 1, srcWidth ) * 4;
+		for ( unsigned int i = 0; i < 4; ++i ) {
+			dst[ i ] = ( a[ i ] + b[ i ] + c[ i ] + d[ i ] ) * 0.25f;
+		}
+	}
+}
+
+static void BoxRowRGBA8Scalar( const uint8_t *row0, const uint8_t *row1, uint8_t *dst, unsigned int srcWidth, unsigned int dstWidth ) {
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		const uint8_t *a = row0 + ( 2 * x ) * 4;
+		const uint8_t *b = row0 + ClampIndex( 2 * x + 1, srcWidth ) * 4;
+		const uint8_t *c = row1 + ( 2 * x ) * 4;
+		const uint8_t *d = row1 + ClampIndex( 2 * x + 1, srcWidth ) * 4;
+		for ( unsigned int i = 0; i < 4; ++i ) {
+			dst[ i ] = ( uint8_t ) ( ( a[ i ] + b[ i ] + c[ i ] + d[ i ] + 2 ) >> 2 );
+		}
+	}
+}
+
+static void KaiserRowScalar( const float *src, float *dst, unsigned int srcWidth, unsigned int dstWidth, const float *weights ) {
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		float sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+			const float *p = src + ClampIndex( ( int ) ( 2 * x + k ) - 2, srcWidth ) * 4;
+			for ( unsigned int i = 0; i < 4; ++i ) {
+				sum[ i ] += p[ i ] * weights[ k ];
+			}
+		}
+		memcpy( dst, sum, sizeof( sum ) );
+	}
+}
+
+static void KaiserColumnScalar( const float *const *rows, float *dst, unsigned int width, const float *weights ) {
+	for ( unsigned int i = 0; i < width * 4; ++i ) {
+		float sum = 0.0f;
+		for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+			sum += rows[ k ][ i ] * weights[ k ];
+		}
+		dst[ i ] = sum;
+	}
+}
+
+/****************************************
+ * SSE2
+ ****************************************/
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+/* float pixels are RGBA, so conveniently each one fills a register */
+
+PL_TARGET_ISA( "sse2" )
+static void BoxRowSse2( const float *row0, const float *row1, float *dst, unsigned int srcWidth, unsigned int dstWidth ) {
+	const __m128 quarter = _mm_set1_ps( 0.25f );
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		unsigned int x1 = ClampIndex( 2 * x + 1, srcWidth );
+		__m128 sum = _mm_add_ps( _mm_loadu_ps( row0 + ( 2 * x ) * 4 ), _mm_loadu_ps( row0 + x1 * 4 ) );
+		sum = _mm_add_ps( sum, _mm_add_ps( _mm_loadu_ps( row1 + ( 2 * x ) * 4 ), _mm_loadu_ps( row1 + x1 * 4 ) ) );
+		_mm_storeu_ps( dst, _mm_mul_ps( sum, quarter ) );
+	}
+}
+
+/* two destination pixels at a time, from four across each row */
+PL_TARGET_ISA( "sse2" )
+static void BoxRowRGBA8Sse2( const uint8_t *row0, const uint8_t *row1, uint8_t *dst, unsigned int srcWidth, unsigned int dstWidth ) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16( 2 );
+
+	unsigned int x = 0;
+	for ( ; x + 2 <= dstWidth && 2 * x + 4 <= srcWidth; x += 2 ) {
+		__m128i a = _mm_loadu_si128( ( const __m128i * ) ( row0 + x * 8 ) );
+		__m128i b = _mm_loadu_si128( ( const __m128i * ) ( row1 + x * 8 ) );
+		__m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+		__m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+		lo = _mm_add_epi16( lo, _mm_srli_si128( lo, 8 ) );
+		hi = _mm_add_epi16( hi, _mm_srli_si128( hi, 8 ) );
+		__m128i sum = _mm_srli_epi16( _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), round ), 2 );
+		_mm_storel_epi64( ( __m128i * ) ( dst + x * 4 ), _mm_packus_epi16( sum, sum ) );
+	}
+
+	if ( x < dstWidth ) {
+		BoxRowRGBA8Scalar( row0 + x * 8, row1 + x * 8, dst + x * 4, srcWidth - x * 2, dstWidth - x );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void KaiserRowSse2( const float *src, float *dst, unsigned int srcWidth, unsigned int dstWidth, const float *weights ) {
+	__m128 w[ MIPMAP_KAISER_TAPS ];
+	for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+		w[ k ] = _mm_set1_ps( weights[ k ] );
+	}
+
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		__m128 sum = _mm_setzero_ps();
+		if ( 2 * x >= 2 && 2 * x + 4 <= srcWidth ) {
+			/* away from the edges, so no clamping needed */
+			const float *p = src + ( 2 * x - 2 ) * 4;
+			for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+				sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( p + k * 4 ), w[ k ] ) );
+			}
+		} else {
+			for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+				const float *p = src + ClampIndex( ( int ) ( 2 * x + k ) - 2, srcWidth ) * 4;
+				sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( p ), w[ k ] ) );
+			}
+		}
+		_mm_storeu_ps( dst, sum );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void KaiserColumnSse2( const float *const *rows, float *dst, unsigned int width, const float *weights ) {
+	__m128 w[ MIPMAP_KAISER_TAPS ];
+	for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+		w[ k ] = _mm_set1_ps( weights[ k ] );
+	}
+
+	for ( unsigned int i = 0; i < width * 4; i += 4 ) {
+		__m128 sum = _mm_setzero_ps();
+		for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+			sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( rows[ k ] + i ), w[ k ] ) );
+		}
+		_mm_storeu_ps( dst + i, sum );
+	}
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const BoxRowKernel boxRowKernels[] = { BoxRowScalar, SSE2_KERNEL( BoxRowSse2 ), NULL };
+static const BoxRowRGBA8Kernel boxRowRGBA8Kernels[] = { BoxRowRGBA8Scalar, SSE2_KERNEL( BoxRowRGBA8Sse2 ), NULL };
+static const KaiserRowKernel kaiserRowKernels[] = { KaiserRowScalar, SSE2_KERNEL( KaiserRowSse2 ), NULL };
+static const KaiserColumnKernel kaiserColumnKernels[] = { KaiserColumnScalar, SSE2_KERNEL( KaiserColumnSse2 ), NULL };
+
+static void DownsampleBoxRGBA8( const uint8_t *src, unsigned int sw, unsigned int sh, uint8_t *dst, unsigned int dw, unsigned int dh ) {
+	BoxRowRGBA8Kernel BoxRow = PL_SELECT_SIMD_KERNEL( boxRowRGBA8Kernels, PlGetSimdLevel() );
+	for ( unsigned int y = 0; y < dh; ++y ) {
+		const uint8_t *row0 = src + ( size_t ) ( 2 * y ) * sw * 4;
+		const uint8_t *row1 = src + ( size_t ) ClampIndex( 2 * y + 1, sh ) * sw * 4;
+		BoxRow( row0, row1, dst + ( size_t ) y * dw * 4, sw, dw );
+	}
+}
+
+static void DownsampleBox( const float *src, unsigned int sw, unsigned int sh, float *dst, unsigned int dw, unsigned int dh ) {
+	BoxRowKernel BoxRow = PL_SELECT_SIMD_KERNEL( boxRowKernels, PlGetSimdLevel() );
+	for ( unsigned int y = 0; y < dh; ++y ) {
+		const float *row0 = src + ( size_t ) ( 2 * y ) * sw * 4;
+		const float *row1 = src + ( size_t ) ClampIndex( 2 * y + 1, sh ) * sw * 4;
+		BoxRow( row0, row1, dst + ( size_t ) y * dw * 4, sw, dw );
+	}
+}
+
+/* horizontal pass into scratch (dw * sh), then the vertical pass from there */
+static void DownsampleKaiser( const float *src, unsigned int sw, unsigned int sh, float *dst, unsigned int dw, unsigned int dh, float *scratch, const float *weights ) {
+	KaiserRowKernel KaiserRow = PL_SELECT_SIMD_KERNEL( kaiserRowKernels, PlGetSimdLevel() );
+	KaiserColumnKernel KaiserColumn = PL_SELECT_SIMD_KERNEL( kaiserColumnKernels, PlGetSimdLevel() );
+
+	for ( unsigned int y = 0; y < sh; ++y ) {
+		KaiserRow( src + ( size_t ) y * sw * 4, scratch + ( size_t ) y * dw * 4, sw, dw, weights );
+	}
+
+	for ( unsigned int y = 0; y < dh; ++y ) {
+		const float *rows[ MIPMAP_KAISER_TAPS ];
+		for ( unsigned int k = 0; k < MIPMAP_KAISER_TAPS; ++k ) {
+			rows[ k ] = scratch + ( size_t ) ClampIndex( ( int ) ( 2 * y + k ) - 2, sh ) * dw * 4;
+		}
+		KaiserColumn( rows, dst + ( size_t ) y * dw * 4, dw, weights );
+	}
+}
+
+static float GetAlphaCoverage( const float *pixels, size_t numPixels, float scale ) {
+	size_t covered = 0;
+	for ( size_t i = 0; i < numPixels; ++i ) {
+		covered += ( pixels[ i * 4 + 3 ] * scale > MIPMAP_ALPHA_REFERENCE );
+	}
+
+	return ( float ) covered / ( float ) numPixels;
+}
+
+/**
+ * Finds how much the level's alpha needs scaling by for the same
+ * proportion of it to pass the alpha test as the top level did.
+ */
+static float GetCoverageScale( const float *pixels, size_t numPixels, float coverage ) {
+	float lo = 0.0f, hi = 4.0f;
+	for ( unsigned int i = 0; i < MIPMAP_COVERAGE_STEPS; ++i ) {
+		float mid = ( lo + hi ) * 0.5f;
+		if ( GetAlphaCoverage( pixels, numPixels, mid ) > coverage ) {
+			hi = mid;
+		} else {
+			lo = mid;
+		}
+	}
+
+	return ( lo + hi ) * 0.5f;
+}
+
+/* packs a filtered level out, undoing the linearisation and applying any alpha scale */
+static void StoreLevel( const float *src, uint8_t *dst, PLImageFormat format, size_t numPixels, const SrgbTables *srgb, float alphaScale ) {
+	unsigned int bytesPerPixel = PlImageBytesPerPixel( format );
+
+	float block[ MIPMAP_BLOCK_PIXELS * 4 ];
+	for ( size_t i = 0; i < numPixels; i += MIPMAP_BLOCK_PIXELS ) {
+		size_t n = ( numPixels - i < MIPMAP_BLOCK_PIXELS ) ? numPixels - i : MIPMAP_BLOCK_PIXELS;
+		memcpy( block, src + i * 4, n * 4 * sizeof( float ) );
+		for ( size_t j = 0; j < n; ++j ) {
+			if ( srgb != NULL ) {
+				block[ j * 4 + 0 ] = LookupSrgbTable( srgb->toSrgb, block[ j * 4 + 0 ] );
+				block[ j * 4 + 1 ] = LookupSrgbTable( srgb->toSrgb, block[ j * 4 + 1 ] );
+				block[ j * 4 + 2 ] = LookupSrgbTable( srgb->toSrgb, block[ j * 4 + 2 ] );
+			}
+			block[ j * 4 + 3 ] *= alphaScale;
+		}
+		_plFloatToPixels( block, dst + i * bytesPerPixel, format, n );
+	}
+}
+
+static void GenerateFloatLevels( const PLImage *image, uint8_t *chain, unsigned int numLevels, PLImageMipmapFilter filter, unsigned int flags,
+                                 float *src, float *dst, float *scratch, const SrgbTables *srgb ) {
+	bool preserveCoverage = ( flags & PL_IMAGE_MIPMAP_PRESERVE_COVERAGE ) && _plPixelFormatHasAlpha( image->format );
+
+	size_t numPixels = ( size_t ) image->width * image->height;
+	_plPixelsToFloat( chain, image->format, src, numPixels );
+	if ( srgb != NULL ) {
+		for ( size_t i = 0; i < numPixels; ++i ) {
+			src[ i * 4 + 0 ] = LookupSrgbTable( srgb->toLinear, src[ i * 4 + 0 ] );
+			src[ i * 4 + 1 ] = LookupSrgbTable( srgb->toLinear, src[ i * 4 + 1 ] );
+			src[ i * 4 + 2 ] = LookupSrgbTable( srgb->toLinear, src[ i * 4 + 2 ] );
+		}
+	}
+
+	float coverage = preserveCoverage ? GetAlphaCoverage( src, numPixels, 1.0f ) : 0.0f;
+
+	float weights[ MIPMAP_KAISER_TAPS ];
+	GetKaiserWeights( weights );
+
+	unsigned int sw = image->width, sh = image->height;
+	uint8_t *level = chain + PlGetImageSize( image->format, sw, sh );
+	for ( unsigned int l = 1; l < numLevels; ++l ) {
+		unsigned int dw = ( sw > 1 ) ? sw / 2 : 1;
+		unsigned int dh = ( sh > 1 ) ? sh / 2 : 1;
+		if ( filter == PL_IMAGE_MIPMAP_FILTER_KAISER ) {
+			DownsampleKaiser( src, sw, sh, dst, dw, dh, scratch, weights );
+		} else {
+			DownsampleBox( src, sw, sh, dst, dw, dh );
+		}
+
+		/* the next level is filtered from this one before its alpha gets scaled */
+		numPixels = ( size_t ) dw * dh;
+		float alphaScale = preserveCoverage ? GetCoverageScale( dst, numPixels, coverage ) : 1.0f;
+		StoreLevel( dst, level, image->format, numPixels, srgb, alphaScale );
+
+		float *swap = src;
+		src = dst;
+		dst = swap;
+
+		level += PlGetImageSize( image->format, dw, dh );
+		sw = dw;
+		sh = dh;
+	}
+}
+
+/**
+ * Builds the complete chain for the image's top level into a single
+ * allocation, with each level following straight on from the one before.
+ */
+uint8_t *_plGenerateMipmapChain( const PLImage *image, unsigned int numLevels, PLImageMipmapFilter filter, unsigned int flags ) {
+	size_t size = 0;
+	unsigned int lw = image->width, lh = image->height;
+	for ( unsigned int l = 0; l < numLevels; ++l ) {
+		size += PlGetImageSize( image->format, lw, lh );
+		lw = ( lw > 1 ) ? lw / 2 : 1;
+		lh = ( lh > 1 ) ? lh / 2 : 1;
+	}
+
+	uint8_t *chain = pl_malloc( size );
+	if ( chain == NULL ) {
+		return NULL;
+	}
+
+	memcpy( chain, image->data[ 0 ], PlGetImageSize( image->format, image->width, image->height ) );
+
+	/* plain 8-bit box filtering can skip the trip through float */
+	if ( image->format == PL_IMAGEFORMAT_RGBA8 && filter == PL_IMAGE_MIPMAP_FILTER_BOX && flags == 0 ) {
+		uint8_t *level = chain;
+		unsigned int sw = image->width, sh = image->height;
+		for ( unsigned int l = 1; l < numLevels; ++l ) {
+			unsigned int dw = ( sw > 1 ) ? sw / 2 : 1;
+			unsigned int dh = ( sh > 1 ) ? sh / 2 : 1;
+			uint8_t *next = level + ( size_t ) sw * sh * 4;
+			DownsampleBoxRGBA8( level, sw, sh, next, dw, dh );
+			level = next;
+			sw = dw;
+			sh = dh;
+		}
+
+		return chain;
+	}
+
+	size_t numPixels = ( size_t ) image->width * image->height;
+	float *src = pl_malloc( numPixels * 4 * sizeof( float ) );
+	float *dst = pl_malloc( ( numPixels / 2 + 1 ) * 4 * sizeof( float ) );
+	float *scratch = ( filter == PL_IMAGE_MIPMAP_FILTER_KAISER ) ? pl_malloc( ( numPixels / 2 + image->height ) * 4 * sizeof( float ) ) : NULL;
+	SrgbTables *srgb = ( flags & PL_IMAGE_MIPMAP_SRGB ) ? pl_malloc( sizeof( SrgbTables ) ) : NULL;
+	if ( src == NULL || dst == NULL || ( filter == PL_IMAGE_MIPMAP_FILTER_KAISER && scratch == NULL ) || ( ( flags & PL_IMAGE_MIPMAP_SRGB ) && srgb == NULL ) ) {
+		pl_free( src );
+		pl_free( dst );
+		pl_free( scratch );
+		pl_free( srgb );
+		pl_free( chain );
+		return NULL;
+	}
+
+	if ( srgb != NULL ) {
+		BuildSrgbTables( srgb );
+	}
+
+	GenerateFloatLevels( image, chain, numLevels, filter, flags, src, dst, scratch, srgb );
+
+	pl_free( src );
+	pl_free( dst );
+	pl_free( scratch );
+	pl_free( srgb );
+
+	return chain;
+}
@@ -0,0 +1,221 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "image_private.h"
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Palette expansion for indexed formats. Loaders convert their palette
+ * into the destination pixel format up front, so expanding the image is
+ * nothing more than a table lookup per index. The table is always padded
+ * out to 256 entries, which lets the gather kernels skip bounds checks;
+ * indices are instead validated in one pass before anything is written.
+ *
+ * 4-bit indices are unpacked into bytes (low nibble first) in blocks and
+ * then run through the same lookup as 8-bit indices. */
+
+#define PALETTE_TABLE_SIZE  256
+#define PALETTE_BLOCK_SIZE  1024
+
+typedef uint8_t ( *MaxIndexKernel )( const uint8_t *indices, size_t numBytes, unsigned int bitsPerIndex );
+typedef void ( *UnpackNibblesKernel )( const uint8_t *src, uint8_t *dst, size_t numPixels );
+typedef void ( *ExpandKernel )( const uint8_t *indices, const uint32_t *table, uint8_t *dst, size_t numPixels );
+
+static uint8_t MaxIndexScalar( const uint8_t *indices, size_t numBytes, unsigned int bitsPerIndex ) {
+	uint8_t max = 0;
+	for ( size_t i = 0; i < numBytes; ++i ) {
+		uint8_t index = indices[ i ];
+		if ( bitsPerIndex == 4 ) {
+			index = ( index & 0x0F ) > ( index >> 4 ) ? ( index & 0x0F ) : ( index >> 4 );
+		}
+		if ( index > max ) {
+			max = index;
+		}
+	}
+
+	return max;
+}
+
+static void UnpackNibblesScalar( const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i ) {
+		dst[ i ] = ( i & 1 ) ? ( src[ i / 2 ] >> 4 ) : ( src[ i / 2 ] & 0x0F );
+	}
+}
+
+static void Expand16Scalar( const uint8_t *indices, const uint32_t *table, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, dst += 2 ) {
+		uint16_t colour = ( uint16_t ) table[ indices[ i ] ];
+		memcpy( dst, &colour, sizeof( colour ) );
+	}
+}
+
+static void Expand32Scalar( const uint8_t *indices, const uint32_t *table, uint8_t *dst, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, dst += 4 ) {
+		memcpy( dst, &table[ indices[ i ] ], sizeof( uint32_t ) );
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static uint8_t MaxIndexSse2( const uint8_t *indices, size_t numBytes, unsigned int bitsPerIndex ) {
+	const __m128i nibble = _mm_set1_epi8( 0x0F );
+	__m128i max = _mm_setzero_si128();
+	size_t i = 0;
+	for ( ; i + 16 <= numBytes; i += 16 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) ( indices + i ) );
+		if ( bitsPerIndex == 4 ) {
+			max = _mm_max_epu8( max, _mm_and_si128( v, nibble ) );
+			v = _mm_and_si128( _mm_srli_epi16( v, 4 ), nibble );
+		}
+		max = _mm_max_epu8( max, v );
+	}
+
+	max = _mm_max_epu8( max, _mm_srli_si128( max, 8 ) );
+	max = _mm_max_epu8( max, _mm_srli_si128( max, 4 ) );
+	max = _mm_max_epu8( max, _mm_srli_si128( max, 2 ) );
+	max = _mm_max_epu8( max, _mm_srli_si128( max, 1 ) );
+
+	uint8_t result = ( uint8_t ) _mm_cvtsi128_si32( max );
+	uint8_t tail = MaxIndexScalar( indices + i, numBytes - i, bitsPerIndex );
+	return tail > result ? tail : result;
+}
+
+PL_TARGET_ISA( "sse2" )
+static void UnpackNibblesSse2( const uint8_t *src, uint8_t *dst, size_t numPixels ) {
+	const __m128i nibble = _mm_set1_epi8( 0x0F );
+	size_t i = 0;
+	for ( ; i + 32 <= numPixels; i += 32 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) ( src + i / 2 ) );
+		__m128i lo = _mm_and_si128( v, nibble );
+		__m128i hi = _mm_and_si128( _mm_srli_epi16( v, 4 ), nibble );
+		_mm_storeu_si128( ( __m128i * ) ( dst + i ), _mm_unpacklo_epi8( lo, hi ) );
+		_mm_storeu_si128( ( __m128i * ) ( dst + i + 16 ), _mm_unpackhi_epi8( lo, hi ) );
+	}
+
+	for ( ; i < numPixels; ++i ) {
+		dst[ i ] = ( i & 1 ) ? ( src[ i / 2 ] >> 4 ) : ( src[ i / 2 ] & 0x0F );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Expand16Avx2( const uint8_t *indices, const uint32_t *table, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 16 <= numPixels; i += 16 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) ( indices + i ) );
+		__m256i a = _mm256_i32gather_epi32( ( const int * ) table, _mm256_cvtepu8_epi32( v ), 4 );
+		__m256i b = _mm256_i32gather_epi32( ( const int * ) table, _mm256_cvtepu8_epi32( _mm_srli_si128( v, 8 ) ), 4 );
+		/* entries are zero extended, so packing can't saturate; it does interleave the lanes though */
+		__m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi32( a, b ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + i * 2 ), packed );
+	}
+
+	Expand16Scalar( indices + i, table, dst + i * 2, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void Expand32Avx2( const uint8_t *indices, const uint32_t *table, uint8_t *dst, size_t numPixels ) {
+	size_t i = 0;
+	for ( ; i + 16 <= numPixels; i += 16 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) ( indices + i ) );
+		__m256i a = _mm256_i32gather_epi32( ( const int * ) table, _mm256_cvtepu8_epi32( v ), 4 );
+		__m256i b = _mm256_i32gather_epi32( ( const int * ) table, _mm256_cvtepu8_epi32( _mm_srli_si128( v, 8 ) ), 4 );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + i * 4 ), a );
+		_mm256_storeu_si256( ( __m256i * ) ( dst + i * 4 + 32 ), b );
+	}
+
+	Expand32Scalar( indices + i, table, dst + i * 4, numPixels - i );
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const MaxIndexKernel maxIndexKernels[] = { MaxIndexScalar, SSE2_KERNEL( MaxIndexSse2 ), NULL };
+static const UnpackNibblesKernel unpackNibblesKernels[] = { UnpackNibblesScalar, SSE2_KERNEL( UnpackNibblesSse2 ), NULL };
+static const ExpandKernel expand16Kernels[] = { Expand16Scalar, NULL, AVX2_KERNEL( Expand16Avx2 ) };
+static const ExpandKernel expand32Kernels[] = { Expand32Scalar, NULL, AVX2_KERNEL( Expand32Avx2 ) };
+
+/**
+ * Expands 4 or 8-bit palette indices into pixels.
+ * @param indices Packed indices; for 4-bit, the low nibble comes first.
+ * @param bitsPerIndex Either 4 or 8.
+ * @param numPixels Number of indices to expand.
+ * @param palette Colours already converted into the destination format.
+ * @param numColours Number of colours in the palette.
+ * @param bytesPerColour Size of each colour, either 2 or 4 bytes.
+ * @param dst Destination for numPixels * bytesPerColour bytes.
+ * @return False if an index falls outside of the palette.
+ */
+bool _plExpandPaletteIndices( const uint8_t *indices, unsigned int bitsPerIndex, size_t numPixels,
+                              const void *palette, unsigned int numColours, unsigned int bytesPerColour, uint8_t *dst ) {
+	if ( bitsPerIndex != 4 && bitsPerIndex != 8 ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported palette index size (%u)", bitsPerIndex );
+		return false;
+	}
+
+	if ( bytesPerColour != 2 && bytesPerColour != 4 ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "unsupported palette colour size (%u)", bytesPerColour );
+		return false;
+	}
+
+	/* validate the lot up front, so the kernels don't need to */
+	size_t numBytes = ( bitsPerIndex == 4 ) ? ( numPixels + 1 ) / 2 : numPixels;
+	if ( numPixels > 0 ) {
+		MaxIndexKernel MaxIndex = PL_SELECT_SIMD_KERNEL( maxIndexKernels, PlGetSimdLevel() );
+		unsigned int maxIndex = MaxIndex( indices, numPixels / ( 8 / bitsPerIndex ), bitsPerIndex );
+		if ( numBytes * 8 / bitsPerIndex != numPixels ) {
+			/* odd number of 4-bit indices, the high nibble of the last byte is unused */
+			unsigned int last = indices[ numBytes - 1 ] & 0x0F;
+			maxIndex = last > maxIndex ? last : maxIndex;
+		}
+
+		if ( maxIndex >= numColours ) {
+			PlReportErrorF( PL_RESULT_FILETYPE, "out-of-range palette index (%u >= %u)", maxIndex, numColours );
+			return false;
+		}
+	}
+
+	uint32_t table[ PALETTE_TABLE_SIZE ];
+	memset( table, 0, sizeof( table ) );
+	if ( numColours > PALETTE_TABLE_SIZE ) {
+		numColours = PALETTE_TABLE_SIZE;
+	}
+	for ( unsigned int i = 0; i < numColours; ++i ) {
+		if ( bytesPerColour == 2 ) {
+			uint16_t colour;
+			memcpy( &colour, ( const uint8_t * ) palette + i * 2, sizeof( colour ) );
+			table[ i ] = colour;
+		} else {
+			memcpy( &table[ i ], ( const uint8_t * ) palette + i * 4, sizeof( uint32_t ) );
+		}
+	}
+
+	ExpandKernel Expand = ( bytesPerColour == 2 ) ? PL_SELECT_SIMD_KERNEL( expand16Kernels, PlGetSimdLevel() ) : PL_SELECT_SIMD_KERNEL( expand32Kernels, PlGetSimdLevel() );
+	if ( bitsPerIndex == 8 ) {
+		Expand( indices, table, dst, numPixels );
+		return true;
+	}
+
+	UnpackNibblesKernel UnpackNibbles = PL_SELECT_SIMD_KERNEL( unpackNibblesKernels, PlGetSimdLevel() );
+	uint8_t block[ PALETTE_BLOCK_SIZE ];
+	for ( size_t i = 0; i < numPixels; i += PALETTE_BLOCK_SIZE ) {
+		size_t n = ( numPixels - i < PALETTE_BLOCK_SIZE ) ? numPixels - i : PALETTE_BLOCK_SIZE;
+		UnpackNibbles( indices + i / 2, block, n );
+		Expand( block, table, dst + i * bytesPerColour, n );
+	}
+
+	return true;
+}
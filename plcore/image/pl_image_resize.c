@@ -0,0 +1,279 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "image_private.h"
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Separable resampling, horizontally into a scratch buffer and then
+ * vertically from there. The taps and weights for every destination pixel
+ * are worked out up front, per axis, so the inner loops are nothing but
+ * multiply-adds over float RGBA. When shrinking, the filter is stretched
+ * by the same factor so it still covers every source pixel. */
+
+typedef struct ResizeFilterInfo {
+	float support; /* radius, in source pixels when enlarging */
+	float ( *Evaluate )( float x );
+} ResizeFilterInfo;
+
+/* taps and normalised weights for each destination pixel along one axis */
+typedef struct ResizeWeights {
+	unsigned int numTaps;
+	unsigned int *indices;
+	float *weights;
+} ResizeWeights;
+
+typedef void ( *ResizeRowKernel )( const float *src, float *dst, unsigned int dstWidth, const ResizeWeights *weights );
+typedef void ( *ResizeColumnKernel )( const float *const *rows, const float *weights, unsigned int numTaps, float *dst, unsigned int width );
+
+static float EvaluateBox( float x ) {
+	return ( x > -0.5f && x <= 0.5f ) ? 1.0f : 0.0f;
+}
+
+static float EvaluateTriangle( float x ) {
+	x = fabsf( x );
+	return ( x < 1.0f ) ? 1.0f - x : 0.0f;
+}
+
+static float EvaluateLanczos3( float x ) {
+	if ( x == 0.0f ) {
+		return 1.0f;
+	} else if ( fabsf( x ) >= 3.0f ) {
+		return 0.0f;
+	}
+
+	float px = PL_PI * x;
+	return 3.0f * sinf( px ) * sinf( px / 3.0f ) / ( px * px );
+}
+
+/* Mitchell-Netravali, with the recommended B = C = 1/3 */
+static float EvaluateMitchell( float x ) {
+	const float b = 1.0f / 3.0f, c = 1.0f / 3.0f;
+	x = fabsf( x );
+	if ( x < 1.0f ) {
+		return ( ( 12.0f - 9.0f * b - 6.0f * c ) * x * x * x + ( -18.0f + 12.0f * b + 6.0f * c ) * x * x + ( 6.0f - 2.0f * b ) ) / 6.0f;
+	} else if ( x < 2.0f ) {
+		return ( ( -b - 6.0f * c ) * x * x * x + ( 6.0f * b + 30.0f * c ) * x * x + ( -12.0f * b - 48.0f * c ) * x + ( 8.0f * b + 24.0f * c ) ) / 6.0f;
+	}
+
+	return 0.0f;
+}
+
+static const ResizeFilterInfo resizeFilters[] = {
+        [PL_IMAGE_RESIZE_FILTER_BOX] = { 0.5f, EvaluateBox },
+        [PL_IMAGE_RESIZE_FILTER_BILINEAR] = { 1.0f, EvaluateTriangle },
+        [PL_IMAGE_RESIZE_FILTER_LANCZOS3] = { 3.0f, EvaluateLanczos3 },
+        [PL_IMAGE_RESIZE_FILTER_MITCHELL] = { 2.0f, EvaluateMitchell },
+};
+
+static void FreeResizeWeights( ResizeWeights *weights ) {
+	pl_free( weights->indices );
+	pl_free( weights->weights );
+}
+
+/**
+ * Taps which fall outside of the source are clamped to the edge, so every
+ * destination pixel ends up with the same number of them; any which don't
+ * contribute are simply left with a weight of zero.
+ */
+static bool BuildResizeWeights( const ResizeFilterInfo *filter, unsigned int srcSize, unsigned int dstSize, ResizeWeights *out ) {
+	float scale = ( float ) dstSize / ( float ) srcSize;
+	float stretch = ( scale < 1.0f ) ? 1.0f / scale : 1.0f;
+	float radius = filter->support * stretch;
+
+	out->numTaps = ( unsigned int ) ceilf( radius * 2.0f ) + 1;
+	out->indices = pl_malloc( sizeof( unsigned int ) * out->numTaps * dstSize );
+	out->weights = pl_malloc( sizeof( float ) * out->numTaps * dstSize );
+	if ( out->indices == NULL || out->weights == NULL ) {
+		FreeResizeWeights( out );
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < dstSize; ++i ) {
+		unsigned int *indices = &out->indices[ i * out->numTaps ];
+		float *weights = &out->weights[ i * out->numTaps ];
+
+		/* centre of the destination pixel, in source pixels */
+		float centre = ( ( float ) i + 0.5f ) / scale - 0.5f;
+		int first = ( int ) floorf( centre - radius ) + 1;
+
+		float total = 0.0f;
+		for ( unsigned int t = 0; t < out->numTaps; ++t ) {
+			int s = first + ( int ) t;
+			indices[ t ] = ( s < 0 ) ? 0 : ( ( ( unsigned int ) s >= srcSize ) ? srcSize - 1 : ( unsigned int ) s );
+			weights[ t ] = filter->Evaluate( ( ( float ) s - centre ) / stretch );
+			total += weights[ t ];
+		}
+
+		/* zero would mean the filter missed every tap, which a box can on exact halves */
+		if ( total == 0.0f ) {
+			weights[ out->numTaps / 2 ] = total = 1.0f;
+		}
+
+		for ( unsigned int t = 0; t < out->numTaps; ++t ) {
+			weights[ t ] /= total;
+		}
+	}
+
+	return true;
+}
+
+/****************************************
+ * Scalar
+ ****************************************/
+
+static void ResizeRowScalar( const float *src, float *dst, unsigned int dstWidth, const ResizeWeights *weights ) {
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		const unsigned int *indices = &weights->indices[ x * weights->numTaps ];
+		const float *w = &weights->weights[ x * weights->numTaps ];
+
+		float sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for ( unsigned int t = 0; t < weights->numTaps; ++t ) {
+			const float *p = src + indices[ t ] * 4;
+			for ( unsigned int i = 0; i < 4; ++i ) {
+				sum[ i ] += p[ i ] * w[ t ];
+			}
+		}
+		memcpy( dst, sum, sizeof( sum ) );
+	}
+}
+
+static void ResizeColumnScalar( const float *const *rows, const float *weights, unsigned int numTaps, float *dst, unsigned int width ) {
+	for ( unsigned int i = 0; i < width * 4; ++i ) {
+		float sum = 0.0f;
+		for ( unsigned int t = 0; t < numTaps; ++t ) {
+			sum += rows[ t ][ i ] * weights[ t ];
+		}
+		dst[ i ] = sum;
+	}
+}
+
+/****************************************
+ * SSE2 / AVX2
+ ****************************************/
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static void ResizeRowSse2( const float *src, float *dst, unsigned int dstWidth, const ResizeWeights *weights ) {
+	for ( unsigned int x = 0; x < dstWidth; ++x, dst += 4 ) {
+		const unsigned int *indices = &weights->indices[ x * weights->numTaps ];
+		const float *w = &weights->weights[ x * weights->numTaps ];
+
+		__m128 sum = _mm_setzero_ps();
+		for ( unsigned int t = 0; t < weights->numTaps; ++t ) {
+			sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( src + indices[ t ] * 4 ), _mm_set1_ps( w[ t ] ) ) );
+		}
+		_mm_storeu_ps( dst, sum );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void ResizeColumnSse2( const float *const *rows, const float *weights, unsigned int numTaps, float *dst, unsigned int width ) {
+	for ( unsigned int i = 0; i < width * 4; i += 4 ) {
+		__m128 sum = _mm_setzero_ps();
+		for ( unsigned int t = 0; t < numTaps; ++t ) {
+			sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( rows[ t ] + i ), _mm_set1_ps( weights[ t ] ) ) );
+		}
+		_mm_storeu_ps( dst + i, sum );
+	}
+}
+
+/* two pixels per register, with any odd one left over done four wide */
+PL_TARGET_ISA( "avx2" )
+static void ResizeColumnAvx2( const float *const *rows, const float *weights, unsigned int numTaps, float *dst, unsigned int width ) {
+	unsigned int i = 0;
+	for ( ; i + 8 <= width * 4; i += 8 ) {
+		__m256 sum = _mm256_setzero_ps();
+		for ( unsigned int t = 0; t < numTaps; ++t ) {
+			sum = _mm256_add_ps( sum, _mm256_mul_ps( _mm256_loadu_ps( rows[ t ] + i ), _mm256_set1_ps( weights[ t ] ) ) );
+		}
+		_mm256_storeu_ps( dst + i, sum );
+	}
+
+	for ( ; i < width * 4; i += 4 ) {
+		__m128 sum = _mm_setzero_ps();
+		for ( unsigned int t = 0; t < numTaps; ++t ) {
+			sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( rows[ t ] + i ), _mm_set1_ps( weights[ t ] ) ) );
+		}
+		_mm_storeu_ps( dst + i, sum );
+	}
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const ResizeRowKernel resizeRowKernels[] = { ResizeRowScalar, SSE2_KERNEL( ResizeRowSse2 ), NULL };
+static const ResizeColumnKernel resizeColumnKernels[] = { ResizeColumnScalar, SSE2_KERNEL( ResizeColumnSse2 ), AVX2_KERNEL( ResizeColumnAvx2 ) };
+
+static void ResampleFloat( const float *src, unsigned int sw, unsigned int sh, float *dst, unsigned int dw, unsigned int dh,
+                           float *scratch, const ResizeWeights *horizontal, const ResizeWeights *vertical, const float **rows ) {
+	ResizeRowKernel ResizeRow = PL_SELECT_SIMD_KERNEL( resizeRowKernels, PlGetSimdLevel() );
+	ResizeColumnKernel ResizeColumn = PL_SELECT_SIMD_KERNEL( resizeColumnKernels, PlGetSimdLevel() );
+
+	for ( unsigned int y = 0; y < sh; ++y ) {
+		ResizeRow( src + ( size_t ) y * sw * 4, scratch + ( size_t ) y * dw * 4, dw, horizontal );
+	}
+
+	for ( unsigned int y = 0; y < dh; ++y ) {
+		const unsigned int *indices = &vertical->indices[ y * vertical->numTaps ];
+		for ( unsigned int t = 0; t < vertical->numTaps; ++t ) {
+			rows[ t ] = scratch + ( size_t ) indices[ t ] * dw * 4;
+		}
+		ResizeColumn( rows, &vertical->weights[ y * vertical->numTaps ], vertical->numTaps, dst + ( size_t ) y * dw * 4, dw );
+	}
+}
+
+/**
+ * Resamples the image's top level into a newly allocated buffer of the
+ * given size, in the same format.
+ */
+uint8_t *_plResampleImage( const PLImage *image, unsigned int width, unsigned int height, PLImageResizeFilter filter ) {
+	if ( filter < 0 || filter >= plArrayElements( resizeFilters ) ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM3, "invalid resize filter" );
+		return NULL;
+	}
+
+	size_t srcPixels = ( size_t ) image->width * image->height;
+	size_t dstPixels = ( size_t ) width * height;
+
+	ResizeWeights horizontal = { 0 }, vertical = { 0 };
+	float *src = pl_malloc( srcPixels * 4 * sizeof( float ) );
+	float *dst = pl_malloc( dstPixels * 4 * sizeof( float ) );
+	float *scratch = pl_malloc( ( size_t ) width * image->height * 4 * sizeof( float ) );
+	uint8_t *out = pl_malloc( PlGetImageSize( image->format, width, height ) );
+	const float **rows = NULL;
+	if ( src == NULL || dst == NULL || scratch == NULL || out == NULL ||
+	     !BuildResizeWeights( &resizeFilters[ filter ], image->width, width, &horizontal ) ||
+	     !BuildResizeWeights( &resizeFilters[ filter ], image->height, height, &vertical ) ||
+	     ( rows = pl_malloc( sizeof( float * ) * vertical.numTaps ) ) == NULL ) {
+		pl_free( out );
+		out = NULL;
+	} else {
+		_plPixelsToFloat( image->data[ 0 ], image->format, src, srcPixels );
+		ResampleFloat( src, image->width, image->height, dst, width, height, scratch, &horizontal, &vertical, rows );
+		_plFloatToPixels( dst, out, image->format, dstPixels );
+	}
+
+	pl_free( rows );
+	FreeResizeWeights( &horizontal );
+	FreeResizeWeights( &vertical );
+	pl_free( scratch );
+	pl_free( dst );
+	pl_free( src );
+
+	return out;
+}
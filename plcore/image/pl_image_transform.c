@@ -0,0 +1,973 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "image_private.h"
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* In-place transforms for uncompressed images. The geometric ones only care
+ * about how large a pixel is, so they work on raw bytes; flips swap blocks
+ * in from either end of the image or row at once, which means there's no
+ * need for a temporary row. Colour transforms work directly on the format
+ * where its channels are byte addressable (or, for inverting, through a
+ * per-format XOR mask) and otherwise go through normalised floats a block
+ * at a time. Every level is transformed, not just the top one. */
+
+#define TRANSFORM_BLOCK_PIXELS 256
+#define TRANSFORM_PATTERN_SIZE 48 /* a multiple of every pixel size */
+#define ROTATE_TILE_SIZE       32
+
+typedef void ( *SwapBytesKernel )( uint8_t *a, uint8_t *b, size_t numBytes );
+typedef void ( *ReverseRowsKernel )( uint8_t *pixels, size_t width, unsigned int height, unsigned int bytesPerPixel );
+typedef void ( *RotateKernel )( const uint8_t *src, uint8_t *dst, unsigned int width, unsigned int height, unsigned int bytesPerPixel, bool clockwise );
+typedef void ( *XorPatternKernel )( uint8_t *pixels, size_t numBytes, const uint8_t *pattern );
+typedef void ( *ReplaceKernel )( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *target, const uint8_t *dest );
+typedef void ( *ShuffleKernel )( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *map, const uint8_t *constant );
+typedef void ( *PremultiplyKernel )( uint8_t *pixels, size_t numPixels );
+typedef void ( *FloatKernel )( float *pixels, size_t numPixels, const uint8_t *swizzle );
+
+static void SwapBytesScalar( uint8_t *a, uint8_t *b, size_t numBytes ) {
+	size_t i = 0;
+	for ( ; i + 8 <= numBytes; i += 8 ) {
+		uint64_t t, u;
+		memcpy( &t, a + i, sizeof( t ) );
+		memcpy( &u, b + i, sizeof( u ) );
+		memcpy( a + i, &u, sizeof( u ) );
+		memcpy( b + i, &t, sizeof( t ) );
+	}
+
+	for ( ; i < numBytes; ++i ) {
+		uint8_t t = a[ i ];
+		a[ i ] = b[ i ];
+		b[ i ] = t;
+	}
+}
+
+static void ReversePixelsScalar( uint8_t *row, size_t numPixels, unsigned int bytesPerPixel ) {
+	if ( numPixels < 2 ) {
+		return;
+	}
+
+	uint8_t *l = row;
+	uint8_t *r = row + ( numPixels - 1 ) * bytesPerPixel;
+	for ( ; l < r; l += bytesPerPixel, r -= bytesPerPixel ) {
+		uint8_t t[ 8 ];
+		memcpy( t, l, bytesPerPixel );
+		memcpy( l, r, bytesPerPixel );
+		memcpy( r, t, bytesPerPixel );
+	}
+}
+
+static void ReverseRowsScalar( uint8_t *pixels, size_t width, unsigned int height, unsigned int bytesPerPixel ) {
+	for ( unsigned int y = 0; y < height; ++y ) {
+		ReversePixelsScalar( pixels + y * width * bytesPerPixel, width, bytesPerPixel );
+	}
+}
+
+static void RotateTileScalar( const uint8_t *src, uint8_t *dst, unsigned int width, unsigned int height, unsigned int bytesPerPixel, bool clockwise,
+                              unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1 ) {
+	for ( unsigned int y = y0; y < y1; ++y ) {
+		const uint8_t *s = src + ( ( size_t ) y * width + x0 ) * bytesPerPixel;
+		for ( unsigned int x = x0; x < x1; ++x, s += bytesPerPixel ) {
+			size_t dx = clockwise ? height - 1 - y : y;
+			size_t dy = clockwise ? x : width - 1 - x;
+			memcpy( dst + ( dy * height + dx ) * bytesPerPixel, s, bytesPerPixel );
+		}
+	}
+}
+
+static void RotateScalar( const uint8_t *src, uint8_t *dst, unsigned int width, unsigned int height, unsigned int bytesPerPixel, bool clockwise ) {
+	for ( unsigned int ty = 0; ty < height; ty += ROTATE_TILE_SIZE ) {
+		unsigned int y1 = ( height - ty < ROTATE_TILE_SIZE ) ? height : ty + ROTATE_TILE_SIZE;
+		for ( unsigned int tx = 0; tx < width; tx += ROTATE_TILE_SIZE ) {
+			unsigned int x1 = ( width - tx < ROTATE_TILE_SIZE ) ? width : tx + ROTATE_TILE_SIZE;
+			RotateTileScalar( src, dst, width, height, bytesPerPixel, clockwise, tx, ty, x1, y1 );
+		}
+	}
+}
+
+static void XorPatternScalar( uint8_t *pixels, size_t numBytes, const uint8_t *pattern ) {
+	size_t i = 0;
+	for ( ; i + TRANSFORM_PATTERN_SIZE <= numBytes; i += TRANSFORM_PATTERN_SIZE ) {
+		for ( unsigned int j = 0; j < TRANSFORM_PATTERN_SIZE; j += 8 ) {
+			uint64_t v, m;
+			memcpy( &v, pixels + i + j, sizeof( v ) );
+			memcpy( &m, pattern + j, sizeof( m ) );
+			v ^= m;
+			memcpy( pixels + i + j, &v, sizeof( v ) );
+		}
+	}
+
+	for ( unsigned int j = 0; i < numBytes; ++i, ++j ) {
+		pixels[ i ] ^= pattern[ j ];
+	}
+}
+
+static void ReplaceScalar( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *target, const uint8_t *dest ) {
+	for ( size_t i = 0; i < numPixels; ++i, pixels += bytesPerPixel ) {
+		if ( memcmp( pixels, target, bytesPerPixel ) == 0 ) {
+			memcpy( pixels, dest, bytesPerPixel );
+		}
+	}
+}
+
+static void ShuffleScalar( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *map, const uint8_t *constant ) {
+	for ( size_t i = 0; i < numPixels; ++i, pixels += bytesPerPixel ) {
+		uint8_t t[ 8 ];
+		for ( unsigned int j = 0; j < bytesPerPixel; ++j ) {
+			t[ j ] = ( map[ j ] & 0x80 ) ? constant[ j ] : pixels[ map[ j ] ];
+		}
+		memcpy( pixels, t, bytesPerPixel );
+	}
+}
+
+/* exact round( c * a / 255 ) */
+static inline uint8_t MultiplyAlpha8( unsigned int c, unsigned int a ) {
+	unsigned int t = c * a + 128;
+	return ( uint8_t ) ( ( t + ( t >> 8 ) ) >> 8 );
+}
+
+static void PremultiplyRGBA8Scalar( uint8_t *pixels, size_t numPixels ) {
+	for ( size_t i = 0; i < numPixels; ++i, pixels += 4 ) {
+		pixels[ 0 ] = MultiplyAlpha8( pixels[ 0 ], pixels[ 3 ] );
+		pixels[ 1 ] = MultiplyAlpha8( pixels[ 1 ], pixels[ 3 ] );
+		pixels[ 2 ] = MultiplyAlpha8( pixels[ 2 ], pixels[ 3 ] );
+	}
+}
+
+static void InvertFloatScalar( float *pixels, size_t numPixels, const uint8_t *swizzle ) {
+	for ( size_t i = 0; i < numPixels; ++i, pixels += 4 ) {
+		pixels[ 0 ] = 1.0f - pixels[ 0 ];
+		pixels[ 1 ] = 1.0f - pixels[ 1 ];
+		pixels[ 2 ] = 1.0f - pixels[ 2 ];
+	}
+}
+
+static void SwizzleFloatScalar( float *pixels, size_t numPixels, const uint8_t *swizzle ) {
+	for ( size_t i = 0; i < numPixels; ++i, pixels += 4 ) {
+		float t[ 4 ] = { pixels[ swizzle[ 0 ] ], pixels[ swizzle[ 1 ] ], pixels[ swizzle[ 2 ] ], pixels[ swizzle[ 3 ] ] };
+		memcpy( pixels, t, sizeof( t ) );
+	}
+}
+
+static void PremultiplyFloatScalar( float *pixels, size_t numPixels, const uint8_t *swizzle ) {
+	for ( size_t i = 0; i < numPixels; ++i, pixels += 4 ) {
+		pixels[ 0 ] *= pixels[ 3 ];
+		pixels[ 1 ] *= pixels[ 3 ];
+		pixels[ 2 ] *= pixels[ 3 ];
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static void SwapBytesSse2( uint8_t *a, uint8_t *b, size_t numBytes ) {
+	size_t i = 0;
+	for ( ; i + 16 <= numBytes; i += 16 ) {
+		__m128i t = _mm_loadu_si128( ( const __m128i * ) ( a + i ) );
+		__m128i u = _mm_loadu_si128( ( const __m128i * ) ( b + i ) );
+		_mm_storeu_si128( ( __m128i * ) ( a + i ), u );
+		_mm_storeu_si128( ( __m128i * ) ( b + i ), t );
+	}
+
+	SwapBytesScalar( a + i, b + i, numBytes - i );
+}
+
+/* reverses the order of the 2, 4 or 8 byte pixels within the vector */
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2ReversePixels( __m128i v, unsigned int bytesPerPixel ) {
+	switch ( bytesPerPixel ) {
+		case 2:
+			v = _mm_shufflehi_epi16( _mm_shufflelo_epi16( v, 0x1B ), 0x1B );
+			return _mm_shuffle_epi32( v, 0x4E );
+		case 4:
+			return _mm_shuffle_epi32( v, 0x1B );
+		default:
+			return _mm_shuffle_epi32( v, 0x4E );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void ReverseRowsSse2( uint8_t *pixels, size_t width, unsigned int height, unsigned int bytesPerPixel ) {
+	if ( 16 % bytesPerPixel != 0 ) {
+		ReverseRowsScalar( pixels, width, height, bytesPerPixel );
+		return;
+	}
+
+	for ( unsigned int y = 0; y < height; ++y ) {
+		uint8_t *l = pixels + y * width * bytesPerPixel;
+		uint8_t *r = l + width * bytesPerPixel;
+		while ( r - l >= 32 ) {
+			r -= 16;
+			__m128i a = _mm_loadu_si128( ( const __m128i * ) l );
+			__m128i b = _mm_loadu_si128( ( const __m128i * ) r );
+			_mm_storeu_si128( ( __m128i * ) l, Sse2ReversePixels( b, bytesPerPixel ) );
+			_mm_storeu_si128( ( __m128i * ) r, Sse2ReversePixels( a, bytesPerPixel ) );
+			l += 16;
+		}
+
+		ReversePixelsScalar( l, ( size_t ) ( r - l ) / bytesPerPixel, bytesPerPixel );
+	}
+}
+
+/* transposes a block of 16 / bytesPerPixel rows, so each vector then holds a column */
+PL_TARGET_ISA( "sse2" )
+static inline void Sse2TransposeBlock( __m128i *v, unsigned int bytesPerPixel ) {
+	if ( bytesPerPixel == 8 ) {
+		__m128i t = _mm_unpacklo_epi64( v[ 0 ], v[ 1 ] );
+		v[ 1 ] = _mm_unpackhi_epi64( v[ 0 ], v[ 1 ] );
+		v[ 0 ] = t;
+		return;
+	}
+
+	if ( bytesPerPixel == 4 ) {
+		__m128i t0 = _mm_unpacklo_epi32( v[ 0 ], v[ 1 ] );
+		__m128i t1 = _mm_unpacklo_epi32( v[ 2 ], v[ 3 ] );
+		__m128i t2 = _mm_unpackhi_epi32( v[ 0 ], v[ 1 ] );
+		__m128i t3 = _mm_unpackhi_epi32( v[ 2 ], v[ 3 ] );
+		v[ 0 ] = _mm_unpacklo_epi64( t0, t1 );
+		v[ 1 ] = _mm_unpackhi_epi64( t0, t1 );
+		v[ 2 ] = _mm_unpacklo_epi64( t2, t3 );
+		v[ 3 ] = _mm_unpackhi_epi64( t2, t3 );
+		return;
+	}
+
+	__m128i t[ 8 ], u[ 8 ];
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		t[ i * 2 ] = _mm_unpacklo_epi16( v[ i * 2 ], v[ i * 2 + 1 ] );
+		t[ i * 2 + 1 ] = _mm_unpackhi_epi16( v[ i * 2 ], v[ i * 2 + 1 ] );
+	}
+	for ( unsigned int i = 0; i < 2; ++i ) {
+		u[ i * 4 + 0 ] = _mm_unpacklo_epi32( t[ i * 4 + 0 ], t[ i * 4 + 2 ] );
+		u[ i * 4 + 1 ] = _mm_unpackhi_epi32( t[ i * 4 + 0 ], t[ i * 4 + 2 ] );
+		u[ i * 4 + 2 ] = _mm_unpacklo_epi32( t[ i * 4 + 1 ], t[ i * 4 + 3 ] );
+		u[ i * 4 + 3 ] = _mm_unpackhi_epi32( t[ i * 4 + 1 ], t[ i * 4 + 3 ] );
+	}
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		v[ i * 2 ] = _mm_unpacklo_epi64( u[ i ], u[ i + 4 ] );
+		v[ i * 2 + 1 ] = _mm_unpackhi_epi64( u[ i ], u[ i + 4 ] );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void RotateSse2( const uint8_t *src, uint8_t *dst, unsigned int width, unsigned int height, unsigned int bytesPerPixel, bool clockwise ) {
+	if ( 16 % bytesPerPixel != 0 ) {
+		RotateScalar( src, dst, width, height, bytesPerPixel, clockwise );
+		return;
+	}
+
+	/* blocks are as many pixels square as fit in a vector; anything left over
+	 * along the right and bottom edges is done with the scalar path */
+	unsigned int n = 16 / bytesPerPixel;
+	unsigned int bw = width - width % n;
+	unsigned int bh = height - height % n;
+	for ( unsigned int ty = 0; ty < bh; ty += ROTATE_TILE_SIZE ) {
+		unsigned int y1 = ( bh - ty < ROTATE_TILE_SIZE ) ? bh : ty + ROTATE_TILE_SIZE;
+		for ( unsigned int tx = 0; tx < bw; tx += ROTATE_TILE_SIZE ) {
+			unsigned int x1 = ( bw - tx < ROTATE_TILE_SIZE ) ? bw : tx + ROTATE_TILE_SIZE;
+			for ( unsigned int y = ty; y < y1; y += n ) {
+				for ( unsigned int x = tx; x < x1; x += n ) {
+					__m128i v[ 8 ];
+					for ( unsigned int i = 0; i < n; ++i ) {
+						v[ i ] = _mm_loadu_si128( ( const __m128i * ) ( src + ( ( size_t ) ( y + i ) * width + x ) * bytesPerPixel ) );
+					}
+
+					Sse2TransposeBlock( v, bytesPerPixel );
+
+					for ( unsigned int i = 0; i < n; ++i ) {
+						uint8_t *d;
+						if ( clockwise ) {
+							v[ i ] = Sse2ReversePixels( v[ i ], bytesPerPixel );
+							d = dst + ( ( size_t ) ( x + i ) * height + ( height - y - n ) ) * bytesPerPixel;
+						} else {
+							d = dst + ( ( size_t ) ( width - 1 - x - i ) * height + y ) * bytesPerPixel;
+						}
+						_mm_storeu_si128( ( __m128i * ) d, v[ i ] );
+					}
+				}
+			}
+		}
+	}
+
+	RotateTileScalar( src, dst, width, height, bytesPerPixel, clockwise, bw, 0, width, height );
+	RotateTileScalar( src, dst, width, height, bytesPerPixel, clockwise, 0, bh, bw, height );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void XorPatternSse2( uint8_t *pixels, size_t numBytes, const uint8_t *pattern ) {
+	const __m128i m0 = _mm_loadu_si128( ( const __m128i * ) pattern );
+	const __m128i m1 = _mm_loadu_si128( ( const __m128i * ) ( pattern + 16 ) );
+	const __m128i m2 = _mm_loadu_si128( ( const __m128i * ) ( pattern + 32 ) );
+	size_t i = 0;
+	for ( ; i + TRANSFORM_PATTERN_SIZE <= numBytes; i += TRANSFORM_PATTERN_SIZE ) {
+		__m128i *p = ( __m128i * ) ( pixels + i );
+		_mm_storeu_si128( p, _mm_xor_si128( _mm_loadu_si128( p ), m0 ) );
+		_mm_storeu_si128( p + 1, _mm_xor_si128( _mm_loadu_si128( p + 1 ), m1 ) );
+		_mm_storeu_si128( p + 2, _mm_xor_si128( _mm_loadu_si128( p + 2 ), m2 ) );
+	}
+
+	XorPatternScalar( pixels + i, numBytes - i, pattern );
+}
+
+/* all-ones in every lane where a whole pixel matches */
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2ComparePixels( __m128i a, __m128i b, unsigned int bytesPerPixel ) {
+	switch ( bytesPerPixel ) {
+		case 2:
+			return _mm_cmpeq_epi16( a, b );
+		case 4:
+			return _mm_cmpeq_epi32( a, b );
+		default: {
+			__m128i m = _mm_cmpeq_epi32( a, b );
+			return _mm_and_si128( m, _mm_shuffle_epi32( m, 0xB1 ) );
+		}
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void ReplaceSse2( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *target, const uint8_t *dest ) {
+	if ( 16 % bytesPerPixel != 0 ) {
+		ReplaceScalar( pixels, numPixels, bytesPerPixel, target, dest );
+		return;
+	}
+
+	uint8_t t[ 16 ], d[ 16 ];
+	for ( unsigned int i = 0; i < 16; i += bytesPerPixel ) {
+		memcpy( t + i, target, bytesPerPixel );
+		memcpy( d + i, dest, bytesPerPixel );
+	}
+
+	const __m128i tv = _mm_loadu_si128( ( const __m128i * ) t );
+	const __m128i dv = _mm_loadu_si128( ( const __m128i * ) d );
+	size_t numBytes = numPixels * bytesPerPixel;
+	size_t i = 0;
+	for ( ; i + 16 <= numBytes; i += 16 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) ( pixels + i ) );
+		__m128i m = Sse2ComparePixels( v, tv, bytesPerPixel );
+		_mm_storeu_si128( ( __m128i * ) ( pixels + i ), _mm_or_si128( _mm_and_si128( m, dv ), _mm_andnot_si128( m, v ) ) );
+	}
+
+	ReplaceScalar( pixels + i, ( numBytes - i ) / bytesPerPixel, bytesPerPixel, target, dest );
+}
+
+PL_TARGET_ISA( "sse2" )
+static inline __m128i Sse2MultiplyAlpha8( __m128i c ) {
+	__m128i a = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c, 0xFF ), 0xFF );
+	__m128i t = _mm_add_epi16( _mm_mullo_epi16( c, a ), _mm_set1_epi16( 128 ) );
+	return _mm_srli_epi16( _mm_add_epi16( t, _mm_srli_epi16( t, 8 ) ), 8 );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void PremultiplyRGBA8Sse2( uint8_t *pixels, size_t numPixels ) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha = _mm_set1_epi32( ( int ) 0xFF000000 );
+	size_t i = 0;
+	for ( ; i + 4 <= numPixels; i += 4, pixels += 16 ) {
+		__m128i v = _mm_loadu_si128( ( const __m128i * ) pixels );
+		__m128i r = _mm_packus_epi16( Sse2MultiplyAlpha8( _mm_unpacklo_epi8( v, zero ) ),
+		                              Sse2MultiplyAlpha8( _mm_unpackhi_epi8( v, zero ) ) );
+		_mm_storeu_si128( ( __m128i * ) pixels, _mm_or_si128( _mm_and_si128( alpha, v ), _mm_andnot_si128( alpha, r ) ) );
+	}
+
+	PremultiplyRGBA8Scalar( pixels, numPixels - i );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void InvertFloatSse2( float *pixels, size_t numPixels, const uint8_t *swizzle ) {
+	const __m128 one = _mm_setr_ps( 1.0f, 1.0f, 1.0f, 0.0f );
+	const __m128 sign = _mm_setr_ps( -0.0f, -0.0f, -0.0f, 0.0f );
+	for ( size_t i = 0; i < numPixels; ++i, pixels += 4 ) {
+		/* alpha is left as 0 + a */
+		__m128 v = _mm_loadu_ps( pixels );
+		_mm_storeu_ps( pixels, _mm_add_ps( one, _mm_xor_ps( v, sign ) ) );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void PremultiplyFloatSse2( float *pixels, size_t numPixels, const uint8_t *swizzle ) {
+	const __m128 colour = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) );
+	for ( size_t i = 0; i < numPixels; ++i, pixels += 4 ) {
+		__m128 v = _mm_loadu_ps( pixels );
+		__m128 r = _mm_mul_ps( v, _mm_shuffle_ps( v, v, 0xFF ) );
+		_mm_storeu_ps( pixels, _mm_or_ps( _mm_and_ps( colour, r ), _mm_andnot_ps( colour, v ) ) );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void SwapBytesAvx2( uint8_t *a, uint8_t *b, size_t numBytes ) {
+	size_t i = 0;
+	for ( ; i + 32 <= numBytes; i += 32 ) {
+		__m256i t = _mm256_loadu_si256( ( const __m256i * ) ( a + i ) );
+		__m256i u = _mm256_loadu_si256( ( const __m256i * ) ( b + i ) );
+		_mm256_storeu_si256( ( __m256i * ) ( a + i ), u );
+		_mm256_storeu_si256( ( __m256i * ) ( b + i ), t );
+	}
+
+	SwapBytesScalar( a + i, b + i, numBytes - i );
+}
+
+/* builds the byte shuffles reversing the pixels within a 48 byte block,
+ * with each output vector gathered from (up to) all three input vectors */
+static void BuildReverseMasks( unsigned int bytesPerPixel, uint8_t masks[ 3 ][ 3 ][ 16 ] ) {
+	unsigned int numPixels = TRANSFORM_PATTERN_SIZE / bytesPerPixel;
+	for ( unsigned int i = 0; i < TRANSFORM_PATTERN_SIZE; ++i ) {
+		unsigned int src = ( numPixels - 1 - i / bytesPerPixel ) * bytesPerPixel + i % bytesPerPixel;
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			masks[ i / 16 ][ j ][ i % 16 ] = ( src / 16 == j ) ? ( uint8_t ) ( src % 16 ) : 0x80;
+		}
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static inline void Avx2ReverseBlock( const uint8_t *src, uint8_t *dst, const __m128i masks[ 3 ][ 3 ] ) {
+	__m128i v[ 3 ];
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		v[ i ] = _mm_loadu_si128( ( const __m128i * ) ( src + i * 16 ) );
+	}
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		__m128i r = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8( v[ 0 ], masks[ i ][ 0 ] ), _mm_shuffle_epi8( v[ 1 ], masks[ i ][ 1 ] ) ),
+		                          _mm_shuffle_epi8( v[ 2 ], masks[ i ][ 2 ] ) );
+		_mm_storeu_si128( ( __m128i * ) ( dst + i * 16 ), r );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void ReverseRowsAvx2( uint8_t *pixels, size_t width, unsigned int height, unsigned int bytesPerPixel ) {
+	if ( bytesPerPixel == 4 || bytesPerPixel == 8 ) {
+		const __m256i order = _mm256_setr_epi32( 7, 6, 5, 4, 3, 2, 1, 0 );
+		for ( unsigned int y = 0; y < height; ++y ) {
+			uint8_t *l = pixels + y * width * bytesPerPixel;
+			uint8_t *r = l + width * bytesPerPixel;
+			while ( r - l >= 64 ) {
+				r -= 32;
+				__m256i a = _mm256_loadu_si256( ( const __m256i * ) l );
+				__m256i b = _mm256_loadu_si256( ( const __m256i * ) r );
+				if ( bytesPerPixel == 4 ) {
+					a = _mm256_permutevar8x32_epi32( a, order );
+					b = _mm256_permutevar8x32_epi32( b, order );
+				} else {
+					a = _mm256_permute4x64_epi64( a, 0x1B );
+					b = _mm256_permute4x64_epi64( b, 0x1B );
+				}
+				_mm256_storeu_si256( ( __m256i * ) l, b );
+				_mm256_storeu_si256( ( __m256i * ) r, a );
+				l += 32;
+			}
+
+			ReversePixelsScalar( l, ( size_t ) ( r - l ) / bytesPerPixel, bytesPerPixel );
+		}
+		return;
+	}
+
+	/* other sizes don't fit evenly into a lane, so are done as 48 byte blocks */
+	uint8_t maskBytes[ 3 ][ 3 ][ 16 ];
+	BuildReverseMasks( bytesPerPixel, maskBytes );
+	__m128i masks[ 3 ][ 3 ];
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			masks[ i ][ j ] = _mm_loadu_si128( ( const __m128i * ) maskBytes[ i ][ j ] );
+		}
+	}
+
+	for ( unsigned int y = 0; y < height; ++y ) {
+		uint8_t *l = pixels + y * width * bytesPerPixel;
+		uint8_t *r = l + width * bytesPerPixel;
+		while ( r - l >= TRANSFORM_PATTERN_SIZE * 2 ) {
+			r -= TRANSFORM_PATTERN_SIZE;
+			uint8_t t[ TRANSFORM_PATTERN_SIZE ];
+			memcpy( t, l, sizeof( t ) );
+			Avx2ReverseBlock( r, l, masks );
+			Avx2ReverseBlock( t, r, masks );
+			l += TRANSFORM_PATTERN_SIZE;
+		}
+
+		ReversePixelsScalar( l, ( size_t ) ( r - l ) / bytesPerPixel, bytesPerPixel );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void XorPatternAvx2( uint8_t *pixels, size_t numBytes, const uint8_t *pattern ) {
+	/* the pattern is stored twice over, so it lines up with three 32 byte vectors */
+	const __m256i m0 = _mm256_loadu_si256( ( const __m256i * ) pattern );
+	const __m256i m1 = _mm256_loadu_si256( ( const __m256i * ) ( pattern + 32 ) );
+	const __m256i m2 = _mm256_loadu_si256( ( const __m256i * ) ( pattern + 64 ) );
+	size_t i = 0;
+	for ( ; i + TRANSFORM_PATTERN_SIZE * 2 <= numBytes; i += TRANSFORM_PATTERN_SIZE * 2 ) {
+		__m256i *p = ( __m256i * ) ( pixels + i );
+		_mm256_storeu_si256( p, _mm256_xor_si256( _mm256_loadu_si256( p ), m0 ) );
+		_mm256_storeu_si256( p + 1, _mm256_xor_si256( _mm256_loadu_si256( p + 1 ), m1 ) );
+		_mm256_storeu_si256( p + 2, _mm256_xor_si256( _mm256_loadu_si256( p + 2 ), m2 ) );
+	}
+
+	XorPatternSse2( pixels + i, numBytes - i, pattern );
+}
+
+/* 3 and 6 byte pixels are handled 24 bytes at a time, by spreading them
+ * out into 4 and 8 byte lanes (the 4th and 8th byte being zero) and then
+ * packing them back together again afterwards */
+static const uint8_t spreadMasks[ 2 ][ 16 ] = {
+        { 0, 1, 2, 0x80, 3, 4, 5, 0x80, 6, 7, 8, 0x80, 9, 10, 11, 0x80 },
+        { 0, 1, 2, 3, 4, 5, 0x80, 0x80, 6, 7, 8, 9, 10, 11, 0x80, 0x80 },
+};
+static const uint8_t packMasks[ 2 ][ 16 ] = {
+        { 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0x80, 0x80, 0x80, 0x80 },
+        { 0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, 0x80, 0x80, 0x80, 0x80 },
+};
+
+PL_TARGET_ISA( "avx2" )
+static inline __m256i Avx2LoadLanes( const uint8_t *mask ) {
+	return _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i * ) mask ) );
+}
+
+PL_TARGET_ISA( "avx2" )
+static inline __m256i Avx2Spread24( __m256i v, __m256i spread ) {
+	return _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( v, _mm256_setr_epi32( 0, 1, 2, 3, 3, 4, 5, 6 ) ), spread );
+}
+
+/* the top 8 bytes come out as zero */
+PL_TARGET_ISA( "avx2" )
+static inline __m256i Avx2Pack24( __m256i v, __m256i pack ) {
+	return _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( v, pack ), _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 ) );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void ReplaceAvx2( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *target, const uint8_t *dest ) {
+	size_t numBytes = numPixels * bytesPerPixel;
+	size_t i = 0;
+	if ( 16 % bytesPerPixel == 0 ) {
+		uint8_t t[ 32 ], d[ 32 ];
+		for ( unsigned int j = 0; j < 32; j += bytesPerPixel ) {
+			memcpy( t + j, target, bytesPerPixel );
+			memcpy( d + j, dest, bytesPerPixel );
+		}
+
+		const __m256i tv = _mm256_loadu_si256( ( const __m256i * ) t );
+		const __m256i dv = _mm256_loadu_si256( ( const __m256i * ) d );
+		for ( ; i + 32 <= numBytes; i += 32 ) {
+			__m256i v = _mm256_loadu_si256( ( const __m256i * ) ( pixels + i ) );
+			__m256i m;
+			if ( bytesPerPixel == 2 ) {
+				m = _mm256_cmpeq_epi16( v, tv );
+			} else if ( bytesPerPixel == 4 ) {
+				m = _mm256_cmpeq_epi32( v, tv );
+			} else {
+				m = _mm256_cmpeq_epi64( v, tv );
+			}
+			_mm256_storeu_si256( ( __m256i * ) ( pixels + i ), _mm256_blendv_epi8( v, dv, m ) );
+		}
+	} else {
+		unsigned int lane = ( bytesPerPixel == 3 ) ? 4 : 8;
+		uint8_t t[ 32 ] = { 0 }, d[ 32 ] = { 0 };
+		for ( unsigned int j = 0; j < 32; j += lane ) {
+			memcpy( t + j, target, bytesPerPixel );
+		}
+		for ( unsigned int j = 0; j + bytesPerPixel <= 24; j += bytesPerPixel ) {
+			memcpy( d + j, dest, bytesPerPixel );
+		}
+
+		const __m256i tv = _mm256_loadu_si256( ( const __m256i * ) t );
+		const __m256i dv = _mm256_loadu_si256( ( const __m256i * ) d );
+		const __m256i spread = Avx2LoadLanes( spreadMasks[ lane == 8 ] );
+		const __m256i pack = Avx2LoadLanes( packMasks[ lane == 8 ] );
+		/* stores the full 32 bytes, but with the trailing 8 untouched */
+		for ( ; i + 32 <= numBytes; i += 24 ) {
+			__m256i v = _mm256_loadu_si256( ( const __m256i * ) ( pixels + i ) );
+			__m256i s = Avx2Spread24( v, spread );
+			__m256i m = ( lane == 4 ) ? _mm256_cmpeq_epi32( s, tv ) : _mm256_cmpeq_epi64( s, tv );
+			_mm256_storeu_si256( ( __m256i * ) ( pixels + i ), _mm256_blendv_epi8( v, dv, Avx2Pack24( m, pack ) ) );
+		}
+	}
+
+	ReplaceScalar( pixels + i, ( numBytes - i ) / bytesPerPixel, bytesPerPixel, target, dest );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void ShuffleAvx2( uint8_t *pixels, size_t numPixels, unsigned int bytesPerPixel, const uint8_t *map, const uint8_t *constant ) {
+	/* each lane holds whole pixels, with the map offset for each one */
+	unsigned int perLane = ( bytesPerPixel == 3 ) ? 12 : 16;
+	uint8_t m[ 16 ], c[ 16 ] = { 0 };
+	memset( m, 0x80, sizeof( m ) );
+	for ( unsigned int i = 0; i < perLane; ++i ) {
+		unsigned int j = i % bytesPerPixel;
+		m[ i ] = ( map[ j ] & 0x80 ) ? 0x80 : ( uint8_t ) ( i - j + map[ j ] );
+		c[ i ] = constant[ j ];
+	}
+
+	const __m256i mv = Avx2LoadLanes( m );
+	const __m256i cv = Avx2LoadLanes( c );
+	size_t numBytes = numPixels * bytesPerPixel;
+	size_t i = 0;
+	if ( bytesPerPixel == 3 ) {
+		const __m256i spread = _mm256_setr_epi32( 0, 1, 2, 3, 3, 4, 5, 6 );
+		const __m256i pack = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+		for ( ; i + 32 <= numBytes; i += 24 ) {
+			__m256i v = _mm256_loadu_si256( ( const __m256i * ) ( pixels + i ) );
+			__m256i s = _mm256_or_si256( _mm256_shuffle_epi8( _mm256_permutevar8x32_epi32( v, spread ), mv ), cv );
+			s = _mm256_permutevar8x32_epi32( s, pack );
+			_mm256_storeu_si256( ( __m256i * ) ( pixels + i ), _mm256_blend_epi32( s, v, 0xC0 ) );
+		}
+	} else {
+		for ( ; i + 32 <= numBytes; i += 32 ) {
+			__m256i v = _mm256_loadu_si256( ( const __m256i * ) ( pixels + i ) );
+			_mm256_storeu_si256( ( __m256i * ) ( pixels + i ), _mm256_or_si256( _mm256_shuffle_epi8( v, mv ), cv ) );
+		}
+	}
+
+	ShuffleScalar( pixels + i, ( numBytes - i ) / bytesPerPixel, bytesPerPixel, map, constant );
+}
+
+PL_TARGET_ISA( "avx2" )
+static inline __m256i Avx2MultiplyAlpha8( __m256i c ) {
+	__m256i a = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( c, 0xFF ), 0xFF );
+	__m256i t = _mm256_add_epi16( _mm256_mullo_epi16( c, a ), _mm256_set1_epi16( 128 ) );
+	return _mm256_srli_epi16( _mm256_add_epi16( t, _mm256_srli_epi16( t, 8 ) ), 8 );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void PremultiplyRGBA8Avx2( uint8_t *pixels, size_t numPixels ) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alpha = _mm256_set1_epi32( ( int ) 0xFF000000 );
+	size_t i = 0;
+	for ( ; i + 8 <= numPixels; i += 8, pixels += 32 ) {
+		__m256i v = _mm256_loadu_si256( ( const __m256i * ) pixels );
+		__m256i r = _mm256_packus_epi16( Avx2MultiplyAlpha8( _mm256_unpacklo_epi8( v, zero ) ),
+		                                 Avx2MultiplyAlpha8( _mm256_unpackhi_epi8( v, zero ) ) );
+		_mm256_storeu_si256( ( __m256i * ) pixels, _mm256_blendv_epi8( r, v, alpha ) );
+	}
+
+	PremultiplyRGBA8Sse2( pixels, numPixels - i );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void SwizzleFloatAvx2( float *pixels, size_t numPixels, const uint8_t *swizzle ) {
+	const __m256i order = _mm256_setr_epi32( swizzle[ 0 ], swizzle[ 1 ], swizzle[ 2 ], swizzle[ 3 ],
+	                                         swizzle[ 0 ] + 4, swizzle[ 1 ] + 4, swizzle[ 2 ] + 4, swizzle[ 3 ] + 4 );
+	size_t i = 0;
+	for ( ; i + 2 <= numPixels; i += 2, pixels += 8 ) {
+		_mm256_storeu_ps( pixels, _mm256_permutevar8x32_ps( _mm256_loadu_ps( pixels ), order ) );
+	}
+
+	SwizzleFloatScalar( pixels, numPixels - i, swizzle );
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const SwapBytesKernel swapBytesKernels[] = { SwapBytesScalar, SSE2_KERNEL( SwapBytesSse2 ), AVX2_KERNEL( SwapBytesAvx2 ) };
+static const ReverseRowsKernel reverseRowsKernels[] = { ReverseRowsScalar, SSE2_KERNEL( ReverseRowsSse2 ), AVX2_KERNEL( ReverseRowsAvx2 ) };
+static const RotateKernel rotateKernels[] = { RotateScalar, SSE2_KERNEL( RotateSse2 ), NULL };
+static const XorPatternKernel xorPatternKernels[] = { XorPatternScalar, SSE2_KERNEL( XorPatternSse2 ), AVX2_KERNEL( XorPatternAvx2 ) };
+static const ReplaceKernel replaceKernels[] = { ReplaceScalar, SSE2_KERNEL( ReplaceSse2 ), AVX2_KERNEL( ReplaceAvx2 ) };
+static const ShuffleKernel shuffleKernels[] = { ShuffleScalar, NULL, AVX2_KERNEL( ShuffleAvx2 ) };
+static const PremultiplyKernel premultiplyKernels[] = { PremultiplyRGBA8Scalar, SSE2_KERNEL( PremultiplyRGBA8Sse2 ), AVX2_KERNEL( PremultiplyRGBA8Avx2 ) };
+static const FloatKernel invertFloatKernels[] = { InvertFloatScalar, SSE2_KERNEL( InvertFloatSse2 ), NULL };
+static const FloatKernel swizzleFloatKernels[] = { SwizzleFloatScalar, NULL, AVX2_KERNEL( SwizzleFloatAvx2 ) };
+static const FloatKernel premultiplyFloatKernels[] = { PremultiplyFloatScalar, SSE2_KERNEL( PremultiplyFloatSse2 ), NULL };
+
+/* the bits covering the colour channels of each integer format, as laid out in memory */
+static const uint8_t invertMasks[][ 8 ] = {
+        [PL_IMAGEFORMAT_RGB4] = { 0xFF, 0xF0 },
+        [PL_IMAGEFORMAT_RGBA4] = { 0xFF, 0xF0 },
+        [PL_IMAGEFORMAT_RGB5] = { 0xFF, 0xFE },
+        [PL_IMAGEFORMAT_RGB5A1] = { 0xFF, 0xFE },
+        [PL_IMAGEFORMAT_RGB565] = { 0xFF, 0xFF },
+        [PL_IMAGEFORMAT_RGB8] = { 0xFF, 0xFF, 0xFF },
+        [PL_IMAGEFORMAT_RGBA8] = { 0xFF, 0xFF, 0xFF, 0x00 },
+        [PL_IMAGEFORMAT_RGBA12] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xF0, 0x00 },
+        [PL_IMAGEFORMAT_RGBA16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00 },
+};
+
+static inline unsigned int GetLevelSize( unsigned int size, unsigned int level ) {
+	size >>= level;
+	return ( size > 0 ) ? size : 1;
+}
+
+static unsigned int GetTransformPixelSize( const PLImage *image, const char *what ) {
+	unsigned int bytesPerPixel = PlImageBytesPerPixel( image->format );
+	if ( bytesPerPixel == 0 ) {
+		PlReportErrorF( PL_RESULT_IMAGEFORMAT, "cannot %s images in this format", what );
+	}
+
+	return bytesPerPixel;
+}
+
+/* runs the kernel over every level via normalised floats */
+static bool TransformFloatPixels( PLImage *image, FloatKernel kernel, const uint8_t *swizzle ) {
+	float block[ TRANSFORM_BLOCK_PIXELS * 4 ];
+	unsigned int bytesPerPixel = PlImageBytesPerPixel( image->format );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		size_t numPixels = ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l );
+		for ( size_t i = 0; i < numPixels; i += TRANSFORM_BLOCK_PIXELS ) {
+			size_t n = ( numPixels - i < TRANSFORM_BLOCK_PIXELS ) ? numPixels - i : TRANSFORM_BLOCK_PIXELS;
+			uint8_t *pixels = image->data[ l ] + i * bytesPerPixel;
+			if ( !_plPixelsToFloat( pixels, image->format, block, n ) ) {
+				return false;
+			}
+			kernel( block, n, swizzle );
+			if ( !_plFloatToPixels( block, pixels, image->format, n ) ) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool PlFlipImageVertical( PLImage *image ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "flip" );
+	if ( bytesPerPixel == 0 ) {
+		PL_PROFILE_END();
+		return false;
+	}
+
+	SwapBytesKernel SwapBytes = PL_SELECT_SIMD_KERNEL( swapBytesKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		unsigned int height = GetLevelSize( image->height, l );
+		size_t bytesPerRow = ( size_t ) GetLevelSize( image->width, l ) * bytesPerPixel;
+		for ( unsigned int r = 0; r < height / 2; ++r ) {
+			SwapBytes( image->data[ l ] + r * bytesPerRow, image->data[ l ] + ( height - 1 - r ) * bytesPerRow, bytesPerRow );
+		}
+	}
+
+	PL_PROFILE_END();
+	return true;
+}
+
+bool PlFlipImageHorizontal( PLImage *image ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "flip" );
+	if ( bytesPerPixel == 0 ) {
+		PL_PROFILE_END();
+		return false;
+	}
+
+	ReverseRowsKernel ReverseRows = PL_SELECT_SIMD_KERNEL( reverseRowsKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		ReverseRows( image->data[ l ], GetLevelSize( image->width, l ), GetLevelSize( image->height, l ), bytesPerPixel );
+	}
+
+	PL_PROFILE_END();
+	return true;
+}
+
+/**
+ * Turns every level halfway around in place, which is the same
+ * as reversing the order of all of its pixels.
+ */
+bool _plReverseImagePixels( PLImage *image ) {
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "rotate" );
+	if ( bytesPerPixel == 0 ) {
+		return false;
+	}
+
+	ReverseRowsKernel ReverseRows = PL_SELECT_SIMD_KERNEL( reverseRowsKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		ReverseRows( image->data[ l ], ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l ), 1, bytesPerPixel );
+	}
+
+	return true;
+}
+
+/**
+ * Rotates every level a quarter turn into a single new allocation,
+ * laid out the same as the chains produced for mipmaps.
+ */
+uint8_t *_plRotateImageLevels( const PLImage *image, bool clockwise ) {
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "rotate" );
+	if ( bytesPerPixel == 0 ) {
+		return NULL;
+	}
+
+	size_t size = 0;
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		size += ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l ) * bytesPerPixel;
+	}
+
+	uint8_t *chain = pl_malloc( size );
+	if ( chain == NULL ) {
+		return NULL;
+	}
+
+	RotateKernel Rotate = PL_SELECT_SIMD_KERNEL( rotateKernels, PlGetSimdLevel() );
+	uint8_t *dst = chain;
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		unsigned int width = GetLevelSize( image->width, l );
+		unsigned int height = GetLevelSize( image->height, l );
+		Rotate( image->data[ l ], dst, width, height, bytesPerPixel, clockwise );
+		dst += ( size_t ) width * height * bytesPerPixel;
+	}
+
+	return chain;
+}
+
+/**
+ * Inverts the colour channels of every level, leaving alpha as it was.
+ */
+void PlInvertImageColour( PLImage *image ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "invert" );
+	if ( bytesPerPixel == 0 ) {
+		PL_PROFILE_END();
+		return;
+	}
+
+	if ( image->format == PL_IMAGEFORMAT_RGBA16F ) {
+		TransformFloatPixels( image, PL_SELECT_SIMD_KERNEL( invertFloatKernels, PlGetSimdLevel() ), NULL );
+		PL_PROFILE_END();
+		return;
+	}
+
+	/* spelt out over twice the block size, for the widest kernel */
+	uint8_t pattern[ TRANSFORM_PATTERN_SIZE * 2 ];
+	for ( unsigned int i = 0; i < sizeof( pattern ); ++i ) {
+		pattern[ i ] = invertMasks[ image->format ][ i % bytesPerPixel ];
+	}
+
+	XorPatternKernel XorPattern = PL_SELECT_SIMD_KERNEL( xorPatternKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		XorPattern( image->data[ l ], ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l ) * bytesPerPixel, pattern );
+	}
+
+	PL_PROFILE_END();
+}
+
+/**
+ * Replaces every pixel matching the target colour, once both are
+ * converted into the image's format. Alpha is ignored for formats
+ * without it.
+ */
+void PlReplaceImageColour( PLImage *image, PLColour target, PLColour dest ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "replace colours in" );
+	if ( bytesPerPixel == 0 ) {
+		PL_PROFILE_END();
+		return;
+	}
+
+	uint8_t t[ 8 ], d[ 8 ];
+	if ( !PlConvertPixels( ( const uint8_t * ) &target, PL_IMAGEFORMAT_RGBA8, t, image->format, 1 ) ||
+	     !PlConvertPixels( ( const uint8_t * ) &dest, PL_IMAGEFORMAT_RGBA8, d, image->format, 1 ) ) {
+		PL_PROFILE_END();
+		return;
+	}
+
+	ReplaceKernel Replace = PL_SELECT_SIMD_KERNEL( replaceKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		Replace( image->data[ l ], ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l ), bytesPerPixel, t, d );
+	}
+
+	PL_PROFILE_END();
+}
+
+/**
+ * Reorders the channels of every level.
+ * @param swizzle For each of red, green, blue and alpha, the channel
+ * (0 to 3, in the same order) it should be taken from. Formats without
+ * alpha read it as fully opaque.
+ */
+bool PlSwizzleImageChannels( PLImage *image, const uint8_t swizzle[ 4 ] ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		if ( swizzle[ i ] > 3 ) {
+			PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid channel in swizzle (%u)", swizzle[ i ] );
+			PL_PROFILE_END();
+			return false;
+		}
+	}
+
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "swizzle" );
+	if ( bytesPerPixel == 0 ) {
+		PL_PROFILE_END();
+		return false;
+	}
+
+	/* where channels are whole bytes, this is just a byte shuffle */
+	unsigned int bytesPerChannel;
+	switch ( image->format ) {
+		case PL_IMAGEFORMAT_RGB8:
+		case PL_IMAGEFORMAT_RGBA8:
+			bytesPerChannel = 1;
+			break;
+		case PL_IMAGEFORMAT_RGBA16:
+		case PL_IMAGEFORMAT_RGBA16F:
+			bytesPerChannel = 2;
+			break;
+		default: {
+			bool status = TransformFloatPixels( image, PL_SELECT_SIMD_KERNEL( swizzleFloatKernels, PlGetSimdLevel() ), swizzle );
+			PL_PROFILE_END();
+			return status;
+		}
+	}
+
+	uint8_t map[ 8 ], constant[ 8 ] = { 0 };
+	for ( unsigned int i = 0; i < bytesPerPixel; ++i ) {
+		unsigned int channel = swizzle[ i / bytesPerChannel ];
+		if ( channel * bytesPerChannel >= bytesPerPixel ) {
+			/* alpha, from a format without it */
+			map[ i ] = 0x80;
+			constant[ i ] = 0xFF;
+			continue;
+		}
+		map[ i ] = ( uint8_t ) ( channel * bytesPerChannel + i % bytesPerChannel );
+	}
+
+	ShuffleKernel Shuffle = PL_SELECT_SIMD_KERNEL( shuffleKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		Shuffle( image->data[ l ], ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l ), bytesPerPixel, map, constant );
+	}
+
+	PL_PROFILE_END();
+	return true;
+}
+
+/**
+ * Multiplies the colour channels of every level by alpha.
+ * Formats without alpha are left as they are.
+ */
+bool PlPremultiplyImageAlpha( PLImage *image ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
+	unsigned int bytesPerPixel = GetTransformPixelSize( image, "premultiply" );
+	if ( bytesPerPixel == 0 ) {
+		PL_PROFILE_END();
+		return false;
+	}
+
+	if ( !_plPixelFormatHasAlpha( image->format ) ) {
+		PL_PROFILE_END();
+		return true;
+	}
+
+	if ( image->format != PL_IMAGEFORMAT_RGBA8 ) {
+		bool status = TransformFloatPixels( image, PL_SELECT_SIMD_KERNEL( premultiplyFloatKernels, PlGetSimdLevel() ), NULL );
+		PL_PROFILE_END();
+		return status;
+	}
+
+	PremultiplyKernel Premultiply = PL_SELECT_SIMD_KERNEL( premultiplyKernels, PlGetSimdLevel() );
+	for ( unsigned int l = 0; l < image->levels; ++l ) {
+		Premultiply( image->data[ l ], ( size_t ) GetLevelSize( image->width, l ) * GetLevelSize( image->height, l ) );
+	}
+
+	PL_PROFILE_END();
+	return true;
+}
@@ -168,6 +168,8 @@ PL_EXTERN void PlShutdown( void );
 /******************************************************************/
 /* ERROR HANDLING */
 
+/* error state is kept per thread, so these only see errors raised on the calling thread */
+
 PL_EXTERN void PlClearError( void );// Resets the error message to "null", so you can ensure you have the correct message from the library.
 
 PL_EXTERN PLFunctionResult PlGetFunctionResult( void );
@@ -202,6 +204,16 @@ bool PlIsSubSystemActive( unsigned int subsystem );
 
 PL_EXTERN const char *PlGetFormattedTime( void );
 PL_EXTERN time_t PlStringToTime( const char *ts );
+PL_EXTERN uint64_t PlGetMonotonicTime( void );
+
+typedef enum PLSimdLevel {
+	PL_SIMD_LEVEL_NONE,
+	PL_SIMD_LEVEL_SSE2,
+	PL_SIMD_LEVEL_AVX2,
+} PLSimdLevel;
+
+PL_EXTERN PLSimdLevel PlGetSimdLevel( void );
+PL_EXTERN void PlSetSimdLevel( PLSimdLevel level );
 
 //////////////////////////////////////////////////////////////////
 
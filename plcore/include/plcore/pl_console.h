@@ -91,13 +91,36 @@ PL_EXTERN PLConsoleCommand *PlGetConsoleCommand( const char *name );
 PL_EXTERN void PlSetConsoleOutputCallback( void ( *Callback )( int level, const char *msg ) );
 
 PL_EXTERN const char **PlAutocompleteConsoleString( const char *string, unsigned int *numElements );
+PL_EXTERN unsigned int PlAutocompleteConsoleStringPaged( const char *string, unsigned int offset, const char **options,
+                                                         unsigned int maxOptions, unsigned int *totalMatches );
 PL_EXTERN void PlParseConsoleString( const char *string );
 
 /////////////////////////////////////////////////////////////////////////////////////
 
+typedef enum PLLogOverflowPolicy {
+	PL_LOG_OVERFLOW_DROP, /* discard messages while the queue is full */
+	PL_LOG_OVERFLOW_BLOCK,/* wait for the writer to make room */
+} PLLogOverflowPolicy;
+
+typedef struct PLLogLevelCounters {
+	uint64_t numMessages;
+	uint64_t numDropped;
+	uint64_t numBytes;
+} PLLogLevelCounters;
+
 extern void PlSetupLogOutput( const char *path );
+extern bool PlSetupAsyncLogOutput( PLLogOverflowPolicy policy, unsigned int flushInterval );
+extern void PlShutdownAsyncLogOutput( void );
+extern void PlFlushLogOutput( void );
+/* binary output keys formats on their address, so while it is on they must be
+ * literals; log text that is built at runtime through "%s" */
+extern bool PlSetupBinaryLogOutput( const char *path );
+extern void PlShutdownBinaryLogOutput( void );
+extern void PlFlushBinaryLogOutput( void );
+extern bool PlDecodeBinaryLog( const char *path, FILE *out );
 extern int PlAddLogLevel( const char *prefix, PLColour colour, bool status );
 extern void PlSetLogLevelStatus( int id, bool status );
+extern bool PlGetLogLevelCounters( int id, PLLogLevelCounters *counters );
 extern void PlLogMessage( int id, const char *msg, ... );
 
 #define PlLogWFunction( ID, FORMAT, ... ) PlLogMessage( ( ID ), "(%s) " FORMAT, PL_FUNCTION, ## __VA_ARGS__ )
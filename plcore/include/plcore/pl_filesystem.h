@@ -30,6 +30,12 @@ typedef enum PLFileSeek {
 #endif
 } PLFileSeek;
 
+typedef enum PLFileMemoryBufferType {
+	PL_FILE_MEMORYBUFFERTYPE_UNMANAGED, /* buffer is referenced, caller keeps ownership */
+	PL_FILE_MEMORYBUFFERTYPE_OWNER,     /* file takes ownership and frees the buffer on close */
+	PL_FILE_MEMORYBUFFERTYPE_COPY,      /* buffer is copied into the file */
+} PLFileMemoryBufferType;
+
 typedef struct PLFileSystemMount PLFileSystemMount;
 
 PL_EXTERN_C
@@ -62,6 +68,7 @@ PL_EXTERN bool PlCreatePath( const char *path );
 
 PL_EXTERN PLFile *PlOpenLocalFile( const char *path, bool cache );
 PL_EXTERN PLFile *PlOpenFile( const char *path, bool cache );
+PL_EXTERN PLFile *PlCreateFileFromMemory( const char *path, void *buf, size_t bufSize, PLFileMemoryBufferType bufType );
 PL_EXTERN void PlCloseFile( PLFile *ptr );
 
 PL_EXTERN bool PlCopyFile( const char *path, const char *dest );
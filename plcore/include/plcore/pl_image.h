@@ -33,7 +33,10 @@ typedef enum PLImageFormat {
 	PL_IMAGEFORMAT_RGBA_DXT3,
 	PL_IMAGEFORMAT_RGBA_DXT5,
 
-	PL_IMAGEFORMAT_RGB_FXT1
+	PL_IMAGEFORMAT_RGB_FXT1,
+
+	PL_IMAGEFORMAT_R_BC4,  // aka RGTC1
+	PL_IMAGEFORMAT_RG_BC5, // aka RGTC2
 } PLImageFormat;
 
 typedef enum PLColourFormat {
@@ -45,6 +48,38 @@ typedef enum PLColourFormat {
 	PL_COLOURFORMAT_BGRA,
 } PLColourFormat;
 
+typedef enum PLImageCompressionQuality {
+	PL_IMAGE_COMPRESSION_FAST,    // range fit, quick enough for runtime
+	PL_IMAGE_COMPRESSION_QUALITY, // cluster fit, intended for offline use
+} PLImageCompressionQuality;
+
+typedef enum PLImageMipmapFilter {
+	PL_IMAGE_MIPMAP_FILTER_BOX,    // 2x2 average
+	PL_IMAGE_MIPMAP_FILTER_KAISER, // Kaiser windowed sinc, sharper but slower
+} PLImageMipmapFilter;
+
+enum {
+	PL_BITFLAG( PL_IMAGE_MIPMAP_SRGB, 0 ),              // colour is sRGB encoded, so filter it in linear space
+	PL_BITFLAG( PL_IMAGE_MIPMAP_PRESERVE_COVERAGE, 1 ), // keep the alpha tested coverage of cutouts the same
+};
+
+typedef enum PLImageResizeFilter {
+	PL_IMAGE_RESIZE_FILTER_BOX,
+	PL_IMAGE_RESIZE_FILTER_BILINEAR,
+	PL_IMAGE_RESIZE_FILTER_LANCZOS3,
+	PL_IMAGE_RESIZE_FILTER_MITCHELL,
+} PLImageResizeFilter;
+
+typedef enum PLImageRotation {
+	PL_IMAGE_ROTATE_90,  // clockwise
+	PL_IMAGE_ROTATE_180,
+	PL_IMAGE_ROTATE_270, // i.e. 90 counter-clockwise
+} PLImageRotation;
+
+enum {
+	PL_BITFLAG( PL_IMAGE_FLAG_CONTIGUOUS_LEVELS, 0 ), // every level is within the allocation at data[ 0 ]
+};
+
 typedef struct PLImage {
 #if 1
 	uint8_t **data;
@@ -61,6 +96,13 @@ typedef struct PLImage {
 	unsigned int flags;
 } PLImage;
 
+/* where an image ended up within an atlas */
+typedef struct PLImageAtlasRect {
+	unsigned int x, y; /* in pixels, excluding padding */
+	unsigned int width, height;
+	float s0, t0, s1, t1;
+} PLImageAtlasRect;
+
 typedef struct PLPalette {
 	PLImageFormat format;
 	uint8_t *colours;
@@ -90,6 +132,7 @@ PL_EXTERN_C
 #if !defined( PL_COMPILE_PLUGIN )
 
 PL_EXTERN void PlRegisterImageLoader( const char *extension, PLImage *( *LoadImage )( const char *path ) );
+PL_EXTERN void PlRegisterImageFileLoader( const char *extension, PLImage *( *LoadImageFile )( PLFile *file ) );
 PL_EXTERN void PlRegisterStandardImageLoaders( unsigned int flags );
 PL_EXTERN void PlClearImageLoaders( void );
 
@@ -97,15 +140,27 @@ PL_EXTERN PLImage *PlCreateImage( uint8_t *buf, unsigned int w, unsigned int h,
 PL_EXTERN void PlDestroyImage( PLImage *image );
 
 PL_EXTERN PLImage *PlLoadImage( const char *path );
+PL_EXTERN PLImage *PlLoadImageFromFile( PLFile *file, const char *extension );
+PL_EXTERN PLImage *PlLoadImageFromMemory( const void *buf, size_t bufSize, const char *extension );
 PL_EXTERN bool PlWriteImage( const PLImage *image, const char *path );
 
 PL_EXTERN bool PlConvertPixelFormat( PLImage *image, PLImageFormat new_format );
+PL_EXTERN bool PlConvertPixels( const uint8_t *src, PLImageFormat srcFormat, uint8_t *dst, PLImageFormat dstFormat, size_t numPixels );
+PL_EXTERN bool PlCompressImage( PLImage *image, PLImageFormat format, PLImageCompressionQuality quality );
+PL_EXTERN bool PlGenerateImageMipmaps( PLImage *image, PLImageMipmapFilter filter, unsigned int flags );
+PL_EXTERN bool PlResizeImage( PLImage *image, unsigned int width, unsigned int height, PLImageResizeFilter filter );
+PL_EXTERN bool PlResizeImageToPowerOfTwo( PLImage *image, PLImageResizeFilter filter );
+PL_EXTERN PLImage *PlCreateImageAtlas( PLImage **images, unsigned int numImages, unsigned int padding, unsigned int alignment, unsigned int maxSize, PLImageAtlasRect *rects );
 //PL_EXTERN bool plConvertColourFormat( PLImage *image, PLColourFormat newFormat );
 
 PL_EXTERN void PlInvertImageColour( PLImage *image );
 PL_EXTERN void PlReplaceImageColour( PLImage *image, PLColour target, PLColour dest );
 
 PL_EXTERN bool PlFlipImageVertical( PLImage *image );
+PL_EXTERN bool PlFlipImageHorizontal( PLImage *image );
+PL_EXTERN bool PlRotateImage( PLImage *image, PLImageRotation rotation );
+PL_EXTERN bool PlSwizzleImageChannels( PLImage *image, const uint8_t swizzle[ 4 ] );
+PL_EXTERN bool PlPremultiplyImageAlpha( PLImage *image );
 
 PL_EXTERN unsigned int PlGetNumberOfColourChannels( PLColourFormat format );
 
@@ -8,6 +8,23 @@
 
 #include <plcore/pl.h>
 
+/* Vector instructions for the inline maths are chosen at compile time, as
+ * everything here is inlined into the caller. SSE2 is always available on
+ * x86-64, while AVX is only used when the including unit is built for it.
+ * Every path gives bit-identical results to the ...Scalar reference
+ * functions (so long as the compiler isn't contracting into FMAs), and
+ * defining PL_MATH_NO_SIMD forces the scalar paths throughout. */
+#if !defined( PL_MATH_NO_SIMD ) && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#	define PL_MATH_SSE2
+#	if defined( __AVX__ )
+#		define PL_MATH_AVX
+#		include <immintrin.h>
+#	else
+#		include <emmintrin.h>
+#	endif
+#	define PL_MATH_LOAD4( P, ALIGNED )     ( ( ALIGNED ) ? _mm_load_ps( P ) : _mm_loadu_ps( P ) )
+#endif
+
 PL_EXTERN_C
 
 // Base Defines
@@ -521,26 +538,6 @@ inline static void PlSetRectangleUniformColour( PLRectangle2D *r, PLColour colou
 	r->ll = r->lr = r->ul = r->ur = colour;
 }
 
-/////////////////////////////////////////////////////////////////////////////////////
-// Randomisation
-
-// http://stackoverflow.com/questions/7978759/generate-float-random-values-also-negative
-inline static double PlUniform0To1Random( void ) {
-	return ( rand() ) / ( ( double ) RAND_MAX + 1 );
-}
-
-inline static double PlGenerateUniformRandom( double minmax ) {
-	return ( minmax * 2 ) * PlUniform0To1Random() - minmax;
-}
-
-inline static double PlGenerateRandomDouble( double max ) {
-	return ( double ) ( rand() ) / ( RAND_MAX / max );
-}
-
-inline static float PlGenerateRandomFloat( float max ) {
-	return ( float ) ( rand() ) / ( RAND_MAX / max );
-}
-
 /////////////////////////////////////////////////////////////////////////////////////
 // Interpolation
 // http://paulbourke.net/miscellaneous/interpolation/
@@ -786,3 +783,5 @@ PL_EXTERN_C_END
 
 #include <plcore/pl_math_matrix.h>
 #include <plcore/pl_math_quaternion.h>
+#include <plcore/pl_math_batch.h>
+#include <plcore/pl_math_random.h>
@@ -0,0 +1,40 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Batches
+ * Operate on structure-of-arrays streams, with every component held in its
+ * own array, so that a whole register's worth of vectors are handled at
+ * once. The destination may be the same as a source, but mustn't otherwise
+ * overlap. Results are the same at every SIMD level, and match the
+ * per-element functions (for slerp, PlSlerpQuaternion). */
+
+typedef struct PLVector3SoA {
+	float *x;
+	float *y;
+	float *z;
+} PLVector3SoA;
+
+typedef struct PLQuaternionSoA {
+	float *x;
+	float *y;
+	float *z;
+	float *w;
+} PLQuaternionSoA;
+
+void PlTransformPoints3( const PLMatrix4 *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t num );
+void PlTransformDirections3( const PLMatrix4 *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t num );
+void PlNormalizeVectors3( const PLVector3SoA *src, const PLVector3SoA *dst, size_t num );
+void PlVector3DotProducts( const PLVector3SoA *a, const PLVector3SoA *b, float *dst, size_t num );
+void PlGetVector3Bounds( const PLVector3SoA *src, size_t num, PLVector3 *mins, PLVector3 *maxs );
+void PlLerpVectors3( const PLVector3SoA *a, const PLVector3SoA *b, float t, const PLVector3SoA *dst, size_t num );
+void PlSlerpQuaternions( const PLQuaternionSoA *a, const PLQuaternionSoA *b, float t, const PLQuaternionSoA *dst, size_t num );
+
+PL_EXTERN_C_END
@@ -206,7 +206,7 @@ inline static PLMatrix3 PlTransposeMatrix3( PLMatrix3 m, PLMatrix3 m2 ) {
 	return m;
 }
 
-inline static PLMatrix4 PlTransposeMatrix4( const PLMatrix4 *m ) {
+inline static PLMatrix4 PlTransposeMatrix4Scalar( const PLMatrix4 *m ) {
 	PLMatrix4 out;
 	for ( unsigned int j = 0; j < 4; ++j ) {
 		for ( unsigned int i = 0; i < 4; ++i ) {
@@ -217,6 +217,43 @@ inline static PLMatrix4 PlTransposeMatrix4( const PLMatrix4 *m ) {
 	return out;
 }
 
+#if defined( PL_MATH_SSE2 )
+/* aligned only applies to the input, the result is returned by value */
+inline static PLMatrix4 _plTransposeMatrix4Simd( const float *m, bool aligned ) {
+	__m128 r0 = PL_MATH_LOAD4( &m[ 0 ], aligned );
+	__m128 r1 = PL_MATH_LOAD4( &m[ 4 ], aligned );
+	__m128 r2 = PL_MATH_LOAD4( &m[ 8 ], aligned );
+	__m128 r3 = PL_MATH_LOAD4( &m[ 12 ], aligned );
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+	PLMatrix4 out;
+	_mm_storeu_ps( &out.m[ 0 ], r0 );
+	_mm_storeu_ps( &out.m[ 4 ], r1 );
+	_mm_storeu_ps( &out.m[ 8 ], r2 );
+	_mm_storeu_ps( &out.m[ 12 ], r3 );
+	return out;
+}
+#endif
+
+inline static PLMatrix4 PlTransposeMatrix4( const PLMatrix4 *m ) {
+#if defined( PL_MATH_SSE2 )
+	return _plTransposeMatrix4Simd( m->m, false );
+#else
+	return PlTransposeMatrix4Scalar( m );
+#endif
+}
+
+/**
+ * As above, but m must be 16-byte aligned (see PL_ALIGNED); out needn't be.
+ * Safe to call with out == m.
+ */
+inline static void PlTransposeMatrix4A( PLMatrix4 *out, const PLMatrix4 *m ) {
+#if defined( PL_MATH_SSE2 )
+	*out = _plTransposeMatrix4Simd( m->m, true );
+#else
+	*out = PlTransposeMatrix4Scalar( m );
+#endif
+}
+
 /* Add */
 
 inline static PLMatrix3 PlAddMatrix3( PLMatrix3 m, PLMatrix3 m2 ) {
@@ -229,11 +266,17 @@ inline static PLMatrix3 PlAddMatrix3( PLMatrix3 m, PLMatrix3 m2 ) {
 }
 
 inline static PLMatrix4 PlAddMatrix4( PLMatrix4 m, PLMatrix4 m2 ) {
+#if defined( PL_MATH_SSE2 )
+	for ( unsigned int i = 0; i < 16; i += 4 ) {
+		_mm_storeu_ps( &m.m[ i ], _mm_add_ps( _mm_loadu_ps( &m.m[ i ] ), _mm_loadu_ps( &m2.m[ i ] ) ) );
+	}
+#else
 	for ( unsigned int i = 0; i < 4; ++i ) {
 		for ( unsigned int j = 0; j < 4; ++j ) {
 			m.pl_m4pos( i, j ) += m2.pl_m4pos( i, j );
 		}
 	}
+#endif
 	return m;
 }
 
@@ -249,17 +292,27 @@ inline static PLMatrix3 PlSubtractMatrix3( PLMatrix3 m, PLMatrix3 m2 ) {
 }
 
 inline static PLMatrix4 PlSubtractMatrix4( PLMatrix4 m, PLMatrix4 m2 ) {
+#if defined( PL_MATH_SSE2 )
+	for ( unsigned int i = 0; i < 16; i += 4 ) {
+		_mm_storeu_ps( &m.m[ i ], _mm_sub_ps( _mm_loadu_ps( &m.m[ i ] ), _mm_loadu_ps( &m2.m[ i ] ) ) );
+	}
+#else
 	for ( unsigned int i = 0; i < 4; ++i ) {
 		for ( unsigned int j = 0; j < 4; ++j ) {
 			m.pl_m4pos( i, j ) -= m2.pl_m4pos( i, j );
 		}
 	}
+#endif
 	return m;
 }
 
 /* Multiply */
 
-inline static PLMatrix4 PlMultiplyMatrix4( PLMatrix4 m, PLMatrix4 m2 ) {
+/* The ...Scalar functions are the reference implementations; the vector
+ * paths evaluate the same operations in the same order, so results match
+ * them bit for bit. */
+
+inline static PLMatrix4 PlMultiplyMatrix4Scalar( PLMatrix4 m, PLMatrix4 m2 ) {
 	PLMatrix4 out;
 
 	out.m[ 0 ] = m.m[ 0 ] * m2.m[ 0 ] + m.m[ 4 ] * m2.m[ 1 ] + m.m[ 8 ] * m2.m[ 2 ] + m.m[ 12 ] * m2.m[ 3 ];
@@ -285,6 +338,137 @@ inline static PLMatrix4 PlMultiplyMatrix4( PLMatrix4 m, PLMatrix4 m2 ) {
 	return out;
 }
 
+#if defined( PL_MATH_SSE2 )
+#	define PL_MATH_COLUMN( OP, C0, C1, C2, C3, B )                        \
+		OP##add_ps( OP##add_ps( OP##add_ps(                                \
+		        OP##mul_ps( C0, OP##shuffle_ps( B, B, 0x00 ) ),             \
+		        OP##mul_ps( C1, OP##shuffle_ps( B, B, 0x55 ) ) ),           \
+		        OP##mul_ps( C2, OP##shuffle_ps( B, B, 0xAA ) ) ),           \
+		        OP##mul_ps( C3, OP##shuffle_ps( B, B, 0xFF ) ) )
+
+/* aligned only applies to the inputs, the result is returned by value */
+inline static PLMatrix4 _plMultiplyMatrix4Simd( const float *m, const float *m2, bool aligned ) {
+	PLMatrix4 out;
+#	if defined( PL_MATH_AVX )
+	/* two output columns at a time */
+	__m256 c0 = _mm256_broadcast_ps( ( const __m128 * ) &m[ 0 ] );
+	__m256 c1 = _mm256_broadcast_ps( ( const __m128 * ) &m[ 4 ] );
+	__m256 c2 = _mm256_broadcast_ps( ( const __m128 * ) &m[ 8 ] );
+	__m256 c3 = _mm256_broadcast_ps( ( const __m128 * ) &m[ 12 ] );
+	__m256 b0 = _mm256_loadu_ps( &m2[ 0 ] );
+	__m256 b1 = _mm256_loadu_ps( &m2[ 8 ] );
+	( void ) aligned;
+	_mm256_storeu_ps( &out.m[ 0 ], PL_MATH_COLUMN( _mm256_, c0, c1, c2, c3, b0 ) );
+	_mm256_storeu_ps( &out.m[ 8 ], PL_MATH_COLUMN( _mm256_, c0, c1, c2, c3, b1 ) );
+#	else
+	__m128 c0 = PL_MATH_LOAD4( &m[ 0 ], aligned );
+	__m128 c1 = PL_MATH_LOAD4( &m[ 4 ], aligned );
+	__m128 c2 = PL_MATH_LOAD4( &m[ 8 ], aligned );
+	__m128 c3 = PL_MATH_LOAD4( &m[ 12 ], aligned );
+	__m128 b0 = PL_MATH_LOAD4( &m2[ 0 ], aligned );
+	__m128 b1 = PL_MATH_LOAD4( &m2[ 4 ], aligned );
+	__m128 b2 = PL_MATH_LOAD4( &m2[ 8 ], aligned );
+	__m128 b3 = PL_MATH_LOAD4( &m2[ 12 ], aligned );
+	_mm_storeu_ps( &out.m[ 0 ], PL_MATH_COLUMN( _mm_, c0, c1, c2, c3, b0 ) );
+	_mm_storeu_ps( &out.m[ 4 ], PL_MATH_COLUMN( _mm_, c0, c1, c2, c3, b1 ) );
+	_mm_storeu_ps( &out.m[ 8 ], PL_MATH_COLUMN( _mm_, c0, c1, c2, c3, b2 ) );
+	_mm_storeu_ps( &out.m[ 12 ], PL_MATH_COLUMN( _mm_, c0, c1, c2, c3, b3 ) );
+#	endif
+	return out;
+}
+
+#	undef PL_MATH_COLUMN
+#endif
+
+inline static PLMatrix4 PlMultiplyMatrix4( PLMatrix4 m, PLMatrix4 m2 ) {
+#if defined( PL_MATH_SSE2 )
+	return _plMultiplyMatrix4Simd( m.m, m2.m, false );
+#else
+	return PlMultiplyMatrix4Scalar( m, m2 );
+#endif
+}
+
+/**
+ * As above, but m and m2 must be 16-byte aligned (see PL_ALIGNED); out needn't be.
+ * Safe to call with out aliasing either input.
+ */
+inline static void PlMultiplyMatrix4A( PLMatrix4 *out, const PLMatrix4 *m, const PLMatrix4 *m2 ) {
+#if defined( PL_MATH_SSE2 )
+	*out = _plMultiplyMatrix4Simd( m->m, m2->m, true );
+#else
+	*out = PlMultiplyMatrix4Scalar( *m, *m2 );
+#endif
+}
+
+/* Transform */
+
+inline static PLVector4 PlTransformVector4Scalar( const PLMatrix4 *m, PLVector4 v ) {
+	return PLVector4(
+	        m->m[ 0 ] * v.x + m->m[ 4 ] * v.y + m->m[ 8 ] * v.z + m->m[ 12 ] * v.w,
+	        m->m[ 1 ] * v.x + m->m[ 5 ] * v.y + m->m[ 9 ] * v.z + m->m[ 13 ] * v.w,
+	        m->m[ 2 ] * v.x + m->m[ 6 ] * v.y + m->m[ 10 ] * v.z + m->m[ 14 ] * v.w,
+	        m->m[ 3 ] * v.x + m->m[ 7 ] * v.y + m->m[ 11 ] * v.z + m->m[ 15 ] * v.w );
+}
+
+inline static PLVector3 PlTransformPoint3Scalar( const PLMatrix4 *m, PLVector3 v ) {
+	return PLVector3(
+	        m->m[ 0 ] * v.x + m->m[ 4 ] * v.y + m->m[ 8 ] * v.z + m->m[ 12 ],
+	        m->m[ 1 ] * v.x + m->m[ 5 ] * v.y + m->m[ 9 ] * v.z + m->m[ 13 ],
+	        m->m[ 2 ] * v.x + m->m[ 6 ] * v.y + m->m[ 10 ] * v.z + m->m[ 14 ] );
+}
+
+inline static PLVector3 PlTransformDirection3Scalar( const PLMatrix4 *m, PLVector3 v ) {
+	return PLVector3(
+	        m->m[ 0 ] * v.x + m->m[ 4 ] * v.y + m->m[ 8 ] * v.z,
+	        m->m[ 1 ] * v.x + m->m[ 5 ] * v.y + m->m[ 9 ] * v.z,
+	        m->m[ 2 ] * v.x + m->m[ 6 ] * v.y + m->m[ 10 ] * v.z );
+}
+
+#if defined( PL_MATH_SSE2 )
+inline static __m128 _plTransformVector4Simd( const PLMatrix4 *m, float x, float y, float z ) {
+	__m128 r = _mm_mul_ps( _mm_loadu_ps( &m->m[ 0 ] ), _mm_set1_ps( x ) );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &m->m[ 4 ] ), _mm_set1_ps( y ) ) );
+	return _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &m->m[ 8 ] ), _mm_set1_ps( z ) ) );
+}
+#endif
+
+/**
+ * Multiplies the given column vector by m.
+ */
+inline static PLVector4 PlTransformVector4( const PLMatrix4 *m, PLVector4 v ) {
+#if defined( PL_MATH_SSE2 )
+	__m128 r = _plTransformVector4Simd( m, v.x, v.y, v.z );
+	r = _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &m->m[ 12 ] ), _mm_set1_ps( v.w ) ) );
+	PLVector4 out;
+	_mm_storeu_ps( &out.x, r );
+	return out;
+#else
+	return PlTransformVector4Scalar( m, v );
+#endif
+}
+
+/**
+ * Transforms a point by m, i.e. with an implied w of 1.
+ */
+inline static PLVector3 PlTransformPoint3( const PLMatrix4 *m, PLVector3 v ) {
+#if defined( PL_MATH_SSE2 )
+	return _plStoreVector3( _mm_add_ps( _plTransformVector4Simd( m, v.x, v.y, v.z ), _mm_loadu_ps( &m->m[ 12 ] ) ) );
+#else
+	return PlTransformPoint3Scalar( m, v );
+#endif
+}
+
+/**
+ * Transforms a direction by m, ignoring any translation.
+ */
+inline static PLVector3 PlTransformDirection3( const PLMatrix4 *m, PLVector3 v ) {
+#if defined( PL_MATH_SSE2 )
+	return _plStoreVector3( _plTransformVector4Simd( m, v.x, v.y, v.z ) );
+#else
+	return PlTransformDirection3Scalar( m, v );
+#endif
+}
+
 /* Rotate */
 
 inline static PLMatrix4 PlRotateMatrix4( float angle, PLVector3 axis ) {
@@ -377,136 +561,169 @@ inline static PLMatrix4 PlTranslateMatrix4( PLVector3 v ) {
 	return m;
 }
 
-inline static PLMatrix4 PlInverseMatrix4( PLMatrix4 m ) {
-	PLMatrix4 out;
+/* Inverse
+ * Expands by the 2x2 sub-determinants of each pair of columns, which maps
+ * neatly onto 4-wide registers; the scalar version walks the same terms. */
+
+inline static bool _plInverseMatrix4Scalar( PLMatrix4 *out, const PLMatrix4 *m ) {
+	static const unsigned int pairs[ 6 ][ 2 ] = {
+	        {0, 1},
+	        {0, 2},
+	        {0, 3},
+	        {1, 2},
+	        {1, 3},
+	        {2, 3},
+	};
+	/* column a * det b - column c * det d + column e * det f */
+	static const unsigned int terms[ 4 ][ 6 ] = {
+	        {1, 5, 2, 4, 3, 3},
+	        {0, 5, 2, 2, 3, 1},
+	        {0, 4, 1, 2, 3, 0},
+	        {0, 3, 1, 1, 2, 0},
+	};
+
+	float c[ 4 ][ 4 ];
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		for ( unsigned int j = 0; j < 4; ++j ) {
+			c[ i ][ j ] = m->m[ j * 4 + i ];
+		}
+	}
 
-	out.m[ 0 ] =
-	        m.m[ 5 ] * m.m[ 10 ] * m.m[ 15 ] -
-	        m.m[ 5 ] * m.m[ 11 ] * m.m[ 14 ] -
-	        m.m[ 9 ] * m.m[ 6 ] * m.m[ 15 ] +
-	        m.m[ 9 ] * m.m[ 7 ] * m.m[ 14 ] +
-	        m.m[ 13 ] * m.m[ 6 ] * m.m[ 11 ] -
-	        m.m[ 13 ] * m.m[ 7 ] * m.m[ 10 ];
-	out.m[ 4 ] =
-	        -m.m[ 4 ] * m.m[ 10 ] * m.m[ 15 ] +
-	        m.m[ 4 ] * m.m[ 11 ] * m.m[ 14 ] +
-	        m.m[ 8 ] * m.m[ 6 ] * m.m[ 15 ] -
-	        m.m[ 8 ] * m.m[ 7 ] * m.m[ 14 ] -
-	        m.m[ 12 ] * m.m[ 6 ] * m.m[ 11 ] +
-	        m.m[ 12 ] * m.m[ 7 ] * m.m[ 10 ];
-	out.m[ 8 ] =
-	        m.m[ 4 ] * m.m[ 9 ] * m.m[ 15 ] -
-	        m.m[ 4 ] * m.m[ 11 ] * m.m[ 13 ] -
-	        m.m[ 8 ] * m.m[ 5 ] * m.m[ 15 ] +
-	        m.m[ 8 ] * m.m[ 7 ] * m.m[ 13 ] +
-	        m.m[ 12 ] * m.m[ 5 ] * m.m[ 11 ] -
-	        m.m[ 12 ] * m.m[ 7 ] * m.m[ 9 ];
-	out.m[ 12 ] =
-	        -m.m[ 4 ] * m.m[ 9 ] * m.m[ 14 ] +
-	        m.m[ 4 ] * m.m[ 10 ] * m.m[ 13 ] +
-	        m.m[ 8 ] * m.m[ 5 ] * m.m[ 14 ] -
-	        m.m[ 8 ] * m.m[ 6 ] * m.m[ 13 ] -
-	        m.m[ 12 ] * m.m[ 5 ] * m.m[ 10 ] +
-	        m.m[ 12 ] * m.m[ 6 ] * m.m[ 9 ];
-	out.m[ 1 ] =
-	        -m.m[ 1 ] * m.m[ 10 ] * m.m[ 15 ] +
-	        m.m[ 1 ] * m.m[ 11 ] * m.m[ 14 ] +
-	        m.m[ 9 ] * m.m[ 2 ] * m.m[ 15 ] -
-	        m.m[ 9 ] * m.m[ 3 ] * m.m[ 14 ] -
-	        m.m[ 13 ] * m.m[ 2 ] * m.m[ 11 ] +
-	        m.m[ 13 ] * m.m[ 3 ] * m.m[ 10 ];
-	out.m[ 5 ] =
-	        m.m[ 0 ] * m.m[ 10 ] * m.m[ 15 ] -
-	        m.m[ 0 ] * m.m[ 11 ] * m.m[ 14 ] -
-	        m.m[ 8 ] * m.m[ 2 ] * m.m[ 15 ] +
-	        m.m[ 8 ] * m.m[ 3 ] * m.m[ 14 ] +
-	        m.m[ 12 ] * m.m[ 2 ] * m.m[ 11 ] -
-	        m.m[ 12 ] * m.m[ 3 ] * m.m[ 10 ];
-	out.m[ 9 ] =
-	        -m.m[ 0 ] * m.m[ 9 ] * m.m[ 15 ] +
-	        m.m[ 0 ] * m.m[ 11 ] * m.m[ 13 ] +
-	        m.m[ 8 ] * m.m[ 1 ] * m.m[ 15 ] -
-	        m.m[ 8 ] * m.m[ 3 ] * m.m[ 13 ] -
-	        m.m[ 12 ] * m.m[ 1 ] * m.m[ 11 ] +
-	        m.m[ 12 ] * m.m[ 3 ] * m.m[ 9 ];
-	out.m[ 13 ] =
-	        m.m[ 0 ] * m.m[ 9 ] * m.m[ 14 ] -
-	        m.m[ 0 ] * m.m[ 10 ] * m.m[ 13 ] -
-	        m.m[ 8 ] * m.m[ 1 ] * m.m[ 14 ] +
-	        m.m[ 8 ] * m.m[ 2 ] * m.m[ 13 ] +
-	        m.m[ 12 ] * m.m[ 1 ] * m.m[ 10 ] -
-	        m.m[ 12 ] * m.m[ 2 ] * m.m[ 9 ];
-	out.m[ 2 ] =
-	        m.m[ 1 ] * m.m[ 6 ] * m.m[ 15 ] -
-	        m.m[ 1 ] * m.m[ 7 ] * m.m[ 14 ] -
-	        m.m[ 5 ] * m.m[ 2 ] * m.m[ 15 ] +
-	        m.m[ 5 ] * m.m[ 3 ] * m.m[ 14 ] +
-	        m.m[ 13 ] * m.m[ 2 ] * m.m[ 7 ] -
-	        m.m[ 13 ] * m.m[ 3 ] * m.m[ 6 ];
-	out.m[ 6 ] =
-	        -m.m[ 0 ] * m.m[ 6 ] * m.m[ 15 ] +
-	        m.m[ 0 ] * m.m[ 7 ] * m.m[ 14 ] +
-	        m.m[ 4 ] * m.m[ 2 ] * m.m[ 15 ] -
-	        m.m[ 4 ] * m.m[ 3 ] * m.m[ 14 ] -
-	        m.m[ 12 ] * m.m[ 2 ] * m.m[ 7 ] +
-	        m.m[ 12 ] * m.m[ 3 ] * m.m[ 6 ];
-	out.m[ 10 ] =
-	        m.m[ 0 ] * m.m[ 5 ] * m.m[ 15 ] -
-	        m.m[ 0 ] * m.m[ 7 ] * m.m[ 13 ] -
-	        m.m[ 4 ] * m.m[ 1 ] * m.m[ 15 ] +
-	        m.m[ 4 ] * m.m[ 3 ] * m.m[ 13 ] +
-	        m.m[ 12 ] * m.m[ 1 ] * m.m[ 7 ] -
-	        m.m[ 12 ] * m.m[ 3 ] * m.m[ 5 ];
-	out.m[ 14 ] =
-	        -m.m[ 0 ] * m.m[ 5 ] * m.m[ 14 ] +
-	        m.m[ 0 ] * m.m[ 6 ] * m.m[ 13 ] +
-	        m.m[ 4 ] * m.m[ 1 ] * m.m[ 14 ] -
-	        m.m[ 4 ] * m.m[ 2 ] * m.m[ 13 ] -
-	        m.m[ 12 ] * m.m[ 1 ] * m.m[ 6 ] +
-	        m.m[ 12 ] * m.m[ 2 ] * m.m[ 5 ];
-	out.m[ 3 ] =
-	        -m.m[ 1 ] * m.m[ 6 ] * m.m[ 11 ] +
-	        m.m[ 1 ] * m.m[ 7 ] * m.m[ 10 ] +
-	        m.m[ 5 ] * m.m[ 2 ] * m.m[ 11 ] -
-	        m.m[ 5 ] * m.m[ 3 ] * m.m[ 10 ] -
-	        m.m[ 9 ] * m.m[ 2 ] * m.m[ 7 ] +
-	        m.m[ 9 ] * m.m[ 3 ] * m.m[ 6 ];
-	out.m[ 7 ] =
-	        m.m[ 0 ] * m.m[ 6 ] * m.m[ 11 ] -
-	        m.m[ 0 ] * m.m[ 7 ] * m.m[ 10 ] -
-	        m.m[ 4 ] * m.m[ 2 ] * m.m[ 11 ] +
-	        m.m[ 4 ] * m.m[ 3 ] * m.m[ 10 ] +
-	        m.m[ 8 ] * m.m[ 2 ] * m.m[ 7 ] -
-	        m.m[ 8 ] * m.m[ 3 ] * m.m[ 6 ];
-	out.m[ 11 ] =
-	        -m.m[ 0 ] * m.m[ 5 ] * m.m[ 11 ] +
-	        m.m[ 0 ] * m.m[ 7 ] * m.m[ 9 ] +
-	        m.m[ 4 ] * m.m[ 1 ] * m.m[ 11 ] -
-	        m.m[ 4 ] * m.m[ 3 ] * m.m[ 9 ] -
-	        m.m[ 8 ] * m.m[ 1 ] * m.m[ 7 ] +
-	        m.m[ 8 ] * m.m[ 3 ] * m.m[ 5 ];
-	out.m[ 15 ] =
-	        m.m[ 0 ] * m.m[ 5 ] * m.m[ 10 ] -
-	        m.m[ 0 ] * m.m[ 6 ] * m.m[ 9 ] -
-	        m.m[ 4 ] * m.m[ 1 ] * m.m[ 10 ] +
-	        m.m[ 4 ] * m.m[ 2 ] * m.m[ 9 ] +
-	        m.m[ 8 ] * m.m[ 1 ] * m.m[ 6 ] -
-	        m.m[ 8 ] * m.m[ 2 ] * m.m[ 5 ];
-
-	float d = m.m[ 0 ] * out.m[ 0 ] + m.m[ 1 ] * out.m[ 4 ] + m.m[ 2 ] * out.m[ 8 ] + m.m[ 3 ] * out.m[ 12 ];
-	if ( d == 0 ) {
-		return m;
-	}
-
-	d = 1.0f / d;
+	float d[ 6 ][ 2 ];
+	for ( unsigned int k = 0; k < 6; ++k ) {
+		const float *a = c[ pairs[ k ][ 0 ] ], *b = c[ pairs[ k ][ 1 ] ];
+		d[ k ][ 0 ] = a[ 2 ] * b[ 3 ] - a[ 3 ] * b[ 2 ];
+		d[ k ][ 1 ] = a[ 0 ] * b[ 1 ] - a[ 1 ] * b[ 0 ];
+	}
+
+	PLMatrix4 r;
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		const unsigned int *t = terms[ i ];
+		for ( unsigned int j = 0; j < 4; ++j ) {
+			unsigned int p = j ^ 1, h = j >> 1;
+			float v = ( c[ t[ 0 ] ][ p ] * d[ t[ 1 ] ][ h ] - c[ t[ 2 ] ][ p ] * d[ t[ 3 ] ][ h ] ) + c[ t[ 4 ] ][ p ] * d[ t[ 5 ] ][ h ];
+			r.m[ i * 4 + j ] = ( ( i + j ) & 1 ) ? -v : v;
+		}
+	}
+
+	float det = m->m[ 0 ] * r.m[ 0 ] + m->m[ 1 ] * r.m[ 4 ] + m->m[ 2 ] * r.m[ 8 ] + m->m[ 3 ] * r.m[ 12 ];
+	if ( det == 0 ) {
+		return false;
+	}
 
+	det = 1.0f / det;
 	for ( unsigned int i = 0; i < 16; ++i ) {
-		out.m[ i ] *= d;
+		out->m[ i ] = r.m[ i ] * det;
 	}
 
+	return true;
+}
+
+inline static PLMatrix4 PlInverseMatrix4Scalar( PLMatrix4 m ) {
+	PLMatrix4 out;
+	return _plInverseMatrix4Scalar( &out, &m ) ? out : m;
+}
+
+#if defined( PL_MATH_SSE2 )
+#	define PL_MATH_LO( V )   _mm_shuffle_ps( V, V, _MM_SHUFFLE( 0, 0, 2, 2 ) )
+#	define PL_MATH_HI( V )   _mm_shuffle_ps( V, V, _MM_SHUFFLE( 1, 1, 3, 3 ) )
+#	define PL_MATH_SWAP( V ) _mm_shuffle_ps( V, V, _MM_SHUFFLE( 2, 3, 0, 1 ) )
+#	define PL_MATH_DET2( A, B ) \
+		_mm_sub_ps( _mm_mul_ps( PL_MATH_LO( A ), PL_MATH_HI( B ) ), _mm_mul_ps( PL_MATH_HI( A ), PL_MATH_LO( B ) ) )
+#	define PL_MATH_COFACTOR( A, DA, B, DB, C, DC, SIGN ) \
+		_mm_xor_ps( _mm_add_ps( _mm_sub_ps( _mm_mul_ps( A, DA ), _mm_mul_ps( B, DB ) ), _mm_mul_ps( C, DC ) ), SIGN )
+
+/* hands back m itself if it's singular, aligned only applies to the input */
+inline static PLMatrix4 _plInverseMatrix4Simd( const float *m, bool aligned, bool *isInvertible ) {
+	const __m128 m0 = PL_MATH_LOAD4( &m[ 0 ], aligned );
+	const __m128 m1 = PL_MATH_LOAD4( &m[ 4 ], aligned );
+	const __m128 m2 = PL_MATH_LOAD4( &m[ 8 ], aligned );
+	const __m128 m3 = PL_MATH_LOAD4( &m[ 12 ], aligned );
+	__m128 c0 = m0, c1 = m1, c2 = m2, c3 = m3;
+	_MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+	__m128 d0 = PL_MATH_DET2( c0, c1 );
+	__m128 d1 = PL_MATH_DET2( c0, c2 );
+	__m128 d2 = PL_MATH_DET2( c0, c3 );
+	__m128 d3 = PL_MATH_DET2( c1, c2 );
+	__m128 d4 = PL_MATH_DET2( c1, c3 );
+	__m128 d5 = PL_MATH_DET2( c2, c3 );
+
+	c0 = PL_MATH_SWAP( c0 );
+	c1 = PL_MATH_SWAP( c1 );
+	c2 = PL_MATH_SWAP( c2 );
+	c3 = PL_MATH_SWAP( c3 );
+
+	const __m128 even = _mm_setr_ps( 0.0f, -0.0f, 0.0f, -0.0f );
+	const __m128 odd = _mm_setr_ps( -0.0f, 0.0f, -0.0f, 0.0f );
+	__m128 r0 = PL_MATH_COFACTOR( c1, d5, c2, d4, c3, d3, even );
+	__m128 r1 = PL_MATH_COFACTOR( c0, d5, c2, d2, c3, d1, odd );
+	__m128 r2 = PL_MATH_COFACTOR( c0, d4, c1, d2, c3, d0, even );
+	__m128 r3 = PL_MATH_COFACTOR( c0, d3, c1, d1, c2, d0, odd );
+
+	/* first element of each row against the first column */
+	__m128 lead = _mm_movelh_ps( _mm_unpacklo_ps( r0, r1 ), _mm_unpacklo_ps( r2, r3 ) );
+	__m128 p = _mm_mul_ps( m0, lead );
+	__m128 det = _mm_add_ss( p, _mm_shuffle_ps( p, p, 1 ) );
+	det = _mm_add_ss( det, _mm_movehl_ps( p, p ) );
+	det = _mm_add_ss( det, _mm_shuffle_ps( p, p, 3 ) );
+	PLMatrix4 out;
+	*isInvertible = ( _mm_cvtss_f32( det ) != 0 );
+	if ( !*isInvertible ) {
+		_mm_storeu_ps( &out.m[ 0 ], m0 );
+		_mm_storeu_ps( &out.m[ 4 ], m1 );
+		_mm_storeu_ps( &out.m[ 8 ], m2 );
+		_mm_storeu_ps( &out.m[ 12 ], m3 );
+		return out;
+	}
+
+	det = _mm_div_ss( _mm_set_ss( 1.0f ), det );
+	det = _mm_shuffle_ps( det, det, 0 );
+	_mm_storeu_ps( &out.m[ 0 ], _mm_mul_ps( r0, det ) );
+	_mm_storeu_ps( &out.m[ 4 ], _mm_mul_ps( r1, det ) );
+	_mm_storeu_ps( &out.m[ 8 ], _mm_mul_ps( r2, det ) );
+	_mm_storeu_ps( &out.m[ 12 ], _mm_mul_ps( r3, det ) );
 	return out;
 }
 
+#	undef PL_MATH_LO
+#	undef PL_MATH_HI
+#	undef PL_MATH_SWAP
+#	undef PL_MATH_DET2
+#	undef PL_MATH_COFACTOR
+#endif
+
+/**
+ * Returns the inverse of m, or m itself if it's singular.
+ */
+inline static PLMatrix4 PlInverseMatrix4( PLMatrix4 m ) {
+#if defined( PL_MATH_SSE2 )
+	bool isInvertible;
+	return _plInverseMatrix4Simd( m.m, false, &isInvertible );
+#else
+	return PlInverseMatrix4Scalar( m );
+#endif
+}
+
+/**
+ * As above, but m must be 16-byte aligned (see PL_ALIGNED); out needn't be.
+ * Returns false, leaving out untouched, if m is singular.
+ */
+inline static bool PlInverseMatrix4A( PLMatrix4 *out, const PLMatrix4 *m ) {
+#if defined( PL_MATH_SSE2 )
+	bool isInvertible;
+	PLMatrix4 inverse = _plInverseMatrix4Simd( m->m, true, &isInvertible );
+	if ( !isInvertible ) {
+		return false;
+	}
+
+	*out = inverse;
+	return true;
+#else
+	return _plInverseMatrix4Scalar( out, m );
+#endif
+}
+
 inline static PLMatrix4 PlLookAt( PLVector3 eye, PLVector3 center, PLVector3 up ) {
 	PLVector3 f = PlNormalizeVector3( PlSubtractVector3( center, eye ) );
 	PLVector3 u = PlNormalizeVector3( up );
@@ -606,10 +823,40 @@ typedef enum PLMatrixMode {
 	PL_NUM_MATRIX_MODES
 } PLMatrixMode;
 
+/* Every stack is independent, so one can be kept per thread or per scene.
+ * The functions further down that don't take a stack work on the default
+ * one, which is shared and therefore shouldn't be touched from more than
+ * one thread. */
+
+typedef struct PLMatrixStack PLMatrixStack;
+
+PLMatrixStack *PlCreateMatrixStack( void );
+void PlDestroyMatrixStack( PLMatrixStack *stack );
+PLMatrixStack *PlGetDefaultMatrixStack( void );
+
+void PlSetStackMatrixMode( PLMatrixStack *stack, PLMatrixMode mode );
+PLMatrixMode PlGetStackMatrixMode( const PLMatrixStack *stack );
+
+const PLMatrix4 *PlGetStackMatrix( const PLMatrixStack *stack, PLMatrixMode mode );
+const PLMatrix4 *PlGetStackModelViewProjection( PLMatrixStack *stack );
+void PlLoadStackMatrix( PLMatrixStack *stack, const PLMatrix4 *matrix );
+void PlLoadStackIdentityMatrix( PLMatrixStack *stack );
+
+void PlMultiStackMatrix( PLMatrixStack *stack, const PLMatrix4 *matrix );
+void PlRotateStackMatrix( PLMatrixStack *stack, float angle, float x, float y, float z );
+void PlTranslateStackMatrix( PLMatrixStack *stack, PLVector3 vector );
+void PlScaleStackMatrix( PLMatrixStack *stack, PLVector3 scale );
+
+void PlPushStackMatrix( PLMatrixStack *stack );
+void PlPopStackMatrix( PLMatrixStack *stack );
+
+/* Default stack */
+
 void PlMatrixMode( PLMatrixMode mode );
 PLMatrixMode PlGetMatrixMode( void );
 
 PLMatrix4 *PlGetMatrix( PLMatrixMode mode );
+const PLMatrix4 *PlGetModelViewProjectionMatrix( void );
 void PlLoadMatrix( const PLMatrix4 *matrix );
 void PlLoadIdentityMatrix( void );
 
@@ -27,7 +27,7 @@ typedef struct PLQuaternion {
 
 #endif
 
-inline static PLQuaternion PlMultiplyQuaternion( const PLQuaternion* q, const PLQuaternion* q2 ) {
+inline static PLQuaternion PlMultiplyQuaternionScalar( const PLQuaternion* q, const PLQuaternion* q2 ) {
 	return PLQuaternion
 	(
 		( q->x * q2->w ) + ( q->w * q2->x ) + ( q->y * q2->z ) - ( q->z * q2->y ),
@@ -37,7 +37,7 @@ inline static PLQuaternion PlMultiplyQuaternion( const PLQuaternion* q, const PL
 	);
 }
 
-inline static PLQuaternion PlMultiplyQuaternion3FV( const PLQuaternion* q, const PLVector3* v ) {
+inline static PLQuaternion PlMultiplyQuaternion3FVScalar( const PLQuaternion* q, const PLVector3* v ) {
 	return PLQuaternion
 	(
 		( q->w * v->x ) + ( q->y * v->z ) - ( q->z * v->y ),
@@ -47,6 +47,50 @@ inline static PLQuaternion PlMultiplyQuaternion3FV( const PLQuaternion* q, const
 	);
 }
 
+/* The vector paths below negate the w lane of products by flipping the sign
+ * bit, so the sums still match the scalar versions bit for bit. */
+
+#if defined( PL_MATH_SSE2 )
+#	define PL_MATH_SWIZZLE( V, X, Y, Z, W ) _mm_shuffle_ps( V, V, _MM_SHUFFLE( W, Z, Y, X ) )
+#endif
+
+inline static PLQuaternion PlMultiplyQuaternion( const PLQuaternion* q, const PLQuaternion* q2 ) {
+#if defined( PL_MATH_SSE2 )
+	const __m128 sign = _mm_setr_ps( 0.0f, 0.0f, 0.0f, -0.0f );
+	__m128 a = _mm_loadu_ps( &q->x );
+	__m128 b = _mm_loadu_ps( &q2->x );
+	__m128 r = _mm_mul_ps( a, PL_MATH_SWIZZLE( b, 3, 3, 3, 3 ) );
+	r = _mm_add_ps( r, _mm_xor_ps( _mm_mul_ps( PL_MATH_SWIZZLE( a, 3, 3, 3, 0 ), PL_MATH_SWIZZLE( b, 0, 1, 2, 0 ) ), sign ) );
+	r = _mm_add_ps( r, _mm_xor_ps( _mm_mul_ps( PL_MATH_SWIZZLE( a, 1, 2, 0, 1 ), PL_MATH_SWIZZLE( b, 2, 0, 1, 1 ) ), sign ) );
+	r = _mm_sub_ps( r, _mm_mul_ps( PL_MATH_SWIZZLE( a, 2, 0, 1, 2 ), PL_MATH_SWIZZLE( b, 1, 2, 0, 2 ) ) );
+	PLQuaternion out;
+	_mm_storeu_ps( &out.x, r );
+	return out;
+#else
+	return PlMultiplyQuaternionScalar( q, q2 );
+#endif
+}
+
+inline static PLQuaternion PlMultiplyQuaternion3FV( const PLQuaternion* q, const PLVector3* v ) {
+#if defined( PL_MATH_SSE2 )
+	const __m128 sign = _mm_setr_ps( 0.0f, 0.0f, 0.0f, -0.0f );
+	__m128 a = _mm_loadu_ps( &q->x );
+	__m128 b = _mm_setr_ps( v->x, v->y, v->z, 0.0f );
+	__m128 r = _mm_xor_ps( _mm_mul_ps( PL_MATH_SWIZZLE( a, 3, 3, 3, 0 ), PL_MATH_SWIZZLE( b, 0, 1, 2, 0 ) ), sign );
+	r = _mm_add_ps( r, _mm_xor_ps( _mm_mul_ps( PL_MATH_SWIZZLE( a, 1, 2, 0, 1 ), PL_MATH_SWIZZLE( b, 2, 0, 1, 1 ) ), sign ) );
+	r = _mm_sub_ps( r, _mm_mul_ps( PL_MATH_SWIZZLE( a, 2, 0, 1, 2 ), PL_MATH_SWIZZLE( b, 1, 2, 0, 2 ) ) );
+	PLQuaternion out;
+	_mm_storeu_ps( &out.x, r );
+	return out;
+#else
+	return PlMultiplyQuaternion3FVScalar( q, v );
+#endif
+}
+
+#if defined( PL_MATH_SSE2 )
+#	undef PL_MATH_SWIZZLE
+#endif
+
 inline static PLQuaternion PlScaleQuaternion( const PLQuaternion* q, float a ) {
 	return PLQuaternion( q->x * a, q->y * a, q->z * a, q->w * a );
 }
@@ -92,6 +136,74 @@ inline static void PlComputeQuaternionW( PLQuaternion* q ) {
 	}
 }
 
+/* Slerp
+ * Weights come from Eberly's polynomial fit of sin(t*theta)/sin(theta) in
+ * terms of cos(theta), "A Fast and Accurate Algorithm for Computing SLERP",
+ * which needs no trigonometry and vectorises well; they're within 2e-5 of
+ * the exact weights. */
+
+#define PL_SLERP_TERMS 8
+
+inline static void _plGetSlerpCoefficients( float t, float *c ) {
+	static const float u[ PL_SLERP_TERMS ] = {
+	        1.0f / ( 1.0f * 3.0f ),
+	        1.0f / ( 2.0f * 5.0f ),
+	        1.0f / ( 3.0f * 7.0f ),
+	        1.0f / ( 4.0f * 9.0f ),
+	        1.0f / ( 5.0f * 11.0f ),
+	        1.0f / ( 6.0f * 13.0f ),
+	        1.0f / ( 7.0f * 15.0f ),
+	        1.85298109240830f / ( 8.0f * 17.0f ),
+	};
+	static const float v[ PL_SLERP_TERMS ] = {
+	        1.0f / 3.0f,
+	        2.0f / 5.0f,
+	        3.0f / 7.0f,
+	        4.0f / 9.0f,
+	        5.0f / 11.0f,
+	        6.0f / 13.0f,
+	        7.0f / 15.0f,
+	        1.85298109240830f * 8.0f / 17.0f,
+	};
+	float t2 = t * t;
+	for ( unsigned int i = 0; i < PL_SLERP_TERMS; ++i ) {
+		c[ i ] = u[ i ] * t2 - v[ i ];
+	}
+}
+
+/* cosm1 is the cosine of the angle between the two, minus one */
+inline static float _plGetSlerpWeight( const float *c, float t, float cosm1 ) {
+	float f = 1.0f;
+	for ( int i = PL_SLERP_TERMS - 1; i >= 0; --i ) {
+		f = 1.0f + ( c[ i ] * cosm1 ) * f;
+	}
+	return t * f;
+}
+
+/**
+ * Spherically interpolates from q to q2 along the shortest arc.
+ */
+inline static PLQuaternion PlSlerpQuaternion( const PLQuaternion* q, const PLQuaternion* q2, float t ) {
+	float ca[ PL_SLERP_TERMS ], cb[ PL_SLERP_TERMS ];
+	_plGetSlerpCoefficients( 1.0f - t, ca );
+	_plGetSlerpCoefficients( t, cb );
+
+	float d = q->x * q2->x + q->y * q2->y + q->z * q2->z + q->w * q2->w;
+	bool flip = signbit( d );
+	float cosm1 = ( flip ? -d : d ) - 1.0f;
+	float wa = _plGetSlerpWeight( ca, 1.0f - t, cosm1 );
+	float wb = _plGetSlerpWeight( cb, t, cosm1 );
+	if ( flip ) {
+		wb = -wb;
+	}
+
+	return PLQuaternion(
+	        wa * q->x + wb * q2->x,
+	        wa * q->y + wb * q2->y,
+	        wa * q->z + wb * q2->z,
+	        wa * q->w + wb * q2->w );
+}
+
 /* pulled from here: http://tfc.duke.free.fr/coding/md5-specs-en.html */
 inline static PLQuaternion PlRotateQuaternionPoint( const PLQuaternion* q, const PLVector3* point ) {
 	PLQuaternion b = PlInverseQuaternion( q );
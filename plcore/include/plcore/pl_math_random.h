@@ -0,0 +1,60 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Random
+ * xoshiro256** generators. Each PLRandom is independent, so give every
+ * thread or system its own rather than sharing one; PlGetThreadRandom
+ * provides one per thread for anything that doesn't care. The same seed
+ * always produces the same sequence, and the bulk fills produce the same
+ * results at every SIMD level. None of this is suitable for anything that
+ * needs to be secure. */
+
+typedef struct PLRandom {
+	uint64_t s[ 4 ];
+} PLRandom;
+
+void PlSeedRandom( PLRandom *rng, uint64_t seed );
+PLRandom *PlGetThreadRandom( void );
+
+uint64_t PlRandomUInt64( PLRandom *rng );
+uint32_t PlRandomUInt32( PLRandom *rng );
+uint32_t PlRandomBoundedUInt32( PLRandom *rng, uint32_t bound );
+float PlRandomFloat( PLRandom *rng );
+double PlRandomDouble( PLRandom *rng );
+float PlRandomFloatRange( PLRandom *rng, float min, float max );
+float PlRandomNormal( PLRandom *rng, float mean, float deviation );
+PLVector3 PlRandomOnSphere( PLRandom *rng );
+
+void PlFillRandomBytes( PLRandom *rng, void *dst, size_t size );
+void PlFillRandomUInt32( PLRandom *rng, uint32_t *dst, size_t num );
+void PlFillRandomFloats( PLRandom *rng, float *dst, size_t num, float min, float max );
+void PlFillRandomNormals( PLRandom *rng, float *dst, size_t num, float mean, float deviation );
+void PlFillRandomOnSphere( PLRandom *rng, const PLVector3SoA *dst, size_t num );
+
+/* older helpers, now drawing from the calling thread's generator */
+
+inline static double PlUniform0To1Random( void ) {
+	return PlRandomDouble( PlGetThreadRandom() );
+}
+
+inline static double PlGenerateUniformRandom( double minmax ) {
+	return ( minmax * 2 ) * PlUniform0To1Random() - minmax;
+}
+
+inline static double PlGenerateRandomDouble( double max ) {
+	return PlRandomDouble( PlGetThreadRandom() ) * max;
+}
+
+inline static float PlGenerateRandomFloat( float max ) {
+	return PlRandomFloat( PlGetThreadRandom() ) * max;
+}
+
+PL_EXTERN_C_END
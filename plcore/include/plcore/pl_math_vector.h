@@ -417,6 +417,18 @@ inline static PLVector3 PlVector3CrossProduct( PLVector3 v, PLVector3 v2 ) {
 	        v.x * v2.y - v.y * v2.x );
 }
 
+#if defined( PL_MATH_SSE2 )
+inline static __m128 _plLoadVector3( PLVector3 v ) {
+	return _mm_setr_ps( v.x, v.y, v.z, 0.0f );
+}
+
+inline static PLVector3 _plStoreVector3( __m128 v ) {
+	float f[ 4 ];
+	_mm_storeu_ps( f, v );
+	return PLVector3( f[ 0 ], f[ 1 ], f[ 2 ] );
+}
+#endif
+
 inline static PLVector3 PlVector3Max( PLVector3 v, PLVector3 v2 ) {
 	return PLVector3(
 	        v.x > v2.x ? v.x : v2.x,
@@ -439,7 +451,7 @@ inline static float PlVector3Length( const PLVector3 v ) {
 	return sqrtf( v.x * v.x + v.y * v.y + v.z * v.z );
 }
 
-inline static PLVector3 PlNormalizeVector3( PLVector3 v ) {
+inline static PLVector3 PlNormalizeVector3Scalar( PLVector3 v ) {
 	float length = PlVector3Length( v );
 	if ( length != 0 ) {
 		v.x /= length;
@@ -449,6 +461,18 @@ inline static PLVector3 PlNormalizeVector3( PLVector3 v ) {
 	return v;
 }
 
+inline static PLVector3 PlNormalizeVector3( PLVector3 v ) {
+#if defined( PL_MATH_SSE2 )
+	float length = PlVector3Length( v );
+	if ( length == 0 ) {
+		return v;
+	}
+	return _plStoreVector3( _mm_div_ps( _plLoadVector3( v ), _mm_set1_ps( length ) ) );
+#else
+	return PlNormalizeVector3Scalar( v );
+#endif
+}
+
 inline static const char *PlPrintVector3( const PLVector3 *v, PLVariableType format ) {
 	static char s[ 64 ];
 	if ( format == pl_int_var ) snprintf( s, 32, "%i %i %i", ( int ) v->x, ( int ) v->y, ( int ) v->z );
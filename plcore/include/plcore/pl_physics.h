@@ -114,7 +114,7 @@ inline static bool PlTestLineIntersection( float dst1, float dst2, const PLVecto
 	}
 
 	for ( unsigned int i = 0; i < 3; ++i ) {
-		PlVector3Index( hit, i ) = PlVector3Index( lineStart, i ) + ( PlVector3Index( lineEnd, i ) - PlVector3Index( lineStart, i ) ) * ( -dst1 / ( dst2 - dst1 ) );
+		PlVector3Index( *hit, i ) = PlVector3Index( *lineStart, i ) + ( PlVector3Index( *lineEnd, i ) - PlVector3Index( *lineStart, i ) ) * ( -dst1 / ( dst2 - dst1 ) );
 	}
 
 	return true;
@@ -191,7 +191,7 @@ inline static bool PlIsRayIntersectingAabb( const PLCollisionAABB *bounds, const
 	static const unsigned char left = 1;
 	static const unsigned char middle = 2;
 
-	PLVector3 candidatePlane;
+	PLVector3 candidatePlane = PLVector3( 0, 0, 0 );
 	unsigned char hitQuadrant[ 3 ];
 	bool isInside = true;
 
@@ -216,7 +216,7 @@ inline static bool PlIsRayIntersectingAabb( const PLCollisionAABB *bounds, const
 	}
 
 	/* Calculate T distances to candidate planes */
-	PLVector3 maxT;
+	PLVector3 maxT = PLVector3( 0, 0, 0 );
 	for ( unsigned int i = 0; i < 3; ++i ) {
 		if ( hitQuadrant[ i ] != middle && PlVector3Index( ray->direction, i ) != 0.0f ) {
 			PlVector3Index( maxT, i ) = ( PlVector3Index( candidatePlane, i ) - PlVector3Index( ray->origin, i ) ) / PlVector3Index( ray->direction, i );
@@ -241,12 +241,12 @@ inline static bool PlIsRayIntersectingAabb( const PLCollisionAABB *bounds, const
 
 	for ( unsigned int i = 0; i < 3; ++i ) {
 		if ( whichPlane != i ) {
-			PlVector3Index( hitPoint, i ) = PlVector3Index( ray->origin, i ) + PlVector3Index( maxT, whichPlane ) * PlVector3Index( ray->direction, i );
-			if ( PlVector3Index( hitPoint, i ) < PlVector3Index( min, i ) || PlVector3Index( hitPoint, i ) > PlVector3Index( max, i ) ) {
+			PlVector3Index( *hitPoint, i ) = PlVector3Index( ray->origin, i ) + PlVector3Index( maxT, whichPlane ) * PlVector3Index( ray->direction, i );
+			if ( PlVector3Index( *hitPoint, i ) < PlVector3Index( min, i ) || PlVector3Index( *hitPoint, i ) > PlVector3Index( max, i ) ) {
 				return false;
 			}
 		} else {
-			PlVector3Index( hitPoint, i ) = PlVector3Index( candidatePlane, i );
+			PlVector3Index( *hitPoint, i ) = PlVector3Index( candidatePlane, i );
 		}
 	}
 
@@ -256,3 +256,9 @@ inline static bool PlIsRayIntersectingAabb( const PLCollisionAABB *bounds, const
 PL_EXTERN_C_END
 
 /************************************************************/
+
+#include <plcore/pl_physics_tree.h>
+#include <plcore/pl_physics_broadphase.h>
+#include <plcore/pl_physics_narrowphase.h>
+#include <plcore/pl_physics_mesh.h>
+#include <plcore/pl_physics_cull.h>
@@ -0,0 +1,54 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Broadphase
+ * Keeps track of which of a large number of moving PLCollisionAABBs
+ * overlap, for when rebuilding a tree every frame would cost too much.
+ * Set the bounds of whatever moved, then call PlUpdateBroadphase once per
+ * frame; the pairs that started and stopped overlapping are available
+ * until the next update, alongside the full list. Pairs always have the
+ * lower proxy first, and a removed proxy's pairs are reported as removed
+ * before its handle gets reused.
+ *
+ * Sweep and prune keeps everything sorted along each axis and only does
+ * work for what moved, so it suits things that move a little each frame.
+ * The hash grid starts over each update, so it copes better with things
+ * that jump around, but wants a cell size a little bigger than most of
+ * what's in it. */
+
+typedef enum PLBroadphaseType {
+	PL_BROADPHASE_SWEEP_AND_PRUNE,
+	PL_BROADPHASE_HASH_GRID,
+} PLBroadphaseType;
+
+typedef struct PLBroadphase PLBroadphase;
+
+typedef struct PLBroadphasePair {
+	unsigned int proxyA, proxyB;
+} PLBroadphasePair;
+
+PLBroadphase *PlCreateSweepAndPruneBroadphase( void );
+PLBroadphase *PlCreateHashGridBroadphase( float cellSize );
+void PlDestroyBroadphase( PLBroadphase *broadphase );
+PLBroadphaseType PlGetBroadphaseType( const PLBroadphase *broadphase );
+
+unsigned int PlAddBroadphaseProxy( PLBroadphase *broadphase, const PLCollisionAABB *bounds, void *userData );
+void PlRemoveBroadphaseProxy( PLBroadphase *broadphase, unsigned int proxy );
+void PlSetBroadphaseProxyBounds( PLBroadphase *broadphase, unsigned int proxy, const PLCollisionAABB *bounds );
+void *PlGetBroadphaseProxyUserData( const PLBroadphase *broadphase, unsigned int proxy );
+unsigned int PlGetBroadphaseNumProxies( const PLBroadphase *broadphase );
+
+void PlUpdateBroadphase( PLBroadphase *broadphase );
+const PLBroadphasePair *PlGetBroadphasePairs( const PLBroadphase *broadphase, unsigned int *numPairs );
+const PLBroadphasePair *PlGetBroadphaseAddedPairs( const PLBroadphase *broadphase, unsigned int *numPairs );
+const PLBroadphasePair *PlGetBroadphaseRemovedPairs( const PLBroadphase *broadphase, unsigned int *numPairs );
+
+PL_EXTERN_C_END
@@ -0,0 +1,34 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Frustum Culling
+ * Tests whole arrays of boxes or spheres against a set of planes at once,
+ * such as a PLGCamera's frustum, and finds the ones that are at least
+ * partly on the inside of all of them (i.e. where PlGetPlaneDotProduct is
+ * positive, or zero). Boxes are given by their centre and half their size.
+ * Visible objects can be written out as a bitset, one bit per object, as
+ * a list of their indices, or both.
+ *
+ * The plane cache is optional, one byte per object, and should start off
+ * zeroed. It remembers which plane last culled each object so it can be
+ * tried first next time, which for objects that haven't moved far is
+ * usually the only plane that needs testing. What it holds is only a hint,
+ * and doesn't change which objects are visible. */
+
+#define PL_MAX_CULL_PLANES 32
+
+/* the number of 32-bit words needed for a visibility bitset */
+#define PL_CULL_BITSET_WORDS( NUM ) ( ( ( NUM ) + 31 ) / 32 )
+
+unsigned int PlCullBoxes( const PLVector4 *planes, unsigned int numPlanes, const PLVector3SoA *centres, const PLVector3SoA *extents, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices );
+unsigned int PlCullSpheres( const PLVector4 *planes, unsigned int numPlanes, const PLVector3SoA *centres, const float *radii, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices );
+
+PL_EXTERN_C_END
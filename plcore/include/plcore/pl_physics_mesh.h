@@ -0,0 +1,47 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Collision Mesh
+ * Triangles with a bounding volume hierarchy over them, for casting rays
+ * against meshes for picking, line of sight and the like. Add triangles
+ * from as many sources as needed, then build it once before casting;
+ * triangles are numbered in the order they were added, across every call.
+ * Rays can be cast one at a time, or in bulk, where they're traced in
+ * packets of 4 or 8 depending on the SIMD level. Both give the same
+ * results, so bulk casts pay off the most when neighbouring rays head the
+ * same way, such as those through neighbouring pixels. Triangles are
+ * hit from either side. */
+
+typedef struct PLCollisionMesh PLCollisionMesh;
+
+#define PL_COLLISION_MESH_NO_HIT ( ( unsigned int ) -1 )
+
+typedef struct PLCollisionMeshHit {
+	float distance;        /* in units of the ray's direction */
+	unsigned int triangle; /* or PL_COLLISION_MESH_NO_HIT */
+	float u, v;            /* weights of the triangle's second and third vertices */
+} PLCollisionMeshHit;
+
+bool PlIsRayIntersectingTriangle( const PLCollisionRay *ray, PLVector3 a, PLVector3 b, PLVector3 c, float *distance, float *u, float *v );
+
+PLCollisionMesh *PlCreateCollisionMesh( void );
+void PlDestroyCollisionMesh( PLCollisionMesh *mesh );
+void PlAddCollisionMeshTriangles( PLCollisionMesh *mesh, const PLVector3 *positions, size_t stride, const unsigned int *indices, unsigned int numTriangles );
+void PlBuildCollisionMesh( PLCollisionMesh *mesh );
+
+unsigned int PlGetCollisionMeshNumTriangles( const PLCollisionMesh *mesh );
+void PlGetCollisionMeshBounds( const PLCollisionMesh *mesh, PLVector3 *mins, PLVector3 *maxs );
+
+bool PlRaycastCollisionMesh( const PLCollisionMesh *mesh, const PLCollisionRay *ray, float maxDistance, PLCollisionMeshHit *hit );
+void PlRaycastCollisionMeshRays( const PLCollisionMesh *mesh, const PLCollisionRay *rays, unsigned int numRays, float maxDistance, PLCollisionMeshHit *hits );
+bool PlIsCollisionMeshBlockingRay( const PLCollisionMesh *mesh, const PLCollisionRay *ray, float maxDistance );
+
+PL_EXTERN_C_END
@@ -0,0 +1,86 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Narrowphase
+ * Works out exactly how two shapes are touching, as a manifold of up to
+ * four contact points sharing a normal, which points from the first shape
+ * towards the second; pushing the second along it by a point's
+ * penetration separates them there. Points sit midway between the two
+ * surfaces. Boxes resting on boxes get a point per corner of the overlap,
+ * parallel capsules get one at each end, and pairs without a dedicated
+ * test go through GJK, and EPA when they're sunk into each other, which
+ * gives a single point.
+ *
+ * Touching counts as a contact, with no penetration, the same as
+ * PlIsAabbIntersecting. */
+
+typedef struct PLCollisionCapsule {
+	PLVector3 start, end;
+	float radius;
+} PLCollisionCapsule;
+
+typedef struct PLCollisionOBB {
+	PLVector3 origin;
+	PLVector3 axes[ 3 ]; /* must be orthonormal */
+	PLVector3 extents;   /* half the size along each axis */
+} PLCollisionOBB;
+
+/* the convex hull of vertices, which are relative to origin and aren't copied */
+typedef struct PLCollisionHull {
+	PLVector3 origin;
+	const PLVector3 *vertices;
+	unsigned int numVertices;
+} PLCollisionHull;
+
+typedef enum PLCollisionShapeType {
+	PL_COLLISION_SHAPE_SPHERE,
+	PL_COLLISION_SHAPE_AABB,
+	PL_COLLISION_SHAPE_CAPSULE,
+	PL_COLLISION_SHAPE_OBB,
+	PL_COLLISION_SHAPE_HULL,
+
+	PL_NUM_COLLISION_SHAPES
+} PLCollisionShapeType;
+
+typedef struct PLCollisionShape {
+	PLCollisionShapeType type;
+	union {
+		PLCollisionSphere sphere;
+		PLCollisionAABB aabb;
+		PLCollisionCapsule capsule;
+		PLCollisionOBB obb;
+		PLCollisionHull hull;
+	};
+} PLCollisionShape;
+
+#define PL_MAX_CONTACT_POINTS 4
+
+typedef struct PLContactPoint {
+	PLVector3 position;
+	float penetration;
+} PLContactPoint;
+
+typedef struct PLContactManifold {
+	PLBroadphasePair pair; /* only filled in by PlCollideShapePairs */
+	PLVector3 normal;
+	unsigned int numPoints;
+	PLContactPoint points[ PL_MAX_CONTACT_POINTS ];
+} PLContactManifold;
+
+bool PlCollideSpheres( const PLCollisionSphere *a, const PLCollisionSphere *b, PLContactManifold *manifold );
+bool PlCollideSphereAabb( const PLCollisionSphere *a, const PLCollisionAABB *b, PLContactManifold *manifold );
+bool PlCollideAabbs( const PLCollisionAABB *a, const PLCollisionAABB *b, PLContactManifold *manifold );
+
+PLCollisionAABB PlGetCollisionShapeBounds( const PLCollisionShape *shape );
+bool PlCollideShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold );
+unsigned int PlCollideShapePairs( const PLCollisionShape *shapes, const PLBroadphasePair *pairs, unsigned int numPairs, PLContactManifold *manifolds );
+
+PL_EXTERN_C_END
@@ -0,0 +1,51 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* AABB Tree
+ * Bounding volume hierarchy over PLCollisionAABBs, for finding what overlaps
+ * what without testing every pair. Each proxy is stored with its bounds
+ * grown by the tree's margin, so small movements don't have to touch the
+ * tree at all; queries are against those fattened bounds, so treat their
+ * results as candidates. Trees can be built up incrementally, or all at
+ * once for things that won't move, such as level geometry. */
+
+typedef struct PLAabbTree PLAabbTree;
+
+#define PL_AABB_TREE_INVALID_PROXY ( ( unsigned int ) -1 )
+
+/* return false to stop the query */
+typedef bool ( *PLAabbTreeQueryCallback )( unsigned int proxy, void *userData, void *parm );
+/* return how far along the ray to keep looking; see PlRaycastAabbTree */
+typedef float ( *PLAabbTreeRayCallback )( unsigned int proxy, void *userData, float distance, void *parm );
+typedef void ( *PLAabbTreePairCallback )( unsigned int proxyA, unsigned int proxyB, void *parm );
+
+PLAabbTree *PlCreateAabbTree( float margin );
+void PlDestroyAabbTree( PLAabbTree *tree );
+void PlClearAabbTree( PLAabbTree *tree );
+void PlBuildAabbTree( PLAabbTree *tree, const PLCollisionAABB *bounds, void *const *userData, unsigned int numBounds );
+
+unsigned int PlInsertAabbTreeProxy( PLAabbTree *tree, const PLCollisionAABB *bounds, void *userData );
+void PlRemoveAabbTreeProxy( PLAabbTree *tree, unsigned int proxy );
+bool PlMoveAabbTreeProxy( PLAabbTree *tree, unsigned int proxy, const PLCollisionAABB *bounds, PLVector3 displacement );
+void PlSetAabbTreeProxyBounds( PLAabbTree *tree, unsigned int proxy, const PLCollisionAABB *bounds );
+void PlRefitAabbTree( PLAabbTree *tree );
+
+void *PlGetAabbTreeProxyUserData( const PLAabbTree *tree, unsigned int proxy );
+void PlGetAabbTreeProxyBounds( const PLAabbTree *tree, unsigned int proxy, PLVector3 *mins, PLVector3 *maxs );
+unsigned int PlGetAabbTreeNumProxies( const PLAabbTree *tree );
+unsigned int PlGetAabbTreeHeight( const PLAabbTree *tree );
+
+void PlQueryAabbTree( const PLAabbTree *tree, const PLCollisionAABB *bounds, PLAabbTreeQueryCallback callback, void *parm );
+void PlRaycastAabbTree( const PLAabbTree *tree, const PLCollisionRay *ray, float maxDistance, PLAabbTreeRayCallback callback, void *parm );
+void PlQueryAabbTreeFrustum( const PLAabbTree *tree, const PLVector4 *planes, unsigned int numPlanes, PLAabbTreeQueryCallback callback, void *parm );
+void PlGetAabbTreeOverlapPairs( const PLAabbTree *tree, PLAabbTreePairCallback callback, void *parm );
+
+PL_EXTERN_C_END
@@ -0,0 +1,44 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+#include <plcore/pl.h>
+
+PL_EXTERN_C
+
+/* Zones are recorded into a buffer owned by the calling thread and can be
+ * written out as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+ * Names must remain valid until the trace is written; string literals
+ * or PL_FUNCTION are expected. */
+
+#if !defined( PL_COMPILE_PLUGIN )
+
+PL_EXTERN void PlEnableProfiler( bool enable );
+PL_EXTERN bool PlIsProfilerEnabled( void );
+
+PL_EXTERN void PlBeginProfileZone( const char *name );
+PL_EXTERN void PlEndProfileZone( void );
+PL_EXTERN void PlAddProfileCounter( const char *name, int64_t value );
+
+PL_EXTERN bool PlWriteProfileTrace( const char *path );
+PL_EXTERN void PlClearProfile( void );
+
+#endif
+
+#if !defined( PL_DISABLE_PROFILER )
+#	define PL_PROFILE_BEGIN( NAME )          PlBeginProfileZone( NAME )
+#	define PL_PROFILE_END()                  PlEndProfileZone()
+#	define PL_PROFILE_COUNTER( NAME, VALUE ) PlAddProfileCounter( ( NAME ), ( VALUE ) )
+#else
+#	define PL_PROFILE_BEGIN( NAME )
+#	define PL_PROFILE_END()
+#	define PL_PROFILE_COUNTER( NAME, VALUE )
+#endif
+
+#define PL_PROFILE_FUNCTION_BEGIN() PL_PROFILE_BEGIN( PL_FUNCTION )
+
+PL_EXTERN_C_END
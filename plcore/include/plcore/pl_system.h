@@ -110,6 +110,11 @@
 #error "Unsupported CPU type."
 #endif
 
+#if defined( __amd64 ) || defined( __amd64__ ) || defined( _M_X64 ) || defined( _M_AMD64 ) || \
+        defined( i386 ) || defined( __i386 ) || defined( __i386__ ) || defined( _M_IX86 ) || defined( _X86_ )
+#define PL_SYSTEM_CPU_X86
+#endif
+
 // Compiler
 
 #if defined( _MSC_VER )
@@ -128,6 +133,13 @@
 
 #define PL_STATIC_ASSERT( a, b ) static_assert( ( a ), b )
 
+#define PL_THREAD_LOCAL __declspec( thread )
+
+// MSVC allows any intrinsic without enabling it for the whole unit
+#define PL_TARGET_ISA( ISA )
+
+#define PL_ALIGNED( N ) __declspec( align( N ) )
+
 #define PL_PACKED_STRUCT_START( a ) \
 	__pragma( pack( push, 1 ) ) typedef struct a {
 #define PL_PACKED_STRUCT_END( a ) \
@@ -150,6 +162,13 @@
 
 #define PL_STATIC_ASSERT( a, b ) _Static_assert( ( a ), b )
 
+#define PL_THREAD_LOCAL __thread
+
+// Allows a function to use instructions beyond what the unit is compiled for
+#define PL_TARGET_ISA( ISA ) __attribute__( ( target( ISA ) ) )
+
+#define PL_ALIGNED( N ) __attribute__( ( aligned( N ) ) )
+
 #define PL_PACKED_STRUCT_START( a ) typedef struct __attribute__( ( packed ) ) a {
 #define PL_PACKED_STRUCT_END( a ) \
 	}                             \
@@ -0,0 +1,90 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+#include <plcore/pl.h>
+
+#if defined( _MSC_VER )
+#	include <intrin.h>
+#endif
+
+PL_EXTERN_C
+
+/* Threads, mutexes and conditions */
+
+typedef struct PLThread PLThread;
+typedef struct PLMutex PLMutex;
+typedef struct PLCondition PLCondition;
+
+typedef int ( *PLThreadFunction )( void *userData );
+
+#if !defined( PL_COMPILE_PLUGIN )
+
+PL_EXTERN PLThread *PlCreateThread( PLThreadFunction function, void *userData );
+PL_EXTERN int PlJoinThread( PLThread *thread );
+PL_EXTERN void PlYieldThread( void );
+PL_EXTERN void PlSleepThread( unsigned int milliseconds );
+PL_EXTERN unsigned int PlGetNumProcessors( void );
+
+PL_EXTERN PLMutex *PlCreateMutex( void );
+PL_EXTERN void PlDestroyMutex( PLMutex *mutex );
+PL_EXTERN void PlLockMutex( PLMutex *mutex );
+PL_EXTERN void PlUnlockMutex( PLMutex *mutex );
+
+PL_EXTERN PLCondition *PlCreateCondition( void );
+PL_EXTERN void PlDestroyCondition( PLCondition *condition );
+/* returns false if the wait timed out, a timeout of 0 waits indefinitely */
+PL_EXTERN bool PlWaitCondition( PLCondition *condition, PLMutex *mutex, unsigned int milliseconds );
+PL_EXTERN void PlSignalCondition( PLCondition *condition );
+PL_EXTERN void PlBroadcastCondition( PLCondition *condition );
+
+#endif
+
+/* Atomics
+ * loads have acquire semantics, stores release; read-modify-write operations are sequentially consistent */
+
+#if defined( _MSC_VER )
+
+static inline int32_t PlAtomicLoad32( volatile int32_t *p ) { return _InterlockedCompareExchange( ( volatile long * ) p, 0, 0 ); }
+static inline void PlAtomicStore32( volatile int32_t *p, int32_t v ) { _InterlockedExchange( ( volatile long * ) p, v ); }
+static inline int32_t PlAtomicFetchAdd32( volatile int32_t *p, int32_t v ) { return _InterlockedExchangeAdd( ( volatile long * ) p, v ); }
+static inline bool PlAtomicCompareExchange32( volatile int32_t *p, int32_t *expected, int32_t desired ) {
+	int32_t prev = _InterlockedCompareExchange( ( volatile long * ) p, desired, *expected );
+	if ( prev == *expected ) return true;
+	*expected = prev;
+	return false;
+}
+
+static inline int64_t PlAtomicLoad64( volatile int64_t *p ) { return _InterlockedCompareExchange64( p, 0, 0 ); }
+static inline void PlAtomicStore64( volatile int64_t *p, int64_t v ) { _InterlockedExchange64( p, v ); }
+static inline int64_t PlAtomicFetchAdd64( volatile int64_t *p, int64_t v ) { return _InterlockedExchangeAdd64( p, v ); }
+static inline bool PlAtomicCompareExchange64( volatile int64_t *p, int64_t *expected, int64_t desired ) {
+	int64_t prev = _InterlockedCompareExchange64( p, desired, *expected );
+	if ( prev == *expected ) return true;
+	*expected = prev;
+	return false;
+}
+
+#else /* currently assumed to be GCC */
+
+static inline int32_t PlAtomicLoad32( volatile int32_t *p ) { return __atomic_load_n( p, __ATOMIC_ACQUIRE ); }
+static inline void PlAtomicStore32( volatile int32_t *p, int32_t v ) { __atomic_store_n( p, v, __ATOMIC_RELEASE ); }
+static inline int32_t PlAtomicFetchAdd32( volatile int32_t *p, int32_t v ) { return __atomic_fetch_add( p, v, __ATOMIC_SEQ_CST ); }
+static inline bool PlAtomicCompareExchange32( volatile int32_t *p, int32_t *expected, int32_t desired ) {
+	return __atomic_compare_exchange_n( p, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+}
+
+static inline int64_t PlAtomicLoad64( volatile int64_t *p ) { return __atomic_load_n( p, __ATOMIC_ACQUIRE ); }
+static inline void PlAtomicStore64( volatile int64_t *p, int64_t v ) { __atomic_store_n( p, v, __ATOMIC_RELEASE ); }
+static inline int64_t PlAtomicFetchAdd64( volatile int64_t *p, int64_t v ) { return __atomic_fetch_add( p, v, __ATOMIC_SEQ_CST ); }
+static inline bool PlAtomicCompareExchange64( volatile int64_t *p, int64_t *expected, int64_t desired ) {
+	return __atomic_compare_exchange_n( p, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+}
+
+#endif
+
+PL_EXTERN_C_END
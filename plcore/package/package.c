@@ -132,8 +132,11 @@ void PlRegisterStandardPackageLoaders( void ) {
 PLPackage *PlLoadPackage( const char *path ) {
 	FunctionStart();
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	if ( !PlFileExists( path ) ) {
 		PlReportErrorF( PL_RESULT_FILEREAD, "failed to load package, \"%s\"", path );
+		PL_PROFILE_END();
 		return NULL;
 	}
 
@@ -148,6 +151,7 @@ PLPackage *PlLoadPackage( const char *path ) {
 				PLPackage *package = package_loaders[ i ].LoadFunction( path );
 				if ( package != NULL ) {
 					strncpy( package->path, path, sizeof( package->path ) );
+					PL_PROFILE_END();
 					return package;
 				}
 			}
@@ -155,17 +159,22 @@ PLPackage *PlLoadPackage( const char *path ) {
 			PLPackage *package = package_loaders[ i ].LoadFunction( path );
 			if ( package != NULL ) {
 				strncpy( package->path, path, sizeof( package->path ) );
+				PL_PROFILE_END();
 				return package;
 			}
 		}
 	}
 
+	PL_PROFILE_END();
 	return NULL;
 }
 
 PLFile *PlLoadPackageFile( PLPackage *package, const char *path ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	if ( package->internal.LoadFile == NULL ) {
 		PlReportErrorF( PL_RESULT_FILEREAD, "package has not been initialized, no LoadFile function assigned, aborting" );
+		PL_PROFILE_END();
 		return NULL;
 	}
 
@@ -177,6 +186,7 @@ PLFile *PlLoadPackageFile( PLPackage *package, const char *path ) {
 		/* load in the package */
 		PLFile *packageFile = PlOpenFile( package->path, true );
 		if ( packageFile == NULL ) {
+			PL_PROFILE_END();
 			return NULL;
 		}
 
@@ -184,7 +194,7 @@ PLFile *PlLoadPackageFile( PLPackage *package, const char *path ) {
 
 		uint8_t *dataPtr = package->internal.LoadFile( packageFile, &( package->table[ i ] ) );
 		if ( dataPtr != NULL ) {
-			file = pl_malloc( sizeof( PLFile ) );
+			file = pl_calloc( 1, sizeof( PLFile ) );
 			snprintf( file->path, sizeof( file->path ), "%s", package->table[ i ].fileName );
 			file->size = package->table[ i ].fileSize;
 			file->data = dataPtr;
@@ -193,10 +203,12 @@ PLFile *PlLoadPackageFile( PLPackage *package, const char *path ) {
 
 		PlCloseFile( packageFile );
 
+		PL_PROFILE_END();
 		return file;
 	}
 
 	PlReportErrorF( PL_RESULT_INVALID_PARM2, "failed to find file in package" );
+	PL_PROFILE_END();
 	return NULL;
 }
 
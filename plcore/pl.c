@@ -21,6 +21,11 @@
 #endif
 #include <errno.h>
 
+#if defined( _MSC_VER ) && defined( PL_SYSTEM_CPU_X86 )
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
 #include "pl_private.h"
 
 /*	Generic functions for platform, such as	error handling.	*/
@@ -190,6 +195,7 @@ void PlShutdown( void ) {
 	}
 
 	PlShutdownConsole();
+	PlShutdownProfiler();
 }
 
 /*-------------------------------------------------------------------
@@ -254,8 +260,9 @@ const char *PlGenerateUniqueIdentifier( char *dest, size_t destLength ) {
 	        '9',
 	};
 
+	PLRandom *rng = PlGetThreadRandom();
 	for ( unsigned int i = 0; i < destLength; ++i ) {
-		dest[ i ] = dataPool[ rand() % plArrayElements( dataPool ) ];
+		dest[ i ] = dataPool[ PlRandomBoundedUInt32( rng, plArrayElements( dataPool ) ) ];
 	}
 
 	return dest;
@@ -308,11 +315,12 @@ const char *GetLastError_strerror( int errnum ) {
 #define MAX_FUNCTION_LENGTH 64
 #define MAX_ERROR_LENGTH 2048
 
-char
+/* per-thread, so work spread over several threads can't clobber each other's errors */
+static PL_THREAD_LOCAL char
         loc_error[ MAX_ERROR_LENGTH ] = { '\0' },
                                     loc_function[ MAX_FUNCTION_LENGTH ] = { '\0' };
 
-PLFunctionResult global_result = PL_RESULT_SUCCESS;
+static PL_THREAD_LOCAL PLFunctionResult global_result = PL_RESULT_SUCCESS;
 
 // Returns locally generated error message.
 const char *PlGetError( void ) {
@@ -443,6 +451,86 @@ const char *PlGetFormattedTime( void ) {
 	return time_out;
 }
 
+/**
+ * Returns a monotonic timestamp in nanoseconds, only
+ * meaningful when compared against another.
+ */
+uint64_t PlGetMonotonicTime( void ) {
+#if defined( _WIN32 )
+	static LARGE_INTEGER frequency = { 0 };
+	if ( frequency.QuadPart == 0 ) {
+		QueryPerformanceFrequency( &frequency );
+	}
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	return ( uint64_t ) ( counter.QuadPart / frequency.QuadPart ) * 1000000000ULL +
+	       ( uint64_t ) ( counter.QuadPart % frequency.QuadPart ) * 1000000000ULL / ( uint64_t ) frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ( uint64_t ) ts.tv_sec * 1000000000ULL + ( uint64_t ) ts.tv_nsec;
+#endif
+}
+
+static PLSimdLevel DetectSimdLevel( void ) {
+#if defined( PL_SYSTEM_CPU_X86 )
+#	if defined( _MSC_VER )
+	int info[ 4 ];
+	__cpuid( info, 0 );
+	int numIds = info[ 0 ];
+
+	__cpuid( info, 1 );
+	if ( !( info[ 3 ] & ( 1 << 26 ) ) ) {
+		return PL_SIMD_LEVEL_NONE;
+	}
+
+	/* AVX2 also needs the OS to preserve the upper halves of the registers */
+	bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+	if ( numIds >= 7 && osxsave && ( _xgetbv( 0 ) & 6 ) == 6 ) {
+		__cpuidex( info, 7, 0 );
+		if ( info[ 1 ] & ( 1 << 5 ) ) {
+			return PL_SIMD_LEVEL_AVX2;
+		}
+	}
+
+	return PL_SIMD_LEVEL_SSE2;
+#	else
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports( "avx2" ) ) {
+		return PL_SIMD_LEVEL_AVX2;
+	} else if ( __builtin_cpu_supports( "sse2" ) ) {
+		return PL_SIMD_LEVEL_SSE2;
+	}
+#	endif
+#endif
+
+	return PL_SIMD_LEVEL_NONE;
+}
+
+static volatile int simdLevel = -1;
+static volatile int simdLevelCap = PL_SIMD_LEVEL_AVX2;
+
+/**
+ * Returns the highest instruction set extension that
+ * optimised paths are allowed to use on this machine.
+ */
+PLSimdLevel PlGetSimdLevel( void ) {
+	if ( simdLevel < 0 ) {
+		simdLevel = DetectSimdLevel();
+	}
+
+	return ( PLSimdLevel ) ( ( simdLevel < simdLevelCap ) ? simdLevel : simdLevelCap );
+}
+
+/**
+ * Limits optimised paths to the given level, mainly useful
+ * for comparing against the reference implementations.
+ */
+void PlSetSimdLevel( PLSimdLevel level ) {
+	simdLevelCap = level;
+}
+
 /**
  * Converts the given string to time.
  * http://stackoverflow.com/questions/1765014/convert-string-from-date-into-a-time-t
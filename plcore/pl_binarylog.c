@@ -0,0 +1,862 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include <plcore/pl_console.h>
+#include <plcore/pl_thread.h>
+
+#include "pl_private.h"
+
+#include <stddef.h>
+
+/* Binary Log Output
+ * Rather than formatting at the call site, each message is recorded as the id
+ * of its format string followed by its raw arguments, into a buffer owned by
+ * the calling thread. Format strings are written out the first time they're
+ * seen and the text is only rebuilt later on, by PlDecodeBinaryLog.
+ *
+ * Formats are identified by their address, so they must be string literals,
+ * or at least never change or move while the log is open. Text built at
+ * runtime should be logged as an argument to "%s" instead.
+ *
+ * The stream is written in host byte order.
+ */
+
+#define BINARY_LOG_IDENTIFIER  "PLBLOG01"
+#define BINARY_LOG_BUFFER_SIZE 65536
+#define BINARY_LOG_MAX_PAYLOAD 4096
+#define BINARY_LOG_MAX_STRING  1024
+#define BINARY_LOG_CACHE_SIZE  64 /* per-thread format cache, must be a power of two */
+
+/* type, format, level, thread, time, payload length */
+#define BINARY_LOG_MESSAGE_HEADER ( 1 + 4 + 4 + 4 + 8 + 2 )
+
+enum {
+	BINARY_LOG_RECORD_LEVEL = 1, /* int32 id, uint16 length, prefix */
+	BINARY_LOG_RECORD_FORMAT,    /* uint32 id, uint16 length, format */
+	BINARY_LOG_RECORD_MESSAGE,   /* uint32 format, int32 level, uint32 thread, int64 time, uint16 length, arguments */
+};
+
+enum {
+	BINARY_LOG_ARG_INT = 1, /* int64 */
+	BINARY_LOG_ARG_DOUBLE,  /* double */
+	BINARY_LOG_ARG_POINTER, /* uint64 */
+	BINARY_LOG_ARG_STRING,  /* uint16 length, characters */
+};
+
+typedef struct BinaryLogBuffer {
+	PLMutex *mutex;
+	uint32_t threadId;
+	size_t length;
+	const char *cachedFormats[ BINARY_LOG_CACHE_SIZE ];
+	uint32_t cachedIds[ BINARY_LOG_CACHE_SIZE ];
+	struct BinaryLogBuffer *next;
+	uint8_t data[ BINARY_LOG_BUFFER_SIZE ];
+} BinaryLogBuffer;
+
+typedef struct BinaryLogFormat {
+	const char *format;
+	uint32_t id;
+} BinaryLogFormat;
+
+static struct {
+	volatile int32_t isEnabled;
+	volatile int32_t generation;
+	FILE *file;
+	PLMutex *mutex;
+	BinaryLogBuffer *buffers;
+	uint32_t numThreads;
+
+	/* open addressed, keyed on the format pointer */
+	BinaryLogFormat *formats;
+	uint32_t numFormats;
+	uint32_t maxFormats;
+} binaryLog;
+
+static PL_THREAD_LOCAL BinaryLogBuffer *threadBuffer = NULL;
+static PL_THREAD_LOCAL int32_t threadGeneration = 0;
+
+static unsigned int HashPointer( const void *ptr ) {
+	uint64_t v = ( uint64_t ) ( uintptr_t ) ptr;
+	v ^= v >> 33;
+	v *= 0xff51afd7ed558ccdULL;
+	v ^= v >> 33;
+	return ( unsigned int ) v;
+}
+
+static int64_t GetTimeNanoseconds( void ) {
+	struct timespec ts;
+	timespec_get( &ts, TIME_UTC );
+	return ( int64_t ) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// format parsing, shared between recording and decoding
+
+typedef struct FormatSpec {
+	const char *lengthStart;
+	bool widthArg;
+	bool precisionArg;
+	int precision;
+	char length[ 3 ];
+	char conversion;
+} FormatSpec;
+
+/**
+ * Parses a conversion specification, p should point just past the '%'.
+ * Returns the position following the conversion character or NULL if it's malformed.
+ */
+static const char *ParseFormatSpec( const char *p, FormatSpec *spec ) {
+	memset( spec, 0, sizeof( FormatSpec ) );
+	spec->precision = -1;
+
+	while ( *p != '\0' && strchr( "-+ #0'", *p ) != NULL ) {
+		p++;
+	}
+
+	if ( *p == '*' ) {
+		spec->widthArg = true;
+		p++;
+	} else {
+		while ( isdigit( ( unsigned char ) *p ) ) {
+			p++;
+		}
+	}
+
+	if ( *p == '.' ) {
+		p++;
+		if ( *p == '*' ) {
+			spec->precisionArg = true;
+			p++;
+		} else {
+			spec->precision = 0;
+			while ( isdigit( ( unsigned char ) *p ) ) {
+				spec->precision = spec->precision * 10 + ( *p++ - '0' );
+			}
+		}
+	}
+
+	spec->lengthStart = p;
+	for ( unsigned int i = 0; i < 2 && *p != '\0' && strchr( "hljztL", *p ) != NULL; ++i ) {
+		spec->length[ i ] = *p++;
+	}
+
+	if ( *p == '\0' ) {
+		return NULL;
+	}
+
+	spec->conversion = *p;
+	return p + 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// recording
+
+static void WriteLevelRecord( int id, const char *prefix ) {
+	uint8_t type = BINARY_LOG_RECORD_LEVEL;
+	int32_t levelId = id;
+	uint16_t length = ( uint16_t ) strlen( prefix );
+	fwrite( &type, sizeof( type ), 1, binaryLog.file );
+	fwrite( &levelId, sizeof( levelId ), 1, binaryLog.file );
+	fwrite( &length, sizeof( length ), 1, binaryLog.file );
+	fwrite( prefix, sizeof( char ), length, binaryLog.file );
+}
+
+static void WriteFormatRecord( uint32_t id, const char *format ) {
+	uint8_t type = BINARY_LOG_RECORD_FORMAT;
+	size_t formatLength = strlen( format );
+	uint16_t length = ( uint16_t ) ( ( formatLength > UINT16_MAX ) ? UINT16_MAX : formatLength );
+	fwrite( &type, sizeof( type ), 1, binaryLog.file );
+	fwrite( &id, sizeof( id ), 1, binaryLog.file );
+	fwrite( &length, sizeof( length ), 1, binaryLog.file );
+	fwrite( format, sizeof( char ), length, binaryLog.file );
+}
+
+/**
+ * Fetches the id for the given format string, registering it
+ * and writing it out if it's the first time it's been seen.
+ * Expects the global mutex to be held.
+ */
+static uint32_t GetGlobalFormatId( const char *format ) {
+	if ( ( binaryLog.numFormats + 1 ) * 2 > binaryLog.maxFormats ) {
+		uint32_t newMax = ( binaryLog.maxFormats == 0 ) ? 1024 : binaryLog.maxFormats * 2;
+		BinaryLogFormat *newFormats = pl_calloc( newMax, sizeof( BinaryLogFormat ) );
+		if ( newFormats == NULL ) {
+			return UINT32_MAX;
+		}
+
+		for ( uint32_t i = 0; i < binaryLog.maxFormats; ++i ) {
+			if ( binaryLog.formats[ i ].format == NULL ) {
+				continue;
+			}
+
+			unsigned int slot = HashPointer( binaryLog.formats[ i ].format ) & ( newMax - 1 );
+			while ( newFormats[ slot ].format != NULL ) {
+				slot = ( slot + 1 ) & ( newMax - 1 );
+			}
+			newFormats[ slot ] = binaryLog.formats[ i ];
+		}
+
+		pl_free( binaryLog.formats );
+		binaryLog.formats = newFormats;
+		binaryLog.maxFormats = newMax;
+	}
+
+	unsigned int slot = HashPointer( format ) & ( binaryLog.maxFormats - 1 );
+	while ( binaryLog.formats[ slot ].format != NULL ) {
+		if ( binaryLog.formats[ slot ].format == format ) {
+			return binaryLog.formats[ slot ].id;
+		}
+		slot = ( slot + 1 ) & ( binaryLog.maxFormats - 1 );
+	}
+
+	binaryLog.formats[ slot ].format = format;
+	binaryLog.formats[ slot ].id = binaryLog.numFormats++;
+	WriteFormatRecord( binaryLog.formats[ slot ].id, format );
+
+	return binaryLog.formats[ slot ].id;
+}
+
+static uint32_t GetFormatId( BinaryLogBuffer *buffer, const char *format ) {
+	unsigned int slot = HashPointer( format ) & ( BINARY_LOG_CACHE_SIZE - 1 );
+	if ( buffer->cachedFormats[ slot ] == format ) {
+		return buffer->cachedIds[ slot ];
+	}
+
+	PlLockMutex( binaryLog.mutex );
+	uint32_t id = GetGlobalFormatId( format );
+	PlUnlockMutex( binaryLog.mutex );
+
+	if ( id != UINT32_MAX ) {
+		buffer->cachedFormats[ slot ] = format;
+		buffer->cachedIds[ slot ] = id;
+	}
+
+	return id;
+}
+
+/**
+ * Writes out the contents of the buffer, expects the buffer's mutex to be held.
+ */
+static void FlushThreadBuffer( BinaryLogBuffer *buffer ) {
+	if ( buffer->length == 0 ) {
+		return;
+	}
+
+	PlLockMutex( binaryLog.mutex );
+	if ( binaryLog.file != NULL ) {
+		fwrite( buffer->data, sizeof( uint8_t ), buffer->length, binaryLog.file );
+	}
+	PlUnlockMutex( binaryLog.mutex );
+
+	buffer->length = 0;
+}
+
+static BinaryLogBuffer *GetThreadBuffer( void ) {
+	int32_t generation = PlAtomicLoad32( &binaryLog.generation );
+	if ( threadBuffer != NULL && threadGeneration == generation ) {
+		return threadBuffer;
+	}
+
+	BinaryLogBuffer *buffer = pl_calloc( 1, sizeof( BinaryLogBuffer ) );
+	if ( buffer == NULL ) {
+		return NULL;
+	}
+
+	if ( ( buffer->mutex = PlCreateMutex() ) == NULL ) {
+		pl_free( buffer );
+		return NULL;
+	}
+
+	/* buffers are only ever pushed onto the head, so walking the list never needs the lock */
+	PlLockMutex( binaryLog.mutex );
+	buffer->threadId = ++binaryLog.numThreads;
+	buffer->next = binaryLog.buffers;
+	binaryLog.buffers = buffer;
+	PlUnlockMutex( binaryLog.mutex );
+
+	threadBuffer = buffer;
+	threadGeneration = generation;
+
+	return buffer;
+}
+
+#define PUSH_ARGUMENT( TYPE, VALUE )                                 \
+	{                                                                \
+		TYPE v_ = ( VALUE );                                         \
+		if ( pos + 1 + sizeof( TYPE ) > end ) goto done;             \
+		*pos++ = ( tag );                                            \
+		memcpy( pos, &v_, sizeof( TYPE ) );                          \
+		pos += sizeof( TYPE );                                       \
+	}
+
+/**
+ * Records a message against the calling thread's buffer.
+ * Returns the number of bytes recorded.
+ */
+size_t _plRecordBinaryLogMessage( int level, const char *msg, va_list args ) {
+	BinaryLogBuffer *buffer = GetThreadBuffer();
+	if ( buffer == NULL ) {
+		return 0;
+	}
+
+	PlLockMutex( buffer->mutex );
+
+	if ( buffer->length + BINARY_LOG_MESSAGE_HEADER + BINARY_LOG_MAX_PAYLOAD > BINARY_LOG_BUFFER_SIZE ) {
+		FlushThreadBuffer( buffer );
+	}
+
+	uint32_t formatId = GetFormatId( buffer, msg );
+	if ( formatId == UINT32_MAX ) {
+		PlUnlockMutex( buffer->mutex );
+		return 0;
+	}
+
+	uint8_t *header = buffer->data + buffer->length;
+	uint8_t *pos = header + BINARY_LOG_MESSAGE_HEADER;
+	uint8_t *end = pos + BINARY_LOG_MAX_PAYLOAD;
+	uint8_t tag;
+
+	for ( const char *p = msg; *p != '\0'; ) {
+		if ( *p++ != '%' ) {
+			continue;
+		} else if ( *p == '%' ) {
+			p++;
+			continue;
+		}
+
+		FormatSpec spec;
+		if ( ( p = ParseFormatSpec( p, &spec ) ) == NULL ) {
+			break;
+		}
+
+		tag = BINARY_LOG_ARG_INT;
+		if ( spec.widthArg ) {
+			PUSH_ARGUMENT( int64_t, va_arg( args, int ) );
+		}
+		if ( spec.precisionArg ) {
+			spec.precision = va_arg( args, int );
+			PUSH_ARGUMENT( int64_t, spec.precision );
+		}
+
+		switch ( spec.conversion ) {
+			case 'd':
+			case 'i': {
+				int64_t v;
+				if ( spec.length[ 0 ] == 'l' && spec.length[ 1 ] == 'l' ) v = va_arg( args, long long );
+				else if ( spec.length[ 0 ] == 'l' ) v = va_arg( args, long );
+				else if ( spec.length[ 0 ] == 'j' ) v = va_arg( args, intmax_t );
+				else if ( spec.length[ 0 ] == 'z' ) v = ( int64_t ) va_arg( args, size_t );
+				else if ( spec.length[ 0 ] == 't' ) v = va_arg( args, ptrdiff_t );
+				else if ( spec.length[ 0 ] == 'h' && spec.length[ 1 ] == 'h' ) v = ( signed char ) va_arg( args, int );
+				else if ( spec.length[ 0 ] == 'h' ) v = ( short ) va_arg( args, int );
+				else v = va_arg( args, int );
+				PUSH_ARGUMENT( int64_t, v );
+				break;
+			}
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X': {
+				uint64_t v;
+				if ( spec.length[ 0 ] == 'l' && spec.length[ 1 ] == 'l' ) v = va_arg( args, unsigned long long );
+				else if ( spec.length[ 0 ] == 'l' ) v = va_arg( args, unsigned long );
+				else if ( spec.length[ 0 ] == 'j' ) v = va_arg( args, uintmax_t );
+				else if ( spec.length[ 0 ] == 'z' ) v = va_arg( args, size_t );
+				else if ( spec.length[ 0 ] == 't' ) v = ( uint64_t ) va_arg( args, ptrdiff_t );
+				else if ( spec.length[ 0 ] == 'h' && spec.length[ 1 ] == 'h' ) v = ( unsigned char ) va_arg( args, unsigned int );
+				else if ( spec.length[ 0 ] == 'h' ) v = ( unsigned short ) va_arg( args, unsigned int );
+				else v = va_arg( args, unsigned int );
+				PUSH_ARGUMENT( int64_t, ( int64_t ) v );
+				break;
+			}
+			case 'c':
+				PUSH_ARGUMENT( int64_t, va_arg( args, int ) );
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				tag = BINARY_LOG_ARG_DOUBLE;
+				if ( spec.length[ 0 ] == 'L' ) {
+					PUSH_ARGUMENT( double, ( double ) va_arg( args, long double ) );
+				} else {
+					PUSH_ARGUMENT( double, va_arg( args, double ) );
+				}
+				break;
+			case 'p':
+				tag = BINARY_LOG_ARG_POINTER;
+				PUSH_ARGUMENT( uint64_t, ( uint64_t ) ( uintptr_t ) va_arg( args, void * ) );
+				break;
+			case 'n':
+				( void ) va_arg( args, void * );
+				break;
+			case 's': {
+				const char *s = va_arg( args, const char * );
+				if ( s == NULL ) {
+					s = "(null)";
+				}
+
+				size_t length = 0;
+				size_t maxLength = ( spec.precision >= 0 && spec.precision < BINARY_LOG_MAX_STRING ) ? ( size_t ) spec.precision : BINARY_LOG_MAX_STRING;
+				while ( length < maxLength && s[ length ] != '\0' ) {
+					length++;
+				}
+
+				if ( pos + 1 + sizeof( uint16_t ) + length > end ) {
+					goto done;
+				}
+
+				uint16_t l = ( uint16_t ) length;
+				*pos++ = BINARY_LOG_ARG_STRING;
+				memcpy( pos, &l, sizeof( uint16_t ) );
+				pos += sizeof( uint16_t );
+				memcpy( pos, s, length );
+				pos += length;
+				break;
+			}
+			default:
+				/* unknown conversion, no way of knowing what's left on the stack */
+				goto done;
+		}
+	}
+
+done:;
+	uint16_t payloadLength = ( uint16_t ) ( pos - ( header + BINARY_LOG_MESSAGE_HEADER ) );
+	int32_t levelId = level;
+	int64_t time = GetTimeNanoseconds();
+
+	uint8_t *h = header;
+	*h++ = BINARY_LOG_RECORD_MESSAGE;
+	memcpy( h, &formatId, sizeof( uint32_t ) );
+	h += sizeof( uint32_t );
+	memcpy( h, &levelId, sizeof( int32_t ) );
+	h += sizeof( int32_t );
+	memcpy( h, &buffer->threadId, sizeof( uint32_t ) );
+	h += sizeof( uint32_t );
+	memcpy( h, &time, sizeof( int64_t ) );
+	h += sizeof( int64_t );
+	memcpy( h, &payloadLength, sizeof( uint16_t ) );
+
+	size_t recordLength = BINARY_LOG_MESSAGE_HEADER + payloadLength;
+	buffer->length += recordLength;
+
+	PlUnlockMutex( buffer->mutex );
+
+	return recordLength;
+}
+
+bool _plIsBinaryLogEnabled( void ) {
+	return PlAtomicLoad32( &binaryLog.isEnabled );
+}
+
+void _plAddBinaryLogLevel( int id, const char *prefix ) {
+	if ( !_plIsBinaryLogEnabled() ) {
+		return;
+	}
+
+	PlLockMutex( binaryLog.mutex );
+	WriteLevelRecord( id, prefix );
+	PlUnlockMutex( binaryLog.mutex );
+}
+
+/**
+ * Switches log output over to the binary format, written to the given path.
+ * Messages are no longer formatted or printed to the console while enabled;
+ * use PlDecodeBinaryLog to turn the output back into text.
+ */
+bool PlSetupBinaryLogOutput( const char *path ) {
+	if ( path == NULL || path[ 0 ] == '\0' ) {
+		PlReportBasicError( PL_RESULT_FILEPATH );
+		return false;
+	}
+
+	PlShutdownBinaryLogOutput();
+
+	binaryLog.file = fopen( path, "wb" );
+	if ( binaryLog.file == NULL ) {
+		PlReportErrorF( PL_RESULT_FILEWRITE, "failed to open %s for writing", path );
+		return false;
+	}
+
+	if ( ( binaryLog.mutex = PlCreateMutex() ) == NULL ) {
+		fclose( binaryLog.file );
+		binaryLog.file = NULL;
+		return false;
+	}
+
+	fwrite( BINARY_LOG_IDENTIFIER, sizeof( char ), 8, binaryLog.file );
+
+	const char *prefix;
+	for ( int i = 0; ( prefix = _plGetLogLevelPrefix( i ) ) != NULL; ++i ) {
+		WriteLevelRecord( i, prefix );
+	}
+
+	PlAtomicFetchAdd32( &binaryLog.generation, 1 );
+	PlAtomicStore32( &binaryLog.isEnabled, 1 );
+
+	return true;
+}
+
+/**
+ * Writes out every thread's pending messages.
+ */
+void PlFlushBinaryLogOutput( void ) {
+	if ( !_plIsBinaryLogEnabled() ) {
+		return;
+	}
+
+	PlLockMutex( binaryLog.mutex );
+	BinaryLogBuffer *buffer = binaryLog.buffers;
+	PlUnlockMutex( binaryLog.mutex );
+
+	for ( ; buffer != NULL; buffer = buffer->next ) {
+		PlLockMutex( buffer->mutex );
+		FlushThreadBuffer( buffer );
+		PlUnlockMutex( buffer->mutex );
+	}
+
+	PlLockMutex( binaryLog.mutex );
+	fflush( binaryLog.file );
+	PlUnlockMutex( binaryLog.mutex );
+}
+
+/**
+ * Flushes and closes the binary log. Other threads must
+ * not be logging while this is called.
+ */
+void PlShutdownBinaryLogOutput( void ) {
+	if ( !_plIsBinaryLogEnabled() ) {
+		return;
+	}
+
+	PlFlushBinaryLogOutput();
+
+	PlAtomicStore32( &binaryLog.isEnabled, 0 );
+
+	BinaryLogBuffer *buffer = binaryLog.buffers;
+	while ( buffer != NULL ) {
+		BinaryLogBuffer *next = buffer->next;
+		PlDestroyMutex( buffer->mutex );
+		pl_free( buffer );
+		buffer = next;
+	}
+
+	fclose( binaryLog.file );
+	PlDestroyMutex( binaryLog.mutex );
+	pl_free( binaryLog.formats );
+
+	int32_t generation = binaryLog.generation;
+	memset( &binaryLog, 0, sizeof( binaryLog ) );
+	binaryLog.generation = generation;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// decoding
+
+typedef struct BinaryLogReader {
+	const uint8_t *pos;
+	const uint8_t *end;
+} BinaryLogReader;
+
+static bool ReadBytes( BinaryLogReader *reader, void *dst, size_t size ) {
+	if ( reader->pos + size > reader->end ) {
+		return false;
+	}
+
+	memcpy( dst, reader->pos, size );
+	reader->pos += size;
+	return true;
+}
+
+static bool ReadArgument( BinaryLogReader *reader, uint8_t expectedTag, void *dst, size_t size ) {
+	uint8_t tag;
+	if ( !ReadBytes( reader, &tag, sizeof( tag ) ) || tag != expectedTag ) {
+		reader->pos = reader->end;
+		return false;
+	}
+
+	return ReadBytes( reader, dst, size );
+}
+
+#define APPEND_LINE( ... )                                                      \
+	{                                                                           \
+		if ( c < sizeof( line ) ) {                                             \
+			int n_ = snprintf( line + c, sizeof( line ) - c, __VA_ARGS__ );     \
+			c = ( n_ > 0 ) ? ( ( c + n_ < sizeof( line ) ) ? c + n_ : sizeof( line ) - 1 ) : c; \
+		}                                                                       \
+	}
+
+static void DecodeMessage( FILE *out, const char *format, const char *prefix, int64_t time, BinaryLogReader *args ) {
+	char line[ 4096 ];
+	size_t c = 0;
+
+	char timeString[ 32 ];
+	time_t sec = ( time_t ) ( time / 1000000000 );
+	strftime( timeString, sizeof( timeString ), "%x %X", localtime( &sec ) );
+	if ( prefix != NULL && prefix[ 0 ] != '\0' ) {
+		APPEND_LINE( "[%s] %s: ", timeString, prefix );
+	} else {
+		APPEND_LINE( "[%s]: ", timeString );
+	}
+
+	for ( const char *p = format; *p != '\0'; ) {
+		if ( *p != '%' ) {
+			if ( c < sizeof( line ) - 1 ) {
+				line[ c++ ] = *p;
+			}
+			p++;
+			continue;
+		}
+
+		const char *specStart = p++;
+		if ( *p == '%' ) {
+			APPEND_LINE( "%%" );
+			p++;
+			continue;
+		}
+
+		FormatSpec spec;
+		const char *specEnd = ParseFormatSpec( p, &spec );
+		if ( specEnd == NULL ) {
+			break;
+		}
+		p = specEnd;
+
+		/* rebuild the specification with any '*' swapped for its recorded value
+		 * and the length normalised to match the type we stored */
+		char specString[ 64 ];
+		size_t sl = 0;
+		bool isPrecision = false;
+		for ( const char *s = specStart; s < spec.lengthStart && sl < sizeof( specString ) - 24; ++s ) {
+			/* recorded strings have already been clipped to their precision */
+			isPrecision = isPrecision || ( *s == '.' );
+			bool skip = ( isPrecision && spec.conversion == 's' );
+			if ( *s != '*' ) {
+				if ( !skip ) {
+					specString[ sl++ ] = *s;
+				}
+				continue;
+			}
+
+			int64_t v;
+			if ( !ReadArgument( args, BINARY_LOG_ARG_INT, &v, sizeof( v ) ) ) {
+				APPEND_LINE( "<?>" );
+				goto done;
+			}
+			if ( !skip ) {
+				sl += ( size_t ) snprintf( specString + sl, sizeof( specString ) - sl, "%d", ( int ) v );
+			}
+		}
+
+		switch ( spec.conversion ) {
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X': {
+				int64_t v;
+				if ( !ReadArgument( args, BINARY_LOG_ARG_INT, &v, sizeof( v ) ) ) {
+					APPEND_LINE( "<?>" );
+					goto done;
+				}
+				snprintf( specString + sl, sizeof( specString ) - sl, "ll%c", spec.conversion );
+				if ( spec.conversion == 'd' || spec.conversion == 'i' ) {
+					APPEND_LINE( specString, ( long long ) v );
+				} else {
+					APPEND_LINE( specString, ( unsigned long long ) v );
+				}
+				break;
+			}
+			case 'c': {
+				int64_t v;
+				if ( !ReadArgument( args, BINARY_LOG_ARG_INT, &v, sizeof( v ) ) ) {
+					APPEND_LINE( "<?>" );
+					goto done;
+				}
+				snprintf( specString + sl, sizeof( specString ) - sl, "c" );
+				APPEND_LINE( specString, ( int ) v );
+				break;
+			}
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A': {
+				double v;
+				if ( !ReadArgument( args, BINARY_LOG_ARG_DOUBLE, &v, sizeof( v ) ) ) {
+					APPEND_LINE( "<?>" );
+					goto done;
+				}
+				snprintf( specString + sl, sizeof( specString ) - sl, "%c", spec.conversion );
+				APPEND_LINE( specString, v );
+				break;
+			}
+			case 'p': {
+				uint64_t v;
+				if ( !ReadArgument( args, BINARY_LOG_ARG_POINTER, &v, sizeof( v ) ) ) {
+					APPEND_LINE( "<?>" );
+					goto done;
+				}
+				snprintf( specString + sl, sizeof( specString ) - sl, "p" );
+				APPEND_LINE( specString, ( void * ) ( uintptr_t ) v );
+				break;
+			}
+			case 'n':
+				break;
+			case 's': {
+				uint16_t length;
+				if ( !ReadArgument( args, BINARY_LOG_ARG_STRING, &length, sizeof( length ) ) || args->pos + length > args->end ) {
+					APPEND_LINE( "<?>" );
+					goto done;
+				}
+				snprintf( specString + sl, sizeof( specString ) - sl, ".*s" );
+				APPEND_LINE( specString, ( int ) length, ( const char * ) args->pos );
+				args->pos += length;
+				break;
+			}
+			default:
+				goto done;
+		}
+	}
+
+done:
+	if ( c == 0 || line[ c - 1 ] != '\n' ) {
+		if ( c >= sizeof( line ) - 1 ) {
+			c = sizeof( line ) - 2;
+		}
+		line[ c++ ] = '\n';
+	}
+	line[ c ] = '\0';
+
+	fputs( line, out );
+}
+
+/**
+ * Decodes a log written via PlSetupBinaryLogOutput back into
+ * text, matching the regular log output, and writes it to 'out'.
+ */
+bool PlDecodeBinaryLog( const char *path, FILE *out ) {
+	FILE *file = fopen( path, "rb" );
+	if ( file == NULL ) {
+		PlReportErrorF( PL_RESULT_FILEREAD, "failed to open %s", path );
+		return false;
+	}
+
+	fseek( file, 0, SEEK_END );
+	long size = ftell( file );
+	fseek( file, 0, SEEK_SET );
+
+	uint8_t *data = ( size > 0 ) ? pl_malloc( ( size_t ) size ) : NULL;
+	if ( data == NULL || fread( data, sizeof( uint8_t ), ( size_t ) size, file ) != ( size_t ) size ) {
+		PlReportErrorF( PL_RESULT_FILEREAD, "failed to read %s", path );
+		pl_free( data );
+		fclose( file );
+		return false;
+	}
+	fclose( file );
+
+	if ( size < 8 || memcmp( data, BINARY_LOG_IDENTIFIER, 8 ) != 0 ) {
+		PlReportErrorF( PL_RESULT_FILETYPE, "invalid binary log identifier" );
+		pl_free( data );
+		return false;
+	}
+
+	char **formats = NULL;
+	uint32_t maxFormats = 0;
+	char *prefixes[ 512 ] = { NULL };
+
+	BinaryLogReader reader = { data + 8, data + size };
+	bool status = true;
+	while ( reader.pos < reader.end ) {
+		uint8_t type = *reader.pos++;
+		if ( type == BINARY_LOG_RECORD_LEVEL ) {
+			int32_t id;
+			uint16_t length;
+			if ( !ReadBytes( &reader, &id, sizeof( id ) ) || !ReadBytes( &reader, &length, sizeof( length ) ) || reader.pos + length > reader.end ) {
+				status = false;
+				break;
+			}
+
+			if ( id >= 0 && id < ( int32_t ) plArrayElements( prefixes ) ) {
+				pl_free( prefixes[ id ] );
+				if ( ( prefixes[ id ] = pl_calloc( length + 1, sizeof( char ) ) ) != NULL ) {
+					memcpy( prefixes[ id ], reader.pos, length );
+				}
+			}
+			reader.pos += length;
+		} else if ( type == BINARY_LOG_RECORD_FORMAT ) {
+			uint32_t id;
+			uint16_t length;
+			if ( !ReadBytes( &reader, &id, sizeof( id ) ) || !ReadBytes( &reader, &length, sizeof( length ) ) || reader.pos + length > reader.end ) {
+				status = false;
+				break;
+			}
+
+			if ( id >= maxFormats ) {
+				uint32_t newMax = ( id + 1 ) * 2;
+				char **newFormats = pl_realloc( formats, sizeof( char * ) * newMax );
+				if ( newFormats == NULL ) {
+					status = false;
+					break;
+				}
+				memset( newFormats + maxFormats, 0, sizeof( char * ) * ( newMax - maxFormats ) );
+				formats = newFormats;
+				maxFormats = newMax;
+			}
+
+			pl_free( formats[ id ] );
+			if ( ( formats[ id ] = pl_calloc( length + 1, sizeof( char ) ) ) != NULL ) {
+				memcpy( formats[ id ], reader.pos, length );
+			}
+			reader.pos += length;
+		} else if ( type == BINARY_LOG_RECORD_MESSAGE ) {
+			uint32_t formatId, threadId;
+			int32_t levelId;
+			int64_t time;
+			uint16_t length;
+			if ( !ReadBytes( &reader, &formatId, sizeof( formatId ) ) || !ReadBytes( &reader, &levelId, sizeof( levelId ) ) ||
+			     !ReadBytes( &reader, &threadId, sizeof( threadId ) ) || !ReadBytes( &reader, &time, sizeof( time ) ) ||
+			     !ReadBytes( &reader, &length, sizeof( length ) ) || reader.pos + length > reader.end ) {
+				status = false;
+				break;
+			}
+
+			const char *format = ( formatId < maxFormats ) ? formats[ formatId ] : NULL;
+			const char *prefix = ( levelId >= 0 && levelId < ( int32_t ) plArrayElements( prefixes ) ) ? prefixes[ levelId ] : NULL;
+			if ( format != NULL ) {
+				BinaryLogReader args = { reader.pos, reader.pos + length };
+				DecodeMessage( out, format, prefix, time, &args );
+			}
+			reader.pos += length;
+		} else {
+			status = false;
+			break;
+		}
+	}
+
+	if ( !status ) {
+		PlReportErrorF( PL_RESULT_FILESIZE, "unexpected end of binary log, %s", path );
+	}
+
+	for ( uint32_t i = 0; i < maxFormats; ++i ) {
+		pl_free( formats[ i ] );
+	}
+	pl_free( formats );
+	for ( unsigned int i = 0; i < plArrayElements( prefixes ); ++i ) {
+		pl_free( prefixes[ i ] );
+	}
+	pl_free( data );
+
+	return status;
+}
@@ -6,6 +6,7 @@
 
 #include <plcore/pl_console.h>
 #include <plcore/pl_filesystem.h>
+#include <plcore/pl_thread.h>
 
 #include "pl_private.h"
 
@@ -22,6 +23,93 @@
 // todo, mouse input callback
 // todo, keyboard input callback
 
+/**
+ * Sorted name index shared between commands and variables, maintained on
+ * registration so lookups and autocompletion can binary search rather than
+ * walk every entry.
+ */
+typedef struct ConsoleIndexEntry {
+	const char *name;
+	bool isCommand;
+	void *ptr;
+} ConsoleIndexEntry;
+
+static ConsoleIndexEntry *consoleIndex = NULL;
+static size_t consoleIndexSize = 0;
+static size_t consoleIndexMax = 0;
+
+/**
+ * Returns the first slot whose name is not less than the given string,
+ * comparing only the first 'len' characters if 'len' is non-zero.
+ */
+static size_t GetConsoleIndexLowerBound( const char *string, size_t len ) {
+	size_t lo = 0, hi = consoleIndexSize;
+	while ( lo < hi ) {
+		size_t mid = lo + ( hi - lo ) / 2;
+		int r = ( len > 0 ) ? pl_strncasecmp( consoleIndex[ mid ].name, string, len ) : pl_strcasecmp( consoleIndex[ mid ].name, string );
+		if ( r < 0 ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * Returns the first slot past every name sharing the given prefix.
+ */
+static size_t GetConsoleIndexUpperBound( const char *prefix, size_t len ) {
+	size_t lo = 0, hi = consoleIndexSize;
+	while ( lo < hi ) {
+		size_t mid = lo + ( hi - lo ) / 2;
+		if ( pl_strncasecmp( consoleIndex[ mid ].name, prefix, len ) <= 0 ) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+static bool InsertConsoleIndex( const char *name, bool isCommand, void *ptr ) {
+	if ( consoleIndexSize >= consoleIndexMax ) {
+		size_t newMax = ( consoleIndexMax == 0 ) ? 256 : consoleIndexMax * 2;
+		ConsoleIndexEntry *newIndex = pl_realloc( consoleIndex, sizeof( ConsoleIndexEntry ) * newMax );
+		if ( newIndex == NULL ) {
+			PlReportErrorF( PL_RESULT_MEMORY_ALLOCATION, "failed to allocate %zu bytes for console index",
+			                sizeof( ConsoleIndexEntry ) * newMax );
+			return false;
+		}
+		consoleIndex = newIndex;
+		consoleIndexMax = newMax;
+	}
+
+	/* after any others of the same name, so lookups keep finding the first registered */
+	size_t slot = GetConsoleIndexUpperBound( name, strlen( name ) + 1 );
+	memmove( &consoleIndex[ slot + 1 ], &consoleIndex[ slot ], sizeof( ConsoleIndexEntry ) * ( consoleIndexSize - slot ) );
+	consoleIndex[ slot ].name = name;
+	consoleIndex[ slot ].isCommand = isCommand;
+	consoleIndex[ slot ].ptr = ptr;
+	consoleIndexSize++;
+	return true;
+}
+
+static void *FindConsoleIndex( const char *name, bool isCommand ) {
+	if ( name == NULL ) {
+		return NULL;
+	}
+
+	for ( size_t i = GetConsoleIndexLowerBound( name, 0 ); i < consoleIndexSize; ++i ) {
+		if ( pl_strcasecmp( consoleIndex[ i ].name, name ) != 0 ) {
+			break;
+		} else if ( consoleIndex[ i ].isCommand == isCommand ) {
+			return consoleIndex[ i ].ptr;
+		}
+	}
+	return NULL;
+}
+
 static PLConsoleCommand **_pl_commands = NULL;
 static size_t _pl_num_commands = 0;
 static size_t _pl_commands_size = 512;
@@ -67,6 +155,12 @@ void PlRegisterConsoleCommand( const char *name, void ( *CallbackFunction )( uns
 			strncpy( cmd->description, description, sizeof( cmd->description ) );
 		}
 
+		if ( !InsertConsoleIndex( cmd->cmd, true, cmd ) ) {
+			pl_free( cmd );
+			_pl_commands[ _pl_num_commands ] = NULL;
+			return;
+		}
+
 		_pl_num_commands++;
 	}
 }
@@ -77,12 +171,7 @@ void PlGetConsoleCommands( PLConsoleCommand ***cmds, size_t *num_cmds ) {
 }
 
 PLConsoleCommand *PlGetConsoleCommand( const char *name ) {
-	for ( PLConsoleCommand **cmd = _pl_commands; cmd < _pl_commands + _pl_num_commands; ++cmd ) {
-		if ( pl_strcasecmp( name, ( *cmd )->cmd ) == 0 ) {
-			return ( *cmd );
-		}
-	}
-	return NULL;
+	return ( PLConsoleCommand * ) FindConsoleIndex( name, true );
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -133,6 +222,12 @@ PLConsoleVariable *PlRegisterConsoleVariable( const char *name, const char *def,
 
 		PlSetConsoleVariable( out, out->default_value );
 
+		if ( !InsertConsoleIndex( out->var, false, out ) ) {
+			pl_free( out );
+			_pl_variables[ _pl_num_variables ] = NULL;
+			return NULL;
+		}
+
 		// Ensure the callback is only called afterwards
 		if ( CallbackFunction != NULL ) {
 			out->CallbackFunction = CallbackFunction;
@@ -150,12 +245,7 @@ void PlGetConsoleVariables( PLConsoleVariable ***vars, size_t *num_vars ) {
 }
 
 PLConsoleVariable *PlGetConsoleVariable( const char *name ) {
-	for ( PLConsoleVariable **var = _pl_variables; var < _pl_variables + _pl_num_variables; ++var ) {
-		if ( pl_strcasecmp( name, ( *var )->var ) == 0 ) {
-			return ( *var );
-		}
-	}
-	return NULL;
+	return ( PLConsoleVariable * ) FindConsoleIndex( name, false );
 }
 
 const char *PlGetConsoleVariableValue( const char *name ) {
@@ -352,6 +442,9 @@ PLFunctionResult PlInitConsole( void ) {
 }
 
 void PlShutdownConsole( void ) {
+	PlShutdownBinaryLogOutput();
+	PlShutdownAsyncLogOutput();
+
 	if ( _pl_commands ) {
 		for ( PLConsoleCommand **cmd = _pl_commands; cmd < _pl_commands + _pl_num_commands; ++cmd ) {
 			// todo, should we return here; assume it's the end?
@@ -376,6 +469,10 @@ void PlShutdownConsole( void ) {
 		pl_free( _pl_variables );
 	}
 
+	pl_free( consoleIndex );
+	consoleIndex = NULL;
+	consoleIndexSize = consoleIndexMax = 0;
+
 	ConsoleOutputCallback = NULL;
 }
 
@@ -386,32 +483,54 @@ void PlSetConsoleOutputCallback( void ( *Callback )( int level, const char *msg
 /////////////////////////////////////////////////////
 
 /**
- * Takes a string and returns a list of possible options.
+ * Fetches a page of completions for the given string, sorted by name.
+ * Returns the number of options written; 'totalMatches' receives the
+ * full count so the caller can page through the rest.
  */
-const char **PlAutocompleteConsoleString( const char *string, unsigned int *numElements ) {
-#define MAX_AUTO_OPTIONS 16
-	static const char *options[ MAX_AUTO_OPTIONS ];
+unsigned int PlAutocompleteConsoleStringPaged( const char *string, unsigned int offset, const char **options,
+                                               unsigned int maxOptions, unsigned int *totalMatches ) {
+	size_t len = ( string != NULL ) ? strlen( string ) : 0;
+	size_t start = 0, end = consoleIndexSize;
+	if ( len > 0 ) {
+		start = GetConsoleIndexLowerBound( string, len );
+		end = GetConsoleIndexUpperBound( string, len );
+	}
+
+	if ( totalMatches != NULL ) {
+		*totalMatches = ( unsigned int ) ( end - start );
+	}
+
 	unsigned int c = 0;
-	/* gather all the console variables */
-	for ( unsigned int i = 0; i < _pl_num_variables; ++i ) {
-		if ( c >= MAX_AUTO_OPTIONS ) {
-			break;
-		} else if ( pl_strncasecmp( string, _pl_variables[ i ]->var, strlen( string ) ) != 0 ) {
-			continue;
-		}
-		options[ c++ ] = _pl_variables[ i ]->var;
+	for ( size_t i = start + offset; i < end && c < maxOptions; ++i ) {
+		options[ c++ ] = consoleIndex[ i ].name;
 	}
-	/* gather up all the console commands */
-	for ( unsigned int i = 0; i < _pl_num_commands; ++i ) {
-		if ( c >= MAX_AUTO_OPTIONS ) {
-			break;
-		} else if ( pl_strncasecmp( string, _pl_commands[ i ]->cmd, strlen( string ) ) != 0 ) {
-			continue;
+
+	return c;
+}
+
+/**
+ * Takes a string and returns a sorted list of every possible option.
+ * The returned list is owned by the console and is only valid until the next call.
+ */
+const char **PlAutocompleteConsoleString( const char *string, unsigned int *numElements ) {
+	static const char **options = NULL;
+	static unsigned int maxOptions = 0;
+
+	unsigned int total;
+	PlAutocompleteConsoleStringPaged( string, 0, NULL, 0, &total );
+	if ( total > maxOptions ) {
+		const char **newOptions = pl_realloc( options, sizeof( char * ) * total );
+		if ( newOptions == NULL ) {
+			PlReportErrorF( PL_RESULT_MEMORY_ALLOCATION, "failed to allocate %zu bytes for autocomplete options",
+			                sizeof( char * ) * total );
+			*numElements = 0;
+			return options;
 		}
-		options[ c++ ] = _pl_commands[ i ]->cmd;
+		options = newOptions;
+		maxOptions = total;
 	}
 
-	*numElements = c;
+	*numElements = PlAutocompleteConsoleStringPaged( string, 0, options, maxOptions, NULL );
 	return options;
 }
 
@@ -421,7 +540,7 @@ void PlParseConsoleString( const char *string ) {
 		return;
 	}
 
-	PlLogMessage( LOG_LEVEL_LOW, string );
+	PlLogMessage( LOG_LEVEL_LOW, "%s", string );
 
 	static char **argv = NULL;
 	if ( argv == NULL ) {
@@ -483,6 +602,9 @@ typedef struct LogLevel {
 	char prefix[ 64 ];// e.g. 'warning, 'error'
 	PLColour colour;
 	PLConsoleVariable *var;
+	volatile int64_t numMessages;
+	volatile int64_t numDropped;
+	volatile int64_t numBytes;
 } LogLevel;
 static LogLevel levels[ MAX_LOG_LEVELS ];
 
@@ -521,6 +643,17 @@ static LogLevel *GetLogLevelForId( int id ) {
 	return &levels[ id ];
 }
 
+/**
+ * Returns the prefix for the given level, or NULL if it's not reserved.
+ */
+const char *_plGetLogLevelPrefix( int id ) {
+	if ( id < 0 || id >= MAX_LOG_LEVELS || !levels[ id ].isReserved ) {
+		return NULL;
+	}
+
+	return levels[ id ].prefix;
+}
+
 /**
  * Fetches the next unreserved slot.
  */
@@ -535,19 +668,313 @@ static int GetNextFreeLogLevel( void ) {
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
-// public
+// asynchronous output
+
+/* Messages are pushed into a bounded multi-producer queue (each slot carries
+ * a sequence number, so producers only contend on a single counter) and a
+ * background thread drains it into a batch which is written out and flushed
+ * periodically, keeping disk I/O off the calling thread. */
+
+#define LOG_QUEUE_LENGTH         512 /* must be a power of two */
+#define LOG_QUEUE_MESSAGE_LENGTH 4096 /* same as the buffer in PlLogMessage, so nothing gets cut short */
+#define LOG_BATCH_SIZE           65536
+
+typedef struct LogQueueSlot {
+	volatile int64_t sequence;
+	unsigned int length;
+	char message[ LOG_QUEUE_MESSAGE_LENGTH ];
+} LogQueueSlot;
+
+static struct {
+	LogQueueSlot *slots;
+	volatile int64_t enqueuePos;
+	int64_t dequeuePos; /* only touched by the writer */
+
+	volatile int64_t flushTarget;
+	volatile int64_t flushedPos;
+	volatile int32_t isRunning;
+	volatile int32_t reopenFile;
+
+	PLLogOverflowPolicy policy;
+	unsigned int flushInterval;
+	char path[ PL_SYSTEM_MAX_PATH ]; /* handed to the writer along with reopenFile, under the mutex */
+
+	PLThread *thread;
+	PLMutex *mutex;
+	PLCondition *wake;
+	PLCondition *drained;
+} asyncLog;
 
 static char logOutputPath[ PL_SYSTEM_MAX_PATH ] = { '\0' };
 
+static bool PushLogQueue( const char *message, size_t length ) {
+	if ( length > LOG_QUEUE_MESSAGE_LENGTH ) {
+		length = LOG_QUEUE_MESSAGE_LENGTH;
+	}
+
+	int64_t pos = PlAtomicLoad64( &asyncLog.enqueuePos );
+	for ( ;; ) {
+		LogQueueSlot *slot = &asyncLog.slots[ pos & ( LOG_QUEUE_LENGTH - 1 ) ];
+		int64_t diff = PlAtomicLoad64( &slot->sequence ) - pos;
+		if ( diff == 0 ) {
+			if ( !PlAtomicCompareExchange64( &asyncLog.enqueuePos, &pos, pos + 1 ) ) {
+				continue;
+			}
+
+			memcpy( slot->message, message, length );
+			/* keep truncated messages on their own line */
+			slot->message[ length - 1 ] = '\n';
+			slot->length = ( unsigned int ) length;
+			PlAtomicStore64( &slot->sequence, pos + 1 );
+
+			/* nudge the writer every half queue, otherwise it wakes on its own interval */
+			if ( ( pos & ( LOG_QUEUE_LENGTH / 2 - 1 ) ) == 0 ) {
+				PlSignalCondition( asyncLog.wake );
+			}
+			return true;
+		} else if ( diff < 0 ) {
+			/* queue is full */
+			if ( asyncLog.policy == PL_LOG_OVERFLOW_DROP ) {
+				return false;
+			}
+
+			PlSignalCondition( asyncLog.wake );
+			PlYieldThread();
+			pos = PlAtomicLoad64( &asyncLog.enqueuePos );
+		} else {
+			pos = PlAtomicLoad64( &asyncLog.enqueuePos );
+		}
+	}
+}
+
+static FILE *WriteLogBatch( FILE *file, char *path, const char *batch, size_t length ) {
+	if ( PlAtomicLoad32( &asyncLog.reopenFile ) ) {
+		if ( file != NULL ) {
+			fclose( file );
+			file = NULL;
+		}
+
+		PlLockMutex( asyncLog.mutex );
+		memcpy( path, asyncLog.path, sizeof( asyncLog.path ) );
+		PlAtomicStore32( &asyncLog.reopenFile, 0 );
+		PlUnlockMutex( asyncLog.mutex );
+	}
+
+	if ( length == 0 ) {
+		return file;
+	}
+
+	if ( file == NULL && path[ 0 ] != '\0' ) {
+		file = fopen( path, "a" );
+	}
+
+	if ( file != NULL ) {
+		fwrite( batch, sizeof( char ), length, file );
+	}
+
+	return file;
+}
+
+static int AsyncLogWriterThread( void *userData ) {
+	PlUnused( userData );
+
+	char *batch = pl_malloc( LOG_BATCH_SIZE );
+	if ( batch == NULL ) {
+		return -1;
+	}
+
+	size_t batchLength = 0;
+	FILE *file = NULL;
+	char path[ PL_SYSTEM_MAX_PATH ] = { '\0' }; /* our own copy, only updated on reopen */
+	for ( ;; ) {
+		bool isRunning = PlAtomicLoad32( &asyncLog.isRunning );
+
+		/* drain everything that's been published so far */
+		for ( ;; ) {
+			LogQueueSlot *slot = &asyncLog.slots[ asyncLog.dequeuePos & ( LOG_QUEUE_LENGTH - 1 ) ];
+			if ( PlAtomicLoad64( &slot->sequence ) != asyncLog.dequeuePos + 1 ) {
+				break;
+			}
+
+			if ( batchLength + slot->length > LOG_BATCH_SIZE ) {
+				file = WriteLogBatch( file, path, batch, batchLength );
+				batchLength = 0;
+			}
+
+			memcpy( batch + batchLength, slot->message, slot->length );
+			batchLength += slot->length;
+
+			PlAtomicStore64( &slot->sequence, asyncLog.dequeuePos + LOG_QUEUE_LENGTH );
+			asyncLog.dequeuePos++;
+		}
+
+		file = WriteLogBatch( file, path, batch, batchLength );
+		batchLength = 0;
+		if ( file != NULL ) {
+			fflush( file );
+		}
+
+		PlLockMutex( asyncLog.mutex );
+		PlAtomicStore64( &asyncLog.flushedPos, asyncLog.dequeuePos );
+		PlBroadcastCondition( asyncLog.drained );
+
+		if ( !isRunning ) {
+			PlUnlockMutex( asyncLog.mutex );
+			break;
+		}
+
+		/* a flush is waiting on a message that's been claimed but not yet published */
+		if ( PlAtomicLoad64( &asyncLog.flushTarget ) > asyncLog.dequeuePos ) {
+			PlUnlockMutex( asyncLog.mutex );
+			PlYieldThread();
+			continue;
+		}
+
+		PlWaitCondition( asyncLog.wake, asyncLog.mutex, asyncLog.flushInterval );
+		PlUnlockMutex( asyncLog.mutex );
+	}
+
+	if ( file != NULL ) {
+		fclose( file );
+	}
+
+	pl_free( batch );
+
+	return 0;
+}
+
+/**
+ * Moves writing of the log output file onto a background thread.
+ * Console output and the output callback are still called immediately.
+ * flushInterval is the maximum time, in milliseconds, before queued messages hit the disk.
+ * Calling it again while it's running just updates the policy and interval.
+ */
+bool PlSetupAsyncLogOutput( PLLogOverflowPolicy policy, unsigned int flushInterval ) {
+	if ( asyncLog.thread != NULL ) {
+		PlLockMutex( asyncLog.mutex );
+		asyncLog.policy = policy;
+		asyncLog.flushInterval = ( flushInterval > 0 ) ? flushInterval : 1;
+		/* so the writer's current wait doesn't hold on to the old interval */
+		PlSignalCondition( asyncLog.wake );
+		PlUnlockMutex( asyncLog.mutex );
+		return true;
+	}
+
+	asyncLog.slots = pl_calloc( LOG_QUEUE_LENGTH, sizeof( LogQueueSlot ) );
+	if ( asyncLog.slots == NULL ) {
+		return false;
+	}
+
+	for ( int64_t i = 0; i < LOG_QUEUE_LENGTH; ++i ) {
+		asyncLog.slots[ i ].sequence = i;
+	}
+
+	asyncLog.enqueuePos = asyncLog.dequeuePos = 0;
+	asyncLog.flushTarget = asyncLog.flushedPos = 0;
+	asyncLog.reopenFile = 1;
+	snprintf( asyncLog.path, sizeof( asyncLog.path ), "%s", logOutputPath );
+	asyncLog.policy = policy;
+	asyncLog.flushInterval = ( flushInterval > 0 ) ? flushInterval : 1;
+	asyncLog.isRunning = 1;
+
+	asyncLog.mutex = PlCreateMutex();
+	asyncLog.wake = PlCreateCondition();
+	asyncLog.drained = PlCreateCondition();
+	if ( asyncLog.mutex == NULL || asyncLog.wake == NULL || asyncLog.drained == NULL ||
+	     ( asyncLog.thread = PlCreateThread( AsyncLogWriterThread, NULL ) ) == NULL ) {
+		PlDestroyCondition( asyncLog.drained );
+		PlDestroyCondition( asyncLog.wake );
+		PlDestroyMutex( asyncLog.mutex );
+		pl_free( asyncLog.slots );
+		memset( &asyncLog, 0, sizeof( asyncLog ) );
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Writes out anything still queued and returns to synchronous output.
+ */
+void PlShutdownAsyncLogOutput( void ) {
+	if ( asyncLog.thread == NULL ) {
+		return;
+	}
+
+	PlLockMutex( asyncLog.mutex );
+	PlAtomicStore32( &asyncLog.isRunning, 0 );
+	PlSignalCondition( asyncLog.wake );
+	PlUnlockMutex( asyncLog.mutex );
+
+	PlJoinThread( asyncLog.thread );
+
+	PlDestroyCondition( asyncLog.drained );
+	PlDestroyCondition( asyncLog.wake );
+	PlDestroyMutex( asyncLog.mutex );
+	pl_free( asyncLog.slots );
+	memset( &asyncLog, 0, sizeof( asyncLog ) );
+}
+
+/**
+ * Blocks until every message logged before the call has been written out.
+ */
+void PlFlushLogOutput( void ) {
+	if ( asyncLog.thread == NULL ) {
+		return;
+	}
+
+	int64_t target = PlAtomicLoad64( &asyncLog.enqueuePos );
+	int64_t current = PlAtomicLoad64( &asyncLog.flushTarget );
+	while ( current < target && !PlAtomicCompareExchange64( &asyncLog.flushTarget, &current, target ) ) {}
+
+	PlLockMutex( asyncLog.mutex );
+	PlSignalCondition( asyncLog.wake );
+	while ( PlAtomicLoad64( &asyncLog.flushedPos ) < target ) {
+		PlWaitCondition( asyncLog.drained, asyncLog.mutex, asyncLog.flushInterval );
+	}
+	PlUnlockMutex( asyncLog.mutex );
+}
+
+bool PlGetLogLevelCounters( int id, PLLogLevelCounters *counters ) {
+	LogLevel *l = GetLogLevelForId( id );
+	if ( l == NULL || !l->isReserved ) {
+		return false;
+	}
+
+	counters->numMessages = ( uint64_t ) PlAtomicLoad64( &l->numMessages );
+	counters->numDropped = ( uint64_t ) PlAtomicLoad64( &l->numDropped );
+	counters->numBytes = ( uint64_t ) PlAtomicLoad64( &l->numBytes );
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// public
+
+
 void PlSetupLogOutput( const char *path ) {
 	if ( path == NULL || path[ 0 ] == '\0' ) {
 		return;
 	}
 
+	/* make sure anything queued for the old path goes there */
+	PlFlushLogOutput();
+
+	/* the writer only takes the new path under the lock, so it can't reopen
+	 * the file before it has been cleared out */
+	if ( asyncLog.thread != NULL ) {
+		PlLockMutex( asyncLog.mutex );
+	}
+
 	strncpy( logOutputPath, path, sizeof( logOutputPath ) );
 	if ( PlFileExists( logOutputPath ) ) {
 		unlink( logOutputPath );
 	}
+
+	if ( asyncLog.thread != NULL ) {
+		memcpy( asyncLog.path, logOutputPath, sizeof( asyncLog.path ) );
+		PlAtomicStore32( &asyncLog.reopenFile, 1 );
+		PlUnlockMutex( asyncLog.mutex );
+	}
 }
 
 int PlAddLogLevel( const char *prefix, PLColour colour, bool status ) {
@@ -568,6 +995,8 @@ int PlAddLogLevel( const char *prefix, PLColour colour, bool status ) {
 	snprintf( var, sizeof( var ), "log.%s", prefix );
 	l->var = PlRegisterConsoleVariable( var, status ? "1" : "0", pl_bool_var, NULL, "Console output level." );
 
+	_plAddBinaryLogLevel( i, l->prefix );
+
 	return i;
 }
 
@@ -586,6 +1015,18 @@ void PlLogMessage( int id, const char *msg, ... ) {
 		return;
 	}
 
+	/* binary output skips formatting entirely, see pl_binarylog.c */
+	if ( _plIsBinaryLogEnabled() ) {
+		va_list args;
+		va_start( args, msg );
+		size_t length = _plRecordBinaryLogMessage( id, msg, args );
+		va_end( args );
+
+		PlAtomicFetchAdd64( &l->numMessages, 1 );
+		PlAtomicFetchAdd64( &l->numBytes, ( int64_t ) length );
+		return;
+	}
+
 	char buf[ 4096 ] = { '\0' };
 
 	// add the prefix to the start
@@ -605,6 +1046,10 @@ void PlLogMessage( int id, const char *msg, ... ) {
 		strncat( buf, "\n", sizeof( buf ) - strlen( buf ) - 1 );
 	}
 
+	size_t length = strlen( buf );
+	PlAtomicFetchAdd64( &l->numMessages, 1 );
+	PlAtomicFetchAdd64( &l->numBytes, ( int64_t ) length );
+
 #if defined( _WIN32 )
 	OutputDebugString( buf );
 #endif
@@ -617,23 +1062,33 @@ void PlLogMessage( int id, const char *msg, ... ) {
 		ConsoleOutputCallback( id, buf );
 	}
 
+	if ( logOutputPath[ 0 ] == '\0' ) {
+		return;
+	}
+
+	if ( asyncLog.thread != NULL ) {
+		if ( !PushLogQueue( buf, length ) ) {
+			PlAtomicFetchAdd64( &l->numDropped, 1 );
+		}
+		return;
+	}
+
 	static bool avoid_recursion = false;
-	if ( !avoid_recursion ) {
-		if ( logOutputPath[ 0 ] != '\0' ) {
-			size_t size = strlen( buf );
-			FILE *file = fopen( logOutputPath, "a" );
-			if ( file != NULL ) {
-				if ( fwrite( buf, sizeof( char ), size, file ) != size ) {
-					avoid_recursion = true;
-					PlReportErrorF( PL_RESULT_FILEERR, "failed to write to log, %s\n%s", logOutputPath, strerror( errno ) );
-				}
-				fclose( file );
-				return;
-			}
+	if ( avoid_recursion ) {
+		return;
+	}
 
-			// todo, needs to be more appropriate; return details on exact issue
+	FILE *file = fopen( logOutputPath, "a" );
+	if ( file != NULL ) {
+		if ( fwrite( buf, sizeof( char ), length, file ) != length ) {
 			avoid_recursion = true;
-			PlReportErrorF( PL_RESULT_FILEREAD, "failed to open %s", logOutputPath );
+			PlReportErrorF( PL_RESULT_FILEERR, "failed to write to log, %s\n%s", logOutputPath, strerror( errno ) );
 		}
+		fclose( file );
+		return;
 	}
+
+	// todo, needs to be more appropriate; return details on exact issue
+	avoid_recursion = true;
+	PlReportErrorF( PL_RESULT_FILEREAD, "failed to open %s", logOutputPath );
 }
@@ -679,14 +679,18 @@ static void ScanLocalDirectory( const PLFileSystemMount *mount, FSScanInstance *
  * @param recursive if true, also scans the contents of each sub-directory.
  */
 void PlScanDirectory( const char *path, const char *extension, void ( *Function )( const char *, void * ), bool recursive, void *userData ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	if ( strncmp( FS_LOCAL_HINT, path, sizeof( FS_LOCAL_HINT ) ) == 0 ) {
 		ScanLocalDirectory( NULL, NULL, path + sizeof( FS_LOCAL_HINT ), extension, Function, recursive, userData );
+		PL_PROFILE_END();
 		return;
 	}
 
 	// If no mounted locations, assume local scan
 	if ( fs_mount_root == NULL ) {
 		ScanLocalDirectory( NULL, NULL, path, extension, Function, recursive, userData );
+		PL_PROFILE_END();
 		return;
 	}
 
@@ -716,6 +720,8 @@ void PlScanDirectory( const char *path, const char *extension, void ( *Function
 		current = current->next;
 		pl_free( prev );
 	}
+
+	PL_PROFILE_END();
 }
 
 const char *PlGetWorkingDirectory( void ) {
@@ -750,11 +756,17 @@ bool PlLocalFileExists( const char *path ) {
  * @return False if the file wasn't accessible.
  */
 bool PlFileExists( const char *path ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	if ( fs_mount_root == NULL ) {
-		return PlLocalFileExists( path );
+		bool status = PlLocalFileExists( path );
+		PL_PROFILE_END();
+		return status;
 	} else if ( strncmp( FS_LOCAL_HINT, path, sizeof( FS_LOCAL_HINT ) ) == 0 ) {
 		path += sizeof( FS_LOCAL_HINT );
-		return PlLocalFileExists( path );
+		bool status = PlLocalFileExists( path );
+		PL_PROFILE_END();
+		return status;
 	}
 
 	PLFileSystemMount *location = fs_mount_root;
@@ -764,12 +776,14 @@ bool PlFileExists( const char *path ) {
 			char buf[ PL_SYSTEM_MAX_PATH + 1 ];
 			snprintf( buf, sizeof( buf ), "%s/%s", location->path, path );
 			if ( PlLocalFileExists( buf ) ) {
+				PL_PROFILE_END();
 				return true;
 			}
 		} else {
 			PLFile *fp = PlLoadPackageFile( location->pkg, path );
 			if ( fp != NULL ) {
 				PlCloseFile( fp );
+				PL_PROFILE_END();
 				return true;
 			}
 		}
@@ -777,6 +791,7 @@ bool PlFileExists( const char *path ) {
 		location = location->next;
 	}
 
+	PL_PROFILE_END();
 	return false;
 }
 
@@ -924,9 +939,12 @@ size_t PlGetLocalFileSize( const char *path ) {
 ///////////////////////////////////////////
 
 PLFile *PlOpenLocalFile( const char *path, bool cache ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	FILE *fp = fopen( path, "rb" );
 	if ( fp == NULL ) {
 		PlReportErrorF( PL_RESULT_FILEREAD, strerror( errno ) );
+		PL_PROFILE_END();
 		return NULL;
 	}
 
@@ -948,6 +966,7 @@ PLFile *PlOpenLocalFile( const char *path, bool cache ) {
 	/* timestamp for local files is a special case */
 	ptr->timeStamp = -1;
 
+	PL_PROFILE_END();
 	return ptr;
 }
 
@@ -995,6 +1014,53 @@ PLFile *PlOpenFile( const char *path, bool cache ) {
 	return NULL;
 }
 
+/**
+ * Wraps a block of memory in a file handle, so it can be
+ * passed to anything that reads from a PLFile.
+ * @param path Path to associate with the handle, may be NULL.
+ * @param buf Buffer containing the file data.
+ * @param bufSize Size of the buffer in bytes.
+ * @param bufType Whether the buffer is referenced, adopted or copied.
+ * @return Returns handle to the file instance.
+ */
+PLFile *PlCreateFileFromMemory( const char *path, void *buf, size_t bufSize, PLFileMemoryBufferType bufType ) {
+	if ( buf == NULL && bufSize > 0 ) {
+		PlReportBasicError( PL_RESULT_INVALID_PARM2 );
+		return NULL;
+	}
+
+	PLFile *ptr = pl_calloc( 1, sizeof( PLFile ) );
+	snprintf( ptr->path, sizeof( ptr->path ), "%s", path != NULL ? path : "" );
+	ptr->size = bufSize;
+
+	switch ( bufType ) {
+		case PL_FILE_MEMORYBUFFERTYPE_UNMANAGED:
+			ptr->data = buf;
+			ptr->isUnmanaged = true;
+			break;
+		case PL_FILE_MEMORYBUFFERTYPE_OWNER:
+			ptr->data = buf;
+			break;
+		case PL_FILE_MEMORYBUFFERTYPE_COPY:
+			ptr->data = pl_malloc( bufSize );
+			if ( ptr->data == NULL ) {
+				pl_free( ptr );
+				return NULL;
+			}
+			memcpy( ptr->data, buf, bufSize );
+			break;
+		default:
+			pl_free( ptr );
+			PlReportBasicError( PL_RESULT_INVALID_PARM4 );
+			return NULL;
+	}
+
+	ptr->pos = ptr->data;
+	ptr->timeStamp = 0;
+
+	return ptr;
+}
+
 void PlCloseFile( PLFile *ptr ) {
 	if ( ptr == NULL ) {
 		return;
@@ -1004,7 +1070,10 @@ void PlCloseFile( PLFile *ptr ) {
 		_pl_fclose( ptr->fptr );
 	}
 
-	pl_free( ptr->data );
+	if ( !ptr->isUnmanaged ) {
+		pl_free( ptr->data );
+	}
+
 	pl_free( ptr );
 }
 
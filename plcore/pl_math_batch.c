@@ -0,0 +1,424 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_math.h>
+
+#include <float.h>
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Batched maths over structure-of-arrays streams. Every kernel takes the
+ * index to start from, so the vector kernels can hand whatever's left over
+ * to the next level down, and each evaluates exactly the same operations in
+ * the same order as the scalar kernel; nothing is fused, so the result is
+ * identical whichever kernel ends up doing the work. */
+
+typedef void ( *TransformKernel )( const float *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num, bool translate );
+typedef void ( *NormalizeKernel )( const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num );
+typedef void ( *DotKernel )( const PLVector3SoA *a, const PLVector3SoA *b, float *dst, size_t i, size_t num );
+typedef void ( *BoundsKernel )( const PLVector3SoA *src, size_t i, size_t num, float *mins, float *maxs );
+typedef void ( *LerpKernel )( const PLVector3SoA *a, const PLVector3SoA *b, float t, const PLVector3SoA *dst, size_t i, size_t num );
+typedef void ( *SlerpKernel )( const PLQuaternionSoA *a, const PLQuaternionSoA *b, const float *ca, const float *cb, float t, const PLQuaternionSoA *dst, size_t i, size_t num );
+
+static void TransformScalar( const float *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num, bool translate ) {
+	for ( ; i < num; ++i ) {
+		float x = src->x[ i ], y = src->y[ i ], z = src->z[ i ];
+		float rx = m[ 0 ] * x + m[ 4 ] * y + m[ 8 ] * z;
+		float ry = m[ 1 ] * x + m[ 5 ] * y + m[ 9 ] * z;
+		float rz = m[ 2 ] * x + m[ 6 ] * y + m[ 10 ] * z;
+		if ( translate ) {
+			rx += m[ 12 ];
+			ry += m[ 13 ];
+			rz += m[ 14 ];
+		}
+		dst->x[ i ] = rx;
+		dst->y[ i ] = ry;
+		dst->z[ i ] = rz;
+	}
+}
+
+static void NormalizeScalar( const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num ) {
+	for ( ; i < num; ++i ) {
+		float x = src->x[ i ], y = src->y[ i ], z = src->z[ i ];
+		float length = sqrtf( x * x + y * y + z * z );
+		if ( length != 0 ) {
+			x /= length;
+			y /= length;
+			z /= length;
+		}
+		dst->x[ i ] = x;
+		dst->y[ i ] = y;
+		dst->z[ i ] = z;
+	}
+}
+
+static void DotScalar( const PLVector3SoA *a, const PLVector3SoA *b, float *dst, size_t i, size_t num ) {
+	for ( ; i < num; ++i ) {
+		dst[ i ] = a->x[ i ] * b->x[ i ] + a->y[ i ] * b->y[ i ] + a->z[ i ] * b->z[ i ];
+	}
+}
+
+static void BoundsScalar( const PLVector3SoA *src, size_t i, size_t num, float *mins, float *maxs ) {
+	const float *c[ 3 ] = { src->x, src->y, src->z };
+	for ( unsigned int j = 0; j < 3; ++j ) {
+		float lo = mins[ j ], hi = maxs[ j ];
+		for ( size_t k = i; k < num; ++k ) {
+			float v = c[ j ][ k ];
+			lo = ( v < lo ) ? v : lo;
+			hi = ( v > hi ) ? v : hi;
+		}
+		mins[ j ] = lo;
+		maxs[ j ] = hi;
+	}
+}
+
+static void LerpScalar( const PLVector3SoA *a, const PLVector3SoA *b, float t, const PLVector3SoA *dst, size_t i, size_t num ) {
+	for ( ; i < num; ++i ) {
+		dst->x[ i ] = a->x[ i ] + ( b->x[ i ] - a->x[ i ] ) * t;
+		dst->y[ i ] = a->y[ i ] + ( b->y[ i ] - a->y[ i ] ) * t;
+		dst->z[ i ] = a->z[ i ] + ( b->z[ i ] - a->z[ i ] ) * t;
+	}
+}
+
+static void SlerpScalar( const PLQuaternionSoA *a, const PLQuaternionSoA *b, const float *ca, const float *cb, float t, const PLQuaternionSoA *dst, size_t i, size_t num ) {
+	for ( ; i < num; ++i ) {
+		PLQuaternion q = PLQuaternion( a->x[ i ], a->y[ i ], a->z[ i ], a->w[ i ] );
+		PLQuaternion q2 = PLQuaternion( b->x[ i ], b->y[ i ], b->z[ i ], b->w[ i ] );
+		float d = q.x * q2.x + q.y * q2.y + q.z * q2.z + q.w * q2.w;
+		bool flip = signbit( d );
+		float cosm1 = ( flip ? -d : d ) - 1.0f;
+		float wa = _plGetSlerpWeight( ca, 1.0f - t, cosm1 );
+		float wb = _plGetSlerpWeight( cb, t, cosm1 );
+		if ( flip ) {
+			wb = -wb;
+		}
+		dst->x[ i ] = wa * q.x + wb * q2.x;
+		dst->y[ i ] = wa * q.y + wb * q2.y;
+		dst->z[ i ] = wa * q.z + wb * q2.z;
+		dst->w[ i ] = wa * q.w + wb * q2.w;
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static void TransformSse2( const float *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num, bool translate ) {
+	__m128 c[ 12 ];
+	for ( unsigned int j = 0; j < 12; ++j ) {
+		c[ j ] = _mm_set1_ps( m[ ( j / 3 ) * 4 + j % 3 ] );
+	}
+
+	for ( ; i + 4 <= num; i += 4 ) {
+		__m128 x = _mm_loadu_ps( &src->x[ i ] ), y = _mm_loadu_ps( &src->y[ i ] ), z = _mm_loadu_ps( &src->z[ i ] );
+		__m128 rx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( c[ 0 ], x ), _mm_mul_ps( c[ 3 ], y ) ), _mm_mul_ps( c[ 6 ], z ) );
+		__m128 ry = _mm_add_ps( _mm_add_ps( _mm_mul_ps( c[ 1 ], x ), _mm_mul_ps( c[ 4 ], y ) ), _mm_mul_ps( c[ 7 ], z ) );
+		__m128 rz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( c[ 2 ], x ), _mm_mul_ps( c[ 5 ], y ) ), _mm_mul_ps( c[ 8 ], z ) );
+		if ( translate ) {
+			rx = _mm_add_ps( rx, c[ 9 ] );
+			ry = _mm_add_ps( ry, c[ 10 ] );
+			rz = _mm_add_ps( rz, c[ 11 ] );
+		}
+		_mm_storeu_ps( &dst->x[ i ], rx );
+		_mm_storeu_ps( &dst->y[ i ], ry );
+		_mm_storeu_ps( &dst->z[ i ], rz );
+	}
+
+	TransformScalar( m, src, dst, i, num, translate );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void NormalizeSse2( const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num ) {
+	const __m128 zero = _mm_setzero_ps();
+	for ( ; i + 4 <= num; i += 4 ) {
+		__m128 x = _mm_loadu_ps( &src->x[ i ] ), y = _mm_loadu_ps( &src->y[ i ] ), z = _mm_loadu_ps( &src->z[ i ] );
+		__m128 length = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) ) );
+		/* zero length vectors are left as they are */
+		__m128 mask = _mm_cmpneq_ps( length, zero );
+		_mm_storeu_ps( &dst->x[ i ], _mm_or_ps( _mm_and_ps( mask, _mm_div_ps( x, length ) ), _mm_andnot_ps( mask, x ) ) );
+		_mm_storeu_ps( &dst->y[ i ], _mm_or_ps( _mm_and_ps( mask, _mm_div_ps( y, length ) ), _mm_andnot_ps( mask, y ) ) );
+		_mm_storeu_ps( &dst->z[ i ], _mm_or_ps( _mm_and_ps( mask, _mm_div_ps( z, length ) ), _mm_andnot_ps( mask, z ) ) );
+	}
+
+	NormalizeScalar( src, dst, i, num );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void DotSse2( const PLVector3SoA *a, const PLVector3SoA *b, float *dst, size_t i, size_t num ) {
+	for ( ; i + 4 <= num; i += 4 ) {
+		__m128 r = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( &a->x[ i ] ), _mm_loadu_ps( &b->x[ i ] ) ),
+		                       _mm_mul_ps( _mm_loadu_ps( &a->y[ i ] ), _mm_loadu_ps( &b->y[ i ] ) ) );
+		r = _mm_add_ps( r, _mm_mul_ps( _mm_loadu_ps( &a->z[ i ] ), _mm_loadu_ps( &b->z[ i ] ) ) );
+		_mm_storeu_ps( &dst[ i ], r );
+	}
+
+	DotScalar( a, b, dst, i, num );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void BoundsSse2( const PLVector3SoA *src, size_t i, size_t num, float *mins, float *maxs ) {
+	const float *c[ 3 ] = { src->x, src->y, src->z };
+	size_t end = i + ( ( num - i ) & ~( size_t ) 3 );
+	for ( unsigned int j = 0; j < 3; ++j ) {
+		__m128 lo = _mm_set1_ps( mins[ j ] ), hi = _mm_set1_ps( maxs[ j ] );
+		for ( size_t k = i; k < end; k += 4 ) {
+			__m128 v = _mm_loadu_ps( &c[ j ][ k ] );
+			lo = _mm_min_ps( v, lo );
+			hi = _mm_max_ps( v, hi );
+		}
+		lo = _mm_min_ps( lo, _mm_shuffle_ps( lo, lo, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		hi = _mm_max_ps( hi, _mm_shuffle_ps( hi, hi, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		mins[ j ] = _mm_cvtss_f32( _mm_min_ss( lo, _mm_shuffle_ps( lo, lo, 1 ) ) );
+		maxs[ j ] = _mm_cvtss_f32( _mm_max_ss( hi, _mm_shuffle_ps( hi, hi, 1 ) ) );
+	}
+
+	BoundsScalar( src, end, num, mins, maxs );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void LerpSse2( const PLVector3SoA *a, const PLVector3SoA *b, float t, const PLVector3SoA *dst, size_t i, size_t num ) {
+	const __m128 tv = _mm_set1_ps( t );
+	for ( ; i + 4 <= num; i += 4 ) {
+		__m128 x = _mm_loadu_ps( &a->x[ i ] ), y = _mm_loadu_ps( &a->y[ i ] ), z = _mm_loadu_ps( &a->z[ i ] );
+		_mm_storeu_ps( &dst->x[ i ], _mm_add_ps( x, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &b->x[ i ] ), x ), tv ) ) );
+		_mm_storeu_ps( &dst->y[ i ], _mm_add_ps( y, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &b->y[ i ] ), y ), tv ) ) );
+		_mm_storeu_ps( &dst->z[ i ], _mm_add_ps( z, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &b->z[ i ] ), z ), tv ) ) );
+	}
+
+	LerpScalar( a, b, t, dst, i, num );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void SlerpSse2( const PLQuaternionSoA *a, const PLQuaternionSoA *b, const float *ca, const float *cb, float t, const PLQuaternionSoA *dst, size_t i, size_t num ) {
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 sign = _mm_set1_ps( -0.0f );
+	const __m128 ta = _mm_set1_ps( 1.0f - t ), tb = _mm_set1_ps( t );
+	__m128 va[ PL_SLERP_TERMS ], vb[ PL_SLERP_TERMS ];
+	for ( unsigned int j = 0; j < PL_SLERP_TERMS; ++j ) {
+		va[ j ] = _mm_set1_ps( ca[ j ] );
+		vb[ j ] = _mm_set1_ps( cb[ j ] );
+	}
+
+	for ( ; i + 4 <= num; i += 4 ) {
+		__m128 ax = _mm_loadu_ps( &a->x[ i ] ), ay = _mm_loadu_ps( &a->y[ i ] ), az = _mm_loadu_ps( &a->z[ i ] ), aw = _mm_loadu_ps( &a->w[ i ] );
+		__m128 bx = _mm_loadu_ps( &b->x[ i ] ), by = _mm_loadu_ps( &b->y[ i ] ), bz = _mm_loadu_ps( &b->z[ i ] ), bw = _mm_loadu_ps( &b->w[ i ] );
+		__m128 d = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, bx ), _mm_mul_ps( ay, by ) ), _mm_mul_ps( az, bz ) ), _mm_mul_ps( aw, bw ) );
+		__m128 flip = _mm_and_ps( d, sign );
+		__m128 cosm1 = _mm_sub_ps( _mm_xor_ps( d, flip ), one );
+		__m128 fa = one, fb = one;
+		for ( int j = PL_SLERP_TERMS - 1; j >= 0; --j ) {
+			fa = _mm_add_ps( one, _mm_mul_ps( _mm_mul_ps( va[ j ], cosm1 ), fa ) );
+			fb = _mm_add_ps( one, _mm_mul_ps( _mm_mul_ps( vb[ j ], cosm1 ), fb ) );
+		}
+		__m128 wa = _mm_mul_ps( ta, fa );
+		__m128 wb = _mm_xor_ps( _mm_mul_ps( tb, fb ), flip );
+		_mm_storeu_ps( &dst->x[ i ], _mm_add_ps( _mm_mul_ps( wa, ax ), _mm_mul_ps( wb, bx ) ) );
+		_mm_storeu_ps( &dst->y[ i ], _mm_add_ps( _mm_mul_ps( wa, ay ), _mm_mul_ps( wb, by ) ) );
+		_mm_storeu_ps( &dst->z[ i ], _mm_add_ps( _mm_mul_ps( wa, az ), _mm_mul_ps( wb, bz ) ) );
+		_mm_storeu_ps( &dst->w[ i ], _mm_add_ps( _mm_mul_ps( wa, aw ), _mm_mul_ps( wb, bw ) ) );
+	}
+
+	SlerpScalar( a, b, ca, cb, t, dst, i, num );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void TransformAvx2( const float *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num, bool translate ) {
+	__m256 c[ 12 ];
+	for ( unsigned int j = 0; j < 12; ++j ) {
+		c[ j ] = _mm256_set1_ps( m[ ( j / 3 ) * 4 + j % 3 ] );
+	}
+
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256 x = _mm256_loadu_ps( &src->x[ i ] ), y = _mm256_loadu_ps( &src->y[ i ] ), z = _mm256_loadu_ps( &src->z[ i ] );
+		__m256 rx = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( c[ 0 ], x ), _mm256_mul_ps( c[ 3 ], y ) ), _mm256_mul_ps( c[ 6 ], z ) );
+		__m256 ry = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( c[ 1 ], x ), _mm256_mul_ps( c[ 4 ], y ) ), _mm256_mul_ps( c[ 7 ], z ) );
+		__m256 rz = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( c[ 2 ], x ), _mm256_mul_ps( c[ 5 ], y ) ), _mm256_mul_ps( c[ 8 ], z ) );
+		if ( translate ) {
+			rx = _mm256_add_ps( rx, c[ 9 ] );
+			ry = _mm256_add_ps( ry, c[ 10 ] );
+			rz = _mm256_add_ps( rz, c[ 11 ] );
+		}
+		_mm256_storeu_ps( &dst->x[ i ], rx );
+		_mm256_storeu_ps( &dst->y[ i ], ry );
+		_mm256_storeu_ps( &dst->z[ i ], rz );
+	}
+
+	TransformSse2( m, src, dst, i, num, translate );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void NormalizeAvx2( const PLVector3SoA *src, const PLVector3SoA *dst, size_t i, size_t num ) {
+	const __m256 zero = _mm256_setzero_ps();
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256 x = _mm256_loadu_ps( &src->x[ i ] ), y = _mm256_loadu_ps( &src->y[ i ] ), z = _mm256_loadu_ps( &src->z[ i ] );
+		__m256 length = _mm256_sqrt_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, x ), _mm256_mul_ps( y, y ) ), _mm256_mul_ps( z, z ) ) );
+		__m256 mask = _mm256_cmp_ps( length, zero, _CMP_NEQ_UQ );
+		_mm256_storeu_ps( &dst->x[ i ], _mm256_blendv_ps( x, _mm256_div_ps( x, length ), mask ) );
+		_mm256_storeu_ps( &dst->y[ i ], _mm256_blendv_ps( y, _mm256_div_ps( y, length ), mask ) );
+		_mm256_storeu_ps( &dst->z[ i ], _mm256_blendv_ps( z, _mm256_div_ps( z, length ), mask ) );
+	}
+
+	NormalizeSse2( src, dst, i, num );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void DotAvx2( const PLVector3SoA *a, const PLVector3SoA *b, float *dst, size_t i, size_t num ) {
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256 r = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( &a->x[ i ] ), _mm256_loadu_ps( &b->x[ i ] ) ),
+		                          _mm256_mul_ps( _mm256_loadu_ps( &a->y[ i ] ), _mm256_loadu_ps( &b->y[ i ] ) ) );
+		r = _mm256_add_ps( r, _mm256_mul_ps( _mm256_loadu_ps( &a->z[ i ] ), _mm256_loadu_ps( &b->z[ i ] ) ) );
+		_mm256_storeu_ps( &dst[ i ], r );
+	}
+
+	DotSse2( a, b, dst, i, num );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void BoundsAvx2( const PLVector3SoA *src, size_t i, size_t num, float *mins, float *maxs ) {
+	const float *c[ 3 ] = { src->x, src->y, src->z };
+	size_t end = i + ( ( num - i ) & ~( size_t ) 7 );
+	for ( unsigned int j = 0; j < 3; ++j ) {
+		__m256 lo = _mm256_set1_ps( mins[ j ] ), hi = _mm256_set1_ps( maxs[ j ] );
+		for ( size_t k = i; k < end; k += 8 ) {
+			__m256 v = _mm256_loadu_ps( &c[ j ][ k ] );
+			lo = _mm256_min_ps( v, lo );
+			hi = _mm256_max_ps( v, hi );
+		}
+		__m128 l = _mm_min_ps( _mm256_castps256_ps128( lo ), _mm256_extractf128_ps( lo, 1 ) );
+		__m128 h = _mm_max_ps( _mm256_castps256_ps128( hi ), _mm256_extractf128_ps( hi, 1 ) );
+		l = _mm_min_ps( l, _mm_shuffle_ps( l, l, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		h = _mm_max_ps( h, _mm_shuffle_ps( h, h, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		mins[ j ] = _mm_cvtss_f32( _mm_min_ss( l, _mm_shuffle_ps( l, l, 1 ) ) );
+		maxs[ j ] = _mm_cvtss_f32( _mm_max_ss( h, _mm_shuffle_ps( h, h, 1 ) ) );
+	}
+
+	BoundsSse2( src, end, num, mins, maxs );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void LerpAvx2( const PLVector3SoA *a, const PLVector3SoA *b, float t, const PLVector3SoA *dst, size_t i, size_t num ) {
+	const __m256 tv = _mm256_set1_ps( t );
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256 x = _mm256_loadu_ps( &a->x[ i ] ), y = _mm256_loadu_ps( &a->y[ i ] ), z = _mm256_loadu_ps( &a->z[ i ] );
+		_mm256_storeu_ps( &dst->x[ i ], _mm256_add_ps( x, _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( &b->x[ i ] ), x ), tv ) ) );
+		_mm256_storeu_ps( &dst->y[ i ], _mm256_add_ps( y, _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( &b->y[ i ] ), y ), tv ) ) );
+		_mm256_storeu_ps( &dst->z[ i ], _mm256_add_ps( z, _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( &b->z[ i ] ), z ), tv ) ) );
+	}
+
+	LerpSse2( a, b, t, dst, i, num );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void SlerpAvx2( const PLQuaternionSoA *a, const PLQuaternionSoA *b, const float *ca, const float *cb, float t, const PLQuaternionSoA *dst, size_t i, size_t num ) {
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	const __m256 sign = _mm256_set1_ps( -0.0f );
+	const __m256 ta = _mm256_set1_ps( 1.0f - t ), tb = _mm256_set1_ps( t );
+	__m256 va[ PL_SLERP_TERMS ], vb[ PL_SLERP_TERMS ];
+	for ( unsigned int j = 0; j < PL_SLERP_TERMS; ++j ) {
+		va[ j ] = _mm256_set1_ps( ca[ j ] );
+		vb[ j ] = _mm256_set1_ps( cb[ j ] );
+	}
+
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256 ax = _mm256_loadu_ps( &a->x[ i ] ), ay = _mm256_loadu_ps( &a->y[ i ] ), az = _mm256_loadu_ps( &a->z[ i ] ), aw = _mm256_loadu_ps( &a->w[ i ] );
+		__m256 bx = _mm256_loadu_ps( &b->x[ i ] ), by = _mm256_loadu_ps( &b->y[ i ] ), bz = _mm256_loadu_ps( &b->z[ i ] ), bw = _mm256_loadu_ps( &b->w[ i ] );
+		__m256 d = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ax, bx ), _mm256_mul_ps( ay, by ) ), _mm256_mul_ps( az, bz ) ), _mm256_mul_ps( aw, bw ) );
+		__m256 flip = _mm256_and_ps( d, sign );
+		__m256 cosm1 = _mm256_sub_ps( _mm256_xor_ps( d, flip ), one );
+		__m256 fa = one, fb = one;
+		for ( int j = PL_SLERP_TERMS - 1; j >= 0; --j ) {
+			fa = _mm256_add_ps( one, _mm256_mul_ps( _mm256_mul_ps( va[ j ], cosm1 ), fa ) );
+			fb = _mm256_add_ps( one, _mm256_mul_ps( _mm256_mul_ps( vb[ j ], cosm1 ), fb ) );
+		}
+		__m256 wa = _mm256_mul_ps( ta, fa );
+		__m256 wb = _mm256_xor_ps( _mm256_mul_ps( tb, fb ), flip );
+		_mm256_storeu_ps( &dst->x[ i ], _mm256_add_ps( _mm256_mul_ps( wa, ax ), _mm256_mul_ps( wb, bx ) ) );
+		_mm256_storeu_ps( &dst->y[ i ], _mm256_add_ps( _mm256_mul_ps( wa, ay ), _mm256_mul_ps( wb, by ) ) );
+		_mm256_storeu_ps( &dst->z[ i ], _mm256_add_ps( _mm256_mul_ps( wa, az ), _mm256_mul_ps( wb, bz ) ) );
+		_mm256_storeu_ps( &dst->w[ i ], _mm256_add_ps( _mm256_mul_ps( wa, aw ), _mm256_mul_ps( wb, bw ) ) );
+	}
+
+	SlerpSse2( a, b, ca, cb, t, dst, i, num );
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const TransformKernel transformKernels[] = { TransformScalar, SSE2_KERNEL( TransformSse2 ), AVX2_KERNEL( TransformAvx2 ) };
+static const NormalizeKernel normalizeKernels[] = { NormalizeScalar, SSE2_KERNEL( NormalizeSse2 ), AVX2_KERNEL( NormalizeAvx2 ) };
+static const DotKernel dotKernels[] = { DotScalar, SSE2_KERNEL( DotSse2 ), AVX2_KERNEL( DotAvx2 ) };
+static const BoundsKernel boundsKernels[] = { BoundsScalar, SSE2_KERNEL( BoundsSse2 ), AVX2_KERNEL( BoundsAvx2 ) };
+static const LerpKernel lerpKernels[] = { LerpScalar, SSE2_KERNEL( LerpSse2 ), AVX2_KERNEL( LerpAvx2 ) };
+static const SlerpKernel slerpKernels[] = { SlerpScalar, SSE2_KERNEL( SlerpSse2 ), AVX2_KERNEL( SlerpAvx2 ) };
+
+/**
+ * Transforms each point by m, i.e. with an implied w of 1.
+ */
+void PlTransformPoints3( const PLMatrix4 *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t num ) {
+	PL_SELECT_SIMD_KERNEL( transformKernels, PlGetSimdLevel() )( m->m, src, dst, 0, num, true );
+}
+
+/**
+ * Transforms each direction by m, ignoring any translation.
+ */
+void PlTransformDirections3( const PLMatrix4 *m, const PLVector3SoA *src, const PLVector3SoA *dst, size_t num ) {
+	PL_SELECT_SIMD_KERNEL( transformKernels, PlGetSimdLevel() )( m->m, src, dst, 0, num, false );
+}
+
+/**
+ * Normalizes each vector; any of zero length are left as they are.
+ */
+void PlNormalizeVectors3( const PLVector3SoA *src, const PLVector3SoA *dst, size_t num ) {
+	PL_SELECT_SIMD_KERNEL( normalizeKernels, PlGetSimdLevel() )( src, dst, 0, num );
+}
+
+/**
+ * Writes the dot product of each pair of vectors into dst.
+ */
+void PlVector3DotProducts( const PLVector3SoA *a, const PLVector3SoA *b, float *dst, size_t num ) {
+	PL_SELECT_SIMD_KERNEL( dotKernels, PlGetSimdLevel() )( a, b, dst, 0, num );
+}
+
+/**
+ * Fetches the smallest and largest of each component. If there's nothing
+ * to go through, mins is left at FLT_MAX and maxs at -FLT_MAX.
+ */
+void PlGetVector3Bounds( const PLVector3SoA *src, size_t num, PLVector3 *mins, PLVector3 *maxs ) {
+	float lo[ 3 ] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float hi[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	PL_SELECT_SIMD_KERNEL( boundsKernels, PlGetSimdLevel() )( src, 0, num, lo, hi );
+	*mins = PLVector3( lo[ 0 ], lo[ 1 ], lo[ 2 ] );
+	*maxs = PLVector3( hi[ 0 ], hi[ 1 ], hi[ 2 ] );
+}
+
+/**
+ * Linearly interpolates from each vector in a towards its pair in b.
+ */
+void PlLerpVectors3( const PLVector3SoA *a, const PLVector3SoA *b, float t, const PLVector3SoA *dst, size_t num ) {
+	PL_SELECT_SIMD_KERNEL( lerpKernels, PlGetSimdLevel() )( a, b, t, dst, 0, num );
+}
+
+/**
+ * Spherically interpolates from each quaternion in a towards its pair in b,
+ * giving the same results as PlSlerpQuaternion.
+ */
+void PlSlerpQuaternions( const PLQuaternionSoA *a, const PLQuaternionSoA *b, float t, const PLQuaternionSoA *dst, size_t num ) {
+	float ca[ PL_SLERP_TERMS ], cb[ PL_SLERP_TERMS ];
+	_plGetSlerpCoefficients( 1.0f - t, ca );
+	_plGetSlerpCoefficients( t, cb );
+	PL_SELECT_SIMD_KERNEL( slerpKernels, PlGetSimdLevel() )( a, b, ca, cb, t, dst, 0, num );
+}
@@ -11,85 +11,212 @@
 /* Matrix Stack, sorta mirrors OpenGL behaviour */
 
 #define MAX_STACK_SIZE 64
-static PLMatrix4 stacks[ PL_NUM_MATRIX_MODES ][ MAX_STACK_SIZE ];
-static PLMatrixMode curMatrixMode = PL_MODELVIEW_MATRIX;
-static unsigned int curStackSlot[ PL_NUM_MATRIX_MODES ];
+
+#define MODE_BIT( MODE ) ( 1U << ( MODE ) )
+#define MVP_MODES        ( MODE_BIT( PL_MODELVIEW_MATRIX ) | MODE_BIT( PL_PROJECTION_MATRIX ) )
+
+typedef struct PLMatrixStack {
+	PLMatrix4 stacks[ PL_NUM_MATRIX_MODES ][ MAX_STACK_SIZE ];
+	unsigned int slots[ PL_NUM_MATRIX_MODES ];
+	PLMatrixMode mode;
+
+	/* combined projection and modelview, only rebuilt when asked for and
+	 * one of the two has changed since */
+	PLMatrix4 mvp;
+	unsigned int dirty; /* MODE_BIT of each mode changed since */
+} PLMatrixStack;
+
+#define IDENTITY_MATRIX4 { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } }
+
+/* set up statically rather than on first use, so there's no
+ * initialisation for threads to race over */
+static PLMatrixStack defaultStack = {
+        .stacks = {
+                [PL_MODELVIEW_MATRIX] = { IDENTITY_MATRIX4 },
+                [PL_PROJECTION_MATRIX] = { IDENTITY_MATRIX4 },
+                [PL_TEXTURE_MATRIX] = { IDENTITY_MATRIX4 },
+        },
+        .mode = PL_MODELVIEW_MATRIX,
+        .dirty = MVP_MODES,
+};
+
+static void ResetMatrixStack( PLMatrixStack *stack ) {
+	memset( stack->slots, 0, sizeof( stack->slots ) );
+	stack->mode = PL_MODELVIEW_MATRIX;
+
+	/* every stack starts off with identity matrix for first slot */
+	for ( unsigned int i = 0; i < PL_NUM_MATRIX_MODES; ++i ) {
+		stack->stacks[ i ][ 0 ] = PlMatrix4Identity();
+	}
+
+	stack->dirty = MVP_MODES;
+}
+
+static PLMatrix4 *GetStackTop( PLMatrixStack *stack, PLMatrixMode mode ) {
+	return &stack->stacks[ mode ][ stack->slots[ mode ] ];
+}
+
+PLMatrixStack *PlCreateMatrixStack( void ) {
+	PLMatrixStack *stack = pl_malloc( sizeof( PLMatrixStack ) );
+	if ( stack == NULL ) {
+		return NULL;
+	}
+
+	ResetMatrixStack( stack );
+	return stack;
+}
+
+void PlDestroyMatrixStack( PLMatrixStack *stack ) {
+	if ( stack == NULL || stack == PlGetDefaultMatrixStack() ) {
+		return;
+	}
+
+	pl_free( stack );
+}
 
 /**
- * Returns a pointer to the current matrix stack.
+ * Returns the stack used by the functions that don't take one.
  */
-PLMatrix4 *PlGetMatrix( PLMatrixMode mode ) {
-	return &stacks[ mode ][ curStackSlot[ mode ] ];
+PLMatrixStack *PlGetDefaultMatrixStack( void ) {
+	return &defaultStack;
+}
+
+void PlSetStackMatrixMode( PLMatrixStack *stack, PLMatrixMode mode ) {
+	stack->mode = mode;
+}
+
+PLMatrixMode PlGetStackMatrixMode( const PLMatrixStack *stack ) {
+	return stack->mode;
 }
 
 /**
- * Private function that initializes all of the matrix stacks.
+ * Returns the matrix at the top of the given mode's stack.
  */
-void _plInitializeMatrixStacks( void ) {
-	/* make sure all of the slots default to 0 */
-	memset( curStackSlot, 0, sizeof( unsigned int ) * PL_NUM_MATRIX_MODES );
+const PLMatrix4 *PlGetStackMatrix( const PLMatrixStack *stack, PLMatrixMode mode ) {
+	return &stack->stacks[ mode ][ stack->slots[ mode ] ];
+}
 
-	/* every stack starts off with identity matrix for first slot */
-	for ( unsigned int i = 0; i < PL_NUM_MATRIX_MODES; ++i ) {
-		stacks[ i ][ 0 ] = PlMatrix4Identity();
+/**
+ * Returns projection * modelview, recalculating it only if either has
+ * changed since it was last asked for.
+ */
+const PLMatrix4 *PlGetStackModelViewProjection( PLMatrixStack *stack ) {
+	if ( stack->dirty & MVP_MODES ) {
+		stack->mvp = PlMultiplyMatrix4( *GetStackTop( stack, PL_PROJECTION_MATRIX ), *GetStackTop( stack, PL_MODELVIEW_MATRIX ) );
+		stack->dirty &= ~MVP_MODES;
 	}
+
+	return &stack->mvp;
 }
 
+void PlLoadStackMatrix( PLMatrixStack *stack, const PLMatrix4 *matrix ) {
+	*GetStackTop( stack, stack->mode ) = *matrix;
+	stack->dirty |= MODE_BIT( stack->mode );
+}
+
+void PlLoadStackIdentityMatrix( PLMatrixStack *stack ) {
+	PLMatrix4 identity = PlMatrix4Identity();
+	PlLoadStackMatrix( stack, &identity );
+}
+
+void PlMultiStackMatrix( PLMatrixStack *stack, const PLMatrix4 *matrix ) {
+	PLMatrix4 *top = GetStackTop( stack, stack->mode );
+	*top = PlMultiplyMatrix4( *top, *matrix );
+	stack->dirty |= MODE_BIT( stack->mode );
+}
+
+void PlRotateStackMatrix( PLMatrixStack *stack, float angle, float x, float y, float z ) {
+	PLMatrix4 rotation = PlRotateMatrix4( angle, PLVector3( x, y, z ) );
+	PlMultiStackMatrix( stack, &rotation );
+}
+
+void PlTranslateStackMatrix( PLMatrixStack *stack, PLVector3 vector ) {
+	PLMatrix4 translate = PlTranslateMatrix4( vector );
+	PlMultiStackMatrix( stack, &translate );
+}
+
+void PlScaleStackMatrix( PLMatrixStack *stack, PLVector3 scale ) {
+	PLMatrix4 *top = GetStackTop( stack, stack->mode );
+	*top = PlScaleMatrix4( *top, scale );
+	stack->dirty |= MODE_BIT( stack->mode );
+}
+
+void PlPushStackMatrix( PLMatrixStack *stack ) {
+	if ( stack->slots[ stack->mode ] + 1 >= MAX_STACK_SIZE ) {
+		PlReportBasicError( PL_RESULT_MEMORY_EOA );
+		return;
+	}
+
+	/* the top is copied up, so nothing has changed as far as the mvp goes */
+	PLMatrix4 *top = GetStackTop( stack, stack->mode );
+	stack->slots[ stack->mode ]++;
+	*GetStackTop( stack, stack->mode ) = *top;
+}
+
+void PlPopStackMatrix( PLMatrixStack *stack ) {
+	if ( stack->slots[ stack->mode ] == 0 ) {
+		PlReportBasicError( PL_RESULT_MEMORY_UNDERFLOW );
+		return;
+	}
+
+	stack->slots[ stack->mode ]--;
+	stack->dirty |= MODE_BIT( stack->mode );
+}
+
+/****************************************
+ * Default stack
+ ****************************************/
+
 void PlMatrixMode( PLMatrixMode mode ) {
-	curMatrixMode = mode;
+	PlSetStackMatrixMode( PlGetDefaultMatrixStack(), mode );
 }
 
 PLMatrixMode PlGetMatrixMode( void ) {
-	return curMatrixMode;
+	return PlGetStackMatrixMode( PlGetDefaultMatrixStack() );
+}
+
+/**
+ * Returns a pointer to the top of the given mode's stack. As it may be
+ * written through, the mode is treated as having changed.
+ */
+PLMatrix4 *PlGetMatrix( PLMatrixMode mode ) {
+	PLMatrixStack *stack = PlGetDefaultMatrixStack();
+	stack->dirty |= MODE_BIT( mode );
+	return GetStackTop( stack, mode );
+}
+
+const PLMatrix4 *PlGetModelViewProjectionMatrix( void ) {
+	return PlGetStackModelViewProjection( PlGetDefaultMatrixStack() );
 }
 
 void PlLoadMatrix( const PLMatrix4 *matrix ) {
-	PLMatrix4 *curStack = PlGetMatrix( curMatrixMode );
-	*curStack = *matrix;
+	PlLoadStackMatrix( PlGetDefaultMatrixStack(), matrix );
 }
 
 void PlLoadIdentityMatrix( void ) {
-	PLMatrix4 identity = PlMatrix4Identity();
-	PlLoadMatrix( &identity );
+	PlLoadStackIdentityMatrix( PlGetDefaultMatrixStack() );
 }
 
 void PlMultiMatrix( const PLMatrix4 *matrix ) {
-	PLMatrix4 *curStack = PlGetMatrix( curMatrixMode );
-	*curStack = PlMultiplyMatrix4( *curStack, *matrix );
+	PlMultiStackMatrix( PlGetDefaultMatrixStack(), matrix );
 }
 
 void PlRotateMatrix( float angle, float x, float y, float z ) {
-	PLMatrix4 rotation = PlRotateMatrix4( angle, PLVector3( x, y, z ) );
-	PlMultiMatrix( &rotation );
+	PlRotateStackMatrix( PlGetDefaultMatrixStack(), angle, x, y, z );
 }
 
 void PlTranslateMatrix( PLVector3 vector ) {
-	PLMatrix4 translate = PlTranslateMatrix4( vector );
-	PlMultiMatrix( &translate );
+	PlTranslateStackMatrix( PlGetDefaultMatrixStack(), vector );
 }
 
 void PlScaleMatrix( PLVector3 scale ) {
-	PLMatrix4 *curStack = PlGetMatrix( curMatrixMode );
-	*curStack = PlScaleMatrix4( *curStack, scale );
+	PlScaleStackMatrix( PlGetDefaultMatrixStack(), scale );
 }
 
 void PlPushMatrix( void ) {
-	if ( curStackSlot[ curMatrixMode ] >= MAX_STACK_SIZE ) {
-		PlReportBasicError( PL_RESULT_MEMORY_EOA );
-		return;
-	}
-
-	PLMatrix4 *curStack = PlGetMatrix( curMatrixMode );
-	curStackSlot[ curMatrixMode ]++;
-	PLMatrix4 *newStack = PlGetMatrix( curMatrixMode );
-	*newStack = *curStack;
+	PlPushStackMatrix( PlGetDefaultMatrixStack() );
 }
 
 void PlPopMatrix( void ) {
-	if ( curStackSlot[ curMatrixMode ] == 0 ) {
-		PlReportBasicError( PL_RESULT_MEMORY_UNDERFLOW );
-		return;
-	}
-
-	curStackSlot[ curMatrixMode ]--;
+	PlPopStackMatrix( PlGetDefaultMatrixStack() );
 }
@@ -0,0 +1,740 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_math.h>
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* xoshiro256**, by David Blackman and Sebastiano Vigna; see
+ * https://prng.di.unimi.it/ */
+
+static uint64_t Rotl64( uint64_t x, int k ) {
+	return ( x << k ) | ( x >> ( 64 - k ) );
+}
+
+static uint64_t SplitMix64( uint64_t *x ) {
+	uint64_t z = ( *x += 0x9e3779b97f4a7c15ULL );
+	z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+	z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+	return z ^ ( z >> 31 );
+}
+
+/**
+ * Any seed is fine, including zero; it's expanded with splitmix64 so
+ * that similar seeds still produce unrelated sequences.
+ */
+void PlSeedRandom( PLRandom *rng, uint64_t seed ) {
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		rng->s[ i ] = SplitMix64( &seed );
+	}
+}
+
+static PL_THREAD_LOCAL PLRandom threadRandom;
+static PL_THREAD_LOCAL bool threadRandomSeeded = false;
+
+/**
+ * Returns the calling thread's generator, seeded from the time on first use.
+ */
+PLRandom *PlGetThreadRandom( void ) {
+	if ( !threadRandomSeeded ) {
+		/* the address differs between threads started at the same moment */
+		PlSeedRandom( &threadRandom, PlGetMonotonicTime() ^ ( ( uint64_t ) time( NULL ) << 32 ) ^ ( uint64_t ) ( uintptr_t ) &threadRandom );
+		threadRandomSeeded = true;
+	}
+
+	return &threadRandom;
+}
+
+uint64_t PlRandomUInt64( PLRandom *rng ) {
+	uint64_t *s = rng->s;
+	uint64_t result = Rotl64( s[ 1 ] * 5, 7 ) * 9;
+	uint64_t t = s[ 1 ] << 17;
+	s[ 2 ] ^= s[ 0 ];
+	s[ 3 ] ^= s[ 1 ];
+	s[ 1 ] ^= s[ 2 ];
+	s[ 0 ] ^= s[ 3 ];
+	s[ 2 ] ^= t;
+	s[ 3 ] = Rotl64( s[ 3 ], 45 );
+	return result;
+}
+
+uint32_t PlRandomUInt32( PLRandom *rng ) {
+	return ( uint32_t ) ( PlRandomUInt64( rng ) >> 32 );
+}
+
+/**
+ * Returns a value from 0 up to, but not including, bound, without the
+ * bias of taking the remainder (Lemire's method).
+ */
+uint32_t PlRandomBoundedUInt32( PLRandom *rng, uint32_t bound ) {
+	uint64_t m = ( uint64_t ) PlRandomUInt32( rng ) * bound;
+	if ( ( uint32_t ) m < bound ) {
+		uint32_t threshold = ( uint32_t ) -bound % bound;
+		while ( ( uint32_t ) m < threshold ) {
+			m = ( uint64_t ) PlRandomUInt32( rng ) * bound;
+		}
+	}
+
+	return ( uint32_t ) ( m >> 32 );
+}
+
+/**
+ * Returns a value from 0 up to, but not including, 1.
+ */
+float PlRandomFloat( PLRandom *rng ) {
+	return ( float ) ( PlRandomUInt64( rng ) >> 40 ) * ( 1.0f / 16777216.0f );
+}
+
+/**
+ * Returns a value from 0 up to, but not including, 1.
+ */
+double PlRandomDouble( PLRandom *rng ) {
+	return ( double ) ( PlRandomUInt64( rng ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+float PlRandomFloatRange( PLRandom *rng, float min, float max ) {
+	return min + PlRandomFloat( rng ) * ( max - min );
+}
+
+/****************************************
+ * Distributions
+ ****************************************/
+
+/* The distributions each turn one 64-bit output into a pair of values, using
+ * the low 32 bits for one and the high 32 bits for the other. The logarithm
+ * and sine/cosine are cephes' single precision polynomials, evaluated in the
+ * same order by every kernel so the results match at every level. Angles
+ * come from the top two bits picking a quadrant, and the next 22 giving an
+ * offset within it, so no range reduction is needed. */
+
+#define UNIT_23 ( 1.0f / 8388608.0f )
+#define UNIT_24 ( 1.0f / 16777216.0f )
+
+#define LOG_SQRTHF 0.707106781186547524f
+#define LOG_P0     7.0376836292E-2f
+#define LOG_P1     -1.1514610310E-1f
+#define LOG_P2     1.1676998740E-1f
+#define LOG_P3     -1.2420140846E-1f
+#define LOG_P4     1.4249322787E-1f
+#define LOG_P5     -1.6668057665E-1f
+#define LOG_P6     2.0000714765E-1f
+#define LOG_P7     -2.4999993993E-1f
+#define LOG_P8     3.3333331174E-1f
+#define LOG_Q1     -2.12194440E-4f
+#define LOG_Q2     0.693359375f
+
+#define SIN_P0 -1.9515295891E-4f
+#define SIN_P1 8.3321608736E-3f
+#define SIN_P2 -1.6666654611E-1f
+#define COS_P0 2.443315711809948E-5f
+#define COS_P1 -1.388731625493765E-3f
+#define COS_P2 4.166664568298827E-2f
+
+#define ANGLE_MASK  0x3fffff
+#define ANGLE_SCALE ( PL_PI / 2.0f / 4194304.0f )
+#define ANGLE_BIAS  ( -PL_PI / 4.0f )
+
+/* natural logarithm, for 0 < u <= 1 */
+static float LogScalar( float u ) {
+	uint32_t bits;
+	memcpy( &bits, &u, sizeof( bits ) );
+	float e = ( float ) ( ( int32_t ) ( bits >> 23 ) - 126 );
+	bits = ( bits & 0x7fffff ) | 0x3f000000;
+
+	float m;
+	memcpy( &m, &bits, sizeof( m ) );
+	float x = m - 1.0f;
+	if ( m < LOG_SQRTHF ) {
+		e = e - 1.0f;
+		x = x + m;
+	}
+
+	float z = x * x;
+	float y = LOG_P0 * x + LOG_P1;
+	y = y * x + LOG_P2;
+	y = y * x + LOG_P3;
+	y = y * x + LOG_P4;
+	y = y * x + LOG_P5;
+	y = y * x + LOG_P6;
+	y = y * x + LOG_P7;
+	y = y * x + LOG_P8;
+	y = y * x;
+	y = y * z;
+	y = y + e * LOG_Q1;
+	y = y - z * 0.5f;
+	x = x + y;
+	return x + e * LOG_Q2;
+}
+
+/* cosine and sine of a uniformly distributed angle, taken from bits */
+static void GetAngleScalar( uint32_t bits, float *c, float *s ) {
+	float x = ( float ) ( ( bits >> 8 ) & ANGLE_MASK ) * ANGLE_SCALE + ANGLE_BIAS;
+	float z = x * x;
+
+	float ys = SIN_P0 * z + SIN_P1;
+	ys = ys * z + SIN_P2;
+	ys = ys * z;
+	ys = ys * x;
+	ys = ys + x;
+
+	float yc = COS_P0 * z + COS_P1;
+	yc = yc * z + COS_P2;
+	yc = yc * z;
+	yc = yc * z;
+	yc = yc - z * 0.5f;
+	yc = yc + 1.0f;
+
+	/* rotate into the quadrant */
+	bool swap = ( bits & 0x40000000 ) != 0;
+	*c = swap ? ys : yc;
+	*s = swap ? yc : ys;
+	if ( ( bits ^ ( bits << 1 ) ) & 0x80000000 ) {
+		*c = -*c;
+	}
+	if ( bits & 0x80000000 ) {
+		*s = -*s;
+	}
+}
+
+static void GetNormalPairScalar( uint64_t bits, float mean, float deviation, float *z0, float *z1 ) {
+	float u = ( float ) ( ( ( uint32_t ) bits >> 8 ) + 1 ) * UNIT_24;
+	float r = sqrtf( LogScalar( u ) * -2.0f );
+	float c, s;
+	GetAngleScalar( ( uint32_t ) ( bits >> 32 ), &c, &s );
+	*z0 = ( r * c ) * deviation + mean;
+	*z1 = ( r * s ) * deviation + mean;
+}
+
+static void GetSpherePointScalar( uint64_t bits, float *x, float *y, float *z ) {
+	*z = ( float ) ( ( uint32_t ) bits >> 8 ) * UNIT_23 - 1.0f;
+	float r = sqrtf( 1.0f - *z * *z );
+	float c, s;
+	GetAngleScalar( ( uint32_t ) ( bits >> 32 ), &c, &s );
+	*x = r * c;
+	*y = r * s;
+}
+
+/**
+ * Returns a normally distributed value (Box-Muller).
+ */
+float PlRandomNormal( PLRandom *rng, float mean, float deviation ) {
+	float z0, z1;
+	GetNormalPairScalar( PlRandomUInt64( rng ), mean, deviation, &z0, &z1 );
+	return z0;
+}
+
+/**
+ * Returns a point uniformly distributed over the surface of the unit sphere.
+ */
+PLVector3 PlRandomOnSphere( PLRandom *rng ) {
+	PLVector3 v;
+	GetSpherePointScalar( PlRandomUInt64( rng ), &v.x, &v.y, &v.z );
+	return v;
+}
+
+/****************************************
+ * Bulk fills
+ ****************************************/
+
+/* The fills run four generators side by side, seeded from the one they're
+ * handed, so they can be stepped together in vector registers. Each step of
+ * the four gives eight 32-bit values in lane order, or four sphere points.
+ * The kernels only ever hand over at the end of a step, storing the lanes
+ * back for the level below to carry on from. */
+
+#define NUM_LANES 4
+
+typedef struct RandomLanes {
+	uint64_t s[ 4 ][ NUM_LANES ]; /* word, then lane */
+} RandomLanes;
+
+static void SeedLanes( PLRandom *rng, RandomLanes *lanes ) {
+	uint64_t seed = PlRandomUInt64( rng );
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		for ( unsigned int j = 0; j < NUM_LANES; ++j ) {
+			lanes->s[ i ][ j ] = SplitMix64( &seed );
+		}
+	}
+}
+
+static void StepLanesScalar( RandomLanes *lanes, uint64_t *out ) {
+	for ( unsigned int j = 0; j < NUM_LANES; ++j ) {
+		PLRandom lane = { { lanes->s[ 0 ][ j ], lanes->s[ 1 ][ j ], lanes->s[ 2 ][ j ], lanes->s[ 3 ][ j ] } };
+		out[ j ] = PlRandomUInt64( &lane );
+		for ( unsigned int i = 0; i < 4; ++i ) {
+			lanes->s[ i ][ j ] = lane.s[ i ];
+		}
+	}
+}
+
+typedef void ( *UInt32Kernel )( RandomLanes *lanes, uint32_t *dst, size_t i, size_t num );
+typedef void ( *UniformKernel )( RandomLanes *lanes, float *dst, size_t i, size_t num, float scale, float offset );
+typedef void ( *NormalKernel )( RandomLanes *lanes, float *dst, size_t i, size_t num, float mean, float deviation );
+typedef void ( *SphereKernel )( RandomLanes *lanes, const PLVector3SoA *dst, size_t i, size_t num );
+
+static void UInt32Scalar( RandomLanes *lanes, uint32_t *dst, size_t i, size_t num ) {
+	while ( i < num ) {
+		uint64_t out[ NUM_LANES ];
+		StepLanesScalar( lanes, out );
+		for ( unsigned int j = 0; j < NUM_LANES * 2 && i < num; ++j, ++i ) {
+			dst[ i ] = ( uint32_t ) ( out[ j / 2 ] >> ( ( j & 1 ) * 32 ) );
+		}
+	}
+}
+
+/* scale has already had 2^-24 folded in */
+static void UniformScalar( RandomLanes *lanes, float *dst, size_t i, size_t num, float scale, float offset ) {
+	while ( i < num ) {
+		uint64_t out[ NUM_LANES ];
+		StepLanesScalar( lanes, out );
+		for ( unsigned int j = 0; j < NUM_LANES * 2 && i < num; ++j, ++i ) {
+			uint32_t bits = ( uint32_t ) ( out[ j / 2 ] >> ( ( j & 1 ) * 32 ) );
+			dst[ i ] = ( float ) ( bits >> 8 ) * scale + offset;
+		}
+	}
+}
+
+static void NormalScalar( RandomLanes *lanes, float *dst, size_t i, size_t num, float mean, float deviation ) {
+	while ( i < num ) {
+		uint64_t out[ NUM_LANES ];
+		StepLanesScalar( lanes, out );
+		for ( unsigned int j = 0; j < NUM_LANES && i < num; ++j ) {
+			float z[ 2 ];
+			GetNormalPairScalar( out[ j ], mean, deviation, &z[ 0 ], &z[ 1 ] );
+			for ( unsigned int k = 0; k < 2 && i < num; ++k, ++i ) {
+				dst[ i ] = z[ k ];
+			}
+		}
+	}
+}
+
+static void SphereScalar( RandomLanes *lanes, const PLVector3SoA *dst, size_t i, size_t num ) {
+	while ( i < num ) {
+		uint64_t out[ NUM_LANES ];
+		StepLanesScalar( lanes, out );
+		for ( unsigned int j = 0; j < NUM_LANES && i < num; ++j, ++i ) {
+			GetSpherePointScalar( out[ j ], &dst->x[ i ], &dst->y[ i ], &dst->z[ i ] );
+		}
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+#	define ROTL_SSE2( X, K ) _mm_or_si128( _mm_slli_epi64( ( X ), ( K ) ), _mm_srli_epi64( ( X ), 64 - ( K ) ) )
+#	define ROTL_AVX2( X, K ) _mm256_or_si256( _mm256_slli_epi64( ( X ), ( K ) ), _mm256_srli_epi64( ( X ), 64 - ( K ) ) )
+
+/* two lanes per register, so a and b hold lanes 0-1 and 2-3 */
+typedef struct LanesSse2 {
+	__m128i a[ 4 ], b[ 4 ];
+} LanesSse2;
+
+PL_TARGET_ISA( "sse2" )
+static void LoadLanesSse2( const RandomLanes *lanes, LanesSse2 *v ) {
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		v->a[ i ] = _mm_loadu_si128( ( const __m128i * ) &lanes->s[ i ][ 0 ] );
+		v->b[ i ] = _mm_loadu_si128( ( const __m128i * ) &lanes->s[ i ][ 2 ] );
+	}
+}
+
+PL_TARGET_ISA( "sse2" )
+static void StoreLanesSse2( RandomLanes *lanes, const LanesSse2 *v ) {
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		_mm_storeu_si128( ( __m128i * ) &lanes->s[ i ][ 0 ], v->a[ i ] );
+		_mm_storeu_si128( ( __m128i * ) &lanes->s[ i ][ 2 ], v->b[ i ] );
+	}
+}
+
+/* there's no 64-bit multiply, but the ones needed are 5 and 9 */
+PL_TARGET_ISA( "sse2" )
+static __m128i StepSse2( __m128i *s ) {
+	__m128i r = _mm_add_epi64( _mm_slli_epi64( s[ 1 ], 2 ), s[ 1 ] );
+	r = ROTL_SSE2( r, 7 );
+	r = _mm_add_epi64( _mm_slli_epi64( r, 3 ), r );
+
+	__m128i t = _mm_slli_epi64( s[ 1 ], 17 );
+	s[ 2 ] = _mm_xor_si128( s[ 2 ], s[ 0 ] );
+	s[ 3 ] = _mm_xor_si128( s[ 3 ], s[ 1 ] );
+	s[ 1 ] = _mm_xor_si128( s[ 1 ], s[ 2 ] );
+	s[ 0 ] = _mm_xor_si128( s[ 0 ], s[ 3 ] );
+	s[ 2 ] = _mm_xor_si128( s[ 2 ], t );
+	s[ 3 ] = ROTL_SSE2( s[ 3 ], 45 );
+	return r;
+}
+
+PL_TARGET_ISA( "sse2" )
+static __m128 LogSse2( __m128 u ) {
+	const __m128 one = _mm_set1_ps( 1.0f );
+	__m128i bits = _mm_castps_si128( u );
+	__m128 e = _mm_cvtepi32_ps( _mm_sub_epi32( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 126 ) ) );
+	__m128 m = _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( bits, _mm_set1_epi32( 0x7fffff ) ), _mm_set1_epi32( 0x3f000000 ) ) );
+
+	__m128 mask = _mm_cmplt_ps( m, _mm_set1_ps( LOG_SQRTHF ) );
+	e = _mm_sub_ps( e, _mm_and_ps( one, mask ) );
+	__m128 x = _mm_add_ps( _mm_sub_ps( m, one ), _mm_and_ps( m, mask ) );
+
+	__m128 z = _mm_mul_ps( x, x );
+	__m128 y = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( LOG_P0 ), x ), _mm_set1_ps( LOG_P1 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P2 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P3 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P4 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P5 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P6 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P7 ) );
+	y = _mm_add_ps( _mm_mul_ps( y, x ), _mm_set1_ps( LOG_P8 ) );
+	y = _mm_mul_ps( y, x );
+	y = _mm_mul_ps( y, z );
+	y = _mm_add_ps( y, _mm_mul_ps( e, _mm_set1_ps( LOG_Q1 ) ) );
+	y = _mm_sub_ps( y, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+	x = _mm_add_ps( x, y );
+	return _mm_add_ps( x, _mm_mul_ps( e, _mm_set1_ps( LOG_Q2 ) ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void GetAngleSse2( __m128i bits, __m128 *c, __m128 *s ) {
+	__m128 x = _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( bits, 8 ), _mm_set1_epi32( ANGLE_MASK ) ) );
+	x = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( ANGLE_SCALE ) ), _mm_set1_ps( ANGLE_BIAS ) );
+	__m128 z = _mm_mul_ps( x, x );
+
+	__m128 ys = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( SIN_P0 ), z ), _mm_set1_ps( SIN_P1 ) );
+	ys = _mm_add_ps( _mm_mul_ps( ys, z ), _mm_set1_ps( SIN_P2 ) );
+	ys = _mm_mul_ps( ys, z );
+	ys = _mm_mul_ps( ys, x );
+	ys = _mm_add_ps( ys, x );
+
+	__m128 yc = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( COS_P0 ), z ), _mm_set1_ps( COS_P1 ) );
+	yc = _mm_add_ps( _mm_mul_ps( yc, z ), _mm_set1_ps( COS_P2 ) );
+	yc = _mm_mul_ps( yc, z );
+	yc = _mm_mul_ps( yc, z );
+	yc = _mm_sub_ps( yc, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+	yc = _mm_add_ps( yc, _mm_set1_ps( 1.0f ) );
+
+	__m128i signBit = _mm_set1_epi32( ( int ) 0x80000000 );
+	__m128 swap = _mm_castsi128_ps( _mm_srai_epi32( _mm_slli_epi32( bits, 1 ), 31 ) );
+	__m128 cSign = _mm_castsi128_ps( _mm_and_si128( _mm_xor_si128( bits, _mm_slli_epi32( bits, 1 ) ), signBit ) );
+	__m128 sSign = _mm_castsi128_ps( _mm_and_si128( bits, signBit ) );
+	*c = _mm_xor_ps( _mm_or_ps( _mm_and_ps( swap, ys ), _mm_andnot_ps( swap, yc ) ), cSign );
+	*s = _mm_xor_ps( _mm_or_ps( _mm_and_ps( swap, yc ), _mm_andnot_ps( swap, ys ) ), sSign );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void UInt32Sse2( RandomLanes *lanes, uint32_t *dst, size_t i, size_t num ) {
+	LanesSse2 v;
+	LoadLanesSse2( lanes, &v );
+	for ( ; i + 8 <= num; i += 8 ) {
+		_mm_storeu_si128( ( __m128i * ) &dst[ i ], StepSse2( v.a ) );
+		_mm_storeu_si128( ( __m128i * ) &dst[ i + 4 ], StepSse2( v.b ) );
+	}
+	StoreLanesSse2( lanes, &v );
+
+	UInt32Scalar( lanes, dst, i, num );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void UniformSse2( RandomLanes *lanes, float *dst, size_t i, size_t num, float scale, float offset ) {
+	const __m128 vs = _mm_set1_ps( scale ), vo = _mm_set1_ps( offset );
+	LanesSse2 v;
+	LoadLanesSse2( lanes, &v );
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m128 a = _mm_cvtepi32_ps( _mm_srli_epi32( StepSse2( v.a ), 8 ) );
+		__m128 b = _mm_cvtepi32_ps( _mm_srli_epi32( StepSse2( v.b ), 8 ) );
+		_mm_storeu_ps( &dst[ i ], _mm_add_ps( _mm_mul_ps( a, vs ), vo ) );
+		_mm_storeu_ps( &dst[ i + 4 ], _mm_add_ps( _mm_mul_ps( b, vs ), vo ) );
+	}
+	StoreLanesSse2( lanes, &v );
+
+	UniformScalar( lanes, dst, i, num, scale, offset );
+}
+
+/* splits a step into the low and high halves of each lane, in lane order */
+PL_TARGET_ISA( "sse2" )
+static void StepHalvesSse2( LanesSse2 *v, __m128i *lo, __m128i *hi ) {
+	__m128 a = _mm_castsi128_ps( StepSse2( v->a ) );
+	__m128 b = _mm_castsi128_ps( StepSse2( v->b ) );
+	*lo = _mm_castps_si128( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+	*hi = _mm_castps_si128( _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void NormalSse2( RandomLanes *lanes, float *dst, size_t i, size_t num, float mean, float deviation ) {
+	const __m128 vm = _mm_set1_ps( mean ), vd = _mm_set1_ps( deviation );
+	LanesSse2 v;
+	LoadLanesSse2( lanes, &v );
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m128i lo, hi;
+		StepHalvesSse2( &v, &lo, &hi );
+
+		__m128 u = _mm_cvtepi32_ps( _mm_add_epi32( _mm_srli_epi32( lo, 8 ), _mm_set1_epi32( 1 ) ) );
+		__m128 r = _mm_sqrt_ps( _mm_mul_ps( LogSse2( _mm_mul_ps( u, _mm_set1_ps( UNIT_24 ) ) ), _mm_set1_ps( -2.0f ) ) );
+		__m128 c, s;
+		GetAngleSse2( hi, &c, &s );
+		__m128 z0 = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( r, c ), vd ), vm );
+		__m128 z1 = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( r, s ), vd ), vm );
+		_mm_storeu_ps( &dst[ i ], _mm_unpacklo_ps( z0, z1 ) );
+		_mm_storeu_ps( &dst[ i + 4 ], _mm_unpackhi_ps( z0, z1 ) );
+	}
+	StoreLanesSse2( lanes, &v );
+
+	NormalScalar( lanes, dst, i, num, mean, deviation );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void SphereSse2( RandomLanes *lanes, const PLVector3SoA *dst, size_t i, size_t num ) {
+	const __m128 one = _mm_set1_ps( 1.0f );
+	LanesSse2 v;
+	LoadLanesSse2( lanes, &v );
+	for ( ; i + 4 <= num; i += 4 ) {
+		__m128i lo, hi;
+		StepHalvesSse2( &v, &lo, &hi );
+
+		__m128 z = _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( lo, 8 ) ), _mm_set1_ps( UNIT_23 ) ), one );
+		__m128 r = _mm_sqrt_ps( _mm_sub_ps( one, _mm_mul_ps( z, z ) ) );
+		__m128 c, s;
+		GetAngleSse2( hi, &c, &s );
+		_mm_storeu_ps( &dst->x[ i ], _mm_mul_ps( r, c ) );
+		_mm_storeu_ps( &dst->y[ i ], _mm_mul_ps( r, s ) );
+		_mm_storeu_ps( &dst->z[ i ], z );
+	}
+	StoreLanesSse2( lanes, &v );
+
+	SphereScalar( lanes, dst, i, num );
+}
+
+PL_TARGET_ISA( "avx2" )
+static __m256i StepAvx2( __m256i *s ) {
+	__m256i r = _mm256_add_epi64( _mm256_slli_epi64( s[ 1 ], 2 ), s[ 1 ] );
+	r = ROTL_AVX2( r, 7 );
+	r = _mm256_add_epi64( _mm256_slli_epi64( r, 3 ), r );
+
+	__m256i t = _mm256_slli_epi64( s[ 1 ], 17 );
+	s[ 2 ] = _mm256_xor_si256( s[ 2 ], s[ 0 ] );
+	s[ 3 ] = _mm256_xor_si256( s[ 3 ], s[ 1 ] );
+	s[ 1 ] = _mm256_xor_si256( s[ 1 ], s[ 2 ] );
+	s[ 0 ] = _mm256_xor_si256( s[ 0 ], s[ 3 ] );
+	s[ 2 ] = _mm256_xor_si256( s[ 2 ], t );
+	s[ 3 ] = ROTL_AVX2( s[ 3 ], 45 );
+	return r;
+}
+
+PL_TARGET_ISA( "avx2" )
+static void LoadLanesAvx2( const RandomLanes *lanes, __m256i *s ) {
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		s[ i ] = _mm256_loadu_si256( ( const __m256i * ) lanes->s[ i ] );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void StoreLanesAvx2( RandomLanes *lanes, const __m256i *s ) {
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		_mm256_storeu_si256( ( __m256i * ) lanes->s[ i ], s[ i ] );
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static __m256 LogAvx2( __m256 u ) {
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	__m256i bits = _mm256_castps_si256( u );
+	__m256 e = _mm256_cvtepi32_ps( _mm256_sub_epi32( _mm256_srli_epi32( bits, 23 ), _mm256_set1_epi32( 126 ) ) );
+	__m256 m = _mm256_castsi256_ps( _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi32( 0x7fffff ) ), _mm256_set1_epi32( 0x3f000000 ) ) );
+
+	__m256 mask = _mm256_cmp_ps( m, _mm256_set1_ps( LOG_SQRTHF ), _CMP_LT_OQ );
+	e = _mm256_sub_ps( e, _mm256_and_ps( one, mask ) );
+	__m256 x = _mm256_add_ps( _mm256_sub_ps( m, one ), _mm256_and_ps( m, mask ) );
+
+	__m256 z = _mm256_mul_ps( x, x );
+	__m256 y = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( LOG_P0 ), x ), _mm256_set1_ps( LOG_P1 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P2 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P3 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P4 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P5 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P6 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P7 ) );
+	y = _mm256_add_ps( _mm256_mul_ps( y, x ), _mm256_set1_ps( LOG_P8 ) );
+	y = _mm256_mul_ps( y, x );
+	y = _mm256_mul_ps( y, z );
+	y = _mm256_add_ps( y, _mm256_mul_ps( e, _mm256_set1_ps( LOG_Q1 ) ) );
+	y = _mm256_sub_ps( y, _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) );
+	x = _mm256_add_ps( x, y );
+	return _mm256_add_ps( x, _mm256_mul_ps( e, _mm256_set1_ps( LOG_Q2 ) ) );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void GetAngleAvx2( __m256i bits, __m256 *c, __m256 *s ) {
+	__m256 x = _mm256_cvtepi32_ps( _mm256_and_si256( _mm256_srli_epi32( bits, 8 ), _mm256_set1_epi32( ANGLE_MASK ) ) );
+	x = _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( ANGLE_SCALE ) ), _mm256_set1_ps( ANGLE_BIAS ) );
+	__m256 z = _mm256_mul_ps( x, x );
+
+	__m256 ys = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( SIN_P0 ), z ), _mm256_set1_ps( SIN_P1 ) );
+	ys = _mm256_add_ps( _mm256_mul_ps( ys, z ), _mm256_set1_ps( SIN_P2 ) );
+	ys = _mm256_mul_ps( ys, z );
+	ys = _mm256_mul_ps( ys, x );
+	ys = _mm256_add_ps( ys, x );
+
+	__m256 yc = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( COS_P0 ), z ), _mm256_set1_ps( COS_P1 ) );
+	yc = _mm256_add_ps( _mm256_mul_ps( yc, z ), _mm256_set1_ps( COS_P2 ) );
+	yc = _mm256_mul_ps( yc, z );
+	yc = _mm256_mul_ps( yc, z );
+	yc = _mm256_sub_ps( yc, _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) );
+	yc = _mm256_add_ps( yc, _mm256_set1_ps( 1.0f ) );
+
+	__m256i signBit = _mm256_set1_epi32( ( int ) 0x80000000 );
+	__m256 swap = _mm256_castsi256_ps( _mm256_srai_epi32( _mm256_slli_epi32( bits, 1 ), 31 ) );
+	__m256 cSign = _mm256_castsi256_ps( _mm256_and_si256( _mm256_xor_si256( bits, _mm256_slli_epi32( bits, 1 ) ), signBit ) );
+	__m256 sSign = _mm256_castsi256_ps( _mm256_and_si256( bits, signBit ) );
+	*c = _mm256_xor_ps( _mm256_blendv_ps( yc, ys, swap ), cSign );
+	*s = _mm256_xor_ps( _mm256_blendv_ps( ys, yc, swap ), sSign );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void UInt32Avx2( RandomLanes *lanes, uint32_t *dst, size_t i, size_t num ) {
+	__m256i s[ 4 ];
+	LoadLanesAvx2( lanes, s );
+	for ( ; i + 8 <= num; i += 8 ) {
+		_mm256_storeu_si256( ( __m256i * ) &dst[ i ], StepAvx2( s ) );
+	}
+	StoreLanesAvx2( lanes, s );
+
+	UInt32Scalar( lanes, dst, i, num );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void UniformAvx2( RandomLanes *lanes, float *dst, size_t i, size_t num, float scale, float offset ) {
+	const __m256 vs = _mm256_set1_ps( scale ), vo = _mm256_set1_ps( offset );
+	__m256i s[ 4 ];
+	LoadLanesAvx2( lanes, s );
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256 a = _mm256_cvtepi32_ps( _mm256_srli_epi32( StepAvx2( s ), 8 ) );
+		_mm256_storeu_ps( &dst[ i ], _mm256_add_ps( _mm256_mul_ps( a, vs ), vo ) );
+	}
+	StoreLanesAvx2( lanes, s );
+
+	UniformScalar( lanes, dst, i, num, scale, offset );
+}
+
+/* two steps at a time, to fill a register; lo and high are then ordered
+ * a0 a1 b0 b1 a2 a3 b2 b3 */
+PL_TARGET_ISA( "avx2" )
+static void StepHalvesAvx2( __m256i *s, __m256i *lo, __m256i *hi ) {
+	__m256 a = _mm256_castsi256_ps( StepAvx2( s ) );
+	__m256 b = _mm256_castsi256_ps( StepAvx2( s ) );
+	*lo = _mm256_castps_si256( _mm256_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+	*hi = _mm256_castps_si256( _mm256_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void NormalAvx2( RandomLanes *lanes, float *dst, size_t i, size_t num, float mean, float deviation ) {
+	const __m256 vm = _mm256_set1_ps( mean ), vd = _mm256_set1_ps( deviation );
+	__m256i s[ 4 ];
+	LoadLanesAvx2( lanes, s );
+	for ( ; i + 16 <= num; i += 16 ) {
+		__m256i lo, hi;
+		StepHalvesAvx2( s, &lo, &hi );
+
+		__m256 u = _mm256_cvtepi32_ps( _mm256_add_epi32( _mm256_srli_epi32( lo, 8 ), _mm256_set1_epi32( 1 ) ) );
+		__m256 r = _mm256_sqrt_ps( _mm256_mul_ps( LogAvx2( _mm256_mul_ps( u, _mm256_set1_ps( UNIT_24 ) ) ), _mm256_set1_ps( -2.0f ) ) );
+		__m256 c, sn;
+		GetAngleAvx2( hi, &c, &sn );
+		__m256 z0 = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( r, c ), vd ), vm );
+		__m256 z1 = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( r, sn ), vd ), vm );
+
+		/* within each half, this puts the pairs back in lane order */
+		_mm256_storeu_ps( &dst[ i ], _mm256_unpacklo_ps( z0, z1 ) );
+		_mm256_storeu_ps( &dst[ i + 8 ], _mm256_unpackhi_ps( z0, z1 ) );
+	}
+	StoreLanesAvx2( lanes, s );
+
+	NormalSse2( lanes, dst, i, num, mean, deviation );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void SphereAvx2( RandomLanes *lanes, const PLVector3SoA *dst, size_t i, size_t num ) {
+	const __m256 one = _mm256_set1_ps( 1.0f );
+	__m256i s[ 4 ];
+	LoadLanesAvx2( lanes, s );
+	for ( ; i + 8 <= num; i += 8 ) {
+		__m256i lo, hi;
+		StepHalvesAvx2( s, &lo, &hi );
+		lo = _mm256_permute4x64_epi64( lo, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		hi = _mm256_permute4x64_epi64( hi, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+		__m256 z = _mm256_sub_ps( _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_srli_epi32( lo, 8 ) ), _mm256_set1_ps( UNIT_23 ) ), one );
+		__m256 r = _mm256_sqrt_ps( _mm256_sub_ps( one, _mm256_mul_ps( z, z ) ) );
+		__m256 c, sn;
+		GetAngleAvx2( hi, &c, &sn );
+		_mm256_storeu_ps( &dst->x[ i ], _mm256_mul_ps( r, c ) );
+		_mm256_storeu_ps( &dst->y[ i ], _mm256_mul_ps( r, sn ) );
+		_mm256_storeu_ps( &dst->z[ i ], z );
+	}
+	StoreLanesAvx2( lanes, s );
+
+	SphereSse2( lanes, dst, i, num );
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const UInt32Kernel uint32Kernels[] = { UInt32Scalar, SSE2_KERNEL( UInt32Sse2 ), AVX2_KERNEL( UInt32Avx2 ) };
+static const UniformKernel uniformKernels[] = { UniformScalar, SSE2_KERNEL( UniformSse2 ), AVX2_KERNEL( UniformAvx2 ) };
+static const NormalKernel normalKernels[] = { NormalScalar, SSE2_KERNEL( NormalSse2 ), AVX2_KERNEL( NormalAvx2 ) };
+static const SphereKernel sphereKernels[] = { SphereScalar, SSE2_KERNEL( SphereSse2 ), AVX2_KERNEL( SphereAvx2 ) };
+
+void PlFillRandomBytes( PLRandom *rng, void *dst, size_t size ) {
+	uint8_t *p = dst;
+	for ( ; size >= sizeof( uint64_t ); size -= sizeof( uint64_t ), p += sizeof( uint64_t ) ) {
+		uint64_t v = PlRandomUInt64( rng );
+		memcpy( p, &v, sizeof( v ) );
+	}
+
+	if ( size > 0 ) {
+		uint64_t v = PlRandomUInt64( rng );
+		memcpy( p, &v, size );
+	}
+}
+
+void PlFillRandomUInt32( PLRandom *rng, uint32_t *dst, size_t num ) {
+	RandomLanes lanes;
+	SeedLanes( rng, &lanes );
+	PL_SELECT_SIMD_KERNEL( uint32Kernels, PlGetSimdLevel() )( &lanes, dst, 0, num );
+}
+
+/**
+ * Fills dst with values uniformly distributed between min and max.
+ */
+void PlFillRandomFloats( PLRandom *rng, float *dst, size_t num, float min, float max ) {
+	RandomLanes lanes;
+	SeedLanes( rng, &lanes );
+	PL_SELECT_SIMD_KERNEL( uniformKernels, PlGetSimdLevel() )( &lanes, dst, 0, num, ( max - min ) * UNIT_24, min );
+}
+
+/**
+ * Fills dst with normally distributed values.
+ */
+void PlFillRandomNormals( PLRandom *rng, float *dst, size_t num, float mean, float deviation ) {
+	RandomLanes lanes;
+	SeedLanes( rng, &lanes );
+	PL_SELECT_SIMD_KERNEL( normalKernels, PlGetSimdLevel() )( &lanes, dst, 0, num, mean, deviation );
+}
+
+/**
+ * Fills dst with points uniformly distributed over the surface of the unit
+ * sphere, e.g. for particle directions.
+ */
+void PlFillRandomOnSphere( PLRandom *rng, const PLVector3SoA *dst, size_t num ) {
+	RandomLanes lanes;
+	SeedLanes( rng, &lanes );
+	PL_SELECT_SIMD_KERNEL( sphereKernels, PlGetSimdLevel() )( &lanes, dst, 0, num );
+}
@@ -0,0 +1,750 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_physics.h>
+
+#include <limits.h>
+#include <math.h>
+
+/* Two broadphases sharing the same proxies and pair set. Sweep and prune
+ * follows Bullet's btAxisSweep3: each axis keeps a sorted list of min and
+ * max endpoints, and re-sorting those lists by insertion sort (cheap, as
+ * they're nearly sorted already) tells us exactly which pairs started or
+ * stopped overlapping, as their endpoints swap past each other. The hash
+ * grid drops everything into cells each update and checks what shares one,
+ * stamping the pairs it finds so the ones it didn't can be thrown out. */
+
+#define INVALID_INDEX UINT32_MAX
+
+/* anything covering more cells than this is tested against everything instead */
+#define MAX_GRID_CELLS 64
+/* cell coordinates are clamped to this before they're turned into ints, far out bounds just end up oversized */
+#define MAX_GRID_COORD ( float ) ( INT_MAX / 2 )
+
+enum {
+	PROXY_FREE,
+	PROXY_ADDED, /* live, but its endpoints haven't been sorted in yet */
+	PROXY_LIVE,
+	PROXY_REMOVED, /* dead, but its pairs haven't been reported as removed yet */
+};
+
+typedef struct BroadphaseProxy {
+	PLVector3 mins, maxs;
+	PLVector3 lastMins, lastMaxs; /* as of the last update, for sweep and prune */
+	void *userData;
+	unsigned int next; /* next free proxy, while on the free list */
+	int state;
+} BroadphaseProxy;
+
+/* sorted on value, and then mins before maxs, so touching counts as overlapping */
+typedef struct Endpoint {
+	float value;
+	uint32_t data; /* proxy << 1, with the low bit set for a max */
+} Endpoint;
+
+typedef struct GridRange {
+	int mins[ 3 ], maxs[ 3 ];
+	bool oversized;
+} GridRange;
+
+typedef struct GridEntry {
+	unsigned int proxy;
+	int cell[ 3 ];
+} GridEntry;
+
+typedef struct PairList {
+	PLBroadphasePair *pairs;
+	unsigned int num, max;
+} PairList;
+
+typedef struct PLBroadphase {
+	PLBroadphaseType type;
+
+	BroadphaseProxy *proxies;
+	unsigned int numProxies, maxProxies;
+	unsigned int numLiveProxies;
+	unsigned int freeList;
+	unsigned int *deadProxies;
+	unsigned int numDeadProxies, maxDeadProxies;
+	unsigned int numDeadSortedProxies;
+
+	/* kept dense, with an open addressed table of indices into them */
+	PLBroadphasePair *pairs;
+	uint32_t *pairStamps;
+	unsigned int numPairs, maxPairs;
+	uint32_t *pairTable;
+	unsigned int pairTableBits;
+	uint32_t stamp;
+
+	PairList added, removed;
+
+	/* sweep and prune */
+	Endpoint *endpoints[ 3 ];
+	Endpoint *mergeBuffer;
+	unsigned int numEndpoints, numSortedEndpoints, maxEndpoints;
+
+	/* hash grid */
+	float invCellSize;
+	GridRange *gridRanges;
+	unsigned int maxGridRanges;
+	GridEntry *gridEntries;
+	unsigned int maxGridEntries;
+	uint32_t *gridBuckets;
+	unsigned int maxGridBuckets;
+	unsigned int *oversized;
+	unsigned int numOversized, maxOversized;
+} PLBroadphase;
+
+static void *GrowArray( void *array, unsigned int *max, unsigned int needed, size_t size ) {
+	if ( needed <= *max ) {
+		return array;
+	}
+
+	unsigned int newMax = ( *max > 0 ) ? *max : 16;
+	while ( newMax < needed ) {
+		newMax *= 2;
+	}
+	*max = newMax;
+	return pl_realloc( array, size * newMax );
+}
+
+static void PushPair( PairList *list, unsigned int proxyA, unsigned int proxyB ) {
+	list->pairs = GrowArray( list->pairs, &list->max, list->num + 1, sizeof( PLBroadphasePair ) );
+	list->pairs[ list->num ].proxyA = proxyA;
+	list->pairs[ list->num ].proxyB = proxyB;
+	list->num++;
+}
+
+static bool IsValidProxy( const PLBroadphase *broadphase, unsigned int proxy ) {
+	if ( proxy >= broadphase->numProxies ||
+	     ( broadphase->proxies[ proxy ].state != PROXY_LIVE && broadphase->proxies[ proxy ].state != PROXY_ADDED ) ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid proxy (%u)", proxy );
+		return false;
+	}
+
+	return true;
+}
+
+static void SetProxyBounds( BroadphaseProxy *proxy, const PLCollisionAABB *bounds ) {
+	proxy->mins = PlAddVector3( bounds->mins, bounds->origin );
+	proxy->maxs = PlAddVector3( bounds->maxs, bounds->origin );
+}
+
+static bool IsOverlapping( const BroadphaseProxy *a, const BroadphaseProxy *b ) {
+	return !( a->maxs.x < b->mins.x || a->maxs.y < b->mins.y || a->maxs.z < b->mins.z ||
+	          a->mins.x > b->maxs.x || a->mins.y > b->maxs.y || a->mins.z > b->maxs.z );
+}
+
+static bool WasOverlapping( const BroadphaseProxy *a, const BroadphaseProxy *b ) {
+	return !( a->lastMaxs.x < b->lastMins.x || a->lastMaxs.y < b->lastMins.y || a->lastMaxs.z < b->lastMins.z ||
+	          a->lastMins.x > b->lastMaxs.x || a->lastMins.y > b->lastMaxs.y || a->lastMins.z > b->lastMaxs.z );
+}
+
+/****************************************
+ * Pair Set
+ ****************************************/
+
+static uint32_t HashPair( unsigned int proxyA, unsigned int proxyB, unsigned int bits ) {
+	uint64_t key = ( ( uint64_t ) proxyA << 32 ) | proxyB;
+	return ( uint32_t ) ( ( key * 0x9E3779B97F4A7C15ull ) >> ( 64 - bits ) );
+}
+
+/* either where the pair is, or the empty slot it would go in */
+static uint32_t FindPairSlot( const PLBroadphase *broadphase, unsigned int proxyA, unsigned int proxyB ) {
+	uint32_t mask = ( 1u << broadphase->pairTableBits ) - 1;
+	for ( uint32_t slot = HashPair( proxyA, proxyB, broadphase->pairTableBits );; slot = ( slot + 1 ) & mask ) {
+		uint32_t index = broadphase->pairTable[ slot ];
+		if ( index == INVALID_INDEX ||
+		     ( broadphase->pairs[ index ].proxyA == proxyA && broadphase->pairs[ index ].proxyB == proxyB ) ) {
+			return slot;
+		}
+	}
+}
+
+static void ResizePairTable( PLBroadphase *broadphase, unsigned int bits ) {
+	pl_free( broadphase->pairTable );
+	broadphase->pairTableBits = bits;
+	broadphase->pairTable = pl_malloc( sizeof( uint32_t ) << bits );
+	memset( broadphase->pairTable, 0xff, sizeof( uint32_t ) << bits );
+	for ( unsigned int i = 0; i < broadphase->numPairs; ++i ) {
+		broadphase->pairTable[ FindPairSlot( broadphase, broadphase->pairs[ i ].proxyA, broadphase->pairs[ i ].proxyB ) ] = i;
+	}
+}
+
+static void AddPair( PLBroadphase *broadphase, unsigned int proxyA, unsigned int proxyB ) {
+	if ( proxyA > proxyB ) {
+		unsigned int swap = proxyA;
+		proxyA = proxyB;
+		proxyB = swap;
+	}
+
+	uint32_t slot = FindPairSlot( broadphase, proxyA, proxyB );
+	uint32_t index = broadphase->pairTable[ slot ];
+	if ( index != INVALID_INDEX ) {
+		broadphase->pairStamps[ index ] = broadphase->stamp;
+		return;
+	}
+
+	if ( broadphase->numPairs == broadphase->maxPairs ) {
+		unsigned int maxStamps = broadphase->maxPairs;
+		broadphase->pairs = GrowArray( broadphase->pairs, &broadphase->maxPairs, broadphase->numPairs + 1, sizeof( PLBroadphasePair ) );
+		broadphase->pairStamps = GrowArray( broadphase->pairStamps, &maxStamps, broadphase->numPairs + 1, sizeof( uint32_t ) );
+	}
+
+	index = broadphase->numPairs++;
+	broadphase->pairs[ index ].proxyA = proxyA;
+	broadphase->pairs[ index ].proxyB = proxyB;
+	broadphase->pairStamps[ index ] = broadphase->stamp;
+	broadphase->pairTable[ slot ] = index;
+	if ( broadphase->numPairs * 2 > ( 1u << broadphase->pairTableBits ) ) {
+		ResizePairTable( broadphase, broadphase->pairTableBits + 1 );
+	}
+
+	PushPair( &broadphase->added, proxyA, proxyB );
+}
+
+static void RemovePairSlot( PLBroadphase *broadphase, uint32_t slot ) {
+	uint32_t mask = ( 1u << broadphase->pairTableBits ) - 1;
+	uint32_t index = broadphase->pairTable[ slot ];
+	PushPair( &broadphase->removed, broadphase->pairs[ index ].proxyA, broadphase->pairs[ index ].proxyB );
+
+	/* shuffle back anything after it that would otherwise become unreachable */
+	uint32_t hole = slot;
+	for ( uint32_t i = ( slot + 1 ) & mask; broadphase->pairTable[ i ] != INVALID_INDEX; i = ( i + 1 ) & mask ) {
+		const PLBroadphasePair *pair = &broadphase->pairs[ broadphase->pairTable[ i ] ];
+		uint32_t home = HashPair( pair->proxyA, pair->proxyB, broadphase->pairTableBits );
+		if ( ( ( i - home ) & mask ) >= ( ( i - hole ) & mask ) ) {
+			broadphase->pairTable[ hole ] = broadphase->pairTable[ i ];
+			hole = i;
+		}
+	}
+	broadphase->pairTable[ hole ] = INVALID_INDEX;
+
+	/* and fill the gap it leaves with the last pair */
+	uint32_t last = --broadphase->numPairs;
+	if ( index != last ) {
+		broadphase->pairs[ index ] = broadphase->pairs[ last ];
+		broadphase->pairStamps[ index ] = broadphase->pairStamps[ last ];
+		broadphase->pairTable[ FindPairSlot( broadphase, broadphase->pairs[ index ].proxyA, broadphase->pairs[ index ].proxyB ) ] = index;
+	}
+}
+
+static void RemovePair( PLBroadphase *broadphase, unsigned int proxyA, unsigned int proxyB ) {
+	uint32_t slot = ( proxyA < proxyB ) ? FindPairSlot( broadphase, proxyA, proxyB ) : FindPairSlot( broadphase, proxyB, proxyA );
+	if ( broadphase->pairTable[ slot ] != INVALID_INDEX ) {
+		RemovePairSlot( broadphase, slot );
+	}
+}
+
+/* going backwards, as anything moved into place has already been looked at */
+static void RemoveDeadPairs( PLBroadphase *broadphase, bool checkStamps ) {
+	for ( unsigned int i = broadphase->numPairs; i-- > 0; ) {
+		const PLBroadphasePair *pair = &broadphase->pairs[ i ];
+		if ( broadphase->proxies[ pair->proxyA ].state == PROXY_REMOVED ||
+		     broadphase->proxies[ pair->proxyB ].state == PROXY_REMOVED ||
+		     ( checkStamps && broadphase->pairStamps[ i ] != broadphase->stamp ) ) {
+			RemovePairSlot( broadphase, FindPairSlot( broadphase, pair->proxyA, pair->proxyB ) );
+		}
+	}
+}
+
+/****************************************
+ * Sweep and Prune
+ ****************************************/
+
+static bool IsEndpointBefore( Endpoint a, Endpoint b ) {
+	return a.value < b.value || ( a.value == b.value && ( a.data & 1 ) < ( b.data & 1 ) );
+}
+
+static int CompareEndpoints( const void *a, const void *b ) {
+	const Endpoint *ea = a, *eb = b;
+	return IsEndpointBefore( *ea, *eb ) ? -1 : ( IsEndpointBefore( *eb, *ea ) ? 1 : 0 );
+}
+
+static void RefreshEndpoints( PLBroadphase *broadphase, unsigned int axis ) {
+	Endpoint *endpoints = broadphase->endpoints[ axis ];
+	for ( unsigned int i = 0; i < broadphase->numEndpoints; ++i ) {
+		BroadphaseProxy *proxy = &broadphase->proxies[ endpoints[ i ].data >> 1 ];
+		endpoints[ i ].value = ( endpoints[ i ].data & 1 ) ? PlVector3Index( proxy->maxs, axis ) : PlVector3Index( proxy->mins, axis );
+	}
+}
+
+/**
+ * Everything that needs to move left does so one step at a time, and each
+ * step tells us about a pair: a min passing a max means they might have
+ * started overlapping, and a max passing a min means they definitely
+ * stopped. Nothing else can change whether a pair overlaps. The pairs are
+ * exactly what overlapped last time, so that's checked before bothering
+ * to look one up.
+ */
+static void SortAxis( PLBroadphase *broadphase, unsigned int axis ) {
+	Endpoint *endpoints = broadphase->endpoints[ axis ];
+	for ( unsigned int i = 1; i < broadphase->numSortedEndpoints; ++i ) {
+		Endpoint endpoint = endpoints[ i ];
+		unsigned int j = i;
+		for ( ; j > 0 && IsEndpointBefore( endpoint, endpoints[ j - 1 ] ); --j ) {
+			Endpoint other = endpoints[ j - 1 ];
+			endpoints[ j ] = other;
+			if ( ( endpoint.data & 1 ) == ( other.data & 1 ) ) {
+				continue;
+			}
+
+			unsigned int a = endpoint.data >> 1, b = other.data >> 1;
+			if ( endpoint.data & 1 ) {
+				if ( WasOverlapping( &broadphase->proxies[ a ], &broadphase->proxies[ b ] ) ) {
+					RemovePair( broadphase, a, b );
+				}
+			} else if ( broadphase->proxies[ a ].state == PROXY_LIVE && broadphase->proxies[ b ].state == PROXY_LIVE &&
+			            IsOverlapping( &broadphase->proxies[ a ], &broadphase->proxies[ b ] ) ) {
+				AddPair( broadphase, a, b );
+			}
+		}
+		endpoints[ j ] = endpoint;
+	}
+}
+
+static unsigned int MergeEndpoints( Endpoint *dst, const Endpoint *a, unsigned int numA, const Endpoint *b, unsigned int numB ) {
+	unsigned int i = 0, j = 0, k = 0;
+	while ( i < numA && j < numB ) {
+		dst[ k++ ] = IsEndpointBefore( b[ j ], a[ i ] ) ? b[ j++ ] : a[ i++ ];
+	}
+	while ( i < numA ) {
+		dst[ k++ ] = a[ i++ ];
+	}
+	while ( j < numB ) {
+		dst[ k++ ] = b[ j++ ];
+	}
+	return k;
+}
+
+/* the y and z bounds of everything the sweep is inside, kept together so they're quick to test */
+typedef struct ActiveList {
+	unsigned int *proxies;
+	float *bounds[ 4 ]; /* mins y, maxs y, mins z, maxs z */
+	unsigned int num;
+} ActiveList;
+
+static void SetupActiveList( ActiveList *list, unsigned int *proxies, float *bounds, unsigned int max ) {
+	list->proxies = proxies;
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		list->bounds[ i ] = bounds + i * max;
+	}
+	list->num = 0;
+}
+
+static void SetActiveEntry( ActiveList *list, unsigned int slot, unsigned int proxy, const BroadphaseProxy *p ) {
+	list->proxies[ slot ] = proxy;
+	list->bounds[ 0 ][ slot ] = p->mins.y;
+	list->bounds[ 1 ][ slot ] = p->maxs.y;
+	list->bounds[ 2 ][ slot ] = p->mins.z;
+	list->bounds[ 3 ][ slot ] = p->maxs.z;
+}
+
+/* anything still in the list overlaps on x, so only the other two need checking */
+static void TestActiveList( PLBroadphase *broadphase, unsigned int proxy, const ActiveList *list, unsigned int *hits ) {
+	const BroadphaseProxy *p = &broadphase->proxies[ proxy ];
+	unsigned int numHits = 0;
+	for ( unsigned int i = 0; i < list->num; ++i ) {
+		hits[ numHits ] = i;
+		numHits += ( list->bounds[ 0 ][ i ] <= p->maxs.y ) & ( list->bounds[ 1 ][ i ] >= p->mins.y ) &
+		           ( list->bounds[ 2 ][ i ] <= p->maxs.z ) & ( list->bounds[ 3 ][ i ] >= p->mins.z );
+	}
+	for ( unsigned int i = 0; i < numHits; ++i ) {
+		AddPair( broadphase, proxy, list->proxies[ hits[ i ] ] );
+	}
+}
+
+/**
+ * Sweeps along the merged x axis, testing the newly added proxies against
+ * anything they cross. The old ones are kept in their own list, as they
+ * don't need testing against each other.
+ */
+static void AddNewProxyPairs( PLBroadphase *broadphase, const Endpoint *endpoints, unsigned int numEndpoints ) {
+	unsigned int max = broadphase->numProxies;
+	unsigned int *slots = pl_malloc( sizeof( unsigned int ) * max * 4 );
+	unsigned int *hits = slots + max * 3;
+	float *bounds = pl_malloc( sizeof( float ) * max * 8 );
+	ActiveList lists[ 2 ];
+	SetupActiveList( &lists[ 0 ], slots + max, bounds, max );
+	SetupActiveList( &lists[ 1 ], slots + max * 2, bounds + max * 4, max );
+
+	for ( unsigned int i = 0; i < numEndpoints; ++i ) {
+		unsigned int proxy = endpoints[ i ].data >> 1;
+		ActiveList *list = &lists[ broadphase->proxies[ proxy ].state == PROXY_ADDED ];
+		if ( endpoints[ i ].data & 1 ) {
+			unsigned int slot = slots[ proxy ], last = --list->num;
+			if ( slot != last ) {
+				unsigned int moved = list->proxies[ last ];
+				SetActiveEntry( list, slot, moved, &broadphase->proxies[ moved ] );
+				slots[ moved ] = slot;
+			}
+			continue;
+		}
+
+		if ( list == &lists[ 1 ] ) {
+			TestActiveList( broadphase, proxy, &lists[ 0 ], hits );
+		}
+		TestActiveList( broadphase, proxy, &lists[ 1 ], hits );
+		slots[ proxy ] = list->num;
+		SetActiveEntry( list, list->num++, proxy, &broadphase->proxies[ proxy ] );
+	}
+
+	pl_free( slots );
+	pl_free( bounds );
+}
+
+static void UpdateSweepAndPrune( PLBroadphase *broadphase ) {
+	for ( unsigned int axis = 0; axis < 3; ++axis ) {
+		RefreshEndpoints( broadphase, axis );
+		SortAxis( broadphase, axis );
+	}
+
+	/* removed proxies sit at infinity, so they've all been sorted to the end */
+	unsigned int numOld = broadphase->numSortedEndpoints - broadphase->numDeadSortedProxies * 2;
+	broadphase->numDeadSortedProxies = 0;
+
+	/* sort in anything that's been added since last time, dropping any that have already gone again */
+	unsigned int numNew = 0;
+	for ( unsigned int axis = 0; axis < 3; ++axis ) {
+		Endpoint *added = broadphase->endpoints[ axis ] + broadphase->numSortedEndpoints;
+		numNew = 0;
+		for ( unsigned int i = 0; i < broadphase->numEndpoints - broadphase->numSortedEndpoints; ++i ) {
+			if ( broadphase->proxies[ added[ i ].data >> 1 ].state == PROXY_ADDED ) {
+				added[ numNew++ ] = added[ i ];
+			}
+		}
+		if ( numNew == 0 ) {
+			break;
+		}
+
+		qsort( added, numNew, sizeof( Endpoint ), CompareEndpoints );
+		MergeEndpoints( broadphase->mergeBuffer, broadphase->endpoints[ axis ], numOld, added, numNew );
+		if ( axis == 0 ) {
+			AddNewProxyPairs( broadphase, broadphase->mergeBuffer, numOld + numNew );
+		}
+
+		Endpoint *swap = broadphase->endpoints[ axis ];
+		broadphase->endpoints[ axis ] = broadphase->mergeBuffer;
+		broadphase->mergeBuffer = swap;
+	}
+
+	for ( unsigned int i = 0; i < numOld + numNew; ++i ) {
+		if ( broadphase->endpoints[ 0 ][ i ].data & 1 ) {
+			continue;
+		}
+		BroadphaseProxy *proxy = &broadphase->proxies[ broadphase->endpoints[ 0 ][ i ].data >> 1 ];
+		proxy->lastMins = proxy->mins;
+		proxy->lastMaxs = proxy->maxs;
+		proxy->state = PROXY_LIVE;
+	}
+
+	broadphase->numEndpoints = broadphase->numSortedEndpoints = numOld + numNew;
+}
+
+/****************************************
+ * Hash Grid
+ ****************************************/
+
+static uint32_t HashCell( int x, int y, int z, unsigned int bits ) {
+	uint32_t hash = ( ( uint32_t ) x * 73856093u ) ^ ( ( uint32_t ) y * 19349663u ) ^ ( ( uint32_t ) z * 83492791u );
+	return ( hash * 0x9E3779B1u ) >> ( 32 - bits );
+}
+
+#define FOR_EACH_CELL( RANGE, X, Y, Z )                          \
+	for ( int Z = ( RANGE )->mins[ 2 ]; Z <= ( RANGE )->maxs[ 2 ]; ++Z ) \
+		for ( int Y = ( RANGE )->mins[ 1 ]; Y <= ( RANGE )->maxs[ 1 ]; ++Y ) \
+			for ( int X = ( RANGE )->mins[ 0 ]; X <= ( RANGE )->maxs[ 0 ]; ++X )
+
+static int GetGridCoord( float v, float invCellSize ) {
+	return ( int ) fmaxf( fminf( floorf( v * invCellSize ), MAX_GRID_COORD ), -MAX_GRID_COORD );
+}
+
+static unsigned int SetupGridRange( PLBroadphase *broadphase, unsigned int proxy ) {
+	const BroadphaseProxy *p = &broadphase->proxies[ proxy ];
+	GridRange *range = &broadphase->gridRanges[ proxy ];
+	uint64_t numCells = 1;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		range->mins[ i ] = GetGridCoord( PlVector3Index( p->mins, i ), broadphase->invCellSize );
+		range->maxs[ i ] = GetGridCoord( PlVector3Index( p->maxs, i ), broadphase->invCellSize );
+		numCells *= ( uint64_t ) ( ( int64_t ) range->maxs[ i ] - range->mins[ i ] + 1 );
+	}
+
+	range->oversized = ( numCells > MAX_GRID_CELLS );
+	return range->oversized ? 0 : ( unsigned int ) numCells;
+}
+
+/* pairs sharing several cells are only counted in the first of them */
+static bool IsFirstSharedCell( const GridRange *a, const GridRange *b, const int *cell ) {
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		if ( cell[ i ] != ( ( a->mins[ i ] > b->mins[ i ] ) ? a->mins[ i ] : b->mins[ i ] ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void TestGridBucket( PLBroadphase *broadphase, const GridEntry *entries, unsigned int numEntries ) {
+	for ( unsigned int i = 0; i < numEntries; ++i ) {
+		const GridEntry *a = &entries[ i ];
+		for ( unsigned int j = i + 1; j < numEntries; ++j ) {
+			const GridEntry *b = &entries[ j ];
+			if ( a->proxy == b->proxy || a->cell[ 0 ] != b->cell[ 0 ] || a->cell[ 1 ] != b->cell[ 1 ] || a->cell[ 2 ] != b->cell[ 2 ] ) {
+				continue;
+			}
+
+			if ( IsFirstSharedCell( &broadphase->gridRanges[ a->proxy ], &broadphase->gridRanges[ b->proxy ], a->cell ) &&
+			     IsOverlapping( &broadphase->proxies[ a->proxy ], &broadphase->proxies[ b->proxy ] ) ) {
+				AddPair( broadphase, a->proxy, b->proxy );
+			}
+		}
+	}
+}
+
+static void UpdateHashGrid( PLBroadphase *broadphase ) {
+	broadphase->stamp++;
+
+	broadphase->gridRanges = GrowArray( broadphase->gridRanges, &broadphase->maxGridRanges, broadphase->numProxies, sizeof( GridRange ) );
+	broadphase->numOversized = 0;
+	unsigned int numEntries = 0;
+	for ( unsigned int i = 0; i < broadphase->numProxies; ++i ) {
+		if ( broadphase->proxies[ i ].state != PROXY_LIVE ) {
+			continue;
+		}
+
+		unsigned int numCells = SetupGridRange( broadphase, i );
+		if ( numCells == 0 ) {
+			broadphase->oversized = GrowArray( broadphase->oversized, &broadphase->maxOversized, broadphase->numOversized + 1, sizeof( unsigned int ) );
+			broadphase->oversized[ broadphase->numOversized++ ] = i;
+		}
+		numEntries += numCells;
+	}
+
+	/* counting sort everything into buckets by cell */
+	unsigned int bits = 4;
+	while ( ( 1u << bits ) < numEntries ) {
+		bits++;
+	}
+	unsigned int numBuckets = 1u << bits;
+	broadphase->gridBuckets = GrowArray( broadphase->gridBuckets, &broadphase->maxGridBuckets, numBuckets + 1, sizeof( uint32_t ) );
+	broadphase->gridEntries = GrowArray( broadphase->gridEntries, &broadphase->maxGridEntries, numEntries, sizeof( GridEntry ) );
+	uint32_t *buckets = broadphase->gridBuckets;
+	memset( buckets, 0, sizeof( uint32_t ) * ( numBuckets + 1 ) );
+	for ( unsigned int i = 0; i < broadphase->numProxies; ++i ) {
+		const GridRange *range = &broadphase->gridRanges[ i ];
+		if ( broadphase->proxies[ i ].state != PROXY_LIVE || range->oversized ) {
+			continue;
+		}
+		FOR_EACH_CELL( range, x, y, z ) {
+			buckets[ HashCell( x, y, z, bits ) + 1 ]++;
+		}
+	}
+	for ( unsigned int i = 1; i <= numBuckets; ++i ) {
+		buckets[ i ] += buckets[ i - 1 ];
+	}
+	for ( unsigned int i = 0; i < broadphase->numProxies; ++i ) {
+		const GridRange *range = &broadphase->gridRanges[ i ];
+		if ( broadphase->proxies[ i ].state != PROXY_LIVE || range->oversized ) {
+			continue;
+		}
+		FOR_EACH_CELL( range, x, y, z ) {
+			GridEntry *entry = &broadphase->gridEntries[ buckets[ HashCell( x, y, z, bits ) ]++ ];
+			entry->proxy = i;
+			entry->cell[ 0 ] = x;
+			entry->cell[ 1 ] = y;
+			entry->cell[ 2 ] = z;
+		}
+	}
+
+	/* each bucket now ends where the next one started */
+	for ( unsigned int i = 0, start = 0; i < numBuckets; start = buckets[ i++ ] ) {
+		if ( buckets[ i ] - start > 1 ) {
+			TestGridBucket( broadphase, &broadphase->gridEntries[ start ], buckets[ i ] - start );
+		}
+	}
+
+	for ( unsigned int i = 0; i < broadphase->numOversized; ++i ) {
+		unsigned int a = broadphase->oversized[ i ];
+		for ( unsigned int b = 0; b < broadphase->numProxies; ++b ) {
+			if ( a == b || broadphase->proxies[ b ].state != PROXY_LIVE || ( b < a && broadphase->gridRanges[ b ].oversized ) ) {
+				continue;
+			}
+			if ( IsOverlapping( &broadphase->proxies[ a ], &broadphase->proxies[ b ] ) ) {
+				AddPair( broadphase, a, b );
+			}
+		}
+	}
+
+	RemoveDeadPairs( broadphase, true );
+}
+
+/****************************************
+ * PUBLIC
+ ****************************************/
+
+static PLBroadphase *CreateBroadphase( PLBroadphaseType type ) {
+	PLBroadphase *broadphase = pl_calloc( 1, sizeof( PLBroadphase ) );
+	broadphase->type = type;
+	broadphase->freeList = INVALID_INDEX;
+	ResizePairTable( broadphase, 4 );
+	return broadphase;
+}
+
+PLBroadphase *PlCreateSweepAndPruneBroadphase( void ) {
+	return CreateBroadphase( PL_BROADPHASE_SWEEP_AND_PRUNE );
+}
+
+PLBroadphase *PlCreateHashGridBroadphase( float cellSize ) {
+	if ( cellSize <= 0.0f ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM1, "invalid cell size (%f)", cellSize );
+		return NULL;
+	}
+
+	PLBroadphase *broadphase = CreateBroadphase( PL_BROADPHASE_HASH_GRID );
+	broadphase->invCellSize = 1.0f / cellSize;
+	return broadphase;
+}
+
+void PlDestroyBroadphase( PLBroadphase *broadphase ) {
+	if ( broadphase == NULL ) {
+		return;
+	}
+
+	pl_free( broadphase->proxies );
+	pl_free( broadphase->deadProxies );
+	pl_free( broadphase->pairs );
+	pl_free( broadphase->pairStamps );
+	pl_free( broadphase->pairTable );
+	pl_free( broadphase->added.pairs );
+	pl_free( broadphase->removed.pairs );
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		pl_free( broadphase->endpoints[ i ] );
+	}
+	pl_free( broadphase->mergeBuffer );
+	pl_free( broadphase->gridRanges );
+	pl_free( broadphase->gridEntries );
+	pl_free( broadphase->gridBuckets );
+	pl_free( broadphase->oversized );
+	pl_free( broadphase );
+}
+
+PLBroadphaseType PlGetBroadphaseType( const PLBroadphase *broadphase ) {
+	return broadphase->type;
+}
+
+unsigned int PlAddBroadphaseProxy( PLBroadphase *broadphase, const PLCollisionAABB *bounds, void *userData ) {
+	unsigned int proxy = broadphase->freeList;
+	if ( proxy != INVALID_INDEX ) {
+		broadphase->freeList = broadphase->proxies[ proxy ].next;
+	} else {
+		broadphase->proxies = GrowArray( broadphase->proxies, &broadphase->maxProxies, broadphase->numProxies + 1, sizeof( BroadphaseProxy ) );
+		proxy = broadphase->numProxies++;
+	}
+
+	BroadphaseProxy *p = &broadphase->proxies[ proxy ];
+	SetProxyBounds( p, bounds );
+	p->userData = userData;
+	p->next = INVALID_INDEX;
+	p->state = PROXY_LIVE;
+	broadphase->numLiveProxies++;
+
+	if ( broadphase->type == PL_BROADPHASE_SWEEP_AND_PRUNE ) {
+		if ( broadphase->numEndpoints + 2 > broadphase->maxEndpoints ) {
+			for ( unsigned int i = 0; i < 3; ++i ) {
+				unsigned int maxEndpoints = broadphase->maxEndpoints;
+				broadphase->endpoints[ i ] = GrowArray( broadphase->endpoints[ i ], &maxEndpoints, broadphase->numEndpoints + 2, sizeof( Endpoint ) );
+			}
+			broadphase->mergeBuffer = GrowArray( broadphase->mergeBuffer, &broadphase->maxEndpoints, broadphase->numEndpoints + 2, sizeof( Endpoint ) );
+		}
+
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			broadphase->endpoints[ i ][ broadphase->numEndpoints ].data = proxy << 1;
+			broadphase->endpoints[ i ][ broadphase->numEndpoints + 1 ].data = ( proxy << 1 ) | 1;
+		}
+		broadphase->numEndpoints += 2;
+		p->state = PROXY_ADDED;
+	}
+
+	return proxy;
+}
+
+void PlRemoveBroadphaseProxy( PLBroadphase *broadphase, unsigned int proxy ) {
+	if ( !IsValidProxy( broadphase, proxy ) ) {
+		return;
+	}
+
+	BroadphaseProxy *p = &broadphase->proxies[ proxy ];
+	if ( p->state == PROXY_LIVE && broadphase->type == PL_BROADPHASE_SWEEP_AND_PRUNE ) {
+		broadphase->numDeadSortedProxies++;
+	}
+
+	/* off to the end, where the sweep can drop it */
+	p->mins = p->maxs = PLVector3( INFINITY, INFINITY, INFINITY );
+	p->state = PROXY_REMOVED;
+	broadphase->numLiveProxies--;
+
+	broadphase->deadProxies = GrowArray( broadphase->deadProxies, &broadphase->maxDeadProxies, broadphase->numDeadProxies + 1, sizeof( unsigned int ) );
+	broadphase->deadProxies[ broadphase->numDeadProxies++ ] = proxy;
+}
+
+void PlSetBroadphaseProxyBounds( PLBroadphase *broadphase, unsigned int proxy, const PLCollisionAABB *bounds ) {
+	if ( !IsValidProxy( broadphase, proxy ) ) {
+		return;
+	}
+
+	SetProxyBounds( &broadphase->proxies[ proxy ], bounds );
+}
+
+void *PlGetBroadphaseProxyUserData( const PLBroadphase *broadphase, unsigned int proxy ) {
+	if ( !IsValidProxy( broadphase, proxy ) ) {
+		return NULL;
+	}
+
+	return broadphase->proxies[ proxy ].userData;
+}
+
+unsigned int PlGetBroadphaseNumProxies( const PLBroadphase *broadphase ) {
+	return broadphase->numLiveProxies;
+}
+
+void PlUpdateBroadphase( PLBroadphase *broadphase ) {
+	broadphase->added.num = broadphase->removed.num = 0;
+
+	if ( broadphase->type == PL_BROADPHASE_SWEEP_AND_PRUNE ) {
+		if ( broadphase->numDeadProxies > 0 ) {
+			RemoveDeadPairs( broadphase, false );
+		}
+		UpdateSweepAndPrune( broadphase );
+	} else {
+		UpdateHashGrid( broadphase );
+	}
+
+	/* their pairs have been reported now, so the handles can go back */
+	for ( unsigned int i = 0; i < broadphase->numDeadProxies; ++i ) {
+		unsigned int proxy = broadphase->deadProxies[ i ];
+		broadphase->proxies[ proxy ].state = PROXY_FREE;
+		broadphase->proxies[ proxy ].next = broadphase->freeList;
+		broadphase->freeList = proxy;
+	}
+	broadphase->numDeadProxies = 0;
+}
+
+const PLBroadphasePair *PlGetBroadphasePairs( const PLBroadphase *broadphase, unsigned int *numPairs ) {
+	*numPairs = broadphase->numPairs;
+	return broadphase->pairs;
+}
+
+const PLBroadphasePair *PlGetBroadphaseAddedPairs( const PLBroadphase *broadphase, unsigned int *numPairs ) {
+	*numPairs = broadphase->added.num;
+	return broadphase->added.pairs;
+}
+
+const PLBroadphasePair *PlGetBroadphaseRemovedPairs( const PLBroadphase *broadphase, unsigned int *numPairs ) {
+	*numPairs = broadphase->removed.num;
+	return broadphase->removed.pairs;
+}
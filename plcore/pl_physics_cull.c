@@ -0,0 +1,377 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_physics.h>
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Each object is tested against a plane by the distance of its centre,
+ * pushed out by its radius; for a box that's the extents projected onto
+ * the plane's normal, which is as far as its furthest corner reaches. The
+ * vector kernels take a register's worth of objects at a time, stopping
+ * as soon as every one of them is outside a plane, and a group only starts
+ * with its cached plane when the whole group shares it; objects tend to be
+ * kept in some spatial order, so neighbours are usually culled by the same
+ * plane. Every kernel evaluates exactly the same operations in the same
+ * order, so which objects are visible doesn't depend on the kernel or the
+ * order the planes are tested in. */
+
+typedef struct CullPlanes {
+	unsigned int num;
+	float x[ PL_MAX_CULL_PLANES ], y[ PL_MAX_CULL_PLANES ], z[ PL_MAX_CULL_PLANES ], w[ PL_MAX_CULL_PLANES ];
+	float ax[ PL_MAX_CULL_PLANES ], ay[ PL_MAX_CULL_PLANES ], az[ PL_MAX_CULL_PLANES ]; /* absolute normals, for boxes */
+} CullPlanes;
+
+typedef struct CullJob {
+	const float *cx, *cy, *cz;
+	const float *ex, *ey, *ez; /* NULL for spheres */
+	const float *radii;        /* NULL for boxes */
+	uint8_t *planeCache;
+	uint32_t *visibleBits;
+	unsigned int *visibleIndices;
+	unsigned int numVisible;
+} CullJob;
+
+typedef void ( *CullKernel )( const CullPlanes *planes, CullJob *job, unsigned int i, unsigned int num );
+
+static void MarkVisible( CullJob *job, unsigned int i ) {
+	if ( job->visibleBits != NULL ) {
+		job->visibleBits[ i / 32 ] |= 1U << ( i % 32 );
+	}
+	if ( job->visibleIndices != NULL ) {
+		job->visibleIndices[ job->numVisible ] = i;
+	}
+	job->numVisible++;
+}
+
+/* groups always start on a multiple of their width, so never straddle a word */
+static void MarkVisibleGroup( CullJob *job, unsigned int i, unsigned int mask, unsigned int width ) {
+	if ( job->visibleBits != NULL ) {
+		job->visibleBits[ i / 32 ] |= mask << ( i % 32 );
+	}
+	for ( unsigned int k = 0; k < width; ++k ) {
+		if ( mask & ( 1U << k ) ) {
+			if ( job->visibleIndices != NULL ) {
+				job->visibleIndices[ job->numVisible ] = i + k;
+			}
+			job->numVisible++;
+		}
+	}
+}
+
+/* the plane that last culled the object, or the first if there's nothing cached */
+static unsigned int GetCachedPlane( const CullPlanes *planes, const CullJob *job, unsigned int i ) {
+	if ( job->planeCache == NULL || job->planeCache[ i ] >= planes->num ) {
+		return 0;
+	}
+
+	return job->planeCache[ i ];
+}
+
+static bool IsOutsidePlane( const CullPlanes *planes, unsigned int j, const CullJob *job, unsigned int i ) {
+	float d = planes->x[ j ] * job->cx[ i ] + planes->y[ j ] * job->cy[ i ] + planes->z[ j ] * job->cz[ i ] + planes->w[ j ];
+	float r;
+	if ( job->radii != NULL ) {
+		r = job->radii[ i ];
+	} else {
+		r = planes->ax[ j ] * job->ex[ i ] + planes->ay[ j ] * job->ey[ i ] + planes->az[ j ] * job->ez[ i ];
+	}
+
+	return d + r < 0.0f;
+}
+
+static void CullScalar( const CullPlanes *planes, CullJob *job, unsigned int i, unsigned int num ) {
+	for ( ; i < num; ++i ) {
+		unsigned int first = GetCachedPlane( planes, job, i );
+		unsigned int culledBy = first;
+		bool visible = !IsOutsidePlane( planes, first, job, i );
+		for ( unsigned int j = 0; visible && j < planes->num; ++j ) {
+			if ( j != first && IsOutsidePlane( planes, j, job, i ) ) {
+				culledBy = j;
+				visible = false;
+			}
+		}
+
+		if ( visible ) {
+			MarkVisible( job, i );
+		} else if ( job->planeCache != NULL ) {
+			job->planeCache[ i ] = ( uint8_t ) culledBy;
+		}
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+/* The vector kernels hold a group's cached planes as a single word, one
+ * byte per lane in order, and the lanes a plane culls are turned into a
+ * byte mask over it by narrowing their comparison down with packs. */
+
+typedef struct CullGroupSse2 {
+	__m128 cx, cy, cz;
+	__m128 ex, ey, ez, r;
+} CullGroupSse2;
+
+PL_TARGET_ISA( "sse2" )
+static __m128 GetOutsideSse2( const CullPlanes *planes, unsigned int j, const CullGroupSse2 *g, bool boxes ) {
+	__m128 d = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+	                                           _mm_mul_ps( _mm_set1_ps( planes->x[ j ] ), g->cx ),
+	                                           _mm_mul_ps( _mm_set1_ps( planes->y[ j ] ), g->cy ) ),
+	                                   _mm_mul_ps( _mm_set1_ps( planes->z[ j ] ), g->cz ) ),
+	                       _mm_set1_ps( planes->w[ j ] ) );
+	__m128 r;
+	if ( boxes ) {
+		r = _mm_add_ps( _mm_add_ps(
+		                        _mm_mul_ps( _mm_set1_ps( planes->ax[ j ] ), g->ex ),
+		                        _mm_mul_ps( _mm_set1_ps( planes->ay[ j ] ), g->ey ) ),
+		                _mm_mul_ps( _mm_set1_ps( planes->az[ j ] ), g->ez ) );
+	} else {
+		r = g->r;
+	}
+
+	return _mm_cmplt_ps( _mm_add_ps( d, r ), _mm_setzero_ps() );
+}
+
+PL_TARGET_ISA( "sse2" )
+static uint32_t GetLaneBytesSse2( __m128 lanes ) {
+	__m128i words = _mm_packs_epi32( _mm_castps_si128( lanes ), _mm_setzero_si128() );
+	return ( uint32_t ) _mm_cvtsi128_si32( _mm_packs_epi16( words, words ) );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void CullSse2( const CullPlanes *planes, CullJob *job, unsigned int i, unsigned int num ) {
+	bool boxes = ( job->radii == NULL );
+	for ( ; i + 4 <= num; i += 4 ) {
+		CullGroupSse2 g;
+		g.cx = _mm_loadu_ps( &job->cx[ i ] );
+		g.cy = _mm_loadu_ps( &job->cy[ i ] );
+		g.cz = _mm_loadu_ps( &job->cz[ i ] );
+		if ( boxes ) {
+			g.ex = _mm_loadu_ps( &job->ex[ i ] );
+			g.ey = _mm_loadu_ps( &job->ey[ i ] );
+			g.ez = _mm_loadu_ps( &job->ez[ i ] );
+		} else {
+			g.r = _mm_loadu_ps( &job->radii[ i ] );
+		}
+
+		/* only start with the cached plane if the whole group agrees on it */
+		uint32_t cached = 0;
+		unsigned int first = 0;
+		if ( job->planeCache != NULL ) {
+			memcpy( &cached, &job->planeCache[ i ], sizeof( cached ) );
+			first = cached & 0xFF;
+			if ( cached != first * 0x01010101U || first >= planes->num ) {
+				first = 0;
+			}
+		}
+
+		uint32_t culledBy = cached;
+		__m128 outsideLanes = _mm_setzero_ps();
+		unsigned int outside = 0;
+		for ( unsigned int k = 0; k <= planes->num && outside != 0xF; ++k ) {
+			/* the first plane goes first, then the rest in order */
+			unsigned int j = ( k == 0 ) ? first : k - 1;
+			if ( k > 0 && j == first ) {
+				continue;
+			}
+
+			__m128 culled = _mm_andnot_ps( outsideLanes, GetOutsideSse2( planes, j, &g, boxes ) );
+			unsigned int newlyCulled = ( unsigned int ) _mm_movemask_ps( culled );
+			if ( newlyCulled != 0 && job->planeCache != NULL ) {
+				uint32_t lanes = GetLaneBytesSse2( culled );
+				culledBy = ( culledBy & ~lanes ) | ( ( j * 0x01010101U ) & lanes );
+			}
+			outsideLanes = _mm_or_ps( outsideLanes, culled );
+			outside |= newlyCulled;
+		}
+
+		if ( culledBy != cached ) {
+			memcpy( &job->planeCache[ i ], &culledBy, sizeof( culledBy ) );
+		}
+
+		MarkVisibleGroup( job, i, ~outside & 0xF, 4 );
+	}
+
+	CullScalar( planes, job, i, num );
+}
+
+typedef struct CullGroupAvx2 {
+	__m256 cx, cy, cz;
+	__m256 ex, ey, ez, r;
+} CullGroupAvx2;
+
+PL_TARGET_ISA( "avx2" )
+static __m256 GetOutsideAvx2( const CullPlanes *planes, unsigned int j, const CullGroupAvx2 *g, bool boxes ) {
+	__m256 d = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps(
+	                                                 _mm256_mul_ps( _mm256_set1_ps( planes->x[ j ] ), g->cx ),
+	                                                 _mm256_mul_ps( _mm256_set1_ps( planes->y[ j ] ), g->cy ) ),
+	                                         _mm256_mul_ps( _mm256_set1_ps( planes->z[ j ] ), g->cz ) ),
+	                          _mm256_set1_ps( planes->w[ j ] ) );
+	__m256 r;
+	if ( boxes ) {
+		r = _mm256_add_ps( _mm256_add_ps(
+		                           _mm256_mul_ps( _mm256_set1_ps( planes->ax[ j ] ), g->ex ),
+		                           _mm256_mul_ps( _mm256_set1_ps( planes->ay[ j ] ), g->ey ) ),
+		                   _mm256_mul_ps( _mm256_set1_ps( planes->az[ j ] ), g->ez ) );
+	} else {
+		r = g->r;
+	}
+
+	return _mm256_cmp_ps( _mm256_add_ps( d, r ), _mm256_setzero_ps(), _CMP_LT_OQ );
+}
+
+PL_TARGET_ISA( "avx2" )
+static uint64_t GetLaneBytesAvx2( __m256 lanes ) {
+	__m128i words = _mm_packs_epi32( _mm256_castsi256_si128( _mm256_castps_si256( lanes ) ), _mm256_extracti128_si256( _mm256_castps_si256( lanes ), 1 ) );
+	uint64_t bytes;
+	_mm_storel_epi64( ( __m128i * ) &bytes, _mm_packs_epi16( words, words ) );
+	return bytes;
+}
+
+PL_TARGET_ISA( "avx2" )
+static void CullAvx2( const CullPlanes *planes, CullJob *job, unsigned int i, unsigned int num ) {
+	bool boxes = ( job->radii == NULL );
+	for ( ; i + 8 <= num; i += 8 ) {
+		CullGroupAvx2 g;
+		g.cx = _mm256_loadu_ps( &job->cx[ i ] );
+		g.cy = _mm256_loadu_ps( &job->cy[ i ] );
+		g.cz = _mm256_loadu_ps( &job->cz[ i ] );
+		if ( boxes ) {
+			g.ex = _mm256_loadu_ps( &job->ex[ i ] );
+			g.ey = _mm256_loadu_ps( &job->ey[ i ] );
+			g.ez = _mm256_loadu_ps( &job->ez[ i ] );
+		} else {
+			g.r = _mm256_loadu_ps( &job->radii[ i ] );
+		}
+
+		uint64_t cached = 0;
+		unsigned int first = 0;
+		if ( job->planeCache != NULL ) {
+			memcpy( &cached, &job->planeCache[ i ], sizeof( cached ) );
+			first = cached & 0xFF;
+			if ( cached != first * UINT64_C( 0x0101010101010101 ) || first >= planes->num ) {
+				first = 0;
+			}
+		}
+
+		uint64_t culledBy = cached;
+		__m256 outsideLanes = _mm256_setzero_ps();
+		unsigned int outside = 0;
+		for ( unsigned int k = 0; k <= planes->num && outside != 0xFF; ++k ) {
+			unsigned int j = ( k == 0 ) ? first : k - 1;
+			if ( k > 0 && j == first ) {
+				continue;
+			}
+
+			__m256 culled = _mm256_andnot_ps( outsideLanes, GetOutsideAvx2( planes, j, &g, boxes ) );
+			unsigned int newlyCulled = ( unsigned int ) _mm256_movemask_ps( culled );
+			if ( newlyCulled != 0 && job->planeCache != NULL ) {
+				uint64_t lanes = GetLaneBytesAvx2( culled );
+				culledBy = ( culledBy & ~lanes ) | ( ( j * UINT64_C( 0x0101010101010101 ) ) & lanes );
+			}
+			outsideLanes = _mm256_or_ps( outsideLanes, culled );
+			outside |= newlyCulled;
+		}
+
+		if ( culledBy != cached ) {
+			memcpy( &job->planeCache[ i ], &culledBy, sizeof( culledBy ) );
+		}
+
+		MarkVisibleGroup( job, i, ~outside & 0xFF, 8 );
+	}
+
+	CullSse2( planes, job, i, num );
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const CullKernel cullKernels[] = { CullScalar, SSE2_KERNEL( CullSse2 ), AVX2_KERNEL( CullAvx2 ) };
+
+static unsigned int Cull( const PLVector4 *planes, unsigned int numPlanes, CullJob *job, unsigned int num ) {
+	if ( numPlanes > PL_MAX_CULL_PLANES ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "too many planes (%u > %u)", numPlanes, PL_MAX_CULL_PLANES );
+		return 0;
+	}
+
+	if ( job->visibleBits != NULL ) {
+		memset( job->visibleBits, 0, PL_CULL_BITSET_WORDS( num ) * sizeof( uint32_t ) );
+	}
+
+	/* nothing to be outside of */
+	if ( numPlanes == 0 ) {
+		for ( unsigned int i = 0; i < num; ++i ) {
+			MarkVisible( job, i );
+		}
+		return job->numVisible;
+	}
+
+	CullPlanes p;
+	p.num = numPlanes;
+	for ( unsigned int i = 0; i < numPlanes; ++i ) {
+		p.x[ i ] = planes[ i ].x;
+		p.y[ i ] = planes[ i ].y;
+		p.z[ i ] = planes[ i ].z;
+		p.w[ i ] = planes[ i ].w;
+		p.ax[ i ] = fabsf( planes[ i ].x );
+		p.ay[ i ] = fabsf( planes[ i ].y );
+		p.az[ i ] = fabsf( planes[ i ].z );
+	}
+
+	PL_SELECT_SIMD_KERNEL( cullKernels, PlGetSimdLevel() )( &p, job, 0, num );
+
+	return job->numVisible;
+}
+
+/**
+ * Culls boxes by their centres and extents (half their size along each
+ * axis), returning how many are visible. Any of planeCache, visibleBits
+ * or visibleIndices may be NULL.
+ */
+unsigned int PlCullBoxes( const PLVector4 *planes, unsigned int numPlanes, const PLVector3SoA *centres, const PLVector3SoA *extents, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices ) {
+	CullJob job = {
+	        .cx = centres->x,
+	        .cy = centres->y,
+	        .cz = centres->z,
+	        .ex = extents->x,
+	        .ey = extents->y,
+	        .ez = extents->z,
+	        .planeCache = planeCache,
+	        .visibleBits = visibleBits,
+	        .visibleIndices = visibleIndices,
+	};
+
+	return Cull( planes, numPlanes, &job, num );
+}
+
+/**
+ * Culls spheres by their centres and radii, returning how many are
+ * visible. Any of planeCache, visibleBits or visibleIndices may be NULL.
+ */
+unsigned int PlCullSpheres( const PLVector4 *planes, unsigned int numPlanes, const PLVector3SoA *centres, const float *radii, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices ) {
+	CullJob job = {
+	        .cx = centres->x,
+	        .cy = centres->y,
+	        .cz = centres->z,
+	        .radii = radii,
+	        .planeCache = planeCache,
+	        .visibleBits = visibleBits,
+	        .visibleIndices = visibleIndices,
+	};
+
+	return Cull( planes, numPlanes, &job, num );
+}
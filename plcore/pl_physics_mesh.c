@@ -0,0 +1,786 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_physics.h>
+
+#include <float.h>
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Flattened bounding volume hierarchy, built top-down by binned surface
+ * area heuristic, with the triangles stored in leaf order as an origin and
+ * two edges each, split out by component for Möller–Trumbore. Packets of
+ * rays walk the hierarchy together, testing each node and triangle against
+ * every ray at once.
+ *
+ * Every kernel evaluates exactly the same operations in the same order as
+ * the scalar code, nothing is fused, node bounds are padded so rounding
+ * can't cull a node holding the closest hit, and ties on distance go to
+ * the lower numbered triangle; so whatever order the nodes get visited in,
+ * and whichever kernel does the work, the hits are identical. */
+
+#define MAX_LEAF_TRIANGLES 4
+#define SAH_BINS           16
+
+/* nodes are padded by this much of their largest coordinate */
+#define NODE_PADDING 1e-5f
+
+/* enough for most meshes; anything deeper gets its stack from the heap */
+#define LOCAL_STACK_SIZE 64
+
+typedef struct MeshNode {
+	float mins[ 3 ], maxs[ 3 ];
+	unsigned int first;    /* first child, with the second after it, or the first triangle of a leaf */
+	uint16_t numTriangles; /* 0 for inner nodes */
+	uint16_t axis;         /* the children were split along */
+} MeshNode;
+
+typedef struct PLCollisionMesh {
+	PLVector3 *vertices; /* three per triangle, as added */
+	unsigned int numTriangles, maxTriangles;
+
+	bool isBuilt;
+	MeshNode *nodes;
+	unsigned int numNodes;
+	unsigned int depth;
+	PLVector3 mins, maxs;
+
+	/* in leaf order */
+	float *triangleData;
+	const float *v0[ 3 ], *e1[ 3 ], *e2[ 3 ];
+	unsigned int *triangles;
+} PLCollisionMesh;
+
+/****************************************
+ * Intersection
+ ****************************************/
+
+/* Möller–Trumbore, hitting either side; the packet kernels must stay in step with this */
+static bool IntersectTriangle( const PLVector3 *o, const PLVector3 *d, PLVector3 v0, PLVector3 e1, PLVector3 e2, float *t, float *u, float *v ) {
+	float px = d->y * e2.z - d->z * e2.y;
+	float py = d->z * e2.x - d->x * e2.z;
+	float pz = d->x * e2.y - d->y * e2.x;
+	float det = e1.x * px + e1.y * py + e1.z * pz;
+	float invDet = 1.0f / det;
+
+	float tx = o->x - v0.x, ty = o->y - v0.y, tz = o->z - v0.z;
+	float qx = ty * e1.z - tz * e1.y;
+	float qy = tz * e1.x - tx * e1.z;
+	float qz = tx * e1.y - ty * e1.x;
+
+	*u = ( tx * px + ty * py + tz * pz ) * invDet;
+	*v = ( d->x * qx + d->y * qy + d->z * qz ) * invDet;
+	*t = ( e2.x * qx + e2.y * qy + e2.z * qz ) * invDet;
+	return det != 0.0f && *u >= 0.0f && *v >= 0.0f && *u + *v <= 1.0f && *t >= 0.0f;
+}
+
+/* keeps the slab test clear of infinity times zero */
+static float GetSlabInverse( float d ) {
+	return 1.0f / ( ( fabsf( d ) < 1e-20f ) ? copysignf( 1e-20f, d ) : d );
+}
+
+/* written the way the packet kernels' min and max behave */
+static bool IntersectNode( const MeshNode *node, const PLVector3 *o, const PLVector3 *inv, float maxDistance ) {
+	float tmin = 0.0f, tmax = maxDistance;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float t1 = ( node->mins[ i ] - PlVector3Index( *o, i ) ) * PlVector3Index( *inv, i );
+		float t2 = ( node->maxs[ i ] - PlVector3Index( *o, i ) ) * PlVector3Index( *inv, i );
+		float near = ( t1 < t2 ) ? t1 : t2;
+		float far = ( t1 > t2 ) ? t1 : t2;
+		tmin = ( near > tmin ) ? near : tmin;
+		tmax = ( far < tmax ) ? far : tmax;
+	}
+
+	return tmin <= tmax;
+}
+
+static PLVector3 GetTriangleVector( const float *const *components, unsigned int i ) {
+	return PLVector3( components[ 0 ][ i ], components[ 1 ][ i ], components[ 2 ][ i ] );
+}
+
+static void TraceRay( const PLCollisionMesh *mesh, const PLCollisionRay *ray, float maxDistance, PLCollisionMeshHit *hit, bool anyHit, unsigned int *stack ) {
+	hit->distance = maxDistance;
+	hit->triangle = PL_COLLISION_MESH_NO_HIT;
+	hit->u = hit->v = 0.0f;
+	if ( mesh->numNodes == 0 ) {
+		return;
+	}
+
+	PLVector3 inv = PLVector3( GetSlabInverse( ray->direction.x ), GetSlabInverse( ray->direction.y ), GetSlabInverse( ray->direction.z ) );
+	unsigned int numStack = 0;
+	stack[ numStack++ ] = 0;
+	while ( numStack > 0 ) {
+		const MeshNode *node = &mesh->nodes[ stack[ --numStack ] ];
+		if ( !IntersectNode( node, &ray->origin, &inv, hit->distance ) ) {
+			continue;
+		}
+
+		if ( node->numTriangles == 0 ) {
+			/* nearer child on top */
+			bool flip = PlVector3Index( ray->direction, node->axis ) < 0.0f;
+			stack[ numStack++ ] = node->first + !flip;
+			stack[ numStack++ ] = node->first + flip;
+			continue;
+		}
+
+		for ( unsigned int i = node->first; i < node->first + node->numTriangles; ++i ) {
+			float t, u, v;
+			if ( !IntersectTriangle( &ray->origin, &ray->direction, GetTriangleVector( mesh->v0, i ), GetTriangleVector( mesh->e1, i ), GetTriangleVector( mesh->e2, i ), &t, &u, &v ) ) {
+				continue;
+			}
+			if ( t < hit->distance || ( t == hit->distance && mesh->triangles[ i ] < hit->triangle ) ) {
+				hit->distance = t;
+				hit->triangle = mesh->triangles[ i ];
+				hit->u = u;
+				hit->v = v;
+				if ( anyHit ) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+/****************************************
+ * Packets
+ ****************************************/
+
+typedef void ( *RaycastKernel )( const PLCollisionMesh *mesh, const PLCollisionRay *rays, size_t i, size_t num, float maxDistance, PLCollisionMeshHit *hits, unsigned int *stack );
+
+static void RaycastScalar( const PLCollisionMesh *mesh, const PLCollisionRay *rays, size_t i, size_t num, float maxDistance, PLCollisionMeshHit *hits, unsigned int *stack ) {
+	for ( ; i < num; ++i ) {
+		TraceRay( mesh, &rays[ i ], maxDistance, &hits[ i ], false, stack );
+	}
+}
+
+/* packets only pay off when the rays head roughly the same way, so anything
+ * that doesn't share a direction octant is left to go one at a time */
+static bool IsPacketCoherent( const PLCollisionRay *rays, unsigned int numLanes ) {
+	for ( unsigned int i = 1; i < numLanes; ++i ) {
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			if ( ( PlVector3Index( rays[ i ].direction, j ) < 0.0f ) != ( PlVector3Index( rays[ 0 ].direction, j ) < 0.0f ) ) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* pushes the children of node, in the order that suits the first ray of the packet */
+static unsigned int PushPacketChildren( const MeshNode *node, const PLCollisionRay *rays, unsigned int *stack, unsigned int numStack ) {
+	bool flip = PlVector3Index( rays[ 0 ].direction, node->axis ) < 0.0f;
+	stack[ numStack++ ] = node->first + !flip;
+	stack[ numStack++ ] = node->first + flip;
+	return numStack;
+}
+
+/* splits a packet of rays out into a lane per ray */
+static void LoadPacketLanes( const PLCollisionRay *rays, unsigned int numLanes, float ( *lanes )[ 8 ] ) {
+	for ( unsigned int i = 0; i < numLanes; ++i ) {
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			lanes[ j ][ i ] = PlVector3Index( rays[ i ].origin, j );
+			lanes[ 3 + j ][ i ] = PlVector3Index( rays[ i ].direction, j );
+			lanes[ 6 + j ][ i ] = GetSlabInverse( lanes[ 3 + j ][ i ] );
+		}
+	}
+}
+
+static void StorePacketHits( PLCollisionMeshHit *hits, unsigned int numLanes, const float *t, const int32_t *triangles, const float *u, const float *v ) {
+	for ( unsigned int i = 0; i < numLanes; ++i ) {
+		hits[ i ].distance = t[ i ];
+		hits[ i ].triangle = ( unsigned int ) triangles[ i ];
+		hits[ i ].u = u[ i ];
+		hits[ i ].v = v[ i ];
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static void TracePacketSse2( const PLCollisionMesh *mesh, const PLCollisionRay *rays, float maxDistance, PLCollisionMeshHit *hits, unsigned int *stack ) {
+	float lanes[ 9 ][ 8 ];
+	LoadPacketLanes( rays, 4, lanes );
+	__m128 o[ 3 ], d[ 3 ], inv[ 3 ];
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		o[ i ] = _mm_loadu_ps( lanes[ i ] );
+		d[ i ] = _mm_loadu_ps( lanes[ 3 + i ] );
+		inv[ i ] = _mm_loadu_ps( lanes[ 6 + i ] );
+	}
+
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps( 1.0f );
+	const __m128i bias = _mm_set1_epi32( INT32_MIN ); /* for comparing unsigned */
+	__m128 bestT = _mm_set1_ps( maxDistance ), bestU = zero, bestV = zero;
+	__m128i bestTriangle = _mm_set1_epi32( -1 );
+
+	unsigned int numStack = 0;
+	if ( mesh->numNodes > 0 ) {
+		stack[ numStack++ ] = 0;
+	}
+	while ( numStack > 0 ) {
+		const MeshNode *node = &mesh->nodes[ stack[ --numStack ] ];
+		__m128 tmin = zero, tmax = bestT;
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			__m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( node->mins[ i ] ), o[ i ] ), inv[ i ] );
+			__m128 t2 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( node->maxs[ i ] ), o[ i ] ), inv[ i ] );
+			tmin = _mm_max_ps( _mm_min_ps( t1, t2 ), tmin );
+			tmax = _mm_min_ps( _mm_max_ps( t1, t2 ), tmax );
+		}
+		__m128 active = _mm_cmple_ps( tmin, tmax );
+		if ( _mm_movemask_ps( active ) == 0 ) {
+			continue;
+		}
+
+		if ( node->numTriangles == 0 ) {
+			numStack = PushPacketChildren( node, rays, stack, numStack );
+			continue;
+		}
+
+		for ( unsigned int i = node->first; i < node->first + node->numTriangles; ++i ) {
+			__m128 v0x = _mm_set1_ps( mesh->v0[ 0 ][ i ] ), v0y = _mm_set1_ps( mesh->v0[ 1 ][ i ] ), v0z = _mm_set1_ps( mesh->v0[ 2 ][ i ] );
+			__m128 e1x = _mm_set1_ps( mesh->e1[ 0 ][ i ] ), e1y = _mm_set1_ps( mesh->e1[ 1 ][ i ] ), e1z = _mm_set1_ps( mesh->e1[ 2 ][ i ] );
+			__m128 e2x = _mm_set1_ps( mesh->e2[ 0 ][ i ] ), e2y = _mm_set1_ps( mesh->e2[ 1 ][ i ] ), e2z = _mm_set1_ps( mesh->e2[ 2 ][ i ] );
+
+			__m128 px = _mm_sub_ps( _mm_mul_ps( d[ 1 ], e2z ), _mm_mul_ps( d[ 2 ], e2y ) );
+			__m128 py = _mm_sub_ps( _mm_mul_ps( d[ 2 ], e2x ), _mm_mul_ps( d[ 0 ], e2z ) );
+			__m128 pz = _mm_sub_ps( _mm_mul_ps( d[ 0 ], e2y ), _mm_mul_ps( d[ 1 ], e2x ) );
+			__m128 det = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, px ), _mm_mul_ps( e1y, py ) ), _mm_mul_ps( e1z, pz ) );
+			__m128 invDet = _mm_div_ps( one, det );
+
+			__m128 tx = _mm_sub_ps( o[ 0 ], v0x ), ty = _mm_sub_ps( o[ 1 ], v0y ), tz = _mm_sub_ps( o[ 2 ], v0z );
+			__m128 qx = _mm_sub_ps( _mm_mul_ps( ty, e1z ), _mm_mul_ps( tz, e1y ) );
+			__m128 qy = _mm_sub_ps( _mm_mul_ps( tz, e1x ), _mm_mul_ps( tx, e1z ) );
+			__m128 qz = _mm_sub_ps( _mm_mul_ps( tx, e1y ), _mm_mul_ps( ty, e1x ) );
+
+			__m128 u = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( tx, px ), _mm_mul_ps( ty, py ) ), _mm_mul_ps( tz, pz ) ), invDet );
+			__m128 v = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( d[ 0 ], qx ), _mm_mul_ps( d[ 1 ], qy ) ), _mm_mul_ps( d[ 2 ], qz ) ), invDet );
+			__m128 t = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2x, qx ), _mm_mul_ps( e2y, qy ) ), _mm_mul_ps( e2z, qz ) ), invDet );
+
+			__m128i triangle = _mm_set1_epi32( ( int ) mesh->triangles[ i ] );
+			__m128 lower = _mm_castsi128_ps( _mm_cmplt_epi32( _mm_xor_si128( triangle, bias ), _mm_xor_si128( bestTriangle, bias ) ) );
+			__m128 closer = _mm_or_ps( _mm_cmplt_ps( t, bestT ), _mm_and_ps( _mm_cmpeq_ps( t, bestT ), lower ) );
+			__m128 hit = _mm_and_ps( _mm_and_ps( _mm_cmpneq_ps( det, zero ), _mm_cmpge_ps( u, zero ) ), _mm_cmpge_ps( v, zero ) );
+			hit = _mm_and_ps( hit, _mm_and_ps( _mm_cmple_ps( _mm_add_ps( u, v ), one ), _mm_cmpge_ps( t, zero ) ) );
+			hit = _mm_and_ps( hit, _mm_and_ps( closer, active ) );
+			if ( _mm_movemask_ps( hit ) == 0 ) {
+				continue;
+			}
+
+			bestT = _mm_or_ps( _mm_and_ps( hit, t ), _mm_andnot_ps( hit, bestT ) );
+			bestU = _mm_or_ps( _mm_and_ps( hit, u ), _mm_andnot_ps( hit, bestU ) );
+			bestV = _mm_or_ps( _mm_and_ps( hit, v ), _mm_andnot_ps( hit, bestV ) );
+			__m128i hitMask = _mm_castps_si128( hit );
+			bestTriangle = _mm_or_si128( _mm_and_si128( hitMask, triangle ), _mm_andnot_si128( hitMask, bestTriangle ) );
+		}
+	}
+
+	float t[ 4 ], u[ 4 ], v[ 4 ];
+	int32_t triangles[ 4 ];
+	_mm_storeu_ps( t, bestT );
+	_mm_storeu_ps( u, bestU );
+	_mm_storeu_ps( v, bestV );
+	_mm_storeu_si128( ( __m128i * ) triangles, bestTriangle );
+	StorePacketHits( hits, 4, t, triangles, u, v );
+}
+
+PL_TARGET_ISA( "sse2" )
+static void RaycastSse2( const PLCollisionMesh *mesh, const PLCollisionRay *rays, size_t i, size_t num, float maxDistance, PLCollisionMeshHit *hits, unsigned int *stack ) {
+	for ( ; i + 4 <= num; i += 4 ) {
+		if ( IsPacketCoherent( &rays[ i ], 4 ) ) {
+			TracePacketSse2( mesh, &rays[ i ], maxDistance, &hits[ i ], stack );
+		} else {
+			RaycastScalar( mesh, rays, i, i + 4, maxDistance, hits, stack );
+		}
+	}
+
+	RaycastScalar( mesh, rays, i, num, maxDistance, hits, stack );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void TracePacketAvx2( const PLCollisionMesh *mesh, const PLCollisionRay *rays, float maxDistance, PLCollisionMeshHit *hits, unsigned int *stack ) {
+	float lanes[ 9 ][ 8 ];
+	LoadPacketLanes( rays, 8, lanes );
+	__m256 o[ 3 ], d[ 3 ], inv[ 3 ];
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		o[ i ] = _mm256_loadu_ps( lanes[ i ] );
+		d[ i ] = _mm256_loadu_ps( lanes[ 3 + i ] );
+		inv[ i ] = _mm256_loadu_ps( lanes[ 6 + i ] );
+	}
+
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps( 1.0f );
+	const __m256i bias = _mm256_set1_epi32( INT32_MIN );
+	__m256 bestT = _mm256_set1_ps( maxDistance ), bestU = zero, bestV = zero;
+	__m256i bestTriangle = _mm256_set1_epi32( -1 );
+
+	unsigned int numStack = 0;
+	if ( mesh->numNodes > 0 ) {
+		stack[ numStack++ ] = 0;
+	}
+	while ( numStack > 0 ) {
+		const MeshNode *node = &mesh->nodes[ stack[ --numStack ] ];
+		__m256 tmin = zero, tmax = bestT;
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			__m256 t1 = _mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( node->mins[ i ] ), o[ i ] ), inv[ i ] );
+			__m256 t2 = _mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( node->maxs[ i ] ), o[ i ] ), inv[ i ] );
+			tmin = _mm256_max_ps( _mm256_min_ps( t1, t2 ), tmin );
+			tmax = _mm256_min_ps( _mm256_max_ps( t1, t2 ), tmax );
+		}
+		__m256 active = _mm256_cmp_ps( tmin, tmax, _CMP_LE_OQ );
+		if ( _mm256_movemask_ps( active ) == 0 ) {
+			continue;
+		}
+
+		if ( node->numTriangles == 0 ) {
+			numStack = PushPacketChildren( node, rays, stack, numStack );
+			continue;
+		}
+
+		for ( unsigned int i = node->first; i < node->first + node->numTriangles; ++i ) {
+			__m256 v0x = _mm256_set1_ps( mesh->v0[ 0 ][ i ] ), v0y = _mm256_set1_ps( mesh->v0[ 1 ][ i ] ), v0z = _mm256_set1_ps( mesh->v0[ 2 ][ i ] );
+			__m256 e1x = _mm256_set1_ps( mesh->e1[ 0 ][ i ] ), e1y = _mm256_set1_ps( mesh->e1[ 1 ][ i ] ), e1z = _mm256_set1_ps( mesh->e1[ 2 ][ i ] );
+			__m256 e2x = _mm256_set1_ps( mesh->e2[ 0 ][ i ] ), e2y = _mm256_set1_ps( mesh->e2[ 1 ][ i ] ), e2z = _mm256_set1_ps( mesh->e2[ 2 ][ i ] );
+
+			__m256 px = _mm256_sub_ps( _mm256_mul_ps( d[ 1 ], e2z ), _mm256_mul_ps( d[ 2 ], e2y ) );
+			__m256 py = _mm256_sub_ps( _mm256_mul_ps( d[ 2 ], e2x ), _mm256_mul_ps( d[ 0 ], e2z ) );
+			__m256 pz = _mm256_sub_ps( _mm256_mul_ps( d[ 0 ], e2y ), _mm256_mul_ps( d[ 1 ], e2x ) );
+			__m256 det = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e1x, px ), _mm256_mul_ps( e1y, py ) ), _mm256_mul_ps( e1z, pz ) );
+			__m256 invDet = _mm256_div_ps( one, det );
+
+			__m256 tx = _mm256_sub_ps( o[ 0 ], v0x ), ty = _mm256_sub_ps( o[ 1 ], v0y ), tz = _mm256_sub_ps( o[ 2 ], v0z );
+			__m256 qx = _mm256_sub_ps( _mm256_mul_ps( ty, e1z ), _mm256_mul_ps( tz, e1y ) );
+			__m256 qy = _mm256_sub_ps( _mm256_mul_ps( tz, e1x ), _mm256_mul_ps( tx, e1z ) );
+			__m256 qz = _mm256_sub_ps( _mm256_mul_ps( tx, e1y ), _mm256_mul_ps( ty, e1x ) );
+
+			__m256 u = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( tx, px ), _mm256_mul_ps( ty, py ) ), _mm256_mul_ps( tz, pz ) ), invDet );
+			__m256 v = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( d[ 0 ], qx ), _mm256_mul_ps( d[ 1 ], qy ) ), _mm256_mul_ps( d[ 2 ], qz ) ), invDet );
+			__m256 t = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e2x, qx ), _mm256_mul_ps( e2y, qy ) ), _mm256_mul_ps( e2z, qz ) ), invDet );
+
+			__m256i triangle = _mm256_set1_epi32( ( int ) mesh->triangles[ i ] );
+			__m256 lower = _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_xor_si256( bestTriangle, bias ), _mm256_xor_si256( triangle, bias ) ) );
+			__m256 closer = _mm256_or_ps( _mm256_cmp_ps( t, bestT, _CMP_LT_OQ ), _mm256_and_ps( _mm256_cmp_ps( t, bestT, _CMP_EQ_OQ ), lower ) );
+			__m256 hit = _mm256_and_ps( _mm256_and_ps( _mm256_cmp_ps( det, zero, _CMP_NEQ_UQ ), _mm256_cmp_ps( u, zero, _CMP_GE_OQ ) ), _mm256_cmp_ps( v, zero, _CMP_GE_OQ ) );
+			hit = _mm256_and_ps( hit, _mm256_and_ps( _mm256_cmp_ps( _mm256_add_ps( u, v ), one, _CMP_LE_OQ ), _mm256_cmp_ps( t, zero, _CMP_GE_OQ ) ) );
+			hit = _mm256_and_ps( hit, _mm256_and_ps( closer, active ) );
+			if ( _mm256_movemask_ps( hit ) == 0 ) {
+				continue;
+			}
+
+			bestT = _mm256_blendv_ps( bestT, t, hit );
+			bestU = _mm256_blendv_ps( bestU, u, hit );
+			bestV = _mm256_blendv_ps( bestV, v, hit );
+			bestTriangle = _mm256_castps_si256( _mm256_blendv_ps( _mm256_castsi256_ps( bestTriangle ), _mm256_castsi256_ps( triangle ), hit ) );
+		}
+	}
+
+	float t[ 8 ], u[ 8 ], v[ 8 ];
+	int32_t triangles[ 8 ];
+	_mm256_storeu_ps( t, bestT );
+	_mm256_storeu_ps( u, bestU );
+	_mm256_storeu_ps( v, bestV );
+	_mm256_storeu_si256( ( __m256i * ) triangles, bestTriangle );
+	StorePacketHits( hits, 8, t, triangles, u, v );
+}
+
+PL_TARGET_ISA( "avx2" )
+static void RaycastAvx2( const PLCollisionMesh *mesh, const PLCollisionRay *rays, size_t i, size_t num, float maxDistance, PLCollisionMeshHit *hits, unsigned int *stack ) {
+	for ( ; i + 8 <= num; i += 8 ) {
+		if ( IsPacketCoherent( &rays[ i ], 8 ) ) {
+			TracePacketAvx2( mesh, &rays[ i ], maxDistance, &hits[ i ], stack );
+		} else {
+			RaycastScalar( mesh, rays, i, i + 8, maxDistance, hits, stack );
+		}
+	}
+
+	RaycastSse2( mesh, rays, i, num, maxDistance, hits, stack );
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const RaycastKernel raycastKernels[] = { RaycastScalar, SSE2_KERNEL( RaycastSse2 ), AVX2_KERNEL( RaycastAvx2 ) };
+
+/****************************************
+ * Building
+ ****************************************/
+
+typedef struct MeshBuilder {
+	PLVector3 *mins, *maxs, *centres; /* per triangle */
+	unsigned int *order;
+} MeshBuilder;
+
+typedef struct SahBin {
+	PLVector3 mins, maxs;
+	unsigned int num;
+} SahBin;
+
+static float GetHalfArea( PLVector3 mins, PLVector3 maxs ) {
+	PLVector3 d = PlSubtractVector3( maxs, mins );
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static unsigned int GetSahBin( float centre, float min, float scale ) {
+	unsigned int bin = ( unsigned int ) ( ( centre - min ) * scale );
+	return ( bin < SAH_BINS ) ? bin : SAH_BINS - 1;
+}
+
+static void SetNodeBounds( MeshNode *node, PLVector3 mins, PLVector3 maxs ) {
+	float scale = 0.0f;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		scale = fmaxf( scale, fmaxf( fabsf( PlVector3Index( mins, i ) ), fabsf( PlVector3Index( maxs, i ) ) ) );
+	}
+
+	float padding = scale * NODE_PADDING;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		node->mins[ i ] = PlVector3Index( mins, i ) - padding;
+		node->maxs[ i ] = PlVector3Index( maxs, i ) + padding;
+	}
+}
+
+/* returns the axis to split along, or -1 if there's nothing to split by */
+static int FindSahSplit( const MeshBuilder *builder, unsigned int first, unsigned int num, PLVector3 centreMins, PLVector3 centreMaxs, unsigned int *splitBin ) {
+	int bestAxis = -1;
+	float bestCost = FLT_MAX;
+	for ( int axis = 0; axis < 3; ++axis ) {
+		float min = PlVector3Index( centreMins, axis );
+		float extent = PlVector3Index( centreMaxs, axis ) - min;
+		if ( extent <= 0.0f ) {
+			continue;
+		}
+
+		SahBin bins[ SAH_BINS ];
+		for ( unsigned int i = 0; i < SAH_BINS; ++i ) {
+			bins[ i ].mins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX );
+			bins[ i ].maxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+			bins[ i ].num = 0;
+		}
+
+		float scale = SAH_BINS / extent;
+		for ( unsigned int i = first; i < first + num; ++i ) {
+			unsigned int triangle = builder->order[ i ];
+			SahBin *bin = &bins[ GetSahBin( PlVector3Index( builder->centres[ triangle ], axis ), min, scale ) ];
+			bin->mins = PlVector3Min( bin->mins, builder->mins[ triangle ] );
+			bin->maxs = PlVector3Max( bin->maxs, builder->maxs[ triangle ] );
+			bin->num++;
+		}
+
+		/* sweep in from the right, then across from the left */
+		float rightCost[ SAH_BINS ];
+		PLVector3 mins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX ), maxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+		unsigned int count = 0;
+		for ( unsigned int i = SAH_BINS - 1; i > 0; --i ) {
+			mins = PlVector3Min( mins, bins[ i ].mins );
+			maxs = PlVector3Max( maxs, bins[ i ].maxs );
+			count += bins[ i ].num;
+			rightCost[ i ] = ( count > 0 ) ? GetHalfArea( mins, maxs ) * count : -1.0f;
+		}
+
+		mins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX );
+		maxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+		count = 0;
+		for ( unsigned int i = 1; i < SAH_BINS; ++i ) {
+			mins = PlVector3Min( mins, bins[ i - 1 ].mins );
+			maxs = PlVector3Max( maxs, bins[ i - 1 ].maxs );
+			count += bins[ i - 1 ].num;
+			if ( count == 0 || rightCost[ i ] < 0.0f ) {
+				continue;
+			}
+
+			float cost = GetHalfArea( mins, maxs ) * count + rightCost[ i ];
+			if ( cost < bestCost ) {
+				bestCost = cost;
+				bestAxis = axis;
+				*splitBin = i;
+			}
+		}
+	}
+
+	return bestAxis;
+}
+
+static void BuildNode( PLCollisionMesh *mesh, const MeshBuilder *builder, unsigned int nodeIndex, unsigned int first, unsigned int num, unsigned int depth ) {
+	PLVector3 mins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX ), maxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	PLVector3 centreMins = mins, centreMaxs = maxs;
+	for ( unsigned int i = first; i < first + num; ++i ) {
+		unsigned int triangle = builder->order[ i ];
+		mins = PlVector3Min( mins, builder->mins[ triangle ] );
+		maxs = PlVector3Max( maxs, builder->maxs[ triangle ] );
+		centreMins = PlVector3Min( centreMins, builder->centres[ triangle ] );
+		centreMaxs = PlVector3Max( centreMaxs, builder->centres[ triangle ] );
+	}
+
+	MeshNode *node = &mesh->nodes[ nodeIndex ];
+	SetNodeBounds( node, mins, maxs );
+	if ( depth > mesh->depth ) {
+		mesh->depth = depth;
+	}
+
+	if ( num <= MAX_LEAF_TRIANGLES ) {
+		node->first = first;
+		node->numTriangles = ( uint16_t ) num;
+		node->axis = 0;
+		return;
+	}
+
+	unsigned int splitBin, numLeft;
+	int axis = FindSahSplit( builder, first, num, centreMins, centreMaxs, &splitBin );
+	if ( axis >= 0 ) {
+		float min = PlVector3Index( centreMins, axis );
+		float scale = SAH_BINS / ( PlVector3Index( centreMaxs, axis ) - min );
+		unsigned int *order = builder->order + first;
+		numLeft = 0;
+		for ( unsigned int i = 0; i < num; ++i ) {
+			if ( GetSahBin( PlVector3Index( builder->centres[ order[ i ] ], axis ), min, scale ) < splitBin ) {
+				unsigned int swap = order[ i ];
+				order[ i ] = order[ numLeft ];
+				order[ numLeft++ ] = swap;
+			}
+		}
+	} else {
+		/* all in the same place, so just halve them */
+		axis = 0;
+		numLeft = num / 2;
+	}
+
+	node->first = mesh->numNodes;
+	node->numTriangles = 0;
+	node->axis = ( uint16_t ) axis;
+	mesh->numNodes += 2;
+
+	unsigned int children = node->first;
+	BuildNode( mesh, builder, children, first, numLeft, depth + 1 );
+	BuildNode( mesh, builder, children + 1, first + numLeft, num - numLeft, depth + 1 );
+}
+
+/****************************************
+ * PUBLIC
+ ****************************************/
+
+/**
+ * Möller–Trumbore test against a single triangle, from either side. On a
+ * hit, distance is in units of the ray's direction, and u and v are the
+ * weights of b and c. Any of them can be NULL.
+ */
+bool PlIsRayIntersectingTriangle( const PLCollisionRay *ray, PLVector3 a, PLVector3 b, PLVector3 c, float *distance, float *u, float *v ) {
+	float t, bu, bv;
+	if ( !IntersectTriangle( &ray->origin, &ray->direction, a, PlSubtractVector3( b, a ), PlSubtractVector3( c, a ), &t, &bu, &bv ) ) {
+		return false;
+	}
+
+	if ( distance != NULL ) {
+		*distance = t;
+	}
+	if ( u != NULL ) {
+		*u = bu;
+	}
+	if ( v != NULL ) {
+		*v = bv;
+	}
+
+	return true;
+}
+
+PLCollisionMesh *PlCreateCollisionMesh( void ) {
+	return pl_calloc( 1, sizeof( PLCollisionMesh ) );
+}
+
+static void FreeBuiltMesh( PLCollisionMesh *mesh ) {
+	pl_free( mesh->nodes );
+	pl_free( mesh->triangleData );
+	pl_free( mesh->triangles );
+	mesh->nodes = NULL;
+	mesh->triangleData = NULL;
+	mesh->triangles = NULL;
+	mesh->numNodes = 0;
+	mesh->depth = 0;
+	mesh->isBuilt = false;
+}
+
+void PlDestroyCollisionMesh( PLCollisionMesh *mesh ) {
+	if ( mesh == NULL ) {
+		return;
+	}
+
+	FreeBuiltMesh( mesh );
+	pl_free( mesh->vertices );
+	pl_free( mesh );
+}
+
+/**
+ * Adds numTriangles triangles, stride bytes apart in positions (or packed
+ * if 0), such as the position of a PLGVertex. If indices is NULL, each
+ * three positions in a row make a triangle.
+ */
+void PlAddCollisionMeshTriangles( PLCollisionMesh *mesh, const PLVector3 *positions, size_t stride, const unsigned int *indices, unsigned int numTriangles ) {
+	if ( stride == 0 ) {
+		stride = sizeof( PLVector3 );
+	}
+
+	if ( mesh->numTriangles + numTriangles > mesh->maxTriangles ) {
+		mesh->maxTriangles = ( mesh->maxTriangles > 0 ) ? mesh->maxTriangles : 64;
+		while ( mesh->maxTriangles < mesh->numTriangles + numTriangles ) {
+			mesh->maxTriangles *= 2;
+		}
+		mesh->vertices = pl_realloc( mesh->vertices, sizeof( PLVector3 ) * 3 * mesh->maxTriangles );
+	}
+
+	PLVector3 *dst = &mesh->vertices[ mesh->numTriangles * 3 ];
+	for ( unsigned int i = 0; i < numTriangles * 3; ++i ) {
+		size_t index = ( indices != NULL ) ? indices[ i ] : i;
+		dst[ i ] = *( const PLVector3 * ) ( ( const uint8_t * ) positions + index * stride );
+	}
+
+	mesh->numTriangles += numTriangles;
+	mesh->isBuilt = false;
+}
+
+/**
+ * Builds the hierarchy over everything added so far; needs doing again
+ * after adding any more.
+ */
+void PlBuildCollisionMesh( PLCollisionMesh *mesh ) {
+	FreeBuiltMesh( mesh );
+	mesh->isBuilt = true;
+	mesh->mins = mesh->maxs = pl_vecOrigin3;
+	if ( mesh->numTriangles == 0 ) {
+		return;
+	}
+
+	MeshBuilder builder;
+	builder.mins = pl_malloc( sizeof( PLVector3 ) * 3 * mesh->numTriangles );
+	builder.maxs = builder.mins + mesh->numTriangles;
+	builder.centres = builder.maxs + mesh->numTriangles;
+	builder.order = pl_malloc( sizeof( unsigned int ) * mesh->numTriangles );
+	for ( unsigned int i = 0; i < mesh->numTriangles; ++i ) {
+		const PLVector3 *v = &mesh->vertices[ i * 3 ];
+		builder.mins[ i ] = PlVector3Min( PlVector3Min( v[ 0 ], v[ 1 ] ), v[ 2 ] );
+		builder.maxs[ i ] = PlVector3Max( PlVector3Max( v[ 0 ], v[ 1 ] ), v[ 2 ] );
+		builder.centres[ i ] = PlScaleVector3F( PlAddVector3( builder.mins[ i ], builder.maxs[ i ] ), 0.5f );
+		builder.order[ i ] = i;
+	}
+
+	mesh->nodes = pl_malloc( sizeof( MeshNode ) * ( mesh->numTriangles * 2 - 1 ) );
+	mesh->numNodes = 1;
+	BuildNode( mesh, &builder, 0, 0, mesh->numTriangles, 0 );
+
+	mesh->mins = mesh->maxs = mesh->vertices[ 0 ];
+	for ( unsigned int i = 0; i < mesh->numTriangles; ++i ) {
+		mesh->mins = PlVector3Min( mesh->mins, builder.mins[ i ] );
+		mesh->maxs = PlVector3Max( mesh->maxs, builder.maxs[ i ] );
+	}
+
+	/* and lay the triangles out the way the leaves reference them */
+	mesh->triangleData = pl_malloc( sizeof( float ) * 9 * mesh->numTriangles );
+	float *components[ 9 ];
+	for ( unsigned int i = 0; i < 9; ++i ) {
+		components[ i ] = mesh->triangleData + i * mesh->numTriangles;
+	}
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		mesh->v0[ i ] = components[ i ];
+		mesh->e1[ i ] = components[ 3 + i ];
+		mesh->e2[ i ] = components[ 6 + i ];
+	}
+	mesh->triangles = builder.order;
+	for ( unsigned int i = 0; i < mesh->numTriangles; ++i ) {
+		const PLVector3 *v = &mesh->vertices[ mesh->triangles[ i ] * 3 ];
+		PLVector3 e1 = PlSubtractVector3( v[ 1 ], v[ 0 ] );
+		PLVector3 e2 = PlSubtractVector3( v[ 2 ], v[ 0 ] );
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			components[ j ][ i ] = PlVector3Index( v[ 0 ], j );
+			components[ 3 + j ][ i ] = PlVector3Index( e1, j );
+			components[ 6 + j ][ i ] = PlVector3Index( e2, j );
+		}
+	}
+
+	pl_free( builder.mins );
+}
+
+unsigned int PlGetCollisionMeshNumTriangles( const PLCollisionMesh *mesh ) {
+	return mesh->numTriangles;
+}
+
+void PlGetCollisionMeshBounds( const PLCollisionMesh *mesh, PLVector3 *mins, PLVector3 *maxs ) {
+	*mins = mesh->mins;
+	*maxs = mesh->maxs;
+}
+
+static unsigned int *GetTraceStack( const PLCollisionMesh *mesh, unsigned int *localStack ) {
+	if ( !mesh->isBuilt ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM1, "collision mesh hasn't been built" );
+		return NULL;
+	}
+
+	return ( mesh->depth + 2 <= LOCAL_STACK_SIZE ) ? localStack : pl_malloc( sizeof( unsigned int ) * ( mesh->depth + 2 ) );
+}
+
+static void FreeTraceStack( unsigned int *stack, unsigned int *localStack ) {
+	if ( stack != localStack ) {
+		pl_free( stack );
+	}
+}
+
+/**
+ * Finds the closest triangle along the ray, up to maxDistance, returning
+ * false if there isn't one.
+ */
+bool PlRaycastCollisionMesh( const PLCollisionMesh *mesh, const PLCollisionRay *ray, float maxDistance, PLCollisionMeshHit *hit ) {
+	unsigned int localStack[ LOCAL_STACK_SIZE ];
+	unsigned int *stack = GetTraceStack( mesh, localStack );
+	if ( stack == NULL ) {
+		hit->triangle = PL_COLLISION_MESH_NO_HIT;
+		return false;
+	}
+
+	TraceRay( mesh, ray, maxDistance, hit, false, stack );
+	FreeTraceStack( stack, localStack );
+	return hit->triangle != PL_COLLISION_MESH_NO_HIT;
+}
+
+/**
+ * The same as PlRaycastCollisionMesh for each of the rays, a packet at a
+ * time. Misses are left with a triangle of PL_COLLISION_MESH_NO_HIT.
+ */
+void PlRaycastCollisionMeshRays( const PLCollisionMesh *mesh, const PLCollisionRay *rays, unsigned int numRays, float maxDistance, PLCollisionMeshHit *hits ) {
+	unsigned int localStack[ LOCAL_STACK_SIZE ];
+	unsigned int *stack = GetTraceStack( mesh, localStack );
+	if ( stack == NULL ) {
+		for ( unsigned int i = 0; i < numRays; ++i ) {
+			hits[ i ].triangle = PL_COLLISION_MESH_NO_HIT;
+		}
+		return;
+	}
+
+	PL_SELECT_SIMD_KERNEL( raycastKernels, PlGetSimdLevel() )( mesh, rays, 0, numRays, maxDistance, hits, stack );
+	FreeTraceStack( stack, localStack );
+}
+
+/**
+ * Whether anything at all is along the ray within maxDistance, which is
+ * all line of sight needs; stops at the first hit it comes across.
+ */
+bool PlIsCollisionMeshBlockingRay( const PLCollisionMesh *mesh, const PLCollisionRay *ray, float maxDistance ) {
+	unsigned int localStack[ LOCAL_STACK_SIZE ];
+	unsigned int *stack = GetTraceStack( mesh, localStack );
+	if ( stack == NULL ) {
+		return false;
+	}
+
+	PLCollisionMeshHit hit;
+	TraceRay( mesh, ray, maxDistance, &hit, true, stack );
+	FreeTraceStack( stack, localStack );
+	return hit.triangle != PL_COLLISION_MESH_NO_HIT;
+}
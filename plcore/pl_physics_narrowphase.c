@@ -0,0 +1,1255 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_physics.h>
+
+#include <float.h>
+
+/* Anything with a dedicated test below gets it; the rest treat each shape
+ * as a core (a point, segment, box or hull) plus a radius, find how far
+ * apart the cores are by GJK and, if that's within the two radii, work the
+ * contact out from the closest points. Cores that overlap go to EPA for
+ * the shallowest way out instead.
+ *
+ * References:
+ *	Ericson, Real-Time Collision Detection, ch. 5 and 9
+ *	van den Bergen, Collision Detection in Interactive 3D Environments
+ *	Gottschalk, Separating Axis Test for OBBs */
+
+#define GJK_MAX_ITERATIONS 64
+#define EPA_MAX_ITERATIONS 64
+#define EPA_MAX_VERTICES   ( EPA_MAX_ITERATIONS + 4 )
+#define EPA_MAX_FACES      ( EPA_MAX_VERTICES * 2 )
+#define EPA_TOLERANCE      1e-5f
+
+/* normal used when there's nothing better to go on, such as concentric spheres */
+static const PLVector3 fallbackNormal = { 0.0f, 1.0f, 0.0f };
+
+static PLVector3 MultiplyAddVector3( PLVector3 v, PLVector3 v2, float f ) {
+	return PLVector3( v.x + v2.x * f, v.y + v2.y * f, v.z + v2.z * f );
+}
+
+static float GetLengthSquared( PLVector3 v ) {
+	return PlVector3DotProduct( v, v );
+}
+
+static PLVector3 GetMidpoint( PLVector3 a, PLVector3 b ) {
+	return PlScaleVector3F( PlAddVector3( a, b ), 0.5f );
+}
+
+static void BeginManifold( PLContactManifold *manifold, PLVector3 normal ) {
+	manifold->normal = normal;
+	manifold->numPoints = 0;
+}
+
+/* surfaceA and surfaceB are the deepest points of each shape into the other */
+static void AddContactPoint( PLContactManifold *manifold, PLVector3 surfaceA, PLVector3 surfaceB, float penetration ) {
+	PLContactPoint *point = &manifold->points[ manifold->numPoints++ ];
+	point->position = GetMidpoint( surfaceA, surfaceB );
+	point->penetration = ( penetration > 0.0f ) ? penetration : 0.0f;
+}
+
+/****************************************
+ * Spheres and Capsules
+ ****************************************/
+
+/* two points, each with a radius around them, as for spheres or the closest points of capsules */
+static bool CollideRoundedPoints( PLVector3 a, float radiusA, PLVector3 b, float radiusB, PLVector3 *normal, PLVector3 *surfaceA, PLVector3 *surfaceB, float *penetration ) {
+	PLVector3 d = PlSubtractVector3( b, a );
+	float radius = radiusA + radiusB;
+	float distanceSquared = GetLengthSquared( d );
+	if ( distanceSquared > radius * radius ) {
+		return false;
+	}
+
+	float distance = sqrtf( distanceSquared );
+	*normal = ( distance > FLT_EPSILON ) ? PlScaleVector3F( d, 1.0f / distance ) : fallbackNormal;
+	*surfaceA = MultiplyAddVector3( a, *normal, radiusA );
+	*surfaceB = MultiplyAddVector3( b, *normal, -radiusB );
+	*penetration = radius - distance;
+	return true;
+}
+
+static bool CollideRoundedPointsManifold( PLVector3 a, float radiusA, PLVector3 b, float radiusB, PLContactManifold *manifold ) {
+	PLVector3 normal, surfaceA, surfaceB;
+	float penetration;
+	if ( !CollideRoundedPoints( a, radiusA, b, radiusB, &normal, &surfaceA, &surfaceB, &penetration ) ) {
+		return false;
+	}
+
+	BeginManifold( manifold, normal );
+	AddContactPoint( manifold, surfaceA, surfaceB, penetration );
+	return true;
+}
+
+static float GetClosestSegmentFraction( PLVector3 start, PLVector3 end, PLVector3 point ) {
+	PLVector3 d = PlSubtractVector3( end, start );
+	float lengthSquared = GetLengthSquared( d );
+	if ( lengthSquared <= FLT_EPSILON ) {
+		return 0.0f;
+	}
+
+	float t = PlVector3DotProduct( PlSubtractVector3( point, start ), d ) / lengthSquared;
+	return ( t < 0.0f ) ? 0.0f : ( ( t > 1.0f ) ? 1.0f : t );
+}
+
+static float ClampFraction( float t ) {
+	return ( t < 0.0f ) ? 0.0f : ( ( t > 1.0f ) ? 1.0f : t );
+}
+
+/* closest points between segments p1-q1 and p2-q2, per Ericson 5.1.9 */
+static void GetClosestSegmentPoints( PLVector3 p1, PLVector3 q1, PLVector3 p2, PLVector3 q2, PLVector3 *c1, PLVector3 *c2 ) {
+	PLVector3 d1 = PlSubtractVector3( q1, p1 ), d2 = PlSubtractVector3( q2, p2 ), r = PlSubtractVector3( p1, p2 );
+	float a = GetLengthSquared( d1 ), e = GetLengthSquared( d2 ), f = PlVector3DotProduct( d2, r );
+	float s, t;
+	if ( a <= FLT_EPSILON && e <= FLT_EPSILON ) {
+		s = t = 0.0f;
+	} else if ( a <= FLT_EPSILON ) {
+		s = 0.0f;
+		t = ClampFraction( f / e );
+	} else {
+		float c = PlVector3DotProduct( d1, r );
+		if ( e <= FLT_EPSILON ) {
+			t = 0.0f;
+			s = ClampFraction( -c / a );
+		} else {
+			float b = PlVector3DotProduct( d1, d2 );
+			float denom = a * e - b * b;
+			s = ( denom > 0.0f ) ? ClampFraction( ( b * f - c * e ) / denom ) : 0.0f;
+			t = ( b * s + f ) / e;
+			if ( t < 0.0f ) {
+				t = 0.0f;
+				s = ClampFraction( -c / a );
+			} else if ( t > 1.0f ) {
+				t = 1.0f;
+				s = ClampFraction( ( b - c ) / a );
+			}
+		}
+	}
+
+	*c1 = MultiplyAddVector3( p1, d1, s );
+	*c2 = MultiplyAddVector3( p2, d2, t );
+}
+
+static bool CollideCapsuleSphere( const PLCollisionCapsule *a, const PLCollisionSphere *b, PLContactManifold *manifold ) {
+	float t = GetClosestSegmentFraction( a->start, a->end, b->origin );
+	PLVector3 point = MultiplyAddVector3( a->start, PlSubtractVector3( a->end, a->start ), t );
+	return CollideRoundedPointsManifold( point, a->radius, b->origin, b->radius, manifold );
+}
+
+static bool CollideCapsules( const PLCollisionCapsule *a, const PLCollisionCapsule *b, PLContactManifold *manifold ) {
+	PLVector3 d1 = PlSubtractVector3( a->end, a->start ), d2 = PlSubtractVector3( b->end, b->start );
+	float l1 = GetLengthSquared( d1 ), l2 = GetLengthSquared( d2 );
+	float crossSquared = GetLengthSquared( PlVector3CrossProduct( d1, d2 ) );
+	if ( l1 > FLT_EPSILON && l2 > FLT_EPSILON && crossSquared <= 1e-6f * l1 * l2 ) {
+		/* lying alongside each other, so hold them at both ends of the overlap */
+		float t0 = PlVector3DotProduct( PlSubtractVector3( b->start, a->start ), d1 ) / l1;
+		float t1 = PlVector3DotProduct( PlSubtractVector3( b->end, a->start ), d1 ) / l1;
+		float lo = ClampFraction( ( t0 < t1 ) ? t0 : t1 ), hi = ClampFraction( ( t0 > t1 ) ? t0 : t1 );
+		if ( lo < hi ) {
+			float ends[ 2 ] = { lo, hi };
+			for ( unsigned int i = 0; i < 2; ++i ) {
+				PLVector3 pointA = MultiplyAddVector3( a->start, d1, ends[ i ] );
+				PLVector3 pointB = MultiplyAddVector3( b->start, d2, GetClosestSegmentFraction( b->start, b->end, pointA ) );
+				PLVector3 normal, surfaceA, surfaceB;
+				float penetration;
+				if ( !CollideRoundedPoints( pointA, a->radius, pointB, b->radius, &normal, &surfaceA, &surfaceB, &penetration ) ) {
+					return false;
+				}
+				if ( i == 0 ) {
+					BeginManifold( manifold, normal );
+				}
+				AddContactPoint( manifold, surfaceA, surfaceB, penetration );
+			}
+			return true;
+		}
+	}
+
+	PLVector3 pointA, pointB;
+	GetClosestSegmentPoints( a->start, a->end, b->start, b->end, &pointA, &pointB );
+	return CollideRoundedPointsManifold( pointA, a->radius, pointB, b->radius, manifold );
+}
+
+/****************************************
+ * Boxes
+ ****************************************/
+
+typedef struct Box {
+	PLVector3 centre;
+	PLVector3 axes[ 3 ];
+	float extents[ 3 ];
+} Box;
+
+static Box GetAabbBox( const PLCollisionAABB *aabb ) {
+	Box box;
+	PLVector3 mins = PlAddVector3( aabb->origin, aabb->mins ), maxs = PlAddVector3( aabb->origin, aabb->maxs );
+	box.centre = GetMidpoint( mins, maxs );
+	box.axes[ 0 ] = PLVector3( 1.0f, 0.0f, 0.0f );
+	box.axes[ 1 ] = PLVector3( 0.0f, 1.0f, 0.0f );
+	box.axes[ 2 ] = PLVector3( 0.0f, 0.0f, 1.0f );
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		box.extents[ i ] = ( PlVector3Index( maxs, i ) - PlVector3Index( mins, i ) ) * 0.5f;
+	}
+	return box;
+}
+
+static Box GetObbBox( const PLCollisionOBB *obb ) {
+	Box box;
+	box.centre = obb->origin;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		box.axes[ i ] = obb->axes[ i ];
+		box.extents[ i ] = PlVector3Index( obb->extents, i );
+	}
+	return box;
+}
+
+/* a sphere against a box in the box's own space */
+static bool CollideSphereBox( const Box *box, PLVector3 centre, float radius, PLContactManifold *manifold ) {
+	PLVector3 local, closest;
+	PLVector3 offset = PlSubtractVector3( centre, box->centre );
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float d = PlVector3DotProduct( offset, box->axes[ i ] );
+		PlVector3Index( local, i ) = d;
+		PlVector3Index( closest, i ) = ( d < -box->extents[ i ] ) ? -box->extents[ i ] : ( ( d > box->extents[ i ] ) ? box->extents[ i ] : d );
+	}
+
+	PLVector3 normal, surfaceA, surfaceB;
+	float penetration;
+	PLVector3 d = PlSubtractVector3( local, closest );
+	float distanceSquared = GetLengthSquared( d );
+	if ( distanceSquared > 0.0f ) {
+		if ( distanceSquared > radius * radius ) {
+			return false;
+		}
+
+		float distance = sqrtf( distanceSquared );
+		normal = PlScaleVector3F( d, -1.0f / distance );
+		surfaceB = closest;
+		penetration = radius - distance;
+	} else {
+		/* centre's inside, so out through the nearest face */
+		unsigned int axis = 0;
+		float nearest = FLT_MAX;
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			float depth = box->extents[ i ] - fabsf( PlVector3Index( local, i ) );
+			if ( depth < nearest ) {
+				nearest = depth;
+				axis = i;
+			}
+		}
+
+		float side = ( PlVector3Index( local, axis ) < 0.0f ) ? -1.0f : 1.0f;
+		normal = pl_vecOrigin3;
+		PlVector3Index( normal, axis ) = -side;
+		surfaceB = local;
+		PlVector3Index( surfaceB, axis ) = side * box->extents[ axis ];
+		penetration = radius + nearest;
+	}
+	surfaceA = MultiplyAddVector3( local, normal, radius );
+
+	/* and back out of the box's space */
+	PLVector3 worldNormal = pl_vecOrigin3, worldA = box->centre, worldB = box->centre;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		worldNormal = MultiplyAddVector3( worldNormal, box->axes[ i ], PlVector3Index( normal, i ) );
+		worldA = MultiplyAddVector3( worldA, box->axes[ i ], PlVector3Index( surfaceA, i ) );
+		worldB = MultiplyAddVector3( worldB, box->axes[ i ], PlVector3Index( surfaceB, i ) );
+	}
+
+	BeginManifold( manifold, worldNormal );
+	AddContactPoint( manifold, worldA, worldB, penetration );
+	return true;
+}
+
+/* keeps polygon on the side of the plane that dot( normal, p ) <= offset */
+static unsigned int ClipPolygon( const PLVector3 *polygon, unsigned int numPoints, PLVector3 normal, float offset, PLVector3 *clipped ) {
+	unsigned int numClipped = 0;
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		PLVector3 a = polygon[ i ], b = polygon[ ( i + 1 ) % numPoints ];
+		float da = PlVector3DotProduct( normal, a ) - offset, db = PlVector3DotProduct( normal, b ) - offset;
+		if ( da <= 0.0f ) {
+			clipped[ numClipped++ ] = a;
+		}
+		if ( ( da < 0.0f && db > 0.0f ) || ( da > 0.0f && db < 0.0f ) ) {
+			clipped[ numClipped++ ] = MultiplyAddVector3( a, PlSubtractVector3( b, a ), da / ( da - db ) );
+		}
+	}
+	return numClipped;
+}
+
+/* incident's face that's most against reference's, clipped to the sides of reference's */
+static void AddBoxFaceContacts( const Box *reference, unsigned int axis, PLVector3 normal, const Box *incident, bool flipped, PLContactManifold *manifold ) {
+	PLVector3 faceCentre = MultiplyAddVector3( reference->centre, normal, reference->extents[ axis ] );
+	unsigned int incidentAxis = 0;
+	float best = -1.0f;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float d = fabsf( PlVector3DotProduct( incident->axes[ i ], normal ) );
+		if ( d > best ) {
+			best = d;
+			incidentAxis = i;
+		}
+	}
+
+	float side = ( PlVector3DotProduct( incident->axes[ incidentAxis ], normal ) > 0.0f ) ? -1.0f : 1.0f;
+	PLVector3 incidentCentre = MultiplyAddVector3( incident->centre, incident->axes[ incidentAxis ], side * incident->extents[ incidentAxis ] );
+	unsigned int u = ( incidentAxis + 1 ) % 3, v = ( incidentAxis + 2 ) % 3;
+	PLVector3 du = PlScaleVector3F( incident->axes[ u ], incident->extents[ u ] ), dv = PlScaleVector3F( incident->axes[ v ], incident->extents[ v ] );
+
+	PLVector3 polygon[ 8 ], clipped[ 8 ];
+	polygon[ 0 ] = PlAddVector3( PlAddVector3( incidentCentre, du ), dv );
+	polygon[ 1 ] = PlAddVector3( PlSubtractVector3( incidentCentre, du ), dv );
+	polygon[ 2 ] = PlSubtractVector3( PlSubtractVector3( incidentCentre, du ), dv );
+	polygon[ 3 ] = PlSubtractVector3( PlAddVector3( incidentCentre, du ), dv );
+	unsigned int numPoints = 4;
+
+	PLVector3 sideAxes[ 2 ] = { reference->axes[ ( axis + 1 ) % 3 ], reference->axes[ ( axis + 2 ) % 3 ] };
+	float sideExtents[ 2 ] = { reference->extents[ ( axis + 1 ) % 3 ], reference->extents[ ( axis + 2 ) % 3 ] };
+	for ( unsigned int i = 0; i < 2 && numPoints > 0; ++i ) {
+		float centre = PlVector3DotProduct( sideAxes[ i ], reference->centre );
+		numPoints = ClipPolygon( polygon, numPoints, sideAxes[ i ], centre + sideExtents[ i ], clipped );
+		numPoints = ClipPolygon( clipped, numPoints, PlScaleVector3F( sideAxes[ i ], -1.0f ), -centre + sideExtents[ i ], polygon );
+	}
+
+	/* anything below the reference face is touching */
+	float faceOffset = PlVector3DotProduct( normal, faceCentre );
+	PLContactPoint points[ 8 ];
+	unsigned int numContacts = 0;
+	for ( unsigned int i = 0; i < numPoints; ++i ) {
+		float separation = PlVector3DotProduct( normal, polygon[ i ] ) - faceOffset;
+		if ( separation <= 0.0f ) {
+			points[ numContacts ].position = MultiplyAddVector3( polygon[ i ], normal, -separation * 0.5f );
+			points[ numContacts++ ].penetration = -separation;
+		}
+	}
+
+	/* if clipping left more than can be kept, keep the ones furthest out on the face */
+	unsigned int keep[ 4 ], numKeep = 0;
+	if ( numContacts > PL_MAX_CONTACT_POINTS ) {
+		for ( unsigned int i = 0; i < 4; ++i ) {
+			PLVector3 direction = PlScaleVector3F( sideAxes[ i / 2 ], ( i & 1 ) ? -1.0f : 1.0f );
+			unsigned int extreme = 0;
+			for ( unsigned int j = 1; j < numContacts; ++j ) {
+				if ( PlVector3DotProduct( direction, points[ j ].position ) > PlVector3DotProduct( direction, points[ extreme ].position ) ) {
+					extreme = j;
+				}
+			}
+			bool isKept = false;
+			for ( unsigned int j = 0; j < numKeep; ++j ) {
+				isKept |= ( keep[ j ] == extreme );
+			}
+			if ( !isKept ) {
+				keep[ numKeep++ ] = extreme;
+			}
+		}
+	} else {
+		for ( ; numKeep < numContacts; ++numKeep ) {
+			keep[ numKeep ] = numKeep;
+		}
+	}
+
+	BeginManifold( manifold, flipped ? PlScaleVector3F( normal, -1.0f ) : normal );
+	for ( unsigned int i = 0; i < numKeep; ++i ) {
+		manifold->points[ manifold->numPoints++ ] = points[ keep[ i ] ];
+	}
+}
+
+/* the edge of box furthest along direction, parallel to the given axis */
+static void GetBoxEdge( const Box *box, unsigned int axis, PLVector3 direction, PLVector3 *start, PLVector3 *end ) {
+	PLVector3 centre = box->centre;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		if ( i != axis ) {
+			float side = ( PlVector3DotProduct( box->axes[ i ], direction ) < 0.0f ) ? -1.0f : 1.0f;
+			centre = MultiplyAddVector3( centre, box->axes[ i ], side * box->extents[ i ] );
+		}
+	}
+
+	*start = MultiplyAddVector3( centre, box->axes[ axis ], -box->extents[ axis ] );
+	*end = MultiplyAddVector3( centre, box->axes[ axis ], box->extents[ axis ] );
+}
+
+/* separating axis test over the 15 candidate axes, then clipping for the contacts */
+static bool CollideBoxes( const Box *a, const Box *b, PLContactManifold *manifold ) {
+	PLVector3 t = PlSubtractVector3( b->centre, a->centre );
+	float r[ 3 ][ 3 ], absR[ 3 ][ 3 ];
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			r[ i ][ j ] = PlVector3DotProduct( a->axes[ i ], b->axes[ j ] );
+			absR[ i ][ j ] = fabsf( r[ i ][ j ] ) + 1e-6f; /* so parallel edges don't produce a bogus axis */
+		}
+	}
+
+	/* faces of a, then faces of b, each only taking over if clearly better */
+	float bestPenetration = FLT_MAX;
+	int bestAxis = -1;
+	PLVector3 bestNormal = fallbackNormal;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float rb = b->extents[ 0 ] * absR[ i ][ 0 ] + b->extents[ 1 ] * absR[ i ][ 1 ] + b->extents[ 2 ] * absR[ i ][ 2 ];
+		float d = PlVector3DotProduct( t, a->axes[ i ] );
+		float penetration = a->extents[ i ] + rb - fabsf( d );
+		if ( penetration < 0.0f ) {
+			return false;
+		}
+		if ( penetration < bestPenetration ) {
+			bestPenetration = penetration;
+			bestAxis = ( int ) i;
+			bestNormal = PlScaleVector3F( a->axes[ i ], ( d < 0.0f ) ? -1.0f : 1.0f );
+		}
+	}
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float ra = a->extents[ 0 ] * absR[ 0 ][ i ] + a->extents[ 1 ] * absR[ 1 ][ i ] + a->extents[ 2 ] * absR[ 2 ][ i ];
+		float d = PlVector3DotProduct( t, b->axes[ i ] );
+		float penetration = ra + b->extents[ i ] - fabsf( d );
+		if ( penetration < 0.0f ) {
+			return false;
+		}
+		if ( penetration < bestPenetration * 0.95f ) {
+			bestPenetration = penetration;
+			bestAxis = 3 + ( int ) i;
+			bestNormal = PlScaleVector3F( b->axes[ i ], ( d < 0.0f ) ? -1.0f : 1.0f );
+		}
+	}
+
+	/* then the edge pairs, worked out in a's space from what's above */
+	float ta[ 3 ] = { PlVector3DotProduct( t, a->axes[ 0 ] ), PlVector3DotProduct( t, a->axes[ 1 ] ), PlVector3DotProduct( t, a->axes[ 2 ] ) };
+	float facePenetration = bestPenetration;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		unsigned int i1 = ( i + 1 ) % 3, i2 = ( i + 2 ) % 3;
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			float lengthSquared = 1.0f - r[ i ][ j ] * r[ i ][ j ];
+			if ( lengthSquared < 1e-6f ) {
+				continue;
+			}
+
+			unsigned int j1 = ( j + 1 ) % 3, j2 = ( j + 2 ) % 3;
+			float ra = a->extents[ i1 ] * absR[ i2 ][ j ] + a->extents[ i2 ] * absR[ i1 ][ j ];
+			float rb = b->extents[ j1 ] * absR[ i ][ j2 ] + b->extents[ j2 ] * absR[ i ][ j1 ];
+			float d = ta[ i2 ] * r[ i1 ][ j ] - ta[ i1 ] * r[ i2 ][ j ];
+			float penetration = ra + rb - fabsf( d );
+			if ( penetration < 0.0f ) {
+				return false;
+			}
+
+			penetration /= sqrtf( lengthSquared );
+			if ( penetration < facePenetration * 0.95f && penetration < bestPenetration ) {
+				bestPenetration = penetration;
+				bestAxis = 6 + ( int ) ( i * 3 + j );
+				bestNormal = PlNormalizeVector3( PlVector3CrossProduct( a->axes[ i ], b->axes[ j ] ) );
+				bestNormal = PlScaleVector3F( bestNormal, ( d < 0.0f ) ? -1.0f : 1.0f );
+			}
+		}
+	}
+
+	if ( bestAxis < 3 ) {
+		AddBoxFaceContacts( a, ( unsigned int ) bestAxis, bestNormal, b, false, manifold );
+	} else if ( bestAxis < 6 ) {
+		AddBoxFaceContacts( b, ( unsigned int ) bestAxis - 3, PlScaleVector3F( bestNormal, -1.0f ), a, true, manifold );
+	} else {
+		PLVector3 startA, endA, startB, endB, pointA, pointB;
+		GetBoxEdge( a, ( unsigned int ) ( bestAxis - 6 ) / 3, bestNormal, &startA, &endA );
+		GetBoxEdge( b, ( unsigned int ) ( bestAxis - 6 ) % 3, PlScaleVector3F( bestNormal, -1.0f ), &startB, &endB );
+		GetClosestSegmentPoints( startA, endA, startB, endB, &pointA, &pointB );
+		BeginManifold( manifold, bestNormal );
+		AddContactPoint( manifold, pointA, pointB, bestPenetration );
+	}
+
+	/* clipping can come up empty on a grazing contact, in which case go by the centres */
+	if ( manifold->numPoints == 0 ) {
+		AddContactPoint( manifold, a->centre, b->centre, bestPenetration );
+	}
+	return true;
+}
+
+/****************************************
+ * GJK and EPA
+ ****************************************/
+
+static PLVector3 GetShapeCentre( const PLCollisionShape *shape ) {
+	switch ( shape->type ) {
+		case PL_COLLISION_SHAPE_SPHERE:
+			return shape->sphere.origin;
+		case PL_COLLISION_SHAPE_AABB:
+			return PlAddVector3( shape->aabb.origin, GetMidpoint( shape->aabb.mins, shape->aabb.maxs ) );
+		case PL_COLLISION_SHAPE_CAPSULE:
+			return GetMidpoint( shape->capsule.start, shape->capsule.end );
+		case PL_COLLISION_SHAPE_OBB:
+			return shape->obb.origin;
+		default:
+			break;
+	}
+
+	PLVector3 centre = pl_vecOrigin3;
+	for ( unsigned int i = 0; i < shape->hull.numVertices; ++i ) {
+		centre = PlAddVector3( centre, shape->hull.vertices[ i ] );
+	}
+	return ( shape->hull.numVertices > 0 ) ? PlAddVector3( shape->hull.origin, PlScaleVector3F( centre, 1.0f / shape->hull.numVertices ) ) : shape->hull.origin;
+}
+
+static float GetShapeRadius( const PLCollisionShape *shape ) {
+	switch ( shape->type ) {
+		case PL_COLLISION_SHAPE_SPHERE:
+			return shape->sphere.radius;
+		case PL_COLLISION_SHAPE_CAPSULE:
+			return shape->capsule.radius;
+		default:
+			return 0.0f;
+	}
+}
+
+/* the point of the shape's core furthest along direction */
+static PLVector3 GetCoreSupport( const PLCollisionShape *shape, PLVector3 direction ) {
+	switch ( shape->type ) {
+		case PL_COLLISION_SHAPE_SPHERE:
+			return shape->sphere.origin;
+		case PL_COLLISION_SHAPE_AABB:
+			return PlAddVector3( shape->aabb.origin, PLVector3( ( direction.x >= 0.0f ) ? shape->aabb.maxs.x : shape->aabb.mins.x,
+			                                                    ( direction.y >= 0.0f ) ? shape->aabb.maxs.y : shape->aabb.mins.y,
+			                                                    ( direction.z >= 0.0f ) ? shape->aabb.maxs.z : shape->aabb.mins.z ) );
+		case PL_COLLISION_SHAPE_CAPSULE:
+			return ( PlVector3DotProduct( direction, PlSubtractVector3( shape->capsule.end, shape->capsule.start ) ) >= 0.0f ) ? shape->capsule.end : shape->capsule.start;
+		case PL_COLLISION_SHAPE_OBB: {
+			PLVector3 point = shape->obb.origin;
+			for ( unsigned int i = 0; i < 3; ++i ) {
+				float extent = PlVector3Index( shape->obb.extents, i );
+				point = MultiplyAddVector3( point, shape->obb.axes[ i ], ( PlVector3DotProduct( direction, shape->obb.axes[ i ] ) >= 0.0f ) ? extent : -extent );
+			}
+			return point;
+		}
+		default:
+			break;
+	}
+
+	unsigned int best = 0;
+	float bestDistance = -FLT_MAX;
+	for ( unsigned int i = 0; i < shape->hull.numVertices; ++i ) {
+		float distance = PlVector3DotProduct( shape->hull.vertices[ i ], direction );
+		if ( distance > bestDistance ) {
+			bestDistance = distance;
+			best = i;
+		}
+	}
+	return ( shape->hull.numVertices > 0 ) ? PlAddVector3( shape->hull.origin, shape->hull.vertices[ best ] ) : shape->hull.origin;
+}
+
+/* a point on the Minkowski difference of the cores, and where it came from on each */
+typedef struct SimplexVertex {
+	PLVector3 w, a, b;
+} SimplexVertex;
+
+typedef struct Simplex {
+	SimplexVertex vertices[ 4 ];
+	float weights[ 4 ];
+	unsigned int numVertices;
+} Simplex;
+
+static SimplexVertex GetSupport( const PLCollisionShape *a, const PLCollisionShape *b, PLVector3 direction ) {
+	SimplexVertex vertex;
+	vertex.a = GetCoreSupport( a, direction );
+	vertex.b = GetCoreSupport( b, PlScaleVector3F( direction, -1.0f ) );
+	vertex.w = PlSubtractVector3( vertex.a, vertex.b );
+	return vertex;
+}
+
+static PLVector3 GetSimplexPoint( const Simplex *simplex ) {
+	PLVector3 point = pl_vecOrigin3;
+	for ( unsigned int i = 0; i < simplex->numVertices; ++i ) {
+		point = MultiplyAddVector3( point, simplex->vertices[ i ].w, simplex->weights[ i ] );
+	}
+	return point;
+}
+
+static void SetSimplexVertex( Simplex *simplex, SimplexVertex vertex ) {
+	simplex->vertices[ 0 ] = vertex;
+	simplex->weights[ 0 ] = 1.0f;
+	simplex->numVertices = 1;
+}
+
+static void SetSimplexSegment( Simplex *simplex, SimplexVertex a, SimplexVertex b, float t ) {
+	simplex->vertices[ 0 ] = a;
+	simplex->vertices[ 1 ] = b;
+	simplex->weights[ 0 ] = 1.0f - t;
+	simplex->weights[ 1 ] = t;
+	simplex->numVertices = 2;
+}
+
+/* each of these reduces the simplex to the part closest to the origin */
+static void SolveSegment( Simplex *simplex ) {
+	SimplexVertex a = simplex->vertices[ 0 ], b = simplex->vertices[ 1 ];
+	PLVector3 ab = PlSubtractVector3( b.w, a.w );
+	float lengthSquared = GetLengthSquared( ab );
+	float t = ( lengthSquared > 0.0f ) ? -PlVector3DotProduct( a.w, ab ) / lengthSquared : 0.0f;
+	if ( t <= 0.0f ) {
+		SetSimplexVertex( simplex, a );
+	} else if ( t >= 1.0f ) {
+		SetSimplexVertex( simplex, b );
+	} else {
+		SetSimplexSegment( simplex, a, b, t );
+	}
+}
+
+/* Ericson 5.1.5, with the origin as the point */
+static void SolveTriangle( Simplex *simplex ) {
+	SimplexVertex va = simplex->vertices[ 0 ], vb = simplex->vertices[ 1 ], vc = simplex->vertices[ 2 ];
+	PLVector3 a = va.w, b = vb.w, c = vc.w;
+	PLVector3 ab = PlSubtractVector3( b, a ), ac = PlSubtractVector3( c, a );
+
+	float d1 = -PlVector3DotProduct( ab, a ), d2 = -PlVector3DotProduct( ac, a );
+	if ( d1 <= 0.0f && d2 <= 0.0f ) {
+		SetSimplexVertex( simplex, va );
+		return;
+	}
+
+	float d3 = -PlVector3DotProduct( ab, b ), d4 = -PlVector3DotProduct( ac, b );
+	if ( d3 >= 0.0f && d4 <= d3 ) {
+		SetSimplexVertex( simplex, vb );
+		return;
+	}
+
+	float vC = d1 * d4 - d3 * d2;
+	if ( vC <= 0.0f && d1 >= 0.0f && d3 <= 0.0f ) {
+		SetSimplexSegment( simplex, va, vb, ( d1 - d3 > 0.0f ) ? d1 / ( d1 - d3 ) : 0.0f );
+		return;
+	}
+
+	float d5 = -PlVector3DotProduct( ab, c ), d6 = -PlVector3DotProduct( ac, c );
+	if ( d6 >= 0.0f && d5 <= d6 ) {
+		SetSimplexVertex( simplex, vc );
+		return;
+	}
+
+	float vB = d5 * d2 - d1 * d6;
+	if ( vB <= 0.0f && d2 >= 0.0f && d6 <= 0.0f ) {
+		SetSimplexSegment( simplex, va, vc, ( d2 - d6 > 0.0f ) ? d2 / ( d2 - d6 ) : 0.0f );
+		return;
+	}
+
+	float vA = d3 * d6 - d5 * d4;
+	if ( vA <= 0.0f && ( d4 - d3 ) >= 0.0f && ( d5 - d6 ) >= 0.0f ) {
+		float denom = ( d4 - d3 ) + ( d5 - d6 );
+		SetSimplexSegment( simplex, vb, vc, ( denom > 0.0f ) ? ( d4 - d3 ) / denom : 0.0f );
+		return;
+	}
+
+	float denom = vA + vB + vC;
+	if ( denom <= 0.0f ) {
+		/* flat, so settle for the closest edge */
+		Simplex edges[ 3 ];
+		SetSimplexSegment( &edges[ 0 ], va, vb, 0.0f );
+		SetSimplexSegment( &edges[ 1 ], va, vc, 0.0f );
+		SetSimplexSegment( &edges[ 2 ], vb, vc, 0.0f );
+		unsigned int best = 0;
+		float bestDistance = FLT_MAX;
+		for ( unsigned int i = 0; i < 3; ++i ) {
+			SolveSegment( &edges[ i ] );
+			float distance = GetLengthSquared( GetSimplexPoint( &edges[ i ] ) );
+			if ( distance < bestDistance ) {
+				bestDistance = distance;
+				best = i;
+			}
+		}
+		*simplex = edges[ best ];
+		return;
+	}
+
+	simplex->weights[ 1 ] = vB / denom;
+	simplex->weights[ 2 ] = vC / denom;
+	simplex->weights[ 0 ] = 1.0f - simplex->weights[ 1 ] - simplex->weights[ 2 ];
+}
+
+/* returns false if the origin's inside */
+static bool SolveTetrahedron( Simplex *simplex ) {
+	static const unsigned int faces[ 4 ][ 4 ] = {
+	        /* face, then the vertex opposite */
+	        { 0, 1, 2, 3 },
+	        { 0, 2, 3, 1 },
+	        { 0, 3, 1, 2 },
+	        { 1, 3, 2, 0 },
+	};
+
+	const SimplexVertex *v = simplex->vertices;
+	PLVector3 ab = PlSubtractVector3( v[ 1 ].w, v[ 0 ].w ), ac = PlSubtractVector3( v[ 2 ].w, v[ 0 ].w ), ad = PlSubtractVector3( v[ 3 ].w, v[ 0 ].w );
+	float volume = PlVector3DotProduct( ad, PlVector3CrossProduct( ab, ac ) );
+	float scale = GetLengthSquared( ab ) + GetLengthSquared( ac ) + GetLengthSquared( ad );
+	bool isFlat = fabsf( volume ) <= 1e-7f * scale * sqrtf( scale );
+
+	Simplex best;
+	float bestDistance = FLT_MAX;
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		PLVector3 a = v[ faces[ i ][ 0 ] ].w, b = v[ faces[ i ][ 1 ] ].w, c = v[ faces[ i ][ 2 ] ].w;
+		PLVector3 normal = PlVector3CrossProduct( PlSubtractVector3( b, a ), PlSubtractVector3( c, a ) );
+		float origin = -PlVector3DotProduct( a, normal );
+		float opposite = PlVector3DotProduct( PlSubtractVector3( v[ faces[ i ][ 3 ] ].w, a ), normal );
+		if ( !isFlat && origin * opposite >= 0.0f ) {
+			continue;
+		}
+
+		Simplex face;
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			face.vertices[ j ] = v[ faces[ i ][ j ] ];
+		}
+		face.numVertices = 3;
+		SolveTriangle( &face );
+		float distance = GetLengthSquared( GetSimplexPoint( &face ) );
+		if ( distance < bestDistance ) {
+			bestDistance = distance;
+			best = face;
+		}
+	}
+
+	if ( bestDistance == FLT_MAX ) {
+		return false;
+	}
+
+	*simplex = best;
+	return true;
+}
+
+typedef enum GjkResult {
+	GJK_SEPARATED, /* further apart than the margin */
+	GJK_CLOSEST,
+	GJK_OVERLAPPING,
+} GjkResult;
+
+static GjkResult RunGjk( const PLCollisionShape *a, const PLCollisionShape *b, float margin, Simplex *simplex ) {
+	PLVector3 direction = PlSubtractVector3( GetShapeCentre( b ), GetShapeCentre( a ) );
+	if ( GetLengthSquared( direction ) == 0.0f ) {
+		direction = fallbackNormal;
+	}
+	SetSimplexVertex( simplex, GetSupport( a, b, PlScaleVector3F( direction, -1.0f ) ) );
+
+	PLVector3 v = simplex->vertices[ 0 ].w;
+	float scale = GetLengthSquared( v );
+	for ( unsigned int iteration = 0; iteration < GJK_MAX_ITERATIONS; ++iteration ) {
+		float vv = GetLengthSquared( v );
+		if ( vv <= 1e-12f * scale ) {
+			return GJK_OVERLAPPING;
+		}
+
+		SimplexVertex vertex = GetSupport( a, b, PlScaleVector3F( v, -1.0f ) );
+		float vw = PlVector3DotProduct( v, vertex.w );
+		if ( vw > 0.0f && vw * vw > vv * margin * margin ) {
+			return GJK_SEPARATED;
+		}
+		if ( vv - vw <= 1e-6f * vv ) {
+			return GJK_CLOSEST;
+		}
+		for ( unsigned int i = 0; i < simplex->numVertices; ++i ) {
+			if ( PlCompareVector3( &simplex->vertices[ i ].w, &vertex.w ) ) {
+				return GJK_CLOSEST;
+			}
+		}
+
+		simplex->vertices[ simplex->numVertices++ ] = vertex;
+		switch ( simplex->numVertices ) {
+			case 2:
+				SolveSegment( simplex );
+				break;
+			case 3:
+				SolveTriangle( simplex );
+				break;
+			default:
+				if ( !SolveTetrahedron( simplex ) ) {
+					return GJK_OVERLAPPING;
+				}
+				break;
+		}
+
+		PLVector3 next = GetSimplexPoint( simplex );
+		if ( GetLengthSquared( next ) >= vv ) {
+			return GJK_CLOSEST; /* no longer getting any closer */
+		}
+		v = next;
+		if ( GetLengthSquared( vertex.w ) > scale ) {
+			scale = GetLengthSquared( vertex.w );
+		}
+	}
+
+	return GJK_CLOSEST;
+}
+
+typedef struct EpaFace {
+	unsigned int vertices[ 3 ];
+	PLVector3 normal;
+	float distance;
+} EpaFace;
+
+typedef struct EpaPolytope {
+	SimplexVertex vertices[ EPA_MAX_VERTICES ];
+	unsigned int numVertices;
+	EpaFace faces[ EPA_MAX_FACES ];
+	unsigned int numFaces;
+} EpaPolytope;
+
+static bool AddEpaFace( EpaPolytope *polytope, unsigned int a, unsigned int b, unsigned int c ) {
+	if ( polytope->numFaces >= EPA_MAX_FACES ) {
+		return false;
+	}
+
+	PLVector3 va = polytope->vertices[ a ].w;
+	PLVector3 normal = PlVector3CrossProduct( PlSubtractVector3( polytope->vertices[ b ].w, va ), PlSubtractVector3( polytope->vertices[ c ].w, va ) );
+	float length = PlVector3Length( normal );
+	if ( length <= FLT_EPSILON ) {
+		return false;
+	}
+
+	EpaFace *face = &polytope->faces[ polytope->numFaces++ ];
+	face->vertices[ 0 ] = a;
+	face->vertices[ 1 ] = b;
+	face->vertices[ 2 ] = c;
+	face->normal = PlScaleVector3F( normal, 1.0f / length );
+	face->distance = PlVector3DotProduct( face->normal, va );
+	return true;
+}
+
+/* GJK can finish on anything from a point to a tetrahedron, but EPA needs the latter */
+static bool ExpandSimplex( const PLCollisionShape *a, const PLCollisionShape *b, Simplex *simplex ) {
+	static const PLVector3 axes[ 6 ] = {
+	        { 1.0f, 0.0f, 0.0f },
+	        { -1.0f, 0.0f, 0.0f },
+	        { 0.0f, 1.0f, 0.0f },
+	        { 0.0f, -1.0f, 0.0f },
+	        { 0.0f, 0.0f, 1.0f },
+	        { 0.0f, 0.0f, -1.0f },
+	};
+
+	SimplexVertex *v = simplex->vertices;
+	if ( simplex->numVertices == 1 ) {
+		for ( unsigned int i = 0; i < 6 && simplex->numVertices == 1; ++i ) {
+			SimplexVertex vertex = GetSupport( a, b, axes[ i ] );
+			if ( GetLengthSquared( PlSubtractVector3( vertex.w, v[ 0 ].w ) ) > FLT_EPSILON ) {
+				v[ simplex->numVertices++ ] = vertex;
+			}
+		}
+	}
+	if ( simplex->numVertices == 2 ) {
+		PLVector3 d = PlSubtractVector3( v[ 1 ].w, v[ 0 ].w );
+		for ( unsigned int i = 0; i < 6 && simplex->numVertices == 2; ++i ) {
+			PLVector3 perpendicular = PlVector3CrossProduct( d, axes[ i ] );
+			if ( GetLengthSquared( perpendicular ) <= FLT_EPSILON ) {
+				continue;
+			}
+			SimplexVertex vertex = GetSupport( a, b, perpendicular );
+			if ( GetLengthSquared( PlVector3CrossProduct( d, PlSubtractVector3( vertex.w, v[ 0 ].w ) ) ) > FLT_EPSILON ) {
+				v[ simplex->numVertices++ ] = vertex;
+			}
+		}
+	}
+	if ( simplex->numVertices == 3 ) {
+		PLVector3 normal = PlVector3CrossProduct( PlSubtractVector3( v[ 1 ].w, v[ 0 ].w ), PlSubtractVector3( v[ 2 ].w, v[ 0 ].w ) );
+		for ( unsigned int i = 0; i < 2 && simplex->numVertices == 3; ++i ) {
+			SimplexVertex vertex = GetSupport( a, b, PlScaleVector3F( normal, i ? -1.0f : 1.0f ) );
+			if ( fabsf( PlVector3DotProduct( PlSubtractVector3( vertex.w, v[ 0 ].w ), normal ) ) > FLT_EPSILON ) {
+				v[ simplex->numVertices++ ] = vertex;
+			}
+		}
+	}
+
+	return simplex->numVertices == 4;
+}
+
+static void AddHorizonEdge( unsigned int ( *edges )[ 2 ], unsigned int *numEdges, unsigned int a, unsigned int b ) {
+	/* an edge shared between two removed faces isn't on the horizon */
+	for ( unsigned int i = 0; i < *numEdges; ++i ) {
+		if ( edges[ i ][ 0 ] == b && edges[ i ][ 1 ] == a ) {
+			edges[ i ][ 0 ] = edges[ *numEdges - 1 ][ 0 ];
+			edges[ i ][ 1 ] = edges[ *numEdges - 1 ][ 1 ];
+			( *numEdges )--;
+			return;
+		}
+	}
+
+	edges[ *numEdges ][ 0 ] = a;
+	edges[ *numEdges ][ 1 ] = b;
+	( *numEdges )++;
+}
+
+/* finds the shallowest way out for overlapping cores; normal from a to b */
+static bool RunEpa( const PLCollisionShape *a, const PLCollisionShape *b, Simplex *simplex, PLVector3 *normal, float *depth, PLVector3 *pointA, PLVector3 *pointB ) {
+	if ( !ExpandSimplex( a, b, simplex ) ) {
+		return false;
+	}
+
+	EpaPolytope polytope;
+	polytope.numVertices = 4;
+	polytope.numFaces = 0;
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		polytope.vertices[ i ] = simplex->vertices[ i ];
+	}
+
+	/* wind the tetrahedron outwards */
+	PLVector3 *w[ 4 ] = { &polytope.vertices[ 0 ].w, &polytope.vertices[ 1 ].w, &polytope.vertices[ 2 ].w, &polytope.vertices[ 3 ].w };
+	if ( PlVector3DotProduct( PlSubtractVector3( *w[ 3 ], *w[ 0 ] ), PlVector3CrossProduct( PlSubtractVector3( *w[ 1 ], *w[ 0 ] ), PlSubtractVector3( *w[ 2 ], *w[ 0 ] ) ) ) > 0.0f ) {
+		SimplexVertex swap = polytope.vertices[ 1 ];
+		polytope.vertices[ 1 ] = polytope.vertices[ 2 ];
+		polytope.vertices[ 2 ] = swap;
+	}
+	if ( !AddEpaFace( &polytope, 0, 1, 2 ) || !AddEpaFace( &polytope, 0, 3, 1 ) || !AddEpaFace( &polytope, 0, 2, 3 ) || !AddEpaFace( &polytope, 1, 3, 2 ) ) {
+		return false;
+	}
+
+	const EpaFace *closest = NULL;
+	for ( unsigned int iteration = 0; iteration < EPA_MAX_ITERATIONS; ++iteration ) {
+		closest = &polytope.faces[ 0 ];
+		for ( unsigned int i = 1; i < polytope.numFaces; ++i ) {
+			if ( polytope.faces[ i ].distance < closest->distance ) {
+				closest = &polytope.faces[ i ];
+			}
+		}
+
+		SimplexVertex vertex = GetSupport( a, b, closest->normal );
+		float distance = PlVector3DotProduct( vertex.w, closest->normal );
+		if ( distance - closest->distance <= EPA_TOLERANCE * ( 1.0f + fabsf( distance ) ) || polytope.numVertices >= EPA_MAX_VERTICES ) {
+			break;
+		}
+
+		unsigned int newVertex = polytope.numVertices++;
+		polytope.vertices[ newVertex ] = vertex;
+
+		unsigned int edges[ EPA_MAX_FACES * 3 ][ 2 ], numEdges = 0;
+		for ( unsigned int i = polytope.numFaces; i-- > 0; ) {
+			EpaFace *face = &polytope.faces[ i ];
+			if ( PlVector3DotProduct( face->normal, PlSubtractVector3( vertex.w, polytope.vertices[ face->vertices[ 0 ] ].w ) ) <= 0.0f ) {
+				continue;
+			}
+			for ( unsigned int j = 0; j < 3; ++j ) {
+				AddHorizonEdge( edges, &numEdges, face->vertices[ j ], face->vertices[ ( j + 1 ) % 3 ] );
+			}
+			*face = polytope.faces[ --polytope.numFaces ];
+		}
+
+		bool isComplete = true;
+		for ( unsigned int i = 0; i < numEdges && isComplete; ++i ) {
+			isComplete = AddEpaFace( &polytope, edges[ i ][ 0 ], edges[ i ][ 1 ], newVertex );
+		}
+		closest = NULL;
+		if ( !isComplete || polytope.numFaces == 0 ) {
+			return false;
+		}
+	}
+
+	if ( closest == NULL ) {
+		closest = &polytope.faces[ 0 ];
+		for ( unsigned int i = 1; i < polytope.numFaces; ++i ) {
+			if ( polytope.faces[ i ].distance < closest->distance ) {
+				closest = &polytope.faces[ i ];
+			}
+		}
+	}
+
+	/* where the origin projects onto the face, as weights of its corners */
+	Simplex face;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		face.vertices[ i ] = polytope.vertices[ closest->vertices[ i ] ];
+	}
+	PLVector3 p = PlScaleVector3F( closest->normal, closest->distance );
+	PLVector3 v0 = PlSubtractVector3( face.vertices[ 1 ].w, face.vertices[ 0 ].w ), v1 = PlSubtractVector3( face.vertices[ 2 ].w, face.vertices[ 0 ].w ), v2 = PlSubtractVector3( p, face.vertices[ 0 ].w );
+	float d00 = PlVector3DotProduct( v0, v0 ), d01 = PlVector3DotProduct( v0, v1 ), d11 = PlVector3DotProduct( v1, v1 );
+	float d20 = PlVector3DotProduct( v2, v0 ), d21 = PlVector3DotProduct( v2, v1 );
+	float denom = d00 * d11 - d01 * d01;
+	face.weights[ 1 ] = ( denom != 0.0f ) ? ( d11 * d20 - d01 * d21 ) / denom : 0.0f;
+	face.weights[ 2 ] = ( denom != 0.0f ) ? ( d00 * d21 - d01 * d20 ) / denom : 0.0f;
+	face.weights[ 0 ] = 1.0f - face.weights[ 1 ] - face.weights[ 2 ];
+
+	*normal = closest->normal;
+	*depth = closest->distance;
+	*pointA = *pointB = pl_vecOrigin3;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		*pointA = MultiplyAddVector3( *pointA, face.vertices[ i ].a, face.weights[ i ] );
+		*pointB = MultiplyAddVector3( *pointB, face.vertices[ i ].b, face.weights[ i ] );
+	}
+	return true;
+}
+
+static bool CollideConvex( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	float radiusA = GetShapeRadius( a ), radiusB = GetShapeRadius( b );
+	float margin = radiusA + radiusB;
+
+	Simplex simplex;
+	GjkResult result = RunGjk( a, b, margin, &simplex );
+	if ( result == GJK_SEPARATED ) {
+		return false;
+	}
+
+	PLVector3 normal, pointA, pointB;
+	float penetration;
+	if ( result == GJK_CLOSEST ) {
+		PLVector3 v = GetSimplexPoint( &simplex );
+		float distance = PlVector3Length( v );
+		if ( distance > margin ) {
+			return false;
+		}
+
+		pointA = pointB = pl_vecOrigin3;
+		for ( unsigned int i = 0; i < simplex.numVertices; ++i ) {
+			pointA = MultiplyAddVector3( pointA, simplex.vertices[ i ].a, simplex.weights[ i ] );
+			pointB = MultiplyAddVector3( pointB, simplex.vertices[ i ].b, simplex.weights[ i ] );
+		}
+		if ( distance > 1e-6f * ( 1.0f + margin ) ) {
+			normal = PlScaleVector3F( v, -1.0f / distance );
+			penetration = margin - distance;
+		} else {
+			result = GJK_OVERLAPPING; /* touching cores, so no direction to go on */
+		}
+	}
+
+	if ( result == GJK_OVERLAPPING ) {
+		float depth;
+		if ( !RunEpa( a, b, &simplex, &normal, &depth, &pointA, &pointB ) ) {
+			/* flat or degenerate shapes, so fall back on the centres */
+			pointA = GetShapeCentre( a );
+			pointB = GetShapeCentre( b );
+			PLVector3 d = PlSubtractVector3( pointB, pointA );
+			float length = PlVector3Length( d );
+			normal = ( length > FLT_EPSILON ) ? PlScaleVector3F( d, 1.0f / length ) : fallbackNormal;
+			depth = 0.0f;
+		}
+		penetration = depth + margin;
+	}
+
+	BeginManifold( manifold, normal );
+	AddContactPoint( manifold, MultiplyAddVector3( pointA, normal, radiusA ), MultiplyAddVector3( pointB, normal, -radiusB ), penetration );
+	return true;
+}
+
+/****************************************
+ * Dispatch
+ ****************************************/
+
+typedef bool ( *CollideFunction )( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold );
+
+static bool CollideSphereSphereShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	return PlCollideSpheres( &a->sphere, &b->sphere, manifold );
+}
+
+static bool CollideSphereAabbShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	return PlCollideSphereAabb( &a->sphere, &b->aabb, manifold );
+}
+
+static bool CollideSphereObbShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	Box box = GetObbBox( &b->obb );
+	return CollideSphereBox( &box, a->sphere.origin, a->sphere.radius, manifold );
+}
+
+static bool CollideAabbAabbShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	return PlCollideAabbs( &a->aabb, &b->aabb, manifold );
+}
+
+static bool CollideBoxShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	Box boxA = ( a->type == PL_COLLISION_SHAPE_AABB ) ? GetAabbBox( &a->aabb ) : GetObbBox( &a->obb );
+	Box boxB = ( b->type == PL_COLLISION_SHAPE_AABB ) ? GetAabbBox( &b->aabb ) : GetObbBox( &b->obb );
+	return CollideBoxes( &boxA, &boxB, manifold );
+}
+
+static bool CollideCapsuleSphereShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	return CollideCapsuleSphere( &a->capsule, &b->sphere, manifold );
+}
+
+static bool CollideCapsuleShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	return CollideCapsules( &a->capsule, &b->capsule, manifold );
+}
+
+/* indexed by the types of a and b; swapped ones are done the other way around */
+static const struct {
+	CollideFunction Collide;
+	bool swap;
+} collideFunctions[ PL_NUM_COLLISION_SHAPES ][ PL_NUM_COLLISION_SHAPES ] = {
+        /* sphere */
+        {
+                { CollideSphereSphereShapes, false },
+                { CollideSphereAabbShapes, false },
+                { CollideCapsuleSphereShapes, true },
+                { CollideSphereObbShapes, false },
+                { CollideConvex, false },
+        },
+        /* aabb */
+        {
+                { CollideSphereAabbShapes, true },
+                { CollideAabbAabbShapes, false },
+                { CollideConvex, false },
+                { CollideBoxShapes, false },
+                { CollideConvex, false },
+        },
+        /* capsule */
+        {
+                { CollideCapsuleSphereShapes, false },
+                { CollideConvex, false },
+                { CollideCapsuleShapes, false },
+                { CollideConvex, false },
+                { CollideConvex, false },
+        },
+        /* obb */
+        {
+                { CollideSphereObbShapes, true },
+                { CollideBoxShapes, false },
+                { CollideConvex, false },
+                { CollideBoxShapes, false },
+                { CollideConvex, false },
+        },
+        /* hull */
+        {
+                { CollideConvex, false },
+                { CollideConvex, false },
+                { CollideConvex, false },
+                { CollideConvex, false },
+                { CollideConvex, false },
+        },
+};
+
+/****************************************
+ * PUBLIC
+ ****************************************/
+
+bool PlCollideSpheres( const PLCollisionSphere *a, const PLCollisionSphere *b, PLContactManifold *manifold ) {
+	return CollideRoundedPointsManifold( a->origin, a->radius, b->origin, b->radius, manifold );
+}
+
+bool PlCollideSphereAabb( const PLCollisionSphere *a, const PLCollisionAABB *b, PLContactManifold *manifold ) {
+	Box box = GetAabbBox( b );
+	return CollideSphereBox( &box, a->origin, a->radius, manifold );
+}
+
+/**
+ * Pushes out along whichever axis needs the least, with a point at each
+ * corner of where the two overlap.
+ */
+bool PlCollideAabbs( const PLCollisionAABB *a, const PLCollisionAABB *b, PLContactManifold *manifold ) {
+	PLVector3 aMins = PlAddVector3( a->origin, a->mins ), aMaxs = PlAddVector3( a->origin, a->maxs );
+	PLVector3 bMins = PlAddVector3( b->origin, b->mins ), bMaxs = PlAddVector3( b->origin, b->maxs );
+
+	unsigned int axis = 0;
+	float penetration = FLT_MAX, side = 1.0f;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float forward = PlVector3Index( aMaxs, i ) - PlVector3Index( bMins, i );
+		float backward = PlVector3Index( bMaxs, i ) - PlVector3Index( aMins, i );
+		if ( forward < 0.0f || backward < 0.0f ) {
+			return false;
+		}
+		if ( forward < penetration ) {
+			penetration = forward;
+			axis = i;
+			side = 1.0f;
+		}
+		if ( backward < penetration ) {
+			penetration = backward;
+			axis = i;
+			side = -1.0f;
+		}
+	}
+
+	PLVector3 normal = pl_vecOrigin3;
+	PlVector3Index( normal, axis ) = side;
+	BeginManifold( manifold, normal );
+
+	unsigned int u = ( axis + 1 ) % 3, v = ( axis + 2 ) % 3;
+	float us[ 2 ] = { fmaxf( PlVector3Index( aMins, u ), PlVector3Index( bMins, u ) ), fminf( PlVector3Index( aMaxs, u ), PlVector3Index( bMaxs, u ) ) };
+	float vs[ 2 ] = { fmaxf( PlVector3Index( aMins, v ), PlVector3Index( bMins, v ) ), fminf( PlVector3Index( aMaxs, v ), PlVector3Index( bMaxs, v ) ) };
+	/* halfway between the faces pushing against each other */
+	float plane = ( ( side > 0.0f ) ? ( PlVector3Index( aMaxs, axis ) + PlVector3Index( bMins, axis ) ) : ( PlVector3Index( aMins, axis ) + PlVector3Index( bMaxs, axis ) ) ) * 0.5f;
+	for ( unsigned int i = 0; i < 4; ++i ) {
+		/* skipping corners that coincide, for edges and corners just touching */
+		if ( ( ( i & 1 ) && us[ 0 ] == us[ 1 ] ) || ( ( i & 2 ) && vs[ 0 ] == vs[ 1 ] ) ) {
+			continue;
+		}
+
+		PLContactPoint *point = &manifold->points[ manifold->numPoints++ ];
+		PlVector3Index( point->position, axis ) = plane;
+		PlVector3Index( point->position, u ) = us[ i & 1 ];
+		PlVector3Index( point->position, v ) = vs[ ( i >> 1 ) & 1 ];
+		point->penetration = penetration;
+	}
+
+	return true;
+}
+
+/**
+ * World space bounds of the shape, in the same form as
+ * PlGenerateAabbFromCoords, for handing to a broadphase.
+ */
+PLCollisionAABB PlGetCollisionShapeBounds( const PLCollisionShape *shape ) {
+	PLVector3 mins, maxs;
+	switch ( shape->type ) {
+		case PL_COLLISION_SHAPE_SPHERE:
+			mins = PlSubtractVector3F( shape->sphere.origin, shape->sphere.radius );
+			maxs = PlAddVector3F( shape->sphere.origin, shape->sphere.radius );
+			break;
+		case PL_COLLISION_SHAPE_AABB:
+			mins = PlAddVector3( shape->aabb.origin, shape->aabb.mins );
+			maxs = PlAddVector3( shape->aabb.origin, shape->aabb.maxs );
+			break;
+		case PL_COLLISION_SHAPE_CAPSULE:
+			mins = PlSubtractVector3F( PlVector3Min( shape->capsule.start, shape->capsule.end ), shape->capsule.radius );
+			maxs = PlAddVector3F( PlVector3Max( shape->capsule.start, shape->capsule.end ), shape->capsule.radius );
+			break;
+		case PL_COLLISION_SHAPE_OBB: {
+			PLVector3 extent = pl_vecOrigin3;
+			for ( unsigned int i = 0; i < 3; ++i ) {
+				const PLVector3 *axis = &shape->obb.axes[ i ];
+				extent = MultiplyAddVector3( extent, PLVector3( fabsf( axis->x ), fabsf( axis->y ), fabsf( axis->z ) ), PlVector3Index( shape->obb.extents, i ) );
+			}
+			mins = PlSubtractVector3( shape->obb.origin, extent );
+			maxs = PlAddVector3( shape->obb.origin, extent );
+			break;
+		}
+		default:
+			mins = maxs = shape->hull.origin;
+			for ( unsigned int i = 0; i < shape->hull.numVertices; ++i ) {
+				PLVector3 vertex = PlAddVector3( shape->hull.origin, shape->hull.vertices[ i ] );
+				mins = PlVector3Min( mins, vertex );
+				maxs = PlVector3Max( maxs, vertex );
+			}
+			break;
+	}
+
+	PLCollisionAABB bounds;
+	bounds.origin = pl_vecOrigin3;
+	bounds.mins = mins;
+	bounds.maxs = maxs;
+	bounds.absOrigin = GetMidpoint( mins, maxs );
+	return bounds;
+}
+
+/**
+ * Picks the test for the pair of shapes; returns false, leaving the
+ * manifold alone, if they aren't touching.
+ */
+bool PlCollideShapes( const PLCollisionShape *a, const PLCollisionShape *b, PLContactManifold *manifold ) {
+	if ( ( unsigned int ) a->type >= PL_NUM_COLLISION_SHAPES ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM1, "invalid shape type (%d)", a->type );
+		return false;
+	} else if ( ( unsigned int ) b->type >= PL_NUM_COLLISION_SHAPES ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid shape type (%d)", b->type );
+		return false;
+	}
+
+	if ( !collideFunctions[ a->type ][ b->type ].swap ) {
+		return collideFunctions[ a->type ][ b->type ].Collide( a, b, manifold );
+	}
+
+	if ( !collideFunctions[ a->type ][ b->type ].Collide( b, a, manifold ) ) {
+		return false;
+	}
+
+	manifold->normal = PlScaleVector3F( manifold->normal, -1.0f );
+	return true;
+}
+
+/**
+ * Collides each pair, as from PlGetBroadphasePairs, where shapes is
+ * indexed by proxy. Only pairs that are touching get a manifold, so
+ * manifolds needs room for numPairs at most; returns how many were written.
+ */
+unsigned int PlCollideShapePairs( const PLCollisionShape *shapes, const PLBroadphasePair *pairs, unsigned int numPairs, PLContactManifold *manifolds ) {
+	unsigned int numManifolds = 0;
+	for ( unsigned int i = 0; i < numPairs; ++i ) {
+		PLContactManifold *manifold = &manifolds[ numManifolds ];
+		if ( PlCollideShapes( &shapes[ pairs[ i ].proxyA ], &shapes[ pairs[ i ].proxyB ], manifold ) ) {
+			manifold->pair = pairs[ i ];
+			numManifolds++;
+		}
+	}
+
+	return numManifolds;
+}
@@ -0,0 +1,843 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include "pl_private.h"
+
+#include <plcore/pl_physics.h>
+
+#include <float.h>
+
+/* Dynamic AABB tree, after Box2D's b2DynamicTree. Leaves are proxies, and
+ * every internal node has exactly two children. Inserting picks a sibling
+ * by surface area heuristic, and the tree is kept balanced by rotating on
+ * the way back up. Proxy handles are just node indices. */
+
+#define NULL_NODE -1
+
+/* how far ahead to grow the bounds of something moving, per displacement */
+#define DISPLACEMENT_MULTIPLIER 2.0f
+
+typedef struct TreeNode {
+	PLVector3 mins, maxs;
+	void *userData;
+	int parent; /* or the next free node, while on the free list */
+	int children[ 2 ];
+	int height; /* 0 for leaves, -1 if free */
+} TreeNode;
+
+typedef struct PLAabbTree {
+	TreeNode *nodes;
+	int numNodes, maxNodes;
+	int freeList;
+	int root;
+	float margin;
+	unsigned int numProxies;
+} PLAabbTree;
+
+#define IS_LEAF( NODE ) ( ( NODE )->children[ 0 ] == NULL_NODE )
+
+/****************************************
+ * Node Management
+ ****************************************/
+
+static void LinkFreeNodes( PLAabbTree *tree, int first ) {
+	for ( int i = first; i < tree->maxNodes - 1; ++i ) {
+		tree->nodes[ i ].parent = i + 1;
+		tree->nodes[ i ].height = -1;
+	}
+	tree->nodes[ tree->maxNodes - 1 ].parent = NULL_NODE;
+	tree->nodes[ tree->maxNodes - 1 ].height = -1;
+	tree->freeList = first;
+}
+
+static int AllocateNode( PLAabbTree *tree ) {
+	if ( tree->freeList == NULL_NODE ) {
+		int first = tree->maxNodes;
+		tree->maxNodes *= 2;
+		tree->nodes = pl_realloc( tree->nodes, sizeof( TreeNode ) * tree->maxNodes );
+		LinkFreeNodes( tree, first );
+	}
+
+	int node = tree->freeList;
+	TreeNode *n = &tree->nodes[ node ];
+	tree->freeList = n->parent;
+	n->parent = NULL_NODE;
+	n->children[ 0 ] = n->children[ 1 ] = NULL_NODE;
+	n->height = 0;
+	n->userData = NULL;
+	tree->numNodes++;
+	return node;
+}
+
+static void FreeNode( PLAabbTree *tree, int node ) {
+	tree->nodes[ node ].parent = tree->freeList;
+	tree->nodes[ node ].height = -1;
+	tree->freeList = node;
+	tree->numNodes--;
+}
+
+static bool IsValidProxy( const PLAabbTree *tree, unsigned int proxy ) {
+	if ( proxy >= ( unsigned int ) tree->maxNodes || tree->nodes[ proxy ].height != 0 ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid proxy (%u)", proxy );
+		return false;
+	}
+
+	return true;
+}
+
+/****************************************
+ * Bounds
+ ****************************************/
+
+/* half the surface area, which is all the heuristic needs */
+static float GetArea( PLVector3 mins, PLVector3 maxs ) {
+	PLVector3 d = PlSubtractVector3( maxs, mins );
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static float GetCombinedArea( const TreeNode *a, const TreeNode *b ) {
+	return GetArea( PlVector3Min( a->mins, b->mins ), PlVector3Max( a->maxs, b->maxs ) );
+}
+
+static void CombineBounds( TreeNode *node, const TreeNode *a, const TreeNode *b ) {
+	node->mins = PlVector3Min( a->mins, b->mins );
+	node->maxs = PlVector3Max( a->maxs, b->maxs );
+}
+
+static bool ContainsBounds( PLVector3 mins, PLVector3 maxs, PLVector3 innerMins, PLVector3 innerMaxs ) {
+	return mins.x <= innerMins.x && mins.y <= innerMins.y && mins.z <= innerMins.z &&
+	       maxs.x >= innerMaxs.x && maxs.y >= innerMaxs.y && maxs.z >= innerMaxs.z;
+}
+
+static bool OverlapsBounds( const TreeNode *node, PLVector3 mins, PLVector3 maxs ) {
+	return !( node->maxs.x < mins.x || node->maxs.y < mins.y || node->maxs.z < mins.z ||
+	          node->mins.x > maxs.x || node->mins.y > maxs.y || node->mins.z > maxs.z );
+}
+
+static void GetWorldBounds( const PLCollisionAABB *bounds, PLVector3 *mins, PLVector3 *maxs ) {
+	*mins = PlAddVector3( bounds->mins, bounds->origin );
+	*maxs = PlAddVector3( bounds->maxs, bounds->origin );
+}
+
+static void SetFatBounds( const PLAabbTree *tree, TreeNode *node, const PLCollisionAABB *bounds ) {
+	GetWorldBounds( bounds, &node->mins, &node->maxs );
+	node->mins = PlSubtractVector3( node->mins, PLVector3( tree->margin, tree->margin, tree->margin ) );
+	node->maxs = PlAddVector3( node->maxs, PLVector3( tree->margin, tree->margin, tree->margin ) );
+}
+
+/****************************************
+ * Structure
+ ****************************************/
+
+static void ReplaceChild( PLAabbTree *tree, int parent, int oldChild, int newChild ) {
+	if ( parent == NULL_NODE ) {
+		tree->root = newChild;
+		return;
+	}
+
+	TreeNode *p = &tree->nodes[ parent ];
+	p->children[ p->children[ 0 ] == oldChild ? 0 : 1 ] = newChild;
+}
+
+static void UpdateNode( PLAabbTree *tree, int node ) {
+	TreeNode *n = &tree->nodes[ node ];
+	const TreeNode *a = &tree->nodes[ n->children[ 0 ] ];
+	const TreeNode *b = &tree->nodes[ n->children[ 1 ] ];
+	CombineBounds( n, a, b );
+	n->height = 1 + ( a->height > b->height ? a->height : b->height );
+}
+
+/**
+ * If one side of the given node is more than a level taller than the other,
+ * rotates the taller child up into its place. Returns whichever node ends
+ * up where the given one was.
+ */
+static int Balance( PLAabbTree *tree, int iA ) {
+	TreeNode *nodes = tree->nodes;
+	TreeNode *a = &nodes[ iA ];
+	if ( IS_LEAF( a ) || a->height < 2 ) {
+		return iA;
+	}
+
+	int balance = nodes[ a->children[ 1 ] ].height - nodes[ a->children[ 0 ] ].height;
+	if ( balance >= -1 && balance <= 1 ) {
+		return iA;
+	}
+
+	/* the taller child takes a's place, a takes one of its children, and
+	 * it keeps the taller of its own two */
+	int side = ( balance > 1 ) ? 1 : 0;
+	int iC = a->children[ side ];
+	TreeNode *c = &nodes[ iC ];
+	int iF = c->children[ 0 ], iG = c->children[ 1 ];
+	if ( nodes[ iF ].height > nodes[ iG ].height ) {
+		int t = iF;
+		iF = iG;
+		iG = t;
+	}
+
+	c->parent = a->parent;
+	ReplaceChild( tree, c->parent, iA, iC );
+	c->children[ 0 ] = iA;
+	c->children[ 1 ] = iG;
+	a->parent = iC;
+	a->children[ side ] = iF;
+	nodes[ iF ].parent = iA;
+
+	UpdateNode( tree, iA );
+	UpdateNode( tree, iC );
+	return iC;
+}
+
+static void RefitAncestors( PLAabbTree *tree, int node ) {
+	while ( node != NULL_NODE ) {
+		node = Balance( tree, node );
+		UpdateNode( tree, node );
+		node = tree->nodes[ node ].parent;
+	}
+}
+
+static void InsertLeaf( PLAabbTree *tree, int leaf ) {
+	TreeNode *nodes = tree->nodes;
+	if ( tree->root == NULL_NODE ) {
+		tree->root = leaf;
+		nodes[ leaf ].parent = NULL_NODE;
+		return;
+	}
+
+	/* work down to the cheapest sibling; pairing with any node means growing
+	 * all of its ancestors, so that's carried down as we go */
+	const TreeNode *l = &nodes[ leaf ];
+	int index = tree->root;
+	while ( !IS_LEAF( &nodes[ index ] ) ) {
+		const TreeNode *n = &nodes[ index ];
+		float area = GetArea( n->mins, n->maxs );
+		float combinedArea = GetCombinedArea( n, l );
+
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * ( combinedArea - area );
+
+		float childCosts[ 2 ];
+		for ( unsigned int i = 0; i < 2; ++i ) {
+			const TreeNode *child = &nodes[ n->children[ i ] ];
+			childCosts[ i ] = GetCombinedArea( child, l ) + inheritanceCost;
+			if ( !IS_LEAF( child ) ) {
+				childCosts[ i ] -= GetArea( child->mins, child->maxs );
+			}
+		}
+
+		if ( cost < childCosts[ 0 ] && cost < childCosts[ 1 ] ) {
+			break;
+		}
+
+		index = n->children[ ( childCosts[ 0 ] < childCosts[ 1 ] ) ? 0 : 1 ];
+	}
+
+	int sibling = index;
+	int oldParent = nodes[ sibling ].parent;
+	int newParent = AllocateNode( tree );
+	nodes = tree->nodes; /* may have moved */
+
+	nodes[ newParent ].parent = oldParent;
+	nodes[ newParent ].children[ 0 ] = sibling;
+	nodes[ newParent ].children[ 1 ] = leaf;
+	ReplaceChild( tree, oldParent, sibling, newParent );
+	nodes[ sibling ].parent = newParent;
+	nodes[ leaf ].parent = newParent;
+
+	RefitAncestors( tree, newParent );
+}
+
+static void RemoveLeaf( PLAabbTree *tree, int leaf ) {
+	TreeNode *nodes = tree->nodes;
+	if ( leaf == tree->root ) {
+		tree->root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[ leaf ].parent;
+	int grandParent = nodes[ parent ].parent;
+	int sibling = nodes[ parent ].children[ nodes[ parent ].children[ 0 ] == leaf ? 1 : 0 ];
+
+	ReplaceChild( tree, grandParent, parent, sibling );
+	nodes[ sibling ].parent = grandParent;
+	FreeNode( tree, parent );
+
+	RefitAncestors( tree, grandParent );
+}
+
+/****************************************
+ * Traversal
+ ****************************************/
+
+/* nodes still to visit, on the stack unless the tree turns out deep */
+typedef struct StackEntry {
+	int node;
+	float distance;
+	unsigned int planes;
+} StackEntry;
+
+typedef struct NodeStack {
+	StackEntry *entries;
+	unsigned int num, max;
+	StackEntry local[ 64 ];
+} NodeStack;
+
+static void InitNodeStack( NodeStack *stack ) {
+	stack->entries = stack->local;
+	stack->num = 0;
+	stack->max = plArrayElements( stack->local );
+}
+
+static void PushNode( NodeStack *stack, int node, float distance, unsigned int planes ) {
+	if ( stack->num == stack->max ) {
+		stack->max *= 2;
+		if ( stack->entries == stack->local ) {
+			stack->entries = pl_malloc( sizeof( StackEntry ) * stack->max );
+			memcpy( stack->entries, stack->local, sizeof( stack->local ) );
+		} else {
+			stack->entries = pl_realloc( stack->entries, sizeof( StackEntry ) * stack->max );
+		}
+	}
+
+	stack->entries[ stack->num++ ] = ( StackEntry ){ node, distance, planes };
+}
+
+static void FreeNodeStack( NodeStack *stack ) {
+	if ( stack->entries != stack->local ) {
+		pl_free( stack->entries );
+	}
+}
+
+/* walks the subtree under node, stopping if the callback asks */
+static bool QueryOverlaps( const PLAabbTree *tree, int node, PLVector3 mins, PLVector3 maxs, PLAabbTreeQueryCallback callback, void *parm ) {
+	NodeStack stack;
+	InitNodeStack( &stack );
+	PushNode( &stack, node, 0.0f, 0 );
+
+	bool carryOn = true;
+	while ( carryOn && stack.num > 0 ) {
+		int index = stack.entries[ --stack.num ].node;
+		const TreeNode *n = &tree->nodes[ index ];
+		if ( !OverlapsBounds( n, mins, maxs ) ) {
+			continue;
+		}
+
+		if ( IS_LEAF( n ) ) {
+			carryOn = callback( ( unsigned int ) index, n->userData, parm );
+		} else {
+			PushNode( &stack, n->children[ 0 ], 0.0f, 0 );
+			PushNode( &stack, n->children[ 1 ], 0.0f, 0 );
+		}
+	}
+
+	FreeNodeStack( &stack );
+	return carryOn;
+}
+
+/****************************************
+ * Public
+ ****************************************/
+
+/**
+ * Creates an empty tree. Proxies are stored with their bounds grown by
+ * margin on every side.
+ */
+PLAabbTree *PlCreateAabbTree( float margin ) {
+	PLAabbTree *tree = pl_calloc( 1, sizeof( PLAabbTree ) );
+	tree->margin = margin;
+	tree->maxNodes = 16;
+	tree->nodes = pl_malloc( sizeof( TreeNode ) * tree->maxNodes );
+	PlClearAabbTree( tree );
+	return tree;
+}
+
+void PlDestroyAabbTree( PLAabbTree *tree ) {
+	if ( tree == NULL ) {
+		return;
+	}
+
+	pl_free( tree->nodes );
+	pl_free( tree );
+}
+
+/**
+ * Removes every proxy, keeping the memory for reuse.
+ */
+void PlClearAabbTree( PLAabbTree *tree ) {
+	LinkFreeNodes( tree, 0 );
+	tree->root = NULL_NODE;
+	tree->numNodes = 0;
+	tree->numProxies = 0;
+}
+
+unsigned int PlInsertAabbTreeProxy( PLAabbTree *tree, const PLCollisionAABB *bounds, void *userData ) {
+	int leaf = AllocateNode( tree );
+	TreeNode *n = &tree->nodes[ leaf ];
+	SetFatBounds( tree, n, bounds );
+	n->userData = userData;
+	InsertLeaf( tree, leaf );
+	tree->numProxies++;
+	return ( unsigned int ) leaf;
+}
+
+void PlRemoveAabbTreeProxy( PLAabbTree *tree, unsigned int proxy ) {
+	if ( !IsValidProxy( tree, proxy ) ) {
+		return;
+	}
+
+	RemoveLeaf( tree, ( int ) proxy );
+	FreeNode( tree, ( int ) proxy );
+	tree->numProxies--;
+}
+
+/**
+ * Updates a proxy that's moved by displacement since it was last updated.
+ * Nothing happens unless it's moved outside of its fattened bounds (or
+ * those have become far too large), in which case it's reinserted with them
+ * stretched ahead in the direction it's going. Returns true if the tree was
+ * changed.
+ */
+bool PlMoveAabbTreeProxy( PLAabbTree *tree, unsigned int proxy, const PLCollisionAABB *bounds, PLVector3 displacement ) {
+	if ( !IsValidProxy( tree, proxy ) ) {
+		return false;
+	}
+
+	TreeNode fat;
+	SetFatBounds( tree, &fat, bounds );
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float d = PlVector3Index( displacement, i ) * DISPLACEMENT_MULTIPLIER;
+		if ( d < 0.0f ) {
+			PlVector3Index( fat.mins, i ) += d;
+		} else {
+			PlVector3Index( fat.maxs, i ) += d;
+		}
+	}
+
+	TreeNode *n = &tree->nodes[ proxy ];
+	PLVector3 mins, maxs;
+	GetWorldBounds( bounds, &mins, &maxs );
+	if ( ContainsBounds( n->mins, n->maxs, mins, maxs ) ) {
+		float huge = 4.0f * tree->margin;
+		PLVector3 hugeMins = PlSubtractVector3( fat.mins, PLVector3( huge, huge, huge ) );
+		PLVector3 hugeMaxs = PlAddVector3( fat.maxs, PLVector3( huge, huge, huge ) );
+		if ( ContainsBounds( hugeMins, hugeMaxs, n->mins, n->maxs ) ) {
+			return false;
+		}
+	}
+
+	RemoveLeaf( tree, ( int ) proxy );
+	n->mins = fat.mins;
+	n->maxs = fat.maxs;
+	InsertLeaf( tree, ( int ) proxy );
+	return true;
+}
+
+/**
+ * Changes the bounds of a proxy without touching the rest of the tree, for
+ * when a lot of things are moving at once. PlRefitAabbTree must be called
+ * once they're all done, and before the tree is used for anything else.
+ */
+void PlSetAabbTreeProxyBounds( PLAabbTree *tree, unsigned int proxy, const PLCollisionAABB *bounds ) {
+	if ( !IsValidProxy( tree, proxy ) ) {
+		return;
+	}
+
+	SetFatBounds( tree, &tree->nodes[ proxy ], bounds );
+}
+
+static void RefitNode( PLAabbTree *tree, int node ) {
+	TreeNode *n = &tree->nodes[ node ];
+	if ( IS_LEAF( n ) ) {
+		return;
+	}
+
+	RefitNode( tree, n->children[ 0 ] );
+	RefitNode( tree, n->children[ 1 ] );
+	CombineBounds( n, &tree->nodes[ n->children[ 0 ] ], &tree->nodes[ n->children[ 1 ] ] );
+}
+
+/**
+ * Recalculates the bounds of every node from the proxies up, keeping the
+ * structure as it is. Much cheaper than reinserting everything, though the
+ * tree will get worse to search as things move further from where they
+ * were inserted.
+ */
+void PlRefitAabbTree( PLAabbTree *tree ) {
+	if ( tree->root != NULL_NODE ) {
+		RefitNode( tree, tree->root );
+	}
+}
+
+void *PlGetAabbTreeProxyUserData( const PLAabbTree *tree, unsigned int proxy ) {
+	if ( !IsValidProxy( tree, proxy ) ) {
+		return NULL;
+	}
+
+	return tree->nodes[ proxy ].userData;
+}
+
+/**
+ * Fetches the proxy's bounds as they're stored, i.e. fattened.
+ */
+void PlGetAabbTreeProxyBounds( const PLAabbTree *tree, unsigned int proxy, PLVector3 *mins, PLVector3 *maxs ) {
+	if ( !IsValidProxy( tree, proxy ) ) {
+		return;
+	}
+
+	*mins = tree->nodes[ proxy ].mins;
+	*maxs = tree->nodes[ proxy ].maxs;
+}
+
+unsigned int PlGetAabbTreeNumProxies( const PLAabbTree *tree ) {
+	return tree->numProxies;
+}
+
+unsigned int PlGetAabbTreeHeight( const PLAabbTree *tree ) {
+	return ( tree->root == NULL_NODE ) ? 0 : ( unsigned int ) tree->nodes[ tree->root ].height;
+}
+
+/**
+ * Calls back for every proxy overlapping the given bounds.
+ */
+void PlQueryAabbTree( const PLAabbTree *tree, const PLCollisionAABB *bounds, PLAabbTreeQueryCallback callback, void *parm ) {
+	if ( tree->root == NULL_NODE ) {
+		return;
+	}
+
+	PLVector3 mins, maxs;
+	GetWorldBounds( bounds, &mins, &maxs );
+	QueryOverlaps( tree, tree->root, mins, maxs, callback, parm );
+}
+
+/* slab test, giving the distance to where the ray enters the node */
+static bool IntersectRayNode( const TreeNode *node, const PLCollisionRay *ray, PLVector3 invDirection, float maxDistance, float *distance ) {
+	float enter = 0.0f, leave = maxDistance;
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		float o = PlVector3Index( ray->origin, i ), d = PlVector3Index( invDirection, i );
+		float t1 = ( PlVector3Index( node->mins, i ) - o ) * d;
+		float t2 = ( PlVector3Index( node->maxs, i ) - o ) * d;
+		enter = fmaxf( enter, fminf( t1, t2 ) );
+		leave = fminf( leave, fmaxf( t1, t2 ) );
+	}
+
+	*distance = enter;
+	return enter <= leave;
+}
+
+/**
+ * Calls back for every proxy the ray passes through within maxDistance,
+ * with the distance to where it enters, in multiples of the direction; so
+ * for a segment, pass the start as the origin, the end minus the start as
+ * the direction and 1 for maxDistance. Nearer proxies tend to come first,
+ * but that isn't guaranteed. The callback returns how far along the ray to
+ * search from then on: maxDistance to carry on as before, the distance to
+ * its own hit to only look for anything closer, or 0 to stop.
+ */
+void PlRaycastAabbTree( const PLAabbTree *tree, const PLCollisionRay *ray, float maxDistance, PLAabbTreeRayCallback callback, void *parm ) {
+	if ( tree->root == NULL_NODE ) {
+		return;
+	}
+
+	PLVector3 invDirection = PLVector3( 1.0f / ray->direction.x, 1.0f / ray->direction.y, 1.0f / ray->direction.z );
+
+	NodeStack stack;
+	InitNodeStack( &stack );
+
+	float distance;
+	if ( IntersectRayNode( &tree->nodes[ tree->root ], ray, invDirection, maxDistance, &distance ) ) {
+		PushNode( &stack, tree->root, distance, 0 );
+	}
+
+	while ( stack.num > 0 && maxDistance > 0.0f ) {
+		StackEntry entry = stack.entries[ --stack.num ];
+		if ( entry.distance > maxDistance ) {
+			continue;
+		}
+
+		const TreeNode *n = &tree->nodes[ entry.node ];
+		if ( IS_LEAF( n ) ) {
+			maxDistance = callback( ( unsigned int ) entry.node, n->userData, entry.distance, parm );
+			continue;
+		}
+
+		/* push the nearer child last, so it's visited first */
+		float distances[ 2 ];
+		bool hits[ 2 ];
+		for ( unsigned int i = 0; i < 2; ++i ) {
+			hits[ i ] = IntersectRayNode( &tree->nodes[ n->children[ i ] ], ray, invDirection, maxDistance, &distances[ i ] );
+		}
+		unsigned int nearer = ( distances[ 1 ] < distances[ 0 ] ) ? 1 : 0;
+		if ( hits[ nearer ^ 1 ] ) {
+			PushNode( &stack, n->children[ nearer ^ 1 ], distances[ nearer ^ 1 ], 0 );
+		}
+		if ( hits[ nearer ] ) {
+			PushNode( &stack, n->children[ nearer ], distances[ nearer ], 0 );
+		}
+	}
+
+	FreeNodeStack( &stack );
+}
+
+/**
+ * Calls back for every proxy that's at least partly on the inside of all
+ * the given planes (i.e. where PlGetPlaneDotProduct is positive), such as
+ * a PLGCamera's frustum. No more than 32 planes can be used. Once a node
+ * is found to be entirely inside a plane, its children aren't tested
+ * against it again.
+ */
+void PlQueryAabbTreeFrustum( const PLAabbTree *tree, const PLVector4 *planes, unsigned int numPlanes, PLAabbTreeQueryCallback callback, void *parm ) {
+	if ( numPlanes > 32 ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM3, "too many planes (%u > 32)", numPlanes );
+		return;
+	}
+
+	if ( tree->root == NULL_NODE ) {
+		return;
+	}
+
+	NodeStack stack;
+	InitNodeStack( &stack );
+	PushNode( &stack, tree->root, 0.0f, ( numPlanes == 32 ) ? ~0U : ( ( 1U << numPlanes ) - 1 ) );
+
+	bool carryOn = true;
+	while ( carryOn && stack.num > 0 ) {
+		StackEntry entry = stack.entries[ --stack.num ];
+		const TreeNode *n = &tree->nodes[ entry.node ];
+
+		PLVector3 centre = PlScaleVector3F( PlAddVector3( n->mins, n->maxs ), 0.5f );
+		PLVector3 extents = PlScaleVector3F( PlSubtractVector3( n->maxs, n->mins ), 0.5f );
+		bool outside = false;
+		for ( unsigned int i = 0; i < numPlanes; ++i ) {
+			if ( !( entry.planes & ( 1U << i ) ) ) {
+				continue;
+			}
+
+			const PLVector4 *p = &planes[ i ];
+			float d = PlGetPlaneDotProduct( p, &centre );
+			float r = fabsf( p->x ) * extents.x + fabsf( p->y ) * extents.y + fabsf( p->z ) * extents.z;
+			if ( d + r < 0.0f ) {
+				outside = true;
+				break;
+			}
+			if ( d - r >= 0.0f ) {
+				entry.planes &= ~( 1U << i );
+			}
+		}
+
+		if ( outside ) {
+			continue;
+		}
+
+		if ( IS_LEAF( n ) ) {
+			carryOn = callback( ( unsigned int ) entry.node, n->userData, parm );
+		} else {
+			PushNode( &stack, n->children[ 0 ], 0.0f, entry.planes );
+			PushNode( &stack, n->children[ 1 ], 0.0f, entry.planes );
+		}
+	}
+
+	FreeNodeStack( &stack );
+}
+
+typedef struct PairQuery {
+	int proxy;
+	PLAabbTreePairCallback callback;
+	void *parm;
+} PairQuery;
+
+static bool ReportPair( unsigned int proxy, void *userData, void *parm ) {
+	PairQuery *query = parm;
+	if ( ( int ) proxy > query->proxy ) {
+		query->callback( ( unsigned int ) query->proxy, proxy, query->parm );
+	}
+
+	return true;
+}
+
+/**
+ * Calls back once for every pair of proxies with overlapping bounds, with
+ * the lower numbered proxy first.
+ */
+void PlGetAabbTreeOverlapPairs( const PLAabbTree *tree, PLAabbTreePairCallback callback, void *parm ) {
+	PairQuery query = { NULL_NODE, callback, parm };
+	for ( int i = 0; i < tree->maxNodes; ++i ) {
+		const TreeNode *n = &tree->nodes[ i ];
+		if ( n->height != 0 ) {
+			continue;
+		}
+
+		query.proxy = i;
+		QueryOverlaps( tree, tree->root, n->mins, n->maxs, ReportPair, &query );
+	}
+}
+
+/****************************************
+ * Static Build
+ ****************************************/
+
+/* Top-down build, splitting by binned surface area heuristic on the
+ * centres of the bounds. Much better than building incrementally, but
+ * only for everything at once. */
+
+#define SAH_BINS 16
+
+typedef struct SahBin {
+	PLVector3 mins, maxs;
+	unsigned int num;
+} SahBin;
+
+static void ClearSahBin( SahBin *bin ) {
+	bin->mins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX );
+	bin->maxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	bin->num = 0;
+}
+
+static void AddToSahBin( SahBin *bin, const TreeNode *node ) {
+	bin->mins = PlVector3Min( bin->mins, node->mins );
+	bin->maxs = PlVector3Max( bin->maxs, node->maxs );
+	bin->num++;
+}
+
+static PLVector3 GetNodeCentre( const TreeNode *node ) {
+	return PlScaleVector3F( PlAddVector3( node->mins, node->maxs ), 0.5f );
+}
+
+static unsigned int GetSahBin( float centre, float min, float scale ) {
+	int bin = ( int ) ( ( centre - min ) * scale );
+	return ( bin < 0 ) ? 0 : ( bin >= SAH_BINS ) ? SAH_BINS - 1 : ( unsigned int ) bin;
+}
+
+static int BuildNode( PLAabbTree *tree, int *leaves, unsigned int num ) {
+	if ( num == 1 ) {
+		return leaves[ 0 ];
+	}
+
+	PLVector3 centreMins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX );
+	PLVector3 centreMaxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	for ( unsigned int i = 0; i < num; ++i ) {
+		PLVector3 c = GetNodeCentre( &tree->nodes[ leaves[ i ] ] );
+		centreMins = PlVector3Min( centreMins, c );
+		centreMaxs = PlVector3Max( centreMaxs, c );
+	}
+
+	/* find the cheapest split between bins along any axis */
+	float bestCost = FLT_MAX;
+	unsigned int bestAxis = 0, bestSplit = 0;
+	for ( unsigned int axis = 0; axis < 3; ++axis ) {
+		float min = PlVector3Index( centreMins, axis ), extent = PlVector3Index( centreMaxs, axis ) - min;
+		if ( extent <= 0.0f ) {
+			continue;
+		}
+
+		SahBin bins[ SAH_BINS ];
+		for ( unsigned int i = 0; i < SAH_BINS; ++i ) {
+			ClearSahBin( &bins[ i ] );
+		}
+		float scale = SAH_BINS / extent;
+		for ( unsigned int i = 0; i < num; ++i ) {
+			const TreeNode *n = &tree->nodes[ leaves[ i ] ];
+			PLVector3 c = GetNodeCentre( n );
+			AddToSahBin( &bins[ GetSahBin( PlVector3Index( c, axis ), min, scale ) ], n );
+		}
+
+		/* sweep from the right to get the cost of everything above each split,
+		 * then from the left to add on everything below */
+		float rightCosts[ SAH_BINS ];
+		SahBin sweep;
+		ClearSahBin( &sweep );
+		for ( unsigned int i = SAH_BINS - 1; i > 0; --i ) {
+			if ( bins[ i ].num > 0 ) {
+				sweep.mins = PlVector3Min( sweep.mins, bins[ i ].mins );
+				sweep.maxs = PlVector3Max( sweep.maxs, bins[ i ].maxs );
+				sweep.num += bins[ i ].num;
+			}
+			rightCosts[ i ] = ( sweep.num > 0 ) ? GetArea( sweep.mins, sweep.maxs ) * sweep.num : 0.0f;
+		}
+
+		ClearSahBin( &sweep );
+		for ( unsigned int i = 1; i < SAH_BINS; ++i ) {
+			if ( bins[ i - 1 ].num > 0 ) {
+				sweep.mins = PlVector3Min( sweep.mins, bins[ i - 1 ].mins );
+				sweep.maxs = PlVector3Max( sweep.maxs, bins[ i - 1 ].maxs );
+				sweep.num += bins[ i - 1 ].num;
+			}
+			if ( sweep.num == 0 || sweep.num == num ) {
+				continue;
+			}
+
+			float cost = GetArea( sweep.mins, sweep.maxs ) * sweep.num + rightCosts[ i ];
+			if ( cost < bestCost ) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	/* partition, or if everything's in the same place, just halve it */
+	unsigned int mid = num / 2;
+	if ( bestCost < FLT_MAX ) {
+		float min = PlVector3Index( centreMins, bestAxis );
+		float scale = SAH_BINS / ( PlVector3Index( centreMaxs, bestAxis ) - min );
+		unsigned int i = 0, j = num;
+		while ( i < j ) {
+			PLVector3 c = GetNodeCentre( &tree->nodes[ leaves[ i ] ] );
+			if ( GetSahBin( PlVector3Index( c, bestAxis ), min, scale ) < bestSplit ) {
+				i++;
+			} else {
+				int t = leaves[ i ];
+				leaves[ i ] = leaves[ --j ];
+				leaves[ j ] = t;
+			}
+		}
+		mid = i;
+	}
+
+	int left = BuildNode( tree, leaves, mid );
+	int right = BuildNode( tree, leaves + mid, num - mid );
+
+	int node = AllocateNode( tree );
+	tree->nodes[ node ].children[ 0 ] = left;
+	tree->nodes[ node ].children[ 1 ] = right;
+	tree->nodes[ left ].parent = node;
+	tree->nodes[ right ].parent = node;
+	UpdateNode( tree, node );
+	return node;
+}
+
+/**
+ * Replaces the contents of the tree with the given bounds, building it in
+ * one go for the best layout; this is the way to go for anything that's not
+ * going to move. The proxy for each is the same as its index, and userData
+ * may be NULL. Proxies can still be inserted and removed afterwards.
+ */
+void PlBuildAabbTree( PLAabbTree *tree, const PLCollisionAABB *bounds, void *const *userData, unsigned int numBounds ) {
+	PlClearAabbTree( tree );
+	if ( numBounds == 0 ) {
+		return;
+	}
+
+	/* make room for all of the nodes up front, so the leaves come first */
+	if ( tree->maxNodes < ( int ) numBounds * 2 ) {
+		tree->maxNodes = ( int ) numBounds * 2;
+		tree->nodes = pl_realloc( tree->nodes, sizeof( TreeNode ) * tree->maxNodes );
+		LinkFreeNodes( tree, 0 );
+	}
+
+	int *leaves = pl_malloc( sizeof( int ) * numBounds );
+	for ( unsigned int i = 0; i < numBounds; ++i ) {
+		leaves[ i ] = AllocateNode( tree );
+		SetFatBounds( tree, &tree->nodes[ leaves[ i ] ], &bounds[ i ] );
+		tree->nodes[ leaves[ i ] ].userData = ( userData != NULL ) ? userData[ i ] : NULL;
+	}
+
+	tree->root = BuildNode( tree, leaves, numBounds );
+	tree->nodes[ tree->root ].parent = NULL_NODE;
+	tree->numProxies = numBounds;
+
+	pl_free( leaves );
+}
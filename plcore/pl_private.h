@@ -7,6 +7,7 @@
 #pragma once
 
 #include <plcore/pl.h>
+#include <plcore/pl_profiler.h>
 
 #if defined( _MSC_VER )
 #pragma warning( disable : 4204 )
@@ -47,6 +48,20 @@ extern int LOG_LEVEL_FILESYSTEM;
 
 #define FunctionStart() PlClearError()
 
+static inline PLSimdLevel _plGetKernelLevel( PLSimdLevel level, bool hasSse2, bool hasAvx2 ) {
+	if ( level >= PL_SIMD_LEVEL_AVX2 && hasAvx2 ) {
+		return PL_SIMD_LEVEL_AVX2;
+	} else if ( level >= PL_SIMD_LEVEL_SSE2 && hasSse2 ) {
+		return PL_SIMD_LEVEL_SSE2;
+	}
+
+	return PL_SIMD_LEVEL_NONE;
+}
+
+/* picks the highest level kernel available from a table indexed by PLSimdLevel, falling back towards scalar */
+#define PL_SELECT_SIMD_KERNEL( KERNELS, LEVEL ) \
+	( ( KERNELS )[ _plGetKernelLevel( ( LEVEL ), ( KERNELS )[ PL_SIMD_LEVEL_SSE2 ] != NULL, ( KERNELS )[ PL_SIMD_LEVEL_AVX2 ] != NULL ) ] )
+
 /* * * * * * * * * * * * * * * * * * * */
 /* Sub Systems                         */
 
@@ -56,6 +71,14 @@ void PlShutdownFileSystem( void );
 PLFunctionResult PlInitConsole( void );
 void PlShutdownConsole( void );
 
+void PlShutdownProfiler( void );
+
+const char *_plGetLogLevelPrefix( int id );
+
+bool _plIsBinaryLogEnabled( void );
+void _plAddBinaryLogLevel( int id, const char *prefix );
+size_t _plRecordBinaryLogMessage( int level, const char *msg, va_list args );
+
 void PlInitPackageSubSystem( void );
 
 /* * * * * * * * * * * * * * * * * * * */
@@ -0,0 +1,295 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include <plcore/pl_profiler.h>
+#include <plcore/pl_thread.h>
+
+#include "pl_private.h"
+
+/* Each thread appends completed zones into its own chain of fixed-size chunks
+ * and publishes the new count afterwards, so writing the trace out can walk
+ * every thread's events without stalling any of them. */
+
+#define PROFILE_CHUNK_EVENTS 4096
+#define PROFILE_MAX_DEPTH    64
+
+enum {
+	PROFILE_EVENT_ZONE,
+	PROFILE_EVENT_COUNTER,
+};
+
+typedef struct ProfileEvent {
+	const char *name;
+	uint64_t start;
+	int64_t value; /* duration for zones */
+	uint8_t type;
+} ProfileEvent;
+
+typedef struct ProfileChunk {
+	ProfileEvent events[ PROFILE_CHUNK_EVENTS ];
+	struct ProfileChunk *next;
+} ProfileChunk;
+
+typedef struct ProfileThread {
+	uint32_t id;
+	ProfileChunk *firstChunk;
+	ProfileChunk *lastChunk;
+	volatile int64_t numEvents;
+
+	/* only touched by the owning thread */
+	const char *zoneNames[ PROFILE_MAX_DEPTH ];
+	uint64_t zoneStarts[ PROFILE_MAX_DEPTH ];
+	unsigned int depth;
+	unsigned int overflow;
+
+	struct ProfileThread *next;
+} ProfileThread;
+
+static struct {
+	volatile int32_t isEnabled;
+	volatile int32_t generation;
+	uint64_t baseTime;
+	PLMutex *mutex;
+	ProfileThread *threads;
+	uint32_t numThreads;
+} profiler = { .generation = 1 };
+
+static PL_THREAD_LOCAL ProfileThread *profileThread = NULL;
+static PL_THREAD_LOCAL int32_t profileGeneration = 0;
+
+static ProfileThread *GetProfileThread( void ) {
+	int32_t generation = PlAtomicLoad32( &profiler.generation );
+	if ( profileThread != NULL && profileGeneration == generation ) {
+		return profileThread;
+	}
+
+	ProfileThread *thread = pl_calloc( 1, sizeof( ProfileThread ) );
+	if ( thread == NULL ) {
+		return NULL;
+	}
+
+	if ( ( thread->firstChunk = thread->lastChunk = pl_calloc( 1, sizeof( ProfileChunk ) ) ) == NULL ) {
+		pl_free( thread );
+		return NULL;
+	}
+
+	PlLockMutex( profiler.mutex );
+	thread->id = ++profiler.numThreads;
+	thread->next = profiler.threads;
+	profiler.threads = thread;
+	PlUnlockMutex( profiler.mutex );
+
+	profileThread = thread;
+	profileGeneration = generation;
+
+	return thread;
+}
+
+static void PushProfileEvent( ProfileThread *thread, uint8_t type, const char *name, uint64_t start, int64_t value ) {
+	int64_t index = thread->numEvents;
+	unsigned int slot = ( unsigned int ) ( index % PROFILE_CHUNK_EVENTS );
+	if ( slot == 0 && index > 0 ) {
+		ProfileChunk *chunk = pl_calloc( 1, sizeof( ProfileChunk ) );
+		if ( chunk == NULL ) {
+			return;
+		}
+
+		thread->lastChunk->next = chunk;
+		thread->lastChunk = chunk;
+	}
+
+	ProfileEvent *event = &thread->lastChunk->events[ slot ];
+	event->name = name;
+	event->start = start;
+	event->value = value;
+	event->type = type;
+
+	PlAtomicStore64( &thread->numEvents, index + 1 );
+}
+
+/**
+ * Starts or stops recording. Enabling does not clear anything recorded previously.
+ */
+void PlEnableProfiler( bool enable ) {
+	if ( enable && profiler.mutex == NULL ) {
+		if ( ( profiler.mutex = PlCreateMutex() ) == NULL ) {
+			return;
+		}
+		profiler.baseTime = PlGetMonotonicTime();
+	}
+
+	PlAtomicStore32( &profiler.isEnabled, enable );
+}
+
+bool PlIsProfilerEnabled( void ) {
+	return PlAtomicLoad32( &profiler.isEnabled );
+}
+
+void PlBeginProfileZone( const char *name ) {
+	if ( !PlAtomicLoad32( &profiler.isEnabled ) ) {
+		return;
+	}
+
+	ProfileThread *thread = GetProfileThread();
+	if ( thread == NULL ) {
+		return;
+	}
+
+	if ( thread->depth >= PROFILE_MAX_DEPTH ) {
+		thread->overflow++;
+		return;
+	}
+
+	thread->zoneNames[ thread->depth ] = name;
+	thread->zoneStarts[ thread->depth ] = PlGetMonotonicTime();
+	thread->depth++;
+}
+
+void PlEndProfileZone( void ) {
+	/* always close off open zones, even if recording has since been stopped */
+	ProfileThread *thread = profileThread;
+	if ( thread == NULL || profileGeneration != PlAtomicLoad32( &profiler.generation ) ) {
+		return;
+	}
+
+	if ( thread->overflow > 0 ) {
+		thread->overflow--;
+		return;
+	} else if ( thread->depth == 0 ) {
+		return;
+	}
+
+	thread->depth--;
+
+	uint64_t start = thread->zoneStarts[ thread->depth ];
+	PushProfileEvent( thread, PROFILE_EVENT_ZONE, thread->zoneNames[ thread->depth ], start, ( int64_t ) ( PlGetMonotonicTime() - start ) );
+}
+
+void PlAddProfileCounter( const char *name, int64_t value ) {
+	if ( !PlAtomicLoad32( &profiler.isEnabled ) ) {
+		return;
+	}
+
+	ProfileThread *thread = GetProfileThread();
+	if ( thread == NULL ) {
+		return;
+	}
+
+	PushProfileEvent( thread, PROFILE_EVENT_COUNTER, name, PlGetMonotonicTime(), value );
+}
+
+static void WriteJsonString( FILE *file, const char *string ) {
+	fputc( '"', file );
+	for ( const char *c = string; *c != '\0'; ++c ) {
+		if ( *c == '"' || *c == '\\' ) {
+			fputc( '\\', file );
+			fputc( *c, file );
+		} else if ( ( unsigned char ) *c < 0x20 ) {
+			fprintf( file, "\\u%04x", *c );
+		} else {
+			fputc( *c, file );
+		}
+	}
+	fputc( '"', file );
+}
+
+/**
+ * Writes everything recorded so far out in the Chrome trace event format.
+ * Threads can continue recording while this is happening.
+ */
+bool PlWriteProfileTrace( const char *path ) {
+	if ( profiler.mutex == NULL ) {
+		PlReportErrorF( PL_RESULT_FAIL, "profiler has not been enabled" );
+		return false;
+	}
+
+	FILE *file = fopen( path, "w" );
+	if ( file == NULL ) {
+		PlReportErrorF( PL_RESULT_FILEWRITE, "failed to open %s for writing", path );
+		return false;
+	}
+
+	/* threads are only ever pushed onto the head, so the list can be walked without the lock */
+	PlLockMutex( profiler.mutex );
+	ProfileThread *threads = profiler.threads;
+	PlUnlockMutex( profiler.mutex );
+
+	fprintf( file, "{\"traceEvents\":[\n" );
+	bool first = true;
+	for ( ProfileThread *thread = threads; thread != NULL; thread = thread->next ) {
+		fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+		         first ? "" : ",\n", thread->id, thread->id );
+		first = false;
+
+		int64_t numEvents = PlAtomicLoad64( &thread->numEvents );
+		ProfileChunk *chunk = thread->firstChunk;
+		for ( int64_t i = 0; i < numEvents; ++i ) {
+			unsigned int slot = ( unsigned int ) ( i % PROFILE_CHUNK_EVENTS );
+			if ( slot == 0 && i > 0 ) {
+				chunk = chunk->next;
+			}
+
+			const ProfileEvent *event = &chunk->events[ slot ];
+			double ts = ( double ) ( int64_t ) ( event->start - profiler.baseTime ) / 1000.0;
+
+			fprintf( file, ",\n{\"name\":" );
+			WriteJsonString( file, event->name );
+			if ( event->type == PROFILE_EVENT_ZONE ) {
+				fprintf( file, ",\"cat\":\"hei\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				         ts, ( double ) event->value / 1000.0, thread->id );
+			} else {
+				fprintf( file, ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}",
+				         ts, thread->id, ( long long ) event->value );
+			}
+		}
+	}
+	fprintf( file, "\n],\"displayTimeUnit\":\"ns\"}\n" );
+
+	bool status = ( ferror( file ) == 0 );
+	fclose( file );
+
+	if ( !status ) {
+		PlReportErrorF( PL_RESULT_FILEWRITE, "failed to write %s", path );
+	}
+
+	return status;
+}
+
+/**
+ * Throws away everything recorded so far. Other threads
+ * must not be recording while this is called.
+ */
+void PlClearProfile( void ) {
+	if ( profiler.mutex == NULL ) {
+		return;
+	}
+
+	PlLockMutex( profiler.mutex );
+	ProfileThread *thread = profiler.threads;
+	while ( thread != NULL ) {
+		ProfileThread *next = thread->next;
+		ProfileChunk *chunk = thread->firstChunk;
+		while ( chunk != NULL ) {
+			ProfileChunk *nextChunk = chunk->next;
+			pl_free( chunk );
+			chunk = nextChunk;
+		}
+		pl_free( thread );
+		thread = next;
+	}
+	profiler.threads = NULL;
+	profiler.numThreads = 0;
+	profiler.baseTime = PlGetMonotonicTime();
+	PlAtomicFetchAdd32( &profiler.generation, 1 );
+	PlUnlockMutex( profiler.mutex );
+}
+
+void PlShutdownProfiler( void ) {
+	PlAtomicStore32( &profiler.isEnabled, 0 );
+	PlClearProfile();
+	PlDestroyMutex( profiler.mutex );
+	profiler.mutex = NULL;
+}
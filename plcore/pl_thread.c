@@ -0,0 +1,248 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include <plcore/pl_thread.h>
+
+#include "pl_private.h"
+
+#if defined( _WIN32 )
+#	include <Windows.h>
+#else
+#	include <pthread.h>
+#	include <sched.h>
+#	include <errno.h>
+#endif
+
+struct PLThread {
+	PLThreadFunction function;
+	void *userData;
+	int returnCode;
+#if defined( _WIN32 )
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+struct PLMutex {
+#if defined( _WIN32 )
+	CRITICAL_SECTION handle;
+#else
+	pthread_mutex_t handle;
+#endif
+};
+
+struct PLCondition {
+#if defined( _WIN32 )
+	CONDITION_VARIABLE handle;
+#else
+	pthread_cond_t handle;
+#endif
+};
+
+#if defined( _WIN32 )
+static DWORD WINAPI ThreadEntry( LPVOID parm ) {
+	PLThread *thread = ( PLThread * ) parm;
+	thread->returnCode = thread->function( thread->userData );
+	return 0;
+}
+#else
+static void *ThreadEntry( void *parm ) {
+	PLThread *thread = ( PLThread * ) parm;
+	thread->returnCode = thread->function( thread->userData );
+	return NULL;
+}
+#endif
+
+/**
+ * Spawns a new thread which runs the given function.
+ * The thread must be cleaned up via PlJoinThread.
+ */
+PLThread *PlCreateThread( PLThreadFunction function, void *userData ) {
+	PLThread *thread = pl_calloc( 1, sizeof( PLThread ) );
+	if ( thread == NULL ) {
+		return NULL;
+	}
+
+	thread->function = function;
+	thread->userData = userData;
+
+#if defined( _WIN32 )
+	thread->handle = CreateThread( NULL, 0, ThreadEntry, thread, 0, NULL );
+	if ( thread->handle == NULL ) {
+		PlReportErrorF( PL_RESULT_SYSERR, "failed to create thread (%d)", GetLastError() );
+		pl_free( thread );
+		return NULL;
+	}
+#else
+	int err = pthread_create( &thread->handle, NULL, ThreadEntry, thread );
+	if ( err != 0 ) {
+		PlReportErrorF( PL_RESULT_SYSERR, "failed to create thread (%s)", strerror( err ) );
+		pl_free( thread );
+		return NULL;
+	}
+#endif
+
+	return thread;
+}
+
+/**
+ * Waits for the thread to finish, frees it and returns
+ * the value returned by its function.
+ */
+int PlJoinThread( PLThread *thread ) {
+#if defined( _WIN32 )
+	WaitForSingleObject( thread->handle, INFINITE );
+	CloseHandle( thread->handle );
+#else
+	pthread_join( thread->handle, NULL );
+#endif
+
+	int returnCode = thread->returnCode;
+	pl_free( thread );
+	return returnCode;
+}
+
+void PlYieldThread( void ) {
+#if defined( _WIN32 )
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+void PlSleepThread( unsigned int milliseconds ) {
+#if defined( _WIN32 )
+	Sleep( milliseconds );
+#else
+	struct timespec ts = { milliseconds / 1000, ( long ) ( milliseconds % 1000 ) * 1000000L };
+	while ( nanosleep( &ts, &ts ) == -1 && errno == EINTR ) {}
+#endif
+}
+
+unsigned int PlGetNumProcessors( void ) {
+#if defined( _WIN32 )
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return ( unsigned int ) info.dwNumberOfProcessors;
+#else
+	long n = sysconf( _SC_NPROCESSORS_ONLN );
+	return ( n > 0 ) ? ( unsigned int ) n : 1;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+PLMutex *PlCreateMutex( void ) {
+	PLMutex *mutex = pl_calloc( 1, sizeof( PLMutex ) );
+	if ( mutex == NULL ) {
+		return NULL;
+	}
+
+#if defined( _WIN32 )
+	InitializeCriticalSection( &mutex->handle );
+#else
+	pthread_mutex_init( &mutex->handle, NULL );
+#endif
+
+	return mutex;
+}
+
+void PlDestroyMutex( PLMutex *mutex ) {
+	if ( mutex == NULL ) {
+		return;
+	}
+
+#if defined( _WIN32 )
+	DeleteCriticalSection( &mutex->handle );
+#else
+	pthread_mutex_destroy( &mutex->handle );
+#endif
+
+	pl_free( mutex );
+}
+
+void PlLockMutex( PLMutex *mutex ) {
+#if defined( _WIN32 )
+	EnterCriticalSection( &mutex->handle );
+#else
+	pthread_mutex_lock( &mutex->handle );
+#endif
+}
+
+void PlUnlockMutex( PLMutex *mutex ) {
+#if defined( _WIN32 )
+	LeaveCriticalSection( &mutex->handle );
+#else
+	pthread_mutex_unlock( &mutex->handle );
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+PLCondition *PlCreateCondition( void ) {
+	PLCondition *condition = pl_calloc( 1, sizeof( PLCondition ) );
+	if ( condition == NULL ) {
+		return NULL;
+	}
+
+#if defined( _WIN32 )
+	InitializeConditionVariable( &condition->handle );
+#else
+	pthread_cond_init( &condition->handle, NULL );
+#endif
+
+	return condition;
+}
+
+void PlDestroyCondition( PLCondition *condition ) {
+	if ( condition == NULL ) {
+		return;
+	}
+
+#if !defined( _WIN32 )
+	pthread_cond_destroy( &condition->handle );
+#endif
+
+	pl_free( condition );
+}
+
+bool PlWaitCondition( PLCondition *condition, PLMutex *mutex, unsigned int milliseconds ) {
+#if defined( _WIN32 )
+	return SleepConditionVariableCS( &condition->handle, &mutex->handle, ( milliseconds == 0 ) ? INFINITE : milliseconds );
+#else
+	if ( milliseconds == 0 ) {
+		return ( pthread_cond_wait( &condition->handle, &mutex->handle ) == 0 );
+	}
+
+	struct timespec ts;
+	clock_gettime( CLOCK_REALTIME, &ts );
+	ts.tv_sec += milliseconds / 1000;
+	ts.tv_nsec += ( long ) ( milliseconds % 1000 ) * 1000000L;
+	if ( ts.tv_nsec >= 1000000000L ) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	return ( pthread_cond_timedwait( &condition->handle, &mutex->handle, &ts ) == 0 );
+#endif
+}
+
+void PlSignalCondition( PLCondition *condition ) {
+#if defined( _WIN32 )
+	WakeConditionVariable( &condition->handle );
+#else
+	pthread_cond_signal( &condition->handle );
+#endif
+}
+
+void PlBroadcastCondition( PLCondition *condition ) {
+#if defined( _WIN32 )
+	WakeAllConditionVariable( &condition->handle );
+#else
+	pthread_cond_broadcast( &condition->handle );
+#endif
+}
@@ -90,6 +90,8 @@ PL_EXTERN void PlgSetupCamera( PLGCamera *camera );
 
 PL_EXTERN bool PlgIsBoxInsideView( const PLGCamera *camera, const PLCollisionAABB *bounds );
 PL_EXTERN bool PlgIsSphereInsideView( const PLGCamera *camera, const PLCollisionSphere *sphere );
+PL_EXTERN unsigned int PlgCullBoxes( const PLGCamera *camera, const PLVector3SoA *centres, const PLVector3SoA *extents, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices );
+PL_EXTERN unsigned int PlgCullSpheres( const PLGCamera *camera, const PLVector3SoA *centres, const float *radii, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices );
 
 PL_EXTERN const PLGViewport *PlgGetCurrentViewport( void );
 
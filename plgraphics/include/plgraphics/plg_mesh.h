@@ -73,6 +73,7 @@ typedef struct PLGMesh {
 } PLGMesh;
 
 typedef struct PLCollisionAABB PLCollisionAABB;
+typedef struct PLCollisionMesh PLCollisionMesh;
 
 #if !defined( PL_COMPILE_PLUGIN )
 
@@ -118,6 +119,7 @@ PL_EXTERN void PlgDrawMesh( PLGMesh *mesh );
 
 PLCollisionAABB PlgGenerateAabbFromVertices( const PLGVertex *vertices, unsigned int numVertices, bool absolute );
 PLCollisionAABB PlgGenerateAabbFromMesh( const PLGMesh *mesh, bool absolute );
+void PlgAddMeshToCollisionMesh( PLCollisionMesh *collisionMesh, const PLGMesh *mesh );
 
 PL_EXTERN void PlgGenerateMeshNormals( PLGMesh *mesh, bool perFace );
 PL_EXTERN void PlgGenerateMeshTangentBasis( PLGMesh *mesh );
@@ -0,0 +1,50 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#pragma once
+
+#include <plgraphics/plg.h>
+#include <plgraphics/plg_camera.h>
+
+PL_EXTERN_C
+
+/******************************************************************/
+/* Occlusion Culling
+ * Hides objects behind walls and other large geometry, on the CPU, by
+ * drawing a few chosen occluders into a small depth buffer and then
+ * checking object bounds against it; something like 256x128 is plenty.
+ * Occluders cover the pixels whose centres they contain, at the furthest
+ * depth they reach within each, so an object is only reported as hidden
+ * when something is in front of it, give or take half a pixel around
+ * the edges of the occluders.
+ *
+ * Each frame, clear the buffer with the view-projection matrix, add the
+ * occluders, build the pyramid, then test objects. Testing still works
+ * without the pyramid, it's just slower for anything taking up much of
+ * the screen. Objects crossing the near plane, or off the screen, always
+ * count as visible; leave the latter to frustum culling. */
+
+typedef struct PLGOcclusionBuffer PLGOcclusionBuffer;
+
+PL_EXTERN PLGOcclusionBuffer *PlgCreateOcclusionBuffer( unsigned int width, unsigned int height );
+PL_EXTERN void PlgDestroyOcclusionBuffer( PLGOcclusionBuffer *buffer );
+
+PL_EXTERN void PlgClearOcclusionBuffer( PLGOcclusionBuffer *buffer, const PLMatrix4 *viewProjection );
+PL_EXTERN void PlgClearOcclusionBufferFromCamera( PLGOcclusionBuffer *buffer, const PLGCamera *camera );
+
+PL_EXTERN void PlgAddOccluderTriangles( PLGOcclusionBuffer *buffer, const PLMatrix4 *transform, const PLVector3 *positions, size_t stride, const unsigned int *indices, unsigned int numTriangles );
+PL_EXTERN void PlgAddOccluderMesh( PLGOcclusionBuffer *buffer, const PLMatrix4 *transform, const PLGMesh *mesh );
+PL_EXTERN void PlgBuildOcclusionPyramid( PLGOcclusionBuffer *buffer );
+
+PL_EXTERN bool PlgIsBoxOccluded( const PLGOcclusionBuffer *buffer, const PLCollisionAABB *bounds );
+PL_EXTERN unsigned int PlgTestOcclusionBoxes( const PLGOcclusionBuffer *buffer, const PLVector3SoA *centres, const PLVector3SoA *extents, unsigned int num, uint32_t *visibleBits, unsigned int *visibleIndices );
+
+/* for debugging */
+PL_EXTERN unsigned int PlgGetOcclusionBufferLevels( const PLGOcclusionBuffer *buffer );
+PL_EXTERN float PlgGetOcclusionBufferDepth( const PLGOcclusionBuffer *buffer, unsigned int level, unsigned int x, unsigned int y );
+PL_EXTERN PLImage *PlgGetOcclusionBufferImage( const PLGOcclusionBuffer *buffer, unsigned int level );
+
+PL_EXTERN_C_END
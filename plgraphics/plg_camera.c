@@ -177,36 +177,24 @@ void PlgSetupCamera( PLGCamera *camera ) {
 	CallGfxFunction( SetupCamera, camera );
 }
 
+/* the view checks have always left out the near plane, which comes last */
+#define VIEW_CULL_PLANES PLG_FRUSTUM_PLANE_NEAR
+
 /**
  * Checks that the given bounding box is within the view space.
  */
 bool PlgIsBoxInsideView( const PLGCamera *camera, const PLCollisionAABB *bounds ) {
 	PLVector3 mins = PlAddVector3( bounds->mins, bounds->origin );
 	PLVector3 maxs = PlAddVector3( bounds->maxs, bounds->origin );
-	for ( unsigned int i = 0; i < 5; ++i ) {
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( mins.x, mins.y, mins.z ) ) >= 0.0f ) {
-			continue;
-		}
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( maxs.x, mins.y, mins.z ) ) >= 0.0f ) {
-			continue;
-		}
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( mins.x, maxs.y, mins.z ) ) >= 0.0f ) {
-			continue;
-		}
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( maxs.x, maxs.y, mins.z ) ) >= 0.0f ) {
-			continue;
-		}
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( mins.x, mins.y, maxs.z ) ) >= 0.0f ) {
-			continue;
-		}
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( mins.x, maxs.y, maxs.z ) ) >= 0.0f ) {
-			continue;
-		}
-		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &PLVector3( maxs.x, maxs.y, maxs.z ) ) >= 0.0f ) {
-			continue;
+	PLVector3 centre = PlScaleVector3F( PlAddVector3( mins, maxs ), 0.5f );
+	PLVector3 extents = PlScaleVector3F( PlSubtractVector3( maxs, mins ), 0.5f );
+	for ( unsigned int i = 0; i < VIEW_CULL_PLANES; ++i ) {
+		/* distance to the corner furthest along the plane's normal */
+		const PLVector4 *p = &camera->frustum[ i ];
+		float r = fabsf( p->x ) * extents.x + fabsf( p->y ) * extents.y + fabsf( p->z ) * extents.z;
+		if ( PlGetPlaneDotProduct( p, &centre ) + r < 0.0f ) {
+			return false;
 		}
-
-		return false;
 	}
 
 	return true;
@@ -216,7 +204,7 @@ bool PlgIsBoxInsideView( const PLGCamera *camera, const PLCollisionAABB *bounds
  * Checks that the given sphere is within the view space.
  */
 bool PlgIsSphereInsideView( const PLGCamera *camera, const PLCollisionSphere *sphere ) {
-	for ( unsigned int i = 0; i < 5; ++i ) {
+	for ( unsigned int i = 0; i < VIEW_CULL_PLANES; ++i ) {
 		if ( PlGetPlaneDotProduct( &camera->frustum[ i ], &sphere->origin ) < -sphere->radius ) {
 			return false;
 		}
@@ -225,6 +213,22 @@ bool PlgIsSphereInsideView( const PLGCamera *camera, const PLCollisionSphere *sp
 	return true;
 }
 
+/**
+ * Culls a batch of boxes against the camera's frustum, the same
+ * planes as PlgIsBoxInsideView; see PlCullBoxes.
+ */
+unsigned int PlgCullBoxes( const PLGCamera *camera, const PLVector3SoA *centres, const PLVector3SoA *extents, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices ) {
+	return PlCullBoxes( camera->frustum, VIEW_CULL_PLANES, centres, extents, num, planeCache, visibleBits, visibleIndices );
+}
+
+/**
+ * Culls a batch of spheres against the camera's frustum, the same
+ * planes as PlgIsSphereInsideView; see PlCullSpheres.
+ */
+unsigned int PlgCullSpheres( const PLGCamera *camera, const PLVector3SoA *centres, const float *radii, unsigned int num, uint8_t *planeCache, uint32_t *visibleBits, unsigned int *visibleIndices ) {
+	return PlCullSpheres( camera->frustum, VIEW_CULL_PLANES, centres, radii, num, planeCache, visibleBits, visibleIndices );
+}
+
 const PLGViewport *PlgGetCurrentViewport( void ) {
 	return gfx_state.current_viewport;
 }
@@ -8,6 +8,8 @@
 
 #include "plg_private.h"
 
+#include <plcore/pl_profiler.h>
+
 #define MAXIMUM_STORAGE 4096
 
 static PLGMesh *InitLineMesh( void ) {
@@ -56,6 +58,8 @@ void PlgDrawEllipse( unsigned int segments, PLVector2 position, float w, float h
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	for ( unsigned int i = 0, pos = 0; i < 360; i += ( 360 / segments ) ) {
 		if ( pos >= segments ) {
 			break;
@@ -80,6 +84,8 @@ void PlgDrawEllipse( unsigned int segments, PLVector2 position, float w, float h
 	PlgDrawMesh( mesh );
 
 	PlPopMatrix();
+
+	PL_PROFILE_END();
 }
 
 static void SetupRectangleMesh( PLGMesh *mesh, float x, float y, float w, float h, PLColour colour ) {
@@ -95,6 +101,8 @@ void PlgDrawTexturedRectangle( const PLMatrix4 *transform, float x, float y, flo
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	SetupRectangleMesh( mesh, x, y, w, h, PLColour( 255, 255, 255, 255 ) );
 
 	PlgSetTexture( texture, 0 );
@@ -105,6 +113,8 @@ void PlgDrawTexturedRectangle( const PLMatrix4 *transform, float x, float y, flo
 	PlgDrawMesh( mesh );
 
 	PlgSetTexture( NULL, 0 );
+
+	PL_PROFILE_END();
 }
 
 PLGMesh *PlgCreateMeshRectangle( float x, float y, float w, float h, PLColour colour ) {
@@ -124,12 +134,16 @@ void PlgDrawRectangle( const PLMatrix4 *transform, float x, float y, float w, fl
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	SetupRectangleMesh( mesh, x, y, w, h, colour );
 
 	PlgSetShaderUniformValue( PlgGetCurrentShaderProgram(), "pl_model", transform, true );
 
 	PlgUploadMesh( mesh );
 	PlgDrawMesh( mesh );
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawFilledRectangle( const PLRectangle2D *rectangle ) {
@@ -138,6 +152,8 @@ void PlgDrawFilledRectangle( const PLRectangle2D *rectangle ) {
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	SetupRectangleMesh( mesh, rectangle->xy.x, rectangle->xy.y, rectangle->wh.x, rectangle->wh.y, PLColour( 255, 255, 255, 255 ) );
 
 	PlgSetMeshVertexColour( mesh, 0, rectangle->ll );
@@ -156,6 +172,8 @@ void PlgDrawFilledRectangle( const PLRectangle2D *rectangle ) {
 	PlgDrawMesh( mesh );
 
 	PlPopMatrix();
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawTexturedQuad( const PLVector3 *ul, const PLVector3 *ur, const PLVector3 *ll, const PLVector3 *lr, float hScale, float vScale, PLGTexture *texture ) {
@@ -164,6 +182,8 @@ void PlgDrawTexturedQuad( const PLVector3 *ul, const PLVector3 *ur, const PLVect
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	PLVector3 upperDist = PlSubtractVector3( *ul, *ur );
 	float quadWidth = PlVector3Length( upperDist ) / hScale;
 	PLVector3 lowerDist = PlSubtractVector3( *ll, *ul );
@@ -192,6 +212,8 @@ void PlgDrawTexturedQuad( const PLVector3 *ul, const PLVector3 *ur, const PLVect
 	PlgDrawMesh( mesh );
 
 	PlPopMatrix();
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawTriangle( int x, int y, unsigned int w, unsigned int h ) {
@@ -200,6 +222,8 @@ void PlgDrawTriangle( int x, int y, unsigned int w, unsigned int h ) {
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	PlgClearMesh( mesh );
 
 	PlgAddMeshVertex( mesh, PLVector3( x, y + h, 0.0f ), pl_vecOrigin3, PLColour( 255, 0, 0, 255 ), pl_vecOrigin2 );
@@ -219,6 +243,8 @@ void PlgDrawTriangle( int x, int y, unsigned int w, unsigned int h ) {
 	PlgDrawMesh( mesh );
 
 	PlPopMatrix();
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawLines( const PLVector3 *points, unsigned int numPoints, PLColour colour ) {
@@ -227,6 +253,8 @@ void PlgDrawLines( const PLVector3 *points, unsigned int numPoints, PLColour col
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	for ( unsigned int i = 0; i < numPoints; ++i ) {
 		PlgAddMeshVertex( mesh, points[ i ], pl_vecOrigin3, colour, pl_vecOrigin2 );
 	}
@@ -235,6 +263,8 @@ void PlgDrawLines( const PLVector3 *points, unsigned int numPoints, PLColour col
 
 	PlgUploadMesh( mesh );
 	PlgDrawMesh( mesh );
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawLine( PLMatrix4 transform, PLVector3 startPos, PLColour startColour, PLVector3 endPos, PLColour endColour ) {
@@ -243,6 +273,8 @@ void PlgDrawLine( PLMatrix4 transform, PLVector3 startPos, PLColour startColour,
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	PlgAddMeshVertex( mesh, startPos, pl_vecOrigin3, startColour, pl_vecOrigin2 );
 	PlgAddMeshVertex( mesh, endPos, pl_vecOrigin3, endColour, pl_vecOrigin2 );
 
@@ -250,6 +282,8 @@ void PlgDrawLine( PLMatrix4 transform, PLVector3 startPos, PLColour startColour,
 
 	PlgUploadMesh( mesh );
 	PlgDrawMesh( mesh );
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawSimpleLine( PLMatrix4 transform, PLVector3 startPos, PLVector3 endPos, PLColour colour ) {
@@ -276,6 +310,8 @@ void PlgDrawMeshNormals( const PLMatrix4 *transform, const PLGMesh *mesh ) {
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	PlgClearMesh( linesMesh );
 
 	for ( unsigned int i = 0; i < mesh->num_verts; ++i ) {
@@ -287,6 +323,8 @@ void PlgDrawMeshNormals( const PLMatrix4 *transform, const PLGMesh *mesh ) {
 
 	PlgUploadMesh( linesMesh );
 	PlgDrawMesh( linesMesh );
+
+	PL_PROFILE_END();
 }
 
 void PlgDrawPixel( int x, int y, PLColour colour ) {
@@ -303,6 +341,8 @@ void PlgDrawBoundingVolume( const PLCollisionAABB *bounds, PLColour colour ) {
 		return;
 	}
 
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	PlMatrixMode( PL_MODELVIEW_MATRIX );
 	PlPushMatrix();
 
@@ -356,4 +396,6 @@ void PlgDrawBoundingVolume( const PLCollisionAABB *bounds, PLColour colour ) {
 	PlgDrawMesh( mesh );
 
 	PlPopMatrix();
+
+	PL_PROFILE_END();
 }
@@ -327,3 +327,16 @@ PLCollisionAABB PlgGenerateAabbFromVertices( const PLGVertex *vertices, unsigned
 PLCollisionAABB PlgGenerateAabbFromMesh( const PLGMesh *mesh, bool absolute ) {
 	return PlgGenerateAabbFromVertices( mesh->vertices, mesh->num_verts, absolute );
 }
+
+/**
+ * Adds the mesh's triangles to the collision mesh, which will still need
+ * building afterwards. Only triangle lists are supported.
+ */
+void PlgAddMeshToCollisionMesh( PLCollisionMesh *collisionMesh, const PLGMesh *mesh ) {
+	if ( mesh->primitive != PLG_MESH_TRIANGLES ) {
+		PlReportErrorF( PL_RESULT_UNSUPPORTED, "unsupported mesh primitive for collision (%d)", mesh->primitive );
+		return;
+	}
+
+	PlAddCollisionMeshTriangles( collisionMesh, &mesh->vertices[ 0 ].position, sizeof( PLGVertex ), mesh->indices, mesh->num_triangles );
+}
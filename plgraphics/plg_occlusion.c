@@ -0,0 +1,913 @@
+/**
+ * Hei Platform Library
+ * Copyright (C) 2017-2021 Mark E Sowden <hogsy@oldtimes-software.com>
+ * This software is licensed under MIT. See LICENSE for more details.
+ */
+
+#include <plgraphics/plg_occlusion.h>
+
+#include "plg_private.h"
+
+#include <float.h>
+
+#if defined( PL_SYSTEM_CPU_X86 )
+#	include <immintrin.h>
+#endif
+
+/* Depth is stored as z / w, which only needs to get larger further away
+ * from the camera, so any view-projection matrix can be used. Occluders
+ * are clipped in clip space, against the near plane and a guard band a
+ * little way outside the screen, then drawn a row at a time, with the
+ * vector kernels taking a register's worth of pixels at once. Each level
+ * of the pyramid holds the furthest depth of the four texels below it, so
+ * an object's nearest depth only needs comparing against a handful of
+ * texels, at whichever level its bounds cover no more than 4x4 of them.
+ *
+ * As with the frustum culling kernels, every kernel evaluates exactly the
+ * same operations in the same order, so neither the depth buffer nor
+ * which objects are occluded depends on the kernel. */
+
+#define MAX_BUFFER_SIZE 4096
+#define MAX_LEVELS      13 /* enough to halve MAX_BUFFER_SIZE down to a single texel */
+
+#define CLEAR_DEPTH FLT_MAX
+
+/* how far out occluders are clipped to, relative to the screen; keeps their
+ * edge equations small enough for floats to stay accurate */
+#define GUARD_BAND 4.0f
+
+enum {
+	CLIP_PLANE_NEAR,
+	CLIP_PLANE_RIGHT,
+	CLIP_PLANE_LEFT,
+	CLIP_PLANE_TOP,
+	CLIP_PLANE_BOTTOM,
+
+	MAX_CLIP_PLANES
+};
+
+/* each plane a triangle is clipped against adds at most one vertex */
+#define MAX_CLIP_VERTICES ( 3 + MAX_CLIP_PLANES )
+
+typedef struct OcclusionLevel {
+	unsigned int width, height, stride;
+	float *depth;
+} OcclusionLevel;
+
+struct PLGOcclusionBuffer {
+	PLMatrix4 viewProjection;
+	float halfWidth, halfHeight;
+	OcclusionLevel levels[ MAX_LEVELS ];
+	unsigned int numLevels;
+	bool isPyramidBuilt;
+};
+
+/**
+ * Creates a depth buffer for occlusion culling of the given resolution,
+ * which doesn't need to match the viewport's aspect ratio.
+ */
+PLGOcclusionBuffer *PlgCreateOcclusionBuffer( unsigned int width, unsigned int height ) {
+	if ( width == 0 || width > MAX_BUFFER_SIZE ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM1, "invalid occlusion buffer width (%u)", width );
+		return NULL;
+	}
+	if ( height == 0 || height > MAX_BUFFER_SIZE ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid occlusion buffer height (%u)", height );
+		return NULL;
+	}
+
+	PLGOcclusionBuffer *buffer = ( PLGOcclusionBuffer * ) pl_calloc( 1, sizeof( PLGOcclusionBuffer ) );
+	if ( buffer == NULL ) {
+		return NULL;
+	}
+
+	buffer->halfWidth = ( float ) width * 0.5f;
+	buffer->halfHeight = ( float ) height * 0.5f;
+
+	/* each level is half the size of the one below, rounding up, until
+	 * there's only a single texel left */
+	size_t size = 0;
+	for ( ;; ) {
+		OcclusionLevel *level = &buffer->levels[ buffer->numLevels++ ];
+		level->width = width;
+		level->height = height;
+		level->stride = ( width + 7 ) & ~7U; /* so rows can be written 8 texels at a time */
+		size += ( size_t ) level->stride * level->height;
+		if ( width == 1 && height == 1 ) {
+			break;
+		}
+
+		width = ( width + 1 ) / 2;
+		height = ( height + 1 ) / 2;
+	}
+
+	float *depth = ( float * ) pl_malloc( size * sizeof( float ) );
+	if ( depth == NULL ) {
+		pl_free( buffer );
+		return NULL;
+	}
+
+	for ( unsigned int i = 0; i < buffer->numLevels; ++i ) {
+		buffer->levels[ i ].depth = depth;
+		depth += buffer->levels[ i ].stride * buffer->levels[ i ].height;
+	}
+
+	PLMatrix4 identity = PlMatrix4Identity();
+	PlgClearOcclusionBuffer( buffer, &identity );
+
+	return buffer;
+}
+
+void PlgDestroyOcclusionBuffer( PLGOcclusionBuffer *buffer ) {
+	if ( buffer == NULL ) {
+		return;
+	}
+
+	pl_free( buffer->levels[ 0 ].depth );
+	pl_free( buffer );
+}
+
+/**
+ * Clears the buffer ready for a new frame, drawn with the given
+ * view-projection matrix.
+ */
+void PlgClearOcclusionBuffer( PLGOcclusionBuffer *buffer, const PLMatrix4 *viewProjection ) {
+	buffer->viewProjection = *viewProjection;
+
+	OcclusionLevel *base = &buffer->levels[ 0 ];
+	size_t size = ( size_t ) base->stride * base->height;
+	for ( size_t i = 0; i < size; ++i ) {
+		base->depth[ i ] = CLEAR_DEPTH;
+	}
+
+	buffer->isPyramidBuilt = false;
+}
+
+/**
+ * Clears the buffer ready for a new frame, drawn from the camera's
+ * current view; call PlgSetupCamera first.
+ */
+void PlgClearOcclusionBufferFromCamera( PLGOcclusionBuffer *buffer, const PLGCamera *camera ) {
+	PLMatrix4 viewProjection = PlMultiplyMatrix4( camera->internal.proj, camera->internal.view );
+	PlgClearOcclusionBuffer( buffer, &viewProjection );
+}
+
+/****************************************
+ * Rasterisation
+ ****************************************/
+
+typedef struct ScreenVertex {
+	float x, y, z;
+} ScreenVertex;
+
+/* edges are A * x + B * y + C, which is positive on the inside */
+typedef struct RasterTriangle {
+	float a[ 3 ], b[ 3 ], c[ 3 ];
+	float dzdx, dzdy, zc;
+	float zBias; /* how much further away the plane gets within half a pixel */
+	int minX, maxX, minY, maxY;
+} RasterTriangle;
+
+typedef void ( *RasterKernel )( const RasterTriangle *t, OcclusionLevel *level );
+
+static void RasterizeScalar( const RasterTriangle *t, OcclusionLevel *level ) {
+	for ( int y = t->minY; y <= t->maxY; ++y ) {
+		float py = ( float ) y + 0.5f;
+		float e0 = t->b[ 0 ] * py + t->c[ 0 ];
+		float e1 = t->b[ 1 ] * py + t->c[ 1 ];
+		float e2 = t->b[ 2 ] * py + t->c[ 2 ];
+		float rowZ = ( t->dzdy * py + t->zc ) + t->zBias;
+
+		float *row = &level->depth[ y * level->stride ];
+		for ( int x = t->minX; x <= t->maxX; ++x ) {
+			float px = ( float ) x + 0.5f;
+			if ( t->a[ 0 ] * px + e0 >= 0.0f && t->a[ 1 ] * px + e1 >= 0.0f && t->a[ 2 ] * px + e2 >= 0.0f ) {
+				float z = t->dzdx * px + rowZ;
+				row[ x ] = ( row[ x ] < z ) ? row[ x ] : z;
+			}
+		}
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static void RasterizeSse2( const RasterTriangle *t, OcclusionLevel *level ) {
+	const __m128 lanes = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+	const __m128 first = _mm_set1_ps( ( float ) t->minX + 0.5f );
+	const __m128 last = _mm_set1_ps( ( float ) t->maxX + 0.5f );
+	const __m128 a0 = _mm_set1_ps( t->a[ 0 ] );
+	const __m128 a1 = _mm_set1_ps( t->a[ 1 ] );
+	const __m128 a2 = _mm_set1_ps( t->a[ 2 ] );
+	const __m128 dzdx = _mm_set1_ps( t->dzdx );
+	const __m128 zero = _mm_setzero_ps();
+
+	for ( int y = t->minY; y <= t->maxY; ++y ) {
+		float py = ( float ) y + 0.5f;
+		__m128 e0 = _mm_set1_ps( t->b[ 0 ] * py + t->c[ 0 ] );
+		__m128 e1 = _mm_set1_ps( t->b[ 1 ] * py + t->c[ 1 ] );
+		__m128 e2 = _mm_set1_ps( t->b[ 2 ] * py + t->c[ 2 ] );
+		__m128 rowZ = _mm_set1_ps( ( t->dzdy * py + t->zc ) + t->zBias );
+
+		float *row = &level->depth[ y * level->stride ];
+		for ( int x = t->minX & ~3; x <= t->maxX; x += 4 ) {
+			__m128 px = _mm_add_ps( _mm_set1_ps( ( float ) x ), lanes );
+			__m128 inside = _mm_and_ps( _mm_cmpge_ps( px, first ), _mm_cmple_ps( px, last ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( a0, px ), e0 ), zero ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( a1, px ), e1 ), zero ) );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( a2, px ), e2 ), zero ) );
+			if ( _mm_movemask_ps( inside ) == 0 ) {
+				continue;
+			}
+
+			__m128 z = _mm_add_ps( _mm_mul_ps( dzdx, px ), rowZ );
+			__m128 old = _mm_loadu_ps( &row[ x ] );
+			__m128 nearest = _mm_min_ps( old, z );
+			_mm_storeu_ps( &row[ x ], _mm_or_ps( _mm_and_ps( inside, nearest ), _mm_andnot_ps( inside, old ) ) );
+		}
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void RasterizeAvx2( const RasterTriangle *t, OcclusionLevel *level ) {
+	const __m256 lanes = _mm256_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f );
+	const __m256 first = _mm256_set1_ps( ( float ) t->minX + 0.5f );
+	const __m256 last = _mm256_set1_ps( ( float ) t->maxX + 0.5f );
+	const __m256 a0 = _mm256_set1_ps( t->a[ 0 ] );
+	const __m256 a1 = _mm256_set1_ps( t->a[ 1 ] );
+	const __m256 a2 = _mm256_set1_ps( t->a[ 2 ] );
+	const __m256 dzdx = _mm256_set1_ps( t->dzdx );
+	const __m256 zero = _mm256_setzero_ps();
+
+	for ( int y = t->minY; y <= t->maxY; ++y ) {
+		float py = ( float ) y + 0.5f;
+		__m256 e0 = _mm256_set1_ps( t->b[ 0 ] * py + t->c[ 0 ] );
+		__m256 e1 = _mm256_set1_ps( t->b[ 1 ] * py + t->c[ 1 ] );
+		__m256 e2 = _mm256_set1_ps( t->b[ 2 ] * py + t->c[ 2 ] );
+		__m256 rowZ = _mm256_set1_ps( ( t->dzdy * py + t->zc ) + t->zBias );
+
+		float *row = &level->depth[ y * level->stride ];
+		for ( int x = t->minX & ~7; x <= t->maxX; x += 8 ) {
+			__m256 px = _mm256_add_ps( _mm256_set1_ps( ( float ) x ), lanes );
+			__m256 inside = _mm256_and_ps( _mm256_cmp_ps( px, first, _CMP_GE_OQ ), _mm256_cmp_ps( px, last, _CMP_LE_OQ ) );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( _mm256_add_ps( _mm256_mul_ps( a0, px ), e0 ), zero, _CMP_GE_OQ ) );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( _mm256_add_ps( _mm256_mul_ps( a1, px ), e1 ), zero, _CMP_GE_OQ ) );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( _mm256_add_ps( _mm256_mul_ps( a2, px ), e2 ), zero, _CMP_GE_OQ ) );
+			if ( _mm256_movemask_ps( inside ) == 0 ) {
+				continue;
+			}
+
+			__m256 z = _mm256_add_ps( _mm256_mul_ps( dzdx, px ), rowZ );
+			__m256 old = _mm256_loadu_ps( &row[ x ] );
+			__m256 nearest = _mm256_min_ps( old, z );
+			_mm256_storeu_ps( &row[ x ], _mm256_blendv_ps( old, nearest, inside ) );
+		}
+	}
+}
+
+#	define SSE2_KERNEL( KERNEL ) KERNEL
+#	define AVX2_KERNEL( KERNEL ) KERNEL
+#else
+#	define SSE2_KERNEL( KERNEL ) NULL
+#	define AVX2_KERNEL( KERNEL ) NULL
+#endif
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const RasterKernel rasterKernels[] = { RasterizeScalar, SSE2_KERNEL( RasterizeSse2 ), AVX2_KERNEL( RasterizeAvx2 ) };
+
+/* Pixels are drawn when their centre is on or inside every edge. Each
+ * edge's C is worked out from whichever of its ends comes first, so the
+ * two triangles sharing an edge get exactly opposite equations, and a
+ * centre lying right on it is always drawn by at least one of them;
+ * otherwise the gaps would show up all the way up the pyramid. */
+static void RasterizeTriangle( OcclusionLevel *level, RasterKernel kernel, const ScreenVertex *v0, const ScreenVertex *v1, const ScreenVertex *v2 ) {
+	float area = ( v1->x - v0->x ) * ( v2->y - v0->y ) - ( v2->x - v0->x ) * ( v1->y - v0->y );
+	/* occluders are double-sided */
+	if ( area < 0.0f ) {
+		const ScreenVertex *v = v1;
+		v1 = v2;
+		v2 = v;
+		area = -area;
+	}
+	if ( !( area > 0.0f ) ) {
+		return;
+	}
+
+	float minX = fminf( v0->x, fminf( v1->x, v2->x ) );
+	float maxX = fmaxf( v0->x, fmaxf( v1->x, v2->x ) );
+	float minY = fminf( v0->y, fminf( v1->y, v2->y ) );
+	float maxY = fmaxf( v0->y, fmaxf( v1->y, v2->y ) );
+
+	/* pixels whose centres are within the bounds, and on the screen */
+	RasterTriangle t;
+	t.minX = ( int ) ceilf( fmaxf( minX - 0.5f, 0.0f ) );
+	t.maxX = ( int ) floorf( fminf( maxX - 0.5f, ( float ) level->width - 1.0f ) );
+	t.minY = ( int ) ceilf( fmaxf( minY - 0.5f, 0.0f ) );
+	t.maxY = ( int ) floorf( fminf( maxY - 0.5f, ( float ) level->height - 1.0f ) );
+	if ( t.minX > t.maxX || t.minY > t.maxY ) {
+		return;
+	}
+
+	const ScreenVertex *v[ 3 ] = { v0, v1, v2 };
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		const ScreenVertex *p = v[ i ], *q = v[ ( i + 1 ) % 3 ];
+		t.a[ i ] = p->y - q->y;
+		t.b[ i ] = q->x - p->x;
+
+		const ScreenVertex *o = ( p->x < q->x || ( p->x == q->x && p->y < q->y ) ) ? p : q;
+		t.c[ i ] = -( t.a[ i ] * o->x + t.b[ i ] * o->y );
+	}
+
+	float dx1 = v1->x - v0->x, dy1 = v1->y - v0->y, dz1 = v1->z - v0->z;
+	float dx2 = v2->x - v0->x, dy2 = v2->y - v0->y, dz2 = v2->z - v0->z;
+	t.dzdx = ( dz1 * dy2 - dz2 * dy1 ) / area;
+	t.dzdy = ( dx1 * dz2 - dx2 * dz1 ) / area;
+	t.zc = v0->z - t.dzdx * v0->x - t.dzdy * v0->y;
+	t.zBias = 0.5f * ( fabsf( t.dzdx ) + fabsf( t.dzdy ) );
+
+	kernel( &t, level );
+}
+
+static float GetClipDistance( const PLVector4 *v, unsigned int plane ) {
+	switch ( plane ) {
+		case CLIP_PLANE_NEAR:
+			return v->z + v->w;
+		case CLIP_PLANE_RIGHT:
+			return GUARD_BAND * v->w - v->x;
+		case CLIP_PLANE_LEFT:
+			return GUARD_BAND * v->w + v->x;
+		case CLIP_PLANE_TOP:
+			return GUARD_BAND * v->w - v->y;
+		default:
+			return GUARD_BAND * v->w + v->y;
+	}
+}
+
+static unsigned int GetClipOutcode( const PLVector4 *v ) {
+	unsigned int outcode = 0;
+	for ( unsigned int i = 0; i < MAX_CLIP_PLANES; ++i ) {
+		if ( GetClipDistance( v, i ) < 0.0f ) {
+			outcode |= 1U << i;
+		}
+	}
+
+	return outcode;
+}
+
+/* Sutherland-Hodgman, returning how many vertices are left */
+static unsigned int ClipPolygon( const PLVector4 *in, unsigned int numIn, PLVector4 *out, unsigned int plane ) {
+	unsigned int numOut = 0;
+	for ( unsigned int i = 0; i < numIn; ++i ) {
+		const PLVector4 *a = &in[ i ], *b = &in[ ( i + 1 ) % numIn ];
+		float da = GetClipDistance( a, plane );
+		float db = GetClipDistance( b, plane );
+		if ( da >= 0.0f ) {
+			out[ numOut++ ] = *a;
+		}
+		if ( ( da >= 0.0f ) != ( db >= 0.0f ) ) {
+			float t = da / ( da - db );
+			out[ numOut++ ] = PLVector4( a->x + ( b->x - a->x ) * t,
+			                             a->y + ( b->y - a->y ) * t,
+			                             a->z + ( b->z - a->z ) * t,
+			                             a->w + ( b->w - a->w ) * t );
+		}
+	}
+
+	return numOut;
+}
+
+static void AddClipTriangle( PLGOcclusionBuffer *buffer, RasterKernel kernel, const PLVector4 *clip ) {
+	unsigned int outcodes[ 3 ] = { GetClipOutcode( &clip[ 0 ] ), GetClipOutcode( &clip[ 1 ] ), GetClipOutcode( &clip[ 2 ] ) };
+	/* entirely outside one of the planes */
+	if ( outcodes[ 0 ] & outcodes[ 1 ] & outcodes[ 2 ] ) {
+		return;
+	}
+
+	PLVector4 polygons[ 2 ][ MAX_CLIP_VERTICES ];
+	unsigned int numVertices = 3, cur = 0;
+	memcpy( polygons[ 0 ], clip, sizeof( PLVector4 ) * 3 );
+
+	unsigned int crossed = outcodes[ 0 ] | outcodes[ 1 ] | outcodes[ 2 ];
+	for ( unsigned int i = 0; i < MAX_CLIP_PLANES; ++i ) {
+		if ( !( crossed & ( 1U << i ) ) ) {
+			continue;
+		}
+
+		numVertices = ClipPolygon( polygons[ cur ], numVertices, polygons[ cur ^ 1 ], i );
+		cur ^= 1;
+		if ( numVertices < 3 ) {
+			return;
+		}
+	}
+
+	ScreenVertex screen[ MAX_CLIP_VERTICES ];
+	for ( unsigned int i = 0; i < numVertices; ++i ) {
+		const PLVector4 *v = &polygons[ cur ][ i ];
+		/* only possible for a triangle squashed onto the camera's position */
+		if ( !( v->w > 0.0f ) ) {
+			return;
+		}
+
+		float invW = 1.0f / v->w;
+		screen[ i ].x = ( v->x * invW ) * buffer->halfWidth + buffer->halfWidth;
+		screen[ i ].y = buffer->halfHeight - ( v->y * invW ) * buffer->halfHeight;
+		screen[ i ].z = v->z * invW;
+	}
+
+	for ( unsigned int i = 2; i < numVertices; ++i ) {
+		RasterizeTriangle( &buffer->levels[ 0 ], kernel, &screen[ 0 ], &screen[ i - 1 ], &screen[ i ] );
+	}
+}
+
+static PLVector4 TransformPosition( const PLMatrix4 *m, const PLVector3 *p ) {
+	return PLVector4( m->m[ 0 ] * p->x + m->m[ 4 ] * p->y + m->m[ 8 ] * p->z + m->m[ 12 ],
+	                  m->m[ 1 ] * p->x + m->m[ 5 ] * p->y + m->m[ 9 ] * p->z + m->m[ 13 ],
+	                  m->m[ 2 ] * p->x + m->m[ 6 ] * p->y + m->m[ 10 ] * p->z + m->m[ 14 ],
+	                  m->m[ 3 ] * p->x + m->m[ 7 ] * p->y + m->m[ 11 ] * p->z + m->m[ 15 ] );
+}
+
+/**
+ * Draws occluder triangles into the buffer, positioned by transform,
+ * which may be NULL if they're already in world space. Positions are
+ * stride bytes apart (or packed, if 0) and indexed as with
+ * PlAddCollisionMeshTriangles, three to a triangle, or used in order if
+ * indices is NULL. Which way the triangles face doesn't matter.
+ */
+void PlgAddOccluderTriangles( PLGOcclusionBuffer *buffer, const PLMatrix4 *transform, const PLVector3 *positions, size_t stride, const unsigned int *indices, unsigned int numTriangles ) {
+	if ( stride == 0 ) {
+		stride = sizeof( PLVector3 );
+	}
+
+	PLMatrix4 m = buffer->viewProjection;
+	if ( transform != NULL ) {
+		m = PlMultiplyMatrix4( m, *transform );
+	}
+
+	RasterKernel kernel = PLG_SELECT_SIMD_KERNEL( rasterKernels, PlGetSimdLevel() );
+	for ( unsigned int i = 0; i < numTriangles; ++i ) {
+		PLVector4 clip[ 3 ];
+		for ( unsigned int j = 0; j < 3; ++j ) {
+			size_t index = ( indices != NULL ) ? indices[ i * 3 + j ] : i * 3 + j;
+			clip[ j ] = TransformPosition( &m, ( const PLVector3 * ) ( ( const uint8_t * ) positions + index * stride ) );
+		}
+
+		AddClipTriangle( buffer, kernel, clip );
+	}
+
+	buffer->isPyramidBuilt = false;
+}
+
+void PlgAddOccluderMesh( PLGOcclusionBuffer *buffer, const PLMatrix4 *transform, const PLGMesh *mesh ) {
+	if ( mesh->primitive != PLG_MESH_TRIANGLES ) {
+		PlReportErrorF( PL_RESULT_UNSUPPORTED, "unsupported mesh primitive for occlusion (%d)", mesh->primitive );
+		return;
+	}
+
+	PlgAddOccluderTriangles( buffer, transform, &mesh->vertices[ 0 ].position, sizeof( PLGVertex ), mesh->indices, mesh->num_triangles );
+}
+
+/**
+ * Builds each level of the pyramid from the one below; call this after
+ * adding the occluders, and before testing anything against them.
+ */
+void PlgBuildOcclusionPyramid( PLGOcclusionBuffer *buffer ) {
+	for ( unsigned int i = 1; i < buffer->numLevels; ++i ) {
+		const OcclusionLevel *src = &buffer->levels[ i - 1 ];
+		OcclusionLevel *dst = &buffer->levels[ i ];
+		for ( unsigned int y = 0; y < dst->height; ++y ) {
+			/* odd rows and columns at the edge are folded into the last texel */
+			const float *row0 = &src->depth[ y * 2 * src->stride ];
+			const float *row1 = ( y * 2 + 1 < src->height ) ? row0 + src->stride : row0;
+			float *out = &dst->depth[ y * dst->stride ];
+			for ( unsigned int x = 0; x < dst->width; ++x ) {
+				unsigned int x0 = x * 2;
+				unsigned int x1 = ( x0 + 1 < src->width ) ? x0 + 1 : x0;
+				out[ x ] = fmaxf( fmaxf( row0[ x0 ], row0[ x1 ] ), fmaxf( row1[ x0 ], row1[ x1 ] ) );
+			}
+		}
+	}
+
+	buffer->isPyramidBuilt = true;
+}
+
+/****************************************
+ * Testing
+ ****************************************/
+
+/* projected in batches, which then get tested one by one */
+#define PROJECT_BATCH 32
+
+typedef struct ProjectedBoxes {
+	/* normalised device coordinates, and the nearest depth */
+	float minX[ PROJECT_BATCH ], maxX[ PROJECT_BATCH ];
+	float minY[ PROJECT_BATCH ], maxY[ PROJECT_BATCH ];
+	float minZ[ PROJECT_BATCH ];
+	uint32_t clipped; /* crossing the near plane */
+} ProjectedBoxes;
+
+typedef struct ProjectJob {
+	const float *m;
+	const float *cx, *cy, *cz;
+	const float *ex, *ey, *ez;
+} ProjectJob;
+
+typedef void ( *ProjectKernel )( const ProjectJob *job, unsigned int i, unsigned int num, ProjectedBoxes *out );
+
+/* Every corner is the centre's clip position with each of the box's
+ * projected axes added or taken away in turn. */
+static void ProjectScalar( const ProjectJob *job, unsigned int i, unsigned int num, ProjectedBoxes *out ) {
+	const float *m = job->m;
+	for ( unsigned int k = 0; k < num; ++k ) {
+		unsigned int n = i + k;
+		float c[ 4 ], ax[ 4 ], ay[ 4 ], az[ 4 ];
+		for ( unsigned int r = 0; r < 4; ++r ) {
+			c[ r ] = ( ( m[ r ] * job->cx[ n ] + m[ 4 + r ] * job->cy[ n ] ) + m[ 8 + r ] * job->cz[ n ] ) + m[ 12 + r ];
+			ax[ r ] = m[ r ] * job->ex[ n ];
+			ay[ r ] = m[ 4 + r ] * job->ey[ n ];
+			az[ r ] = m[ 8 + r ] * job->ez[ n ];
+		}
+
+		bool isClipped = false;
+		float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f, minZ = 0.0f;
+		for ( unsigned int j = 0; j < 8; ++j ) {
+			float v[ 4 ];
+			for ( unsigned int r = 0; r < 4; ++r ) {
+				v[ r ] = ( j & 1 ) ? c[ r ] + ax[ r ] : c[ r ] - ax[ r ];
+				v[ r ] = ( j & 2 ) ? v[ r ] + ay[ r ] : v[ r ] - ay[ r ];
+				v[ r ] = ( j & 4 ) ? v[ r ] + az[ r ] : v[ r ] - az[ r ];
+			}
+
+			if ( !( v[ 2 ] + v[ 3 ] >= 0.0f && v[ 3 ] > 0.0f ) ) {
+				isClipped = true;
+			}
+
+			float invW = 1.0f / v[ 3 ];
+			float x = v[ 0 ] * invW, y = v[ 1 ] * invW, z = v[ 2 ] * invW;
+			if ( j == 0 ) {
+				minX = maxX = x;
+				minY = maxY = y;
+				minZ = z;
+				continue;
+			}
+
+			minX = ( minX < x ) ? minX : x;
+			maxX = ( maxX > x ) ? maxX : x;
+			minY = ( minY < y ) ? minY : y;
+			maxY = ( maxY > y ) ? maxY : y;
+			minZ = ( minZ < z ) ? minZ : z;
+		}
+
+		out->minX[ k ] = minX;
+		out->maxX[ k ] = maxX;
+		out->minY[ k ] = minY;
+		out->maxY[ k ] = maxY;
+		out->minZ[ k ] = minZ;
+		if ( isClipped ) {
+			out->clipped |= 1U << k;
+		}
+	}
+}
+
+#if defined( PL_SYSTEM_CPU_X86 )
+
+PL_TARGET_ISA( "sse2" )
+static void ProjectSse2( const ProjectJob *job, unsigned int i, unsigned int num, ProjectedBoxes *out ) {
+	const float *m = job->m;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+
+	unsigned int k = 0;
+	for ( ; k + 4 <= num; k += 4 ) {
+		unsigned int n = i + k;
+		__m128 cx = _mm_loadu_ps( &job->cx[ n ] ), cy = _mm_loadu_ps( &job->cy[ n ] ), cz = _mm_loadu_ps( &job->cz[ n ] );
+		__m128 ex = _mm_loadu_ps( &job->ex[ n ] ), ey = _mm_loadu_ps( &job->ey[ n ] ), ez = _mm_loadu_ps( &job->ez[ n ] );
+
+		__m128 c[ 4 ], ax[ 4 ], ay[ 4 ], az[ 4 ];
+		for ( unsigned int r = 0; r < 4; ++r ) {
+			c[ r ] = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m[ r ] ), cx ), _mm_mul_ps( _mm_set1_ps( m[ 4 + r ] ), cy ) ), _mm_mul_ps( _mm_set1_ps( m[ 8 + r ] ), cz ) ), _mm_set1_ps( m[ 12 + r ] ) );
+			ax[ r ] = _mm_mul_ps( _mm_set1_ps( m[ r ] ), ex );
+			ay[ r ] = _mm_mul_ps( _mm_set1_ps( m[ 4 + r ] ), ey );
+			az[ r ] = _mm_mul_ps( _mm_set1_ps( m[ 8 + r ] ), ez );
+		}
+
+		__m128 inFront = _mm_cmpeq_ps( zero, zero );
+		__m128 minX = zero, maxX = zero, minY = zero, maxY = zero, minZ = zero;
+		for ( unsigned int j = 0; j < 8; ++j ) {
+			__m128 v[ 4 ];
+			for ( unsigned int r = 0; r < 4; ++r ) {
+				v[ r ] = ( j & 1 ) ? _mm_add_ps( c[ r ], ax[ r ] ) : _mm_sub_ps( c[ r ], ax[ r ] );
+				v[ r ] = ( j & 2 ) ? _mm_add_ps( v[ r ], ay[ r ] ) : _mm_sub_ps( v[ r ], ay[ r ] );
+				v[ r ] = ( j & 4 ) ? _mm_add_ps( v[ r ], az[ r ] ) : _mm_sub_ps( v[ r ], az[ r ] );
+			}
+
+			inFront = _mm_and_ps( inFront, _mm_and_ps( _mm_cmpge_ps( _mm_add_ps( v[ 2 ], v[ 3 ] ), zero ), _mm_cmpgt_ps( v[ 3 ], zero ) ) );
+
+			__m128 invW = _mm_div_ps( one, v[ 3 ] );
+			__m128 x = _mm_mul_ps( v[ 0 ], invW ), y = _mm_mul_ps( v[ 1 ], invW ), z = _mm_mul_ps( v[ 2 ], invW );
+			if ( j == 0 ) {
+				minX = maxX = x;
+				minY = maxY = y;
+				minZ = z;
+				continue;
+			}
+
+			minX = _mm_min_ps( minX, x );
+			maxX = _mm_max_ps( maxX, x );
+			minY = _mm_min_ps( minY, y );
+			maxY = _mm_max_ps( maxY, y );
+			minZ = _mm_min_ps( minZ, z );
+		}
+
+		_mm_storeu_ps( &out->minX[ k ], minX );
+		_mm_storeu_ps( &out->maxX[ k ], maxX );
+		_mm_storeu_ps( &out->minY[ k ], minY );
+		_mm_storeu_ps( &out->maxY[ k ], maxY );
+		_mm_storeu_ps( &out->minZ[ k ], minZ );
+		out->clipped |= ( ( unsigned int ) _mm_movemask_ps( inFront ) ^ 0xFU ) << k;
+	}
+
+	if ( k < num ) {
+		ProjectedBoxes tail = { .clipped = 0 };
+		ProjectScalar( job, i + k, num - k, &tail );
+		for ( unsigned int j = 0; k + j < num; ++j ) {
+			out->minX[ k + j ] = tail.minX[ j ];
+			out->maxX[ k + j ] = tail.maxX[ j ];
+			out->minY[ k + j ] = tail.minY[ j ];
+			out->maxY[ k + j ] = tail.maxY[ j ];
+			out->minZ[ k + j ] = tail.minZ[ j ];
+		}
+		out->clipped |= tail.clipped << k;
+	}
+}
+
+PL_TARGET_ISA( "avx2" )
+static void ProjectAvx2( const ProjectJob *job, unsigned int i, unsigned int num, ProjectedBoxes *out ) {
+	const float *m = job->m;
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps( 1.0f );
+
+	unsigned int k = 0;
+	for ( ; k + 8 <= num; k += 8 ) {
+		unsigned int n = i + k;
+		__m256 cx = _mm256_loadu_ps( &job->cx[ n ] ), cy = _mm256_loadu_ps( &job->cy[ n ] ), cz = _mm256_loadu_ps( &job->cz[ n ] );
+		__m256 ex = _mm256_loadu_ps( &job->ex[ n ] ), ey = _mm256_loadu_ps( &job->ey[ n ] ), ez = _mm256_loadu_ps( &job->ez[ n ] );
+
+		__m256 c[ 4 ], ax[ 4 ], ay[ 4 ], az[ 4 ];
+		for ( unsigned int r = 0; r < 4; ++r ) {
+			c[ r ] = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( m[ r ] ), cx ), _mm256_mul_ps( _mm256_set1_ps( m[ 4 + r ] ), cy ) ), _mm256_mul_ps( _mm256_set1_ps( m[ 8 + r ] ), cz ) ), _mm256_set1_ps( m[ 12 + r ] ) );
+			ax[ r ] = _mm256_mul_ps( _mm256_set1_ps( m[ r ] ), ex );
+			ay[ r ] = _mm256_mul_ps( _mm256_set1_ps( m[ 4 + r ] ), ey );
+			az[ r ] = _mm256_mul_ps( _mm256_set1_ps( m[ 8 + r ] ), ez );
+		}
+
+		__m256 inFront = _mm256_cmp_ps( zero, zero, _CMP_EQ_OQ );
+		__m256 minX = zero, maxX = zero, minY = zero, maxY = zero, minZ = zero;
+		for ( unsigned int j = 0; j < 8; ++j ) {
+			__m256 v[ 4 ];
+			for ( unsigned int r = 0; r < 4; ++r ) {
+				v[ r ] = ( j & 1 ) ? _mm256_add_ps( c[ r ], ax[ r ] ) : _mm256_sub_ps( c[ r ], ax[ r ] );
+				v[ r ] = ( j & 2 ) ? _mm256_add_ps( v[ r ], ay[ r ] ) : _mm256_sub_ps( v[ r ], ay[ r ] );
+				v[ r ] = ( j & 4 ) ? _mm256_add_ps( v[ r ], az[ r ] ) : _mm256_sub_ps( v[ r ], az[ r ] );
+			}
+
+			inFront = _mm256_and_ps( inFront, _mm256_and_ps( _mm256_cmp_ps( _mm256_add_ps( v[ 2 ], v[ 3 ] ), zero, _CMP_GE_OQ ), _mm256_cmp_ps( v[ 3 ], zero, _CMP_GT_OQ ) ) );
+
+			__m256 invW = _mm256_div_ps( one, v[ 3 ] );
+			__m256 x = _mm256_mul_ps( v[ 0 ], invW ), y = _mm256_mul_ps( v[ 1 ], invW ), z = _mm256_mul_ps( v[ 2 ], invW );
+			if ( j == 0 ) {
+				minX = maxX = x;
+				minY = maxY = y;
+				minZ = z;
+				continue;
+			}
+
+			minX = _mm256_min_ps( minX, x );
+			maxX = _mm256_max_ps( maxX, x );
+			minY = _mm256_min_ps( minY, y );
+			maxY = _mm256_max_ps( maxY, y );
+			minZ = _mm256_min_ps( minZ, z );
+		}
+
+		_mm256_storeu_ps( &out->minX[ k ], minX );
+		_mm256_storeu_ps( &out->maxX[ k ], maxX );
+		_mm256_storeu_ps( &out->minY[ k ], minY );
+		_mm256_storeu_ps( &out->maxY[ k ], maxY );
+		_mm256_storeu_ps( &out->minZ[ k ], minZ );
+		out->clipped |= ( ( unsigned int ) _mm256_movemask_ps( inFront ) ^ 0xFFU ) << k;
+	}
+
+	/* sse2 picks up whatever's left, which in turn leaves the rest to scalar */
+	if ( k < num ) {
+		ProjectedBoxes tail = { .clipped = 0 };
+		ProjectSse2( job, i + k, num - k, &tail );
+		for ( unsigned int j = 0; k + j < num; ++j ) {
+			out->minX[ k + j ] = tail.minX[ j ];
+			out->maxX[ k + j ] = tail.maxX[ j ];
+			out->minY[ k + j ] = tail.minY[ j ];
+			out->maxY[ k + j ] = tail.maxY[ j ];
+			out->minZ[ k + j ] = tail.minZ[ j ];
+		}
+		out->clipped |= tail.clipped << k;
+	}
+}
+
+#endif
+
+/****************************************
+ ****************************************/
+
+/* indexed by PLSimdLevel, falling back to the level below if NULL */
+static const ProjectKernel projectKernels[] = { ProjectScalar, SSE2_KERNEL( ProjectSse2 ), AVX2_KERNEL( ProjectAvx2 ) };
+
+static bool IsProjectionOccluded( const PLGOcclusionBuffer *buffer, const ProjectedBoxes *boxes, unsigned int k ) {
+	if ( boxes->clipped & ( 1U << k ) ) {
+		return false;
+	}
+
+	const OcclusionLevel *base = &buffer->levels[ 0 ];
+	float x0 = boxes->minX[ k ] * buffer->halfWidth + buffer->halfWidth;
+	float x1 = boxes->maxX[ k ] * buffer->halfWidth + buffer->halfWidth;
+	float y0 = buffer->halfHeight - boxes->maxY[ k ] * buffer->halfHeight;
+	float y1 = buffer->halfHeight - boxes->minY[ k ] * buffer->halfHeight;
+	/* off the screen, which is up to frustum culling */
+	if ( !( x1 >= 0.0f && x0 < ( float ) base->width && y1 >= 0.0f && y0 < ( float ) base->height ) ) {
+		return false;
+	}
+
+	unsigned int minX = ( x0 > 0.0f ) ? ( unsigned int ) x0 : 0;
+	unsigned int maxX = ( x1 < ( float ) base->width ) ? ( unsigned int ) x1 : base->width - 1;
+	unsigned int minY = ( y0 > 0.0f ) ? ( unsigned int ) y0 : 0;
+	unsigned int maxY = ( y1 < ( float ) base->height ) ? ( unsigned int ) y1 : base->height - 1;
+
+	/* go up until the bounds cover no more than 4x4 texels */
+	unsigned int l = 0;
+	unsigned int maxLevel = buffer->isPyramidBuilt ? buffer->numLevels - 1 : 0;
+	while ( l < maxLevel && ( ( maxX >> l ) - ( minX >> l ) > 3 || ( maxY >> l ) - ( minY >> l ) > 3 ) ) {
+		l++;
+	}
+
+	const OcclusionLevel *level = &buffer->levels[ l ];
+	float minZ = boxes->minZ[ k ];
+	for ( unsigned int y = minY >> l; y <= maxY >> l; ++y ) {
+		const float *row = &level->depth[ y * level->stride ];
+		for ( unsigned int x = minX >> l; x <= maxX >> l; ++x ) {
+			if ( !( minZ > row[ x ] ) ) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Checks whether the given box is entirely hidden behind the occluders.
+ */
+bool PlgIsBoxOccluded( const PLGOcclusionBuffer *buffer, const PLCollisionAABB *bounds ) {
+	PLVector3 mins = PlAddVector3( bounds->mins, bounds->origin );
+	PLVector3 maxs = PlAddVector3( bounds->maxs, bounds->origin );
+	PLVector3 centre = PlScaleVector3F( PlAddVector3( mins, maxs ), 0.5f );
+	PLVector3 extents = PlScaleVector3F( PlSubtractVector3( maxs, mins ), 0.5f );
+
+	ProjectJob job = {
+	        .m = buffer->viewProjection.m,
+	        .cx = &centre.x,
+	        .cy = &centre.y,
+	        .cz = &centre.z,
+	        .ex = &extents.x,
+	        .ey = &extents.y,
+	        .ez = &extents.z,
+	};
+
+	ProjectedBoxes boxes = { .clipped = 0 };
+	ProjectScalar( &job, 0, 1, &boxes );
+
+	return IsProjectionOccluded( buffer, &boxes, 0 );
+}
+
+/**
+ * Tests a batch of boxes, given by their centres and extents, against the
+ * occluders, returning how many are visible; the results are written out
+ * the same way as PlCullBoxes, and either visibleBits or visibleIndices
+ * may be NULL.
+ */
+unsigned int PlgTestOcclusionBoxes( const PLGOcclusionBuffer *buffer, const PLVector3SoA *centres, const PLVector3SoA *extents, unsigned int num, uint32_t *visibleBits, unsigned int *visibleIndices ) {
+	if ( visibleBits != NULL ) {
+		memset( visibleBits, 0, PL_CULL_BITSET_WORDS( num ) * sizeof( uint32_t ) );
+	}
+
+	ProjectJob job = {
+	        .m = buffer->viewProjection.m,
+	        .cx = centres->x,
+	        .cy = centres->y,
+	        .cz = centres->z,
+	        .ex = extents->x,
+	        .ey = extents->y,
+	        .ez = extents->z,
+	};
+
+	ProjectKernel kernel = PLG_SELECT_SIMD_KERNEL( projectKernels, PlGetSimdLevel() );
+
+	unsigned int numVisible = 0;
+	for ( unsigned int i = 0; i < num; i += PROJECT_BATCH ) {
+		unsigned int batch = ( num - i < PROJECT_BATCH ) ? num - i : PROJECT_BATCH;
+
+		ProjectedBoxes boxes = { .clipped = 0 };
+		kernel( &job, i, batch, &boxes );
+
+		for ( unsigned int k = 0; k < batch; ++k ) {
+			if ( IsProjectionOccluded( buffer, &boxes, k ) ) {
+				continue;
+			}
+
+			unsigned int n = i + k;
+			if ( visibleBits != NULL ) {
+				visibleBits[ n / 32 ] |= 1U << ( n % 32 );
+			}
+			if ( visibleIndices != NULL ) {
+				visibleIndices[ numVisible ] = n;
+			}
+			numVisible++;
+		}
+	}
+
+	return numVisible;
+}
+
+/****************************************
+ * Debugging
+ ****************************************/
+
+unsigned int PlgGetOcclusionBufferLevels( const PLGOcclusionBuffer *buffer ) {
+	return buffer->numLevels;
+}
+
+/**
+ * Returns the depth stored at the given texel, or FLT_MAX if nothing's
+ * been drawn there. Levels above the first are only up to date once the
+ * pyramid has been built.
+ */
+float PlgGetOcclusionBufferDepth( const PLGOcclusionBuffer *buffer, unsigned int level, unsigned int x, unsigned int y ) {
+	if ( level >= buffer->numLevels ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid occlusion buffer level (%u >= %u)", level, buffer->numLevels );
+		return CLEAR_DEPTH;
+	}
+
+	const OcclusionLevel *l = &buffer->levels[ level ];
+	if ( x >= l->width || y >= l->height ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM3, "invalid occlusion buffer texel (%u %u)", x, y );
+		return CLEAR_DEPTH;
+	}
+
+	return l->depth[ y * l->stride + x ];
+}
+
+/**
+ * Creates a greyscale image of the given level, which can be uploaded with
+ * PlgUploadTextureImage to see what the occluders look like; the nearer
+ * something is, the brighter it's drawn, and empty space is black.
+ */
+PLImage *PlgGetOcclusionBufferImage( const PLGOcclusionBuffer *buffer, unsigned int level ) {
+	if ( level >= buffer->numLevels ) {
+		PlReportErrorF( PL_RESULT_INVALID_PARM2, "invalid occlusion buffer level (%u >= %u)", level, buffer->numLevels );
+		return NULL;
+	}
+
+	const OcclusionLevel *l = &buffer->levels[ level ];
+
+	/* spread whatever range of depths there is across the image */
+	float minZ = CLEAR_DEPTH, maxZ = -CLEAR_DEPTH;
+	for ( unsigned int y = 0; y < l->height; ++y ) {
+		const float *row = &l->depth[ y * l->stride ];
+		for ( unsigned int x = 0; x < l->width; ++x ) {
+			if ( row[ x ] == CLEAR_DEPTH ) {
+				continue;
+			}
+
+			minZ = fminf( minZ, row[ x ] );
+			maxZ = fmaxf( maxZ, row[ x ] );
+		}
+	}
+
+	PLImage *image = PlCreateImage( NULL, l->width, l->height, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	if ( image == NULL ) {
+		return NULL;
+	}
+
+	float scale = ( maxZ > minZ ) ? 191.0f / ( maxZ - minZ ) : 0.0f;
+	uint8_t *pixel = image->data[ 0 ];
+	for ( unsigned int y = 0; y < l->height; ++y ) {
+		const float *row = &l->depth[ y * l->stride ];
+		for ( unsigned int x = 0; x < l->width; ++x, pixel += 4 ) {
+			uint8_t grey = 0;
+			if ( row[ x ] != CLEAR_DEPTH ) {
+				grey = ( uint8_t ) ( 255.0f - ( row[ x ] - minZ ) * scale );
+			}
+
+			pixel[ 0 ] = pixel[ 1 ] = pixel[ 2 ] = grey;
+			pixel[ 3 ] = 255;
+		}
+	}
+
+	return image;
+}
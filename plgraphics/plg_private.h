@@ -39,6 +39,20 @@ extern int LOG_LEVEL_GRAPHICS;
 #define GfxLog( ... )
 #endif
 
+static inline PLSimdLevel _plgGetKernelLevel( PLSimdLevel level, bool hasSse2, bool hasAvx2 ) {
+	if ( level >= PL_SIMD_LEVEL_AVX2 && hasAvx2 ) {
+		return PL_SIMD_LEVEL_AVX2;
+	} else if ( level >= PL_SIMD_LEVEL_SSE2 && hasSse2 ) {
+		return PL_SIMD_LEVEL_SSE2;
+	}
+
+	return PL_SIMD_LEVEL_NONE;
+}
+
+/* picks the highest level kernel available from a table indexed by PLSimdLevel, falling back towards scalar */
+#define PLG_SELECT_SIMD_KERNEL( KERNELS, LEVEL ) \
+	( ( KERNELS )[ _plgGetKernelLevel( ( LEVEL ), ( KERNELS )[ PL_SIMD_LEVEL_SSE2 ] != NULL, ( KERNELS )[ PL_SIMD_LEVEL_AVX2 ] != NULL ) ] )
+
 typedef struct GfxState {
 	const PLGDriverImportTable *interface;
 
@@ -135,6 +135,7 @@ void PlmDrawModelSkeleton( PLMModel *model );
 
 void PlmGenerateModelNormals( PLMModel *model, bool perFace );
 void PlmGenerateModelBounds( PLMModel *model );
+PLCollisionMesh *PlmGenerateModelCollisionMesh( const PLMModel *model );
 
 enum {
 	PLM_MODEL_FILEFORMAT_ALL = 0,
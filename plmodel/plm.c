@@ -24,6 +24,8 @@ SOFTWARE.
 
 #include "plm_private.h"
 
+#include <plcore/pl_profiler.h>
+
 /* PLATFORM MODEL LOADER */
 
 typedef struct ModelLoader {
@@ -54,12 +56,18 @@ void PlmInitialize( void ) {
 #define SkeletalModelData( a ) ( a )->internal.skeletal_data
 
 void PlmGenerateModelNormals( PLMModel *model, bool perFace ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	for ( unsigned int j = 0; j < model->numMeshes; ++j ) {
 		PlgGenerateMeshNormals( model->meshes[ j ], perFace );
 	}
+
+	PL_PROFILE_END();
 }
 
 void PlmGenerateModelBounds( PLMModel *model ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	PLCollisionAABB bounds = {
 	        PLVector3( 99999, 99999, 99999 ),   /* max */
 	        PLVector3( -99999, -99999, -99999 ) /* min */
@@ -77,6 +85,22 @@ void PlmGenerateModelBounds( PLMModel *model ) {
 		}
 	}
 	model->bounds = bounds;
+
+	PL_PROFILE_END();
+}
+
+/**
+ * Builds a collision mesh from every mesh in the model, in its own space;
+ * triangles are numbered through each mesh in turn.
+ */
+PLCollisionMesh *PlmGenerateModelCollisionMesh( const PLMModel *model ) {
+	PLCollisionMesh *collisionMesh = PlCreateCollisionMesh();
+	for ( unsigned int i = 0; i < model->numMeshes; ++i ) {
+		PlgAddMeshToCollisionMesh( collisionMesh, model->meshes[ i ] );
+	}
+
+	PlBuildCollisionMesh( collisionMesh );
+	return collisionMesh;
 }
 
 bool PlmWriteModel( const char *path, PLMModel *model, PLMModelOutputType type ) {
@@ -133,8 +157,11 @@ void PlmClearModelLoaders( void ) {
 }
 
 PLMModel *PlmLoadModel( const char *path ) {
+	PL_PROFILE_FUNCTION_BEGIN();
+
 	if ( !PlFileExists( path ) ) {
 		PlReportErrorF( PL_RESULT_FILEREAD, "failed to load model, %s", path );
+		PL_PROFILE_END();
 		return NULL;
 	}
 
@@ -158,12 +185,14 @@ PLMModel *PlmLoadModel( const char *path ) {
 					}
 
 					strncpy( model->path, path, sizeof( model->path ) );
+					PL_PROFILE_END();
 					return model;
 				}
 			}
 		}
 	}
 
+	PL_PROFILE_END();
 	return NULL;
 }
 
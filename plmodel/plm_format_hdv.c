@@ -123,11 +123,12 @@ PLMModel *PlmLoadHdvModel( const char *path ) {
 	}
 
 #if 1 /* debug */
-	srand( mesh->num_verts );
+	PLRandom rng;
+	PlSeedRandom( &rng, mesh->num_verts );
 	for ( unsigned int i = 0; i < mesh->num_verts; ++i ) {
-		uint8_t r = ( uint8_t ) ( rand() % 255 );
-		uint8_t g = ( uint8_t ) ( rand() % 255 );
-		uint8_t b = ( uint8_t ) ( rand() % 255 );
+		uint8_t r = ( uint8_t ) PlRandomBoundedUInt32( &rng, 255 );
+		uint8_t g = ( uint8_t ) PlRandomBoundedUInt32( &rng, 255 );
+		uint8_t b = ( uint8_t ) PlRandomBoundedUInt32( &rng, 255 );
 		PlgSetMeshVertexPosition( mesh, i, PLVector3( -vertices[ i ].x / 100, -vertices[ i ].y / 100, vertices[ i ].z / 100 ) );
 		PlgSetMeshVertexColour( mesh, i, PLColour( r, g, b, 255 ) );
 	}
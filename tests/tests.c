@@ -27,6 +27,15 @@ For more information, please refer to <http://unlicense.org>
 
 #include <plcore/pl.h>
 #include <plcore/pl_console.h>
+#include <plcore/pl_thread.h>
+#include <plcore/pl_profiler.h>
+#include <plcore/pl_image.h>
+#include <plcore/pl_math.h>
+#include <plcore/pl_physics.h>
+
+#include <plgraphics/plg_occlusion.h>
+
+#include <float.h>
 
 enum {
 	TEST_RETURN_SUCCESS,
@@ -93,11 +102,2306 @@ FUNC_TEST( GetConsoleCommand )
 	    printf( "Failed to get test_cmd!\n" );
 	    return TEST_RETURN_FAILURE;
     }
+    /* if a name is registered twice, the first one wins */
+    PlRegisterConsoleCommand( "dup_cmd", CB_test_cmd, "first" );
+    PlRegisterConsoleCommand( "DUP_cmd", CB_test_cmd, "second" );
+    cmd = PlGetConsoleCommand( "dup_cmd" );
+    if ( cmd == NULL || strcmp( cmd->description, "first" ) != 0 ) {
+	    printf( "Expected the first dup_cmd to be found!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+FUNC_TEST( AutocompleteConsoleString )
+    static const char *names[] = { "auto_zeta", "AUTO_alpha", "auto_beta", "autumn" };
+    for ( unsigned int i = 0; i < plArrayElements( names ); ++i ) {
+	    PlRegisterConsoleCommand( names[ i ], CB_test_cmd, "testing" );
+    }
+    unsigned int numOptions;
+    const char **options = PlAutocompleteConsoleString( "auto_", &numOptions );
+    if ( numOptions != 3 ) {
+	    printf( "Expected 3 options, got %u!\n", numOptions );
+	    return TEST_RETURN_FAILURE;
+    }
+    if ( strcmp( options[ 0 ], "AUTO_alpha" ) != 0 || strcmp( options[ 1 ], "auto_beta" ) != 0 || strcmp( options[ 2 ], "auto_zeta" ) != 0 ) {
+	    printf( "Options were not sorted!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    const char *page[ 2 ];
+    unsigned int total;
+    unsigned int numPage = PlAutocompleteConsoleStringPaged( "au", 2, page, plArrayElements( page ), &total );
+    if ( total != 4 || numPage != 2 || strcmp( page[ 0 ], "auto_zeta" ) != 0 || strcmp( page[ 1 ], "autumn" ) != 0 ) {
+	    printf( "Unexpected page of options!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+#define ASYNC_LOG_THREADS  4
+#define ASYNC_LOG_MESSAGES 32
+
+static int asyncLogLevel;
+static int AsyncLogProducer( void *userData ) {
+	for ( unsigned int i = 0; i < ASYNC_LOG_MESSAGES; ++i ) {
+		PlLogMessage( asyncLogLevel, "thread %d message %u", *( int * ) userData, i );
+	}
+	return 0;
+}
+
+FUNC_TEST( AsyncLogOutput )
+    static const char *path = "tests_async.log";
+    asyncLogLevel = PlAddLogLevel( "tests/async", PL_COLOUR_WHITE, true );
+    PlSetupLogOutput( path );
+    if ( !PlSetupAsyncLogOutput( PL_LOG_OVERFLOW_BLOCK, 10 ) ) {
+	    printf( "Failed to start async log output: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PLThread *threads[ ASYNC_LOG_THREADS ];
+    int ids[ ASYNC_LOG_THREADS ];
+    for ( int i = 0; i < ASYNC_LOG_THREADS; ++i ) {
+	    ids[ i ] = i;
+	    threads[ i ] = PlCreateThread( AsyncLogProducer, &ids[ i ] );
+    }
+    for ( int i = 0; i < ASYNC_LOG_THREADS; ++i ) {
+	    PlJoinThread( threads[ i ] );
+    }
+    /* long messages should come out whole, same as without the queue */
+    char longMessage[ 2000 ];
+    memset( longMessage, 'x', sizeof( longMessage ) - 1 );
+    longMessage[ sizeof( longMessage ) - 1 ] = '\0';
+    PlLogMessage( asyncLogLevel, "%s", longMessage );
+    PlFlushLogOutput();
+    unsigned int numLines = 0, longestRun = 0;
+    FILE *file = fopen( path, "r" );
+    if ( file != NULL ) {
+	    unsigned int run = 0;
+	    for ( int ch; ( ch = fgetc( file ) ) != EOF; ) {
+		    if ( ch == '\n' ) {
+			    numLines++;
+		    }
+		    run = ( ch == 'x' ) ? run + 1 : 0;
+		    if ( run > longestRun ) {
+			    longestRun = run;
+		    }
+	    }
+	    fclose( file );
+    }
+    /* switching path while running should start the new file from scratch */
+    static const char *switchPath = "tests_async_switch.log";
+    FILE *stale = fopen( switchPath, "w" );
+    if ( stale != NULL ) {
+	    fputs( "stale\n", stale );
+	    fclose( stale );
+    }
+    int switchLevel = PlAddLogLevel( "tests/switch", PL_COLOUR_WHITE, true );
+    PlSetupAsyncLogOutput( PL_LOG_OVERFLOW_BLOCK, 5 );
+    PlSetupLogOutput( switchPath );
+    PlLogMessage( switchLevel, "after switch" );
+    PlFlushLogOutput();
+    char switchLine[ 256 ] = { '\0' };
+    unsigned int numSwitchLines = 0;
+    file = fopen( switchPath, "r" );
+    if ( file != NULL ) {
+	    for ( char line[ 256 ]; fgets( line, sizeof( line ), file ) != NULL; ++numSwitchLines ) {
+		    snprintf( switchLine, sizeof( switchLine ), "%s", line );
+	    }
+	    fclose( file );
+    }
+    PlShutdownAsyncLogOutput();
+    unlink( path );
+    unlink( switchPath );
+    if ( numSwitchLines != 1 || strstr( switchLine, "after switch" ) == NULL ) {
+	    printf( "Expected only the new message after switching log path, got %u lines!\n", numSwitchLines );
+	    return TEST_RETURN_FAILURE;
+    }
+    if ( numLines != ASYNC_LOG_THREADS * ASYNC_LOG_MESSAGES + 1 ) {
+	    printf( "Expected %u lines in log, got %u!\n", ASYNC_LOG_THREADS * ASYNC_LOG_MESSAGES + 1, numLines );
+	    return TEST_RETURN_FAILURE;
+    }
+    if ( longestRun != sizeof( longMessage ) - 1 ) {
+	    printf( "Long message was cut short, got %u of %u characters!\n", longestRun, ( unsigned int ) sizeof( longMessage ) - 1 );
+	    return TEST_RETURN_FAILURE;
+    }
+    PLLogLevelCounters counters;
+    if ( !PlGetLogLevelCounters( asyncLogLevel, &counters ) || counters.numMessages != numLines || counters.numDropped != 0 ) {
+	    printf( "Unexpected log level counters!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+FUNC_TEST( BinaryLogOutput )
+    static const char *path = "tests_binary.log";
+    static const char *decodedPath = "tests_binary.txt";
+    int level = PlAddLogLevel( "tests/binary", PL_COLOUR_WHITE, true );
+    if ( !PlSetupBinaryLogOutput( path ) ) {
+	    printf( "Failed to start binary log output: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlLogMessage( level, "int %d, unsigned %05u, hex %llx, char %c", -42, 7u, 0xdeadbeefcafeULL, 'z' );
+    PlLogMessage( level, "float %.2f, string \"%s\", clipped \"%.*s\", percent %%", 3.14159, "hello", 3, "abcdef" );
+    PlLogMessage( level, "size %zu, short %hd, width [%*d]\n", ( size_t ) 123456789, ( short ) -5, 6, 99 );
+    /* text built at runtime goes through "%s", since formats are keyed on their address */
+    char reused[ 32 ];
+    snprintf( reused, sizeof( reused ), "first from buffer" );
+    PlLogMessage( level, "%s", reused );
+    snprintf( reused, sizeof( reused ), "second from buffer" );
+    PlLogMessage( level, "%s", reused );
+    PlShutdownBinaryLogOutput();
+    FILE *out = fopen( decodedPath, "w" );
+    bool status = ( out != NULL && PlDecodeBinaryLog( path, out ) );
+    if ( out != NULL ) {
+	    fclose( out );
+    }
+    unlink( path );
+    if ( !status ) {
+	    printf( "Failed to decode binary log: %s\n", PlGetError() );
+	    unlink( decodedPath );
+	    return TEST_RETURN_FAILURE;
+    }
+    static const char *expected[] = {
+            "int -42, unsigned 00007, hex deadbeefcafe, char z\n",
+            "float 3.14, string \"hello\", clipped \"abc\", percent %\n",
+            "size 123456789, short -5, width [    99]\n",
+            "first from buffer\n",
+            "second from buffer\n",
+    };
+    unsigned int numLines = 0;
+    char line[ 256 ];
+    FILE *in = fopen( decodedPath, "r" );
+    while ( in != NULL && fgets( line, sizeof( line ), in ) != NULL ) {
+	    const char *message = strstr( line, "tests/binary: " );
+	    if ( numLines >= plArrayElements( expected ) || message == NULL || strcmp( message + 14, expected[ numLines ] ) != 0 ) {
+		    printf( "Unexpected decoded line, %s", line );
+		    fclose( in );
+		    unlink( decodedPath );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    numLines++;
+    }
+    if ( in != NULL ) {
+	    fclose( in );
+    }
+    unlink( decodedPath );
+    if ( numLines != plArrayElements( expected ) ) {
+	    printf( "Expected %u decoded lines, got %u!\n", ( unsigned int ) plArrayElements( expected ), numLines );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+FUNC_TEST( ProfilerTrace )
+    static const char *path = "tests_profile.json";
+    PlEnableProfiler( true );
+    PL_PROFILE_BEGIN( "tests/outer" );
+    PL_PROFILE_BEGIN( "tests/inner" );
+    PL_PROFILE_COUNTER( "tests/counter", 42 );
+    PL_PROFILE_END();
+    PL_PROFILE_END();
+    PlEnableProfiler( false );
+    if ( !PlWriteProfileTrace( path ) ) {
+	    printf( "Failed to write profile trace: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    char buf[ 4096 ];
+    FILE *in = fopen( path, "r" );
+    size_t length = ( in != NULL ) ? fread( buf, 1, sizeof( buf ) - 1, in ) : 0;
+    buf[ length ] = '\0';
+    if ( in != NULL ) {
+	    fclose( in );
+    }
+    unlink( path );
+    PlClearProfile();
+    static const char *expected[] = {
+            "\"traceEvents\"",
+            "\"name\":\"tests/outer\",\"cat\":\"hei\",\"ph\":\"X\"",
+            "\"name\":\"tests/inner\",\"cat\":\"hei\",\"ph\":\"X\"",
+            "\"name\":\"tests/counter\",\"ph\":\"C\"",
+    };
+    for ( unsigned int i = 0; i < plArrayElements( expected ); ++i ) {
+	    if ( strstr( buf, expected[ i ] ) == NULL ) {
+		    printf( "Expected %s in profile trace!\n", expected[ i ] );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+FUNC_TEST_END()
+
+#define CONVERT_TEST_PIXELS 1027
+
+FUNC_TEST( ConvertPixels )
+    static uint8_t src[ CONVERT_TEST_PIXELS * 8 ], scalar[ CONVERT_TEST_PIXELS * 8 ], simd[ CONVERT_TEST_PIXELS * 8 ];
+    uint32_t seed = 0x12345678;
+    for ( unsigned int i = 0; i < sizeof( src ); ++i ) {
+	    seed = seed * 1664525 + 1013904223;
+	    src[ i ] = ( uint8_t ) ( seed >> 24 );
+    }
+    /* the scalar paths are the reference for the vectorised ones */
+    for ( PLImageFormat in = PL_IMAGEFORMAT_RGB4; in <= PL_IMAGEFORMAT_RGBA16F; ++in ) {
+	    for ( PLImageFormat out = PL_IMAGEFORMAT_RGB4; out <= PL_IMAGEFORMAT_RGBA16F; ++out ) {
+		    size_t size = PlImageBytesPerPixel( out ) * CONVERT_TEST_PIXELS;
+		    PlSetSimdLevel( PL_SIMD_LEVEL_NONE );
+		    PlConvertPixels( src, in, scalar, out, CONVERT_TEST_PIXELS );
+		    for ( PLSimdLevel level = PL_SIMD_LEVEL_SSE2; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+			    PlSetSimdLevel( level );
+			    PlConvertPixels( src, in, simd, out, CONVERT_TEST_PIXELS );
+			    if ( memcmp( scalar, simd, size ) != 0 ) {
+				    printf( "Mismatch between scalar and SIMD level %d conversion from %d to %d!\n", level, in, out );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+    }
+    /* wider formats must hold RGBA8 without loss */
+    static const PLImageFormat wideFormats[] = { PL_IMAGEFORMAT_RGBA12, PL_IMAGEFORMAT_RGBA16, PL_IMAGEFORMAT_RGBA16F };
+    for ( unsigned int i = 0; i < plArrayElements( wideFormats ); ++i ) {
+	    PlConvertPixels( src, PL_IMAGEFORMAT_RGBA8, simd, wideFormats[ i ], CONVERT_TEST_PIXELS );
+	    PlConvertPixels( simd, wideFormats[ i ], scalar, PL_IMAGEFORMAT_RGBA8, CONVERT_TEST_PIXELS );
+	    if ( memcmp( src, scalar, CONVERT_TEST_PIXELS * 4 ) != 0 ) {
+		    printf( "RGBA8 didn't survive a round trip through %d!\n", wideFormats[ i ] );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    static const uint8_t red[] = { 0xf8, 0x01 };
+    uint8_t rgba[ 4 ];
+    PlConvertPixels( red, PL_IMAGEFORMAT_RGB5A1, rgba, PL_IMAGEFORMAT_RGBA8, 1 );
+    if ( rgba[ 0 ] != 255 || rgba[ 1 ] != 0 || rgba[ 2 ] != 0 || rgba[ 3 ] != 255 ) {
+	    printf( "Unexpected RGB5A1 conversion: %u %u %u %u\n", rgba[ 0 ], rgba[ 1 ], rgba[ 2 ], rgba[ 3 ] );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+#define BC_TEST_WIDTH  517 /* odd sizes, to catch the partial blocks */
+#define BC_TEST_HEIGHT 301
+
+FUNC_TEST( DecodeBlockCompressed )
+    /* red and blue endpoints, with the indices walking through the palette */
+    static const uint8_t bc1[ 8 ] = { 0x00, 0xf8, 0x1f, 0x00, 0xe4, 0xe4, 0xe4, 0xe4 };
+    PLImage *image = PlCreateImage( ( uint8_t * ) bc1, 4, 4, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGB_DXT1 );
+    if ( !PlConvertPixelFormat( image, PL_IMAGEFORMAT_RGBA8 ) ) {
+	    printf( "Failed to decode BC1 block: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    static const uint8_t expected[ 16 ] = { 255, 0, 0, 255, 0, 0, 255, 255, 170, 0, 85, 255, 85, 0, 170, 255 };
+    if ( memcmp( image->data[ 0 ], expected, sizeof( expected ) ) != 0 ) {
+	    printf( "Unexpected BC1 decode!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    /* large enough to be decoded across threads, and compared against the scalar path */
+    static const PLImageFormat formats[] = { PL_IMAGEFORMAT_RGBA_DXT1, PL_IMAGEFORMAT_RGB_DXT1, PL_IMAGEFORMAT_RGBA_DXT3,
+                                             PL_IMAGEFORMAT_RGBA_DXT5, PL_IMAGEFORMAT_R_BC4, PL_IMAGEFORMAT_RG_BC5 };
+    for ( unsigned int i = 0; i < plArrayElements( formats ); ++i ) {
+	    unsigned int size = PlGetImageSize( formats[ i ], BC_TEST_WIDTH, BC_TEST_HEIGHT );
+	    uint8_t *blocks = pl_malloc( size );
+	    uint32_t seed = 0x12345678;
+	    for ( unsigned int j = 0; j < size; ++j ) {
+		    seed = seed * 1664525 + 1013904223;
+		    blocks[ j ] = ( uint8_t ) ( seed >> 24 );
+	    }
+	    PLImage *images[ 2 ];
+	    for ( unsigned int j = 0; j < 2; ++j ) {
+		    PlSetSimdLevel( ( j == 0 ) ? PL_SIMD_LEVEL_NONE : PL_SIMD_LEVEL_AVX2 );
+		    images[ j ] = PlCreateImage( blocks, BC_TEST_WIDTH, BC_TEST_HEIGHT, PL_COLOURFORMAT_RGBA, formats[ i ] );
+		    PlConvertPixelFormat( images[ j ], PL_IMAGEFORMAT_RGBA8 );
+	    }
+	    bool status = ( images[ 0 ]->format == PL_IMAGEFORMAT_RGBA8 && images[ 0 ]->size == images[ 1 ]->size &&
+	                    memcmp( images[ 0 ]->data[ 0 ], images[ 1 ]->data[ 0 ], images[ 0 ]->size ) == 0 );
+	    PlDestroyImage( images[ 0 ] );
+	    PlDestroyImage( images[ 1 ] );
+	    pl_free( blocks );
+	    if ( !status ) {
+		    printf( "Mismatch between scalar and SIMD decode of %d!\n", formats[ i ] );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+FUNC_TEST_END()
+
+#define COMPRESS_TEST_SIZE 256
+
+/* peak signal-to-noise ratio over the first numChannels of each pixel */
+static double GetImagePSNR( const uint8_t *a, const uint8_t *b, unsigned int numPixels, unsigned int numChannels ) {
+	double error = 0.0;
+	for ( unsigned int i = 0; i < numPixels; ++i ) {
+		for ( unsigned int c = 0; c < numChannels; ++c ) {
+			double d = ( double ) a[ i * 4 + c ] - ( double ) b[ i * 4 + c ];
+			error += d * d;
+		}
+	}
+	error /= ( double ) numPixels * numChannels;
+	return ( error > 0.0 ) ? 10.0 * log10( 255.0 * 255.0 / error ) : 100.0;
+}
+
+FUNC_TEST( CompressBlockCompressed )
+    /* smooth gradients with a little noise, much like a typical texture */
+    unsigned int numPixels = COMPRESS_TEST_SIZE * COMPRESS_TEST_SIZE;
+    uint8_t *pixels = pl_malloc( numPixels * 4 );
+    uint32_t seed = 0x12345678;
+    for ( unsigned int y = 0; y < COMPRESS_TEST_SIZE; ++y ) {
+	    for ( unsigned int x = 0; x < COMPRESS_TEST_SIZE; ++x ) {
+		    seed = seed * 1664525 + 1013904223;
+		    uint8_t *p = &pixels[ ( y * COMPRESS_TEST_SIZE + x ) * 4 ];
+		    p[ 0 ] = ( uint8_t ) PlClamp( 0, ( int ) x + ( int ) ( ( seed >> 24 ) & 7 ) - 4, 255 );
+		    p[ 1 ] = ( uint8_t ) PlClamp( 0, ( int ) y + ( int ) ( ( seed >> 16 ) & 7 ) - 4, 255 );
+		    p[ 2 ] = ( uint8_t ) ( ( x + y ) / 2 );
+		    p[ 3 ] = ( uint8_t ) ( 255 - y );
+	    }
+    }
+    static const PLImageFormat formats[] = { PL_IMAGEFORMAT_RGB_DXT1, PL_IMAGEFORMAT_RGBA_DXT5 };
+    for ( unsigned int i = 0; i < plArrayElements( formats ); ++i ) {
+	    unsigned int numChannels = ( formats[ i ] == PL_IMAGEFORMAT_RGBA_DXT5 ) ? 4 : 3;
+	    double psnr[ 2 ];
+	    for ( unsigned int j = 0; j < 2; ++j ) {
+		    /* both quality levels should match between the scalar and vectorised paths */
+		    PLImage *images[ 2 ];
+		    for ( unsigned int k = 0; k < 2; ++k ) {
+			    PlSetSimdLevel( ( k == 0 ) ? PL_SIMD_LEVEL_NONE : PL_SIMD_LEVEL_AVX2 );
+			    images[ k ] = PlCreateImage( pixels, COMPRESS_TEST_SIZE, COMPRESS_TEST_SIZE, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+			    if ( !PlCompressImage( images[ k ], formats[ i ], ( PLImageCompressionQuality ) j ) ) {
+				    printf( "Failed to compress image: %s\n", PlGetError() );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+		    bool status = ( images[ 0 ]->size == images[ 1 ]->size && memcmp( images[ 0 ]->data[ 0 ], images[ 1 ]->data[ 0 ], images[ 0 ]->size ) == 0 );
+		    status = status && PlConvertPixelFormat( images[ 0 ], PL_IMAGEFORMAT_RGBA8 );
+		    psnr[ j ] = status ? GetImagePSNR( pixels, images[ 0 ]->data[ 0 ], numPixels, numChannels ) : 0.0;
+		    PlDestroyImage( images[ 0 ] );
+		    PlDestroyImage( images[ 1 ] );
+		    if ( !status ) {
+			    printf( "Mismatch between scalar and SIMD compression of %d!\n", formats[ i ] );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+	    printf( " (%d: %.2f dB fast, %.2f dB quality)", formats[ i ], psnr[ 0 ], psnr[ 1 ] );
+	    if ( psnr[ 0 ] < 30.0 || psnr[ 1 ] < psnr[ 0 ] ) {
+		    printf( "Poor compression quality for %d!\n", formats[ i ] );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    pl_free( pixels );
+    /* transparent pixels in BC1 should come back out transparent */
+    uint8_t cutout[ 16 * 4 ];
+    for ( unsigned int i = 0; i < 16; ++i ) {
+	    cutout[ i * 4 + 0 ] = ( uint8_t ) ( i * 16 );
+	    cutout[ i * 4 + 1 ] = 128;
+	    cutout[ i * 4 + 2 ] = ( uint8_t ) ( 255 - i * 16 );
+	    cutout[ i * 4 + 3 ] = ( i & 1 ) ? 255 : 0;
+    }
+    PLImage *image = PlCreateImage( cutout, 4, 4, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+    if ( !PlCompressImage( image, PL_IMAGEFORMAT_RGBA_DXT1, PL_IMAGE_COMPRESSION_QUALITY ) || !PlConvertPixelFormat( image, PL_IMAGEFORMAT_RGBA8 ) ) {
+	    printf( "Failed to compress BC1 cutout: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    for ( unsigned int i = 0; i < 16; ++i ) {
+	    if ( image->data[ 0 ][ i * 4 + 3 ] != cutout[ i * 4 + 3 ] ) {
+		    printf( "Unexpected alpha in BC1 cutout!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    PlDestroyImage( image );
+FUNC_TEST_END()
+
+#define MIPMAP_TEST_WIDTH  37
+#define MIPMAP_TEST_HEIGHT 20
+
+static float GetCutoutCoverage( const uint8_t *pixels, unsigned int numPixels ) {
+	unsigned int covered = 0;
+	for ( unsigned int i = 0; i < numPixels; ++i ) {
+		covered += ( pixels[ i * 4 + 3 ] > 127 );
+	}
+	return ( float ) covered / ( float ) numPixels;
+}
+
+FUNC_TEST( GenerateImageMipmaps )
+    uint8_t pixels[ MIPMAP_TEST_WIDTH * MIPMAP_TEST_HEIGHT * 4 ];
+    uint32_t seed = 0x12345678;
+    for ( unsigned int i = 0; i < sizeof( pixels ); ++i ) {
+	    seed = seed * 1664525 + 1013904223;
+	    pixels[ i ] = ( uint8_t ) ( seed >> 24 );
+    }
+    /* the integer box filter should match between paths, and the chain share one allocation */
+    PLImage *images[ 2 ];
+    for ( unsigned int i = 0; i < 2; ++i ) {
+	    PlSetSimdLevel( ( i == 0 ) ? PL_SIMD_LEVEL_NONE : PL_SIMD_LEVEL_AVX2 );
+	    images[ i ] = PlCreateImage( pixels, MIPMAP_TEST_WIDTH, MIPMAP_TEST_HEIGHT, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	    if ( !PlGenerateImageMipmaps( images[ i ], PL_IMAGE_MIPMAP_FILTER_BOX, 0 ) || images[ i ]->levels != 6 ) {
+		    printf( "Failed to generate mipmaps: %s\n", PlGetError() );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    unsigned int lw = MIPMAP_TEST_WIDTH, lh = MIPMAP_TEST_HEIGHT;
+    for ( unsigned int l = 0; l < images[ 0 ]->levels; ++l ) {
+	    unsigned int size = PlGetImageSize( PL_IMAGEFORMAT_RGBA8, lw, lh );
+	    if ( memcmp( images[ 0 ]->data[ l ], images[ 1 ]->data[ l ], size ) != 0 ||
+	         ( l + 1 < images[ 0 ]->levels && images[ 0 ]->data[ l + 1 ] != images[ 0 ]->data[ l ] + size ) ) {
+		    printf( "Unexpected mipmap level %u!\n", l );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    lw = ( lw > 1 ) ? lw / 2 : 1;
+	    lh = ( lh > 1 ) ? lh / 2 : 1;
+    }
+    const uint8_t *level = images[ 0 ]->data[ 1 ];
+    if ( level[ 0 ] != ( pixels[ 0 ] + pixels[ 4 ] + pixels[ MIPMAP_TEST_WIDTH * 4 ] + pixels[ MIPMAP_TEST_WIDTH * 4 + 4 ] + 2 ) / 4 ) {
+	    printf( "Unexpected box filter result!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( images[ 0 ] );
+    PlDestroyImage( images[ 1 ] );
+    /* black and white average out to middle grey in linear space */
+    static const uint8_t stripes[ 6 ] = { 0, 0, 0, 255, 255, 255 };
+    PLImage *image = PlCreateImage( ( uint8_t * ) stripes, 2, 1, PL_COLOURFORMAT_RGB, PL_IMAGEFORMAT_RGB8 );
+    if ( !PlGenerateImageMipmaps( image, PL_IMAGE_MIPMAP_FILTER_BOX, PL_IMAGE_MIPMAP_SRGB ) || image->data[ 1 ][ 0 ] != 188 ) {
+	    printf( "Unexpected sRGB filter result!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    /* flat colour should come out flat from the Kaiser filter, whatever the format */
+    uint16_t flat[ MIPMAP_TEST_WIDTH * MIPMAP_TEST_HEIGHT * 4 ];
+    for ( unsigned int i = 0; i < plArrayElements( flat ); ++i ) {
+	    flat[ i ] = ( uint16_t ) ( 1000 * ( i % 4 ) + 12345 );
+    }
+    image = PlCreateImage( ( uint8_t * ) flat, MIPMAP_TEST_WIDTH, MIPMAP_TEST_HEIGHT, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA16 );
+    if ( !PlGenerateImageMipmaps( image, PL_IMAGE_MIPMAP_FILTER_KAISER, 0 ) ) {
+	    printf( "Failed to generate mipmaps: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    const uint16_t *last = ( const uint16_t * ) image->data[ image->levels - 1 ];
+    for ( unsigned int i = 0; i < 4; ++i ) {
+	    if ( abs( last[ i ] - flat[ i ] ) > 1 ) {
+		    printf( "Unexpected Kaiser filter result!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    PlDestroyImage( image );
+    /* sparse cutout, mostly below the alpha test, which would otherwise fade out */
+    for ( unsigned int i = 0; i < MIPMAP_TEST_WIDTH * MIPMAP_TEST_HEIGHT; ++i ) {
+	    float a = pixels[ i * 4 + 3 ] / 255.0f;
+	    pixels[ i * 4 + 3 ] = ( uint8_t ) ( a * a * a * 255.0f );
+    }
+    image = PlCreateImage( pixels, MIPMAP_TEST_WIDTH, MIPMAP_TEST_HEIGHT, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+    if ( !PlGenerateImageMipmaps( image, PL_IMAGE_MIPMAP_FILTER_BOX, PL_IMAGE_MIPMAP_PRESERVE_COVERAGE ) ) {
+	    printf( "Failed to generate mipmaps: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    float coverage = GetCutoutCoverage( image->data[ 0 ], MIPMAP_TEST_WIDTH * MIPMAP_TEST_HEIGHT );
+    float levelCoverage = GetCutoutCoverage( image->data[ 2 ], ( MIPMAP_TEST_WIDTH / 4 ) * ( MIPMAP_TEST_HEIGHT / 4 ) );
+    if ( fabsf( coverage - levelCoverage ) > 0.1f ) {
+	    printf( "Alpha coverage wasn't preserved (%.2f vs %.2f)!\n", coverage, levelCoverage );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+FUNC_TEST_END()
+
+FUNC_TEST( ResizeImage )
+    /* flat colour should stay flat, whichever way it goes */
+    uint8_t pixels[ 37 * 20 * 4 ];
+    for ( unsigned int i = 0; i < sizeof( pixels ); ++i ) {
+	    pixels[ i ] = ( uint8_t ) ( 40 * ( i % 4 ) + 7 );
+    }
+    static const PLImageResizeFilter filters[] = { PL_IMAGE_RESIZE_FILTER_BOX, PL_IMAGE_RESIZE_FILTER_BILINEAR, PL_IMAGE_RESIZE_FILTER_LANCZOS3, PL_IMAGE_RESIZE_FILTER_MITCHELL };
+    for ( unsigned int i = 0; i < plArrayElements( filters ); ++i ) {
+	    PLImage *image = PlCreateImage( pixels, 37, 20, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	    if ( !PlResizeImage( image, 64, 9, filters[ i ] ) || image->width != 64 || image->height != 9 ) {
+		    printf( "Failed to resize image: %s\n", PlGetError() );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    for ( unsigned int j = 0; j < 64 * 9 * 4; ++j ) {
+		    if ( abs( image->data[ 0 ][ j ] - pixels[ j % 4 ] ) > 1 ) {
+			    printf( "Unexpected result from resize filter %u!\n", filters[ i ] );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+	    PlDestroyImage( image );
+    }
+    /* halving with a box is a plain average */
+    static const uint8_t quad[ 4 * 4 ] = { 0, 10, 20, 30, 100, 110, 120, 130, 50, 60, 70, 80, 150, 160, 170, 180 };
+    PLImage *image = PlCreateImage( ( uint8_t * ) quad, 2, 2, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+    static const uint8_t average[ 4 ] = { 75, 85, 95, 105 };
+    if ( !PlResizeImage( image, 1, 1, PL_IMAGE_RESIZE_FILTER_BOX ) || memcmp( image->data[ 0 ], average, sizeof( average ) ) != 0 ) {
+	    printf( "Unexpected box resize result!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    /* vectorised paths should agree with the scalar one */
+    uint32_t seed = 0x12345678;
+    for ( unsigned int i = 0; i < sizeof( pixels ); ++i ) {
+	    seed = seed * 1664525 + 1013904223;
+	    pixels[ i ] = ( uint8_t ) ( seed >> 24 );
+    }
+    PLImage *images[ 2 ];
+    for ( unsigned int i = 0; i < 2; ++i ) {
+	    PlSetSimdLevel( ( i == 0 ) ? PL_SIMD_LEVEL_NONE : PL_SIMD_LEVEL_AVX2 );
+	    images[ i ] = PlCreateImage( pixels, 37, 20, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	    PlResizeImage( images[ i ], 23, 51, PL_IMAGE_RESIZE_FILTER_LANCZOS3 );
+    }
+    for ( unsigned int i = 0; i < 23 * 51 * 4; ++i ) {
+	    if ( abs( images[ 0 ]->data[ 0 ][ i ] - images[ 1 ]->data[ 0 ][ i ] ) > 1 ) {
+		    printf( "Mismatch between scalar and SIMD resize!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    PlDestroyImage( images[ 0 ] );
+    PlDestroyImage( images[ 1 ] );
+    /* legacy formats get bumped up to the next power of two */
+    image = PlCreateImage( pixels, 37, 20, PL_COLOURFORMAT_RGB, PL_IMAGEFORMAT_RGB565 );
+    if ( !PlResizeImageToPowerOfTwo( image, PL_IMAGE_RESIZE_FILTER_MITCHELL ) || image->width != 64 || image->height != 32 ||
+         image->size != PlGetImageSize( PL_IMAGEFORMAT_RGB565, 64, 32 ) ) {
+	    printf( "Failed to resize image to a power of two: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+FUNC_TEST_END()
+
+FUNC_TEST( LoadImageFromMemory )
+    /* 2x2 uncompressed true-colour tga, bottom-up and stored as bgra */
+    static const uint8_t tga[ 18 + 2 * 2 * 4 ] = {
+            0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 2, 0, 32, 8,
+            30, 20, 10, 255, 70, 60, 50, 255,
+            110, 100, 90, 128, 150, 140, 130, 0 };
+    static const uint8_t expected[ 2 * 2 * 4 ] = {
+            90, 100, 110, 128, 130, 140, 150, 0,
+            10, 20, 30, 255, 50, 60, 70, 255 };
+    PlRegisterStandardImageLoaders( PL_IMAGE_FILEFORMAT_ALL );
+    PLImage *image = PlLoadImageFromMemory( tga, sizeof( tga ), "tga" );
+    if ( image == NULL || image->width != 2 || image->height != 2 || memcmp( image->data[ 0 ], expected, sizeof( expected ) ) != 0 ) {
+	    printf( "Failed to load image from memory: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    /* without an extension every loader gets a go */
+    image = PlLoadImageFromMemory( tga, sizeof( tga ), NULL );
+    if ( image == NULL || memcmp( image->data[ 0 ], expected, sizeof( expected ) ) != 0 ) {
+	    printf( "Failed to load image from memory without an extension: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    /* and an uncached handle is streamed rather than read up front */
+    PlWriteFile( "test_image.tga", tga, sizeof( tga ) );
+    PLFile *file = PlOpenLocalFile( "test_image.tga", false );
+    image = PlLoadImageFromFile( file, NULL );
+    PlCloseFile( file );
+    if ( image == NULL || memcmp( image->data[ 0 ], expected, sizeof( expected ) ) != 0 ) {
+	    printf( "Failed to load image from file handle: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    image = PlLoadImage( "test_image.tga" );
+    if ( image == NULL || strcmp( image->path, "test_image.tga" ) != 0 || memcmp( image->data[ 0 ], expected, sizeof( expected ) ) != 0 ) {
+	    printf( "Failed to load image: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    PlDeleteFile( "test_image.tga" );
+    PlClearImageLoaders();
+FUNC_TEST_END()
+
+static void WriteTimInt( uint8_t **p, uint32_t value, unsigned int size ) {
+    for ( unsigned int i = 0; i < size; ++i ) {
+	    *( *p )++ = ( uint8_t ) ( value >> ( i * 8 ) );
+    }
+}
+
+static size_t WriteTim( uint8_t *dst, uint8_t type, const uint16_t *palette, uint16_t numColours, const uint8_t *pixels, uint16_t widthWords, uint16_t height ) {
+    uint8_t *p = dst;
+    WriteTimInt( &p, 16, 4 );
+    WriteTimInt( &p, type | ( ( palette != NULL ) ? 8 : 0 ), 4 );
+    if ( palette != NULL ) {
+	    WriteTimInt( &p, 12 + numColours * 2, 4 );
+	    WriteTimInt( &p, 0, 4 );
+	    WriteTimInt( &p, numColours, 2 );
+	    WriteTimInt( &p, 1, 2 );
+	    for ( unsigned int i = 0; i < numColours; ++i ) {
+		    WriteTimInt( &p, palette[ i ], 2 );
+	    }
+    }
+    WriteTimInt( &p, 12 + widthWords * 2 * height, 4 );
+    WriteTimInt( &p, 0, 4 );
+    WriteTimInt( &p, widthWords, 2 );
+    WriteTimInt( &p, height, 2 );
+    memcpy( p, pixels, widthWords * 2 * height );
+    return ( size_t ) ( p - dst ) + widthWords * 2 * height;
+}
+
+FUNC_TEST( LoadTimImage )
+    PlRegisterStandardImageLoaders( PL_IMAGE_FILEFORMAT_TIM );
+    static uint8_t buf[ 1024 + 128 * 16 * 2 ];
+    uint16_t palette[ 256 ];
+    uint8_t indices[ 64 * 16 ], direct[ 128 * 16 * 2 ];
+    uint32_t seed = 0x600dcafe;
+    for ( unsigned int i = 0; i < 256; ++i ) {
+	    seed = seed * 1664525 + 1013904223;
+	    palette[ i ] = ( uint16_t ) ( seed >> 16 );
+    }
+    for ( unsigned int i = 0; i < sizeof( indices ); ++i ) {
+	    seed = seed * 1664525 + 1013904223;
+	    indices[ i ] = ( uint8_t ) ( seed >> 24 );
+    }
+    /* indexed images should come out the same as the equivalent direct colour one */
+    for ( unsigned int bits = 4; bits <= 8; bits += 4 ) {
+	    unsigned int numPixels = sizeof( indices ) * 8 / bits;
+	    for ( unsigned int i = 0; i < numPixels; ++i ) {
+		    uint8_t index = ( bits == 8 ) ? indices[ i ] : ( ( i & 1 ) ? ( indices[ i / 2 ] >> 4 ) : ( indices[ i / 2 ] & 15 ) );
+		    direct[ i * 2 ] = ( uint8_t ) palette[ index ];
+		    direct[ i * 2 + 1 ] = ( uint8_t ) ( palette[ index ] >> 8 );
+	    }
+	    size_t size = WriteTim( buf, 2, NULL, 0, direct, ( uint16_t ) ( numPixels / 16 ), 16 );
+	    PLImage *expected = PlLoadImageFromMemory( buf, size, "tim" );
+	    size = WriteTim( buf, ( bits == 8 ) ? 1 : 0, palette, ( uint16_t ) ( 1 << bits ), indices, 32, 16 );
+	    for ( unsigned int level = PL_SIMD_LEVEL_NONE; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+		    PlSetSimdLevel( level );
+		    PLImage *image = PlLoadImageFromMemory( buf, size, "tim" );
+		    if ( image == NULL || expected == NULL || image->width != expected->width || image->size != expected->size ||
+		         memcmp( image->data[ 0 ], expected->data[ 0 ], image->size ) != 0 ) {
+			    printf( "Unexpected %ubpp TIM result at SIMD level %u: %s\n", bits, level, PlGetError() );
+			    return TEST_RETURN_FAILURE;
+		    }
+		    PlDestroyImage( image );
+	    }
+	    PlDestroyImage( expected );
+    }
+    /* indices past the end of the palette are rejected */
+    size_t size = WriteTim( buf, 1, palette, 16, indices, 32, 16 );
+    PLImage *image = PlLoadImageFromMemory( buf, size, "tim" );
+    if ( image != NULL ) {
+	    printf( "Loaded TIM with out-of-range palette indices!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    /* 24bpp rows are padded out to a whole number of words */
+    static const uint8_t rgb[ 8 * 2 ] = { 1, 2, 3, 4, 5, 6, 0, 0, 7, 8, 9, 10, 11, 12, 0, 0 };
+    size = WriteTim( buf, 3, NULL, 0, rgb, 4, 2 );
+    image = PlLoadImageFromMemory( buf, size, "tim" );
+    static const uint8_t expectedRgb[ 2 * 2 * 3 ] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    if ( image == NULL || image->width != 2 || image->height != 2 || image->format != PL_IMAGEFORMAT_RGB8 ||
+         memcmp( image->data[ 0 ], expectedRgb, sizeof( expectedRgb ) ) != 0 ) {
+	    printf( "Failed to load 24bpp TIM: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    PlClearImageLoaders();
+FUNC_TEST_END()
+
+FUNC_TEST( CreateImageAtlas )
+    /* every pixel records which image it came from, and where */
+    PLImage *images[ 40 ];
+    uint32_t seed = 0xa71a5;
+    for ( unsigned int i = 0; i < plArrayElements( images ); ++i ) {
+	    seed = seed * 1664525 + 1013904223;
+	    unsigned int w = 1 + ( seed >> 8 ) % 40, h = 1 + ( seed >> 20 ) % 40;
+	    images[ i ] = PlCreateImage( NULL, w, h, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	    for ( unsigned int y = 0; y < h; ++y ) {
+		    for ( unsigned int x = 0; x < w; ++x ) {
+			    uint8_t *pixel = &images[ i ]->data[ 0 ][ ( y * w + x ) * 4 ];
+			    pixel[ 0 ] = ( uint8_t ) i;
+			    pixel[ 1 ] = ( uint8_t ) x;
+			    pixel[ 2 ] = ( uint8_t ) y;
+			    pixel[ 3 ] = 255;
+		    }
+	    }
+    }
+    PLImageAtlasRect rects[ plArrayElements( images ) ];
+    PLImage *atlas = PlCreateImageAtlas( images, plArrayElements( images ), 2, 4, 1024, rects );
+    if ( atlas == NULL ) {
+	    printf( "Failed to create atlas: %s\n", PlGetError() );
+	    return TEST_RETURN_FAILURE;
+    }
+    for ( unsigned int i = 0; i < plArrayElements( images ); ++i ) {
+	    const PLImageAtlasRect *rect = &rects[ i ];
+	    if ( rect->width != images[ i ]->width || rect->height != images[ i ]->height || ( rect->x - 2 ) % 4 != 0 || ( rect->y - 2 ) % 4 != 0 ||
+	         rect->s0 != ( float ) rect->x / ( float ) atlas->width || rect->t1 != ( float ) ( rect->y + rect->height ) / ( float ) atlas->height ) {
+		    printf( "Unexpected atlas rect for image %u!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    /* padded cells shouldn't overlap */
+	    for ( unsigned int j = 0; j < i; ++j ) {
+		    if ( rect->x - 2 < rects[ j ].x + rects[ j ].width + 2 && rects[ j ].x - 2 < rect->x + rect->width + 2 &&
+		         rect->y - 2 < rects[ j ].y + rects[ j ].height + 2 && rects[ j ].y - 2 < rect->y + rect->height + 2 ) {
+			    printf( "Atlas images %u and %u overlap!\n", i, j );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+	    /* contents, including the extruded border */
+	    for ( int y = -2; y < ( int ) rect->height + 2; ++y ) {
+		    for ( int x = -2; x < ( int ) rect->width + 2; ++x ) {
+			    const uint8_t *pixel = &atlas->data[ 0 ][ ( ( rect->y + y ) * atlas->width + rect->x + x ) * 4 ];
+			    int sx = x < 0 ? 0 : ( x >= ( int ) rect->width ? ( int ) rect->width - 1 : x );
+			    int sy = y < 0 ? 0 : ( y >= ( int ) rect->height ? ( int ) rect->height - 1 : y );
+			    if ( pixel[ 0 ] != i || pixel[ 1 ] != sx || pixel[ 2 ] != sy || pixel[ 3 ] != 255 ) {
+				    printf( "Unexpected atlas pixel for image %u at %d %d!\n", i, x, y );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+    }
+    PlDestroyImage( atlas );
+    /* equally sized tiles should pack without any waste */
+    for ( unsigned int i = 0; i < plArrayElements( images ); ++i ) {
+	    PlDestroyImage( images[ i ] );
+	    images[ i ] = PlCreateImage( NULL, 16, 8, PL_COLOURFORMAT_RGB, PL_IMAGEFORMAT_RGB565 );
+    }
+    atlas = PlCreateImageAtlas( images, 32, 0, 1, 1024, rects );
+    if ( atlas == NULL || atlas->width * atlas->height != 32 * 16 * 8 ) {
+	    printf( "Unexpected atlas size for equally sized tiles!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( atlas );
+    /* and anything too big to fit is rejected */
+    if ( PlCreateImageAtlas( images, plArrayElements( images ), 0, 1, 32, rects ) != NULL ) {
+	    printf( "Created an atlas beyond the maximum size!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    for ( unsigned int i = 0; i < plArrayElements( images ); ++i ) {
+	    PlDestroyImage( images[ i ] );
+    }
+FUNC_TEST_END()
+
+static const struct {
+	PLImageFormat format;
+	bool hasAlpha;
+	int tolerance; /* after going through RGBA8 */
+} transformFormats[] = {
+        { PL_IMAGEFORMAT_RGB4, false, 9 },
+        { PL_IMAGEFORMAT_RGBA4, true, 9 },
+        { PL_IMAGEFORMAT_RGB5, false, 5 },
+        { PL_IMAGEFORMAT_RGB5A1, true, 5 },
+        { PL_IMAGEFORMAT_RGB565, false, 5 },
+        { PL_IMAGEFORMAT_RGB8, false, 1 },
+        { PL_IMAGEFORMAT_RGBA8, true, 1 },
+        { PL_IMAGEFORMAT_RGBA12, true, 1 },
+        { PL_IMAGEFORMAT_RGBA16, true, 1 },
+        { PL_IMAGEFORMAT_RGBA16F, true, 1 },
+};
+
+static PLImage *CreateTransformImage( PLImageFormat format, unsigned int w, unsigned int h, uint32_t seed ) {
+	PLImage *image = PlCreateImage( NULL, w, h, PL_COLOURFORMAT_RGBA, PL_IMAGEFORMAT_RGBA8 );
+	for ( unsigned int i = 0; i < w * h * 4; ++i ) {
+		seed = seed * 1664525 + 1013904223;
+		image->data[ 0 ][ i ] = ( uint8_t ) ( seed >> 24 );
+	}
+	PlConvertPixelFormat( image, format );
+	return image;
+}
+
+/* where the pixel at x, y of a transformed level came from, given its original size */
+static void GetTransformSource( unsigned int op, unsigned int w, unsigned int h, unsigned int x, unsigned int y, unsigned int *sx, unsigned int *sy ) {
+	switch ( op ) {
+		case 0: /* vertical flip */
+			*sx = x, *sy = h - 1 - y;
+			break;
+		case 1: /* horizontal flip */
+			*sx = w - 1 - x, *sy = y;
+			break;
+		case 2: /* 90 */
+			*sx = y, *sy = h - 1 - x;
+			break;
+		case 3: /* 180 */
+			*sx = w - 1 - x, *sy = h - 1 - y;
+			break;
+		default: /* 270 */
+			*sx = w - 1 - y, *sy = x;
+			break;
+	}
+}
+
+FUNC_TEST( TransformImage )
+    /* every level of every format, wide enough for each of the vector paths */
+    for ( unsigned int i = 0; i < plArrayElements( transformFormats ); ++i ) {
+	    for ( unsigned int op = 0; op < 5; ++op ) {
+		    for ( unsigned int j = 0; j < 2; ++j ) {
+			    PlSetSimdLevel( ( j == 0 ) ? PL_SIMD_LEVEL_NONE : PL_SIMD_LEVEL_AVX2 );
+			    PLImage *original = CreateTransformImage( transformFormats[ i ].format, 101, 37, 0x7f4a );
+			    PLImage *image = CreateTransformImage( transformFormats[ i ].format, 101, 37, 0x7f4a );
+			    PlGenerateImageMipmaps( original, PL_IMAGE_MIPMAP_FILTER_BOX, 0 );
+			    PlGenerateImageMipmaps( image, PL_IMAGE_MIPMAP_FILTER_BOX, 0 );
+			    bool status;
+			    switch ( op ) {
+				    case 0:
+					    status = PlFlipImageVertical( image );
+					    break;
+				    case 1:
+					    status = PlFlipImageHorizontal( image );
+					    break;
+				    default:
+					    status = PlRotateImage( image, ( PLImageRotation ) ( PL_IMAGE_ROTATE_90 + op - 2 ) );
+					    break;
+			    }
+			    bool turned = ( op == 2 || op == 4 );
+			    if ( !status || image->levels != original->levels || image->width != ( turned ? 37 : 101 ) || image->height != ( turned ? 101 : 37 ) ) {
+				    printf( "Failed to transform image (%u, %u): %s\n", transformFormats[ i ].format, op, PlGetError() );
+				    return TEST_RETURN_FAILURE;
+			    }
+			    unsigned int bpp = PlImageBytesPerPixel( image->format );
+			    for ( unsigned int l = 0; l < image->levels; ++l ) {
+				    unsigned int w = ( original->width >> l ) ? ( original->width >> l ) : 1;
+				    unsigned int h = ( original->height >> l ) ? ( original->height >> l ) : 1;
+				    unsigned int dw = turned ? h : w, dh = turned ? w : h;
+				    for ( unsigned int y = 0; y < dh; ++y ) {
+					    for ( unsigned int x = 0; x < dw; ++x ) {
+						    unsigned int sx, sy;
+						    GetTransformSource( op, w, h, x, y, &sx, &sy );
+						    if ( memcmp( &image->data[ l ][ ( y * dw + x ) * bpp ], &original->data[ l ][ ( sy * w + sx ) * bpp ], bpp ) != 0 ) {
+							    printf( "Unexpected pixel after transform (%u, %u) at level %u, %u %u!\n", transformFormats[ i ].format, op, l, x, y );
+							    return TEST_RETURN_FAILURE;
+						    }
+					    }
+				    }
+			    }
+			    PlDestroyImage( original );
+			    PlDestroyImage( image );
+		    }
+	    }
+    }
+    /* four quarter turns should get back to where it started */
+    PLImage *original = CreateTransformImage( PL_IMAGEFORMAT_RGBA8, 13, 70, 0x1234 );
+    PLImage *image = CreateTransformImage( PL_IMAGEFORMAT_RGBA8, 13, 70, 0x1234 );
+    for ( unsigned int i = 0; i < 4; ++i ) {
+	    PlRotateImage( image, PL_IMAGE_ROTATE_270 );
+    }
+    if ( image->width != 13 || image->height != 70 || memcmp( image->data[ 0 ], original->data[ 0 ], image->size ) != 0 ) {
+	    printf( "Rotating an image all the way around changed it!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( original );
+    PlDestroyImage( image );
+FUNC_TEST_END()
+
+FUNC_TEST( TransformImageColour )
+    static const uint8_t swizzles[][ 4 ] = { { 2, 1, 0, 3 }, { 3, 0, 1, 2 } };
+    const PLColour target = PLColour( 10, 200, 30, 255 );
+    const PLColour dest = PLColour( 250, 5, 128, 64 );
+    for ( unsigned int i = 0; i < plArrayElements( transformFormats ); ++i ) {
+	    PLImageFormat format = transformFormats[ i ].format;
+	    unsigned int bpp = PlImageBytesPerPixel( format );
+	    int tolerance = transformFormats[ i ].tolerance;
+	    for ( unsigned int j = 0; j < 2; ++j ) {
+		    PlSetSimdLevel( ( j == 0 ) ? PL_SIMD_LEVEL_NONE : PL_SIMD_LEVEL_AVX2 );
+		    PLImage *original = CreateTransformImage( format, 67, 3, 0xc0102 );
+		    PlConvertPixels( ( const uint8_t * ) &target, PL_IMAGEFORMAT_RGBA8, &original->data[ 0 ][ 5 * bpp ], format, 1 );
+		    PLImage *images[ 5 ];
+		    for ( unsigned int k = 0; k < plArrayElements( images ); ++k ) {
+			    images[ k ] = CreateTransformImage( format, 67, 3, 0xc0102 );
+			    memcpy( images[ k ]->data[ 0 ], original->data[ 0 ], original->size );
+		    }
+		    PlInvertImageColour( images[ 0 ] );
+		    PlSwizzleImageChannels( images[ 1 ], swizzles[ 0 ] );
+		    PlSwizzleImageChannels( images[ 2 ], swizzles[ 1 ] );
+		    PlPremultiplyImageAlpha( images[ 3 ] );
+		    PlReplaceImageColour( images[ 4 ], target, dest );
+		    /* replacement is exact, within the format */
+		    uint8_t t[ 8 ], d[ 8 ];
+		    PlConvertPixels( ( const uint8_t * ) &target, PL_IMAGEFORMAT_RGBA8, t, format, 1 );
+		    PlConvertPixels( ( const uint8_t * ) &dest, PL_IMAGEFORMAT_RGBA8, d, format, 1 );
+		    for ( unsigned int k = 0; k < 67 * 3; ++k ) {
+			    const uint8_t *before = &original->data[ 0 ][ k * bpp ];
+			    const uint8_t *after = &images[ 4 ]->data[ 0 ][ k * bpp ];
+			    if ( memcmp( after, ( memcmp( before, t, bpp ) == 0 ) ? d : before, bpp ) != 0 || ( k == 5 && memcmp( after, d, bpp ) != 0 ) ) {
+				    printf( "Unexpected colour replacement (%u) at %u!\n", format, k );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+		    /* everything else is compared as RGBA8 */
+		    for ( unsigned int k = 0; k < plArrayElements( images ); ++k ) {
+			    PlConvertPixelFormat( images[ k ], PL_IMAGEFORMAT_RGBA8 );
+		    }
+		    PlConvertPixelFormat( original, PL_IMAGEFORMAT_RGBA8 );
+		    /* channels may be moved somewhere with fewer bits, so requantise what's expected */
+		    uint8_t swizzled[ 2 ][ 67 * 3 * 4 ], packed[ 67 * 3 * 8 ];
+		    for ( unsigned int k = 0; k < 2; ++k ) {
+			    for ( unsigned int p = 0; p < 67 * 3 * 4; ++p ) {
+				    swizzled[ k ][ p ] = original->data[ 0 ][ p - p % 4 + swizzles[ k ][ p % 4 ] ];
+			    }
+			    PlConvertPixels( swizzled[ k ], PL_IMAGEFORMAT_RGBA8, packed, format, 67 * 3 );
+			    PlConvertPixels( packed, format, swizzled[ k ], PL_IMAGEFORMAT_RGBA8, 67 * 3 );
+		    }
+		    unsigned int numChannels = transformFormats[ i ].hasAlpha ? 4 : 3;
+		    for ( unsigned int k = 0; k < 67 * 3; ++k ) {
+			    const uint8_t *o = &original->data[ 0 ][ k * 4 ];
+			    for ( unsigned int c = 0; c < numChannels; ++c ) {
+				    int inverted = ( c < 3 ) ? 255 - o[ c ] : o[ c ];
+				    int premultiplied = ( c < 3 ) ? ( o[ c ] * o[ 3 ] + 127 ) / 255 : o[ c ];
+				    if ( abs( images[ 0 ]->data[ 0 ][ k * 4 + c ] - inverted ) > tolerance ||
+				         images[ 1 ]->data[ 0 ][ k * 4 + c ] != swizzled[ 0 ][ k * 4 + c ] ||
+				         images[ 2 ]->data[ 0 ][ k * 4 + c ] != swizzled[ 1 ][ k * 4 + c ] ||
+				         abs( images[ 3 ]->data[ 0 ][ k * 4 + c ] - premultiplied ) > tolerance ) {
+					    printf( "Unexpected colour transform result (%u) at %u!\n", format, k );
+					    return TEST_RETURN_FAILURE;
+				    }
+			    }
+		    }
+		    for ( unsigned int k = 0; k < plArrayElements( images ); ++k ) {
+			    PlDestroyImage( images[ k ] );
+		    }
+		    PlDestroyImage( original );
+	    }
+    }
+FUNC_TEST_END()
+
+/*============================================================
+ * MATH
+ ===========================================================*/
+
+static float RandomMathFloat( uint32_t *seed ) {
+	*seed = *seed * 1664525 + 1013904223;
+	return ( ( float ) ( *seed >> 8 ) / 8388608.0f - 1.0f ) * 4.0f;
+}
+
+FUNC_TEST( SimdMathMatchesScalar )
+    uint32_t seed = 0x3a7f;
+    for ( unsigned int i = 0; i < 4096; ++i ) {
+	    PL_ALIGNED( 16 ) PLMatrix4 a, b, out;
+	    PLVector4 v4;
+	    PLQuaternion q, q2;
+	    for ( unsigned int j = 0; j < 16; ++j ) {
+		    a.m[ j ] = RandomMathFloat( &seed );
+		    b.m[ j ] = RandomMathFloat( &seed );
+	    }
+	    v4 = PLVector4( RandomMathFloat( &seed ), RandomMathFloat( &seed ), RandomMathFloat( &seed ), RandomMathFloat( &seed ) );
+	    q = PLQuaternion( RandomMathFloat( &seed ), RandomMathFloat( &seed ), RandomMathFloat( &seed ), RandomMathFloat( &seed ) );
+	    q2 = PLQuaternion( RandomMathFloat( &seed ), RandomMathFloat( &seed ), RandomMathFloat( &seed ), RandomMathFloat( &seed ) );
+	    PLVector3 v = PLVector3( v4.x, v4.y, v4.z );
+
+	    PLMatrix4 m = PlMultiplyMatrix4Scalar( a, b );
+	    PlMultiplyMatrix4A( &out, &a, &b );
+	    bool matches = memcmp( &m, &out, sizeof( PLMatrix4 ) ) == 0;
+	    out = PlMultiplyMatrix4( a, b );
+	    matches &= memcmp( &m, &out, sizeof( PLMatrix4 ) ) == 0;
+
+	    m = PlTransposeMatrix4Scalar( &a );
+	    PlTransposeMatrix4A( &out, &a );
+	    matches &= memcmp( &m, &out, sizeof( PLMatrix4 ) ) == 0;
+
+	    m = PlInverseMatrix4Scalar( a );
+	    out = PlInverseMatrix4( a );
+	    matches &= memcmp( &m, &out, sizeof( PLMatrix4 ) ) == 0;
+	    matches &= PlInverseMatrix4A( &out, &a ) && memcmp( &m, &out, sizeof( PLMatrix4 ) ) == 0;
+
+	    PLVector4 r4 = PlTransformVector4Scalar( &a, v4 ), s4 = PlTransformVector4( &a, v4 );
+	    matches &= memcmp( &r4, &s4, sizeof( PLVector4 ) ) == 0;
+	    PLVector3 r3 = PlTransformPoint3Scalar( &a, v ), s3 = PlTransformPoint3( &a, v );
+	    matches &= memcmp( &r3, &s3, sizeof( PLVector3 ) ) == 0;
+	    r3 = PlTransformDirection3Scalar( &a, v ), s3 = PlTransformDirection3( &a, v );
+	    matches &= memcmp( &r3, &s3, sizeof( PLVector3 ) ) == 0;
+	    r3 = PlNormalizeVector3Scalar( v ), s3 = PlNormalizeVector3( v );
+	    matches &= memcmp( &r3, &s3, sizeof( PLVector3 ) ) == 0;
+
+	    PLQuaternion rq = PlMultiplyQuaternionScalar( &q, &q2 ), sq = PlMultiplyQuaternion( &q, &q2 );
+	    matches &= memcmp( &rq, &sq, sizeof( PLQuaternion ) ) == 0;
+	    rq = PlMultiplyQuaternion3FVScalar( &q, &v ), sq = PlMultiplyQuaternion3FV( &q, &v );
+	    matches &= memcmp( &rq, &sq, sizeof( PLQuaternion ) ) == 0;
+	    if ( !matches ) {
+		    printf( "Vector maths differs from the scalar reference (%u)!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+
+	    /* and the inverse should actually be one */
+	    m = PlMultiplyMatrix4( a, PlInverseMatrix4( a ) );
+	    for ( unsigned int j = 0; j < 16; ++j ) {
+		    if ( fabsf( m.m[ j ] - ( ( j % 5 == 0 ) ? 1.0f : 0.0f ) ) > 1e-3f ) {
+			    printf( "Unexpected inverse (%u)!\n", i );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+    }
+
+    /* singular matrices are handed back as they are */
+    PL_ALIGNED( 16 ) PLMatrix4 singular = { { 1, 2, 3, 4, 2, 4, 6, 8, 0, 1, 0, 0, 0, 0, 1, 0 } }, out = PlMatrix4Identity();
+    PLMatrix4 r = PlInverseMatrix4( singular );
+    if ( memcmp( &r, &singular, sizeof( PLMatrix4 ) ) != 0 || PlInverseMatrix4A( &out, &singular ) ) {
+	    printf( "Singular matrix was inverted!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+#define BATCH_TEST_VECTORS 203
+
+FUNC_TEST( BatchMath )
+    static float streams[ 12 ][ BATCH_TEST_VECTORS ], out[ 4 ][ BATCH_TEST_VECTORS ];
+    uint32_t seed = 0xba7c4;
+    for ( unsigned int i = 0; i < 12; ++i ) {
+	    for ( unsigned int j = 0; j < BATCH_TEST_VECTORS; ++j ) {
+		    streams[ i ][ j ] = RandomMathFloat( &seed );
+	    }
+    }
+    streams[ 0 ][ 7 ] = streams[ 1 ][ 7 ] = streams[ 2 ][ 7 ] = 0.0f; /* zero length is left alone */
+    PLVector3SoA a = { streams[ 0 ], streams[ 1 ], streams[ 2 ] }, b = { streams[ 3 ], streams[ 4 ], streams[ 5 ] };
+    PLVector3SoA o = { out[ 0 ], out[ 1 ], out[ 2 ] };
+    PLQuaternionSoA qa = { streams[ 4 ], streams[ 5 ], streams[ 6 ], streams[ 7 ] }, qb = { streams[ 8 ], streams[ 9 ], streams[ 10 ], streams[ 11 ] };
+    PLQuaternionSoA qo = { out[ 0 ], out[ 1 ], out[ 2 ], out[ 3 ] };
+    for ( unsigned int j = 0; j < BATCH_TEST_VECTORS; ++j ) {
+	    PLQuaternion q = PLQuaternion( qa.x[ j ], qa.y[ j ], qa.z[ j ], qa.w[ j ] ), q2 = PLQuaternion( qb.x[ j ], qb.y[ j ], qb.z[ j ], qb.w[ j ] );
+	    q = PlNormalizeQuaternion( &q ), q2 = PlNormalizeQuaternion( &q2 );
+	    qa.x[ j ] = q.x, qa.y[ j ] = q.y, qa.z[ j ] = q.z, qa.w[ j ] = q.w;
+	    qb.x[ j ] = q2.x, qb.y[ j ] = q2.y, qb.z[ j ] = q2.z, qb.w[ j ] = q2.w;
+    }
+    PLMatrix4 m;
+    for ( unsigned int j = 0; j < 16; ++j ) {
+	    m.m[ j ] = RandomMathFloat( &seed );
+    }
+
+    for ( unsigned int level = PL_SIMD_LEVEL_NONE; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+	    PlSetSimdLevel( level );
+	    /* odd lengths, so every kernel has a tail to hand on */
+	    for ( unsigned int num = 1; num <= BATCH_TEST_VECTORS; num += 101 ) {
+		    for ( unsigned int op = 0; op < 6; ++op ) {
+			    switch ( op ) {
+				    case 0: PlTransformPoints3( &m, &a, &o, num ); break;
+				    case 1: PlTransformDirections3( &m, &a, &o, num ); break;
+				    case 2: PlNormalizeVectors3( &a, &o, num ); break;
+				    case 3: PlVector3DotProducts( &a, &b, out[ 0 ], num ); break;
+				    case 4: PlLerpVectors3( &a, &b, 0.3f, &o, num ); break;
+				    case 5: PlSlerpQuaternions( &qa, &qb, 0.7f, &qo, num ); break;
+			    }
+			    for ( unsigned int j = 0; j < num; ++j ) {
+				    PLVector3 v = PLVector3( a.x[ j ], a.y[ j ], a.z[ j ] ), v2 = PLVector3( b.x[ j ], b.y[ j ], b.z[ j ] );
+				    float e[ 4 ];
+				    unsigned int numComponents = 3;
+				    switch ( op ) {
+					    case 0: v = PlTransformPoint3Scalar( &m, v ); break;
+					    case 1: v = PlTransformDirection3Scalar( &m, v ); break;
+					    case 2: v = PlNormalizeVector3Scalar( v ); break;
+					    case 3: v.x = PlVector3DotProduct( v, v2 ), numComponents = 1; break;
+					    case 4: v = PLVector3( v.x + ( v2.x - v.x ) * 0.3f, v.y + ( v2.y - v.y ) * 0.3f, v.z + ( v2.z - v.z ) * 0.3f ); break;
+					    case 5: {
+						    PLQuaternion q = PLQuaternion( qa.x[ j ], qa.y[ j ], qa.z[ j ], qa.w[ j ] ), q2 = PLQuaternion( qb.x[ j ], qb.y[ j ], qb.z[ j ], qb.w[ j ] );
+						    q = PlSlerpQuaternion( &q, &q2, 0.7f );
+						    e[ 3 ] = q.w, numComponents = 4;
+						    v = PLVector3( q.x, q.y, q.z );
+						    break;
+					    }
+				    }
+				    e[ 0 ] = v.x, e[ 1 ] = v.y, e[ 2 ] = v.z;
+				    for ( unsigned int c = 0; c < numComponents; ++c ) {
+					    if ( memcmp( &out[ c ][ j ], &e[ c ], sizeof( float ) ) != 0 ) {
+						    printf( "Batch operation %u differs at %u (level %u)!\n", op, j, level );
+						    return TEST_RETURN_FAILURE;
+					    }
+				    }
+			    }
+		    }
+	    }
+
+	    PLVector3 mins, maxs;
+	    PlGetVector3Bounds( &a, BATCH_TEST_VECTORS, &mins, &maxs );
+	    PLVector3 emins = PLVector3( FLT_MAX, FLT_MAX, FLT_MAX ), emaxs = PLVector3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	    for ( unsigned int j = 0; j < BATCH_TEST_VECTORS; ++j ) {
+		    PLVector3 v = PLVector3( a.x[ j ], a.y[ j ], a.z[ j ] );
+		    emins = PlVector3Min( emins, v );
+		    emaxs = PlVector3Max( emaxs, v );
+	    }
+	    if ( !PlCompareVector3( &mins, &emins ) || !PlCompareVector3( &maxs, &emaxs ) ) {
+		    printf( "Unexpected bounds (level %u)!\n", level );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+
+    /* the slerp weights are an approximation, so check them against the real thing */
+    for ( unsigned int j = 0; j < BATCH_TEST_VECTORS; ++j ) {
+	    PLQuaternion q = PLQuaternion( qa.x[ j ], qa.y[ j ], qa.z[ j ], qa.w[ j ] ), q2 = PLQuaternion( qb.x[ j ], qb.y[ j ], qb.z[ j ], qb.w[ j ] );
+	    float d = q.x * q2.x + q.y * q2.y + q.z * q2.z + q.w * q2.w;
+	    if ( d < 0 ) {
+		    q2 = PlScaleQuaternion( &q2, -1.0f ), d = -d;
+	    }
+	    float theta = acosf( PlClamp( -1.0f, d, 1.0f ) );
+	    for ( float t = 0.0f; t <= 1.0f; t += 0.125f ) {
+		    float wa = sinf( ( 1.0f - t ) * theta ) / sinf( theta ), wb = sinf( t * theta ) / sinf( theta );
+		    PLQuaternion r = PlSlerpQuaternion( &q, &q2, t );
+		    if ( fabsf( r.x - ( wa * q.x + wb * q2.x ) ) > 1e-4f || fabsf( r.y - ( wa * q.y + wb * q2.y ) ) > 1e-4f ||
+		         fabsf( r.z - ( wa * q.z + wb * q2.z ) ) > 1e-4f || fabsf( r.w - ( wa * q.w + wb * q2.w ) ) > 1e-4f ) {
+			    printf( "Inaccurate slerp at %u (t %f)!\n", j, t );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+    }
+FUNC_TEST_END()
+
+#define MATRIX_STACK_THREADS 4
+
+static int MatrixStackWorker( void *userData ) {
+	int *result = userData;
+	PLMatrixStack *stack = PlCreateMatrixStack();
+	PlSetStackMatrixMode( stack, PL_PROJECTION_MATRIX );
+	PlScaleStackMatrix( stack, PLVector3( 2.0f, 2.0f, 2.0f ) );
+	PlSetStackMatrixMode( stack, PL_MODELVIEW_MATRIX );
+	*result = 0;
+	for ( int i = 0; i < 1000; ++i ) {
+		PlPushStackMatrix( stack );
+		PlTranslateStackMatrix( stack, PLVector3( ( float ) *result, 0.0f, 0.0f ) );
+		PLVector3 p = PlTransformPoint3( PlGetStackModelViewProjection( stack ), PLVector3( 1.0f, 0.0f, 0.0f ) );
+		PlPopStackMatrix( stack );
+		*result += ( p.x == 2.0f ) ? 0 : 1;
+	}
+	PlDestroyMatrixStack( stack );
+	return 0;
+}
+
+FUNC_TEST( MatrixStack )
+    PLMatrixStack *stack = PlCreateMatrixStack();
+    PLMatrix4 identity = PlMatrix4Identity();
+    if ( !PlCompareMatrix( PlGetStackModelViewProjection( stack ), &identity ) ) {
+	    printf( "New stack isn't identity!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PLMatrix4 projection = PlPerspective( 90.0f, 1.5f, 0.1f, 100.0f );
+    PlSetStackMatrixMode( stack, PL_PROJECTION_MATRIX );
+    PlLoadStackMatrix( stack, &projection );
+    PlSetStackMatrixMode( stack, PL_MODELVIEW_MATRIX );
+    PlRotateStackMatrix( stack, 0.5f, 0.0f, 1.0f, 0.0f );
+    PLMatrix4 modelView = *PlGetStackMatrix( stack, PL_MODELVIEW_MATRIX );
+    PLMatrix4 expected = PlMultiplyMatrix4( projection, modelView );
+    const PLMatrix4 *mvp = PlGetStackModelViewProjection( stack );
+    if ( !PlCompareMatrix( mvp, &expected ) || PlGetStackModelViewProjection( stack ) != mvp ) {
+	    printf( "Unexpected model-view-projection!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    /* pushing and changing the top, then popping, should bring the original back */
+    PlPushStackMatrix( stack );
+    PlTranslateStackMatrix( stack, PLVector3( 1.0f, 2.0f, 3.0f ) );
+    expected = PlMultiplyMatrix4( projection, PlMultiplyMatrix4( modelView, PlTranslateMatrix4( PLVector3( 1.0f, 2.0f, 3.0f ) ) ) );
+    if ( !PlCompareMatrix( PlGetStackModelViewProjection( stack ), &expected ) ) {
+	    printf( "Model-view-projection wasn't updated!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlPopStackMatrix( stack );
+    expected = PlMultiplyMatrix4( projection, modelView );
+    if ( !PlCompareMatrix( PlGetStackModelViewProjection( stack ), &expected ) ) {
+	    printf( "Model-view-projection wasn't restored!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    /* under and overflowing are errors, and leave the stack alone */
+    PlPopStackMatrix( stack );
+    if ( PlGetFunctionResult() != PL_RESULT_MEMORY_UNDERFLOW ) {
+	    printf( "Expected underflow!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    for ( unsigned int i = 0; i < 64; ++i ) {
+	    PlPushStackMatrix( stack );
+    }
+    if ( PlGetFunctionResult() != PL_RESULT_MEMORY_EOA || !PlCompareMatrix( PlGetStackMatrix( stack, PL_MODELVIEW_MATRIX ), &modelView ) ) {
+	    printf( "Expected overflow!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    /* and none of that should have touched the default stack */
+    if ( !PlCompareMatrix( PlGetMatrix( PL_MODELVIEW_MATRIX ), &identity ) ) {
+	    printf( "Default stack was modified!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyMatrixStack( stack );
+
+    PLThread *threads[ MATRIX_STACK_THREADS ];
+    int results[ MATRIX_STACK_THREADS ];
+    for ( int i = 0; i < MATRIX_STACK_THREADS; ++i ) {
+	    threads[ i ] = PlCreateThread( MatrixStackWorker, &results[ i ] );
+    }
+    for ( int i = 0; i < MATRIX_STACK_THREADS; ++i ) {
+	    PlJoinThread( threads[ i ] );
+	    if ( results[ i ] != 0 ) {
+		    printf( "Unexpected result from stack on thread %d!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+FUNC_TEST_END()
+
+#define RANDOM_TEST_VALUES 10011
+
+static int RandomWorker( void *userData ) {
+	*( uint64_t * ) userData = PlRandomUInt64( PlGetThreadRandom() );
+	return 0;
+}
+
+FUNC_TEST( Random )
+    /* known values for xoshiro256** seeded through splitmix64 */
+    static const uint64_t expected[] = { 0x0bab45d9a0e3ae53ULL, 0xd7c640660c19433eULL, 0xb0dedaa0d09a6691ULL };
+    PLRandom rng;
+    PlSeedRandom( &rng, 1234 );
+    for ( unsigned int i = 0; i < plArrayElements( expected ); ++i ) {
+	    if ( PlRandomUInt64( &rng ) != expected[ i ] ) {
+		    printf( "Unexpected sequence at %u!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    for ( unsigned int i = 0; i < 100000; ++i ) {
+	    float f = PlRandomFloat( &rng );
+	    double d = PlRandomDouble( &rng );
+	    if ( f < 0.0f || f >= 1.0f || d < 0.0 || d >= 1.0 || PlRandomBoundedUInt32( &rng, 7 ) >= 7 ) {
+		    printf( "Value out of range!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+
+    /* the fills should come out the same at every level, and odd lengths
+     * make sure every kernel has a tail to hand on */
+    static float reference[ 4 ][ RANDOM_TEST_VALUES ], out[ 4 ][ RANDOM_TEST_VALUES ];
+    PLVector3SoA sphere = { out[ 1 ], out[ 2 ], out[ 3 ] };
+    for ( unsigned int level = PL_SIMD_LEVEL_NONE; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+	    PlSetSimdLevel( level );
+	    for ( unsigned int op = 0; op < 4; ++op ) {
+		    for ( unsigned int num = 1; num <= RANDOM_TEST_VALUES; num += 1001 ) {
+			    PlSeedRandom( &rng, op );
+			    switch ( op ) {
+				    case 0: PlFillRandomUInt32( &rng, ( uint32_t * ) out[ 0 ], num ); break;
+				    case 1: PlFillRandomFloats( &rng, out[ 0 ], num, -2.0f, 3.0f ); break;
+				    case 2: PlFillRandomNormals( &rng, out[ 0 ], num, 1.0f, 0.5f ); break;
+				    case 3: {
+					    PlFillRandomOnSphere( &rng, &sphere, num );
+					    /* fold the point into one value, for comparing */
+					    for ( unsigned int j = 0; j < num; ++j ) {
+						    out[ 0 ][ j ] = out[ 1 ][ j ] * 4.0f + out[ 2 ][ j ] * 2.0f + out[ 3 ][ j ];
+					    }
+					    break;
+				    }
+			    }
+			    if ( level == PL_SIMD_LEVEL_NONE ) {
+				    memcpy( reference[ op ], out[ 0 ], sizeof( float ) * num );
+			    } else if ( memcmp( out[ 0 ], reference[ op ], sizeof( float ) * num ) != 0 ) {
+				    printf( "Random fill %u of %u differs (level %u)!\n", op, num, level );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+    }
+    PlSetSimdLevel( PL_SIMD_LEVEL_AVX2 );
+
+    /* and a short fill should be the start of a longer one */
+    PlSeedRandom( &rng, 2 );
+    PlFillRandomNormals( &rng, out[ 0 ], 13, 1.0f, 0.5f );
+    if ( memcmp( out[ 0 ], reference[ 2 ], sizeof( float ) * 13 ) != 0 ) {
+	    printf( "Short fill differs!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* rough checks on the distributions themselves */
+    double sum = 0.0, sumSquares = 0.0;
+    for ( unsigned int i = 0; i < RANDOM_TEST_VALUES; ++i ) {
+	    if ( reference[ 1 ][ i ] < -2.0f || reference[ 1 ][ i ] > 3.0f ) {
+		    printf( "Uniform value out of range!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    sum += reference[ 2 ][ i ];
+	    sumSquares += reference[ 2 ][ i ] * reference[ 2 ][ i ];
+    }
+    double mean = sum / RANDOM_TEST_VALUES, variance = sumSquares / RANDOM_TEST_VALUES - mean * mean;
+    if ( fabs( mean - 1.0 ) > 0.02 || fabs( variance - 0.25 ) > 0.02 ) {
+	    printf( "Unexpected normal distribution (mean %f, variance %f)!\n", mean, variance );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlFillRandomOnSphere( &rng, &sphere, RANDOM_TEST_VALUES );
+    PLVector3 centre = PLVector3( 0.0f, 0.0f, 0.0f );
+    for ( unsigned int i = 0; i < RANDOM_TEST_VALUES; ++i ) {
+	    PLVector3 v = PLVector3( out[ 1 ][ i ], out[ 2 ][ i ], out[ 3 ][ i ] );
+	    if ( fabsf( PlVector3Length( v ) - 1.0f ) > 1e-5f ) {
+		    printf( "Point %u isn't on the sphere!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    centre = PlAddVector3( centre, v );
+    }
+    if ( PlVector3Length( centre ) / RANDOM_TEST_VALUES > 0.03f ) {
+	    printf( "Sphere points aren't evenly spread!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* each thread should get its own generator */
+    uint64_t threadValue;
+    PLThread *thread = PlCreateThread( RandomWorker, &threadValue );
+    PlJoinThread( thread );
+    if ( threadValue == PlRandomUInt64( PlGetThreadRandom() ) ) {
+	    printf( "Threads share a generator!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+FUNC_TEST_END()
+
+/*============================================================
+ * PHYSICS
+ ===========================================================*/
+
+#define AABB_TREE_BOXES 700
+
+static PLCollisionAABB RandomTestAabb( PLRandom *rng, float spread, float size ) {
+	PLVector3 origin = PLVector3( PlRandomFloatRange( rng, -spread, spread ), PlRandomFloatRange( rng, -spread, spread ), PlRandomFloatRange( rng, -spread, spread ) );
+	PLVector3 extents = PLVector3( PlRandomFloatRange( rng, 0.1f, size ), PlRandomFloatRange( rng, 0.1f, size ), PlRandomFloatRange( rng, 0.1f, size ) );
+	return PlSetupCollisionAABB( origin, PlScaleVector3F( extents, -1.0f ), extents );
+}
+
+/* the pairs and hits found, summed up so they can be compared without sorting */
+typedef struct TreeTestResult {
+	unsigned int num;
+	uint64_t sum;
+} TreeTestResult;
+
+static void CountTreePair( unsigned int proxyA, unsigned int proxyB, void *parm ) {
+	TreeTestResult *result = parm;
+	result->num += ( proxyA < proxyB ) ? 1 : 1000000; /* order is part of the contract */
+	result->sum += ( uint64_t ) proxyA * AABB_TREE_BOXES * 2 + proxyB;
+}
+
+static bool CountTreeProxy( unsigned int proxy, void *userData, void *parm ) {
+	TreeTestResult *result = parm;
+	result->num++;
+	result->sum += proxy;
+	return true;
+}
+
+static float FindClosestTreeHit( unsigned int proxy, void *userData, float distance, void *parm ) {
+	*( float * ) parm = distance;
+	return distance;
+}
+
+/* brute force, against the bounds the tree says it's storing */
+static bool CheckAabbTree( const PLAabbTree *tree, const bool *live, PLRandom *rng ) {
+	PLVector3 mins[ AABB_TREE_BOXES * 2 ], maxs[ AABB_TREE_BOXES * 2 ];
+	for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+		if ( live[ i ] ) {
+			PlGetAabbTreeProxyBounds( tree, i, &mins[ i ], &maxs[ i ] );
+		}
+	}
+
+	TreeTestResult expected = { 0 }, result = { 0 };
+	for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+		for ( unsigned int j = i + 1; j < AABB_TREE_BOXES * 2 && live[ i ]; ++j ) {
+			PLCollisionAABB a = PlSetupCollisionAABB( pl_vecOrigin3, mins[ i ], maxs[ i ] ), b = PlSetupCollisionAABB( pl_vecOrigin3, mins[ j ], maxs[ j ] );
+			if ( live[ j ] && PlIsAabbIntersecting( &a, &b ) ) {
+				CountTreePair( i, j, &expected );
+			}
+		}
+	}
+	PlGetAabbTreeOverlapPairs( tree, CountTreePair, &result );
+	if ( result.num != expected.num || result.sum != expected.sum ) {
+		printf( "Unexpected pairs (%u, expected %u)!\n", result.num, expected.num );
+		return false;
+	}
+
+	for ( unsigned int k = 0; k < 32; ++k ) {
+		PLCollisionAABB query = RandomTestAabb( rng, 50.0f, 20.0f );
+		expected = ( TreeTestResult ){ 0 }, result = ( TreeTestResult ){ 0 };
+		for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+			PLCollisionAABB a = PlSetupCollisionAABB( pl_vecOrigin3, mins[ i ], maxs[ i ] );
+			if ( live[ i ] && PlIsAabbIntersecting( &a, &query ) ) {
+				CountTreeProxy( i, NULL, &expected );
+			}
+		}
+		PlQueryAabbTree( tree, &query, CountTreeProxy, &result );
+		if ( result.num != expected.num || result.sum != expected.sum ) {
+			printf( "Unexpected query results (%u, expected %u)!\n", result.num, expected.num );
+			return false;
+		}
+
+		/* a frustum-ish set of planes, looking down x */
+		PLVector4 planes[ 5 ] = {
+		        PlNormalizePlane( PLVector4( 1.0f, 0.0f, 0.0f, 10.0f ) ),
+		        PlNormalizePlane( PLVector4( 1.0f, 1.0f, 0.0f, query.origin.y ) ),
+		        PlNormalizePlane( PLVector4( 1.0f, -1.0f, 0.0f, query.origin.z ) ),
+		        PlNormalizePlane( PLVector4( 1.0f, 0.0f, 1.0f, 0.0f ) ),
+		        PlNormalizePlane( PLVector4( 1.0f, 0.0f, -1.0f, 5.0f ) ),
+		};
+		expected = ( TreeTestResult ){ 0 }, result = ( TreeTestResult ){ 0 };
+		for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+			bool inside = live[ i ];
+			for ( unsigned int j = 0; j < plArrayElements( planes ) && inside; ++j ) {
+				bool anyCorner = false;
+				for ( unsigned int c = 0; c < 8; ++c ) {
+					PLVector3 corner = PLVector3( ( c & 1 ) ? maxs[ i ].x : mins[ i ].x, ( c & 2 ) ? maxs[ i ].y : mins[ i ].y, ( c & 4 ) ? maxs[ i ].z : mins[ i ].z );
+					anyCorner |= PlGetPlaneDotProduct( &planes[ j ], &corner ) >= 0.0f;
+				}
+				inside = anyCorner;
+			}
+			if ( inside ) {
+				CountTreeProxy( i, NULL, &expected );
+			}
+		}
+		PlQueryAabbTreeFrustum( tree, planes, plArrayElements( planes ), CountTreeProxy, &result );
+		if ( result.num != expected.num || result.sum != expected.sum ) {
+			printf( "Unexpected frustum results (%u, expected %u)!\n", result.num, expected.num );
+			return false;
+		}
+
+		PLVector3 direction = PlNormalizeVector3( PLVector3( PlRandomFloatRange( rng, -1.0f, 1.0f ), PlRandomFloatRange( rng, -1.0f, 1.0f ), 0.5f ) );
+		PLCollisionRay ray = PlSetupCollisionRay( PLVector3( query.origin.x, query.origin.y, -100.0f ), direction );
+		float closest = FLT_MAX, hit = FLT_MAX;
+		for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+			PLCollisionAABB a = PlSetupCollisionAABB( pl_vecOrigin3, mins[ i ], maxs[ i ] );
+			PLVector3 point = PLVector3( 0, 0, 0 );
+			if ( live[ i ] && PlIsRayIntersectingAabb( &a, &ray, &point ) ) {
+				float distance = PlVector3Length( PlSubtractVector3( point, ray.origin ) );
+				closest = ( distance < closest ) ? distance : closest;
+			}
+		}
+		PlRaycastAabbTree( tree, &ray, FLT_MAX, FindClosestTreeHit, &hit );
+		if ( fabsf( hit - closest ) > 1e-3f ) {
+			printf( "Unexpected closest hit (%f, expected %f)!\n", hit, closest );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+FUNC_TEST( AabbTree )
+    PLRandom rng;
+    PlSeedRandom( &rng, 0xaabb );
+    static PLCollisionAABB boxes[ AABB_TREE_BOXES * 2 ];
+    static bool live[ AABB_TREE_BOXES * 2 ];
+    static void *userData[ AABB_TREE_BOXES * 2 ];
+    for ( unsigned int i = 0; i < AABB_TREE_BOXES; ++i ) {
+	    boxes[ i ] = RandomTestAabb( &rng, 50.0f, 3.0f );
+	    userData[ i ] = &boxes[ i ];
+    }
+
+    PLAabbTree *tree = PlCreateAabbTree( 0.5f );
+    for ( unsigned int i = 0; i < AABB_TREE_BOXES; ++i ) {
+	    unsigned int proxy = PlInsertAabbTreeProxy( tree, &boxes[ i ], userData[ i ] );
+	    if ( proxy >= AABB_TREE_BOXES * 2 || live[ proxy ] || PlGetAabbTreeProxyUserData( tree, proxy ) != userData[ i ] ) {
+		    printf( "Unexpected proxy!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    live[ proxy ] = true;
+    }
+    /* should be kept balanced, however it's built up */
+    if ( PlGetAabbTreeNumProxies( tree ) != AABB_TREE_BOXES || PlGetAabbTreeHeight( tree ) > 20 ) {
+	    printf( "Unexpected tree (height %u)!\n", PlGetAabbTreeHeight( tree ) );
+	    return TEST_RETURN_FAILURE;
+    }
+    if ( !CheckAabbTree( tree, live, &rng ) ) {
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* take out every other one, and move the rest around */
+    for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; i += 2 ) {
+	    if ( live[ i ] ) {
+		    PlRemoveAabbTreeProxy( tree, i );
+		    live[ i ] = false;
+	    }
+    }
+    for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+	    if ( live[ i ] ) {
+		    PLCollisionAABB *bounds = PlGetAabbTreeProxyUserData( tree, i );
+		    PLVector3 displacement = PLVector3( PlRandomFloatRange( &rng, -2.0f, 2.0f ), 0.0f, PlRandomFloatRange( &rng, -0.2f, 0.2f ) );
+		    bounds->origin = PlAddVector3( bounds->origin, displacement );
+		    PlMoveAabbTreeProxy( tree, i, bounds, displacement );
+	    }
+    }
+    PlRemoveAabbTreeProxy( tree, 0 );
+    if ( PlGetFunctionResult() != PL_RESULT_INVALID_PARM2 ) {
+	    printf( "Removing a free proxy should fail!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    if ( !CheckAabbTree( tree, live, &rng ) ) {
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* refitting in place */
+    for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+	    if ( live[ i ] ) {
+		    PLCollisionAABB *bounds = PlGetAabbTreeProxyUserData( tree, i );
+		    bounds->origin.y += PlRandomFloatRange( &rng, -5.0f, 5.0f );
+		    PlSetAabbTreeProxyBounds( tree, i, bounds );
+	    }
+    }
+    PlRefitAabbTree( tree );
+    if ( !CheckAabbTree( tree, live, &rng ) ) {
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* and built all at once, where proxies match the indices */
+    memset( live, 0, sizeof( live ) );
+    for ( unsigned int i = AABB_TREE_BOXES; i < AABB_TREE_BOXES * 2; ++i ) {
+	    boxes[ i ] = RandomTestAabb( &rng, 50.0f, 3.0f );
+	    userData[ i ] = &boxes[ i ];
+    }
+    boxes[ 5 ] = boxes[ 6 ] = boxes[ 7 ]; /* some in the same place */
+    PlBuildAabbTree( tree, boxes, userData, AABB_TREE_BOXES * 2 );
+    for ( unsigned int i = 0; i < AABB_TREE_BOXES * 2; ++i ) {
+	    if ( PlGetAabbTreeProxyUserData( tree, i ) != userData[ i ] ) {
+		    printf( "Built proxy doesn't match its index!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    live[ i ] = true;
+    }
+    if ( !CheckAabbTree( tree, live, &rng ) ) {
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyAabbTree( tree );
+FUNC_TEST_END()
+
+#define BROADPHASE_BOXES 500
+
+/* what overlapped as of the last update, by proxy */
+static bool broadphaseOverlaps[ BROADPHASE_BOXES * 2 ][ BROADPHASE_BOXES * 2 ];
+
+static bool CheckBroadphase( const PLBroadphase *broadphase, const PLCollisionAABB *boxes, const bool *live ) {
+	static bool overlaps[ BROADPHASE_BOXES * 2 ][ BROADPHASE_BOXES * 2 ];
+	static bool seen[ BROADPHASE_BOXES * 2 ][ BROADPHASE_BOXES * 2 ];
+	unsigned int numOverlaps = 0, numAdded = 0, numRemoved = 0;
+	for ( unsigned int i = 0; i < BROADPHASE_BOXES * 2; ++i ) {
+		for ( unsigned int j = i + 1; j < BROADPHASE_BOXES * 2; ++j ) {
+			overlaps[ i ][ j ] = live[ i ] && live[ j ] && PlIsAabbIntersecting( &boxes[ i ], &boxes[ j ] );
+			numOverlaps += overlaps[ i ][ j ];
+			numAdded += overlaps[ i ][ j ] && !broadphaseOverlaps[ i ][ j ];
+			numRemoved += !overlaps[ i ][ j ] && broadphaseOverlaps[ i ][ j ];
+		}
+	}
+
+	unsigned int num;
+	const PLBroadphasePair *pairs = PlGetBroadphasePairs( broadphase, &num );
+	if ( num != numOverlaps ) {
+		printf( "Found %u pairs rather than %u!\n", num, numOverlaps );
+		return false;
+	}
+	memset( seen, 0, sizeof( seen ) );
+	for ( unsigned int i = 0; i < num; ++i ) {
+		unsigned int a = pairs[ i ].proxyA, b = pairs[ i ].proxyB;
+		if ( a >= b || b >= BROADPHASE_BOXES * 2 || !overlaps[ a ][ b ] || seen[ a ][ b ] ) {
+			printf( "Unexpected pair (%u %u)!\n", a, b );
+			return false;
+		}
+		seen[ a ][ b ] = true;
+	}
+
+	/* and the differences since last time */
+	pairs = PlGetBroadphaseAddedPairs( broadphase, &num );
+	for ( unsigned int i = 0; i < num; ++i ) {
+		if ( !overlaps[ pairs[ i ].proxyA ][ pairs[ i ].proxyB ] || broadphaseOverlaps[ pairs[ i ].proxyA ][ pairs[ i ].proxyB ] ) {
+			printf( "Unexpected added pair (%u %u)!\n", pairs[ i ].proxyA, pairs[ i ].proxyB );
+			return false;
+		}
+	}
+	if ( num != numAdded ) {
+		printf( "Added %u pairs rather than %u!\n", num, numAdded );
+		return false;
+	}
+	pairs = PlGetBroadphaseRemovedPairs( broadphase, &num );
+	for ( unsigned int i = 0; i < num; ++i ) {
+		if ( overlaps[ pairs[ i ].proxyA ][ pairs[ i ].proxyB ] || !broadphaseOverlaps[ pairs[ i ].proxyA ][ pairs[ i ].proxyB ] ) {
+			printf( "Unexpected removed pair (%u %u)!\n", pairs[ i ].proxyA, pairs[ i ].proxyB );
+			return false;
+		}
+	}
+	if ( num != numRemoved ) {
+		printf( "Removed %u pairs rather than %u!\n", num, numRemoved );
+		return false;
+	}
+
+	memcpy( broadphaseOverlaps, overlaps, sizeof( overlaps ) );
+	return true;
+}
+
+static bool AddTestBroadphaseBox( PLBroadphase *broadphase, PLCollisionAABB *boxes, bool *live, PLCollisionAABB box ) {
+	unsigned int proxy = PlAddBroadphaseProxy( broadphase, &box, NULL );
+	if ( proxy >= BROADPHASE_BOXES * 2 || live[ proxy ] ) {
+		printf( "Unexpected proxy (%u)!\n", proxy );
+		return false;
+	}
+
+	boxes[ proxy ] = box;
+	live[ proxy ] = true;
+	return true;
+}
+
+/* things coming, going and moving about, checked against brute force every update */
+FUNC_TEST( Broadphase )
+    static PLCollisionAABB boxes[ BROADPHASE_BOXES * 2 ];
+    static bool live[ BROADPHASE_BOXES * 2 ];
+    for ( unsigned int type = 0; type < 2; ++type ) {
+	    PLRandom rng;
+	    PlSeedRandom( &rng, 0xb9a5e + type );
+	    memset( live, 0, sizeof( live ) );
+	    memset( broadphaseOverlaps, 0, sizeof( broadphaseOverlaps ) );
+
+	    PLBroadphase *broadphase = ( type == 0 ) ? PlCreateSweepAndPruneBroadphase() : PlCreateHashGridBroadphase( 4.0f );
+	    unsigned int numLive = 0;
+	    /* one pair just touching, and one box big enough to cover a lot of cells */
+	    AddTestBroadphaseBox( broadphase, boxes, live, PlSetupCollisionAABB( PLVector3( 40.0f, 0.0f, 0.0f ), PLVector3( -1.0f, -1.0f, -1.0f ), PLVector3( 1.0f, 1.0f, 1.0f ) ) );
+	    AddTestBroadphaseBox( broadphase, boxes, live, PlSetupCollisionAABB( PLVector3( 42.0f, 0.0f, 0.0f ), PLVector3( -1.0f, -1.0f, -1.0f ), PLVector3( 1.0f, 1.0f, 1.0f ) ) );
+	    AddTestBroadphaseBox( broadphase, boxes, live, RandomTestAabb( &rng, 30.0f, 25.0f ) );
+	    for ( numLive = 3; numLive < BROADPHASE_BOXES; ++numLive ) {
+		    if ( !AddTestBroadphaseBox( broadphase, boxes, live, RandomTestAabb( &rng, 30.0f, 2.0f ) ) ) {
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+
+	    for ( unsigned int frame = 0; frame < 40; ++frame ) {
+		    PlUpdateBroadphase( broadphase );
+		    if ( !CheckBroadphase( broadphase, boxes, live ) || PlGetBroadphaseNumProxies( broadphase ) != numLive ) {
+			    printf( "Broadphase %u is wrong on frame %u!\n", type, frame );
+			    return TEST_RETURN_FAILURE;
+		    }
+
+		    for ( unsigned int i = 0; i < BROADPHASE_BOXES * 2; ++i ) {
+			    if ( !live[ i ] ) {
+				    continue;
+			    }
+			    uint32_t r = PlRandomBoundedUInt32( &rng, 100 );
+			    if ( r < 4 ) {
+				    PlRemoveBroadphaseProxy( broadphase, i );
+				    live[ i ] = false;
+				    numLive--;
+				    continue;
+			    } else if ( r < 8 ) {
+				    boxes[ i ] = RandomTestAabb( &rng, 30.0f, 2.0f );
+			    } else {
+				    boxes[ i ].origin.x += PlRandomFloatRange( &rng, -0.5f, 0.5f );
+				    boxes[ i ].origin.y += PlRandomFloatRange( &rng, -0.5f, 0.5f );
+				    boxes[ i ].origin.z += PlRandomFloatRange( &rng, -0.5f, 0.5f );
+			    }
+			    PlSetBroadphaseProxyBounds( broadphase, i, &boxes[ i ] );
+		    }
+		    for ( unsigned int i = PlRandomBoundedUInt32( &rng, 30 ); i > 0 && numLive < BROADPHASE_BOXES; --i, ++numLive ) {
+			    if ( !AddTestBroadphaseBox( broadphase, boxes, live, RandomTestAabb( &rng, 30.0f, 2.0f ) ) ) {
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+
+	    unsigned int freeProxy = 0;
+	    while ( live[ freeProxy ] ) {
+		    freeProxy++;
+	    }
+	    PlRemoveBroadphaseProxy( broadphase, freeProxy );
+	    if ( PlGetFunctionResult() != PL_RESULT_INVALID_PARM2 ) {
+		    printf( "Removing a free proxy should fail!\n" );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    PlDestroyBroadphase( broadphase );
+
+	    /* a box reaching well beyond the range of the grid's cell coordinates */
+	    memset( live, 0, sizeof( live ) );
+	    memset( broadphaseOverlaps, 0, sizeof( broadphaseOverlaps ) );
+	    broadphase = ( type == 0 ) ? PlCreateSweepAndPruneBroadphase() : PlCreateHashGridBroadphase( 4.0f );
+	    for ( unsigned int i = 0; i < 8; ++i ) {
+		    AddTestBroadphaseBox( broadphase, boxes, live, PlSetupCollisionAABB( PLVector3( i * 3.0f, 0.0f, 0.0f ), PLVector3( -0.5f, -0.5f, -0.5f ), PLVector3( 0.5f, 0.5f, 0.5f ) ) );
+	    }
+	    AddTestBroadphaseBox( broadphase, boxes, live, PlSetupCollisionAABB( PLVector3( 0.0f, 0.0f, 0.0f ), PLVector3( -1e30f, -1e30f, -1e30f ), PLVector3( 1e30f, 1e30f, 1e30f ) ) );
+	    PlUpdateBroadphase( broadphase );
+	    if ( !CheckBroadphase( broadphase, boxes, live ) ) {
+		    printf( "Broadphase %u is wrong with a huge box!\n", type );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    PlDestroyBroadphase( broadphase );
+    }
+FUNC_TEST_END()
+
+#define MESH_TEST_TRIANGLES 2000
+#define MESH_TEST_RAYS      1000
+
+static PLCollisionMeshHit CastTestRay( const PLVector3 *vertices, unsigned int numTriangles, const PLCollisionRay *ray, float maxDistance ) {
+	PLCollisionMeshHit best = { maxDistance, PL_COLLISION_MESH_NO_HIT, 0.0f, 0.0f };
+	for ( unsigned int i = 0; i < numTriangles; ++i ) {
+		float t, u, v;
+		if ( !PlIsRayIntersectingTriangle( ray, vertices[ i * 3 ], vertices[ i * 3 + 1 ], vertices[ i * 3 + 2 ], &t, &u, &v ) ) {
+			continue;
+		}
+		/* ties go to the lower triangle */
+		if ( t < best.distance || ( t == best.distance && best.triangle == PL_COLLISION_MESH_NO_HIT ) ) {
+			best = ( PLCollisionMeshHit ){ t, i, u, v };
+		}
+	}
+	return best;
+}
+
+/* a grid with shared edges and a soup of random triangles, against brute force at each SIMD level */
+FUNC_TEST( CollisionMesh )
+    PLCollisionRay ray = { PLVector3( 0.25f, 0.25f, -1.0f ), PLVector3( 0.0f, 0.0f, 2.0f ) };
+    float t, u, v;
+    if ( !PlIsRayIntersectingTriangle( &ray, PLVector3( 0.0f, 0.0f, 0.0f ), PLVector3( 1.0f, 0.0f, 0.0f ), PLVector3( 0.0f, 1.0f, 0.0f ), &t, &u, &v ) ||
+         t != 0.5f || u != 0.25f || v != 0.25f ) {
+	    printf( "Unexpected triangle hit!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    static PLVector3 vertices[ MESH_TEST_TRIANGLES * 3 ];
+    PLRandom rng;
+    PlSeedRandom( &rng, 0x3e54 );
+    unsigned int numTriangles = 0;
+    for ( unsigned int y = 0; y < 16; ++y ) {
+	    for ( unsigned int x = 0; x < 16; ++x, numTriangles += 2 ) {
+		    PLVector3 *q = &vertices[ numTriangles * 3 ];
+		    q[ 0 ] = q[ 3 ] = PLVector3( ( float ) x, ( float ) y, 0.0f );
+		    q[ 1 ] = PLVector3( x + 1.0f, ( float ) y, 0.0f );
+		    q[ 2 ] = q[ 4 ] = PLVector3( x + 1.0f, y + 1.0f, 0.0f );
+		    q[ 5 ] = PLVector3( ( float ) x, y + 1.0f, 0.0f );
+	    }
+    }
+    for ( ; numTriangles < MESH_TEST_TRIANGLES; ++numTriangles ) {
+	    PLVector3 centre = PLVector3( PlRandomFloatRange( &rng, -4.0f, 20.0f ), PlRandomFloatRange( &rng, -4.0f, 20.0f ), PlRandomFloatRange( &rng, 0.5f, 10.0f ) );
+	    for ( unsigned int i = 0; i < 3; ++i ) {
+		    vertices[ numTriangles * 3 + i ] = PlAddVector3( centre, PLVector3( PlRandomFloatRange( &rng, -1.0f, 1.0f ), PlRandomFloatRange( &rng, -1.0f, 1.0f ), PlRandomFloatRange( &rng, -1.0f, 1.0f ) ) );
+	    }
+    }
+
+    /* added in two lots, the second indexed, to check the numbering carries on */
+    unsigned int indices[ 300 ];
+    for ( unsigned int i = 0; i < 300; ++i ) {
+	    indices[ i ] = i;
+    }
+    PLCollisionMesh *mesh = PlCreateCollisionMesh();
+    PlAddCollisionMeshTriangles( mesh, vertices, 0, NULL, MESH_TEST_TRIANGLES - 100 );
+    PlAddCollisionMeshTriangles( mesh, &vertices[ ( MESH_TEST_TRIANGLES - 100 ) * 3 ], sizeof( PLVector3 ), indices, 100 );
+    PLCollisionMeshHit hit;
+    if ( PlRaycastCollisionMesh( mesh, &ray, 100.0f, &hit ) || PlGetFunctionResult() != PL_RESULT_INVALID_PARM1 ) {
+	    printf( "Unbuilt mesh should fail!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlBuildCollisionMesh( mesh );
+    if ( PlGetCollisionMeshNumTriangles( mesh ) != MESH_TEST_TRIANGLES ) {
+	    printf( "Unexpected number of triangles!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* half of them straight down onto grid corners and edges, the rest anywhere */
+    static PLCollisionRay rays[ MESH_TEST_RAYS ];
+    static PLCollisionMeshHit expected[ MESH_TEST_RAYS ], hits[ MESH_TEST_RAYS ];
+    for ( unsigned int i = 0; i < MESH_TEST_RAYS; ++i ) {
+	    if ( i < MESH_TEST_RAYS / 2 ) {
+		    rays[ i ].origin = PLVector3( PlRandomBoundedUInt32( &rng, 33 ) * 0.5f, PlRandomBoundedUInt32( &rng, 33 ) * 0.5f, 12.0f );
+		    rays[ i ].direction = PLVector3( 0.0f, 0.0f, -1.0f );
+	    } else {
+		    rays[ i ].origin = PLVector3( PlRandomFloatRange( &rng, -8.0f, 24.0f ), PlRandomFloatRange( &rng, -8.0f, 24.0f ), PlRandomFloatRange( &rng, -2.0f, 14.0f ) );
+		    rays[ i ].direction = PLVector3( PlRandomFloatRange( &rng, -1.0f, 1.0f ), PlRandomFloatRange( &rng, -1.0f, 1.0f ), PlRandomFloatRange( &rng, -1.0f, 1.0f ) );
+	    }
+	    float maxDistance = ( i % 3 == 0 ) ? 8.0f : 100.0f;
+	    expected[ i ] = CastTestRay( vertices, MESH_TEST_TRIANGLES, &rays[ i ], maxDistance );
+	    bool isHit = PlRaycastCollisionMesh( mesh, &rays[ i ], maxDistance, &hit );
+	    if ( isHit != ( expected[ i ].triangle != PL_COLLISION_MESH_NO_HIT ) || ( isHit && memcmp( &hit, &expected[ i ], sizeof( hit ) ) != 0 ) ) {
+		    printf( "Ray %u hit %u rather than %u!\n", i, hit.triangle, expected[ i ].triangle );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    if ( PlIsCollisionMeshBlockingRay( mesh, &rays[ i ], maxDistance ) != isHit ) {
+		    printf( "Ray %u blocking doesn't match!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+
+    for ( unsigned int level = PL_SIMD_LEVEL_NONE; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+	    PlSetSimdLevel( level );
+	    PlRaycastCollisionMeshRays( mesh, rays, MESH_TEST_RAYS - 3, 100.0f, hits );
+	    for ( unsigned int i = 0; i < MESH_TEST_RAYS - 3; ++i ) {
+		    PLCollisionMeshHit single;
+		    PlRaycastCollisionMesh( mesh, &rays[ i ], 100.0f, &single );
+		    if ( hits[ i ].triangle != single.triangle || ( single.triangle != PL_COLLISION_MESH_NO_HIT && memcmp( &hits[ i ], &single, sizeof( single ) ) != 0 ) ) {
+			    printf( "Ray %u differs in bulk (level %u)!\n", i, level );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+    }
+    PlSetSimdLevel( PL_SIMD_LEVEL_AVX2 );
+
+    PlDestroyCollisionMesh( mesh );
+FUNC_TEST_END()
+
+static PLCollisionShape GetTestCubeHull( PLCollisionAABB aabb, PLVector3 *vertices ) {
+	for ( unsigned int i = 0; i < 8; ++i ) {
+		vertices[ i ] = PLVector3( ( i & 1 ) ? aabb.maxs.x : aabb.mins.x, ( i & 2 ) ? aabb.maxs.y : aabb.mins.y, ( i & 4 ) ? aabb.maxs.z : aabb.mins.z );
+	}
+	PLCollisionShape shape = { .type = PL_COLLISION_SHAPE_HULL };
+	shape.hull.origin = aabb.origin;
+	shape.hull.vertices = vertices;
+	shape.hull.numVertices = 8;
+	return shape;
+}
+
+static bool IsTestContactNear( const PLContactManifold *manifold, PLVector3 normal, float penetration, float tolerance ) {
+	if ( manifold->numPoints == 0 || PlVector3Length( PlSubtractVector3( manifold->normal, normal ) ) > tolerance ) {
+		return false;
+	}
+	for ( unsigned int i = 0; i < manifold->numPoints; ++i ) {
+		if ( fabsf( manifold->points[ i ].penetration - penetration ) > tolerance ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* known answers for each kind of pair, then the general paths against the dedicated ones */
+FUNC_TEST( Narrowphase )
+    PLContactManifold manifold;
+    PLCollisionSphere sphere = PlSetupCollisionSphere( PLVector3( 1.5f, 0.0f, 0.0f ), 1.0f );
+    PLCollisionSphere unitSphere = PlSetupCollisionSphere( PLVector3( 0.0f, 0.0f, 0.0f ), 1.0f );
+    if ( !PlCollideSpheres( &unitSphere, &sphere, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 1.0f, 0.0f, 0.0f ), 0.5f, 1e-6f ) ||
+         manifold.numPoints != 1 || fabsf( manifold.points[ 0 ].position.x - 0.75f ) > 1e-6f ) {
+	    printf( "Unexpected sphere contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    sphere.origin.x = 2.5f;
+    if ( PlCollideSpheres( &unitSphere, &sphere, &manifold ) ) {
+	    printf( "Spheres shouldn't be touching!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    PLCollisionShape box = { .type = PL_COLLISION_SHAPE_AABB, .aabb = PlSetupCollisionAABB( PLVector3( 0.0f, 0.0f, 0.0f ), PLVector3( -1.0f, -1.0f, -1.0f ), PLVector3( 1.0f, 1.0f, 1.0f ) ) };
+    PLCollisionShape ball = { .type = PL_COLLISION_SHAPE_SPHERE, .sphere = PlSetupCollisionSphere( PLVector3( 0.0f, 1.5f, 0.0f ), 1.0f ) };
+    if ( !PlCollideShapes( &box, &ball, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 0.0f, 1.0f, 0.0f ), 0.5f, 1e-6f ) ) {
+	    printf( "Unexpected box and sphere contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* a box resting on another, then turned 45 degrees and resting on a floor */
+    PLCollisionShape other = { .type = PL_COLLISION_SHAPE_AABB, .aabb = PlSetupCollisionAABB( PLVector3( 0.5f, 1.9f, 0.0f ), PLVector3( -1.0f, -1.0f, -1.0f ), PLVector3( 1.0f, 1.0f, 1.0f ) ) };
+    if ( !PlCollideShapes( &box, &other, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 0.0f, 1.0f, 0.0f ), 0.1f, 1e-5f ) || manifold.numPoints != 4 ) {
+	    printf( "Unexpected stacked box contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PLCollisionShape floor = { .type = PL_COLLISION_SHAPE_AABB, .aabb = PlSetupCollisionAABB( PLVector3( 0.0f, 0.0f, 0.0f ), PLVector3( -5.0f, -1.0f, -5.0f ), PLVector3( 5.0f, 0.0f, 5.0f ) ) };
+    PLCollisionShape turned = { .type = PL_COLLISION_SHAPE_OBB };
+    turned.obb.origin = PLVector3( 0.0f, 0.9f, 0.0f );
+    turned.obb.axes[ 0 ] = PLVector3( sqrtf( 0.5f ), 0.0f, sqrtf( 0.5f ) );
+    turned.obb.axes[ 1 ] = PLVector3( 0.0f, 1.0f, 0.0f );
+    turned.obb.axes[ 2 ] = PLVector3( -sqrtf( 0.5f ), 0.0f, sqrtf( 0.5f ) );
+    turned.obb.extents = PLVector3( 1.0f, 1.0f, 1.0f );
+    if ( !PlCollideShapes( &turned, &floor, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 0.0f, -1.0f, 0.0f ), 0.1f, 1e-5f ) || manifold.numPoints != 4 ) {
+	    printf( "Unexpected turned box contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* capsules side by side get both ends, and one lying in the floor goes through GJK */
+    PLCollisionShape capsule = { .type = PL_COLLISION_SHAPE_CAPSULE, .capsule = { PLVector3( -1.0f, 0.4f, 0.0f ), PLVector3( 1.0f, 0.4f, 0.0f ), 0.5f } };
+    PLCollisionShape capsule2 = { .type = PL_COLLISION_SHAPE_CAPSULE, .capsule = { PLVector3( 0.0f, 1.2f, 0.0f ), PLVector3( 3.0f, 1.2f, 0.0f ), 0.5f } };
+    if ( !PlCollideShapes( &capsule, &capsule2, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 0.0f, 1.0f, 0.0f ), 0.2f, 1e-5f ) || manifold.numPoints != 2 ) {
+	    printf( "Unexpected capsule contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    if ( !PlCollideShapes( &capsule, &floor, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 0.0f, -1.0f, 0.0f ), 0.1f, 1e-4f ) ) {
+	    printf( "Unexpected capsule and floor contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    capsule.capsule.start.y = capsule.capsule.end.y = -0.2f;
+    if ( !PlCollideShapes( &capsule, &floor, &manifold ) || !IsTestContactNear( &manifold, PLVector3( 0.0f, -1.0f, 0.0f ), 0.7f, 1e-4f ) ) {
+	    printf( "Unexpected sunken capsule contact!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* hulls and oriented boxes should agree with the axis aligned tests */
+    PLRandom rng;
+    PlSeedRandom( &rng, 0x7a9e );
+    PLVector3 verticesA[ 8 ], verticesB[ 8 ];
+    unsigned int numChecked = 0;
+    for ( unsigned int i = 0; i < 2000; ++i ) {
+	    PLCollisionShape a = { .type = PL_COLLISION_SHAPE_AABB, .aabb = RandomTestAabb( &rng, 1.0f, 1.5f ) };
+	    PLCollisionShape b = { .type = PL_COLLISION_SHAPE_AABB, .aabb = RandomTestAabb( &rng, 1.0f, 1.5f ) };
+	    PLCollisionShape s = { .type = PL_COLLISION_SHAPE_SPHERE, .sphere = PlSetupCollisionSphere( b.aabb.origin, b.aabb.maxs.x ) };
+
+	    /* skip anything too close to call */
+	    PLVector3 aMins = PlAddVector3( a.aabb.origin, a.aabb.mins ), aMaxs = PlAddVector3( a.aabb.origin, a.aabb.maxs );
+	    PLVector3 bMins = PlAddVector3( b.aabb.origin, b.aabb.mins ), bMaxs = PlAddVector3( b.aabb.origin, b.aabb.maxs );
+	    float depths[ 6 ];
+	    for ( unsigned int j = 0; j < 3; ++j ) {
+		    depths[ j * 2 ] = PlVector3Index( aMaxs, j ) - PlVector3Index( bMins, j );
+		    depths[ j * 2 + 1 ] = PlVector3Index( bMaxs, j ) - PlVector3Index( aMins, j );
+	    }
+	    bool isClose = false;
+	    for ( unsigned int j = 0; j < 6; ++j ) {
+		    isClose |= fabsf( depths[ j ] ) < 1e-2f;
+		    for ( unsigned int k = j + 1; k < 6; ++k ) {
+			    isClose |= fabsf( depths[ j ] - depths[ k ] ) < 1e-2f;
+		    }
+	    }
+	    if ( isClose ) {
+		    continue;
+	    }
+
+	    PLContactManifold expected, obbManifold, hullManifold;
+	    bool isTouching = PlCollideShapes( &a, &b, &expected );
+	    PLCollisionShape obb = { .type = PL_COLLISION_SHAPE_OBB };
+	    obb.obb.origin = PlAddVector3( b.aabb.origin, PlScaleVector3F( PlAddVector3( b.aabb.mins, b.aabb.maxs ), 0.5f ) );
+	    obb.obb.axes[ 0 ] = PLVector3( 1.0f, 0.0f, 0.0f );
+	    obb.obb.axes[ 1 ] = PLVector3( 0.0f, 1.0f, 0.0f );
+	    obb.obb.axes[ 2 ] = PLVector3( 0.0f, 0.0f, 1.0f );
+	    obb.obb.extents = PlScaleVector3F( PlSubtractVector3( b.aabb.maxs, b.aabb.mins ), 0.5f );
+	    PLCollisionShape hullA = GetTestCubeHull( a.aabb, verticesA ), hullB = GetTestCubeHull( b.aabb, verticesB );
+	    if ( PlCollideShapes( &a, &obb, &obbManifold ) != isTouching || PlCollideShapes( &hullA, &hullB, &hullManifold ) != isTouching ) {
+		    printf( "Boxes %u disagree on touching!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    if ( isTouching ) {
+		    numChecked++;
+		    if ( !IsTestContactNear( &obbManifold, expected.normal, expected.points[ 0 ].penetration, 1e-4f ) || obbManifold.numPoints != expected.numPoints ) {
+			    printf( "Oriented boxes %u disagree!\n", i );
+			    return TEST_RETURN_FAILURE;
+		    }
+		    for ( unsigned int j = 0; j < expected.numPoints; ++j ) {
+			    bool isFound = false;
+			    for ( unsigned int k = 0; k < obbManifold.numPoints; ++k ) {
+				    isFound |= PlVector3Length( PlSubtractVector3( expected.points[ j ].position, obbManifold.points[ k ].position ) ) < 1e-4f;
+			    }
+			    if ( !isFound ) {
+				    printf( "Oriented boxes %u have different points!\n", i );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+		    if ( !IsTestContactNear( &hullManifold, expected.normal, expected.points[ 0 ].penetration, 1e-3f ) ) {
+			    printf( "Hulls %u disagree!\n", i );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+
+	    /* and a sphere, which lands inside the box some of the time */
+	    if ( PlCollideShapes( &s, &a, &expected ) != PlCollideShapes( &s, &hullA, &hullManifold ) ) {
+		    printf( "Sphere %u disagrees on touching!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    if ( expected.numPoints > 0 && !IsTestContactNear( &hullManifold, expected.normal, expected.points[ 0 ].penetration, 1e-3f ) ) {
+		    printf( "Sphere %u disagrees!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    expected.numPoints = 0;
+    }
+    if ( numChecked < 200 ) {
+	    printf( "Only %u boxes were touching!\n", numChecked );
+	    return TEST_RETURN_FAILURE;
+    }
+
+    /* pairs straight from a broadphase */
+    PLCollisionShape shapes[ 4 ] = { box, ball, other, floor };
+    shapes[ 3 ].aabb.origin.y = -10.0f;
+    PLBroadphase *broadphase = PlCreateSweepAndPruneBroadphase();
+    for ( unsigned int i = 0; i < 4; ++i ) {
+	    PLCollisionAABB bounds = PlGetCollisionShapeBounds( &shapes[ i ] );
+	    PlAddBroadphaseProxy( broadphase, &bounds, NULL );
+    }
+    PlUpdateBroadphase( broadphase );
+    unsigned int numPairs;
+    const PLBroadphasePair *pairs = PlGetBroadphasePairs( broadphase, &numPairs );
+    PLContactManifold manifolds[ 6 ];
+    unsigned int numManifolds = PlCollideShapePairs( shapes, pairs, numPairs, manifolds );
+    if ( numManifolds != 3 ) {
+	    printf( "Unexpected contacts from the broadphase (%u)!\n", numManifolds );
+	    return TEST_RETURN_FAILURE;
+    }
+    for ( unsigned int i = 0; i < numManifolds; ++i ) {
+	    if ( manifolds[ i ].pair.proxyB == 3 || !PlCollideShapes( &shapes[ manifolds[ i ].pair.proxyA ], &shapes[ manifolds[ i ].pair.proxyB ], &manifold ) ||
+	         memcmp( &manifold.normal, &manifolds[ i ].normal, sizeof( PLVector3 ) ) != 0 ) {
+		    printf( "Unexpected contact from the broadphase (%u %u)!\n", manifolds[ i ].pair.proxyA, manifolds[ i ].pair.proxyB );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    PlDestroyBroadphase( broadphase );
+FUNC_TEST_END()
+
+/* the same planes a PLGCamera would have, looking down z from the origin */
+static void GetTestFrustumPlanes( PLVector4 *planes ) {
+	PLMatrix4 mvp = PlMultiplyMatrix4( PlPerspective( 75.0f, 4.0f / 3.0f, 0.1f, 100.0f ), PlLookAt( pl_vecOrigin3, PLVector3( 0, 0, 1 ), PLVector3( 0, 1, 0 ) ) );
+	for ( unsigned int i = 0; i < 3; ++i ) {
+		PLVector4 row = PLVector4( mvp.m[ i ], mvp.m[ 4 + i ], mvp.m[ 8 + i ], mvp.m[ 12 + i ] );
+		PLVector4 w = PLVector4( mvp.m[ 3 ], mvp.m[ 7 ], mvp.m[ 11 ], mvp.m[ 15 ] );
+		planes[ i * 2 ] = PlNormalizePlane( PLVector4( w.x - row.x, w.y - row.y, w.z - row.z, w.w - row.w ) );
+		planes[ i * 2 + 1 ] = PlNormalizePlane( PlAddVector4( w, row ) );
+	}
+}
+
+#define CULL_TEST_OBJECTS 1001
+
+FUNC_TEST( FrustumCull )
+    static float c[ 3 ][ CULL_TEST_OBJECTS ], e[ 3 ][ CULL_TEST_OBJECTS ], radii[ CULL_TEST_OBJECTS ];
+    static unsigned int indices[ CULL_TEST_OBJECTS ], scalarIndices[ CULL_TEST_OBJECTS ];
+    static uint8_t cache[ CULL_TEST_OBJECTS ];
+    uint32_t bits[ PL_CULL_BITSET_WORDS( CULL_TEST_OBJECTS ) ], scalarBits[ PL_CULL_BITSET_WORDS( CULL_TEST_OBJECTS ) ];
+    PLVector4 planes[ 6 ];
+    GetTestFrustumPlanes( planes );
+    PLRandom rng;
+    PlSeedRandom( &rng, 49 );
+    for ( unsigned int j = 0; j < 3; ++j ) {
+	    PlFillRandomFloats( &rng, c[ j ], CULL_TEST_OBJECTS, -60.0f, 60.0f );
+	    PlFillRandomFloats( &rng, e[ j ], CULL_TEST_OBJECTS, 0.0f, 4.0f );
+    }
+    PlFillRandomFloats( &rng, radii, CULL_TEST_OBJECTS, 0.0f, 4.0f );
+    PLVector3SoA centres = { c[ 0 ], c[ 1 ], c[ 2 ] }, extents = { e[ 0 ], e[ 1 ], e[ 2 ] };
+    /* check boxes against their corners, other than those too close to call */
+    unsigned int numVisible = 0;
+    PlSetSimdLevel( PL_SIMD_LEVEL_NONE );
+    unsigned int scalarNum = PlCullBoxes( planes, 6, &centres, &extents, CULL_TEST_OBJECTS, NULL, scalarBits, scalarIndices );
+    for ( unsigned int i = 0; i < CULL_TEST_OBJECTS; ++i ) {
+	    bool visible = true, close = false;
+	    for ( unsigned int j = 0; j < 6; ++j ) {
+		    float furthest = -FLT_MAX;
+		    for ( unsigned int k = 0; k < 8; ++k ) {
+			    PLVector3 corner = PLVector3( c[ 0 ][ i ] + ( ( k & 1 ) ? e[ 0 ][ i ] : -e[ 0 ][ i ] ),
+			                                  c[ 1 ][ i ] + ( ( k & 2 ) ? e[ 1 ][ i ] : -e[ 1 ][ i ] ),
+			                                  c[ 2 ][ i ] + ( ( k & 4 ) ? e[ 2 ][ i ] : -e[ 2 ][ i ] ) );
+			    furthest = fmaxf( furthest, PlGetPlaneDotProduct( &planes[ j ], &corner ) );
+		    }
+		    visible = visible && furthest >= 0.0f;
+		    close = close || fabsf( furthest ) < 1e-3f;
+	    }
+	    bool culled = !( scalarBits[ i / 32 ] & ( 1U << ( i % 32 ) ) );
+	    if ( !close && visible == culled ) {
+		    printf( "Box %u was %s!\n", i, culled ? "culled" : "kept" );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    if ( !culled ) {
+		    if ( scalarIndices[ numVisible ] != i ) {
+			    printf( "Visible box %u missing from the list!\n", i );
+			    return TEST_RETURN_FAILURE;
+		    }
+		    numVisible++;
+	    }
+    }
+    if ( numVisible != scalarNum || numVisible == 0 || numVisible == CULL_TEST_OBJECTS ) {
+	    printf( "Unexpected number of visible boxes (%u, %u)!\n", scalarNum, numVisible );
+	    return TEST_RETURN_FAILURE;
+    }
+    /* every level, with and without the cache, must agree with the scalar path */
+    for ( unsigned int k = 0; k < 2; ++k ) {
+	    if ( k == 1 ) {
+		    PlSetSimdLevel( PL_SIMD_LEVEL_NONE );
+		    scalarNum = PlCullSpheres( planes, 6, &centres, radii, CULL_TEST_OBJECTS, NULL, scalarBits, scalarIndices );
+	    }
+	    for ( PLSimdLevel level = PL_SIMD_LEVEL_NONE; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+		    PlSetSimdLevel( level );
+		    memset( cache, 0, sizeof( cache ) );
+		    for ( unsigned int pass = 0; pass < 3; ++pass ) {
+			    memset( indices, 0xFF, sizeof( indices ) );
+			    unsigned int num = ( k == 0 ) ? PlCullBoxes( planes, 6, &centres, &extents, CULL_TEST_OBJECTS, ( pass > 0 ) ? cache : NULL, bits, indices )
+			                                  : PlCullSpheres( planes, 6, &centres, radii, CULL_TEST_OBJECTS, ( pass > 0 ) ? cache : NULL, bits, indices );
+			    if ( num != scalarNum || memcmp( bits, scalarBits, sizeof( bits ) ) != 0 || memcmp( indices, scalarIndices, num * sizeof( unsigned int ) ) != 0 ) {
+				    printf( "Mismatch culling %s at SIMD level %d, pass %u!\n", ( k == 0 ) ? "boxes" : "spheres", level, pass );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+		    /* the cache should name a plane that really does cull each culled object */
+		    for ( unsigned int i = 0; i < CULL_TEST_OBJECTS; ++i ) {
+			    if ( bits[ i / 32 ] & ( 1U << ( i % 32 ) ) ) {
+				    continue;
+			    }
+			    const PLVector4 *p = &planes[ cache[ i ] ];
+			    PLVector3 centre = PLVector3( c[ 0 ][ i ], c[ 1 ][ i ], c[ 2 ][ i ] );
+			    float r = ( k == 0 ) ? fabsf( p->x ) * e[ 0 ][ i ] + fabsf( p->y ) * e[ 1 ][ i ] + fabsf( p->z ) * e[ 2 ][ i ] : radii[ i ];
+			    if ( cache[ i ] >= 6 || PlGetPlaneDotProduct( p, &centre ) + r >= 0.0f ) {
+				    printf( "Object %u cached plane %u, which doesn't cull it!\n", i, cache[ i ] );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+    }
+    /* a camera's single object checks should agree with its batches, neither culling by the near plane */
+    c[ 0 ][ 0 ] = c[ 1 ][ 0 ] = 0.0f;
+    c[ 2 ][ 0 ] = -0.75f;
+    e[ 0 ][ 0 ] = e[ 1 ][ 0 ] = e[ 2 ][ 0 ] = radii[ 0 ] = 0.01f;
+    PLGCamera camera;
+    memset( &camera, 0, sizeof( camera ) );
+    memcpy( camera.frustum, planes, sizeof( camera.frustum ) );
+    PlgCullBoxes( &camera, &centres, &extents, CULL_TEST_OBJECTS, NULL, bits, NULL );
+    PlgCullSpheres( &camera, &centres, radii, CULL_TEST_OBJECTS, NULL, scalarBits, NULL );
+    for ( unsigned int i = 0; i < CULL_TEST_OBJECTS; ++i ) {
+	    PLVector3 centre = PLVector3( c[ 0 ][ i ], c[ 1 ][ i ], c[ 2 ][ i ] );
+	    PLVector3 extent = PLVector3( e[ 0 ][ i ], e[ 1 ][ i ], e[ 2 ][ i ] );
+	    PLCollisionAABB bounds = PlSetupCollisionAABB( centre, PlScaleVector3F( extent, -1.0f ), extent );
+	    PLCollisionSphere sphere = { centre, radii[ i ] };
+	    if ( PlgIsBoxInsideView( &camera, &bounds ) != ( ( bits[ i / 32 ] & ( 1U << ( i % 32 ) ) ) != 0 ) ||
+	         PlgIsSphereInsideView( &camera, &sphere ) != ( ( scalarBits[ i / 32 ] & ( 1U << ( i % 32 ) ) ) != 0 ) ) {
+		    printf( "Camera disagrees with its batch culling over object %u!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    if ( !( bits[ 0 ] & 1U ) || !( scalarBits[ 0 ] & 1U ) ) {
+	    printf( "Camera culled an object only outside the near plane!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    /* without any planes, everything's visible */
+    if ( PlCullSpheres( planes, 0, &centres, radii, CULL_TEST_OBJECTS, NULL, bits, NULL ) != CULL_TEST_OBJECTS || bits[ 0 ] != ~0U ||
+         bits[ PL_CULL_BITSET_WORDS( CULL_TEST_OBJECTS ) - 1 ] != ( 1U << ( CULL_TEST_OBJECTS % 32 ) ) - 1 ) {
+	    printf( "Objects culled without any planes!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlSetSimdLevel( PL_SIMD_LEVEL_AVX2 );
+FUNC_TEST_END()
+
+#define OCCLUSION_TEST_WIDTH   67
+#define OCCLUSION_TEST_HEIGHT  41
+#define OCCLUSION_TEST_OBJECTS 1001
+
+static PLVector3 ProjectOcclusionTestPoint( const PLMatrix4 *m, PLVector3 p ) {
+	float x = m->m[ 0 ] * p.x + m->m[ 4 ] * p.y + m->m[ 8 ] * p.z + m->m[ 12 ];
+	float y = m->m[ 1 ] * p.x + m->m[ 5 ] * p.y + m->m[ 9 ] * p.z + m->m[ 13 ];
+	float z = m->m[ 2 ] * p.x + m->m[ 6 ] * p.y + m->m[ 10 ] * p.z + m->m[ 14 ];
+	float w = m->m[ 3 ] * p.x + m->m[ 7 ] * p.y + m->m[ 11 ] * p.z + m->m[ 15 ];
+	return PLVector3( ( x / w + 1.0f ) * OCCLUSION_TEST_WIDTH * 0.5f, ( 1.0f - y / w ) * OCCLUSION_TEST_HEIGHT * 0.5f, z / w );
+}
+
+FUNC_TEST( OcclusionCull )
+    static float c[ 3 ][ OCCLUSION_TEST_OBJECTS ], e[ 3 ][ OCCLUSION_TEST_OBJECTS ];
+    static unsigned int indices[ OCCLUSION_TEST_OBJECTS ], scalarIndices[ OCCLUSION_TEST_OBJECTS ];
+    static float depths[ OCCLUSION_TEST_WIDTH * OCCLUSION_TEST_HEIGHT ];
+    uint32_t bits[ PL_CULL_BITSET_WORDS( OCCLUSION_TEST_OBJECTS ) ], scalarBits[ PL_CULL_BITSET_WORDS( OCCLUSION_TEST_OBJECTS ) ];
+    PLMatrix4 mvp = PlMultiplyMatrix4( PlPerspective( 75.0f, 4.0f / 3.0f, 0.1f, 100.0f ), PlLookAt( pl_vecOrigin3, PLVector3( 0, 0, 1 ), PLVector3( 0, 1, 0 ) ) );
+    /* a wall about ten units ahead, leaning away and split into two
+     * triangles, and a scattering of random ones, some of which cross the
+     * near plane */
+    PLVector3 wall[ 4 ] = { PLVector3( -5, -5, 9 ), PLVector3( 5, -5, 9 ), PLVector3( 5, 5, 11 ), PLVector3( -5, 5, 11 ) };
+    unsigned int wallIndices[ 6 ] = { 0, 1, 2, 0, 2, 3 };
+    PLVector3 triangles[ 60 ];
+    PLRandom rng;
+    PlSeedRandom( &rng, 50 );
+    for ( unsigned int i = 0; i < 60; ++i ) {
+	    triangles[ i ] = PLVector3( PlRandomFloatRange( &rng, -30.0f, 30.0f ), PlRandomFloatRange( &rng, -20.0f, 20.0f ), PlRandomFloatRange( &rng, -5.0f, 60.0f ) );
+    }
+    PLMatrix4 offset = PlTranslateMatrix4( PLVector3( 0, 0, 20 ) );
+    PLGOcclusionBuffer *buffer = PlgCreateOcclusionBuffer( OCCLUSION_TEST_WIDTH, OCCLUSION_TEST_HEIGHT );
+    /* every level must draw exactly the same depths */
+    for ( PLSimdLevel level = PL_SIMD_LEVEL_NONE; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+	    PlSetSimdLevel( level );
+	    PlgClearOcclusionBuffer( buffer, &mvp );
+	    PlgAddOccluderTriangles( buffer, NULL, triangles, 0, NULL, 20 );
+	    PlgAddOccluderTriangles( buffer, &offset, wall, 0, wallIndices, 2 );
+	    for ( unsigned int y = 0; y < OCCLUSION_TEST_HEIGHT; ++y ) {
+		    for ( unsigned int x = 0; x < OCCLUSION_TEST_WIDTH; ++x ) {
+			    float depth = PlgGetOcclusionBufferDepth( buffer, 0, x, y );
+			    if ( level == PL_SIMD_LEVEL_NONE ) {
+				    depths[ y * OCCLUSION_TEST_WIDTH + x ] = depth;
+			    } else if ( memcmp( &depth, &depths[ y * OCCLUSION_TEST_WIDTH + x ], sizeof( float ) ) != 0 ) {
+				    printf( "Depth mismatch at %u %u at SIMD level %d!\n", x, y, level );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+    }
+    /* then just the wall, which should be solid without any gaps along its
+     * diagonal, and never nearer than it really is anywhere in a pixel */
+    PlgClearOcclusionBuffer( buffer, &mvp );
+    PlgAddOccluderTriangles( buffer, NULL, wall, 0, wallIndices, 2 );
+    PLVector3 screen[ 4 ];
+    for ( unsigned int i = 0; i < 4; ++i ) {
+	    screen[ i ] = ProjectOcclusionTestPoint( &mvp, wall[ i ] );
+    }
+    PLVector3 d1 = PlSubtractVector3( screen[ 1 ], screen[ 0 ] ), d2 = PlSubtractVector3( screen[ 2 ], screen[ 0 ] );
+    float area = d1.x * d2.y - d2.x * d1.y;
+    float dzdx = ( d1.z * d2.y - d2.z * d1.y ) / area, dzdy = ( d1.x * d2.z - d2.x * d1.z ) / area;
+    float zc = screen[ 0 ].z - dzdx * screen[ 0 ].x - dzdy * screen[ 0 ].y;
+    unsigned int numWallPixels = 0;
+    for ( unsigned int y = 0; y < OCCLUSION_TEST_HEIGHT; ++y ) {
+	    for ( unsigned int x = 0; x < OCCLUSION_TEST_WIDTH; ++x ) {
+		    float px = ( float ) x + 0.5f, py = ( float ) y + 0.5f;
+		    float inside = FLT_MAX;
+		    for ( unsigned int k = 0; k < 4; ++k ) {
+			    PLVector3 e = PlSubtractVector3( screen[ ( k + 1 ) % 4 ], screen[ k ] );
+			    float distance = ( e.x * ( py - screen[ k ].y ) - e.y * ( px - screen[ k ].x ) ) / sqrtf( e.x * e.x + e.y * e.y );
+			    inside = fminf( inside, ( area > 0.0f ) ? distance : -distance );
+		    }
+		    float depth = PlgGetOcclusionBufferDepth( buffer, 0, x, y );
+		    if ( inside > 1.0f ) {
+			    float furthest = -FLT_MAX;
+			    for ( unsigned int k = 0; k < 4; ++k ) {
+				    furthest = fmaxf( furthest, dzdx * ( float ) ( x + ( k & 1 ) ) + dzdy * ( float ) ( y + ( k >> 1 ) ) + zc );
+			    }
+			    if ( depth < furthest - 1e-6f || depth > furthest + 1e-4f ) {
+				    printf( "Bad wall depth at %u %u (%f, expected %f)!\n", x, y, depth, furthest );
+				    return TEST_RETURN_FAILURE;
+			    }
+			    numWallPixels++;
+		    } else if ( inside < -1.0f && depth != FLT_MAX ) {
+			    printf( "Wall drawn outside itself at %u %u!\n", x, y );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+    }
+    if ( numWallPixels == 0 ) {
+	    printf( "Wall wasn't drawn!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlgBuildOcclusionPyramid( buffer );
+    /* each texel holds the furthest of the ones below it */
+    unsigned int w = OCCLUSION_TEST_WIDTH, h = OCCLUSION_TEST_HEIGHT;
+    for ( unsigned int l = 1; l < PlgGetOcclusionBufferLevels( buffer ); ++l ) {
+	    unsigned int below = w, belowH = h;
+	    w = ( w + 1 ) / 2;
+	    h = ( h + 1 ) / 2;
+	    for ( unsigned int y = 0; y < h; ++y ) {
+		    for ( unsigned int x = 0; x < w; ++x ) {
+			    float furthest = -FLT_MAX;
+			    for ( unsigned int k = 0; k < 4; ++k ) {
+				    unsigned int bx = x * 2 + ( k & 1 ), by = y * 2 + ( k >> 1 );
+				    if ( bx < below && by < belowH ) {
+					    furthest = fmaxf( furthest, PlgGetOcclusionBufferDepth( buffer, l - 1, bx, by ) );
+				    }
+			    }
+			    if ( PlgGetOcclusionBufferDepth( buffer, l, x, y ) != furthest ) {
+				    printf( "Level %u texel %u %u isn't the furthest below it!\n", l, x, y );
+				    return TEST_RETURN_FAILURE;
+			    }
+		    }
+	    }
+    }
+    /* behind the wall, poking out from behind it, in front, off to the side,
+     * through the near plane and through the wall itself */
+    static const struct {
+	    PLVector3 origin, extents;
+	    bool occluded;
+    } boxes[] = {
+            { { 0, 0, 20 }, { 1, 1, 1 }, true },
+            { { 0, 0, 20 }, { 15, 1, 1 }, false },
+            { { 0, 0, 5 }, { 1, 1, 1 }, false },
+            { { 20, 0, 20 }, { 1, 1, 1 }, false },
+            { { 0, 0, 0 }, { 1, 1, 1 }, false },
+            { { 0, 0, 10 }, { 1, 1, 1 }, false },
+    };
+    for ( unsigned int i = 0; i < plArrayElements( boxes ); ++i ) {
+	    PLCollisionAABB bounds = { .origin = boxes[ i ].origin, .mins = PlScaleVector3F( boxes[ i ].extents, -1.0f ), .maxs = boxes[ i ].extents };
+	    if ( PlgIsBoxOccluded( buffer, &bounds ) != boxes[ i ].occluded ) {
+		    printf( "Box %u should%s be occluded!\n", i, boxes[ i ].occluded ? "" : "n't" );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    /* anything reported as occluded must be entirely behind the wall; most
+     * of these are close to it, to catch any of the kernels being out */
+    for ( unsigned int j = 0; j < 3; ++j ) {
+	    PlFillRandomFloats( &rng, c[ j ], OCCLUSION_TEST_OBJECTS, ( j == 2 ) ? 4.0f : -8.0f, ( j == 2 ) ? 24.0f : 8.0f );
+	    PlFillRandomFloats( &rng, e[ j ], OCCLUSION_TEST_OBJECTS, 0.0f, 1.5f );
+    }
+    PLVector3SoA centres = { c[ 0 ], c[ 1 ], c[ 2 ] }, extents = { e[ 0 ], e[ 1 ], e[ 2 ] };
+    PlSetSimdLevel( PL_SIMD_LEVEL_NONE );
+    unsigned int scalarNum = PlgTestOcclusionBoxes( buffer, &centres, &extents, OCCLUSION_TEST_OBJECTS, scalarBits, scalarIndices );
+    unsigned int numVisible = 0;
+    for ( unsigned int i = 0; i < OCCLUSION_TEST_OBJECTS; ++i ) {
+	    bool occluded = !( scalarBits[ i / 32 ] & ( 1U << ( i % 32 ) ) );
+	    PLCollisionAABB bounds = { .origin = PLVector3( c[ 0 ][ i ], c[ 1 ][ i ], c[ 2 ][ i ] ), .mins = PLVector3( -e[ 0 ][ i ], -e[ 1 ][ i ], -e[ 2 ][ i ] ), .maxs = PLVector3( e[ 0 ][ i ], e[ 1 ][ i ], e[ 2 ][ i ] ) };
+	    if ( occluded != PlgIsBoxOccluded( buffer, &bounds ) ) {
+		    printf( "Box %u isn't the same tested on its own!\n", i );
+		    return TEST_RETURN_FAILURE;
+	    }
+	    if ( !occluded ) {
+		    if ( scalarIndices[ numVisible++ ] != i ) {
+			    printf( "Visible box %u missing from the list!\n", i );
+			    return TEST_RETURN_FAILURE;
+		    }
+		    continue;
+	    }
+	    for ( unsigned int k = 0; k < 8; ++k ) {
+		    float x = c[ 0 ][ i ] + ( ( k & 1 ) ? e[ 0 ][ i ] : -e[ 0 ][ i ] );
+		    float y = c[ 1 ][ i ] + ( ( k & 2 ) ? e[ 1 ][ i ] : -e[ 1 ][ i ] );
+		    float z = c[ 2 ][ i ] + ( ( k & 4 ) ? e[ 2 ][ i ] : -e[ 2 ][ i ] );
+		    /* where the line of sight to the corner meets the wall, which is
+		     * z = 10 + y / 5, allowing for half a pixel around its edges */
+		    float t = 10.0f / ( z - y * 0.2f );
+		    if ( !( t > 0.0f && t < 1.0f ) || fabsf( x * t ) > 5.2f || fabsf( y * t ) > 5.2f ) {
+			    printf( "Box %u was occluded, but isn't behind the wall!\n", i );
+			    return TEST_RETURN_FAILURE;
+		    }
+	    }
+    }
+    if ( numVisible != scalarNum || numVisible == OCCLUSION_TEST_OBJECTS ) {
+	    printf( "Unexpected number of visible boxes (%u, %u)!\n", scalarNum, numVisible );
+	    return TEST_RETURN_FAILURE;
+    }
+    for ( PLSimdLevel level = PL_SIMD_LEVEL_SSE2; level <= PL_SIMD_LEVEL_AVX2; ++level ) {
+	    PlSetSimdLevel( level );
+	    memset( indices, 0xFF, sizeof( indices ) );
+	    unsigned int num = PlgTestOcclusionBoxes( buffer, &centres, &extents, OCCLUSION_TEST_OBJECTS, bits, indices );
+	    if ( num != scalarNum || memcmp( bits, scalarBits, sizeof( bits ) ) != 0 || memcmp( indices, scalarIndices, num * sizeof( unsigned int ) ) != 0 ) {
+		    printf( "Mismatch testing boxes at SIMD level %d!\n", level );
+		    return TEST_RETURN_FAILURE;
+	    }
+    }
+    PlSetSimdLevel( PL_SIMD_LEVEL_AVX2 );
+    /* the debug image shows the wall, and nothing else */
+    PLImage *image = PlgGetOcclusionBufferImage( buffer, 0 );
+    if ( image == NULL || image->width != OCCLUSION_TEST_WIDTH || image->height != OCCLUSION_TEST_HEIGHT ||
+         image->data[ 0 ][ ( ( OCCLUSION_TEST_HEIGHT / 2 ) * OCCLUSION_TEST_WIDTH + OCCLUSION_TEST_WIDTH / 2 ) * 4 ] == 0 || image->data[ 0 ][ 0 ] != 0 ) {
+	    printf( "Bad debug image!\n" );
+	    return TEST_RETURN_FAILURE;
+    }
+    PlDestroyImage( image );
+    PlgDestroyOcclusionBuffer( buffer );
 FUNC_TEST_END()
 
 int main( int argc, char **argv ) {
 	printf( "Starting tests...\n" );
 
+	if ( PlInitialize( argc, argv ) != PL_RESULT_SUCCESS ) {
+		printf( "Failed to initialize Hei: %s\n", PlGetError() );
+		return EXIT_FAILURE;
+	}
+
 #define CALL_FUNC_TEST( NAME ) \
     { int ret = test_##NAME(); \
 		if ( ret != TEST_RETURN_SUCCESS ) { printf( "Failed on " #NAME "!\n"); \
@@ -106,6 +2410,30 @@ int main( int argc, char **argv ) {
 	CALL_FUNC_TEST( RegisterConsoleCommand )
 	CALL_FUNC_TEST( GetConsoleCommands )
 	CALL_FUNC_TEST( GetConsoleCommand )
+	CALL_FUNC_TEST( AutocompleteConsoleString )
+	CALL_FUNC_TEST( AsyncLogOutput )
+	CALL_FUNC_TEST( BinaryLogOutput )
+	CALL_FUNC_TEST( ProfilerTrace )
+	CALL_FUNC_TEST( ConvertPixels )
+	CALL_FUNC_TEST( DecodeBlockCompressed )
+	CALL_FUNC_TEST( CompressBlockCompressed )
+	CALL_FUNC_TEST( GenerateImageMipmaps )
+	CALL_FUNC_TEST( ResizeImage )
+	CALL_FUNC_TEST( LoadImageFromMemory )
+	CALL_FUNC_TEST( LoadTimImage )
+	CALL_FUNC_TEST( CreateImageAtlas )
+	CALL_FUNC_TEST( TransformImage )
+	CALL_FUNC_TEST( TransformImageColour )
+	CALL_FUNC_TEST( SimdMathMatchesScalar )
+	CALL_FUNC_TEST( BatchMath )
+	CALL_FUNC_TEST( MatrixStack )
+	CALL_FUNC_TEST( Random )
+	CALL_FUNC_TEST( AabbTree )
+	CALL_FUNC_TEST( Broadphase )
+	CALL_FUNC_TEST( CollisionMesh )
+	CALL_FUNC_TEST( Narrowphase )
+	CALL_FUNC_TEST( FrustumCull )
+	CALL_FUNC_TEST( OcclusionCull )
 
     return EXIT_SUCCESS;
 }